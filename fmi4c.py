@@ -1,4 +1,9 @@
 import ctypes as ct
+import weakref
+try:
+    import numpy as np
+except ImportError:
+    np = None
 
 class fmi4c:
 
@@ -356,6 +361,8 @@ class fmi4c:
         self.hdll.fmi2_getModelStructureIndex.argtypes = ct.c_void_p,
         self.hdll.fmi2_getModelStructureNumberOfDependencies.restype = ct.c_int
         self.hdll.fmi2_getModelStructureNumberOfDependencies.argtypes = ct.c_void_p,
+        self.hdll.fmi2_getModelStructureDependenciesDefined.restype = ct.c_bool
+        self.hdll.fmi2_getModelStructureDependenciesDefined.argtypes = ct.c_void_p,
         self.hdll.fmi2_getModelStructureDependencyKindsDefined.restype = ct.c_bool
         self.hdll.fmi2_getModelStructureDependencyKindsDefined.argtypes = ct.c_void_p,
         self.hdll.fmi2_getModelStructureDependencies.restype = None
@@ -651,6 +658,8 @@ class fmi4c:
         self.hdll.fmi3_getModelStructureValueReference.argtypes = ct.c_void_p,
         self.hdll.fmi3_getModelStructureNumberOfDependencies.restype = ct.c_int
         self.hdll.fmi3_getModelStructureNumberOfDependencies.argtypes = ct.c_void_p,
+        self.hdll.fmi3_getModelStructureDependenciesDefined.restype = ct.c_bool
+        self.hdll.fmi3_getModelStructureDependenciesDefined.argtypes = ct.c_void_p,
         self.hdll.fmi3_getModelStructureDependencyKindsDefined.restype = ct.c_bool
         self.hdll.fmi3_getModelStructureDependencyKindsDefined.argtypes = ct.c_void_p,
         self.hdll.fmi3_getModelStructureDependencies.restype = None
@@ -876,6 +885,106 @@ class fmi4c:
         self.hdll.fmi3_activateModelPartition.restype = ct.c_int 
         self.hdll.fmi3_activateModelPartition.argtypes = ct.c_void_p,ct.c_uint,ct.c_double,
 
+        #Array functions for NumPy arrays, with separate function objects that take the array data pointers
+        self.uint32Type = np.dtype(np.uint32) if np is not None else None
+        self.float64Type = np.dtype(np.float64) if np is not None else None
+        self.float32Type = np.dtype(np.float32) if np is not None else None
+        self.int32Type = np.dtype(np.int32) if np is not None else None
+        self.int64Type = np.dtype(np.int64) if np is not None else None
+        self.boolType = np.dtype(np.bool_) if np is not None else None
+        self.arrayFunctions = {}
+        self.arrayAddresses = {}
+        for name in ["fmi2_getReal", "fmi2_setReal", "fmi2_getInteger", "fmi2_setInteger", "fmi2_getBoolean", "fmi2_setBoolean"]:
+            self.arrayFunctions[name] = self.createArrayFunction(name, ct.c_void_p, ct.c_void_p, ct.c_size_t, ct.c_void_p)
+        for name in ["fmi3_getFloat64", "fmi3_setFloat64", "fmi3_getFloat32", "fmi3_setFloat32", "fmi3_getInt32", "fmi3_setInt32",
+                     "fmi3_getInt64", "fmi3_setInt64", "fmi3_getBoolean", "fmi3_setBoolean"]:
+            self.arrayFunctions[name] = self.createArrayFunction(name, ct.c_void_p, ct.c_void_p, ct.c_size_t, ct.c_void_p, ct.c_size_t)
+        for name in ["fmi2_getContinuousStates", "fmi2_setContinuousStates", "fmi2_getDerivatives", "fmi2_getEventIndicators",
+                     "fmi3_getContinuousStates", "fmi3_setContinuousStates", "fmi3_getContinuousStateDerivatives", "fmi3_getEventIndicators"]:
+            self.arrayFunctions[name] = self.createArrayFunction(name, ct.c_void_p, ct.c_void_p, ct.c_size_t)
+        for name in ["fmi4c_simulateFmi2", "fmi4c_simulateFmi3"]:
+            self.arrayFunctions[name] = self.createArrayFunction(name, ct.c_void_p, ct.c_int, ct.c_int, ct.c_void_p, ct.c_size_t, ct.c_void_p, ct.c_size_t,
+                                                                 ct.c_void_p, ct.c_void_p, ct.c_size_t, ct.c_void_p, ct.c_size_t, ct.c_void_p)
+            self.arrayFunctions[name].restype = ct.c_bool
+        self.hdll.fmi4c_getSolverMethodByName.restype = ct.c_bool
+        self.hdll.fmi4c_getSolverMethodByName.argtypes = ct.c_char_p, ct.POINTER(ct.c_int),
+
+    def createArrayFunction(self, name, *argtypes):
+        function = self.hdll[name]    # New function object, so that the argument types of self.hdll.name are kept
+        function.restype = ct.c_int
+        function.argtypes = argtypes
+        return function
+
+    #Returns the array as a contiguous NumPy array of the type, which is the array itself if it already is one
+    @staticmethod
+    def toArray(array, dtype):
+        if np is None:
+            raise ImportError("NumPy is required for array functions")
+        if type(array) is np.ndarray and array.dtype is dtype and array.flags.c_contiguous:
+            return array
+        return np.ascontiguousarray(array, dtype=dtype)
+
+    #Returns the NumPy array for output values, which must be a contiguous writable array of the type if given
+    @staticmethod
+    def toOutputArray(values, n, dtype):
+        if values is None:
+            if np is None:
+                raise ImportError("NumPy is required for array functions")
+            return np.empty(n, dtype=dtype)
+        if type(values) is not np.ndarray or values.dtype != dtype or not values.flags.c_contiguous or not values.flags.writeable:
+            raise TypeError("Output values must be a contiguous writable NumPy array of "+np.dtype(dtype).name)
+        return values
+
+    #Returns the address of the data of a contiguous NumPy array. Given is the argument the caller passed, the address is
+    #only cached if the array is that argument, so that arrays that are passed every step are only looked up. The cache
+    #only keeps weak references to the arrays, so it never keeps them alive, and NumPy refuses to resize weakly referenced
+    #arrays in place. Arrays that were converted from other objects or allocated internally are temporary and not cached.
+    def arrayAddress(self, array, given):
+        if given is not array:
+            return array.ctypes.data
+        entry = self.arrayAddresses.get(id(array))
+        if entry is not None and entry[0]() is array:
+            return entry[1]
+        if len(self.arrayAddresses) >= 256:
+            self.arrayAddresses.clear()
+        address = array.ctypes.data
+        self.arrayAddresses[id(array)] = (weakref.ref(array), address)
+        return address
+
+    #Gets values into a NumPy array (allocated if values is None), returns [status, values]
+    def getArray(self, name, instance, valueReferences, values, dtype, nValues=None):
+        references = self.toArray(valueReferences, self.uint32Type)
+        valuesArray = self.toOutputArray(values, references.size if nValues is None else nValues, dtype)
+        if nValues is None:
+            success = self.arrayFunctions[name](instance, self.arrayAddress(references, valueReferences), references.size, self.arrayAddress(valuesArray, values))
+        else:
+            success = self.arrayFunctions[name](instance, self.arrayAddress(references, valueReferences), references.size, self.arrayAddress(valuesArray, values), valuesArray.size)
+        return [success, valuesArray]
+
+    #Sets values from a NumPy array (or anything that converts to one), returns the status
+    def setArray(self, name, instance, valueReferences, values, dtype, withCount):
+        references = self.toArray(valueReferences, self.uint32Type)
+        valuesArray = self.toArray(values, dtype)
+        if withCount:
+            return self.arrayFunctions[name](instance, self.arrayAddress(references, valueReferences), references.size, self.arrayAddress(valuesArray, values), valuesArray.size)
+        return self.arrayFunctions[name](instance, self.arrayAddress(references, valueReferences), references.size, self.arrayAddress(valuesArray, values))
+
+    #Simulates over a time grid in one call, returns [success, results] with one row per time and one column per output
+    def simulate(self, name, instance, type, times, outputRefs, inputRefs, inputTimes, inputValues, solver):
+        method = ct.c_int(0)
+        if not self.hdll.fmi4c_getSolverMethodByName(solver.encode(), ct.byref(method)):
+            raise ValueError("Unknown solver: "+solver)
+        times = self.toArray(times, self.float64Type)
+        outputRefs = self.toArray(outputRefs, self.uint32Type)
+        inputRefs = self.toArray(inputRefs, self.uint32Type)
+        inputTimes = self.toArray(inputTimes, self.float64Type)
+        inputValues = self.toArray(inputValues, self.float64Type).reshape(inputTimes.size, inputRefs.size)
+        results = np.empty((times.size, outputRefs.size), dtype=self.float64Type)
+        success = self.arrayFunctions[name](instance, type, method.value, times.ctypes.data, times.size, inputRefs.ctypes.data, inputRefs.size,
+                                            inputTimes.ctypes.data, inputValues.ctypes.data, inputTimes.size, outputRefs.ctypes.data, outputRefs.size,
+                                            results.ctypes.data)
+        return [success, results]
+
     def translateFmiVersion(self, version):
         match version:
             case 0:
@@ -1570,6 +1679,9 @@ class fmi4c:
     def fmi2_getModelStructureNumberOfDependencies(self, handle):
         return self.hdll.fmi2_getModelStructureNumberOfDependencies(handle)
         
+    def fmi2_getModelStructureDependenciesDefined(self, handle):
+        return self.hdll.fmi2_getModelStructureDependenciesDefined(handle)
+
     def fmi2_getModelStructureDependencyKindsDefined(self, handle):
         return self.hdll.fmi2_getModelStructureDependencyKindsDefined(handle)    
     
@@ -1702,6 +1814,26 @@ class fmi4c:
         valuesArray = double_array_type(*values)
         return self.hdll.fmi2_setString(comp, valueReferencesArray, nValueReferences, valuesArray)
 
+    #Array versions of get and set functions: valueReferences and values are NumPy arrays (uint32 and float64/int32),
+    #which are passed to the FMU without copying. Get functions fill values if given, else they return a new array.
+    def fmi2_getRealArray(self, comp, valueReferences, values=None):
+        return self.getArray("fmi2_getReal", comp, valueReferences, values, self.float64Type)
+
+    def fmi2_getIntegerArray(self, comp, valueReferences, values=None):
+        return self.getArray("fmi2_getInteger", comp, valueReferences, values, self.int32Type)
+
+    def fmi2_getBooleanArray(self, comp, valueReferences, values=None):
+        return self.getArray("fmi2_getBoolean", comp, valueReferences, values, self.int32Type)
+
+    def fmi2_setRealArray(self, comp, valueReferences, values):
+        return self.setArray("fmi2_setReal", comp, valueReferences, values, self.float64Type, False)
+
+    def fmi2_setIntegerArray(self, comp, valueReferences, values):
+        return self.setArray("fmi2_setInteger", comp, valueReferences, values, self.int32Type, False)
+
+    def fmi2_setBooleanArray(self, comp, valueReferences, values):
+        return self.setArray("fmi2_setBoolean", comp, valueReferences, values, self.int32Type, False)
+
     def fmi2_getFMUstate(self, comp, FMUstate):
         return self.hdll.fmi2_getFMUstate(comp, FMUstate)
 
@@ -1769,6 +1901,26 @@ class fmi4c:
         nominalsArray = double_array_type()
         success = self.hdll.fmi2_getNominalsOfContinuousStates(comp, nominalsArray, nNominals)
         return [success, list(nominalsArray)]
+
+    def fmi2_getContinuousStatesArray(self, comp, states):
+        return self.arrayFunctions["fmi2_getContinuousStates"](comp, self.arrayAddress(self.toOutputArray(states, 0, self.float64Type), states), states.size)
+
+    def fmi2_setContinuousStatesArray(self, comp, states):
+        statesArray = self.toArray(states, self.float64Type)
+        return self.arrayFunctions["fmi2_setContinuousStates"](comp, self.arrayAddress(statesArray, states), statesArray.size)
+
+    def fmi2_getDerivativesArray(self, comp, derivatives):
+        return self.arrayFunctions["fmi2_getDerivatives"](comp, self.arrayAddress(self.toOutputArray(derivatives, 0, self.float64Type), derivatives), derivatives.size)
+
+    def fmi2_getEventIndicatorsArray(self, comp, eventIndicators):
+        return self.arrayFunctions["fmi2_getEventIndicators"](comp, self.arrayAddress(self.toOutputArray(eventIndicators, 0, self.float64Type), eventIndicators), eventIndicators.size)
+
+    #Simulates an initialized instance (type 0 = model exchange, 1 = co-simulation) over a time grid in one call. Inputs
+    #are a table with one row of input values per input time, interpolated linearly. Returns [success, results], where
+    #results has one row per time and one column per output. The GIL is released during the simulation, so several
+    #instances can be simulated concurrently from Python threads.
+    def fmi2_simulate(self, comp, type, times, outputRefs, inputRefs=[], inputTimes=[], inputValues=[], solver="euler"):
+        return self.simulate("fmi4c_simulateFmi2", comp, type, times, outputRefs, inputRefs, inputTimes, inputValues, solver)
         
     def fmi2_setRealInputDerivatives(self, comp, vr,  nvr,  order, value):
         return self.hdll.fmi2_setRealInputDerivatives(comp, vr,  nvr,  order, value)
@@ -2211,6 +2363,9 @@ class fmi4c:
     def fmi3_getModelStructureNumberOfDependencies(self, handle):
         return self.hdll.fmi3_getModelStructureNumberOfDependencies(handle)
         
+    def fmi3_getModelStructureDependenciesDefined(self, handle):
+        return self.hdll.fmi3_getModelStructureDependenciesDefined(handle)
+
     def fmi3_getModelStructureDependencyKindsDefined(self, handle):
         return self.hdll.fmi3_getModelStructureDependencyKindsDefined(handle)    
     
@@ -2381,6 +2536,47 @@ class fmi4c:
     def fmi3_reset(self, instance):
         return self.hdll.fmi3_reset(instance)
 
+    #Array versions of get and set functions: valueReferences and values are NumPy arrays (uint32 and the type of the
+    #variables), which are passed to the FMU without copying. Get functions fill values if given, else they return a new
+    #array of nValues values (one per value reference by default).
+    def fmi3_getFloat64Array(self, instance, valueReferences, values=None, nValues=None):
+        return self.getArray("fmi3_getFloat64", instance, valueReferences, values, self.float64Type, self.arrayValueCount(valueReferences, values, nValues))
+
+    def fmi3_getFloat32Array(self, instance, valueReferences, values=None, nValues=None):
+        return self.getArray("fmi3_getFloat32", instance, valueReferences, values, self.float32Type, self.arrayValueCount(valueReferences, values, nValues))
+
+    def fmi3_getInt32Array(self, instance, valueReferences, values=None, nValues=None):
+        return self.getArray("fmi3_getInt32", instance, valueReferences, values, self.int32Type, self.arrayValueCount(valueReferences, values, nValues))
+
+    def fmi3_getInt64Array(self, instance, valueReferences, values=None, nValues=None):
+        return self.getArray("fmi3_getInt64", instance, valueReferences, values, self.int64Type, self.arrayValueCount(valueReferences, values, nValues))
+
+    def fmi3_getBooleanArray(self, instance, valueReferences, values=None, nValues=None):
+        return self.getArray("fmi3_getBoolean", instance, valueReferences, values, self.boolType, self.arrayValueCount(valueReferences, values, nValues))
+
+    def fmi3_setFloat64Array(self, instance, valueReferences, values):
+        return self.setArray("fmi3_setFloat64", instance, valueReferences, values, self.float64Type, True)
+
+    def fmi3_setFloat32Array(self, instance, valueReferences, values):
+        return self.setArray("fmi3_setFloat32", instance, valueReferences, values, self.float32Type, True)
+
+    def fmi3_setInt32Array(self, instance, valueReferences, values):
+        return self.setArray("fmi3_setInt32", instance, valueReferences, values, self.int32Type, True)
+
+    def fmi3_setInt64Array(self, instance, valueReferences, values):
+        return self.setArray("fmi3_setInt64", instance, valueReferences, values, self.int64Type, True)
+
+    def fmi3_setBooleanArray(self, instance, valueReferences, values):
+        return self.setArray("fmi3_setBoolean", instance, valueReferences, values, self.boolType, True)
+
+    @staticmethod
+    def arrayValueCount(valueReferences, values, nValues):
+        if values is not None:
+            return values.size
+        if nValues is not None:
+            return nValues
+        return len(valueReferences)
+
     def fmi3_getFloat64(self, instance, valueReferences, nValueReferences, nValues):
         uint_array_type = ct.c_uint * nValueReferences
         double_array_type = ct.c_double * nValueReferences
@@ -2778,6 +2974,24 @@ class fmi4c:
         success = self.hdll.fmi3_getNominalsOfContinuousStates(instance, nominals_array, nContinuousStates)
         return (success, list(nominals_array))
 
+    def fmi3_getContinuousStatesArray(self, instance, continuousStates):
+        return self.arrayFunctions["fmi3_getContinuousStates"](instance, self.arrayAddress(self.toOutputArray(continuousStates, 0, self.float64Type), continuousStates), continuousStates.size)
+
+    def fmi3_setContinuousStatesArray(self, instance, continuousStates):
+        statesArray = self.toArray(continuousStates, self.float64Type)
+        return self.arrayFunctions["fmi3_setContinuousStates"](instance, self.arrayAddress(statesArray, continuousStates), statesArray.size)
+
+    def fmi3_getContinuousStateDerivativesArray(self, instance, derivatives):
+        return self.arrayFunctions["fmi3_getContinuousStateDerivatives"](instance, self.arrayAddress(self.toOutputArray(derivatives, 0, self.float64Type), derivatives), derivatives.size)
+
+    def fmi3_getEventIndicatorsArray(self, instance, eventIndicators):
+        return self.arrayFunctions["fmi3_getEventIndicators"](instance, self.arrayAddress(self.toOutputArray(eventIndicators, 0, self.float64Type), eventIndicators), eventIndicators.size)
+
+    #Simulates an initialized instance (type 0 = model exchange, 1 = co-simulation) over a time grid in one call, see
+    #fmi2_simulate. Co-simulation instances must be instantiated without event mode and early return.
+    def fmi3_simulate(self, instance, type, times, outputRefs, inputRefs=[], inputTimes=[], inputValues=[], solver="euler"):
+        return self.simulate("fmi4c_simulateFmi3", instance, type, times, outputRefs, inputRefs, inputTimes, inputValues, solver)
+
     def fmi3_getNumberOfEventIndicators(self, instance):
         nEventIndicators = ct.c_size_t()
         success = self.hdll.fmi3_getNumberOfEventIndicators(instance, ct.byref(nEventIndicators))
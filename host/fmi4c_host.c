@@ -0,0 +1,27 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fmi4c.h"
+#include "fmi4c_remote.h"
+
+// Host process for out-of-process FMU instances, started by fmi4c with the file descriptor of the
+// shared memory channel. Serves one instance and exits when it is freed.
+
+static void messageCallback(const char* msg)
+{
+    fprintf(stderr, "%s\n", msg);
+}
+
+int main(int argc, char *argv[])
+{
+    int fd = -1;
+    if(argc != 3 || strcmp(argv[1], "--fd") || sscanf(argv[2], "%i", &fd) != 1 || fd < 0) {
+        fprintf(stderr, "Usage: %s --fd <shared memory file descriptor>\n", argv[0]);
+        fprintf(stderr, "This program is started by fmi4c for out-of-process FMU instances.\n");
+        return 1;
+    }
+
+    fmi4c_setMessageFunction(&messageCallback);
+    return fmi4c_serveRemoteInstance(fd);
+}
@@ -45,6 +45,7 @@ FMI4C_DLLAPI fmiVersion_t fmi4c_getFmiVersion(fmuHandle *fmu);
 FMI4C_DLLAPI fmuHandle *fmi4c_loadUnzippedFmu(const char *instanceName, const char *unzipLocation);
 FMI4C_DLLAPI fmuHandle* fmi4c_loadFmu(const char *fmufile, const char* instanceName);
 FMI4C_DLLAPI void fmi4c_freeFmu(fmuHandle* fmu);
+FMI4C_DLLAPI bool fmi4c_setFmuBinaryIsolation(fmuHandle *fmu, fmi4cBinaryIsolation isolation);
 
 // FMI 1 wrapper functions
 FMI4C_DLLAPI fmi1Type fmi1_getType(fmuHandle *fmu);
@@ -227,6 +228,7 @@ FMI4C_DLLAPI fmi2ModelStructureHandle *fmi2_getModelStructureDerivative(fmuHandl
 FMI4C_DLLAPI fmi2ModelStructureHandle *fmi2_getModelStructureInitialUnknown(fmuHandle *fmu, size_t i);
 FMI4C_DLLAPI int fmi2_getModelStructureIndex(fmi2ModelStructureHandle *handle);
 FMI4C_DLLAPI int fmi2_getModelStructureNumberOfDependencies(fmi2ModelStructureHandle *handle);
+FMI4C_DLLAPI bool fmi2_getModelStructureDependenciesDefined(fmi2ModelStructureHandle *handle);
 FMI4C_DLLAPI bool fmi2_getModelStructureDependencyKindsDefined(fmi2ModelStructureHandle *handle);
 FMI4C_DLLAPI void fmi2_getModelStructureDependencies(fmi2ModelStructureHandle *handle, int *dependencies, size_t numberOfDependencies);
 FMI4C_DLLAPI void fmi2_getModelStructureDependencyKinds(fmi2ModelStructureHandle *handle, int *dependencyKinds, size_t numberOfDependencies);
@@ -362,6 +364,10 @@ FMI4C_DLLAPI fmi3Boolean fmi3_getVariableStartBoolean(fmi3VariableHandle *var);
 FMI4C_DLLAPI fmi3String fmi3_getVariableStartString(fmi3VariableHandle *var);
 FMI4C_DLLAPI fmi3Binary fmi3_getVariableStartBinary(fmi3VariableHandle *var);
 FMI4C_DLLAPI fmi3ValueReference fmi3_getVariableValueReference(fmi3VariableHandle* var);
+FMI4C_DLLAPI int fmi3_getVariablePriority(fmi3VariableHandle* var);
+FMI4C_DLLAPI fmi3IntervalVariability fmi3_getVariableIntervalVariability(fmi3VariableHandle* var);
+FMI4C_DLLAPI double fmi3_getVariableIntervalDecimal(fmi3VariableHandle* var);
+FMI4C_DLLAPI double fmi3_getVariableShiftDecimal(fmi3VariableHandle* var);
 
 FMI4C_DLLAPI const char* fmi3_modelName(fmuHandle *fmu);
 FMI4C_DLLAPI const char* fmi3_instantiationToken(fmuHandle *fmu);
@@ -515,6 +521,7 @@ FMI4C_DLLAPI fmi3ModelStructureHandle *fmi3_getModelStructureInitialUnknown(fmuH
 FMI4C_DLLAPI fmi3ModelStructureHandle *fmi3_getModelStructureEventIndicator(fmuHandle *fmu, size_t i);
 FMI4C_DLLAPI fmi3ValueReference fmi3_getModelStructureValueReference(fmi3ModelStructureHandle *handle);
 FMI4C_DLLAPI int fmi3_getModelStructureNumberOfDependencies(fmi3ModelStructureHandle *handle);
+FMI4C_DLLAPI bool fmi3_getModelStructureDependenciesDefined(fmi3ModelStructureHandle *handle);
 FMI4C_DLLAPI bool fmi3_getModelStructureDependencyKindsDefined(fmi3ModelStructureHandle *handle);
 FMI4C_DLLAPI void fmi3_getModelStructureDependencies(fmi3ModelStructureHandle *handle, int *dependencies, size_t numberOfDependencies);
 FMI4C_DLLAPI void fmi3_getModelStructureDependencyKinds(fmi3ModelStructureHandle *handle, int *dependencyKinds, size_t numberOfDependencies);
@@ -573,6 +580,15 @@ FMI4C_DLLAPI fmi3InstanceHandle *fmi3_instantiateModelExchange(fmuHandle *fmu,
                                                                fmi3InstanceEnvironment    instanceEnvironment,
                                                                fmi3LogMessageCallback     logMessage);
 
+FMI4C_DLLAPI fmi3InstanceHandle *fmi3_instantiateScheduledExecution(fmuHandle *fmu,
+                                                                    fmi3Boolean                  visible,
+                                                                    fmi3Boolean                  loggingOn,
+                                                                    fmi3InstanceEnvironment      instanceEnvironment,
+                                                                    fmi3LogMessageCallback       logMessage,
+                                                                    fmi3ClockUpdateCallback      clockUpdate,
+                                                                    fmi3CallbackLockPreemption   lockPreemption,
+                                                                    fmi3CallbackUnlockPreemption unlockPreemption);
+
 FMI4C_DLLAPI const char* fmi3_getVersion(fmuHandle *fmu);
 
 FMI4C_DLLAPI fmi3Status fmi3_setDebugLogging(fmi3InstanceHandle *instance,
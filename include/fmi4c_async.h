@@ -0,0 +1,57 @@
+#ifndef FMIC_ASYNC_H
+#define FMIC_ASYNC_H
+
+#include "fmi4c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Asynchronous co-simulation steps
+//
+// fmi2_doStepAsync and fmi3_doStepAsync queue a call to fmi2_doStep or fmi3_doStep on an internal
+// executor (a set of worker threads created on first use) and return immediately with a future.
+// The future can be polled, waited on, or given a completion callback, and must be freed by the
+// caller. The status of the step can be read once it has finished. Steps queued for the same
+// instance are executed one at a time in the order they were queued, steps for different instances
+// run concurrently.
+//
+// An instance must not be accessed by any other function while it has unfinished steps. Wait for
+// all of its futures before getting outputs, setting inputs or freeing it.
+
+typedef struct fmi4cStepFuture fmi4cStepFuture;
+
+// Called on the executor thread when the step has finished, before threads waiting for the step are
+// released. Must not wait for or free the future.
+typedef void (*fmi4cStepCallback_t)(fmi4cStepFuture *future, void *userData);
+
+FMI4C_DLLAPI fmi4cStepFuture *fmi2_doStepAsync(fmi2InstanceHandle *instance,
+                                               fmi2Real currentCommunicationPoint,
+                                               fmi2Real communicationStepSize,
+                                               fmi2Boolean noSetFMUStatePriorToCurrentPoint);
+FMI4C_DLLAPI fmi4cStepFuture *fmi3_doStepAsync(fmi3InstanceHandle *instance,
+                                               fmi3Float64 currentCommunicationPoint,
+                                               fmi3Float64 communicationStepSize,
+                                               fmi3Boolean noSetFMUStatePriorToCurrentPoint);
+
+FMI4C_DLLAPI bool fmi4c_isStepReady(fmi4cStepFuture *future);
+FMI4C_DLLAPI void fmi4c_waitStep(fmi4cStepFuture *future);
+FMI4C_DLLAPI void fmi4c_waitAllSteps(fmi4cStepFuture **futures, size_t nFutures);
+FMI4C_DLLAPI void fmi4c_setStepCallback(fmi4cStepFuture *future, fmi4cStepCallback_t callback, void *userData);
+FMI4C_DLLAPI void fmi4c_freeStep(fmi4cStepFuture *future);
+
+FMI4C_DLLAPI fmi2Status fmi2_getStepStatus(fmi4cStepFuture *future);
+FMI4C_DLLAPI fmi3Status fmi3_getStepStatus(fmi4cStepFuture *future,
+                                           fmi3Boolean *eventEncountered,
+                                           fmi3Boolean *terminateSimulation,
+                                           fmi3Boolean *earlyReturn,
+                                           fmi3Float64 *lastSuccessfulTime);
+
+FMI4C_DLLAPI bool fmi4c_setStepExecutorThreads(int nThreads);
+FMI4C_DLLAPI void fmi4c_freeStepExecutor(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FMIC_ASYNC_H
@@ -0,0 +1,59 @@
+#ifndef FMIC_CHECKPOINT_H
+#define FMIC_CHECKPOINT_H
+
+#include "fmi4c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Checkpoint store for serialized FMU states
+//
+// Checkpoints are byte blobs keyed by an arbitrary pointer (usually the instance handle) and a time.
+// Saving a checkpoint with an existing key and time replaces it. Blobs are split into fixed-size
+// chunks, and chunks are deduplicated across all checkpoints, so states that differ in a few bytes
+// only store the changed chunks. Chunks are looked up by a 128-bit content hash and compared byte by
+// byte when the hashes are equal. New chunks are compressed with zlib
+// (when fmi4c is built with FMI4C_WITH_ZLIB), or stored as is when compression does not pay off.
+//
+// Chunks are kept in memory until the memory budget is reached. Further chunks are written to a
+// memory-mapped spill file in the spill directory (the system temporary directory by default), which
+// is deleted when the store is freed. Space of removed chunks in the spill file is kept in a list of
+// free ranges and reused for new chunks.
+//
+// Restored blobs are bit-exact. All functions are thread safe.
+
+typedef struct fmi4cCheckpointStore fmi4cCheckpointStore;
+
+typedef struct {
+    size_t numberOfCheckpoints;
+    size_t checkpointBytes;     // Sum of the sizes of all checkpoints
+    size_t numberOfChunks;      // Unique chunks
+    size_t chunkBytes;          // Uncompressed size of the unique chunks
+    size_t memoryBytes;         // Stored (compressed) size of the chunks in memory
+    size_t spilledBytes;        // Stored (compressed) size of the chunks in the spill file
+    size_t spillFileBytes;      // Used size of the spill file, including free ranges between chunks
+    size_t indexSlots;          // Slots of the chunk and checkpoint hash indices
+} fmi4cCheckpointStatistics;
+
+FMI4C_DLLAPI fmi4cCheckpointStore *fmi4c_createCheckpointStore(size_t memoryBudget, const char *spillDirectory);
+FMI4C_DLLAPI void fmi4c_freeCheckpointStore(fmi4cCheckpointStore *store);
+
+FMI4C_DLLAPI bool fmi4c_putCheckpoint(fmi4cCheckpointStore *store, const void *key, double time, const void *data, size_t size);
+FMI4C_DLLAPI size_t fmi4c_getCheckpointSize(fmi4cCheckpointStore *store, const void *key, double time);
+FMI4C_DLLAPI bool fmi4c_getCheckpoint(fmi4cCheckpointStore *store, const void *key, double time, void *data, size_t size);
+FMI4C_DLLAPI bool fmi4c_removeCheckpoint(fmi4cCheckpointStore *store, const void *key, double time);
+FMI4C_DLLAPI size_t fmi4c_removeCheckpoints(fmi4cCheckpointStore *store, const void *key, double fromTime, double toTime);
+
+FMI4C_DLLAPI bool fmi4c_saveCheckpointFmi2(fmi4cCheckpointStore *store, fmi2InstanceHandle *instance, double time);
+FMI4C_DLLAPI bool fmi4c_restoreCheckpointFmi2(fmi4cCheckpointStore *store, fmi2InstanceHandle *instance, double time);
+FMI4C_DLLAPI bool fmi4c_saveCheckpointFmi3(fmi4cCheckpointStore *store, fmi3InstanceHandle *instance, double time);
+FMI4C_DLLAPI bool fmi4c_restoreCheckpointFmi3(fmi4cCheckpointStore *store, fmi3InstanceHandle *instance, double time);
+
+FMI4C_DLLAPI void fmi4c_getCheckpointStatistics(fmi4cCheckpointStore *store, fmi4cCheckpointStatistics *statistics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FMIC_CHECKPOINT_H
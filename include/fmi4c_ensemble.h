@@ -0,0 +1,48 @@
+#ifndef FMIC_ENSEMBLE_H
+#define FMIC_ENSEMBLE_H
+
+#include "fmi4c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Fork-based ensemble runner (Linux only)
+//
+// Runs many samples (e.g. Monte Carlo) of one FMU without paying for unzipping, loading,
+// instantiation and initialization per sample. The caller prepares one initialized template
+// instance, and every sample runs in a process forked from the calling process, which inherits the
+// instance (and the rest of the address space) copy-on-write. Per-sample startup is thereby reduced
+// to the fork latency, and samples can not affect each other or the template.
+//
+// The sample callback is called in the worker process with the template instance. It applies the
+// parameters of the sample, simulates, and writes up to the configured number of result values,
+// which are passed back to the caller through shared memory. Worker processes exit when the
+// callback returns, without freeing anything. Samples whose callback returns false or whose worker
+// process crashes are reported as failed.
+//
+// Up to the configured number of worker processes run concurrently. Only the thread calling
+// fmi4c_runEnsemble exists in the worker processes, so the callback must not depend on other
+// threads of the application (for example a master thread pool).
+
+typedef struct fmi4cEnsemble fmi4cEnsemble;
+
+typedef bool (*fmi4cEnsembleSampleCallback)(void *instance, int sample, double *results, void *userData);
+
+FMI4C_DLLAPI fmi4cEnsemble *fmi4c_createEnsembleFmi2(fmi2InstanceHandle *instance);
+FMI4C_DLLAPI fmi4cEnsemble *fmi4c_createEnsembleFmi3(fmi3InstanceHandle *instance);
+FMI4C_DLLAPI void fmi4c_freeEnsemble(fmi4cEnsemble *ensemble);
+
+FMI4C_DLLAPI void fmi4c_setEnsembleWorkers(fmi4cEnsemble *ensemble, int nWorkers);
+FMI4C_DLLAPI void fmi4c_setEnsembleResultSize(fmi4cEnsemble *ensemble, size_t nResults);
+
+FMI4C_DLLAPI bool fmi4c_runEnsemble(fmi4cEnsemble *ensemble, int nSamples, fmi4cEnsembleSampleCallback callback, void *userData, double *results, bool *succeeded);
+
+FMI4C_DLLAPI int fmi4c_getEnsembleNumberOfFailedSamples(fmi4cEnsemble *ensemble);
+FMI4C_DLLAPI double fmi4c_getEnsembleMeanStartupTime(fmi4cEnsemble *ensemble);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FMIC_ENSEMBLE_H
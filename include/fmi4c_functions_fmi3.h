@@ -25,6 +25,8 @@ typedef void (*fmi3IntermediateUpdateCallback)(fmi3InstanceEnvironment instanceE
                                                fmi3Boolean* earlyReturnRequested,
                                                fmi3Float64* earlyReturnTime);
 
+typedef void (*fmi3ClockUpdateCallback)(fmi3InstanceEnvironment instanceEnvironment);
+
 typedef void (*fmi3CallbackLockPreemption)();
 typedef void (*fmi3CallbackUnlockPreemption)();
 
@@ -37,12 +39,12 @@ typedef fmi3Component *(STDCALL *fmi3InstantiateCoSimulation_t)(fmi3String, fmi3
                                                                      fmi3Boolean, fmi3Boolean, const fmi3ValueReference[], size_t,
                                                                      fmi3InstanceEnvironment, fmi3LogMessageCallback,
                                                                      fmi3IntermediateUpdateCallback);
-typedef fmi3InstanceHandle *(STDCALL *fmi3InstantiateScheduledExecution_t)(fmi3String, fmi3String, fmi3String, fmi3Boolean,
-                                                                           fmi3Boolean,
-                                                                           fmi3InstanceEnvironment, fmi3LogMessageCallback,
-                                                                           fmi3IntermediateUpdateCallback,
-                                                                           fmi3CallbackLockPreemption,
-                                                                           fmi3CallbackUnlockPreemption);
+typedef fmi3Component *(STDCALL *fmi3InstantiateScheduledExecution_t)(fmi3String, fmi3String, fmi3String, fmi3Boolean,
+                                                                      fmi3Boolean,
+                                                                      fmi3InstanceEnvironment, fmi3LogMessageCallback,
+                                                                      fmi3ClockUpdateCallback,
+                                                                      fmi3CallbackLockPreemption,
+                                                                      fmi3CallbackUnlockPreemption);
 typedef void (STDCALL *fmi3FreeInstance_t)(fmi3Component*);
 typedef fmi3Status (STDCALL *fmi3EnterInitializationMode_t)(fmi3Component*, fmi3Boolean, fmi3Float64,
                                                               fmi3Float64, fmi3Boolean, fmi3Float64);
@@ -0,0 +1,57 @@
+#ifndef FMIC_INPUT_H
+#define FMIC_INPUT_H
+
+#include "fmi4c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Input signals read from a file, for driving FMU inputs
+//
+// The first column is time, the other columns are signals. Files are read in chunks of rows, and
+// only the two chunks around the current time are kept in memory, so there is no limit on the
+// number of rows or columns. Lookups continue from the previous time, which makes stepping forward
+// cheap. Going back in time re-reads earlier chunks using an index of chunk positions, which is
+// built while reading.
+//
+// Supported formats (selected by the file name extension):
+// - CSV files with a header row with the names, and one row per time point (any other extension)
+// - MATLAB level 4 MAT-files as written by fmi4c_createResultWriter (.mat), which are read without parsing
+//
+// Values are interpolated linearly in time (by default), held from the last time point (zero-order
+// hold), or interpolated with cubic Hermite splines whose tangents are the mean slopes of the
+// neighbouring intervals. They are held constant before the first and after the last time point.
+// With several rows at the same time (events), the last row applies from that time, and splines do
+// not extend across the event. All signals are interpolated together from one time cursor, so
+// stepping forward costs the same regardless of the length of the file.
+// All functions are thread safe.
+
+typedef struct fmi4cInputSignals fmi4cInputSignals;
+
+typedef enum {
+    fmi4cInterpolationLinear,
+    fmi4cInterpolationZeroOrderHold,
+    fmi4cInterpolationCubicHermite
+} fmi4cInterpolationMethod;
+
+FMI4C_DLLAPI fmi4cInputSignals *fmi4c_openInputSignals(const char *path);
+FMI4C_DLLAPI void fmi4c_closeInputSignals(fmi4cInputSignals *signals);
+
+FMI4C_DLLAPI size_t fmi4c_getNumberOfInputSignals(fmi4cInputSignals *signals);
+FMI4C_DLLAPI const char *fmi4c_getInputSignalName(fmi4cInputSignals *signals, size_t signal);
+FMI4C_DLLAPI int fmi4c_getInputSignalIndex(fmi4cInputSignals *signals, const char *name);
+
+FMI4C_DLLAPI bool fmi4c_getInterpolationMethodByName(const char *name, fmi4cInterpolationMethod *method);
+FMI4C_DLLAPI const char *fmi4c_getInterpolationMethodName(fmi4cInterpolationMethod method);
+FMI4C_DLLAPI void fmi4c_setInputSignalInterpolation(fmi4cInputSignals *signals, fmi4cInterpolationMethod method);
+
+FMI4C_DLLAPI bool fmi4c_getInputSignalValues(fmi4cInputSignals *signals, double time, double *values);
+FMI4C_DLLAPI bool fmi4c_getInputSignalValuesAndDerivatives(fmi4cInputSignals *signals, double time, double *values, double *derivatives);
+FMI4C_DLLAPI double fmi4c_getInputSignalValue(fmi4cInputSignals *signals, size_t signal, double time);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FMIC_INPUT_H
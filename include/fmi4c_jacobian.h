@@ -0,0 +1,44 @@
+#ifndef FMIC_JACOBIAN_H
+#define FMIC_JACOBIAN_H
+
+#include "fmi4c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Sparse Jacobians of a model exchange instance with respect to its continuous states
+//
+// The state Jacobian (df/dx) has one row per state derivative, the output Jacobian (dy/dx) one row
+// per real output. The sparsity pattern is built from the ModelStructure dependencies and stored in
+// CSR form. Columns that never share a row are grouped by a DSATUR graph coloring, so that one
+// directional derivative (or one finite difference evaluation) per color is enough to compute all
+// non-zero elements. Rows without declared dependencies are treated as dense.
+
+typedef struct fmi4cJacobian fmi4cJacobian;
+
+FMI4C_DLLAPI fmi4cJacobian *fmi4c_createStateJacobianFmi2(fmi2InstanceHandle *instance, size_t nStates);
+FMI4C_DLLAPI fmi4cJacobian *fmi4c_createStateJacobianFmi3(fmi3InstanceHandle *instance, size_t nStates);
+FMI4C_DLLAPI fmi4cJacobian *fmi4c_createOutputJacobianFmi2(fmi2InstanceHandle *instance, size_t nStates);
+FMI4C_DLLAPI fmi4cJacobian *fmi4c_createOutputJacobianFmi3(fmi3InstanceHandle *instance, size_t nStates);
+FMI4C_DLLAPI void fmi4c_freeJacobian(fmi4cJacobian *jacobian);
+
+FMI4C_DLLAPI bool fmi4c_evaluateJacobian(fmi4cJacobian *jacobian, const double *states, const double *unknowns, const double *nominals);
+
+FMI4C_DLLAPI size_t fmi4c_getJacobianNumberOfRows(fmi4cJacobian *jacobian);
+FMI4C_DLLAPI size_t fmi4c_getJacobianNumberOfColumns(fmi4cJacobian *jacobian);
+FMI4C_DLLAPI size_t fmi4c_getJacobianNumberOfNonZeros(fmi4cJacobian *jacobian);
+FMI4C_DLLAPI const size_t *fmi4c_getJacobianRowPointers(fmi4cJacobian *jacobian);
+FMI4C_DLLAPI const size_t *fmi4c_getJacobianColumnIndices(fmi4cJacobian *jacobian);
+FMI4C_DLLAPI const double *fmi4c_getJacobianValues(fmi4cJacobian *jacobian);
+FMI4C_DLLAPI void fmi4c_getJacobianDense(fmi4cJacobian *jacobian, double *matrix);
+FMI4C_DLLAPI int fmi4c_getJacobianNumberOfColors(fmi4cJacobian *jacobian);
+FMI4C_DLLAPI const int *fmi4c_getJacobianColumnColors(fmi4cJacobian *jacobian);
+FMI4C_DLLAPI bool fmi4c_getJacobianUsesDirectionalDerivatives(fmi4cJacobian *jacobian);
+FMI4C_DLLAPI bool fmi4c_setJacobianUsesDirectionalDerivatives(fmi4cJacobian *jacobian, bool useDirectionalDerivatives);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FMIC_JACOBIAN_H
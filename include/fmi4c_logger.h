@@ -0,0 +1,49 @@
+#ifndef FMIC_LOGGER_H
+#define FMIC_LOGGER_H
+
+#include "fmi4c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Asynchronous logger for FMU log callbacks
+//
+// Messages are filtered by status and category on the calling thread before any formatting takes
+// place. Accepted messages are copied (format string and raw arguments) into a lock-free ring buffer
+// owned by the calling thread, and are formatted and written by a background thread. If a ring buffer
+// is full the message is dropped and counted, the FMU thread never blocks on the logger.
+
+typedef struct fmi4cLogger fmi4cLogger;
+
+// Log levels, same meaning as the log level option in the test executable
+typedef enum {
+    fmi4cLogLevelNothing = 0,   // No logging
+    fmi4cLogLevelFatal = 1,     // Fatal
+    fmi4cLogLevelError = 2,     // Fatal & errors
+    fmi4cLogLevelWarning = 3,   // Fatal, errors, warnings & discard
+    fmi4cLogLevelInfo = 4,      // Fatal, errors, warnings, discard, OK & pending
+    fmi4cLogLevelDebug = 5      // Everything
+} fmi4cLogLevel;
+
+FMI4C_DLLAPI fmi4cLogger *fmi4c_createLogger(FILE *output, fmi4cLogLevel level, size_t recordsPerThread);
+FMI4C_DLLAPI void fmi4c_freeLogger(fmi4cLogger *logger);
+FMI4C_DLLAPI void fmi4c_flushLogger(fmi4cLogger *logger);
+FMI4C_DLLAPI void fmi4c_setLoggerLevel(fmi4cLogger *logger, fmi4cLogLevel level);
+FMI4C_DLLAPI void fmi4c_setLoggerCategoryEnabled(fmi4cLogger *logger, const char *category, bool enabled);
+FMI4C_DLLAPI size_t fmi4c_getLoggerNumberOfDroppedMessages(fmi4cLogger *logger);
+FMI4C_DLLAPI size_t fmi4c_getLoggerNumberOfTruncatedMessages(fmi4cLogger *logger);
+
+FMI4C_DLLAPI void fmi4c_setActiveLogger(fmi4cLogger *logger);
+FMI4C_DLLAPI fmi4cLogger *fmi4c_getActiveLogger(void);
+
+// Callbacks that can be passed directly to the instantiate functions, they forward to the active logger
+FMI4C_DLLAPI void fmi4c_loggerFmi1(fmi1Component *component, fmi1String instanceName, fmi1Status status, fmi1String category, fmi1String message, ...);
+FMI4C_DLLAPI void fmi4c_loggerFmi2(fmi2ComponentEnvironment componentEnvironment, fmi2String instanceName, fmi2Status status, fmi2String category, fmi2String message, ...);
+FMI4C_DLLAPI void fmi4c_loggerFmi3(fmi3InstanceEnvironment instanceEnvironment, fmi3Status status, fmi3String category, fmi3String message);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FMIC_LOGGER_H
@@ -0,0 +1,90 @@
+#ifndef FMIC_MASTER_H
+#define FMIC_MASTER_H
+
+#include "fmi4c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Co-simulation master
+//
+// Steps a set of co-simulation instances (subsystems) connected by real-valued output to input
+// connections, on a persistent thread pool. Inputs and outputs of each subsystem are exchanged with
+// one batched get/set call per step, using I/O plans built by fmi4c_initializeMaster().
+//
+// With Jacobi stepping (default) all doStep calls of a communication step run concurrently, in
+// contiguous blocks of subsystems per worker. Outputs are double buffered, so every input receives
+// the output value from the end of the previous communication step.
+//
+// With Gauss-Seidel stepping the connection graph is split into strongly connected components
+// (coupling loops) and levels. Levels are stepped in order and the components within a level
+// concurrently, so inputs receive the outputs at the end of the current step from earlier levels.
+// Members of a coupling loop are stepped serially, ordered along inputs with direct feedthrough
+// (from the ModelStructure output dependencies), and the remaining loop connections are delayed one
+// step. Loops where all connections have feedthrough are reported as algebraic loops.
+//
+// With work stealing, the components of each level are placed on the workers by their measured step
+// times instead of in contiguous blocks, and each worker queues its components in a work-stealing
+// deque. Idle workers steal from the others within a step, and components are moved between workers
+// when the measured step times show a persistent imbalance.
+//
+// Subsystems can be bound to a worker, with or without work stealing. They are then always stepped by
+// that worker and never moved or stolen, also in levels with a single component, which are otherwise
+// stepped by the calling thread. Subsystems of FMUs that can only be instantiated once per process are
+// bound automatically.
+//
+// With adaptive stepping (requires that all FMUs can get and set their state), the master chooses the
+// communication step size from an estimate of the coupling error: the difference between the value
+// each input was held at during the step and the value of its source at the end of the step. Steps
+// with too large errors are rolled back by restoring the FMU states and retried with a smaller step
+// size, steps with small errors are accepted and the next step size is increased.
+//
+// Instances are owned by the caller and must have left initialization mode before the master is
+// initialized, and must not be freed before the master. Between steps the caller may access the instances freely.
+
+typedef struct fmi4cMaster fmi4cMaster;
+
+typedef enum {
+    fmi4cMasterJacobi,
+    fmi4cMasterGaussSeidel
+} fmi4cMasterMethod;
+
+typedef enum {
+    fmi4cMasterOK,
+    fmi4cMasterTerminate,       // At least one subsystem requested termination
+    fmi4cMasterError
+} fmi4cMasterStatus;
+
+FMI4C_DLLAPI fmi4cMaster *fmi4c_createMaster(void);
+FMI4C_DLLAPI void fmi4c_freeMaster(fmi4cMaster *master);
+
+FMI4C_DLLAPI int fmi4c_addMasterSubsystemFmi2(fmi4cMaster *master, fmi2InstanceHandle *instance);
+FMI4C_DLLAPI int fmi4c_addMasterSubsystemFmi3(fmi4cMaster *master, fmi3InstanceHandle *instance);
+FMI4C_DLLAPI bool fmi4c_addMasterConnection(fmi4cMaster *master, int fromSubsystem, unsigned int outputValueReference, int toSubsystem, unsigned int inputValueReference);
+FMI4C_DLLAPI void fmi4c_setMasterMethod(fmi4cMaster *master, fmi4cMasterMethod method);
+FMI4C_DLLAPI void fmi4c_setMasterThreads(fmi4cMaster *master, int nThreads, bool pinThreads);
+FMI4C_DLLAPI void fmi4c_setMasterAdaptiveStep(fmi4cMaster *master, bool adaptive);
+FMI4C_DLLAPI void fmi4c_setMasterTolerance(fmi4cMaster *master, double relativeTolerance, double absoluteTolerance);
+FMI4C_DLLAPI void fmi4c_setMasterStepSize(fmi4cMaster *master, double stepSize, double minStepSize, double maxStepSize);
+FMI4C_DLLAPI void fmi4c_setMasterWorkStealing(fmi4cMaster *master, bool enabled);
+FMI4C_DLLAPI bool fmi4c_setMasterSubsystemWorker(fmi4cMaster *master, int subsystem, int worker);
+
+FMI4C_DLLAPI bool fmi4c_initializeMaster(fmi4cMaster *master);
+FMI4C_DLLAPI fmi4cMasterStatus fmi4c_doMasterStep(fmi4cMaster *master, double currentTime, double stepSize);
+FMI4C_DLLAPI fmi4cMasterStatus fmi4c_doMasterAdaptiveStep(fmi4cMaster *master, double currentTime, double stopTime, double *nextTime);
+
+FMI4C_DLLAPI int fmi4c_getMasterNumberOfSubsystems(fmi4cMaster *master);
+FMI4C_DLLAPI int fmi4c_getMasterNumberOfThreads(fmi4cMaster *master);
+FMI4C_DLLAPI int fmi4c_getMasterNumberOfLevels(fmi4cMaster *master);
+FMI4C_DLLAPI int fmi4c_getMasterNumberOfAlgebraicLoops(fmi4cMaster *master);
+FMI4C_DLLAPI double fmi4c_getMasterParallelEfficiency(fmi4cMaster *master);
+FMI4C_DLLAPI size_t fmi4c_getMasterNumberOfSteals(fmi4cMaster *master);
+FMI4C_DLLAPI size_t fmi4c_getMasterNumberOfAcceptedSteps(fmi4cMaster *master);
+FMI4C_DLLAPI size_t fmi4c_getMasterNumberOfRejectedSteps(fmi4cMaster *master);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FMIC_MASTER_H
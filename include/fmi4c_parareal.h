@@ -0,0 +1,67 @@
+#ifndef FMIC_PARAREAL_H
+#define FMIC_PARAREAL_H
+
+#include "fmi4c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Parallel-in-time (Parareal) execution of one co-simulation FMU
+//
+// The simulation interval is split into time slices. A coarse propagator (large communication
+// steps) is run serially over all slices, and fine propagators (the requested communication step)
+// are run over the slices in parallel, each starting from the current estimate of the state at the
+// start of its slice. The estimates are then corrected serially,
+//
+//     U[n+1] = G(U[n]) + F(U_old[n]) - G(U_old[n])
+//
+// and the process is repeated until no state changes by more than the tolerance. Slices whose start
+// state did not change are not recomputed, so the number of fine propagations decreases with every
+// iteration. After at most one iteration per slice the result equals serial fine stepping.
+//
+// All instances must be of the same FMU, be initialized by the caller, support getting, setting and
+// serializing the FMU state, and remain owned by the caller. The first instance is the coarse
+// propagator and provides the initial state; it is left in the final state at the stop time. Every
+// further instance is a fine propagator with its own worker thread. FMU states are moved between
+// instances in serialized form.
+//
+// Corrections are applied to the real-valued state variables given with
+// fmi4c_setPararealStateVariables, which are set on the FMU after restoring its state. They must be
+// settable during stepping and fully determine the continuous state of the FMU, so the method is
+// mainly useful for FMUs that expose their states this way.
+//
+// Time-varying inputs are set by an optional callback before every communication step. It receives
+// the fmi2InstanceHandle or fmi3InstanceHandle that is about to step and is called from several
+// threads concurrently.
+
+typedef struct fmi4cParareal fmi4cParareal;
+
+typedef void (*fmi4cPararealInputCallback)(void *instance, double time, void *userData);
+
+FMI4C_DLLAPI fmi4cParareal *fmi4c_createParareal(void);
+FMI4C_DLLAPI void fmi4c_freeParareal(fmi4cParareal *parareal);
+
+FMI4C_DLLAPI bool fmi4c_addPararealInstanceFmi2(fmi4cParareal *parareal, fmi2InstanceHandle *instance);
+FMI4C_DLLAPI bool fmi4c_addPararealInstanceFmi3(fmi4cParareal *parareal, fmi3InstanceHandle *instance);
+FMI4C_DLLAPI bool fmi4c_setPararealStateVariables(fmi4cParareal *parareal, const unsigned int *valueReferences, size_t nValueReferences);
+FMI4C_DLLAPI void fmi4c_setPararealInputCallback(fmi4cParareal *parareal, fmi4cPararealInputCallback callback, void *userData);
+FMI4C_DLLAPI void fmi4c_setPararealTimeSlices(fmi4cParareal *parareal, int nSlices);
+FMI4C_DLLAPI void fmi4c_setPararealStepSizes(fmi4cParareal *parareal, double coarseStepSize, double fineStepSize);
+FMI4C_DLLAPI void fmi4c_setPararealTolerance(fmi4cParareal *parareal, double relativeTolerance, double absoluteTolerance);
+FMI4C_DLLAPI void fmi4c_setPararealMaxIterations(fmi4cParareal *parareal, int maxIterations);
+FMI4C_DLLAPI void fmi4c_setPararealThreads(fmi4cParareal *parareal, bool pinThreads);
+
+FMI4C_DLLAPI bool fmi4c_runParareal(fmi4cParareal *parareal, double startTime, double stopTime);
+
+FMI4C_DLLAPI int fmi4c_getPararealNumberOfIterations(fmi4cParareal *parareal);
+FMI4C_DLLAPI size_t fmi4c_getPararealNumberOfFinePropagations(fmi4cParareal *parareal);
+FMI4C_DLLAPI bool fmi4c_getPararealConverged(fmi4cParareal *parareal);
+FMI4C_DLLAPI double fmi4c_getPararealSliceTime(fmi4cParareal *parareal, int boundary);
+FMI4C_DLLAPI bool fmi4c_getPararealStateValues(fmi4cParareal *parareal, int boundary, double *values);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FMIC_PARAREAL_H
@@ -0,0 +1,36 @@
+#ifndef FMIC_REMOTE_H
+#define FMIC_REMOTE_H
+
+#include "fmi4c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Out-of-process FMU instances (Linux only)
+//
+// When a host executable is set for an FMU, every co-simulation instance created from it is run in
+// a separate host process instead of loading the FMU binary into the calling process. Each instance
+// gets its own host process, so a crashing FMU does not take down the application (calls return
+// fmi2Fatal/fmi3Fatal instead), and FMUs that can only be instantiated once per process can be
+// instantiated any number of times.
+//
+// Calls are forwarded through a shared memory channel signalled with futexes. Value references and
+// values are written directly to the shared memory and the host passes pointers into it on to the
+// FMU, so no data is copied apart from one copy into or out of the caller's arrays.
+//
+// The host executable (fmi4chost) only calls fmi4c_serveRemoteInstance. Supported functions are
+// instantiate, freeInstance, setupExperiment (FMI 2), initialization, terminate, reset, get/set of
+// Real/Integer/Boolean (FMI 2) and Float64/Int32/Boolean (FMI 3), doStep, get/set/free FMU state
+// and, for FMI 2, getRealStatus and getBooleanStatus. Other functions are not available for remote
+// instances. Callbacks are not forwarded: the host prints log messages to stderr and intermediate
+// updates are not supported.
+
+FMI4C_DLLAPI bool fmi4c_setFmuHostExecutable(fmuHandle *fmu, const char *hostExecutable);
+FMI4C_DLLAPI int fmi4c_serveRemoteInstance(int fd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FMIC_REMOTE_H
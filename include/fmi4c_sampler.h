@@ -0,0 +1,54 @@
+#ifndef FMIC_SAMPLER_H
+#define FMIC_SAMPLER_H
+
+#include "fmi4c.h"
+#include "fmi4c_writer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Result sampler, which selects the rows passed to a result writer
+//
+// The simulation passes every sample (e.g. every step) to the sampler, which records a row when:
+// - the time reaches the next multiple of the output interval (every sample if the interval is zero)
+// - a channel with a deadband has changed by more than the deadband since the last recorded row
+//   (a deadband of zero records every change, and an infinite interval only records changes)
+// - the sample is the last one before an event, or the first one after it
+// - it is the first sample, or the last one when the sampler is flushed
+//
+// Channels with aggregation get three additional columns, "min(name)", "max(name)" and
+// "mean(name)", over all samples since the previous row (including it). The mean is time-weighted
+// with the trapezoidal rule, so that it does not depend on the step sizes.
+// Samples must be passed from one thread, in order of time.
+
+typedef struct fmi4cResultSampler fmi4cResultSampler;
+
+typedef struct {
+    size_t numberOfSamples;     // Samples passed to the sampler
+    size_t numberOfRows;        // Rows recorded
+    size_t numberOfGridRows;    // Rows recorded at points of the output grid
+    size_t numberOfChangeRows;  // Rows recorded because a channel changed by more than its deadband
+    size_t numberOfEventRows;   // Rows recorded before and after events
+} fmi4cResultSamplerStatistics;
+
+FMI4C_DLLAPI fmi4cResultSampler *fmi4c_createResultSampler(size_t nChannels, const char **names);
+FMI4C_DLLAPI void fmi4c_freeResultSampler(fmi4cResultSampler *sampler);
+
+FMI4C_DLLAPI void fmi4c_setResultSamplingInterval(fmi4cResultSampler *sampler, double interval);
+FMI4C_DLLAPI bool fmi4c_setResultChannelDeadband(fmi4cResultSampler *sampler, size_t channel, double deadband);
+FMI4C_DLLAPI bool fmi4c_setResultChannelAggregation(fmi4cResultSampler *sampler, size_t channel, bool aggregate);
+
+FMI4C_DLLAPI size_t fmi4c_getResultSamplerNumberOfColumns(fmi4cResultSampler *sampler);
+FMI4C_DLLAPI const char **fmi4c_getResultSamplerColumnNames(fmi4cResultSampler *sampler);
+FMI4C_DLLAPI bool fmi4c_setResultSamplerWriter(fmi4cResultSampler *sampler, fmi4cResultWriter *writer);
+
+FMI4C_DLLAPI bool fmi4c_sampleResult(fmi4cResultSampler *sampler, double time, const double *values, bool event);
+FMI4C_DLLAPI bool fmi4c_flushResultSampler(fmi4cResultSampler *sampler);
+FMI4C_DLLAPI void fmi4c_getResultSamplerStatistics(fmi4cResultSampler *sampler, fmi4cResultSamplerStatistics *statistics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FMIC_SAMPLER_H
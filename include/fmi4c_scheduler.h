@@ -0,0 +1,61 @@
+#ifndef FMIC_SCHEDULER_H
+#define FMIC_SCHEDULER_H
+
+#include "fmi4c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Scheduled execution runtime for FMI 3 FMUs
+//
+// The scheduler instantiates an FMU for scheduled execution and activates its model partitions
+// from the input clocks in the model description:
+// - Clocks with constant, fixed, calculated or tunable interval variability are periodic, with the
+//   interval and shift from the model description (or from the FMU, when it provides one after
+//   initialization).
+// - Countdown and changing clocks are activated when the FMU reports a new interval through the
+//   clock update callback.
+// - Triggered clocks are activated by the application with fmi4c_triggerSchedulerClock.
+//
+// Each clock priority gets its own worker thread. Lower priority values mean higher priority,
+// as in FMI. In real-time mode, activations are released at wall-clock times and the workers run
+// with matching SCHED_FIFO priorities (when permitted), so that the operating system preempts
+// lower priority partitions. Otherwise, time advances as fast as possible and activations at the
+// same time instant are executed in priority order, which makes runs deterministic.
+//
+// fmi4c_runScheduler activates the partitions due in [startTime, stopTime). Consecutive calls continue
+// the clock schedule, so the application can advance in steps and set inputs between them.
+//
+// An activation that has not finished when the next activation of the same periodic clock is due
+// counts as a deadline miss, and that activation is skipped. Response times are measured in wall
+// clock time in both modes. In real-time mode, an activation that takes longer than the clock
+// interval also counts as a deadline miss. In simulated time this is not a miss, since the schedule
+// does not advance with the wall clock.
+
+typedef struct fmi4cScheduler fmi4cScheduler;
+
+FMI4C_DLLAPI fmi4cScheduler *fmi4c_createScheduler(fmuHandle *fmu,
+                                                   fmi3Boolean visible,
+                                                   fmi3Boolean loggingOn,
+                                                   fmi3InstanceEnvironment instanceEnvironment,
+                                                   fmi3LogMessageCallback logMessage,
+                                                   bool realTime);
+FMI4C_DLLAPI void fmi4c_freeScheduler(fmi4cScheduler *scheduler);
+FMI4C_DLLAPI fmi3InstanceHandle *fmi4c_getSchedulerInstance(fmi4cScheduler *scheduler);
+
+FMI4C_DLLAPI bool fmi4c_runScheduler(fmi4cScheduler *scheduler, double startTime, double stopTime);
+FMI4C_DLLAPI void fmi4c_stopScheduler(fmi4cScheduler *scheduler);
+FMI4C_DLLAPI bool fmi4c_triggerSchedulerClock(fmi4cScheduler *scheduler, fmi3ValueReference clockReference);
+
+FMI4C_DLLAPI int fmi4c_getSchedulerNumberOfClocks(fmi4cScheduler *scheduler);
+FMI4C_DLLAPI fmi3ValueReference fmi4c_getSchedulerClockValueReference(fmi4cScheduler *scheduler, int i);
+FMI4C_DLLAPI size_t fmi4c_getSchedulerNumberOfActivations(fmi4cScheduler *scheduler, fmi3ValueReference clockReference);
+FMI4C_DLLAPI size_t fmi4c_getSchedulerNumberOfDeadlineMisses(fmi4cScheduler *scheduler, fmi3ValueReference clockReference);
+FMI4C_DLLAPI double fmi4c_getSchedulerMaxResponseTime(fmi4cScheduler *scheduler, fmi3ValueReference clockReference);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FMIC_SCHEDULER_H
@@ -0,0 +1,50 @@
+#ifndef FMIC_SIMULATION_H
+#define FMIC_SIMULATION_H
+
+#include "fmi4c.h"
+#include "fmi4c_solver.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Whole simulations in one call, mainly for Python and other callers through foreign function interfaces
+//
+// Runs the complete co-simulation or model exchange loop of one instance over a time grid, without
+// returning to the caller in between, so that the call overhead of the calling language is paid once
+// per simulation instead of several times per step. Everything is passed as flat arrays.
+//
+// The instance must be initialized (initialization mode exited) at the first time of the grid, and
+// remains owned by the caller, who terminates and frees it. Co-simulation instances take one
+// communication step per grid interval. Model exchange instances are integrated with the built-in
+// solver, which also performs the initial event iteration. Fixed step methods take one step per grid
+// interval, adaptive methods use the default tolerance of the FMU (if defined).
+//
+// Inputs are given as a table with nInputTimes rows of increasing times, each row containing the
+// values of all nInputs inputs (row-major). They are interpolated linearly, held constant before the
+// first and after the last row, and with several rows at the same time the last one applies from that
+// time. Inputs are set at the start of every communication step, or before every solver call. FMI 2
+// co-simulation FMUs that can interpolate inputs also get the slopes of the table.
+//
+// Outputs are real-valued variables, which are read at every grid time into one row of the results
+// array (nTimes rows of nOutputs values, row-major), starting with the values after initialization.
+// If the FMU terminates the simulation early, the remaining rows are NAN.
+// No data is shared between calls, so different instances can be simulated concurrently on different
+// threads.
+
+FMI4C_DLLAPI bool fmi4c_simulateFmi2(fmi2InstanceHandle *instance, fmi2Type type, fmi4cSolverMethod solverMethod,
+                                     const double *times, size_t nTimes,
+                                     const fmi2ValueReference *inputRefs, size_t nInputs,
+                                     const double *inputTimes, const double *inputValues, size_t nInputTimes,
+                                     const fmi2ValueReference *outputRefs, size_t nOutputs, double *results);
+FMI4C_DLLAPI bool fmi4c_simulateFmi3(fmi3InstanceHandle *instance, fmi3Type type, fmi4cSolverMethod solverMethod,
+                                     const double *times, size_t nTimes,
+                                     const fmi3ValueReference *inputRefs, size_t nInputs,
+                                     const double *inputTimes, const double *inputValues, size_t nInputTimes,
+                                     const fmi3ValueReference *outputRefs, size_t nOutputs, double *results);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FMIC_SIMULATION_H
@@ -0,0 +1,71 @@
+#ifndef FMIC_SOLVER_H
+#define FMIC_SOLVER_H
+
+#include "fmi4c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ODE integrators for model exchange FMUs
+//
+// The solver drives the continuous states of an instance that is in continuous-time mode. All work
+// vectors are allocated when the solver is created, no memory is allocated while integrating.
+// Each accepted step is reported to the FMU with completedIntegratorStep. If the FMU requests event
+// mode (or termination) the solver stops at the end of that step and returns to the caller, which
+// must handle the event and then call fmi4c_initializeSolver() again before continuing. State events
+// (zero crossings of event indicators) are located within the step, and time events reported by
+// fmi4c_handleSolverEvent() are stepped to exactly, so large steps can be taken between events.
+
+typedef struct fmi4cSolver fmi4cSolver;
+
+typedef enum {
+    fmi4cSolverEuler,           // Forward Euler, fixed step
+    fmi4cSolverRungeKutta4,     // Classic fourth order Runge-Kutta, fixed step
+    fmi4cSolverDormandPrince,   // Dormand-Prince 5(4), adaptive step with continuous extension
+    fmi4cSolverCashKarp,        // Cash-Karp 5(4), adaptive step with Hermite interpolation
+    fmi4cSolverCVode            // CVODE BDF with Newton iteration, for stiff models (requires FMI4C_WITH_CVODE)
+} fmi4cSolverMethod;
+
+typedef enum {
+    fmi4cSolverOK,
+    fmi4cSolverEnterEventMode,  // State event, time event or step event at the current solver time
+    fmi4cSolverTerminate,       // FMU requested termination
+    fmi4cSolverError
+} fmi4cSolverStatus;
+
+typedef struct {
+    size_t nSteps;
+    size_t nRejectedSteps;
+    size_t nDerivativeEvaluations;
+    size_t nJacobianEvaluations;
+    size_t nStateEvents;
+} fmi4cSolverStatistics;
+
+FMI4C_DLLAPI fmi4cSolver *fmi4c_createSolverFmi2(fmi2InstanceHandle *instance, size_t nStates, fmi4cSolverMethod method);
+FMI4C_DLLAPI fmi4cSolver *fmi4c_createSolverFmi3(fmi3InstanceHandle *instance, size_t nStates, fmi4cSolverMethod method);
+FMI4C_DLLAPI void fmi4c_freeSolver(fmi4cSolver *solver);
+
+FMI4C_DLLAPI bool fmi4c_getSolverMethodByName(const char *name, fmi4cSolverMethod *method);
+FMI4C_DLLAPI const char *fmi4c_getSolverMethodName(fmi4cSolverMethod method);
+
+FMI4C_DLLAPI void fmi4c_setSolverTolerance(fmi4cSolver *solver, double relativeTolerance, double absoluteTolerance);
+FMI4C_DLLAPI void fmi4c_setSolverStepSize(fmi4cSolver *solver, double stepSize, double minStepSize, double maxStepSize);
+FMI4C_DLLAPI void fmi4c_setSolverStopTime(fmi4cSolver *solver, double stopTime);
+FMI4C_DLLAPI void fmi4c_setSolverDenseOutput(fmi4cSolver *solver, bool denseOutput);
+FMI4C_DLLAPI bool fmi4c_setSolverNumberOfEventIndicators(fmi4cSolver *solver, size_t nEventIndicators);
+
+FMI4C_DLLAPI bool fmi4c_initializeSolver(fmi4cSolver *solver, double time);
+FMI4C_DLLAPI fmi4cSolverStatus fmi4c_handleSolverEvent(fmi4cSolver *solver, double time);
+FMI4C_DLLAPI fmi4cSolverStatus fmi4c_integrateSolver(fmi4cSolver *solver, double nextTime);
+FMI4C_DLLAPI bool fmi4c_getSolverDenseOutput(fmi4cSolver *solver, double time, double states[]);
+
+FMI4C_DLLAPI double fmi4c_getSolverTime(fmi4cSolver *solver);
+FMI4C_DLLAPI const double *fmi4c_getSolverStates(fmi4cSolver *solver);
+FMI4C_DLLAPI void fmi4c_getSolverStatistics(fmi4cSolver *solver, fmi4cSolverStatistics *statistics);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FMIC_SOLVER_H
@@ -0,0 +1,41 @@
+#ifndef FMIC_TLM_H
+#define FMIC_TLM_H
+
+#include "fmi4c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Transmission line (TLM) coupling between two subsystems
+//
+// A TLM connection models a lossless transmission line with characteristic impedance Zc and time
+// delay T between side 0 and side 1. Each side publishes its velocity as it advances, which is
+// turned into a wave travelling to the other side:
+//
+//   c_i(t) = w_j(t-T),   w_i(t) = 2*Zc*v_i(t) + c_i(t),   F_i(t) = Zc*v_i(t) + c_i(t)
+//
+// Each direction is a lock-free single producer, single consumer ring of (time, wave) samples, so
+// the two sides can be stepped concurrently on different threads (typically from intermediate update
+// callbacks). Lookups use a moving cursor and are O(1) amortized for increasing times. A side that
+// needs a wave the other side has not produced yet spins briefly and then blocks until it arrives.
+// Published times must be strictly increasing on each side, other samples are ignored.
+
+typedef struct fmi4cTlmConnection fmi4cTlmConnection;
+
+FMI4C_DLLAPI fmi4cTlmConnection *fmi4c_createTlmConnection(double characteristicImpedance, double timeDelay, double startTime, size_t bufferSize);
+FMI4C_DLLAPI void fmi4c_freeTlmConnection(fmi4cTlmConnection *connection);
+FMI4C_DLLAPI void fmi4c_closeTlmConnection(fmi4cTlmConnection *connection);
+
+FMI4C_DLLAPI double fmi4c_getTlmWave(fmi4cTlmConnection *connection, int side, double time);
+FMI4C_DLLAPI double fmi4c_getTlmForce(fmi4cTlmConnection *connection, int side, double time, double velocity);
+FMI4C_DLLAPI bool fmi4c_publishTlmVelocity(fmi4cTlmConnection *connection, int side, double time, double velocity);
+
+FMI4C_DLLAPI double fmi4c_getTlmCharacteristicImpedance(fmi4cTlmConnection *connection);
+FMI4C_DLLAPI double fmi4c_getTlmTimeDelay(fmi4cTlmConnection *connection);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FMIC_TLM_H
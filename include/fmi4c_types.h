@@ -4,4 +4,11 @@
 // Types
 typedef enum { fmiVersionUnknown, fmiVersion1, fmiVersion2, fmiVersion3 } fmiVersion_t;
 
+// How the FMU binary is loaded for each FMI 2 or FMI 3 instance
+typedef enum {
+    fmi4cIsolationNone,         // All instances share the binary (default)
+    fmi4cIsolationNamespace,    // Each instance loads the binary into a new link-map namespace (dlmopen)
+    fmi4cIsolationCopy          // Each instance loads its own temporary copy of the binary
+} fmi4cBinaryIsolation;
+
 #endif // FMIC_TYPES_H
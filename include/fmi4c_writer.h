@@ -0,0 +1,59 @@
+#ifndef FMIC_WRITER_H
+#define FMIC_WRITER_H
+
+#include "fmi4c.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Result writer for simulation results
+//
+// Rows of a time value and one value per variable are collected in blocks of about one megabyte
+// and written with one sequential write per block. The binary formats store all doubles losslessly.
+//
+// MATLAB level 4 MAT-files contain two matrices, as Modelica result files: "names" (a character
+// matrix with one name per column, the first is "time") and "data" (one row per variable and one
+// column per time point, so that rows can be appended). Load them with e.g. scipy.io.loadmat and
+// transpose data to get one column per variable. The number of time points is written when the
+// writer is closed. The compressed variant is a gzip file which decompresses to the same MAT-file
+// (requires fmi4c built with FMI4C_WITH_ZLIB).
+//
+// CSV files have a header row with the variable names and one row per time point. Values are
+// written with the shortest digits that read back to the same double, independent of the C locale.
+//
+// In asynchronous mode, full blocks are formatted, compressed and written by a background thread
+// while the simulation fills the next block. The simulation only waits (a stall) when all blocks
+// within the memory budget are waiting to be written. Closing the writer always writes all rows.
+
+typedef enum {
+    fmi4cResultCsv,
+    fmi4cResultMat4,
+    fmi4cResultMat4Compressed
+} fmi4cResultFormat;
+
+typedef struct fmi4cResultWriter fmi4cResultWriter;
+
+typedef struct {
+    size_t numberOfBlocks;      // Blocks written
+    size_t numberOfStalls;      // Times the simulation waited for a free block
+    double stallTime;           // Total time waited for free blocks, in seconds
+    size_t maxQueuedBlocks;     // Maximum number of blocks waiting to be written
+    double writeTime;           // Total time spent formatting, compressing and writing blocks, in seconds
+    size_t bufferBytes;         // Memory used for buffered rows
+} fmi4cResultWriterStatistics;
+
+FMI4C_DLLAPI fmi4cResultFormat fmi4c_getResultFormatFromFileName(const char *path);
+
+FMI4C_DLLAPI fmi4cResultWriter *fmi4c_createResultWriter(const char *path, fmi4cResultFormat format, size_t nVariables, const char **names);
+FMI4C_DLLAPI bool fmi4c_setResultWriterAsynchronous(fmi4cResultWriter *writer, size_t memoryBudget);
+FMI4C_DLLAPI bool fmi4c_writeResult(fmi4cResultWriter *writer, double time, const double *values);
+FMI4C_DLLAPI size_t fmi4c_getResultNumberOfRows(fmi4cResultWriter *writer);
+FMI4C_DLLAPI void fmi4c_getResultWriterStatistics(fmi4cResultWriter *writer, fmi4cResultWriterStatistics *statistics);
+FMI4C_DLLAPI bool fmi4c_closeResultWriter(fmi4cResultWriter *writer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FMIC_WRITER_H
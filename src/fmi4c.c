@@ -1,3 +1,6 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE     // For dlmopen
+#endif
 #include "fmi4c_private.h"
 #define FMI4C_H_INTERNAL_INCLUDE
 #include "fmi4c.h"
@@ -20,6 +23,7 @@
 #ifndef _WIN32
 #include "fmi4c_common.h"
 #include <dlfcn.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <sys/stat.h>
 #endif
@@ -72,6 +76,91 @@ void *loadDllFunction(void *dll, const char *name, bool *ok) {
 }
 #endif
 
+#ifndef _WIN32
+//! @brief Loads a private copy of a shared object, so that it gets its own global data
+//! The copy is placed next to the original, so that dependencies found relative to it ($ORIGIN) are
+//! still found. It is removed as soon as it is loaded.
+static void *openCopyOfSharedObject(const char *dllPath)
+{
+    char copyPath[FILENAME_MAX];
+    snprintf(copyPath, sizeof(copyPath), "%s.fmi4c_XXXXXX", dllPath);
+    int source = open(dllPath, O_RDONLY);
+    if(source < 0) {
+        return NULL;
+    }
+    int target = mkstemp(copyPath);
+    if(target < 0) {
+        close(source);
+        return NULL;
+    }
+    char buffer[65536];
+    ssize_t n;
+    bool ok = true;
+    while(ok && (n = read(source, buffer, sizeof(buffer))) > 0) {
+        ok = (write(target, buffer, (size_t)n) == n);
+    }
+    close(source);
+    close(target);
+    void *dll = ok ? dlopen(copyPath, RTLD_NOW | RTLD_LOCAL) : NULL;
+    unlink(copyPath);
+    return dll;
+}
+
+//! @brief Loads the shared object of an FMU, according to the binary isolation of the FMU handle
+static void *openSharedObject(fmuHandle *fmu, const char *dllPath)
+{
+    if(fmu->isolation == fmi4cIsolationNone) {
+        return dlopen(dllPath, RTLD_NOW | RTLD_LOCAL);
+    }
+#ifdef LM_ID_NEWLM
+    if(fmu->isolation == fmi4cIsolationNamespace) {
+        void *dll = dlmopen(LM_ID_NEWLM, dllPath, RTLD_NOW | RTLD_LOCAL);
+        if(dll != NULL) {
+            return dll;
+        }
+        // The number of namespaces is limited (16 in glibc), use a copy when they run out
+        fmi4c_printMessage("No link-map namespace available, loading a copy of the FMU binary instead");
+    }
+#endif
+    return openCopyOfSharedObject(dllPath);
+}
+#endif
+
+//! @brief Returns the FMU handle to load the functions of a new instance into
+//! With binary isolation or out-of-process instances, each instance gets its own shallow copy of the
+//! FMU handle, with its own library handle and function pointers. The model description data is shared
+//! with the original.
+static fmuHandle *fmuHandleForInstance(fmuHandle *fmu)
+{
+    if(fmu->isolation == fmi4cIsolationNone && fmu->hostExecutable == NULL) {
+        return fmu;
+    }
+    fmuHandle *copy = malloc(sizeof(fmuHandle));
+    if(copy == NULL) {
+        return NULL;
+    }
+    memcpy(copy, fmu, sizeof(fmuHandle));
+    copy->dll = NULL;
+    copy->parent = fmu;
+    return copy;
+}
+
+//! @brief Unloads and frees a per-instance copy of an FMU handle, does nothing for shared handles
+static void freeFmuHandleForInstance(fmuHandle *fmu)
+{
+    if(fmu->parent == NULL) {
+        return;
+    }
+    if(fmu->dll != NULL) {
+#ifdef _WIN32
+        FreeLibrary(fmu->dll);
+#else
+        dlclose(fmu->dll);
+#endif
+    }
+    free(fmu);
+}
+
 void (*msgFunc)(const char*) = NULL;
 
 void fmi4c_setMessageFunction(void (*func)(const char*))
@@ -1537,7 +1626,6 @@ bool parseModelDescriptionFmi3(fmuHandle *fmu)
                 }
 
                 freeDuplicatedConstChar(mutable_clocks);
-                freeDuplicatedConstChar(clocks);
             }
 
             var.hasStartValue = false;
@@ -1676,9 +1764,6 @@ bool parseModelDescriptionFmi3(fmuHandle *fmu)
                 }
                 else {
                     printf("Unknown causality: %s\n", causality);
-                    if(var.numberOfClocks > 0) {
-                        free(var.clocks);
-                    }
                     freeDuplicatedConstChar(causality);
                     return false;
                 }
@@ -1814,6 +1899,22 @@ bool parseModelDescriptionFmi3(fmuHandle *fmu)
             }
 
             if(var.datatype == fmi3DataTypeClock) {
+                //Defaults from the declared clock type, if any, overridden by attributes of the variable
+                var.canBeDeactivated = false;
+                var.priority = 0;
+                var.intervalVariability = fmi3IntervalVariabilityTriggered;
+                var.intervalDecimal = 0;
+                var.shiftDecimal = 0;
+                for(size_t i=0; var.declaredType != NULL && i<fmu->fmi3.numberOfClockTypes; ++i) {
+                    fmi3ClockType *type = &fmu->fmi3.clockTypes[i];
+                    if(!strcmp(type->name, var.declaredType)) {
+                        var.canBeDeactivated = type->canBeDeactivated;
+                        var.priority = (int)type->priority;
+                        var.intervalVariability = type->intervalVariability;
+                        var.intervalDecimal = type->intervalDecimal;
+                        var.shiftDecimal = type->shiftDecimal;
+                    }
+                }
                 parseBooleanAttributeEzXml(varElement, "canBeDeactivated", &var.canBeDeactivated);
                 parseInt32AttributeEzXml(varElement, "priority", &var.priority);
                 parseFloat64AttributeEzXml(varElement, "intervalDecimal", &var.intervalDecimal);
@@ -1823,7 +1924,7 @@ bool parseModelDescriptionFmi3(fmuHandle *fmu)
                 parseInt64AttributeEzXml(varElement, "intervalCounter", &var.intervalCounter);
                 parseInt64AttributeEzXml(varElement, "shiftCounter", &var.shiftCounter);
                 const char* intervalVariability = NULL;
-                parseStringAttributeEzXmlAndRememberPointer(varElement, "intervalVariability", &intervalVariability, fmu);
+                parseStringAttributeEzXml(varElement, "intervalVariability", &intervalVariability);
                 if(intervalVariability && !strcmp(intervalVariability, "calculated")) {
                     var.intervalVariability = fmi3IntervalVariabilityCalculated;
                 }
@@ -1862,9 +1963,6 @@ bool parseModelDescriptionFmi3(fmuHandle *fmu)
 
             fmu->fmi3.variables[fmu->fmi3.numberOfVariables] = var;
             fmu->fmi3.numberOfVariables++;
-            if(var.numberOfClocks > 0) {
-                free(var.clocks);
-            }
         }
     }
 
@@ -2169,7 +2267,7 @@ bool loadFunctionsFmi2(fmuHandle *fmu, fmi2Type fmuType)
     strcat(cmd, dllPath);
     system(cmd);
 
-    void *dll = dlopen(dllPath, RTLD_NOW | RTLD_LOCAL);
+    void *dll = openSharedObject(fmu, dllPath);
     if (NULL == dll) {
         printf("Loading shared object failed: %s (%s)\n", dllPath, dlerror());
         return false;
@@ -2313,7 +2411,7 @@ bool loadFunctionsFmi3(fmuHandle *fmu, fmi3Type fmuType)
     strcat(cmd, dllPath);
     system(cmd);
 
-    void *dll = dlopen(dllPath, RTLD_NOW | RTLD_LOCAL);
+    void *dll = openSharedObject(fmu, dllPath);
     if (NULL == dll) {
         printf("Loading shared object fejlade: %s (%s)\n", dllPath, dlerror());
         return false;
@@ -2460,8 +2558,29 @@ fmi3InstanceHandle *fmi3_instantiateCoSimulation(fmuHandle *fmu,
                                                  fmi3LogMessageCallback         logMessage,
                                                  fmi3IntermediateUpdateCallback intermediateUpdate)
 {
+    fmu = fmuHandleForInstance(fmu);
+    if(fmu == NULL) {
+        return NULL;
+    }
+    if(fmu->hostExecutable != NULL) {
+        fmi3Component *comp = fmi4c_instantiateRemoteFmi3(fmu, visible, loggingOn, eventModeUsed, earlyReturnAllowed);
+        if(comp == NULL) {
+            freeFmuHandleForInstance(fmu);
+            return NULL;
+        }
+        fmi3InstanceHandle *handle = calloc(1, sizeof(fmi3InstanceHandle));
+        if(handle == NULL) {
+            fmu->fmi3.freeInstance(comp);
+            freeFmuHandleForInstance(fmu);
+            return NULL;
+        }
+        handle->component = comp;
+        handle->fmu = (struct fmuHandle*)fmu;
+        return handle;
+    }
     if(!loadFunctionsFmi3(fmu, fmi3CoSimulation)) {
         printf("Failed to load functions for FMI 3 CS.");
+        freeFmuHandleForInstance(fmu);
         return false;
     }
 
@@ -2491,8 +2610,13 @@ fmi3InstanceHandle *fmi3_instantiateModelExchange(fmuHandle *fmu,
                                                   fmi3InstanceEnvironment    instanceEnvironment,
                                                   fmi3LogMessageCallback     logMessage)
 {
+    fmu = fmuHandleForInstance(fmu);
+    if(fmu == NULL) {
+        return NULL;
+    }
     if(!loadFunctionsFmi3(fmu, fmi3ModelExchange)) {
         printf("Failed to load functions for FMI 3 ME.");
+        freeFmuHandleForInstance(fmu);
         return false;
     }
 
@@ -2512,6 +2636,56 @@ fmi3InstanceHandle *fmi3_instantiateModelExchange(fmuHandle *fmu,
     return handle;
 }
 
+fmi3InstanceHandle *fmi3_instantiateScheduledExecution(fmuHandle *fmu,
+                                                       fmi3Boolean                  visible,
+                                                       fmi3Boolean                  loggingOn,
+                                                       fmi3InstanceEnvironment      instanceEnvironment,
+                                                       fmi3LogMessageCallback       logMessage,
+                                                       fmi3ClockUpdateCallback      clockUpdate,
+                                                       fmi3CallbackLockPreemption   lockPreemption,
+                                                       fmi3CallbackUnlockPreemption unlockPreemption)
+{
+    if(!fmu->fmi3.supportsScheduledExecution) {
+        fmi4c_printMessage("Scheduled execution is not supported by this FMU.");
+        return NULL;
+    }
+    if(fmu->hostExecutable != NULL) {
+        fmi4c_printMessage("Scheduled execution is not supported for out-of-process instances.");
+        return NULL;
+    }
+
+    fmu = fmuHandleForInstance(fmu);
+    if(fmu == NULL) {
+        return NULL;
+    }
+    if(!loadFunctionsFmi3(fmu, fmi3ScheduledExecution)) {
+        printf("Failed to load functions for FMI 3 SE.");
+        freeFmuHandleForInstance(fmu);
+        return NULL;
+    }
+
+    fmi3Component *comp = fmu->fmi3.instantiateScheduledExecution(fmu->instanceName,
+                                                                  fmu->fmi3.instantiationToken,
+                                                                  fmu->resourcesLocation,
+                                                                  visible,
+                                                                  loggingOn,
+                                                                  instanceEnvironment,
+                                                                  logMessage,
+                                                                  clockUpdate,
+                                                                  lockPreemption,
+                                                                  unlockPreemption);
+    if(comp == NULL) {
+        freeFmuHandleForInstance(fmu);
+        return NULL;
+    }
+
+    fmi3InstanceHandle *handle = calloc(1, sizeof(fmi3InstanceHandle));
+    handle->component = comp;
+    handle->fmu = (struct fmuHandle*)fmu;
+
+    return handle;
+}
+
 const char* fmi3_getVersion(fmuHandle *fmu) {
 
     return fmu->fmi3.getVersion();
@@ -2587,6 +2761,7 @@ void fmi3_freeInstance(fmi3InstanceHandle *instance)
     TRACEFUNC
 
     instance->fmu->fmi3.freeInstance(instance->component);
+    freeFmuHandleForInstance(instance->fmu);
     free(instance);
 }
 
@@ -2731,8 +2906,29 @@ fmi2InstanceHandle *fmi2_instantiate(fmuHandle *fmu, fmi2Type type, fmi2Callback
         return NULL;
     }
 
+    fmu = fmuHandleForInstance(fmu);
+    if(fmu == NULL) {
+        return NULL;
+    }
+    if(fmu->hostExecutable != NULL) {
+        fmi2Component *comp = fmi4c_instantiateRemoteFmi2(fmu, type, visible, loggingOn);
+        if(comp == NULL) {
+            freeFmuHandleForInstance(fmu);
+            return NULL;
+        }
+        fmi2InstanceHandle *handle = calloc(1, sizeof(fmi2InstanceHandle));
+        if(handle == NULL) {
+            fmu->fmi2.freeInstance(comp);
+            freeFmuHandleForInstance(fmu);
+            return NULL;
+        }
+        handle->component = comp;
+        handle->fmu = (struct fmuHandle*)fmu;
+        return handle;
+    }
     if(!loadFunctionsFmi2(fmu, type)) {
         fmi4c_printMessage("Failed to load functions for FMI 2.");
+        freeFmuHandleForInstance(fmu);
         return NULL;
     }
 
@@ -2761,6 +2957,7 @@ void fmi2_freeInstance(fmi2InstanceHandle *instance)
     TRACEFUNC
 
     instance->fmu->fmi2.freeInstance(instance->component);
+    freeFmuHandleForInstance(instance->fmu);
     free(instance);
 }
 
@@ -3034,6 +3231,30 @@ fmi3ValueReference fmi3_getVariableValueReference(fmi3VariableHandle *var)
     return var->valueReference;
 }
 
+int fmi3_getVariablePriority(fmi3VariableHandle *var)
+{
+    TRACEFUNC
+    return var->priority;
+}
+
+fmi3IntervalVariability fmi3_getVariableIntervalVariability(fmi3VariableHandle *var)
+{
+    TRACEFUNC
+    return var->intervalVariability;
+}
+
+double fmi3_getVariableIntervalDecimal(fmi3VariableHandle *var)
+{
+    TRACEFUNC
+    return var->intervalDecimal;
+}
+
+double fmi3_getVariableShiftDecimal(fmi3VariableHandle *var)
+{
+    TRACEFUNC
+    return var->shiftDecimal;
+}
+
 fmi3Status fmi3_enterEventMode(fmi3InstanceHandle *instance)
 {
     return instance->fmu->fmi3.enterEventMode(instance->component);
@@ -4232,6 +4453,11 @@ int fmi2_getModelStructureNumberOfDependencies(fmi2ModelStructureHandle *handle)
     return handle->numberOfDependencies;
 }
 
+bool fmi2_getModelStructureDependenciesDefined(fmi2ModelStructureHandle *handle)
+{
+    return handle->dependenciesDefined;
+}
+
 bool fmi2_getModelStructureDependencyKindsDefined(fmi2ModelStructureHandle *handle)
 {
     return handle->dependencyKindsDefined;
@@ -4609,6 +4835,135 @@ bool unzipFmu(const char* fmufile, const char* instanceName, const char* unzipLo
     return true;
 }
 
+//! @brief Sets all FMI 2 functions to placeholders that report an error when called
+void fmi4c_setPlaceholdersFmi2(fmuHandle *fmu)
+{
+    fmu->fmi2.getTypesPlatform = placeholder_fmi2_getTypesPlatform;
+    fmu->fmi2.getVersion = placeholder_fmi2_getVersion;
+    fmu->fmi2.setDebugLogging = placeholder_fmi2_setDebugLogging;
+    fmu->fmi2.instantiate = placeholder_fmi2Instantiate;
+    fmu->fmi2.freeInstance = placeholder_fmi2FreeInstance;
+    fmu->fmi2.setupExperiment = placeholder_fmi2_setupExperiment;
+    fmu->fmi2.enterInitializationMode = placeholder_fmi2EnterInitializationMode;
+    fmu->fmi2.exitInitializationMode = placeholder_fmi2ExitInitializationMode;
+    fmu->fmi2.terminate = placeholder_fmi2Terminate;
+    fmu->fmi2.reset = placeholder_fmi2Reset;
+    fmu->fmi2.getReal = placeholder_fmi2_getReal;
+    fmu->fmi2.getInteger = placeholder_fmi2_getInteger;
+    fmu->fmi2.getBoolean = placeholder_fmi2_getBoolean;
+    fmu->fmi2.getString = placeholder_fmi2_getString;
+    fmu->fmi2.setReal = placeholder_fmi2_setReal;
+    fmu->fmi2.setInteger = placeholder_fmi2_setInteger;
+    fmu->fmi2.setBoolean = placeholder_fmi2_setBoolean;
+    fmu->fmi2.setString = placeholder_fmi2_setString;
+    fmu->fmi2.getFMUstate = placeholder_fmi2_getFMUstate;
+    fmu->fmi2.setFMUstate = placeholder_fmi2_setFMUstate;
+    fmu->fmi2.freeFMUstate = placeholder_fmi2FreeFMUstate;
+    fmu->fmi2.serializedFMUstateSize = placeholder_fmi2SerializedFMUstateSize;
+    fmu->fmi2.serializeFMUstate = placeholder_fmi2SerializeFMUstate;
+    fmu->fmi2.deSerializeFMUstate = placeholder_fmi2DeSerializeFMUstate;
+    fmu->fmi2.getDirectionalDerivative = placeholder_fmi2_getDirectionalDerivative;
+    fmu->fmi2.enterEventMode = placeholder_fmi2EnterEventMode;
+    fmu->fmi2.newDiscreteStates = placeholder_fmi2NewDiscreteStates;
+    fmu->fmi2.enterContinuousTimeMode = placeholder_fmi2EnterContinuousTimeMode;
+    fmu->fmi2.completedIntegratorStep = placeholder_fmi2CompletedIntegratorStep;
+    fmu->fmi2.setTime = placeholder_fmi2_setTime;
+    fmu->fmi2.setContinuousStates = placeholder_fmi2_setContinuousStates;
+    fmu->fmi2.getDerivatives = placeholder_fmi2_getDerivatives;
+    fmu->fmi2.getEventIndicators = placeholder_fmi2_getEventIndicators;
+    fmu->fmi2.getContinuousStates = placeholder_fmi2_getContinuousStates;
+    fmu->fmi2.getNominalsOfContinuousStates = placeholder_fmi2_getNominalsOfContinuousStates;
+    fmu->fmi2.setRealInputDerivatives = placeholder_fmi2_setRealInputDerivatives;
+    fmu->fmi2.getRealOutputDerivatives = placeholder_fmi2_getRealOutputDerivatives;
+    fmu->fmi2.doStep = placeholder_fmi2DoStep;
+    fmu->fmi2.cancelStep = placeholder_fmi2CancelStep;
+    fmu->fmi2.getStatus = placeholder_fmi2_getStatus;
+    fmu->fmi2.getRealStatus = placeholder_fmi2_getRealStatus;
+    fmu->fmi2.getIntegerStatus = placeholder_fmi2_getIntegerStatus;
+    fmu->fmi2.getBooleanStatus = placeholder_fmi2_getBooleanStatus;
+    fmu->fmi2.getStringStatus = placeholder_fmi2_getStringStatus;
+}
+
+//! @brief Sets all FMI 3 functions to placeholders that report an error when called
+void fmi4c_setPlaceholdersFmi3(fmuHandle *fmu)
+{
+    fmu->fmi3.getVersion = placeholder_fmi3GetVersion;
+    fmu->fmi3.setDebugLogging = placeholder_fmi3SetDebugLogging;
+    fmu->fmi3.instantiateModelExchange = placeholder_fmi3InstantiateModelExchange;
+    fmu->fmi3.instantiateCoSimulation = placeholder_fmi3InstantiateCoSimulation;
+    fmu->fmi3.instantiateScheduledExecution = placeholder_fmi3InstantiateScheduledExecution;
+    fmu->fmi3.freeInstance = placeholder_fmi3FreeInstance;
+    fmu->fmi3.enterInitializationMode = placeholder_fmi3EnterInitializationMode;
+    fmu->fmi3.exitInitializationMode = placeholder_fmi3ExitInitializationMode;
+    fmu->fmi3.terminate = placeholder_fmi3Terminate;
+    fmu->fmi3.setFloat64 = placeholder_fmi3SetFloat64;
+    fmu->fmi3.getFloat64 = placeholder_fmi3GetFloat64;
+    fmu->fmi3.doStep = placeholder_fmi3DoStep;
+    fmu->fmi3.enterEventMode = placeholder_fmi3EnterEventMode;
+    fmu->fmi3.reset = placeholder_fmi3Reset;
+    fmu->fmi3.getFloat32 = placeholder_fmi3GetFloat32;
+    fmu->fmi3.getInt8 = placeholder_fmi3GetInt8;
+    fmu->fmi3.getUInt8 = placeholder_fmi3GetUInt8;
+    fmu->fmi3.getInt16 = placeholder_fmi3GetInt16;
+    fmu->fmi3.getUInt16 = placeholder_fmi3GetUInt16;
+    fmu->fmi3.getInt32 = placeholder_fmi3GetInt32;
+    fmu->fmi3.getUInt32 = placeholder_fmi3GetUInt32;
+    fmu->fmi3.getInt64 = placeholder_fmi3GetInt64;
+    fmu->fmi3.getUInt64 = placeholder_fmi3GetUInt64;
+    fmu->fmi3.getBoolean = placeholder_fmi3GetBoolean;
+    fmu->fmi3.getString = placeholder_fmi3GetString;
+    fmu->fmi3.getBinary = placeholder_fmi3GetBinary;
+    fmu->fmi3.getClock = placeholder_fmi3GetClock;
+    fmu->fmi3.setFloat32 = placeholder_fmi3SetFloat32;
+    fmu->fmi3.setInt8 = placeholder_fmi3SetInt8;
+    fmu->fmi3.setUInt8 = placeholder_fmi3SetUInt8;
+    fmu->fmi3.setInt16 = placeholder_fmi3SetInt16;
+    fmu->fmi3.setUInt16 = placeholder_fmi3SetUInt16;
+    fmu->fmi3.setInt32 = placeholder_fmi3SetInt32;
+    fmu->fmi3.setUInt32 = placeholder_fmi3SetUInt32;
+    fmu->fmi3.setInt64 = placeholder_fmi3SetInt64;
+    fmu->fmi3.setUInt64 = placeholder_fmi3SetUInt64;
+    fmu->fmi3.setBoolean = placeholder_fmi3SetBoolean;
+    fmu->fmi3.setString = placeholder_fmi3SetString;
+    fmu->fmi3.setBinary = placeholder_fmi3SetBinary;
+    fmu->fmi3.setClock = placeholder_fmi3SetClock;
+    fmu->fmi3.getNumberOfVariableDependencies = placeholder_fmi3GetNumberOfVariableDependencies;
+    fmu->fmi3.getVariableDependencies = placeholder_fmi3GetVariableDependencies;
+    fmu->fmi3.getFMUState = placeholder_fmi3GetFMUState;
+    fmu->fmi3.setFMUState = placeholder_fmi3SetFMUState;
+    fmu->fmi3.freeFMUState = placeholder_fmi3FreeFMUState;
+    fmu->fmi3.serializedFMUStateSize = placeholder_fmi3SerializedFMUStateSize;
+    fmu->fmi3.serializeFMUState = placeholder_fmi3SerializeFMUState;
+    fmu->fmi3.deserializeFMUState = placeholder_fmi3DeserializeFMUState;
+    fmu->fmi3.getDirectionalDerivative = placeholder_fmi3GetDirectionalDerivative;
+    fmu->fmi3.getAdjointDerivative = placeholder_fmi3GetAdjointDerivative;
+    fmu->fmi3.enterConfigurationMode = placeholder_fmi3EnterConfigurationMode;
+    fmu->fmi3.exitConfigurationMode = placeholder_fmi3ExitConfigurationMode;
+    fmu->fmi3.getIntervalDecimal = placeholder_fmi3GetIntervalDecimal;
+    fmu->fmi3.getIntervalFraction = placeholder_fmi3GetIntervalFraction;
+    fmu->fmi3.getShiftDecimal = placeholder_fmi3GetShiftDecimal;
+    fmu->fmi3.getShiftFraction = placeholder_fmi3GetShiftFraction;
+    fmu->fmi3.setIntervalDecimal = placeholder_fmi3SetIntervalDecimal;
+    fmu->fmi3.setIntervalFraction = placeholder_fmi3SetIntervalFraction;
+    fmu->fmi3.setShiftDecimal = placeholder_fmi3SetShiftDecimal;
+    fmu->fmi3.setShiftFraction = placeholder_fmi3SetShiftFraction;
+    fmu->fmi3.evaluateDiscreteStates = placeholder_fmi3EvaluateDiscreteStates;
+    fmu->fmi3.updateDiscreteStates = placeholder_fmi3UpdateDiscreteStates;
+    fmu->fmi3.enterContinuousTimeMode = placeholder_fmi3EnterContinuousTimeMode;
+    fmu->fmi3.completedIntegratorStep = placeholder_fmi3CompletedIntegratorStep;
+    fmu->fmi3.setTime = placeholder_fmi3SetTime;
+    fmu->fmi3.setContinuousStates = placeholder_fmi3SetContinuousStates;
+    fmu->fmi3.getContinuousStateDerivatives = placeholder_fmi3GetContinuousStateDerivatives;
+    fmu->fmi3.getEventIndicators = placeholder_fmi3GetEventIndicators;
+    fmu->fmi3.getContinuousStates = placeholder_fmi3GetContinuousStates;
+    fmu->fmi3.getNominalsOfContinuousStates = placeholder_fmi3GetNominalsOfContinuousStates;
+    fmu->fmi3.getNumberOfEventIndicators = placeholder_fmi3GetNumberOfEventIndicators;
+    fmu->fmi3.getNumberOfContinuousStates = placeholder_fmi3GetNumberOfContinuousStates;
+    fmu->fmi3.enterStepMode = placeholder_fmi3EnterStepMode;
+    fmu->fmi3.getOutputDerivatives = placeholder_fmi3GetOutputDerivatives;
+    fmu->fmi3.activateModelPartition = placeholder_fmi3ActivateModelPartition;
+}
+
 fmuHandle *fmi4c_loadUnzippedFmu_internal(const char *instanceName, const char *unzipLocation, bool unzippedLocationIsTemporary)
 {
     fmuHandle *fmu = calloc(1, sizeof(fmuHandle)); // Using calloc to ensure all member pointers (and data) are initialized to NULL (0)
@@ -4731,126 +5086,8 @@ fmuHandle *fmi4c_loadUnzippedFmu_internal(const char *instanceName, const char *
     fmu->fmi1.getStateValueReferences = placeholder_fmiGetStateValueReferences;
     fmu->fmi1.terminate = placeholder_fmiTerminate;
 
-    fmu->fmi2.getTypesPlatform = placeholder_fmi2_getTypesPlatform;
-    fmu->fmi2.getVersion = placeholder_fmi2_getVersion;
-    fmu->fmi2.setDebugLogging = placeholder_fmi2_setDebugLogging;
-    fmu->fmi2.instantiate = placeholder_fmi2Instantiate;
-    fmu->fmi2.freeInstance = placeholder_fmi2FreeInstance;
-    fmu->fmi2.setupExperiment = placeholder_fmi2_setupExperiment;
-    fmu->fmi2.enterInitializationMode = placeholder_fmi2EnterInitializationMode;
-    fmu->fmi2.exitInitializationMode = placeholder_fmi2ExitInitializationMode;
-    fmu->fmi2.terminate = placeholder_fmi2Terminate;
-    fmu->fmi2.reset = placeholder_fmi2Reset;
-    fmu->fmi2.getReal = placeholder_fmi2_getReal;
-    fmu->fmi2.getInteger = placeholder_fmi2_getInteger;
-    fmu->fmi2.getBoolean = placeholder_fmi2_getBoolean;
-    fmu->fmi2.getString = placeholder_fmi2_getString;
-    fmu->fmi2.setReal = placeholder_fmi2_setReal;
-    fmu->fmi2.setInteger = placeholder_fmi2_setInteger;
-    fmu->fmi2.setBoolean = placeholder_fmi2_setBoolean;
-    fmu->fmi2.setString = placeholder_fmi2_setString;
-    fmu->fmi2.getFMUstate = placeholder_fmi2_getFMUstate;
-    fmu->fmi2.setFMUstate = placeholder_fmi2_setFMUstate;
-    fmu->fmi2.freeFMUstate = placeholder_fmi2FreeFMUstate;
-    fmu->fmi2.serializedFMUstateSize = placeholder_fmi2SerializedFMUstateSize;
-    fmu->fmi2.serializeFMUstate = placeholder_fmi2SerializeFMUstate;
-    fmu->fmi2.deSerializeFMUstate = placeholder_fmi2DeSerializeFMUstate;
-    fmu->fmi2.getDirectionalDerivative = placeholder_fmi2_getDirectionalDerivative;
-    fmu->fmi2.enterEventMode = placeholder_fmi2EnterEventMode;
-    fmu->fmi2.newDiscreteStates = placeholder_fmi2NewDiscreteStates;
-    fmu->fmi2.enterContinuousTimeMode = placeholder_fmi2EnterContinuousTimeMode;
-    fmu->fmi2.completedIntegratorStep = placeholder_fmi2CompletedIntegratorStep;
-    fmu->fmi2.setTime = placeholder_fmi2_setTime;
-    fmu->fmi2.setContinuousStates = placeholder_fmi2_setContinuousStates;
-    fmu->fmi2.getDerivatives = placeholder_fmi2_getDerivatives;
-    fmu->fmi2.getEventIndicators = placeholder_fmi2_getEventIndicators;
-    fmu->fmi2.getContinuousStates = placeholder_fmi2_getContinuousStates;
-    fmu->fmi2.getNominalsOfContinuousStates = placeholder_fmi2_getNominalsOfContinuousStates;
-    fmu->fmi2.setRealInputDerivatives = placeholder_fmi2_setRealInputDerivatives;
-    fmu->fmi2.getRealOutputDerivatives = placeholder_fmi2_getRealOutputDerivatives;
-    fmu->fmi2.doStep = placeholder_fmi2DoStep;
-    fmu->fmi2.cancelStep = placeholder_fmi2CancelStep;
-    fmu->fmi2.getStatus = placeholder_fmi2_getStatus;
-    fmu->fmi2.getRealStatus = placeholder_fmi2_getRealStatus;
-    fmu->fmi2.getIntegerStatus = placeholder_fmi2_getIntegerStatus;
-    fmu->fmi2.getBooleanStatus = placeholder_fmi2_getBooleanStatus;
-    fmu->fmi2.getStringStatus = placeholder_fmi2_getStringStatus;
-
-    fmu->fmi3.getVersion = placeholder_fmi3GetVersion;
-    fmu->fmi3.setDebugLogging = placeholder_fmi3SetDebugLogging;
-    fmu->fmi3.instantiateModelExchange = placeholder_fmi3InstantiateModelExchange;
-    fmu->fmi3.instantiateCoSimulation = placeholder_fmi3InstantiateCoSimulation;
-    fmu->fmi3.instantiateScheduledExecution = placeholder_fmi3InstantiateScheduledExecution;
-    fmu->fmi3.freeInstance = placeholder_fmi3FreeInstance;
-    fmu->fmi3.enterInitializationMode = placeholder_fmi3EnterInitializationMode;
-    fmu->fmi3.exitInitializationMode = placeholder_fmi3ExitInitializationMode;
-    fmu->fmi3.terminate = placeholder_fmi3Terminate;
-    fmu->fmi3.setFloat64 = placeholder_fmi3SetFloat64;
-    fmu->fmi3.getFloat64 = placeholder_fmi3GetFloat64;
-    fmu->fmi3.doStep = placeholder_fmi3DoStep;
-    fmu->fmi3.enterEventMode = placeholder_fmi3EnterEventMode;
-    fmu->fmi3.reset = placeholder_fmi3Reset;
-    fmu->fmi3.getFloat32 = placeholder_fmi3GetFloat32;
-    fmu->fmi3.getInt8 = placeholder_fmi3GetInt8;
-    fmu->fmi3.getUInt8 = placeholder_fmi3GetUInt8;
-    fmu->fmi3.getInt16 = placeholder_fmi3GetInt16;
-    fmu->fmi3.getUInt16 = placeholder_fmi3GetUInt16;
-    fmu->fmi3.getInt32 = placeholder_fmi3GetInt32;
-    fmu->fmi3.getUInt32 = placeholder_fmi3GetUInt32;
-    fmu->fmi3.getInt64 = placeholder_fmi3GetInt64;
-    fmu->fmi3.getUInt64 = placeholder_fmi3GetUInt64;
-    fmu->fmi3.getBoolean = placeholder_fmi3GetBoolean;
-    fmu->fmi3.getString = placeholder_fmi3GetString;
-    fmu->fmi3.getBinary = placeholder_fmi3GetBinary;
-    fmu->fmi3.getClock = placeholder_fmi3GetClock;
-    fmu->fmi3.setFloat32 = placeholder_fmi3SetFloat32;
-    fmu->fmi3.setInt8 = placeholder_fmi3SetInt8;
-    fmu->fmi3.setUInt8 = placeholder_fmi3SetUInt8;
-    fmu->fmi3.setInt16 = placeholder_fmi3SetInt16;
-    fmu->fmi3.setUInt16 = placeholder_fmi3SetUInt16;
-    fmu->fmi3.setInt32 = placeholder_fmi3SetInt32;
-    fmu->fmi3.setUInt32 = placeholder_fmi3SetUInt32;
-    fmu->fmi3.setInt64 = placeholder_fmi3SetInt64;
-    fmu->fmi3.setUInt64 = placeholder_fmi3SetUInt64;
-    fmu->fmi3.setBoolean = placeholder_fmi3SetBoolean;
-    fmu->fmi3.setString = placeholder_fmi3SetString;
-    fmu->fmi3.setBinary = placeholder_fmi3SetBinary;
-    fmu->fmi3.setClock = placeholder_fmi3SetClock;
-    fmu->fmi3.getNumberOfVariableDependencies = placeholder_fmi3GetNumberOfVariableDependencies;
-    fmu->fmi3.getVariableDependencies = placeholder_fmi3GetVariableDependencies;
-    fmu->fmi3.getFMUState = placeholder_fmi3GetFMUState;
-    fmu->fmi3.setFMUState = placeholder_fmi3SetFMUState;
-    fmu->fmi3.freeFMUState = placeholder_fmi3FreeFMUState;
-    fmu->fmi3.serializedFMUStateSize = placeholder_fmi3SerializedFMUStateSize;
-    fmu->fmi3.serializeFMUState = placeholder_fmi3SerializeFMUState;
-    fmu->fmi3.deserializeFMUState = placeholder_fmi3DeserializeFMUState;
-    fmu->fmi3.getDirectionalDerivative = placeholder_fmi3GetDirectionalDerivative;
-    fmu->fmi3.getAdjointDerivative = placeholder_fmi3GetAdjointDerivative;
-    fmu->fmi3.enterConfigurationMode = placeholder_fmi3EnterConfigurationMode;
-    fmu->fmi3.exitConfigurationMode = placeholder_fmi3ExitConfigurationMode;
-    fmu->fmi3.getIntervalDecimal = placeholder_fmi3GetIntervalDecimal;
-    fmu->fmi3.getIntervalFraction = placeholder_fmi3GetIntervalFraction;
-    fmu->fmi3.getShiftDecimal = placeholder_fmi3GetShiftDecimal;
-    fmu->fmi3.getShiftFraction = placeholder_fmi3GetShiftFraction;
-    fmu->fmi3.setIntervalDecimal = placeholder_fmi3SetIntervalDecimal;
-    fmu->fmi3.setIntervalFraction = placeholder_fmi3SetIntervalFraction;
-    fmu->fmi3.setShiftDecimal = placeholder_fmi3SetShiftDecimal;
-    fmu->fmi3.setShiftFraction = placeholder_fmi3SetShiftFraction;
-    fmu->fmi3.evaluateDiscreteStates = placeholder_fmi3EvaluateDiscreteStates;
-    fmu->fmi3.updateDiscreteStates = placeholder_fmi3UpdateDiscreteStates;
-    fmu->fmi3.enterContinuousTimeMode = placeholder_fmi3EnterContinuousTimeMode;
-    fmu->fmi3.completedIntegratorStep = placeholder_fmi3CompletedIntegratorStep;
-    fmu->fmi3.setTime = placeholder_fmi3SetTime;
-    fmu->fmi3.setContinuousStates = placeholder_fmi3SetContinuousStates;
-    fmu->fmi3.getContinuousStateDerivatives = placeholder_fmi3GetContinuousStateDerivatives;
-    fmu->fmi3.getEventIndicators = placeholder_fmi3GetEventIndicators;
-    fmu->fmi3.getContinuousStates = placeholder_fmi3GetContinuousStates;
-    fmu->fmi3.getNominalsOfContinuousStates = placeholder_fmi3GetNominalsOfContinuousStates;
-    fmu->fmi3.getNumberOfEventIndicators = placeholder_fmi3GetNumberOfEventIndicators;
-    fmu->fmi3.getNumberOfContinuousStates = placeholder_fmi3GetNumberOfContinuousStates;
-    fmu->fmi3.enterStepMode = placeholder_fmi3EnterStepMode;
-    fmu->fmi3.getOutputDerivatives = placeholder_fmi3GetOutputDerivatives;
-    fmu->fmi3.activateModelPartition = placeholder_fmi3ActivateModelPartition;
+    fmi4c_setPlaceholdersFmi2(fmu);
+    fmi4c_setPlaceholdersFmi3(fmu);
 
     if(fmu->version == fmiVersion1) {
         fmu->fmi1.variables = mallocAndRememberPointer(fmu, 100*sizeof(fmi1VariableHandle));
@@ -4945,6 +5182,28 @@ void fmi4c_freeFmu(fmuHandle *fmu)
     free(fmu);
 }
 
+//! @brief Selects how the FMU binary is loaded for FMI 2 and FMI 3 instances created after this call
+//! With isolation, FMUs that keep data in global variables can have several independent instances in
+//! the same process. Namespace isolation falls back to a copy when no more namespaces are available.
+//! @returns False if the isolation mode is not supported on this platform
+bool fmi4c_setFmuBinaryIsolation(fmuHandle *fmu, fmi4cBinaryIsolation isolation)
+{
+    TRACEFUNC
+#ifdef _WIN32
+    if(isolation != fmi4cIsolationNone) {
+        fmi4c_printMessage("Binary isolation is not supported on Windows");
+        return false;
+    }
+#elif !defined(LM_ID_NEWLM)
+    if(isolation == fmi4cIsolationNamespace) {
+        fmi4c_printMessage("Link-map namespaces are not supported on this platform");
+        return false;
+    }
+#endif
+    fmu->isolation = isolation;
+    return true;
+}
+
 fmi1Type fmi1_getType(fmuHandle *fmu)
 {
     TRACEFUNC
@@ -5999,6 +6258,11 @@ int fmi3_getModelStructureNumberOfDependencies(fmi3ModelStructureHandle *handle)
     return handle->numberOfDependencies;
 }
 
+bool fmi3_getModelStructureDependenciesDefined(fmi3ModelStructureHandle *handle)
+{
+    return handle->dependenciesDefined;
+}
+
 bool fmi3_getModelStructureDependencyKindsDefined(fmi3ModelStructureHandle *handle)
 {
     return handle->dependencyKindsDefined;
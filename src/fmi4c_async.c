@@ -0,0 +1,455 @@
+#include "fmi4c_private.h"
+#define FMI4C_H_INTERNAL_INCLUDE
+#include "fmi4c.h"
+#include "fmi4c_async.h"
+#include "fmi4c_threads.h"
+
+#include <stdint.h>
+
+#define INITIAL_PENDING_CAPACITY 64     // Initial number of slots in the table of pending steps, always a power of two
+
+struct fmi4cStepFuture {
+    fmiVersion_t fmiVersion;
+    fmi2InstanceHandle *fmi2Instance;
+    fmi3InstanceHandle *fmi3Instance;
+    double currentCommunicationPoint;
+    double communicationStepSize;
+    int noSetFMUStatePriorToCurrentPoint;
+
+    int status;                         // fmi2Status or fmi3Status
+    fmi3Boolean eventEncountered;
+    fmi3Boolean terminateSimulation;
+    fmi3Boolean earlyReturn;
+    fmi3Float64 lastSuccessfulTime;
+
+    bool finished;                      // Step returned, the callback is called or about to be called
+    volatile size_t done;               // Step returned and the callback has returned
+    fmi4cStepCallback_t callback;
+    void *userData;
+
+    fmi4cStepFuture *nextInQueue;
+    fmi4cStepFuture *nextForInstance;   // Queued when this step has finished
+};
+
+//! @brief Last queued step of an instance, NULL instance for empty slots
+typedef struct {
+    const void *instance;
+    fmi4cStepFuture *future;
+} pendingStep_t;
+
+typedef struct {
+    int nThreads;
+    fmi4cThread_t *threads;
+    int nStarted;
+
+    fmi4cMutex_t mutex;                 // Protects everything below
+    fmi4cCond_t workCondition;
+    fmi4cCond_t doneCondition;
+    fmi4cStepFuture *queueHead;
+    fmi4cStepFuture *queueTail;
+    bool stop;
+
+    pendingStep_t *pendingSteps;        // Open addressing hash table with linear probing, of instances with unfinished steps
+    size_t pendingCapacity;
+    size_t nPending;
+} executor_t;
+
+static volatile size_t executorPointer = 0;     // executor_t*, created on first use
+static int requestedThreads = 0;                // 0 = number of processors
+
+static inline size_t pendingSlot(executor_t *executor, const void *instance)
+{
+    uint64_t x = (uint64_t)(uintptr_t)instance;
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    size_t mask = executor->pendingCapacity-1;
+    size_t slot = (size_t)x & mask;
+    while(executor->pendingSteps[slot].instance != NULL && executor->pendingSteps[slot].instance != instance) {
+        slot = (slot+1) & mask;
+    }
+    return slot;
+}
+
+//! @brief Returns the last queued step of an instance, or NULL if it has no unfinished steps
+static fmi4cStepFuture *getPendingStep(executor_t *executor, const void *instance)
+{
+    return executor->pendingSteps[pendingSlot(executor, instance)].future;
+}
+
+//! @brief Sets the last queued step of an instance, doubling the table when more than half of it is used
+static bool setPendingStep(executor_t *executor, const void *instance, fmi4cStepFuture *future)
+{
+    size_t slot = pendingSlot(executor, instance);
+    if(executor->pendingSteps[slot].instance == NULL) {
+        if(2*(executor->nPending+1) > executor->pendingCapacity) {
+            pendingStep_t *old = executor->pendingSteps;
+            size_t oldCapacity = executor->pendingCapacity;
+            executor->pendingSteps = calloc(2*oldCapacity, sizeof(pendingStep_t));
+            if(executor->pendingSteps == NULL) {
+                executor->pendingSteps = old;
+                return false;
+            }
+            executor->pendingCapacity = 2*oldCapacity;
+            for(size_t i=0; i<oldCapacity; ++i) {
+                if(old[i].instance != NULL) {
+                    executor->pendingSteps[pendingSlot(executor, old[i].instance)] = old[i];
+                }
+            }
+            free(old);
+            slot = pendingSlot(executor, instance);
+        }
+        executor->pendingSteps[slot].instance = instance;
+        ++executor->nPending;
+    }
+    executor->pendingSteps[slot].future = future;
+    return true;
+}
+
+//! @brief Removes an instance from the table, moving later entries of its probe sequence back into the gap
+static void removePendingStep(executor_t *executor, const void *instance)
+{
+    size_t mask = executor->pendingCapacity-1;
+    size_t gap = pendingSlot(executor, instance);
+    if(executor->pendingSteps[gap].instance == NULL) {
+        return;
+    }
+    executor->pendingSteps[gap].instance = NULL;
+    executor->pendingSteps[gap].future = NULL;
+    --executor->nPending;
+    for(size_t slot=(gap+1) & mask; executor->pendingSteps[slot].instance != NULL; slot=(slot+1) & mask) {
+        pendingStep_t entry = executor->pendingSteps[slot];
+        executor->pendingSteps[slot].instance = NULL;
+        executor->pendingSteps[slot].future = NULL;
+        executor->pendingSteps[pendingSlot(executor, entry.instance)] = entry;
+    }
+}
+
+//! @brief Appends a step to the executor queue, the executor mutex must be locked
+static void enqueue(executor_t *executor, fmi4cStepFuture *future)
+{
+    future->nextInQueue = NULL;
+    if(executor->queueTail == NULL) {
+        executor->queueHead = future;
+    }
+    else {
+        executor->queueTail->nextInQueue = future;
+    }
+    executor->queueTail = future;
+    fmi4c_condSignal(&executor->workCondition);
+}
+
+static void runStep(fmi4cStepFuture *future)
+{
+    if(future->fmiVersion == fmiVersion2) {
+        future->status = fmi2_doStep(future->fmi2Instance,
+                                     future->currentCommunicationPoint,
+                                     future->communicationStepSize,
+                                     future->noSetFMUStatePriorToCurrentPoint);
+    }
+    else {
+        future->status = fmi3_doStep(future->fmi3Instance,
+                                     future->currentCommunicationPoint,
+                                     future->communicationStepSize,
+                                     future->noSetFMUStatePriorToCurrentPoint,
+                                     &future->eventEncountered,
+                                     &future->terminateSimulation,
+                                     &future->earlyReturn,
+                                     &future->lastSuccessfulTime);
+    }
+}
+
+static void executorMain(void *arg)
+{
+    executor_t *executor = (executor_t*)arg;
+
+    fmi4c_mutexLock(&executor->mutex);
+    while(true) {
+        while(executor->queueHead == NULL && !executor->stop) {
+            fmi4c_condWait(&executor->workCondition, &executor->mutex);
+        }
+        fmi4cStepFuture *future = executor->queueHead;
+        if(future == NULL) {
+            break;      // Stopped and nothing left to do
+        }
+        executor->queueHead = future->nextInQueue;
+        if(executor->queueHead == NULL) {
+            executor->queueTail = NULL;
+        }
+        fmi4c_mutexUnlock(&executor->mutex);
+
+        runStep(future);
+
+        // The callback is called without holding the mutex, so that it may queue new steps. Waiting
+        // threads are released after it has returned.
+        fmi4c_mutexLock(&executor->mutex);
+        future->finished = true;
+        fmi4cStepCallback_t callback = future->callback;
+        void *userData = future->userData;
+        if(callback != NULL) {
+            fmi4c_mutexUnlock(&executor->mutex);
+            callback(future, userData);
+            fmi4c_mutexLock(&executor->mutex);
+        }
+
+        const void *instance = (future->fmiVersion == fmiVersion2) ? (const void*)future->fmi2Instance
+                                                                   : (const void*)future->fmi3Instance;
+        if(getPendingStep(executor, instance) == future) {
+            removePendingStep(executor, instance);
+        }
+        if(future->nextForInstance != NULL) {
+            enqueue(executor, future->nextForInstance);
+        }
+        fmi4c_atomicStoreRelease(&future->done, 1);
+        fmi4c_condBroadcast(&executor->doneCondition);
+    }
+    fmi4c_mutexUnlock(&executor->mutex);
+}
+
+static void freeExecutor(executor_t *executor)
+{
+    fmi4c_mutexLock(&executor->mutex);
+    executor->stop = true;
+    fmi4c_condBroadcast(&executor->workCondition);
+    fmi4c_mutexUnlock(&executor->mutex);
+    for(int i=0; i<executor->nStarted; ++i) {
+        fmi4c_threadJoin(executor->threads[i]);
+    }
+    fmi4c_condDestroy(&executor->doneCondition);
+    fmi4c_condDestroy(&executor->workCondition);
+    fmi4c_mutexDestroy(&executor->mutex);
+    free(executor->pendingSteps);
+    free(executor->threads);
+    free(executor);
+}
+
+static executor_t *createExecutor(int nThreads)
+{
+    executor_t *executor = calloc(1, sizeof(executor_t));
+    if(executor == NULL) {
+        return NULL;
+    }
+    executor->nThreads = nThreads;
+    executor->threads = calloc((size_t)nThreads, sizeof(fmi4cThread_t));
+    executor->pendingSteps = calloc(INITIAL_PENDING_CAPACITY, sizeof(pendingStep_t));
+    executor->pendingCapacity = INITIAL_PENDING_CAPACITY;
+    if(executor->threads == NULL || executor->pendingSteps == NULL) {
+        free(executor->threads);
+        free(executor->pendingSteps);
+        free(executor);
+        return NULL;
+    }
+    fmi4c_mutexInit(&executor->mutex);
+    fmi4c_condInit(&executor->workCondition);
+    fmi4c_condInit(&executor->doneCondition);
+    for(int i=0; i<nThreads; ++i) {
+        if(!fmi4c_threadCreate(&executor->threads[i], executorMain, executor)) {
+            fmi4c_printMessage("Failed to create executor thread");
+            freeExecutor(executor);
+            return NULL;
+        }
+        ++executor->nStarted;
+    }
+    return executor;
+}
+
+//! @brief Returns the executor, creating it on first use
+static executor_t *getExecutor(void)
+{
+    executor_t *executor = (executor_t*)fmi4c_atomicLoadAcquire(&executorPointer);
+    if(executor != NULL) {
+        return executor;
+    }
+    int nThreads = requestedThreads > 0 ? requestedThreads : fmi4c_getNumberOfProcessors();
+    executor = createExecutor(nThreads > 0 ? nThreads : 1);
+    if(executor == NULL) {
+        return NULL;
+    }
+    if(!fmi4c_atomicCompareExchange(&executorPointer, 0, (size_t)executor)) {
+        // Another thread created an executor at the same time
+        freeExecutor(executor);
+        executor = (executor_t*)fmi4c_atomicLoadAcquire(&executorPointer);
+    }
+    return executor;
+}
+
+//! @brief Queues a step, after any unfinished step for the same instance
+static fmi4cStepFuture *submitStep(fmi4cStepFuture *future, const void *instance)
+{
+    executor_t *executor = getExecutor();
+    if(executor == NULL) {
+        fmi4c_printMessage("Failed to create step executor");
+        free(future);
+        return NULL;
+    }
+    fmi4c_mutexLock(&executor->mutex);
+    fmi4cStepFuture *pending = getPendingStep(executor, instance);
+    if(!setPendingStep(executor, instance, future)) {
+        fmi4c_mutexUnlock(&executor->mutex);
+        fmi4c_printMessage("Failed to queue asynchronous step");
+        free(future);
+        return NULL;
+    }
+    if(pending != NULL) {
+        pending->nextForInstance = future;
+    }
+    else {
+        enqueue(executor, future);
+    }
+    fmi4c_mutexUnlock(&executor->mutex);
+    return future;
+}
+
+//! @brief Queues a call to fmi2_doStep on the executor
+//! @returns Future for the step, or NULL on failure. Must be freed with fmi4c_freeStep().
+fmi4cStepFuture *fmi2_doStepAsync(fmi2InstanceHandle *instance,
+                                  fmi2Real currentCommunicationPoint,
+                                  fmi2Real communicationStepSize,
+                                  fmi2Boolean noSetFMUStatePriorToCurrentPoint)
+{
+    fmi4cStepFuture *future = calloc(1, sizeof(fmi4cStepFuture));
+    if(future == NULL) {
+        return NULL;
+    }
+    future->fmiVersion = fmiVersion2;
+    future->fmi2Instance = instance;
+    future->currentCommunicationPoint = currentCommunicationPoint;
+    future->communicationStepSize = communicationStepSize;
+    future->noSetFMUStatePriorToCurrentPoint = noSetFMUStatePriorToCurrentPoint;
+    return submitStep(future, instance);
+}
+
+//! @brief Queues a call to fmi3_doStep on the executor
+//! @returns Future for the step, or NULL on failure. Must be freed with fmi4c_freeStep().
+fmi4cStepFuture *fmi3_doStepAsync(fmi3InstanceHandle *instance,
+                                  fmi3Float64 currentCommunicationPoint,
+                                  fmi3Float64 communicationStepSize,
+                                  fmi3Boolean noSetFMUStatePriorToCurrentPoint)
+{
+    fmi4cStepFuture *future = calloc(1, sizeof(fmi4cStepFuture));
+    if(future == NULL) {
+        return NULL;
+    }
+    future->fmiVersion = fmiVersion3;
+    future->fmi3Instance = instance;
+    future->currentCommunicationPoint = currentCommunicationPoint;
+    future->communicationStepSize = communicationStepSize;
+    future->noSetFMUStatePriorToCurrentPoint = noSetFMUStatePriorToCurrentPoint;
+    return submitStep(future, instance);
+}
+
+//! @brief Returns true if the step has finished, never blocks
+bool fmi4c_isStepReady(fmi4cStepFuture *future)
+{
+    return fmi4c_atomicLoadAcquire(&future->done) != 0;
+}
+
+//! @brief Blocks until the step has finished
+void fmi4c_waitStep(fmi4cStepFuture *future)
+{
+    fmi4c_waitAllSteps(&future, 1);
+}
+
+//! @brief Blocks until all steps have finished
+//! @param futures Array of futures, NULL elements are ignored
+//! @param nFutures Number of futures
+void fmi4c_waitAllSteps(fmi4cStepFuture **futures, size_t nFutures)
+{
+    size_t i = 0;
+    while(i < nFutures && (futures[i] == NULL || fmi4c_isStepReady(futures[i]))) {
+        ++i;
+    }
+    if(i == nFutures) {
+        return;
+    }
+
+    // A queued future implies that the executor exists
+    executor_t *executor = (executor_t*)fmi4c_atomicLoadAcquire(&executorPointer);
+    fmi4c_mutexLock(&executor->mutex);
+    for(; i<nFutures; ++i) {
+        while(futures[i] != NULL && !fmi4c_isStepReady(futures[i])) {
+            fmi4c_condWait(&executor->doneCondition, &executor->mutex);
+        }
+    }
+    fmi4c_mutexUnlock(&executor->mutex);
+}
+
+//! @brief Sets a callback that is called when the step has finished, before waiting threads are released
+//! If the step has already finished, the callback is called immediately on the calling thread.
+void fmi4c_setStepCallback(fmi4cStepFuture *future, fmi4cStepCallback_t callback, void *userData)
+{
+    executor_t *executor = (executor_t*)fmi4c_atomicLoadAcquire(&executorPointer);
+    fmi4c_mutexLock(&executor->mutex);
+    bool done = future->finished;
+    if(!done) {
+        future->callback = callback;
+        future->userData = userData;
+    }
+    fmi4c_mutexUnlock(&executor->mutex);
+    if(done && callback != NULL) {
+        callback(future, userData);
+    }
+}
+
+//! @brief Waits for the step to finish and frees the future
+void fmi4c_freeStep(fmi4cStepFuture *future)
+{
+    if(future == NULL) {
+        return;
+    }
+    fmi4c_waitStep(future);
+    free(future);
+}
+
+//! @brief Returns the status of a finished FMI 2 step
+//! Must only be called after waiting for the step, or from its completion callback.
+fmi2Status fmi2_getStepStatus(fmi4cStepFuture *future)
+{
+    return (fmi2Status)future->status;
+}
+
+//! @brief Returns the status and outputs of a finished FMI 3 step
+//! Must only be called after waiting for the step, or from its completion callback. Output arguments may be NULL.
+fmi3Status fmi3_getStepStatus(fmi4cStepFuture *future,
+                              fmi3Boolean *eventEncountered,
+                              fmi3Boolean *terminateSimulation,
+                              fmi3Boolean *earlyReturn,
+                              fmi3Float64 *lastSuccessfulTime)
+{
+    if(eventEncountered != NULL) {
+        *eventEncountered = future->eventEncountered;
+    }
+    if(terminateSimulation != NULL) {
+        *terminateSimulation = future->terminateSimulation;
+    }
+    if(earlyReturn != NULL) {
+        *earlyReturn = future->earlyReturn;
+    }
+    if(lastSuccessfulTime != NULL) {
+        *lastSuccessfulTime = future->lastSuccessfulTime;
+    }
+    return (fmi3Status)future->status;
+}
+
+//! @brief Sets the number of executor threads, must be called before the first asynchronous step
+//! @param nThreads Number of threads, 0 = number of processors
+//! @returns False if the executor is already running
+bool fmi4c_setStepExecutorThreads(int nThreads)
+{
+    if(fmi4c_atomicLoadAcquire(&executorPointer) != 0) {
+        fmi4c_printMessage("Step executor threads must be set before the first asynchronous step");
+        return false;
+    }
+    requestedThreads = nThreads;
+    return true;
+}
+
+//! @brief Finishes all queued steps and stops the executor threads
+//! Must not be called while other threads queue or wait for steps. A new executor is created if more asynchronous steps are queued afterwards.
+void fmi4c_freeStepExecutor(void)
+{
+    executor_t *executor = (executor_t*)fmi4c_atomicLoadAcquire(&executorPointer);
+    if(executor != NULL && fmi4c_atomicCompareExchange(&executorPointer, (size_t)executor, 0)) {
+        freeExecutor(executor);
+    }
+}
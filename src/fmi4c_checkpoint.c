@@ -0,0 +1,938 @@
+#include "fmi4c_private.h"
+#define FMI4C_H_INTERNAL_INCLUDE
+#include "fmi4c.h"
+#include "fmi4c_checkpoint.h"
+#include "fmi4c_common.h"
+#include "fmi4c_threads.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef FMI4C_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+#define CHUNK_SIZE 4096                 // Uncompressed chunk size, the last chunk of a checkpoint may be smaller
+#define INITIAL_TABLE_CAPACITY 64       // Initial number of hash table slots, always a power of two
+#define INITIAL_SPILL_CAPACITY (1 << 20)
+#define EMPTY_SLOT -1
+#define DELETED_SLOT -2
+
+//! @brief Unique chunk, stored compressed (storedSize < rawSize) or as is
+typedef struct {
+    uint64_t hash[2];
+    uint32_t rawSize;
+    uint32_t storedSize;
+    uint32_t refCount;                  // Number of checkpoint references, 0 for free entries
+    bool spilled;
+    unsigned char *data;                // Chunk data in memory, if not spilled
+    size_t offset;                      // Offset in the spill file, if spilled
+} chunk_t;
+
+//! @brief Free range in the spill file
+typedef struct {
+    size_t offset;
+    size_t size;
+} extent_t;
+
+typedef struct {
+    const void *key;
+    double time;
+    size_t size;
+    size_t nChunks;
+    int32_t *chunks;                    // NULL for free entries
+} checkpoint_t;
+
+//! @brief Open addressing hash table of entry indices, with linear probing
+typedef struct {
+    int32_t *slots;
+    size_t capacity;
+    size_t nUsed;                       // Occupied and deleted slots
+    size_t nLive;                       // Occupied slots
+} hashIndex_t;
+
+struct fmi4cCheckpointStore {
+    fmi4cMutex_t mutex;
+    size_t memoryBudget;
+
+    chunk_t *chunks;
+    size_t nChunks;
+    size_t chunkCapacity;
+    int32_t *freeChunks;                // Stack of free chunk entries
+    size_t nFreeChunks;
+    hashIndex_t chunkIndex;
+
+    checkpoint_t *checkpoints;
+    size_t nCheckpoints;
+    size_t checkpointCapacity;
+    int32_t *freeCheckpoints;
+    size_t nFreeCheckpoints;
+    hashIndex_t checkpointIndex;
+
+    unsigned char *compressBuffer;
+    unsigned char *chunkBuffer;         // Decompressed chunk for content comparison
+#ifdef FMI4C_WITH_ZLIB
+    z_stream deflater;                  // Streams are reset per chunk, to avoid allocating their state every time
+    z_stream inflater;
+    bool zlibInitialized;
+#endif
+    fmi4cCheckpointStatistics statistics;
+
+    char *spillDirectory;
+    FILE *spillFile;
+    unsigned char *spillMap;            // Mapping of the whole spill file (not on Windows)
+    size_t spillCapacity;
+    size_t spillEnd;
+    extent_t *freeExtents;              // Free ranges before spillEnd, sorted by offset and coalesced
+    size_t nFreeExtents;
+    size_t freeExtentCapacity;
+};
+
+static inline uint64_t rotateLeft(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64-r));
+}
+
+static inline uint64_t mix64(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+//! @brief Computes a 128-bit content hash from two independent 64-bit lanes
+static void hashChunk(const unsigned char *data, size_t size, uint64_t hash[2])
+{
+    uint64_t h1 = 0x9e3779b97f4a7c15ULL ^ size;
+    uint64_t h2 = 0xc2b2ae3d27d4eb4fULL + size;
+    size_t i = 0;
+    for(; i+8 <= size; i += 8) {
+        uint64_t word;
+        memcpy(&word, data+i, 8);
+        h1 = rotateLeft(h1 ^ (word*0x87c37b91114253d5ULL), 31)*0x4cf5ad432745937fULL;
+        h2 = rotateLeft(h2+word, 27)*0x9e3779b97f4a7c15ULL ^ (h2 >> 29);
+    }
+    uint64_t tail = 0;
+    for(size_t j=0; i+j < size; ++j) {
+        tail |= (uint64_t)data[i+j] << (8*j);
+    }
+    hash[0] = mix64(h1 ^ tail);
+    hash[1] = mix64(h2+rotateLeft(tail, 17));
+}
+
+static inline uint64_t checkpointHash(const void *key, double time)
+{
+    uint64_t bits;
+    memcpy(&bits, &time, sizeof(bits));
+    return mix64((uint64_t)(uintptr_t)key ^ rotateLeft(bits, 32));
+}
+
+//! @brief Returns the stored bytes of a chunk, reading spilled chunks into buffer when they are not mapped
+static const unsigned char *readStored(fmi4cCheckpointStore *store, chunk_t *chunk, unsigned char *buffer)
+{
+    if(!chunk->spilled) {
+        return chunk->data;
+    }
+#ifdef _WIN32
+    if(fseek(store->spillFile, (long)chunk->offset, SEEK_SET) != 0 ||
+       fread(buffer, 1, chunk->storedSize, store->spillFile) != chunk->storedSize) {
+        return NULL;
+    }
+    return buffer;
+#else
+    UNUSED(buffer)
+    return store->spillMap+chunk->offset;
+#endif
+}
+
+//! @brief Decompresses (or copies) the content of a chunk into output, which must hold rawSize bytes
+static bool decodeChunk(fmi4cCheckpointStore *store, chunk_t *chunk, unsigned char *output)
+{
+    const unsigned char *stored = readStored(store, chunk, store->compressBuffer);
+    if(stored == NULL) {
+        return false;
+    }
+    if(chunk->storedSize == chunk->rawSize) {
+        memcpy(output, stored, chunk->rawSize);
+        return true;
+    }
+#ifdef FMI4C_WITH_ZLIB
+    z_stream *inflater = &store->inflater;
+    inflateReset(inflater);
+    inflater->next_in = (Bytef*)stored;
+    inflater->avail_in = chunk->storedSize;
+    inflater->next_out = output;
+    inflater->avail_out = chunk->rawSize;
+    return inflate(inflater, Z_FINISH) == Z_STREAM_END && inflater->total_out == chunk->rawSize;
+#else
+    return false;
+#endif
+}
+
+static bool initIndex(hashIndex_t *index, size_t capacity)
+{
+    index->slots = malloc(capacity*sizeof(int32_t));
+    if(index->slots == NULL) {
+        return false;
+    }
+    for(size_t i=0; i<capacity; ++i) {
+        index->slots[i] = EMPTY_SLOT;
+    }
+    index->capacity = capacity;
+    index->nUsed = 0;
+    index->nLive = 0;
+    return true;
+}
+
+//! @brief Returns the slot holding the entry with the specified hash for which matches() is true, or the first free slot
+#define FIND_SLOT(index, hash, matches, result) do { \
+        size_t mask_ = (index)->capacity-1; \
+        size_t slot_ = (size_t)(hash) & mask_; \
+        size_t free_ = (size_t)-1; \
+        while((index)->slots[slot_] != EMPTY_SLOT) { \
+            int32_t entry = (index)->slots[slot_]; \
+            if(entry == DELETED_SLOT) { \
+                if(free_ == (size_t)-1) { free_ = slot_; } \
+            } \
+            else if(matches) { \
+                break; \
+            } \
+            slot_ = (slot_+1) & mask_; \
+        } \
+        (result) = ((index)->slots[slot_] == EMPTY_SLOT && free_ != (size_t)-1) ? free_ : slot_; \
+    } while(0)
+
+//! @brief Checks if a chunk has the specified content
+//! Chunks with equal hashes are also compared byte by byte, so that a hash collision cannot corrupt a checkpoint.
+static bool chunkMatches(fmi4cCheckpointStore *store, int32_t entry, const uint64_t hash[2], const unsigned char *data, uint32_t rawSize)
+{
+    chunk_t *chunk = &store->chunks[entry];
+    if(chunk->hash[0] != hash[0] || chunk->hash[1] != hash[1] || chunk->rawSize != rawSize) {
+        return false;
+    }
+    if(chunk->storedSize == chunk->rawSize) {
+        const unsigned char *stored = readStored(store, chunk, store->compressBuffer);
+        return stored != NULL && memcmp(stored, data, rawSize) == 0;
+    }
+    return decodeChunk(store, chunk, store->chunkBuffer) && memcmp(store->chunkBuffer, data, rawSize) == 0;
+}
+
+static bool checkpointMatches(fmi4cCheckpointStore *store, int32_t entry, const void *key, double time)
+{
+    checkpoint_t *checkpoint = &store->checkpoints[entry];
+    return checkpoint->key == key && checkpoint->time == time;
+}
+
+//! @brief Finds the slot of a chunk with the specified content, or the free slot where it would be inserted
+static size_t findChunkSlot(fmi4cCheckpointStore *store, const uint64_t hash[2], const unsigned char *data, uint32_t rawSize)
+{
+    size_t slot;
+    FIND_SLOT(&store->chunkIndex, hash[0], chunkMatches(store, entry, hash, data, rawSize), slot);
+    return slot;
+}
+
+//! @brief Finds the slot holding a chunk entry
+static size_t findChunkEntrySlot(fmi4cCheckpointStore *store, int32_t chunkEntry)
+{
+    size_t slot;
+    FIND_SLOT(&store->chunkIndex, store->chunks[chunkEntry].hash[0], entry == chunkEntry, slot);
+    return slot;
+}
+
+static size_t findCheckpointSlot(fmi4cCheckpointStore *store, const void *key, double time)
+{
+    size_t slot;
+    FIND_SLOT(&store->checkpointIndex, checkpointHash(key, time), checkpointMatches(store, entry, key, time), slot);
+    return slot;
+}
+
+//! @brief Returns the capacity for rebuilding an index when more than half of its slots are used, or 0 if it needs no rebuild
+//! A rebuild drops the deleted slots, so the capacity is only doubled when the live entries fill more than a quarter of it.
+static size_t getRebuildCapacity(const hashIndex_t *index)
+{
+    if(2*(index->nUsed+1) <= index->capacity) {
+        return 0;
+    }
+    return 4*(index->nLive+1) > index->capacity ? 2*index->capacity : index->capacity;
+}
+
+static bool growChunkIndex(fmi4cCheckpointStore *store)
+{
+    hashIndex_t *index = &store->chunkIndex;
+    size_t capacity = getRebuildCapacity(index);
+    if(capacity == 0) {
+        return true;
+    }
+    hashIndex_t old = *index;
+    if(!initIndex(index, capacity)) {
+        *index = old;
+        return false;
+    }
+    for(size_t i=0; i<old.capacity; ++i) {
+        int32_t entry = old.slots[i];
+        if(entry >= 0) {
+            size_t slot;
+            FIND_SLOT(index, store->chunks[entry].hash[0], false, slot);  // The new index only has empty slots
+            index->slots[slot] = entry;
+            ++index->nUsed;
+            ++index->nLive;
+        }
+    }
+    free(old.slots);
+    return true;
+}
+
+static bool growCheckpointIndex(fmi4cCheckpointStore *store)
+{
+    hashIndex_t *index = &store->checkpointIndex;
+    size_t capacity = getRebuildCapacity(index);
+    if(capacity == 0) {
+        return true;
+    }
+    hashIndex_t old = *index;
+    if(!initIndex(index, capacity)) {
+        *index = old;
+        return false;
+    }
+    for(size_t i=0; i<old.capacity; ++i) {
+        int32_t entry = old.slots[i];
+        if(entry >= 0) {
+            checkpoint_t *checkpoint = &store->checkpoints[entry];
+            size_t slot = findCheckpointSlot(store, checkpoint->key, checkpoint->time);
+            index->slots[slot] = entry;
+            ++index->nUsed;
+            ++index->nLive;
+        }
+    }
+    free(old.slots);
+    return true;
+}
+
+//! @brief Creates a checkpoint store
+//! @param memoryBudget Maximum stored size of chunks in memory in bytes, larger amounts are spilled to disk (0 = unlimited)
+//! @param spillDirectory Directory for the spill file, or NULL for the system temporary directory
+//! @returns Store handle, or NULL on failure
+fmi4cCheckpointStore *fmi4c_createCheckpointStore(size_t memoryBudget, const char *spillDirectory)
+{
+    fmi4cCheckpointStore *store = calloc(1, sizeof(fmi4cCheckpointStore));
+    if(store == NULL) {
+        return NULL;
+    }
+    store->memoryBudget = memoryBudget > 0 ? memoryBudget : (size_t)-1;
+    if(spillDirectory != NULL) {
+        store->spillDirectory = _strdup(spillDirectory);
+    }
+#ifdef FMI4C_WITH_ZLIB
+    store->compressBuffer = malloc(compressBound(CHUNK_SIZE));
+    store->chunkBuffer = malloc(CHUNK_SIZE);
+    if(deflateInit(&store->deflater, Z_BEST_SPEED) != Z_OK) {
+        fmi4c_freeCheckpointStore(store);
+        return NULL;
+    }
+    if(inflateInit(&store->inflater) != Z_OK) {
+        deflateEnd(&store->deflater);
+        fmi4c_freeCheckpointStore(store);
+        return NULL;
+    }
+    store->zlibInitialized = true;
+#else
+    store->compressBuffer = malloc(CHUNK_SIZE);
+    store->chunkBuffer = malloc(CHUNK_SIZE);
+#endif
+    if(store->compressBuffer == NULL || store->chunkBuffer == NULL ||
+       (spillDirectory != NULL && store->spillDirectory == NULL) ||
+       !initIndex(&store->chunkIndex, INITIAL_TABLE_CAPACITY) ||
+       !initIndex(&store->checkpointIndex, INITIAL_TABLE_CAPACITY)) {
+        fmi4c_freeCheckpointStore(store);
+        return NULL;
+    }
+    fmi4c_mutexInit(&store->mutex);
+    return store;
+}
+
+static void closeSpillFile(fmi4cCheckpointStore *store)
+{
+#ifndef _WIN32
+    if(store->spillMap != NULL) {
+        munmap(store->spillMap, store->spillCapacity);
+    }
+#endif
+    if(store->spillFile != NULL) {
+        fclose(store->spillFile);
+    }
+    store->spillMap = NULL;
+    store->spillFile = NULL;
+    store->spillCapacity = 0;
+    store->spillEnd = 0;
+    store->nFreeExtents = 0;
+}
+
+void fmi4c_freeCheckpointStore(fmi4cCheckpointStore *store)
+{
+    if(store == NULL) {
+        return;
+    }
+    if(store->chunkIndex.slots != NULL && store->checkpointIndex.slots != NULL) {
+        fmi4c_mutexDestroy(&store->mutex);
+    }
+    for(size_t i=0; i<store->nChunks; ++i) {
+        free(store->chunks[i].data);
+    }
+    for(size_t i=0; i<store->nCheckpoints; ++i) {
+        free(store->checkpoints[i].chunks);
+    }
+    closeSpillFile(store);
+#ifdef FMI4C_WITH_ZLIB
+    if(store->zlibInitialized) {
+        deflateEnd(&store->deflater);
+        inflateEnd(&store->inflater);
+    }
+#endif
+    free(store->chunks);
+    free(store->freeChunks);
+    free(store->chunkIndex.slots);
+    free(store->checkpoints);
+    free(store->freeCheckpoints);
+    free(store->checkpointIndex.slots);
+    free(store->compressBuffer);
+    free(store->chunkBuffer);
+    free(store->freeExtents);
+    free(store->spillDirectory);
+    free(store);
+}
+
+//! @brief Creates the spill file, it is deleted right away on POSIX systems and by tmpfile() on Windows
+static bool openSpillFile(fmi4cCheckpointStore *store)
+{
+#ifdef _WIN32
+    store->spillFile = tmpfile();
+    return store->spillFile != NULL;
+#else
+    const char *directory = store->spillDirectory;
+    if(directory == NULL) {
+        directory = getenv("TMPDIR");
+    }
+    if(directory == NULL) {
+        directory = "/tmp";
+    }
+    char path[FILENAME_MAX];
+    snprintf(path, sizeof(path), "%s/fmi4c_checkpoints_XXXXXX", directory);
+    int fd = mkstemp(path);
+    if(fd < 0) {
+        fmi4c_printMessage("Failed to create checkpoint spill file");
+        return false;
+    }
+    unlink(path);
+    store->spillFile = fdopen(fd, "w+b");
+    if(store->spillFile == NULL) {
+        close(fd);
+        return false;
+    }
+    return true;
+#endif
+}
+
+//! @brief Makes room for size more bytes at the end of the spill file, remapping it when it grows
+static bool reserveSpillSpace(fmi4cCheckpointStore *store, size_t size)
+{
+    if(store->spillFile == NULL && !openSpillFile(store)) {
+        return false;
+    }
+    if(store->spillEnd+size <= store->spillCapacity) {
+        return true;
+    }
+    size_t capacity = store->spillCapacity > 0 ? store->spillCapacity : INITIAL_SPILL_CAPACITY;
+    while(capacity < store->spillEnd+size) {
+        capacity *= 2;
+    }
+#ifdef _WIN32
+    store->spillCapacity = capacity;
+    return true;
+#else
+    int fd = fileno(store->spillFile);
+    if(ftruncate(fd, (off_t)capacity) != 0) {
+        fmi4c_printMessage("Failed to grow checkpoint spill file");
+        return false;
+    }
+    void *map = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(map == MAP_FAILED) {
+        fmi4c_printMessage("Failed to map checkpoint spill file");
+        return false;
+    }
+    if(store->spillMap != NULL) {
+        munmap(store->spillMap, store->spillCapacity);
+    }
+    store->spillMap = map;
+    store->spillCapacity = capacity;
+    return true;
+#endif
+}
+
+//! @brief Allocates size bytes in the spill file, from the first free range that is large enough or at the end
+static bool allocateSpillSpace(fmi4cCheckpointStore *store, size_t size, size_t *offset)
+{
+    for(size_t i=0; i<store->nFreeExtents; ++i) {
+        extent_t *extent = &store->freeExtents[i];
+        if(extent->size >= size) {
+            *offset = extent->offset;
+            extent->offset += size;
+            extent->size -= size;
+            if(extent->size == 0) {
+                memmove(extent, extent+1, (store->nFreeExtents-i-1)*sizeof(extent_t));
+                --store->nFreeExtents;
+            }
+            return true;
+        }
+    }
+    if(!reserveSpillSpace(store, size)) {
+        return false;
+    }
+    *offset = store->spillEnd;
+    store->spillEnd += size;
+    return true;
+}
+
+//! @brief Returns a range of the spill file to the free list, merging it with adjacent free ranges
+//! A free range at the end of the used part of the file is given back by moving spillEnd.
+static void freeSpillSpace(fmi4cCheckpointStore *store, size_t offset, size_t size)
+{
+    extent_t *extents = store->freeExtents;
+    size_t n = store->nFreeExtents;
+    size_t first = 0;       // First free range after offset
+    size_t last = n;
+    while(first < last) {
+        size_t middle = first+(last-first)/2;
+        if(extents[middle].offset < offset) {
+            first = middle+1;
+        }
+        else {
+            last = middle;
+        }
+    }
+    bool joinsPrevious = first > 0 && extents[first-1].offset+extents[first-1].size == offset;
+    bool joinsNext = first < n && offset+size == extents[first].offset;
+    if(joinsPrevious && joinsNext) {
+        extents[first-1].size += size+extents[first].size;
+        memmove(&extents[first], &extents[first+1], (n-first-1)*sizeof(extent_t));
+        --store->nFreeExtents;
+    }
+    else if(joinsPrevious) {
+        extents[first-1].size += size;
+    }
+    else if(joinsNext) {
+        extents[first].offset = offset;
+        extents[first].size += size;
+    }
+    else {
+        if(n == store->freeExtentCapacity) {
+            size_t capacity = n > 0 ? 2*n : 64;
+            extents = realloc(store->freeExtents, capacity*sizeof(extent_t));
+            if(extents == NULL) {
+                return;     // The range is not reused until the spill file is empty
+            }
+            store->freeExtents = extents;
+            store->freeExtentCapacity = capacity;
+        }
+        memmove(&extents[first+1], &extents[first], (n-first)*sizeof(extent_t));
+        extents[first].offset = offset;
+        extents[first].size = size;
+        ++store->nFreeExtents;
+    }
+    n = store->nFreeExtents;
+    if(extents[n-1].offset+extents[n-1].size == store->spillEnd) {
+        store->spillEnd = extents[n-1].offset;
+        --store->nFreeExtents;
+    }
+}
+
+static bool writeSpilled(fmi4cCheckpointStore *store, chunk_t *chunk, const unsigned char *data)
+{
+    if(!allocateSpillSpace(store, chunk->storedSize, &chunk->offset)) {
+        return false;
+    }
+#ifdef _WIN32
+    if(fseek(store->spillFile, (long)chunk->offset, SEEK_SET) != 0 ||
+       fwrite(data, 1, chunk->storedSize, store->spillFile) != chunk->storedSize) {
+        return false;
+    }
+#else
+    memcpy(store->spillMap+chunk->offset, data, chunk->storedSize);
+#endif
+    chunk->spilled = true;
+    return true;
+}
+
+//! @brief Returns the entry of a chunk with the specified content, adding it if it is new, or -1 on failure
+static int32_t addChunk(fmi4cCheckpointStore *store, const unsigned char *data, uint32_t size)
+{
+    uint64_t hash[2];
+    hashChunk(data, size, hash);
+    size_t slot = findChunkSlot(store, hash, data, size);
+    int32_t entry = store->chunkIndex.slots[slot];
+    if(entry >= 0) {
+        ++store->chunks[entry].refCount;
+        return entry;
+    }
+    if(!growChunkIndex(store)) {
+        return -1;
+    }
+    slot = findChunkSlot(store, hash, data, size);
+
+    // Allocate an entry
+    if(store->nFreeChunks > 0) {
+        entry = store->freeChunks[--store->nFreeChunks];
+    }
+    else {
+        if(store->nChunks == store->chunkCapacity) {
+            size_t capacity = store->chunkCapacity > 0 ? 2*store->chunkCapacity : 64;
+            chunk_t *chunks = realloc(store->chunks, capacity*sizeof(chunk_t));
+            int32_t *freeChunks = realloc(store->freeChunks, capacity*sizeof(int32_t));
+            if(chunks != NULL) {
+                store->chunks = chunks;
+            }
+            if(freeChunks != NULL) {
+                store->freeChunks = freeChunks;
+            }
+            if(chunks == NULL || freeChunks == NULL) {
+                return -1;
+            }
+            store->chunkCapacity = capacity;
+        }
+        entry = (int32_t)store->nChunks++;
+    }
+    chunk_t *chunk = &store->chunks[entry];
+    memset(chunk, 0, sizeof(chunk_t));
+    chunk->hash[0] = hash[0];
+    chunk->hash[1] = hash[1];
+    chunk->rawSize = size;
+
+    // Compress, and keep the original when compression does not pay off
+    const unsigned char *stored = data;
+    chunk->storedSize = size;
+#ifdef FMI4C_WITH_ZLIB
+    z_stream *deflater = &store->deflater;
+    deflateReset(deflater);
+    deflater->next_in = (Bytef*)data;
+    deflater->avail_in = size;
+    deflater->next_out = store->compressBuffer;
+    deflater->avail_out = (uInt)compressBound(CHUNK_SIZE);
+    if(deflate(deflater, Z_FINISH) == Z_STREAM_END && deflater->total_out < size) {
+        stored = store->compressBuffer;
+        chunk->storedSize = (uint32_t)deflater->total_out;
+    }
+#endif
+
+    bool ok;
+    if(store->statistics.memoryBytes+chunk->storedSize <= store->memoryBudget) {
+        chunk->data = malloc(chunk->storedSize);
+        ok = chunk->data != NULL;
+        if(ok) {
+            memcpy(chunk->data, stored, chunk->storedSize);
+            store->statistics.memoryBytes += chunk->storedSize;
+        }
+    }
+    else {
+        ok = writeSpilled(store, chunk, stored);
+        if(ok) {
+            store->statistics.spilledBytes += chunk->storedSize;
+        }
+    }
+    if(!ok) {
+        store->freeChunks[store->nFreeChunks++] = entry;
+        return -1;
+    }
+    chunk->refCount = 1;
+    if(store->chunkIndex.slots[slot] == EMPTY_SLOT) {
+        ++store->chunkIndex.nUsed;
+    }
+    store->chunkIndex.slots[slot] = entry;
+    ++store->chunkIndex.nLive;
+    ++store->statistics.numberOfChunks;
+    store->statistics.chunkBytes += size;
+    return entry;
+}
+
+static void releaseChunk(fmi4cCheckpointStore *store, int32_t entry)
+{
+    chunk_t *chunk = &store->chunks[entry];
+    if(--chunk->refCount > 0) {
+        return;
+    }
+    store->chunkIndex.slots[findChunkEntrySlot(store, entry)] = DELETED_SLOT;
+    --store->chunkIndex.nLive;
+    if(chunk->spilled) {
+        store->statistics.spilledBytes -= chunk->storedSize;
+        freeSpillSpace(store, chunk->offset, chunk->storedSize);
+        if(store->statistics.spilledBytes == 0) {
+            store->spillEnd = 0;    // No live spilled chunks, so the whole file can be reused
+            store->nFreeExtents = 0;
+        }
+    }
+    else {
+        free(chunk->data);
+        chunk->data = NULL;
+        store->statistics.memoryBytes -= chunk->storedSize;
+    }
+    --store->statistics.numberOfChunks;
+    store->statistics.chunkBytes -= chunk->rawSize;
+    store->freeChunks[store->nFreeChunks++] = entry;
+}
+
+//! @brief Removes the checkpoint in a slot of the checkpoint index, must be called with the mutex locked
+static void removeCheckpointInSlot(fmi4cCheckpointStore *store, size_t slot)
+{
+    int32_t entry = store->checkpointIndex.slots[slot];
+    checkpoint_t *checkpoint = &store->checkpoints[entry];
+    for(size_t i=0; i<checkpoint->nChunks; ++i) {
+        releaseChunk(store, checkpoint->chunks[i]);
+    }
+    free(checkpoint->chunks);
+    checkpoint->chunks = NULL;
+    --store->statistics.numberOfCheckpoints;
+    store->statistics.checkpointBytes -= checkpoint->size;
+    store->checkpointIndex.slots[slot] = DELETED_SLOT;
+    --store->checkpointIndex.nLive;
+    store->freeCheckpoints[store->nFreeCheckpoints++] = entry;
+}
+
+static bool putCheckpoint(fmi4cCheckpointStore *store, const void *key, double time, const void *data, size_t size)
+{
+    if(!growCheckpointIndex(store)) {
+        return false;
+    }
+    size_t nChunks = (size+CHUNK_SIZE-1)/CHUNK_SIZE;
+    int32_t *chunks = malloc((nChunks > 0 ? nChunks : 1)*sizeof(int32_t));
+    if(chunks == NULL) {
+        return false;
+    }
+    // Add the new chunks before releasing the ones of a replaced checkpoint, so that shared chunks are kept
+    for(size_t i=0; i<nChunks; ++i) {
+        size_t offset = i*CHUNK_SIZE;
+        size_t chunkSize = size-offset < CHUNK_SIZE ? size-offset : CHUNK_SIZE;
+        chunks[i] = addChunk(store, (const unsigned char*)data+offset, (uint32_t)chunkSize);
+        if(chunks[i] < 0) {
+            for(size_t j=0; j<i; ++j) {
+                releaseChunk(store, chunks[j]);
+            }
+            free(chunks);
+            fmi4c_printMessage("Failed to store checkpoint");
+            return false;
+        }
+    }
+
+    size_t slot = findCheckpointSlot(store, key, time);
+    if(store->checkpointIndex.slots[slot] >= 0) {
+        removeCheckpointInSlot(store, slot);
+    }
+    int32_t entry;
+    if(store->nFreeCheckpoints > 0) {
+        entry = store->freeCheckpoints[--store->nFreeCheckpoints];
+    }
+    else {
+        if(store->nCheckpoints == store->checkpointCapacity) {
+            size_t capacity = store->checkpointCapacity > 0 ? 2*store->checkpointCapacity : 64;
+            checkpoint_t *checkpoints = realloc(store->checkpoints, capacity*sizeof(checkpoint_t));
+            int32_t *freeCheckpoints = realloc(store->freeCheckpoints, capacity*sizeof(int32_t));
+            if(checkpoints != NULL) {
+                store->checkpoints = checkpoints;
+            }
+            if(freeCheckpoints != NULL) {
+                store->freeCheckpoints = freeCheckpoints;
+            }
+            if(checkpoints == NULL || freeCheckpoints == NULL) {
+                for(size_t j=0; j<nChunks; ++j) {
+                    releaseChunk(store, chunks[j]);
+                }
+                free(chunks);
+                return false;
+            }
+            store->checkpointCapacity = capacity;
+        }
+        entry = (int32_t)store->nCheckpoints++;
+    }
+    checkpoint_t *checkpoint = &store->checkpoints[entry];
+    checkpoint->key = key;
+    checkpoint->time = time;
+    checkpoint->size = size;
+    checkpoint->nChunks = nChunks;
+    checkpoint->chunks = chunks;
+    slot = findCheckpointSlot(store, key, time);
+    if(store->checkpointIndex.slots[slot] == EMPTY_SLOT) {
+        ++store->checkpointIndex.nUsed;
+    }
+    store->checkpointIndex.slots[slot] = entry;
+    ++store->checkpointIndex.nLive;
+    ++store->statistics.numberOfCheckpoints;
+    store->statistics.checkpointBytes += size;
+    return true;
+}
+
+//! @brief Stores a copy of a byte blob, replacing any checkpoint with the same key and time
+bool fmi4c_putCheckpoint(fmi4cCheckpointStore *store, const void *key, double time, const void *data, size_t size)
+{
+    fmi4c_mutexLock(&store->mutex);
+    bool ok = putCheckpoint(store, key, time, data, size);
+    fmi4c_mutexUnlock(&store->mutex);
+    return ok;
+}
+
+//! @brief Returns the size of a checkpoint in bytes, or 0 if there is no such checkpoint
+size_t fmi4c_getCheckpointSize(fmi4cCheckpointStore *store, const void *key, double time)
+{
+    fmi4c_mutexLock(&store->mutex);
+    int32_t entry = store->checkpointIndex.slots[findCheckpointSlot(store, key, time)];
+    size_t size = entry >= 0 ? store->checkpoints[entry].size : 0;
+    fmi4c_mutexUnlock(&store->mutex);
+    return size;
+}
+
+static bool getCheckpoint(fmi4cCheckpointStore *store, const void *key, double time, void *data, size_t size)
+{
+    int32_t entry = store->checkpointIndex.slots[findCheckpointSlot(store, key, time)];
+    if(entry < 0 || store->checkpoints[entry].size > size) {
+        return false;
+    }
+    checkpoint_t *checkpoint = &store->checkpoints[entry];
+    unsigned char *output = data;
+    for(size_t i=0; i<checkpoint->nChunks; ++i) {
+        chunk_t *chunk = &store->chunks[checkpoint->chunks[i]];
+        if(!decodeChunk(store, chunk, output)) {
+            return false;
+        }
+        output += chunk->rawSize;
+    }
+    return true;
+}
+
+//! @brief Copies a checkpoint into data, which must hold at least fmi4c_getCheckpointSize() bytes
+//! @returns False if there is no such checkpoint or it could not be read
+bool fmi4c_getCheckpoint(fmi4cCheckpointStore *store, const void *key, double time, void *data, size_t size)
+{
+    fmi4c_mutexLock(&store->mutex);
+    bool ok = getCheckpoint(store, key, time, data, size);
+    fmi4c_mutexUnlock(&store->mutex);
+    return ok;
+}
+
+bool fmi4c_removeCheckpoint(fmi4cCheckpointStore *store, const void *key, double time)
+{
+    fmi4c_mutexLock(&store->mutex);
+    size_t slot = findCheckpointSlot(store, key, time);
+    bool found = store->checkpointIndex.slots[slot] >= 0;
+    if(found) {
+        removeCheckpointInSlot(store, slot);
+    }
+    fmi4c_mutexUnlock(&store->mutex);
+    return found;
+}
+
+//! @brief Removes all checkpoints of a key with times in [fromTime, toTime], e.g. the ones after a rollback
+//! @param key Key of the checkpoints, or NULL for all keys
+//! @returns Number of removed checkpoints
+size_t fmi4c_removeCheckpoints(fmi4cCheckpointStore *store, const void *key, double fromTime, double toTime)
+{
+    size_t nRemoved = 0;
+    fmi4c_mutexLock(&store->mutex);
+    for(size_t slot=0; slot<store->checkpointIndex.capacity; ++slot) {
+        int32_t entry = store->checkpointIndex.slots[slot];
+        if(entry < 0) {
+            continue;
+        }
+        checkpoint_t *checkpoint = &store->checkpoints[entry];
+        if((key == NULL || checkpoint->key == key) && checkpoint->time >= fromTime && checkpoint->time <= toTime) {
+            removeCheckpointInSlot(store, slot);
+            ++nRemoved;
+        }
+    }
+    fmi4c_mutexUnlock(&store->mutex);
+    return nRemoved;
+}
+
+//! @brief Serializes the current FMU state of an instance into a checkpoint keyed by the instance and time
+bool fmi4c_saveCheckpointFmi2(fmi4cCheckpointStore *store, fmi2InstanceHandle *instance, double time)
+{
+    fmi2FMUstate state = NULL;
+    size_t size = 0;
+    if(fmi2_getFMUstate(instance, &state) > fmi2Warning ||
+       fmi2_serializedFMUstateSize(instance, state, &size) > fmi2Warning) {
+        fmi4c_printMessage("Failed to get FMU state for checkpoint");
+        return false;
+    }
+    fmi2Byte *data = malloc(size > 0 ? size : 1);
+    bool ok = data != NULL && fmi2_serializeFMUstate(instance, state, data, size) <= fmi2Warning &&
+              fmi4c_putCheckpoint(store, instance, time, data, size);
+    free(data);
+    fmi2_freeFMUstate(instance, &state);
+    return ok;
+}
+
+//! @brief Restores the FMU state of an instance from its checkpoint at the specified time
+bool fmi4c_restoreCheckpointFmi2(fmi4cCheckpointStore *store, fmi2InstanceHandle *instance, double time)
+{
+    size_t size = fmi4c_getCheckpointSize(store, instance, time);
+    fmi2Byte *data = malloc(size > 0 ? size : 1);
+    if(data == NULL || !fmi4c_getCheckpoint(store, instance, time, data, size)) {
+        free(data);
+        return false;
+    }
+    fmi2FMUstate state = NULL;
+    bool ok = fmi2_deSerializeFMUstate(instance, data, size, &state) <= fmi2Warning &&
+              fmi2_setFMUstate(instance, state) <= fmi2Warning;
+    if(state != NULL) {
+        fmi2_freeFMUstate(instance, &state);
+    }
+    free(data);
+    return ok;
+}
+
+bool fmi4c_saveCheckpointFmi3(fmi4cCheckpointStore *store, fmi3InstanceHandle *instance, double time)
+{
+    fmi3FMUState state = NULL;
+    size_t size = 0;
+    if(fmi3_getFMUState(instance, &state) > fmi3Warning ||
+       fmi3_serializedFMUStateSize(instance, state, &size) > fmi3Warning) {
+        fmi4c_printMessage("Failed to get FMU state for checkpoint");
+        return false;
+    }
+    fmi3Byte *data = malloc(size > 0 ? size : 1);
+    bool ok = data != NULL && fmi3_serializeFMUState(instance, state, data, size) <= fmi3Warning &&
+              fmi4c_putCheckpoint(store, instance, time, data, size);
+    free(data);
+    fmi3_freeFMUState(instance, &state);
+    return ok;
+}
+
+bool fmi4c_restoreCheckpointFmi3(fmi4cCheckpointStore *store, fmi3InstanceHandle *instance, double time)
+{
+    size_t size = fmi4c_getCheckpointSize(store, instance, time);
+    fmi3Byte *data = malloc(size > 0 ? size : 1);
+    if(data == NULL || !fmi4c_getCheckpoint(store, instance, time, data, size)) {
+        free(data);
+        return false;
+    }
+    fmi3FMUState state = NULL;
+    bool ok = fmi3_deserializeFMUState(instance, data, size, &state) <= fmi3Warning &&
+              fmi3_setFMUState(instance, state) <= fmi3Warning;
+    if(state != NULL) {
+        fmi3_freeFMUState(instance, &state);
+    }
+    free(data);
+    return ok;
+}
+
+void fmi4c_getCheckpointStatistics(fmi4cCheckpointStore *store, fmi4cCheckpointStatistics *statistics)
+{
+    fmi4c_mutexLock(&store->mutex);
+    *statistics = store->statistics;
+    statistics->spillFileBytes = store->spillEnd;
+    statistics->indexSlots = store->chunkIndex.capacity+store->checkpointIndex.capacity;
+    fmi4c_mutexUnlock(&store->mutex);
+}
@@ -0,0 +1,102 @@
+#include "fmi4c_deque.h"
+#include "fmi4c_threads.h"
+
+#include <stdlib.h>
+
+struct fmi4cDeque {
+    volatile size_t top;            // Next task to steal
+    char padding[64];               // Keeps top and bottom on separate cache lines
+    volatile size_t bottom;         // Next free slot, only written by the owner
+    size_t capacity;                // Power of two
+    size_t mask;
+    volatile size_t *tasks;
+};
+
+//! @brief Creates an empty deque that can hold at least the specified number of tasks
+fmi4cDeque *fmi4c_createDeque(size_t capacity)
+{
+    fmi4cDeque *deque = calloc(1, sizeof(fmi4cDeque));
+    if(deque == NULL) {
+        return NULL;
+    }
+    deque->capacity = 16;
+    while(deque->capacity < capacity) {
+        deque->capacity *= 2;
+    }
+    deque->mask = deque->capacity-1;
+    deque->tasks = calloc(deque->capacity, sizeof(size_t));
+    if(deque->tasks == NULL) {
+        free(deque);
+        return NULL;
+    }
+    return deque;
+}
+
+void fmi4c_freeDeque(fmi4cDeque *deque)
+{
+    if(deque == NULL) {
+        return;
+    }
+    free((void*)deque->tasks);
+    free(deque);
+}
+
+//! @brief Removes all tasks, must not be called while other workers may steal
+void fmi4c_clearDeque(fmi4cDeque *deque)
+{
+    fmi4c_atomicStoreRelease(&deque->top, 0);
+    fmi4c_atomicStoreRelease(&deque->bottom, 0);
+}
+
+//! @brief Owner: pushes a task at the bottom
+//! @returns False if the deque is full
+bool fmi4c_pushDeque(fmi4cDeque *deque, int task)
+{
+    size_t bottom = deque->bottom;
+    if(bottom-fmi4c_atomicLoadAcquire(&deque->top) >= deque->capacity) {
+        return false;
+    }
+    fmi4c_atomicStoreRelease(&deque->tasks[bottom & deque->mask], (size_t)task);
+    fmi4c_atomicStoreRelease(&deque->bottom, bottom+1);
+    return true;
+}
+
+//! @brief Owner: pops the most recently pushed task
+//! @returns False if the deque is empty
+bool fmi4c_popDeque(fmi4cDeque *deque, int *task)
+{
+    size_t bottom = deque->bottom-1;
+    fmi4c_atomicStoreRelease(&deque->bottom, bottom);
+    fmi4c_atomicFence();
+    size_t top = fmi4c_atomicLoadAcquire(&deque->top);
+    if((ptrdiff_t)(bottom-top) < 0) {
+        fmi4c_atomicStoreRelease(&deque->bottom, top);
+        return false;
+    }
+    *task = (int)fmi4c_atomicLoadAcquire(&deque->tasks[bottom & deque->mask]);
+    if(bottom != top) {
+        return true;
+    }
+
+    // Last task, race against thieves for it
+    bool won = fmi4c_atomicCompareExchange(&deque->top, top, top+1);
+    fmi4c_atomicStoreRelease(&deque->bottom, top+1);
+    return won;
+}
+
+//! @brief Thief: steals the least recently pushed task
+fmi4cDequeResult fmi4c_stealDeque(fmi4cDeque *deque, int *task)
+{
+    size_t top = fmi4c_atomicLoadAcquire(&deque->top);
+    fmi4c_atomicFence();
+    size_t bottom = fmi4c_atomicLoadAcquire(&deque->bottom);
+    if((ptrdiff_t)(bottom-top) <= 0) {
+        return fmi4cDequeEmpty;
+    }
+    int value = (int)fmi4c_atomicLoadAcquire(&deque->tasks[top & deque->mask]);
+    if(!fmi4c_atomicCompareExchange(&deque->top, top, top+1)) {
+        return fmi4cDequeAbort;
+    }
+    *task = value;
+    return fmi4cDequeSuccess;
+}
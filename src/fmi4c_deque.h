@@ -0,0 +1,28 @@
+#ifndef FMIC_DEQUE_H
+#define FMIC_DEQUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Work-stealing deque (Chase-Lev)
+//
+// The owning worker pushes and pops tasks at the bottom without locking, other workers steal from
+// the top with a compare-and-swap. Only the last remaining task can be contended between the owner
+// and a thief. The capacity is fixed when the deque is created, tasks are non-negative integers.
+
+typedef struct fmi4cDeque fmi4cDeque;
+
+typedef enum {
+    fmi4cDequeSuccess,
+    fmi4cDequeEmpty,
+    fmi4cDequeAbort         // Lost a race with another thief or the owner, the deque may not be empty
+} fmi4cDequeResult;
+
+fmi4cDeque *fmi4c_createDeque(size_t capacity);
+void fmi4c_freeDeque(fmi4cDeque *deque);
+void fmi4c_clearDeque(fmi4cDeque *deque);
+bool fmi4c_pushDeque(fmi4cDeque *deque, int task);
+bool fmi4c_popDeque(fmi4cDeque *deque, int *task);
+fmi4cDequeResult fmi4c_stealDeque(fmi4cDeque *deque, int *task);
+
+#endif // FMIC_DEQUE_H
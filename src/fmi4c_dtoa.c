@@ -0,0 +1,316 @@
+#include "fmi4c_dtoa.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#define DTOA_SIGNIFICAND_SIZE 52
+#define DTOA_EXPONENT_BIAS 1075     // Exponent bias plus significand size
+#define DTOA_HIDDEN_BIT UINT64_C(0x0010000000000000)
+#define DTOA_SIGNIFICAND_MASK UINT64_C(0x000FFFFFFFFFFFFF)
+#define DTOA_EXPONENT_MASK UINT64_C(0x7FF0000000000000)
+#define DTOA_SIGN_MASK UINT64_C(0x8000000000000000)
+#define DTOA_MAX_FIXED_DIGITS 21    // Larger decimal exponents use scientific notation
+
+//! @brief Floating-point number f * 2^e with a 64-bit significand
+typedef struct {
+    uint64_t f;
+    int e;
+} diyFp;
+
+// Normalized 64-bit approximations of 10^k for k = -348, -340, ..., 340
+static const uint64_t cachedPowersF[] = {
+    UINT64_C(0xfa8fd5a0081c0288), UINT64_C(0xbaaee17fa23ebf76), UINT64_C(0x8b16fb203055ac76), UINT64_C(0xcf42894a5dce35ea),
+    UINT64_C(0x9a6bb0aa55653b2d), UINT64_C(0xe61acf033d1a45df), UINT64_C(0xab70fe17c79ac6ca), UINT64_C(0xff77b1fcbebcdc4f),
+    UINT64_C(0xbe5691ef416bd60c), UINT64_C(0x8dd01fad907ffc3c), UINT64_C(0xd3515c2831559a83), UINT64_C(0x9d71ac8fada6c9b5),
+    UINT64_C(0xea9c227723ee8bcb), UINT64_C(0xaecc49914078536d), UINT64_C(0x823c12795db6ce57), UINT64_C(0xc21094364dfb5637),
+    UINT64_C(0x9096ea6f3848984f), UINT64_C(0xd77485cb25823ac7), UINT64_C(0xa086cfcd97bf97f4), UINT64_C(0xef340a98172aace5),
+    UINT64_C(0xb23867fb2a35b28e), UINT64_C(0x84c8d4dfd2c63f3b), UINT64_C(0xc5dd44271ad3cdba), UINT64_C(0x936b9fcebb25c996),
+    UINT64_C(0xdbac6c247d62a584), UINT64_C(0xa3ab66580d5fdaf6), UINT64_C(0xf3e2f893dec3f126), UINT64_C(0xb5b5ada8aaff80b8),
+    UINT64_C(0x87625f056c7c4a8b), UINT64_C(0xc9bcff6034c13053), UINT64_C(0x964e858c91ba2655), UINT64_C(0xdff9772470297ebd),
+    UINT64_C(0xa6dfbd9fb8e5b88f), UINT64_C(0xf8a95fcf88747d94), UINT64_C(0xb94470938fa89bcf), UINT64_C(0x8a08f0f8bf0f156b),
+    UINT64_C(0xcdb02555653131b6), UINT64_C(0x993fe2c6d07b7fac), UINT64_C(0xe45c10c42a2b3b06), UINT64_C(0xaa242499697392d3),
+    UINT64_C(0xfd87b5f28300ca0e), UINT64_C(0xbce5086492111aeb), UINT64_C(0x8cbccc096f5088cc), UINT64_C(0xd1b71758e219652c),
+    UINT64_C(0x9c40000000000000), UINT64_C(0xe8d4a51000000000), UINT64_C(0xad78ebc5ac620000), UINT64_C(0x813f3978f8940984),
+    UINT64_C(0xc097ce7bc90715b3), UINT64_C(0x8f7e32ce7bea5c70), UINT64_C(0xd5d238a4abe98068), UINT64_C(0x9f4f2726179a2245),
+    UINT64_C(0xed63a231d4c4fb27), UINT64_C(0xb0de65388cc8ada8), UINT64_C(0x83c7088e1aab65db), UINT64_C(0xc45d1df942711d9a),
+    UINT64_C(0x924d692ca61be758), UINT64_C(0xda01ee641a708dea), UINT64_C(0xa26da3999aef774a), UINT64_C(0xf209787bb47d6b85),
+    UINT64_C(0xb454e4a179dd1877), UINT64_C(0x865b86925b9bc5c2), UINT64_C(0xc83553c5c8965d3d), UINT64_C(0x952ab45cfa97a0b3),
+    UINT64_C(0xde469fbd99a05fe3), UINT64_C(0xa59bc234db398c25), UINT64_C(0xf6c69a72a3989f5c), UINT64_C(0xb7dcbf5354e9bece),
+    UINT64_C(0x88fcf317f22241e2), UINT64_C(0xcc20ce9bd35c78a5), UINT64_C(0x98165af37b2153df), UINT64_C(0xe2a0b5dc971f303a),
+    UINT64_C(0xa8d9d1535ce3b396), UINT64_C(0xfb9b7cd9a4a7443c), UINT64_C(0xbb764c4ca7a44410), UINT64_C(0x8bab8eefb6409c1a),
+    UINT64_C(0xd01fef10a657842c), UINT64_C(0x9b10a4e5e9913129), UINT64_C(0xe7109bfba19c0c9d), UINT64_C(0xac2820d9623bf429),
+    UINT64_C(0x80444b5e7aa7cf85), UINT64_C(0xbf21e44003acdd2d), UINT64_C(0x8e679c2f5e44ff8f), UINT64_C(0xd433179d9c8cb841),
+    UINT64_C(0x9e19db92b4e31ba9), UINT64_C(0xeb96bf6ebadf77d9), UINT64_C(0xaf87023b9bf0ee6b)
+};
+
+static const int16_t cachedPowersE[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980, -954, -927,
+    -901, -874, -847, -821, -794, -768, -741, -715, -688, -661, -635, -608,
+    -582, -555, -529, -502, -475, -449, -422, -396, -369, -343, -316, -289,
+    -263, -236, -210, -183, -157, -130, -103, -77, -50, -24, 3, 30,
+    56, 83, 109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614, 641, 667,
+    694, 720, 747, 774, 800, 827, 853, 880, 907, 933, 960, 986,
+    1013, 1039, 1066
+};
+
+static const uint64_t powersOfTen[] = {
+    UINT64_C(1), UINT64_C(10), UINT64_C(100), UINT64_C(1000), UINT64_C(10000),
+    UINT64_C(100000), UINT64_C(1000000), UINT64_C(10000000), UINT64_C(100000000), UINT64_C(1000000000),
+    UINT64_C(10000000000), UINT64_C(100000000000), UINT64_C(1000000000000), UINT64_C(10000000000000), UINT64_C(100000000000000),
+    UINT64_C(1000000000000000), UINT64_C(10000000000000000), UINT64_C(100000000000000000), UINT64_C(1000000000000000000), UINT64_C(10000000000000000000)
+};
+
+static diyFp multiply(diyFp x, diyFp y)
+{
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 product = (unsigned __int128)x.f*y.f;
+    uint64_t high = (uint64_t)(product >> 64);
+    high += (uint64_t)(product >> 63) & 1;      // Round to nearest
+    diyFp result = { high, x.e + y.e + 64 };
+    return result;
+#else
+    const uint64_t mask32 = UINT64_C(0xFFFFFFFF);
+    uint64_t a = x.f >> 32;
+    uint64_t b = x.f & mask32;
+    uint64_t c = y.f >> 32;
+    uint64_t d = y.f & mask32;
+    uint64_t ac = a*c;
+    uint64_t bc = b*c;
+    uint64_t ad = a*d;
+    uint64_t bd = b*d;
+    uint64_t tmp = (bd >> 32) + (ad & mask32) + (bc & mask32);
+    tmp += UINT64_C(1) << 31;   // Round to nearest
+    diyFp result = { ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), x.e + y.e + 64 };
+    return result;
+#endif
+}
+
+static diyFp normalize(diyFp x)
+{
+    while(!(x.f & DTOA_SIGN_MASK)) {
+        x.f <<= 1;
+        --x.e;
+    }
+    return x;
+}
+
+//! @brief Computes the boundaries halfway to the neighbouring doubles, with the exponent of the upper boundary
+static void getBoundaries(diyFp v, diyFp *minus, diyFp *plus)
+{
+    diyFp upper = { (v.f << 1) + 1, v.e - 1 };
+    while(!(upper.f & (DTOA_HIDDEN_BIT << 1))) {
+        upper.f <<= 1;
+        --upper.e;
+    }
+    upper.f <<= 64 - DTOA_SIGNIFICAND_SIZE - 2;
+    upper.e -= 64 - DTOA_SIGNIFICAND_SIZE - 2;
+
+    // The lower neighbour is closer if v is a power of two
+    diyFp lower;
+    if(v.f == DTOA_HIDDEN_BIT) {
+        lower.f = (v.f << 2) - 1;
+        lower.e = v.e - 2;
+    }
+    else {
+        lower.f = (v.f << 1) - 1;
+        lower.e = v.e - 1;
+    }
+    lower.f <<= lower.e - upper.e;
+    lower.e = upper.e;
+    *minus = lower;
+    *plus = upper;
+}
+
+//! @brief Returns a cached power of ten c = 10^-k such that the exponent of e * c is in [-60, -32]
+static diyFp getCachedPower(int e, int *k)
+{
+    double dk = (-61 - e)*0.30102999566398114 + 347;    // log10(2)
+    int ik = (int)dk;
+    if(dk - ik > 0.0) {
+        ++ik;
+    }
+    int index = (ik >> 3) + 1;
+    *k = -(-348 + index*8);
+    diyFp result = { cachedPowersF[index], cachedPowersE[index] };
+    return result;
+}
+
+//! @brief Moves the last digit closer to the exact value while it stays within the rounding interval
+static void roundWeed(char *digits, int length, uint64_t delta, uint64_t rest, uint64_t tenKappa, uint64_t distance)
+{
+    while(rest < distance && delta - rest >= tenKappa &&
+          (rest + tenKappa < distance || distance - rest > rest + tenKappa - distance)) {
+        --digits[length - 1];
+        rest += tenKappa;
+    }
+}
+
+static int countDigits(uint32_t n)
+{
+    int count = 1;
+    while(count < 10 && n >= powersOfTen[count]) {
+        ++count;
+    }
+    return count;
+}
+
+//! @brief Generates the digits of a number in the interval [plus - delta, plus]
+static int generateDigits(diyFp w, diyFp plus, uint64_t delta, char *digits, int *k)
+{
+    diyFp one = { UINT64_C(1) << -plus.e, plus.e };
+    uint64_t distance = plus.f - w.f;
+    uint32_t integral = (uint32_t)(plus.f >> -one.e);
+    uint64_t fractional = plus.f & (one.f - 1);
+    int kappa = countDigits(integral);
+    int length = 0;
+
+    while(kappa > 0) {
+        uint32_t divisor = (uint32_t)powersOfTen[kappa - 1];
+        uint32_t digit = integral/divisor;
+        integral %= divisor;
+        if(digit != 0 || length != 0) {
+            digits[length++] = (char)('0' + digit);
+        }
+        --kappa;
+        uint64_t rest = ((uint64_t)integral << -one.e) + fractional;
+        if(rest <= delta) {
+            *k += kappa;
+            roundWeed(digits, length, delta, rest, powersOfTen[kappa] << -one.e, distance);
+            return length;
+        }
+    }
+
+    while(true) {
+        fractional *= 10;
+        delta *= 10;
+        char digit = (char)(fractional >> -one.e);
+        if(digit != 0 || length != 0) {
+            digits[length++] = (char)('0' + digit);
+        }
+        fractional &= one.f - 1;
+        --kappa;
+        if(fractional < delta) {
+            *k += kappa;
+            int index = -kappa;
+            roundWeed(digits, length, delta, fractional, one.f, index < 20 ? distance*powersOfTen[index] : 0);
+            return length;
+        }
+    }
+}
+
+static char *writeExponent(int exponent, char *buffer)
+{
+    if(exponent < 0) {
+        *buffer++ = '-';
+        exponent = -exponent;
+    }
+    if(exponent >= 100) {
+        *buffer++ = (char)('0' + exponent/100);
+        exponent %= 100;
+        *buffer++ = (char)('0' + exponent/10);
+    }
+    else if(exponent >= 10) {
+        *buffer++ = (char)('0' + exponent/10);
+    }
+    *buffer++ = (char)('0' + exponent%10);
+    return buffer;
+}
+
+//! @brief Places the decimal point in the digits, or switches to scientific notation for large and small numbers
+//! @param k Decimal exponent of the last digit
+static char *formatDigits(char *digits, int length, int k, char *buffer)
+{
+    int point = length + k;     // Position of the decimal point, counted from the first digit
+    if(k >= 0 && point <= DTOA_MAX_FIXED_DIGITS) {
+        // Integer, e.g. 1500
+        memmove(buffer, digits, (size_t)length);
+        memset(buffer + length, '0', (size_t)k);
+        return buffer + point;
+    }
+    if(point > 0 && point <= DTOA_MAX_FIXED_DIGITS) {
+        // Decimal point within the digits, e.g. 1.5
+        memmove(buffer, digits, (size_t)point);
+        buffer[point] = '.';
+        memmove(buffer + point + 1, digits + point, (size_t)(length - point));
+        return buffer + length + 1;
+    }
+    if(point > -6 && point <= 0) {
+        // Leading zeros, e.g. 0.0015
+        int zeros = -point;
+        memmove(buffer + 2 + zeros, digits, (size_t)length);
+        buffer[0] = '0';
+        buffer[1] = '.';
+        memset(buffer + 2, '0', (size_t)zeros);
+        return buffer + 2 + zeros + length;
+    }
+    // Scientific notation, e.g. 1.5e-7
+    buffer[0] = digits[0];
+    char *end = buffer + 1;
+    if(length > 1) {
+        memmove(buffer + 2, digits + 1, (size_t)(length - 1));
+        buffer[1] = '.';
+        end = buffer + length + 1;
+    }
+    *end++ = 'e';
+    return writeExponent(point - 1, end);
+}
+
+//! @brief Writes the shortest decimal representation of a value that reads back to the same value
+//! Non-finite values are written as "nan", "inf" and "-inf".
+//! @param buffer At least FMI4C_DTOA_BUFFER_SIZE characters, receives the null-terminated text
+//! @returns Number of characters, excluding the null termination
+size_t fmi4c_formatDouble(double value, char *buffer)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    char *start = buffer;
+    if(bits & DTOA_SIGN_MASK) {
+        *buffer++ = '-';
+    }
+    uint64_t significand = bits & DTOA_SIGNIFICAND_MASK;
+    int biasedExponent = (int)((bits & DTOA_EXPONENT_MASK) >> DTOA_SIGNIFICAND_SIZE);
+    char *end;
+    if(biasedExponent == 0x7FF) {
+        if(significand != 0) {
+            buffer = start;     // NaN, regardless of sign
+            memcpy(buffer, "nan", 3);
+        }
+        else {
+            memcpy(buffer, "inf", 3);
+        }
+        end = buffer + 3;
+    }
+    else if(biasedExponent == 0 && significand == 0) {
+        *buffer = '0';
+        end = buffer + 1;
+    }
+    else {
+        diyFp v;
+        if(biasedExponent != 0) {
+            v.f = significand + DTOA_HIDDEN_BIT;
+            v.e = biasedExponent - DTOA_EXPONENT_BIAS;
+        }
+        else {
+            v.f = significand;      // Subnormal
+            v.e = 1 - DTOA_EXPONENT_BIAS;
+        }
+        diyFp minus, plus;
+        getBoundaries(v, &minus, &plus);
+        int k;
+        diyFp cachedPower = getCachedPower(plus.e, &k);
+        diyFp w = multiply(normalize(v), cachedPower);
+        diyFp upper = multiply(plus, cachedPower);
+        diyFp lower = multiply(minus, cachedPower);
+        ++lower.f;      // Stay within the interval despite the rounding of the multiplication
+        --upper.f;
+
+        // Digits are generated at the end of the buffer, leaving room for the decimal point and leading zeros
+        char *digits = buffer + 8;
+        int length = generateDigits(w, upper, upper.f - lower.f, digits, &k);
+        end = formatDigits(digits, length, k, buffer);
+    }
+    *end = '\0';
+    return (size_t)(end - start);
+}
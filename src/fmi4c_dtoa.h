@@ -0,0 +1,17 @@
+#ifndef FMIC_DTOA_H
+#define FMIC_DTOA_H
+
+#include <stddef.h>
+
+// Locale-independent formatting of doubles with the shortest digits that read back to the same value
+//
+// Digits are generated with the Grisu2 algorithm, using 64-bit integer arithmetic only. The result
+// always reads back (with strtod) to exactly the same double. It is the shortest such representation
+// for nearly all values, in rare cases it has one digit more than necessary. Formatting never
+// depends on the C locale, the decimal separator is always a point.
+
+#define FMI4C_DTOA_BUFFER_SIZE 32   // Room for the longest result and the digits generated while formatting
+
+size_t fmi4c_formatDouble(double value, char *buffer);
+
+#endif // FMIC_DTOA_H
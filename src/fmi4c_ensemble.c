@@ -0,0 +1,257 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE     // For pidfd_open
+#endif
+#include "fmi4c_private.h"
+#define FMI4C_H_INTERNAL_INCLUDE
+#include "fmi4c.h"
+#include "fmi4c_common.h"
+#include "fmi4c_ensemble.h"
+#include "fmi4c_threads.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <poll.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+struct fmi4cEnsemble {
+    void *instance;             // Initialized template instance, owned by the caller
+    int nWorkers;               // Maximum number of concurrent worker processes, 0 = number of processors
+    size_t nResults;            // Result values per sample
+    int nFailed;
+    double meanStartupTime;
+};
+
+//! @brief Per-sample data in the shared memory, followed by the result values of all samples
+typedef struct {
+    double forkTime;            // Written by the parent just before forking
+    double startTime;           // Written by the worker when it starts
+    volatile int32_t succeeded;
+} sampleSlot_t;
+
+typedef struct {
+    pid_t pid;
+    int pidfd;                  // For waiting on several workers at once, -1 if not supported
+    int sample;
+} worker_t;
+
+static fmi4cEnsemble *createEnsemble(void *instance)
+{
+#if defined(__linux__)
+    if(instance == NULL) {
+        return NULL;
+    }
+    fmi4cEnsemble *ensemble = calloc(1, sizeof(fmi4cEnsemble));
+    if(ensemble != NULL) {
+        ensemble->instance = instance;
+    }
+    return ensemble;
+#else
+    UNUSED(instance)
+    fmi4c_printMessage("Fork-based ensembles are only supported on Linux");
+    return NULL;
+#endif
+}
+
+//! @brief Creates an ensemble runner that forks samples from an initialized FMI 2 instance
+//! The instance remains owned by the caller and is not modified by the samples.
+fmi4cEnsemble *fmi4c_createEnsembleFmi2(fmi2InstanceHandle *instance)
+{
+    return createEnsemble(instance);
+}
+
+//! @brief Creates an ensemble runner that forks samples from an initialized FMI 3 instance
+fmi4cEnsemble *fmi4c_createEnsembleFmi3(fmi3InstanceHandle *instance)
+{
+    return createEnsemble(instance);
+}
+
+void fmi4c_freeEnsemble(fmi4cEnsemble *ensemble)
+{
+    free(ensemble);
+}
+
+//! @brief Sets the maximum number of concurrent worker processes (0 = number of processors, default)
+void fmi4c_setEnsembleWorkers(fmi4cEnsemble *ensemble, int nWorkers)
+{
+    ensemble->nWorkers = nWorkers > 0 ? nWorkers : 0;
+}
+
+//! @brief Sets the number of result values each sample writes (default 0)
+void fmi4c_setEnsembleResultSize(fmi4cEnsemble *ensemble, size_t nResults)
+{
+    ensemble->nResults = nResults;
+}
+
+//! @brief Returns the number of failed samples in the last run
+int fmi4c_getEnsembleNumberOfFailedSamples(fmi4cEnsemble *ensemble)
+{
+    return ensemble->nFailed;
+}
+
+//! @brief Returns the mean time in seconds from forking a worker to the start of its sample, in the last run
+double fmi4c_getEnsembleMeanStartupTime(fmi4cEnsemble *ensemble)
+{
+    return ensemble->meanStartupTime;
+}
+
+#if defined(__linux__)
+
+//! @brief Waits until one of the active workers has exited and removes it from the list
+//! Workers are waited on through their pidfds when possible, otherwise in the order they were started.
+//! @returns The sample of the worker, with its exit status in status
+static int waitForWorker(worker_t *workers, int *nActive, int *status)
+{
+    int index = 0;
+    bool pollable = true;
+    struct pollfd fds[*nActive];
+    for(int i=0; i<*nActive; ++i) {
+        pollable = pollable && workers[i].pidfd >= 0;
+        fds[i].fd = workers[i].pidfd;
+        fds[i].events = POLLIN;
+        fds[i].revents = 0;
+    }
+    if(pollable) {
+        while(poll(fds, (nfds_t)*nActive, -1) < 0) {
+            // Interrupted by a signal
+        }
+        while(index < *nActive-1 && fds[index].revents == 0) {
+            ++index;
+        }
+    }
+    worker_t worker = workers[index];
+    while(waitpid(worker.pid, status, 0) < 0) {
+        // Interrupted by a signal
+    }
+    if(worker.pidfd >= 0) {
+        close(worker.pidfd);
+    }
+    workers[index] = workers[--(*nActive)];
+    return worker.sample;
+}
+
+//! @brief Runs all samples, each in a worker process forked from the calling process
+//! @param nSamples Number of samples
+//! @param callback Called in the worker process with the template instance, the sample index and the result array of the sample
+//! @param results Array of nSamples times the result size, receives the results of the succeeded samples (may be NULL if the result size is 0)
+//! @param succeeded Array of nSamples, receives whether each sample succeeded (may be NULL)
+//! @returns False if the samples could not be run, failed samples are only reported through succeeded and fmi4c_getEnsembleNumberOfFailedSamples
+bool fmi4c_runEnsemble(fmi4cEnsemble *ensemble, int nSamples, fmi4cEnsembleSampleCallback callback, void *userData, double *results, bool *succeeded)
+{
+    ensemble->nFailed = 0;
+    ensemble->meanStartupTime = 0;
+    if(nSamples <= 0) {
+        return true;
+    }
+    int nWorkers = ensemble->nWorkers > 0 ? ensemble->nWorkers : fmi4c_getNumberOfProcessors();
+    if(nWorkers > nSamples) {
+        nWorkers = nSamples;
+    }
+
+    size_t nResults = ensemble->nResults;
+    size_t sharedSize = (size_t)nSamples*(sizeof(sampleSlot_t)+nResults*sizeof(double));
+    void *shared = mmap(NULL, sharedSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    worker_t *workers = malloc((size_t)nWorkers*sizeof(worker_t));
+    if(shared == MAP_FAILED || workers == NULL) {
+        fmi4c_printMessage("Failed to allocate shared memory for ensemble");
+        if(shared != MAP_FAILED) {
+            munmap(shared, sharedSize);
+        }
+        free(workers);
+        return false;
+    }
+    sampleSlot_t *slots = shared;
+    double *sharedResults = (double*)(slots+nSamples);
+
+    // Buffered output would otherwise be written once more by every worker
+    fflush(NULL);
+
+    int nActive = 0;
+    int nSucceeded = 0;
+    double startupTime = 0;
+    for(int sample=0; sample<nSamples || nActive > 0;) {
+        if(sample < nSamples && nActive < nWorkers) {
+            slots[sample].forkTime = fmi4c_getWallTime();
+            pid_t pid = fork();
+            if(pid == 0) {
+                prctl(PR_SET_PDEATHSIG, SIGKILL);
+                slots[sample].startTime = fmi4c_getWallTime();
+                bool ok = callback(ensemble->instance, sample, sharedResults+(size_t)sample*nResults, userData);
+                slots[sample].succeeded = ok;
+                fflush(NULL);
+                _exit(ok ? 0 : 1);
+            }
+            if(pid < 0) {
+                if(nActive == 0) {
+                    fmi4c_printMessage("Failed to fork ensemble worker");
+                    ++ensemble->nFailed;
+                    if(succeeded != NULL) {
+                        succeeded[sample] = false;
+                    }
+                    ++sample;
+                }
+                else {
+                    nWorkers = nActive;     // Process limit reached, continue with the workers that are running
+                }
+                continue;
+            }
+            workers[nActive].pid = pid;
+            workers[nActive].pidfd = -1;
+#ifdef SYS_pidfd_open
+            workers[nActive].pidfd = (int)syscall(SYS_pidfd_open, pid, 0);
+#endif
+            workers[nActive].sample = sample;
+            ++nActive;
+            ++sample;
+            continue;
+        }
+
+        int status = 0;
+        int finished = waitForWorker(workers, &nActive, &status);
+        bool ok = WIFEXITED(status) && WEXITSTATUS(status) == 0 && slots[finished].succeeded;
+        if(ok) {
+            ++nSucceeded;
+            startupTime += slots[finished].startTime-slots[finished].forkTime;
+            if(results != NULL) {
+                memcpy(results+(size_t)finished*nResults, sharedResults+(size_t)finished*nResults, nResults*sizeof(double));
+            }
+        }
+        else {
+            ++ensemble->nFailed;
+        }
+        if(succeeded != NULL) {
+            succeeded[finished] = ok;
+        }
+    }
+
+    if(nSucceeded > 0) {
+        ensemble->meanStartupTime = startupTime/nSucceeded;
+    }
+    free(workers);
+    munmap(shared, sharedSize);
+    return true;
+}
+
+#else
+
+bool fmi4c_runEnsemble(fmi4cEnsemble *ensemble, int nSamples, fmi4cEnsembleSampleCallback callback, void *userData, double *results, bool *succeeded)
+{
+    UNUSED(ensemble)
+    UNUSED(nSamples)
+    UNUSED(callback)
+    UNUSED(userData)
+    UNUSED(results)
+    UNUSED(succeeded)
+    fmi4c_printMessage("Fork-based ensembles are only supported on Linux");
+    return false;
+}
+
+#endif
@@ -0,0 +1,749 @@
+#include "fmi4c_private.h"
+#define FMI4C_H_INTERNAL_INCLUDE
+#include "fmi4c.h"
+#include "fmi4c_common.h"
+#include "fmi4c_input.h"
+#include "fmi4c_threads.h"
+
+#include <locale.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INPUT_CHUNK_SIZE (256 << 10)    // Bytes of values per chunk
+#define INPUT_MIN_CHUNK_ROWS 4
+#define INPUT_READ_SIZE (64 << 10)      // Bytes read from CSV files at a time, grows for longer lines
+#define MAT4_HEADER_SIZE 20             // Five 32-bit integers: type, rows, columns, imaginary flag, name length
+#define MAT4_TEXT_TYPE 51               // Text stored as bytes
+#define MAT4_MAX_NAME_LENGTH 64
+#define NO_CHUNK SIZE_MAX
+
+#ifdef _MSC_VER
+#define RESTRICT __restrict
+#else
+#define RESTRICT restrict
+#endif
+
+struct fmi4cInputSignals {
+    FILE *file;
+    bool binary;                        // MAT-file, otherwise CSV
+    bool failed;
+    size_t nColumns;                    // Time and signals
+    char **names;                       // Signal names, without time
+    size_t chunkRows;                   // Rows per chunk
+    int64_t *chunkOffsets;              // File position of each chunk found so far
+    double *chunkTimes;                 // Time of the first row of each chunk, NAN if not read yet
+    size_t nChunks;
+    size_t chunkCapacity;
+    bool complete;                      // All chunks have been found (the last one may be partial)
+    size_t nRows;                       // Total number of rows, when complete
+    double *slots[2];                   // Resident chunks, chunk c is kept in slot c%2
+    size_t slotChunks[2];
+    size_t slotRows[2];
+    size_t cursor;                      // Row found by the last lookup, shared by all signals
+    fmi4cInterpolationMethod method;
+    fmi4cMutex_t mutex;
+
+    // CSV reading
+    char *buffer;
+    size_t bufferSize;
+    size_t bufferStart;                 // First character not yet read
+    size_t bufferEnd;
+    int64_t bufferOffset;               // File position of the first character in the buffer
+    bool endOfFile;
+    char decimalPoint;                  // Of the current C locale, which strtod expects
+};
+
+static bool seekFile(FILE *file, int64_t offset)
+{
+#ifdef _WIN32
+    return _fseeki64(file, offset, SEEK_SET) == 0;
+#else
+    return fseek(file, (long)offset, SEEK_SET) == 0;
+#endif
+}
+
+static bool isBigEndian(void)
+{
+    const uint16_t word = 1;
+    return *(const unsigned char*)&word == 0;
+}
+
+static bool addChunk(fmi4cInputSignals *signals, int64_t offset)
+{
+    if(signals->nChunks == signals->chunkCapacity) {
+        size_t capacity = signals->chunkCapacity > 0 ? 2*signals->chunkCapacity : 64;
+        int64_t *offsets = realloc(signals->chunkOffsets, capacity*sizeof(int64_t));
+        if(offsets != NULL) {
+            signals->chunkOffsets = offsets;
+        }
+        double *times = realloc(signals->chunkTimes, capacity*sizeof(double));
+        if(times != NULL) {
+            signals->chunkTimes = times;
+        }
+        if(offsets == NULL || times == NULL) {
+            return false;
+        }
+        signals->chunkCapacity = capacity;
+    }
+    signals->chunkOffsets[signals->nChunks] = offset;
+    signals->chunkTimes[signals->nChunks] = NAN;
+    ++signals->nChunks;
+    return true;
+}
+
+//! @brief Returns the next line of a CSV file (null terminated, without line break), or NULL at the end of the file
+static char *readLine(fmi4cInputSignals *signals)
+{
+    while(true) {
+        char *start = signals->buffer+signals->bufferStart;
+        size_t available = signals->bufferEnd-signals->bufferStart;
+        char *newline = memchr(start, '\n', available);
+        if(newline != NULL || (signals->endOfFile && available > 0)) {
+            size_t length = (newline != NULL) ? (size_t)(newline-start) : available;
+            signals->bufferStart += (newline != NULL) ? length+1 : length;
+            start[length] = '\0';       // The buffer always has room for one more character
+            if(length > 0 && start[length-1] == '\r') {
+                start[length-1] = '\0';
+            }
+            return start;
+        }
+        if(signals->endOfFile) {
+            return NULL;
+        }
+
+        // Move the incomplete line to the beginning of the buffer, and grow the buffer if the line fills it
+        memmove(signals->buffer, start, available);
+        signals->bufferOffset += (int64_t)signals->bufferStart;
+        signals->bufferStart = 0;
+        signals->bufferEnd = available;
+        if(available+1 >= signals->bufferSize) {
+            char *buffer = realloc(signals->buffer, 2*signals->bufferSize);
+            if(buffer == NULL) {
+                fmi4c_printMessage("Failed to allocate memory for input file line");
+                signals->failed = true;
+                return NULL;
+            }
+            signals->buffer = buffer;
+            signals->bufferSize *= 2;
+        }
+        size_t nRead = fread(signals->buffer+available, 1, signals->bufferSize-available-1, signals->file);
+        signals->bufferEnd += nRead;
+        if(nRead == 0) {
+            if(ferror(signals->file)) {
+                fmi4c_printMessage("Failed to read input file");
+                signals->failed = true;
+                return NULL;
+            }
+            signals->endOfFile = true;
+        }
+    }
+}
+
+//! @brief Continues reading a CSV file at the specified position
+static bool seekCsv(fmi4cInputSignals *signals, int64_t offset)
+{
+    if(offset == signals->bufferOffset+(int64_t)signals->bufferStart) {
+        return true;    // Reading sequentially
+    }
+    signals->bufferOffset = offset;
+    signals->bufferStart = 0;
+    signals->bufferEnd = 0;
+    signals->endOfFile = false;
+    clearerr(signals->file);
+    return seekFile(signals->file, offset);
+}
+
+//! @brief Parses one line of comma separated values
+static bool parseRow(fmi4cInputSignals *signals, char *line, double *row)
+{
+    char *field = line;
+    for(size_t i=0; i<signals->nColumns; ++i) {
+        if(signals->decimalPoint != '.') {
+            for(char *c = field; *c != '\0' && *c != ','; ++c) {
+                if(*c == '.') {
+                    *c = signals->decimalPoint;
+                }
+            }
+        }
+        char *end;
+        row[i] = strtod(field, &end);
+        if(end == field) {
+            return false;
+        }
+        while(*end == ' ' || *end == '\t') {
+            ++end;
+        }
+        if(i+1 < signals->nColumns) {
+            if(*end != ',') {
+                return false;
+            }
+            field = end+1;
+        }
+    }
+    return true;
+}
+
+//! @brief Reads a chunk of rows into its slot
+//! Reading the last chunk found so far of a CSV file also finds the next chunk, or the end of the file.
+//! @returns False if the chunk is empty or could not be read
+static bool loadChunk(fmi4cInputSignals *signals, size_t chunk)
+{
+    size_t slot = chunk%2;
+    double *rows = signals->slots[slot];
+    size_t nRows = 0;
+    signals->slotChunks[slot] = NO_CHUNK;
+    if(signals->binary) {
+        nRows = signals->nRows-chunk*signals->chunkRows;
+        nRows = nRows < signals->chunkRows ? nRows : signals->chunkRows;
+        if(!seekFile(signals->file, signals->chunkOffsets[chunk]) ||
+           fread(rows, signals->nColumns*sizeof(double), nRows, signals->file) != nRows) {
+            fmi4c_printMessage("Failed to read input file");
+            signals->failed = true;
+            return false;
+        }
+    }
+    else {
+        if(!seekCsv(signals, signals->chunkOffsets[chunk])) {
+            fmi4c_printMessage("Failed to read input file");
+            signals->failed = true;
+            return false;
+        }
+        char *line;
+        while(nRows < signals->chunkRows && (line = readLine(signals)) != NULL) {
+            if(line[0] == '\0') {
+                continue;   // Empty line
+            }
+            if(!parseRow(signals, line, rows+nRows*signals->nColumns)) {
+                fmi4c_printMessage("Invalid row in input file");
+                signals->failed = true;
+                return false;
+            }
+            ++nRows;
+        }
+        if(signals->failed) {
+            return false;
+        }
+        if(!signals->complete && chunk+1 == signals->nChunks) {
+            if(nRows == signals->chunkRows) {
+                if(!addChunk(signals, signals->bufferOffset+(int64_t)signals->bufferStart)) {
+                    signals->failed = true;
+                    return false;
+                }
+            }
+            else {
+                signals->complete = true;
+                signals->nRows = chunk*signals->chunkRows+nRows;
+                if(nRows == 0) {
+                    signals->nChunks = chunk;
+                }
+            }
+        }
+    }
+    if(nRows == 0) {
+        return false;
+    }
+    signals->slotChunks[slot] = chunk;
+    signals->slotRows[slot] = nRows;
+    signals->chunkTimes[chunk] = rows[0];
+    return true;
+}
+
+//! @brief Returns a row, reading its chunk if it is not resident
+//! @returns Pointer to the time and values of the row, or NULL if there is no such row
+static const double *getRow(fmi4cInputSignals *signals, size_t row)
+{
+    size_t chunk = row/signals->chunkRows;
+    size_t slot = chunk%2;
+    if(signals->slotChunks[slot] != chunk) {
+        // Chunks of CSV files are found by reading the previous chunk
+        while(!signals->failed && !signals->complete && chunk >= signals->nChunks) {
+            if(!loadChunk(signals, signals->nChunks-1)) {
+                break;
+            }
+        }
+        if(signals->failed || chunk >= signals->nChunks || !loadChunk(signals, chunk)) {
+            return NULL;
+        }
+    }
+    size_t index = row%signals->chunkRows;
+    if(index >= signals->slotRows[slot]) {
+        return NULL;
+    }
+    return signals->slots[slot]+index*signals->nColumns;
+}
+
+//! @brief Returns the time of the first row of a chunk, or infinity if there is no such chunk
+static double getChunkTime(fmi4cInputSignals *signals, size_t chunk)
+{
+    if(chunk < signals->nChunks && !isnan(signals->chunkTimes[chunk])) {
+        return signals->chunkTimes[chunk];
+    }
+    if(signals->binary && chunk < signals->nChunks) {
+        // Only the time is needed, not the whole chunk
+        double time;
+        if(!seekFile(signals->file, signals->chunkOffsets[chunk]) || fread(&time, sizeof(double), 1, signals->file) != 1) {
+            fmi4c_printMessage("Failed to read input file");
+            signals->failed = true;
+            return INFINITY;
+        }
+        signals->chunkTimes[chunk] = time;
+        return time;
+    }
+    const double *row = getRow(signals, chunk*signals->chunkRows);
+    return (row != NULL) ? row[0] : INFINITY;
+}
+
+//! @brief Finds the last row at or before the specified time (or the first row), starting from the previous lookup
+//! @param next Receives the row after it, or NULL if it is the last row
+static const double *findRows(fmi4cInputSignals *signals, double time, const double **next)
+{
+    // Find the chunk with a binary search over the chunks found so far, and read further while the
+    // time is after the last of them
+    size_t chunkRows = signals->chunkRows;
+    size_t chunk = signals->cursor/chunkRows;
+    size_t low = chunk;
+    size_t high = signals->nChunks-1;
+    if(getChunkTime(signals, chunk) > time) {
+        low = 0;
+        high = chunk;
+    }
+    while(!signals->failed) {
+        while(low < high) {
+            size_t middle = low+(high-low+1)/2;
+            if(getChunkTime(signals, middle) <= time) {
+                low = middle;
+            }
+            else {
+                high = middle-1;
+            }
+        }
+        if(signals->complete || low+1 < signals->nChunks) {
+            break;
+        }
+        // Reading the last chunk found so far finds the next one, or the end of the file
+        size_t nChunks = signals->nChunks;
+        if(getRow(signals, low*chunkRows) == NULL || (signals->nChunks == nChunks && !signals->complete)) {
+            break;
+        }
+        high = signals->nChunks-1;
+    }
+    chunk = low;
+    const double *first = getRow(signals, chunk*chunkRows);
+    if(first == NULL) {
+        return NULL;
+    }
+
+    // Stepping forward usually ends up at the previous row or the one after it
+    low = chunk*chunkRows;
+    high = low+signals->slotRows[chunk%2]-1;
+    size_t cursor = signals->cursor;
+    if(cursor > low && cursor <= high && getRow(signals, cursor)[0] <= time) {
+        low = cursor;
+        if(low < high && getRow(signals, low+1)[0] > time) {
+            high = low;
+        }
+    }
+    while(low < high) {
+        size_t middle = low+(high-low+1)/2;
+        if(getRow(signals, middle)[0] <= time) {
+            low = middle;
+        }
+        else {
+            high = middle-1;
+        }
+    }
+    signals->cursor = low;
+    *next = getRow(signals, low+1);
+    return getRow(signals, low);
+}
+
+//! @brief Reads the header row of a CSV file
+static bool readCsvHeader(fmi4cInputSignals *signals)
+{
+    signals->decimalPoint = localeconv()->decimal_point[0];
+    signals->bufferSize = INPUT_READ_SIZE;
+    signals->buffer = malloc(signals->bufferSize);
+    if(signals->buffer == NULL) {
+        return false;
+    }
+    char *line = readLine(signals);
+    if(line == NULL) {
+        return false;
+    }
+    if(!strncmp(line, "\xEF\xBB\xBF", 3)) {
+        line += 3;  // UTF-8 byte order mark
+    }
+    signals->nColumns = 1;
+    for(const char *c = line; *c != '\0'; ++c) {
+        signals->nColumns += (*c == ',');
+    }
+    signals->names = calloc(signals->nColumns, sizeof(char*));
+    if(signals->names == NULL) {
+        return false;
+    }
+    char *name = line;
+    for(size_t i=0; i<signals->nColumns; ++i) {
+        char *end = strchr(name, ',');
+        char *next = (end != NULL) ? end+1 : NULL;
+        if(end == NULL) {
+            end = name+strlen(name);
+        }
+        while(name < end && (*name == ' ' || *name == '\t' || *name == '"')) {
+            ++name;
+        }
+        while(end > name && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '"')) {
+            --end;
+        }
+        *end = '\0';
+        if(i > 0) {
+            signals->names[i-1] = _strdup(name);
+            if(signals->names[i-1] == NULL) {
+                return false;
+            }
+        }
+        name = next;
+    }
+    return addChunk(signals, signals->bufferOffset+(int64_t)signals->bufferStart);
+}
+
+//! @brief Reads the names matrix and the header of the data matrix of a MAT-file
+static bool readMatHeader(fmi4cInputSignals *signals)
+{
+    int64_t offset = 0;
+    bool foundNames = false;
+    size_t nameLength = 0;
+    size_t nNames = 0;
+    char *names = NULL;
+    while(true) {
+        int32_t header[5];
+        char matrixName[MAT4_MAX_NAME_LENGTH];
+        if(fread(header, sizeof(header), 1, signals->file) != 1 ||
+           header[0]/1000 != (isBigEndian() ? 1 : 0) || header[1] < 0 || header[2] < 0 ||
+           header[4] <= 0 || header[4] > MAT4_MAX_NAME_LENGTH ||
+           fread(matrixName, 1, (size_t)header[4], signals->file) != (size_t)header[4]) {
+            fmi4c_printMessage("Input MAT-file has no names and data matrices, or a different byte order");
+            free(names);
+            return false;
+        }
+        matrixName[header[4]-1] = '\0';
+        offset += MAT4_HEADER_SIZE+header[4];
+
+        int32_t type = header[0]%1000;
+        size_t nRows = (size_t)header[1];
+        size_t nColumns = (size_t)header[2];
+        if(!strcmp(matrixName, "names") && type == MAT4_TEXT_TYPE && !foundNames) {
+            nameLength = nRows;
+            nNames = nColumns;
+            names = malloc(nameLength*nNames+1);
+            if(names == NULL || fread(names, 1, nameLength*nNames, signals->file) != nameLength*nNames) {
+                free(names);
+                return false;
+            }
+            foundNames = true;
+            offset += (int64_t)(nameLength*nNames);
+        }
+        else if(!strcmp(matrixName, "data") && type == 0 && header[3] == 0) {
+            if(!foundNames || nRows != nNames || nRows == 0) {
+                fmi4c_printMessage("Input MAT-file must have one name per row of the data matrix");
+                free(names);
+                return false;
+            }
+            signals->nColumns = nRows;
+            signals->nRows = nColumns;
+            break;
+        }
+        else {
+            // Skip other matrices
+            static const size_t elementSizes[] = { 8, 4, 4, 2, 2, 1 };
+            size_t precision = (size_t)(type/10)%10;
+            if(precision > 5) {
+                free(names);
+                return false;
+            }
+            offset += (int64_t)(nRows*nColumns*elementSizes[precision]*(header[3] ? 2 : 1));
+            if(!seekFile(signals->file, offset)) {
+                free(names);
+                return false;
+            }
+        }
+    }
+
+    // Names are stored column by column, padded with spaces
+    signals->names = calloc(signals->nColumns, sizeof(char*));
+    bool ok = (signals->names != NULL);
+    for(size_t i=1; ok && i<signals->nColumns; ++i) {
+        char *name = names+i*nameLength;
+        size_t length = nameLength;
+        while(length > 0 && (name[length-1] == ' ' || name[length-1] == '\0')) {
+            --length;
+        }
+        signals->names[i-1] = malloc(length+1);
+        ok = (signals->names[i-1] != NULL);
+        if(ok) {
+            memcpy(signals->names[i-1], name, length);
+            signals->names[i-1][length] = '\0';
+        }
+    }
+    free(names);
+
+    // Rows have a fixed size, so all chunks are known
+    signals->chunkRows = INPUT_CHUNK_SIZE/(signals->nColumns*sizeof(double));
+    signals->chunkRows = signals->chunkRows > INPUT_MIN_CHUNK_ROWS ? signals->chunkRows : INPUT_MIN_CHUNK_ROWS;
+    for(size_t row=0; ok && row<signals->nRows; row+=signals->chunkRows) {
+        ok = addChunk(signals, offset+(int64_t)(row*signals->nColumns*sizeof(double)));
+    }
+    signals->complete = true;
+    return ok;
+}
+
+static void freeInputSignals(fmi4cInputSignals *signals)
+{
+    if(signals->file != NULL) {
+        fclose(signals->file);
+    }
+    if(signals->names != NULL) {
+        for(size_t i=0; i+1<signals->nColumns; ++i) {
+            free(signals->names[i]);
+        }
+        free(signals->names);
+    }
+    free(signals->chunkOffsets);
+    free(signals->chunkTimes);
+    free(signals->slots[0]);
+    free(signals->slots[1]);
+    free(signals->buffer);
+    free(signals);
+}
+
+//! @brief Opens an input file, and reads the names and the first chunk of rows
+//! @returns Input signals, or NULL if the file could not be read
+fmi4cInputSignals *fmi4c_openInputSignals(const char *path)
+{
+    fmi4cInputSignals *signals = calloc(1, sizeof(fmi4cInputSignals));
+    if(signals == NULL) {
+        return NULL;
+    }
+    size_t length = strlen(path);
+    signals->binary = (length >= 4 && !strcmp(path+length-4, ".mat"));
+    signals->file = fopen(path, "rb");
+    if(signals->file == NULL) {
+        fmi4c_printMessage("Failed to open input file");
+        freeInputSignals(signals);
+        return NULL;
+    }
+    bool ok = signals->binary ? readMatHeader(signals) : readCsvHeader(signals);
+    if(ok) {
+        if(!signals->binary) {
+            signals->chunkRows = INPUT_CHUNK_SIZE/(signals->nColumns*sizeof(double));
+            signals->chunkRows = signals->chunkRows > INPUT_MIN_CHUNK_ROWS ? signals->chunkRows : INPUT_MIN_CHUNK_ROWS;
+        }
+        signals->slots[0] = malloc(signals->chunkRows*signals->nColumns*sizeof(double));
+        signals->slots[1] = malloc(signals->chunkRows*signals->nColumns*sizeof(double));
+        signals->slotChunks[0] = NO_CHUNK;
+        signals->slotChunks[1] = NO_CHUNK;
+        ok = (signals->slots[0] != NULL && signals->slots[1] != NULL);
+    }
+    if(!ok || getRow(signals, 0) == NULL) {
+        fmi4c_printMessage("Failed to read input file, or it contains no data");
+        freeInputSignals(signals);
+        return NULL;
+    }
+    fmi4c_mutexInit(&signals->mutex);
+    return signals;
+}
+
+void fmi4c_closeInputSignals(fmi4cInputSignals *signals)
+{
+    if(signals != NULL) {
+        fmi4c_mutexDestroy(&signals->mutex);
+        freeInputSignals(signals);
+    }
+}
+
+//! @brief Returns the number of signals (columns except time)
+size_t fmi4c_getNumberOfInputSignals(fmi4cInputSignals *signals)
+{
+    return signals->nColumns-1;
+}
+
+const char *fmi4c_getInputSignalName(fmi4cInputSignals *signals, size_t signal)
+{
+    if(signal+1 >= signals->nColumns) {
+        return NULL;
+    }
+    return signals->names[signal];
+}
+
+//! @returns Index of the signal with the specified name, or -1 if there is no such signal
+int fmi4c_getInputSignalIndex(fmi4cInputSignals *signals, const char *name)
+{
+    for(size_t i=0; i+1<signals->nColumns; ++i) {
+        if(!strcmp(signals->names[i], name)) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+//! @brief Sets how values are interpolated between time points (linear by default)
+void fmi4c_setInputSignalInterpolation(fmi4cInputSignals *signals, fmi4cInterpolationMethod method)
+{
+    fmi4c_mutexLock(&signals->mutex);
+    signals->method = method;
+    fmi4c_mutexUnlock(&signals->mutex);
+}
+
+//! @brief Returns the interpolation method with the specified name (linear, zoh or hermite)
+bool fmi4c_getInterpolationMethodByName(const char *name, fmi4cInterpolationMethod *method)
+{
+    for(int i=fmi4cInterpolationLinear; i<=fmi4cInterpolationCubicHermite; ++i) {
+        if(!strcmp(name, fmi4c_getInterpolationMethodName((fmi4cInterpolationMethod)i))) {
+            *method = (fmi4cInterpolationMethod)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *fmi4c_getInterpolationMethodName(fmi4cInterpolationMethod method)
+{
+    switch(method) {
+    case fmi4cInterpolationLinear:
+        return "linear";
+    case fmi4cInterpolationZeroOrderHold:
+        return "zoh";
+    case fmi4cInterpolationCubicHermite:
+        return "hermite";
+    }
+    return "unknown";
+}
+
+//! @brief Computes out = c0*x0 + c1*x1 + c2*x2 + c3*x3 for all columns
+//! Rows may be the same, but not the output.
+static void combineRows(size_t n, double *RESTRICT out,
+                        double c0, const double *RESTRICT x0, double c1, const double *RESTRICT x1,
+                        double c2, const double *RESTRICT x2, double c3, const double *RESTRICT x3)
+{
+    for(size_t i=0; i<n; ++i) {
+        out[i] = c0*x0[i] + c1*x1[i] + c2*x2[i] + c3*x3[i];
+    }
+}
+
+//! @brief Computes out = x0 + s*(x1-x0), and the slopes (x1-x0)/h if derivatives is not NULL
+static void interpolateLinear(size_t n, double *RESTRICT out, double *RESTRICT derivatives, double s, double h,
+                              const double *RESTRICT x0, const double *RESTRICT x1)
+{
+    for(size_t i=0; i<n; ++i) {
+        out[i] = x0[i]+s*(x1[i]-x0[i]);
+    }
+    if(derivatives != NULL) {
+        double scale = 1/h;
+        for(size_t i=0; i<n; ++i) {
+            derivatives[i] = scale*(x1[i]-x0[i]);
+        }
+    }
+}
+
+//! @brief Interpolates a range of signals at the specified time
+//! @param derivatives Receives the time derivatives of the interpolated values (may be NULL)
+static bool interpolateSignals(fmi4cInputSignals *signals, double time, size_t first, size_t n, double *values, double *derivatives)
+{
+    const double *next;
+    const double *row = findRows(signals, time, &next);
+    if(row == NULL) {
+        return false;
+    }
+    size_t column = first+1;
+    if(next == NULL || time < row[0] || signals->method == fmi4cInterpolationZeroOrderHold) {
+        // Before the first or after the last time point, or held constant
+        memcpy(values, row+column, n*sizeof(double));
+        if(derivatives != NULL) {
+            memset(derivatives, 0, n*sizeof(double));
+        }
+        return true;
+    }
+
+    const double *x0 = row+column;
+    const double *x1 = next+column;
+    double h0 = next[0]-row[0];
+    double s = (time-row[0])/h0;
+    if(signals->method == fmi4cInterpolationLinear) {
+        interpolateLinear(n, values, derivatives, s, h0, x0, x1);
+        return true;
+    }
+
+    // Cubic Hermite: the tangents are the mean slopes of the neighbouring intervals, or the slope of
+    // the interval at the ends and at events (rows with the same time)
+    size_t index = signals->cursor;
+    const double *previous = (index > 0) ? getRow(signals, index-1) : NULL;
+    const double *after = getRow(signals, index+2);
+    double m0[3] = { 0, -1/h0, 1/h0 };      // Tangent at row from the previous, this and the next row
+    double m1[3] = { -1/h0, 1/h0, 0 };      // Tangent at next from this, the next and the row after it
+    if(previous != NULL && row[0] > previous[0]) {
+        double hm = row[0]-previous[0];
+        m0[0] = -0.5/hm;
+        m0[1] = 0.5*(1/hm-1/h0);
+        m0[2] = 0.5/h0;
+    }
+    if(after != NULL && after[0] > next[0]) {
+        double h1 = after[0]-next[0];
+        m1[0] = -0.5/h0;
+        m1[1] = 0.5*(1/h0-1/h1);
+        m1[2] = 0.5/h1;
+    }
+    const double *xm = (previous != NULL) ? previous+column : x0;
+    const double *x2 = (after != NULL) ? after+column : x1;
+
+    // Basis functions, with the tangents scaled to the interval
+    double h00 = (2*s-3)*s*s+1;
+    double h10 = ((s-2)*s+1)*s*h0;
+    double h01 = (3-2*s)*s*s;
+    double h11 = (s-1)*s*s*h0;
+    combineRows(n, values, h10*m0[0], xm, h00+h10*m0[1]+h11*m1[0], x0, h01+h10*m0[2]+h11*m1[1], x1, h11*m1[2], x2);
+    if(derivatives != NULL) {
+        double d00 = 6*(s-1)*s/h0;
+        double d10 = (3*s-4)*s+1;
+        double d01 = -d00;
+        double d11 = (3*s-2)*s;
+        combineRows(n, derivatives, d10*m0[0], xm, d00+d10*m0[1]+d11*m1[0], x0, d01+d10*m0[2]+d11*m1[1], x1, d11*m1[2], x2);
+    }
+    return true;
+}
+
+//! @brief Interpolates all signals at the specified time
+//! @param values Array with one element per signal
+//! @returns False if the file could not be read
+bool fmi4c_getInputSignalValues(fmi4cInputSignals *signals, double time, double *values)
+{
+    return fmi4c_getInputSignalValuesAndDerivatives(signals, time, values, NULL);
+}
+
+//! @brief Interpolates all signals and their time derivatives at the specified time
+//! The derivatives are those of the interpolation (zero for zero-order hold and outside the time range),
+//! for FMUs that can interpolate inputs.
+//! @param values Array with one element per signal
+//! @param derivatives Array with one element per signal
+//! @returns False if the file could not be read
+bool fmi4c_getInputSignalValuesAndDerivatives(fmi4cInputSignals *signals, double time, double *values, double *derivatives)
+{
+    fmi4c_mutexLock(&signals->mutex);
+    bool ok = interpolateSignals(signals, time, 0, signals->nColumns-1, values, derivatives);
+    fmi4c_mutexUnlock(&signals->mutex);
+    return ok;
+}
+
+//! @brief Interpolates one signal at the specified time
+//! @returns Value of the signal, or 0 if the file could not be read
+double fmi4c_getInputSignalValue(fmi4cInputSignals *signals, size_t signal, double time)
+{
+    double value = 0;
+    if(signal+1 < signals->nColumns) {
+        fmi4c_mutexLock(&signals->mutex);
+        interpolateSignals(signals, time, signal, 1, &value, NULL);
+        fmi4c_mutexUnlock(&signals->mutex);
+    }
+    return value;
+}
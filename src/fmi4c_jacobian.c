@@ -0,0 +1,707 @@
+#include "fmi4c_private.h"
+#define FMI4C_H_INTERNAL_INCLUDE
+#include "fmi4c.h"
+#include "fmi4c_jacobian.h"
+
+#include <float.h>
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+struct fmi4cJacobian {
+    fmiVersion_t fmiVersion;
+    fmi2InstanceHandle *fmi2Instance;
+    fmi3InstanceHandle *fmi3Instance;
+    bool outputs;           // Rows are outputs rather than state derivatives
+    size_t nRows;
+    size_t nColumns;
+
+    // Sparsity pattern (CSR)
+    size_t *rowPointers;
+    size_t *columnIndices;
+    double *values;
+    size_t nNonZeros;
+
+    int nColors;
+    int *colors;
+
+    // Value references of unknowns (rows) and knowns (columns), for directional derivatives
+    bool useDirectionalDerivatives;
+    bool providesDirectionalDerivatives;
+    fmi2ValueReference *fmi2UnknownReferences;
+    fmi2ValueReference *fmi2KnownReferences;
+    fmi3ValueReference *fmi3UnknownReferences;
+    fmi3ValueReference *fmi3KnownReferences;
+
+    // Work vectors
+    double *seed;
+    double *sensitivity;
+    double *unperturbed;
+    double *perturbedStates;
+};
+
+//! @brief Maps a variable index (FMI 2) or value reference (FMI 3) of a known to a column
+typedef struct {
+    unsigned int key;
+    size_t column;
+} columnKey_t;
+
+static int compareColumnKeys(const void *a, const void *b)
+{
+    unsigned int ka = ((const columnKey_t*)a)->key;
+    unsigned int kb = ((const columnKey_t*)b)->key;
+    return (ka > kb) - (ka < kb);
+}
+
+static int compareSizes(const void *a, const void *b)
+{
+    size_t sa = *(const size_t*)a;
+    size_t sb = *(const size_t*)b;
+    return (sa > sb) - (sa < sb);
+}
+
+static fmi4cJacobian *allocateJacobian(fmiVersion_t fmiVersion, size_t nRows, size_t nColumns)
+{
+    fmi4cJacobian *jacobian = calloc(1, sizeof(fmi4cJacobian));
+    if(jacobian == NULL) {
+        return NULL;
+    }
+    size_t m = nRows > 0 ? nRows : 1;
+    size_t n = nColumns > 0 ? nColumns : 1;
+    jacobian->fmiVersion = fmiVersion;
+    jacobian->nRows = nRows;
+    jacobian->nColumns = nColumns;
+    jacobian->rowPointers = calloc(m+1, sizeof(size_t));
+    jacobian->colors = calloc(n, sizeof(int));
+    jacobian->seed = calloc(n, sizeof(double));
+    jacobian->sensitivity = calloc(m, sizeof(double));
+    jacobian->unperturbed = calloc(m, sizeof(double));
+    jacobian->perturbedStates = calloc(n, sizeof(double));
+    if(fmiVersion == fmiVersion2) {
+        jacobian->fmi2UnknownReferences = calloc(m, sizeof(fmi2ValueReference));
+        jacobian->fmi2KnownReferences = calloc(n, sizeof(fmi2ValueReference));
+    }
+    else {
+        jacobian->fmi3UnknownReferences = calloc(m, sizeof(fmi3ValueReference));
+        jacobian->fmi3KnownReferences = calloc(n, sizeof(fmi3ValueReference));
+    }
+    if(jacobian->rowPointers == NULL || jacobian->colors == NULL || jacobian->seed == NULL ||
+       jacobian->sensitivity == NULL || jacobian->unperturbed == NULL || jacobian->perturbedStates == NULL ||
+       (jacobian->fmi2UnknownReferences == NULL && jacobian->fmi3UnknownReferences == NULL) ||
+       (jacobian->fmi2KnownReferences == NULL && jacobian->fmi3KnownReferences == NULL)) {
+        fmi4c_freeJacobian(jacobian);
+        return NULL;
+    }
+    return jacobian;
+}
+
+//! @brief Appends one row to the sparsity pattern
+//! @param dense True if the dependencies are unknown, in which case the row depends on all columns
+//! @param keys Variable indices or value references of the knowns the row depends on
+//! @param map Sorted map from keys to columns
+//! @param marker Work array of size nColumns, used for removing duplicates
+static bool appendRow(fmi4cJacobian *jacobian, size_t row, bool dense, const unsigned int *keys, int nKeys,
+                      const columnKey_t *map, size_t *capacity, size_t *marker)
+{
+    size_t maxLength = dense ? jacobian->nColumns : (size_t)nKeys;
+    if(jacobian->nNonZeros + maxLength > *capacity) {
+        size_t newCapacity = 2*(*capacity) + maxLength;
+        size_t *newColumnIndices = realloc(jacobian->columnIndices, newCapacity*sizeof(size_t));
+        if(newColumnIndices == NULL) {
+            return false;
+        }
+        jacobian->columnIndices = newColumnIndices;
+        *capacity = newCapacity;
+    }
+
+    size_t start = jacobian->nNonZeros;
+    if(dense) {
+        for(size_t j=0; j<jacobian->nColumns; ++j) {
+            jacobian->columnIndices[jacobian->nNonZeros++] = j;
+        }
+    }
+    else {
+        // Dependencies that are not states (e.g. inputs) have no column and are skipped
+        for(int k=0; k<nKeys; ++k) {
+            columnKey_t key;
+            key.key = keys[k];
+            const columnKey_t *found = bsearch(&key, map, jacobian->nColumns, sizeof(columnKey_t), compareColumnKeys);
+            if(found != NULL && marker[found->column] != row+1) {
+                marker[found->column] = row+1;
+                jacobian->columnIndices[jacobian->nNonZeros++] = found->column;
+            }
+        }
+        qsort(&jacobian->columnIndices[start], jacobian->nNonZeros-start, sizeof(size_t), compareSizes);
+    }
+    jacobian->rowPointers[row+1] = jacobian->nNonZeros;
+    return true;
+}
+
+//! @brief Distance-2 coloring of the columns with DSATUR, columns sharing a row get different colors
+//! The uncolored column with the most distinct colors among its neighbours (ties broken by the
+//! number of non-zeros in its rows) is colored next, with the smallest color not used by a neighbour.
+static bool colorColumns(fmi4cJacobian *jacobian)
+{
+    size_t n = jacobian->nColumns;
+    jacobian->nColors = 0;
+    if(n == 0) {
+        return true;
+    }
+
+    // A dense row forces one color per column
+    for(size_t i=0; i<jacobian->nRows; ++i) {
+        if(jacobian->rowPointers[i+1]-jacobian->rowPointers[i] == n) {
+            for(size_t j=0; j<n; ++j) {
+                jacobian->colors[j] = (int)j;
+            }
+            jacobian->nColors = (int)n;
+            return true;
+        }
+    }
+
+    // Transpose the pattern to find the rows of each column
+    size_t *columnPointers = calloc(n+1, sizeof(size_t));
+    size_t *rowIndices = malloc((jacobian->nNonZeros > 0 ? jacobian->nNonZeros : 1)*sizeof(size_t));
+    size_t *saturation = calloc(n, sizeof(size_t));
+    size_t *degree = calloc(n, sizeof(size_t));
+    int *forbidden = malloc(n*sizeof(int));
+    if(columnPointers == NULL || rowIndices == NULL || saturation == NULL || degree == NULL || forbidden == NULL) {
+        free(columnPointers);
+        free(rowIndices);
+        free(saturation);
+        free(degree);
+        free(forbidden);
+        return false;
+    }
+    for(size_t k=0; k<jacobian->nNonZeros; ++k) {
+        ++columnPointers[jacobian->columnIndices[k]+1];
+    }
+    for(size_t j=0; j<n; ++j) {
+        columnPointers[j+1] += columnPointers[j];
+    }
+    for(size_t i=0; i<jacobian->nRows; ++i) {
+        for(size_t k=jacobian->rowPointers[i]; k<jacobian->rowPointers[i+1]; ++k) {
+            size_t j = jacobian->columnIndices[k];
+            rowIndices[columnPointers[j]++] = i;
+            degree[j] += jacobian->rowPointers[i+1]-jacobian->rowPointers[i]-1;
+        }
+    }
+    for(size_t j=n; j>0; --j) {
+        columnPointers[j] = columnPointers[j-1];
+    }
+    columnPointers[0] = 0;
+
+    // Colors seen by each column, as bit sets (the number of colors is at most the largest degree plus one)
+    size_t maxColors = 1;
+    for(size_t j=0; j<n; ++j) {
+        if(degree[j]+1 > maxColors) {
+            maxColors = degree[j]+1;
+        }
+    }
+    if(maxColors > n) {
+        maxColors = n;
+    }
+    size_t wordsPerColumn = (maxColors+31)/32;
+    uint32_t *seen = calloc(n*wordsPerColumn, sizeof(uint32_t));
+    if(seen == NULL) {
+        free(columnPointers);
+        free(rowIndices);
+        free(saturation);
+        free(degree);
+        free(forbidden);
+        return false;
+    }
+
+    for(size_t j=0; j<n; ++j) {
+        forbidden[j] = -1;
+        jacobian->colors[j] = -1;
+    }
+    for(size_t colored=0; colored<n; ++colored) {
+        size_t next = n;
+        for(size_t j=0; j<n; ++j) {
+            if(jacobian->colors[j] < 0 &&
+               (next == n || saturation[j] > saturation[next] ||
+                (saturation[j] == saturation[next] && degree[j] > degree[next]))) {
+                next = j;
+            }
+        }
+
+        for(size_t k=columnPointers[next]; k<columnPointers[next+1]; ++k) {
+            size_t row = rowIndices[k];
+            for(size_t l=jacobian->rowPointers[row]; l<jacobian->rowPointers[row+1]; ++l) {
+                int color = jacobian->colors[jacobian->columnIndices[l]];
+                if(color >= 0) {
+                    forbidden[color] = (int)next;
+                }
+            }
+        }
+        int color = 0;
+        while(forbidden[color] == (int)next) {
+            ++color;
+        }
+        jacobian->colors[next] = color;
+        if(color+1 > jacobian->nColors) {
+            jacobian->nColors = color+1;
+        }
+
+        // Update the saturation of uncolored neighbours
+        uint32_t bit = (uint32_t)1 << (color%32);
+        for(size_t k=columnPointers[next]; k<columnPointers[next+1]; ++k) {
+            size_t row = rowIndices[k];
+            for(size_t l=jacobian->rowPointers[row]; l<jacobian->rowPointers[row+1]; ++l) {
+                size_t j = jacobian->columnIndices[l];
+                uint32_t *word = &seen[j*wordsPerColumn + (size_t)color/32];
+                if(jacobian->colors[j] < 0 && !(*word & bit)) {
+                    *word |= bit;
+                    ++saturation[j];
+                }
+            }
+        }
+    }
+
+    free(columnPointers);
+    free(rowIndices);
+    free(saturation);
+    free(degree);
+    free(forbidden);
+    free(seen);
+    return true;
+}
+
+static bool finalizeJacobian(fmi4cJacobian *jacobian)
+{
+    jacobian->values = calloc(jacobian->nNonZeros > 0 ? jacobian->nNonZeros : 1, sizeof(double));
+    if(jacobian->values == NULL || !colorColumns(jacobian)) {
+        return false;
+    }
+    return true;
+}
+
+static fmi4cJacobian *createJacobianFmi2(fmi2InstanceHandle *instance, size_t nStates, bool outputs)
+{
+    fmuHandle *fmu = instance->fmu;
+
+    // Rows are the state derivatives or the real outputs, in ModelStructure order
+    size_t nRows = nStates;
+    size_t nStructureRows = (size_t)fmi2_getNumberOfModelStructureOutputs(fmu);
+    size_t *rowStructure = calloc(nStructureRows > 0 ? nStructureRows : 1, sizeof(size_t));
+    if(rowStructure == NULL) {
+        return NULL;
+    }
+    if(outputs) {
+        nRows = 0;
+        for(size_t i=0; i<nStructureRows; ++i) {
+            fmi2VariableHandle *var = fmi2_getVariableByIndex(fmu, fmi2_getModelStructureIndex(fmi2_getModelStructureOutput(fmu, i)));
+            if(var != NULL && fmi2_getVariableDataType(var) == fmi2DataTypeReal) {
+                rowStructure[nRows++] = i;
+            }
+        }
+    }
+
+    fmi4cJacobian *jacobian = allocateJacobian(fmiVersion2, nRows, nStates);
+    if(jacobian == NULL) {
+        free(rowStructure);
+        return NULL;
+    }
+    jacobian->fmi2Instance = instance;
+    jacobian->outputs = outputs;
+
+    // States (columns) are ordered as the derivatives in ModelStructure
+    bool structureKnown = (fmi2_getNumberOfModelStructureDerivatives(fmu) == (int)nStates);
+    columnKey_t *map = calloc(nStates > 0 ? nStates : 1, sizeof(columnKey_t));
+    size_t *marker = calloc(nStates > 0 ? nStates : 1, sizeof(size_t));
+    if(map == NULL || marker == NULL) {
+        free(rowStructure);
+        free(map);
+        free(marker);
+        fmi4c_freeJacobian(jacobian);
+        return NULL;
+    }
+    for(size_t j=0; structureKnown && j<nStates; ++j) {
+        fmi2ModelStructureHandle *derivative = fmi2_getModelStructureDerivative(fmu, j);
+        fmi2VariableHandle *derivativeVar = fmi2_getVariableByIndex(fmu, fmi2_getModelStructureIndex(derivative));
+        fmi2VariableHandle *stateVar = NULL;
+        if(derivativeVar != NULL) {
+            stateVar = fmi2_getVariableByIndex(fmu, fmi2_getVariableDerivativeIndex(derivativeVar));
+        }
+        if(stateVar == NULL) {
+            structureKnown = false;
+            break;
+        }
+        if(!outputs) {
+            jacobian->fmi2UnknownReferences[j] = (fmi2ValueReference)fmi2_getVariableValueReference(derivativeVar);
+        }
+        jacobian->fmi2KnownReferences[j] = (fmi2ValueReference)fmi2_getVariableValueReference(stateVar);
+        map[j].key = (unsigned int)fmi2_getVariableDerivativeIndex(derivativeVar);
+        map[j].column = j;
+    }
+    qsort(map, nStates, sizeof(columnKey_t), compareColumnKeys);
+
+    size_t capacity = 0;
+    bool ok = true;
+    for(size_t i=0; ok && i<nRows; ++i) {
+        fmi2ModelStructureHandle *row = outputs ? fmi2_getModelStructureOutput(fmu, rowStructure[i])
+                                                : fmi2_getModelStructureDerivative(fmu, i);
+        if(outputs) {
+            fmi2VariableHandle *var = fmi2_getVariableByIndex(fmu, fmi2_getModelStructureIndex(row));
+            jacobian->fmi2UnknownReferences[i] = (fmi2ValueReference)fmi2_getVariableValueReference(var);
+        }
+        if(!structureKnown) {
+            ok = appendRow(jacobian, i, true, NULL, 0, map, &capacity, marker);
+            continue;
+        }
+        int nDependencies = fmi2_getModelStructureNumberOfDependencies(row);
+        unsigned int *keys = malloc((nDependencies > 0 ? nDependencies : 1)*sizeof(unsigned int));
+        int *dependencies = malloc((nDependencies > 0 ? nDependencies : 1)*sizeof(int));
+        if(keys == NULL || dependencies == NULL) {
+            free(keys);
+            free(dependencies);
+            ok = false;
+            break;
+        }
+        fmi2_getModelStructureDependencies(row, dependencies, nDependencies);
+        for(int k=0; k<nDependencies; ++k) {
+            keys[k] = (unsigned int)dependencies[k];
+        }
+        ok = appendRow(jacobian, i, !fmi2_getModelStructureDependenciesDefined(row), keys, nDependencies, map, &capacity, marker);
+        free(keys);
+        free(dependencies);
+    }
+    free(rowStructure);
+    free(map);
+    free(marker);
+
+    jacobian->providesDirectionalDerivatives = structureKnown && fmi2me_getProvidesDirectionalDerivative(fmu);
+    jacobian->useDirectionalDerivatives = jacobian->providesDirectionalDerivatives;
+    if(!ok || !finalizeJacobian(jacobian)) {
+        fmi4c_freeJacobian(jacobian);
+        return NULL;
+    }
+    return jacobian;
+}
+
+static fmi4cJacobian *createJacobianFmi3(fmi3InstanceHandle *instance, size_t nStates, bool outputs)
+{
+    fmuHandle *fmu = instance->fmu;
+
+    // Rows are the state derivatives or the Float64 outputs, in ModelStructure order
+    size_t nRows = nStates;
+    size_t nStructureRows = (size_t)fmi3_getNumberOfModelStructureOutputs(fmu);
+    size_t *rowStructure = calloc(nStructureRows > 0 ? nStructureRows : 1, sizeof(size_t));
+    if(rowStructure == NULL) {
+        return NULL;
+    }
+    if(outputs) {
+        nRows = 0;
+        for(size_t i=0; i<nStructureRows; ++i) {
+            fmi3VariableHandle *var = fmi3_getVariableByValueReference(fmu, fmi3_getModelStructureValueReference(fmi3_getModelStructureOutput(fmu, i)));
+            if(var != NULL && fmi3_getVariableDataType(var) == fmi3DataTypeFloat64) {
+                rowStructure[nRows++] = i;
+            }
+        }
+    }
+
+    fmi4cJacobian *jacobian = allocateJacobian(fmiVersion3, nRows, nStates);
+    if(jacobian == NULL) {
+        free(rowStructure);
+        return NULL;
+    }
+    jacobian->fmi3Instance = instance;
+    jacobian->outputs = outputs;
+
+    // States (columns) are ordered as the continuous state derivatives in ModelStructure
+    bool structureKnown = (fmi3_getNumberOfModelStructureContinuousStateDerivatives(fmu) == (int)nStates);
+    columnKey_t *map = calloc(nStates > 0 ? nStates : 1, sizeof(columnKey_t));
+    size_t *marker = calloc(nStates > 0 ? nStates : 1, sizeof(size_t));
+    if(map == NULL || marker == NULL) {
+        free(rowStructure);
+        free(map);
+        free(marker);
+        fmi4c_freeJacobian(jacobian);
+        return NULL;
+    }
+    for(size_t j=0; structureKnown && j<nStates; ++j) {
+        fmi3ModelStructureHandle *derivative = fmi3_getModelStructureContinuousStateDerivative(fmu, j);
+        fmi3ValueReference derivativeRef = fmi3_getModelStructureValueReference(derivative);
+        fmi3VariableHandle *derivativeVar = fmi3_getVariableByValueReference(fmu, derivativeRef);
+        if(derivativeVar == NULL) {
+            structureKnown = false;
+            break;
+        }
+        if(!outputs) {
+            jacobian->fmi3UnknownReferences[j] = derivativeRef;
+        }
+        jacobian->fmi3KnownReferences[j] = (fmi3ValueReference)fmi3_getVariableDerivativeIndex(derivativeVar);
+        map[j].key = jacobian->fmi3KnownReferences[j];
+        map[j].column = j;
+    }
+    qsort(map, nStates, sizeof(columnKey_t), compareColumnKeys);
+
+    size_t capacity = 0;
+    bool ok = true;
+    for(size_t i=0; ok && i<nRows; ++i) {
+        fmi3ModelStructureHandle *row = outputs ? fmi3_getModelStructureOutput(fmu, rowStructure[i])
+                                                : fmi3_getModelStructureContinuousStateDerivative(fmu, i);
+        if(outputs) {
+            jacobian->fmi3UnknownReferences[i] = fmi3_getModelStructureValueReference(row);
+        }
+        if(!structureKnown) {
+            ok = appendRow(jacobian, i, true, NULL, 0, map, &capacity, marker);
+            continue;
+        }
+        int nDependencies = fmi3_getModelStructureNumberOfDependencies(row);
+        int *dependencies = malloc((nDependencies > 0 ? nDependencies : 1)*sizeof(int));
+        unsigned int *keys = malloc((nDependencies > 0 ? nDependencies : 1)*sizeof(unsigned int));
+        if(keys == NULL || dependencies == NULL) {
+            free(keys);
+            free(dependencies);
+            ok = false;
+            break;
+        }
+        fmi3_getModelStructureDependencies(row, dependencies, nDependencies);
+        for(int k=0; k<nDependencies; ++k) {
+            keys[k] = (unsigned int)dependencies[k];
+        }
+        ok = appendRow(jacobian, i, !fmi3_getModelStructureDependenciesDefined(row), keys, nDependencies, map, &capacity, marker);
+        free(keys);
+        free(dependencies);
+    }
+    free(rowStructure);
+    free(map);
+    free(marker);
+
+    jacobian->providesDirectionalDerivatives = structureKnown && fmi3me_getProvidesDirectionalDerivative(fmu);
+    jacobian->useDirectionalDerivatives = jacobian->providesDirectionalDerivatives;
+    if(!ok || !finalizeJacobian(jacobian)) {
+        fmi4c_freeJacobian(jacobian);
+        return NULL;
+    }
+    return jacobian;
+}
+
+//! @brief Creates a state Jacobian (df/dx) for an FMI 2 model exchange instance
+//! @param instance Model exchange instance
+//! @param nStates Number of continuous states
+//! @returns Jacobian handle, or NULL on failure
+fmi4cJacobian *fmi4c_createStateJacobianFmi2(fmi2InstanceHandle *instance, size_t nStates)
+{
+    return createJacobianFmi2(instance, nStates, false);
+}
+
+//! @brief Creates a state Jacobian (df/dx) for an FMI 3 model exchange instance
+//! @param instance Model exchange instance
+//! @param nStates Number of continuous states
+//! @returns Jacobian handle, or NULL on failure
+fmi4cJacobian *fmi4c_createStateJacobianFmi3(fmi3InstanceHandle *instance, size_t nStates)
+{
+    return createJacobianFmi3(instance, nStates, false);
+}
+
+//! @brief Creates an output Jacobian (dy/dx) for an FMI 2 model exchange instance
+//! Rows are the real outputs in ModelStructure order.
+//! @param instance Model exchange instance
+//! @param nStates Number of continuous states
+//! @returns Jacobian handle, or NULL on failure
+fmi4cJacobian *fmi4c_createOutputJacobianFmi2(fmi2InstanceHandle *instance, size_t nStates)
+{
+    return createJacobianFmi2(instance, nStates, true);
+}
+
+//! @brief Creates an output Jacobian (dy/dx) for an FMI 3 model exchange instance
+//! Rows are the Float64 outputs in ModelStructure order.
+//! @param instance Model exchange instance
+//! @param nStates Number of continuous states
+//! @returns Jacobian handle, or NULL on failure
+fmi4cJacobian *fmi4c_createOutputJacobianFmi3(fmi3InstanceHandle *instance, size_t nStates)
+{
+    return createJacobianFmi3(instance, nStates, true);
+}
+
+void fmi4c_freeJacobian(fmi4cJacobian *jacobian)
+{
+    if(jacobian == NULL) {
+        return;
+    }
+    free(jacobian->rowPointers);
+    free(jacobian->columnIndices);
+    free(jacobian->values);
+    free(jacobian->colors);
+    free(jacobian->fmi2UnknownReferences);
+    free(jacobian->fmi2KnownReferences);
+    free(jacobian->fmi3UnknownReferences);
+    free(jacobian->fmi3KnownReferences);
+    free(jacobian->seed);
+    free(jacobian->sensitivity);
+    free(jacobian->unperturbed);
+    free(jacobian->perturbedStates);
+    free(jacobian);
+}
+
+static bool getDirectionalDerivative(fmi4cJacobian *jacobian)
+{
+    size_t m = jacobian->nRows;
+    size_t n = jacobian->nColumns;
+    if(jacobian->fmiVersion == fmiVersion2) {
+        return fmi2_getDirectionalDerivative(jacobian->fmi2Instance, jacobian->fmi2UnknownReferences, m,
+                                             jacobian->fmi2KnownReferences, n, jacobian->seed, jacobian->sensitivity) <= fmi2Warning;
+    }
+    return fmi3_getDirectionalDerivative(jacobian->fmi3Instance, jacobian->fmi3UnknownReferences, m,
+                                         jacobian->fmi3KnownReferences, n, jacobian->seed, n, jacobian->sensitivity, m) <= fmi3Warning;
+}
+
+//! @brief Gets the current values of the unknowns (state derivatives or outputs)
+static bool getUnknowns(fmi4cJacobian *jacobian, double *values)
+{
+    size_t m = jacobian->nRows;
+    if(jacobian->fmiVersion == fmiVersion2) {
+        if(jacobian->outputs) {
+            return fmi2_getReal(jacobian->fmi2Instance, jacobian->fmi2UnknownReferences, m, values) <= fmi2Warning;
+        }
+        return fmi2_getDerivatives(jacobian->fmi2Instance, values, m) <= fmi2Warning;
+    }
+    if(jacobian->outputs) {
+        return fmi3_getFloat64(jacobian->fmi3Instance, jacobian->fmi3UnknownReferences, m, values, m) <= fmi3Warning;
+    }
+    return fmi3_getContinuousStateDerivatives(jacobian->fmi3Instance, values, m) <= fmi3Warning;
+}
+
+static bool setStates(fmi4cJacobian *jacobian, const double *states)
+{
+    size_t n = jacobian->nColumns;
+    if(jacobian->fmiVersion == fmiVersion2) {
+        return fmi2_setContinuousStates(jacobian->fmi2Instance, states, n) <= fmi2Warning;
+    }
+    return fmi3_setContinuousStates(jacobian->fmi3Instance, states, n) <= fmi3Warning;
+}
+
+//! @brief Evaluates all non-zero elements of the Jacobian
+//! The FMU must be at the specified states (and the time of interest) when this is called, and is
+//! left there on return. Requires one directional derivative or finite difference evaluation per color.
+//! @param states Current continuous states
+//! @param unknowns Current state derivatives or outputs, only used for finite differences (NULL = get from FMU)
+//! @param nominals Nominal values of the states, used for finite difference increments (may be NULL)
+//! @returns True on success
+bool fmi4c_evaluateJacobian(fmi4cJacobian *jacobian, const double *states, const double *unknowns, const double *nominals)
+{
+    size_t n = jacobian->nColumns;
+    bool ok = true;
+    if(!jacobian->useDirectionalDerivatives && unknowns == NULL) {
+        ok = getUnknowns(jacobian, jacobian->unperturbed);
+        unknowns = jacobian->unperturbed;
+    }
+    for(int color=0; ok && color<jacobian->nColors; ++color) {
+        if(jacobian->useDirectionalDerivatives) {
+            for(size_t j=0; j<n; ++j) {
+                jacobian->seed[j] = (jacobian->colors[j] == color) ? 1.0 : 0.0;
+            }
+            ok = getDirectionalDerivative(jacobian);
+        }
+        else {
+            memcpy(jacobian->perturbedStates, states, n*sizeof(double));
+            for(size_t j=0; j<n; ++j) {
+                if(jacobian->colors[j] == color) {
+                    double magnitude = fabs(states[j]);
+                    double nominal = nominals != NULL ? nominals[j] : 1.0;
+                    double increment = sqrt(DBL_EPSILON)*(magnitude > nominal ? magnitude : nominal);
+                    // Make the increment exactly representable
+                    volatile double perturbed = states[j] + increment;
+                    jacobian->seed[j] = perturbed - states[j];
+                    jacobian->perturbedStates[j] = perturbed;
+                }
+            }
+            ok = setStates(jacobian, jacobian->perturbedStates) && getUnknowns(jacobian, jacobian->sensitivity);
+            if(ok) {
+                for(size_t i=0; i<jacobian->nRows; ++i) {
+                    jacobian->sensitivity[i] -= unknowns[i];
+                }
+            }
+        }
+        if(!ok) {
+            break;
+        }
+
+        for(size_t i=0; i<jacobian->nRows; ++i) {
+            for(size_t k=jacobian->rowPointers[i]; k<jacobian->rowPointers[i+1]; ++k) {
+                size_t j = jacobian->columnIndices[k];
+                if(jacobian->colors[j] == color) {
+                    jacobian->values[k] = jacobian->useDirectionalDerivatives ? jacobian->sensitivity[i] : jacobian->sensitivity[i]/jacobian->seed[j];
+                }
+            }
+        }
+    }
+
+    if(!jacobian->useDirectionalDerivatives && jacobian->nColors > 0) {
+        // Restore the unperturbed states
+        ok = setStates(jacobian, states) && ok;
+    }
+    if(!ok) {
+        fmi4c_printMessage("Failed to evaluate Jacobian");
+    }
+    return ok;
+}
+
+size_t fmi4c_getJacobianNumberOfRows(fmi4cJacobian *jacobian)
+{
+    return jacobian->nRows;
+}
+
+size_t fmi4c_getJacobianNumberOfColumns(fmi4cJacobian *jacobian)
+{
+    return jacobian->nColumns;
+}
+
+size_t fmi4c_getJacobianNumberOfNonZeros(fmi4cJacobian *jacobian)
+{
+    return jacobian->nNonZeros;
+}
+
+const size_t *fmi4c_getJacobianRowPointers(fmi4cJacobian *jacobian)
+{
+    return jacobian->rowPointers;
+}
+
+const size_t *fmi4c_getJacobianColumnIndices(fmi4cJacobian *jacobian)
+{
+    return jacobian->columnIndices;
+}
+
+const double *fmi4c_getJacobianValues(fmi4cJacobian *jacobian)
+{
+    return jacobian->values;
+}
+
+//! @brief Expands the Jacobian values to a dense row-major matrix of size rows x columns
+void fmi4c_getJacobianDense(fmi4cJacobian *jacobian, double *matrix)
+{
+    memset(matrix, 0, jacobian->nRows*jacobian->nColumns*sizeof(double));
+    for(size_t i=0; i<jacobian->nRows; ++i) {
+        for(size_t k=jacobian->rowPointers[i]; k<jacobian->rowPointers[i+1]; ++k) {
+            matrix[i*jacobian->nColumns + jacobian->columnIndices[k]] = jacobian->values[k];
+        }
+    }
+}
+
+int fmi4c_getJacobianNumberOfColors(fmi4cJacobian *jacobian)
+{
+    return jacobian->nColors;
+}
+
+//! @brief Returns the color of each column, columns with the same color are evaluated together
+const int *fmi4c_getJacobianColumnColors(fmi4cJacobian *jacobian)
+{
+    return jacobian->colors;
+}
+
+bool fmi4c_getJacobianUsesDirectionalDerivatives(fmi4cJacobian *jacobian)
+{
+    return jacobian->useDirectionalDerivatives;
+}
+
+//! @brief Selects between directional derivatives and colored finite differences
+//! Directional derivatives can only be selected if the FMU provides them and the sparsity pattern is known.
+//! @returns True if the requested method is used
+bool fmi4c_setJacobianUsesDirectionalDerivatives(fmi4cJacobian *jacobian, bool useDirectionalDerivatives)
+{
+    jacobian->useDirectionalDerivatives = useDirectionalDerivatives && jacobian->providesDirectionalDerivatives;
+    return jacobian->useDirectionalDerivatives == useDirectionalDerivatives;
+}
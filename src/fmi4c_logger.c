@@ -0,0 +1,840 @@
+#include "fmi4c_private.h"
+#define FMI4C_H_INTERNAL_INCLUDE
+#include "fmi4c.h"
+#include "fmi4c_logger.h"
+#include "fmi4c_common.h"
+#include "fmi4c_threads.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <string.h>
+
+#define LOG_MAX_ARGS 16
+#define LOG_TEXT_SIZE 448
+#define LOG_MAX_DISABLED_CATEGORIES 32
+#define LOG_DEFAULT_RECORDS_PER_THREAD 256
+
+typedef enum { logArgInt, logArgUInt, logArgChar, logArgDouble, logArgPointer, logArgString } logArgType_t;
+
+typedef union {
+    long long i;
+    unsigned long long u;
+    double d;
+    const void *p;
+    size_t offset;  // Offset into record text for string arguments
+} logArg_t;
+
+//! @brief One log message with its raw (unformatted) arguments
+typedef struct {
+    unsigned char fmiVersion;
+    unsigned char status;
+    unsigned char nArgs;
+    bool truncated;
+    size_t instanceNameOffset;
+    size_t categoryOffset;
+    size_t messageOffset;
+    unsigned char argTypes[LOG_MAX_ARGS];
+    logArg_t args[LOG_MAX_ARGS];
+    size_t textUsed;
+    char text[LOG_TEXT_SIZE];
+} logRecord_t;
+
+//! @brief Single-producer/single-consumer ring buffer owned by one producer thread
+typedef struct logRing {
+    logRecord_t *records;
+    size_t mask;
+    volatile size_t head;       // Written by producer only
+    volatile size_t tail;       // Written by consumer only
+    volatile size_t dropped;
+    volatile size_t truncated;
+    const void *owner;          // Identity of the producer thread
+    struct logRing *next;
+} logRing_t;
+
+//! @brief Disabled category, immutable while it is published
+typedef struct logCategory {
+    size_t hash;
+    char *name;
+    struct logCategory *next;   // Next retired category
+} logCategory_t;
+
+struct fmi4cLogger {
+    FILE *output;
+    volatile size_t level;
+    size_t recordsPerThread;
+    size_t id;
+
+    logRing_t *volatile rings;  // Singly linked list, only prepended to (under ringMutex)
+    fmi4cMutex_t ringMutex;
+
+    volatile size_t numberOfDisabledCategories;
+    void *volatile disabledCategories[LOG_MAX_DISABLED_CATEGORIES];    // Published logCategory_t pointers
+    logCategory_t *retiredCategories;   // Enabled again, kept until the logger is freed as producers may still read them
+
+    fmi4cThread_t thread;
+    fmi4cMutex_t mutex;
+    fmi4cCond_t cond;
+    bool stopRequested;
+    size_t flushRequested;
+    size_t flushCompleted;
+    char *formatBuffer;
+    size_t formatBufferSize;
+};
+
+static fmi4cLogger *activeLogger = NULL;
+static volatile size_t nextLoggerId = 1;
+
+static FMI4C_THREAD_LOCAL char threadIdentity;
+static FMI4C_THREAD_LOCAL size_t threadLoggerId = 0;
+static FMI4C_THREAD_LOCAL logRing_t *threadRing = NULL;
+
+static size_t hashString(const char *str)
+{
+    size_t hash = (size_t)2166136261u;
+    while(*str) {
+        hash = (hash ^ (unsigned char)(*str++)) * (size_t)16777619u;
+    }
+    return hash;
+}
+
+//! @brief Maps an FMI status (same order in all FMI versions) to the lowest log level that shows it
+static int statusLevel(int status)
+{
+    switch(status) {
+    case 0: return fmi4cLogLevelInfo;       // OK
+    case 1: return fmi4cLogLevelWarning;    // Warning
+    case 2: return fmi4cLogLevelWarning;    // Discard
+    case 3: return fmi4cLogLevelError;      // Error
+    case 4: return fmi4cLogLevelFatal;      // Fatal
+    default: return fmi4cLogLevelInfo;      // Pending
+    }
+}
+
+static const char *statusString(int status)
+{
+    switch(status) {
+    case 0: return "OK";
+    case 1: return "Warning";
+    case 2: return "Discard";
+    case 3: return "Error";
+    case 4: return "Fatal";
+    default: return "Pending";
+    }
+}
+
+static bool categoryMatches(const logCategory_t *disabled, size_t hash, const char *category)
+{
+    return disabled->hash == hash && !strcmp(disabled->name, category);
+}
+
+static void freeCategory(logCategory_t *disabled)
+{
+    if(disabled != NULL) {
+        free(disabled->name);
+        free(disabled);
+    }
+}
+
+static logCategory_t *newCategory(size_t hash, const char *category)
+{
+    logCategory_t *disabled = malloc(sizeof(logCategory_t));
+    if(disabled == NULL) {
+        return NULL;
+    }
+    disabled->hash = hash;
+    disabled->name = _strdup(category);
+    disabled->next = NULL;
+    if(disabled->name == NULL) {
+        free(disabled);
+        return NULL;
+    }
+    return disabled;
+}
+
+//! @brief Removes a category from the retired list and returns it, so that toggling a category does not allocate every time
+static logCategory_t *takeRetiredCategory(fmi4cLogger *logger, size_t hash, const char *category)
+{
+    logCategory_t **retired = &logger->retiredCategories;
+    while(*retired != NULL && !categoryMatches(*retired, hash, category)) {
+        retired = &(*retired)->next;
+    }
+    logCategory_t *disabled = *retired;
+    if(disabled != NULL) {
+        *retired = disabled->next;
+    }
+    return disabled;
+}
+
+//! @brief Checks status and category filters, no formatting or copying takes place
+static bool acceptMessage(fmi4cLogger *logger, int status, const char *category)
+{
+    if((size_t)statusLevel(status) > fmi4c_atomicLoadAcquire(&logger->level)) {
+        return false;
+    }
+    size_t n = fmi4c_atomicLoadAcquire(&logger->numberOfDisabledCategories);
+    if(n > 0 && category != NULL) {
+        size_t hash = hashString(category);
+        for(size_t i=0; i<n; ++i) {
+            if(categoryMatches(fmi4c_atomicLoadPointerAcquire(&logger->disabledCategories[i]), hash, category)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+//! @brief Parsed printf conversion specification
+typedef struct {
+    const char *start;      // Points to '%'
+    const char *end;        // Points past the conversion character
+    bool widthFromArg;
+    bool precisionFromArg;
+    char length[3];
+    char conversion;
+} logConversion_t;
+
+//! @brief Finds the next conversion specification in a printf format string
+//! @returns False if there are no more conversions
+static bool nextConversion(const char *fmt, logConversion_t *conv)
+{
+    const char *p = strchr(fmt, '%');
+    while(p != NULL && p[1] == '%') {
+        p = strchr(p+2, '%');
+    }
+    if(p == NULL) {
+        return false;
+    }
+    conv->start = p++;
+    conv->widthFromArg = false;
+    conv->precisionFromArg = false;
+    memset(conv->length, 0, sizeof(conv->length));
+    while(*p && strchr("-+ #0'", *p)) {
+        ++p;
+    }
+    if(*p == '*') {
+        conv->widthFromArg = true;
+        ++p;
+    }
+    while(*p >= '0' && *p <= '9') {
+        ++p;
+    }
+    if(*p == '.') {
+        ++p;
+        if(*p == '*') {
+            conv->precisionFromArg = true;
+            ++p;
+        }
+        while(*p >= '0' && *p <= '9') {
+            ++p;
+        }
+    }
+    size_t nLength = 0;
+    while(*p && strchr("hlLqjzt", *p) && nLength < 2) {
+        conv->length[nLength++] = *p++;
+    }
+    conv->conversion = *p;
+    conv->end = (*p) ? p+1 : p;
+    return true;
+}
+
+//! @brief Appends a string to the record text
+//! @returns Offset of the copied string
+static size_t appendText(logRecord_t *record, const char *str)
+{
+    if(str == NULL) {
+        str = "(null)";
+    }
+    size_t offset = record->textUsed;
+    size_t available = LOG_TEXT_SIZE - record->textUsed;
+    if(available == 0) {
+        record->truncated = true;
+        return LOG_TEXT_SIZE-1;
+    }
+    size_t len = strlen(str);
+    if(len >= available) {
+        len = available-1;
+        record->truncated = true;
+    }
+    memcpy(record->text+offset, str, len);
+    record->text[offset+len] = '\0';
+    record->textUsed += len+1;
+    return offset;
+}
+
+//! @brief Copies the raw arguments of a printf-style message into a record, without formatting
+static void copyArguments(logRecord_t *record, const char *fmt, va_list *pArgs)
+{
+    logConversion_t conv;
+    while(nextConversion(fmt, &conv)) {
+        fmt = conv.end;
+        if(conv.conversion == '\0') {
+            break;
+        }
+        int nNeeded = 1 + (conv.widthFromArg ? 1 : 0) + (conv.precisionFromArg ? 1 : 0);
+        if(record->nArgs + nNeeded > LOG_MAX_ARGS) {
+            record->truncated = true;
+            break;
+        }
+        if(conv.widthFromArg) {
+            record->argTypes[record->nArgs] = logArgInt;
+            record->args[record->nArgs++].i = va_arg(*pArgs, int);
+        }
+        if(conv.precisionFromArg) {
+            record->argTypes[record->nArgs] = logArgInt;
+            record->args[record->nArgs++].i = va_arg(*pArgs, int);
+        }
+        logArg_t *arg = &record->args[record->nArgs];
+        unsigned char *type = &record->argTypes[record->nArgs];
+        switch(conv.conversion) {
+        case 'c':
+            *type = logArgChar;
+            arg->i = va_arg(*pArgs, int);
+            break;
+        case 'd':
+        case 'i':
+            *type = logArgInt;
+            if(!strcmp(conv.length, "l")) arg->i = va_arg(*pArgs, long);
+            else if(!strcmp(conv.length, "ll") || !strcmp(conv.length, "q")) arg->i = va_arg(*pArgs, long long);
+            else if(!strcmp(conv.length, "z")) arg->i = (long long)va_arg(*pArgs, size_t);
+            else if(!strcmp(conv.length, "j")) arg->i = (long long)va_arg(*pArgs, intmax_t);
+            else if(!strcmp(conv.length, "t")) arg->i = (long long)va_arg(*pArgs, ptrdiff_t);
+            else arg->i = va_arg(*pArgs, int);
+            break;
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            *type = logArgUInt;
+            if(!strcmp(conv.length, "l")) arg->u = va_arg(*pArgs, unsigned long);
+            else if(!strcmp(conv.length, "ll") || !strcmp(conv.length, "q")) arg->u = va_arg(*pArgs, unsigned long long);
+            else if(!strcmp(conv.length, "z")) arg->u = va_arg(*pArgs, size_t);
+            else if(!strcmp(conv.length, "j")) arg->u = (unsigned long long)va_arg(*pArgs, uintmax_t);
+            else if(!strcmp(conv.length, "t")) arg->u = (unsigned long long)va_arg(*pArgs, ptrdiff_t);
+            else arg->u = va_arg(*pArgs, unsigned int);
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            *type = logArgDouble;
+            if(!strcmp(conv.length, "L")) arg->d = (double)va_arg(*pArgs, long double);
+            else arg->d = va_arg(*pArgs, double);
+            break;
+        case 's':
+            *type = logArgString;
+            arg->offset = appendText(record, va_arg(*pArgs, const char*));
+            break;
+        case 'p':
+        case 'n':   // Never written to, only consumed
+            *type = logArgPointer;
+            arg->p = va_arg(*pArgs, void*);
+            break;
+        default:    // Unknown conversion, arguments can no longer be decoded reliably
+            record->truncated = true;
+            return;
+        }
+        ++record->nArgs;
+    }
+}
+
+//! @brief Returns the ring buffer of the calling thread, creating it on first use
+static logRing_t *getThreadRing(fmi4cLogger *logger)
+{
+    if(threadLoggerId == logger->id && threadRing != NULL) {
+        return threadRing;
+    }
+
+    //Slow path, only taken once per thread and logger
+    fmi4c_mutexLock(&logger->ringMutex);
+    logRing_t *ring = logger->rings;
+    while(ring != NULL && ring->owner != &threadIdentity) {
+        ring = ring->next;
+    }
+    if(ring == NULL) {
+        ring = calloc(1, sizeof(logRing_t));
+        if(ring != NULL) {
+            ring->records = malloc(logger->recordsPerThread*sizeof(logRecord_t));
+            if(ring->records == NULL) {
+                free(ring);
+                ring = NULL;
+            }
+        }
+        if(ring != NULL) {
+            ring->mask = logger->recordsPerThread-1;
+            ring->owner = &threadIdentity;
+            ring->next = logger->rings;
+            logger->rings = ring;
+        }
+    }
+    fmi4c_mutexUnlock(&logger->ringMutex);
+
+    threadLoggerId = logger->id;
+    threadRing = ring;
+    return ring;
+}
+
+//! @brief Reserves the next free record in the calling thread's ring, or returns NULL if it is full
+static logRecord_t *beginRecord(fmi4cLogger *logger, logRing_t **pRing)
+{
+    logRing_t *ring = getThreadRing(logger);
+    if(ring == NULL) {
+        return NULL;
+    }
+    size_t head = ring->head;
+    if(head - fmi4c_atomicLoadAcquire(&ring->tail) > ring->mask) {
+        fmi4c_atomicFetchAdd(&ring->dropped, 1);
+        return NULL;
+    }
+    *pRing = ring;
+    logRecord_t *record = &ring->records[head & ring->mask];
+    record->nArgs = 0;
+    record->truncated = false;
+    record->textUsed = 0;
+    return record;
+}
+
+//! @brief Publishes a record to the consumer
+static void commitRecord(logRing_t *ring, logRecord_t *record)
+{
+    if(record->truncated) {
+        fmi4c_atomicFetchAdd(&ring->truncated, 1);
+    }
+    fmi4c_atomicStoreRelease(&ring->head, ring->head+1);
+}
+
+//! @brief Filters a message and copies it to the calling thread's ring buffer
+//! @param args Variable arguments for the printf-style message, or NULL if the message is plain text
+static void logMessage(fmi4cLogger *logger, int fmiVersion, const char *instanceName, int status, const char *category, const char *message, va_list *args)
+{
+    if(!acceptMessage(logger, status, category)) {
+        return;
+    }
+    logRing_t *ring;
+    logRecord_t *record = beginRecord(logger, &ring);
+    if(record == NULL) {
+        return;
+    }
+    record->fmiVersion = (unsigned char)fmiVersion;
+    record->status = (unsigned char)status;
+    record->instanceNameOffset = appendText(record, instanceName ? instanceName : "");
+    record->categoryOffset = appendText(record, category ? category : "");
+    record->messageOffset = appendText(record, message);
+    if(args != NULL && !record->truncated) {
+        copyArguments(record, message, args);
+    }
+    commitRecord(ring, record);
+}
+
+//! @brief Appends formatted text to the logger format buffer, growing it if needed
+static size_t appendFormatted(fmi4cLogger *logger, size_t pos, const char *spec, const logRecord_t *record, int nArgs, const logArg_t *args, unsigned char type)
+{
+    for(;;) {
+        size_t available = logger->formatBufferSize - pos;
+        char *dst = logger->formatBuffer + pos;
+        int n;
+        if(nArgs == 0) {
+            n = snprintf(dst, available, "%s", spec);
+        }
+        else {
+            //Width and precision arguments (if any) are placed before the value
+            int ints[2] = {0, 0};
+            for(int i=0; i<nArgs-1; ++i) {
+                ints[i] = (int)args[i].i;
+            }
+            const logArg_t *value = &args[nArgs-1];
+            switch(type) {
+            case logArgChar:
+                if(nArgs == 1) n = snprintf(dst, available, spec, (int)value->i);
+                else if(nArgs == 2) n = snprintf(dst, available, spec, ints[0], (int)value->i);
+                else n = snprintf(dst, available, spec, ints[0], ints[1], (int)value->i);
+                break;
+            case logArgInt:
+                if(nArgs == 1) n = snprintf(dst, available, spec, value->i);
+                else if(nArgs == 2) n = snprintf(dst, available, spec, ints[0], value->i);
+                else n = snprintf(dst, available, spec, ints[0], ints[1], value->i);
+                break;
+            case logArgUInt:
+                if(nArgs == 1) n = snprintf(dst, available, spec, value->u);
+                else if(nArgs == 2) n = snprintf(dst, available, spec, ints[0], value->u);
+                else n = snprintf(dst, available, spec, ints[0], ints[1], value->u);
+                break;
+            case logArgDouble:
+                if(nArgs == 1) n = snprintf(dst, available, spec, value->d);
+                else if(nArgs == 2) n = snprintf(dst, available, spec, ints[0], value->d);
+                else n = snprintf(dst, available, spec, ints[0], ints[1], value->d);
+                break;
+            case logArgString: {
+                const char *str = record->text + value->offset;
+                if(nArgs == 1) n = snprintf(dst, available, spec, str);
+                else if(nArgs == 2) n = snprintf(dst, available, spec, ints[0], str);
+                else n = snprintf(dst, available, spec, ints[0], ints[1], str);
+                break;
+            }
+            default:
+                n = snprintf(dst, available, "%p", value->p);
+                break;
+            }
+        }
+        if(n < 0) {
+            return pos;
+        }
+        if((size_t)n < available) {
+            return pos + (size_t)n;
+        }
+        char *newBuffer = realloc(logger->formatBuffer, 2*logger->formatBufferSize + (size_t)n);
+        if(newBuffer == NULL) {
+            return pos;
+        }
+        logger->formatBuffer = newBuffer;
+        logger->formatBufferSize = 2*logger->formatBufferSize + (size_t)n;
+    }
+}
+
+//! @brief Appends literal text from a format string, with "%%" collapsed to "%"
+static size_t appendLiteral(fmi4cLogger *logger, size_t pos, const char *text, size_t length)
+{
+    if(logger->formatBufferSize - pos <= length) {
+        char *newBuffer = realloc(logger->formatBuffer, 2*logger->formatBufferSize + length);
+        if(newBuffer == NULL) {
+            return pos;
+        }
+        logger->formatBuffer = newBuffer;
+        logger->formatBufferSize = 2*logger->formatBufferSize + length;
+    }
+    for(size_t i=0; i<length; ++i) {
+        if(text[i] == '%' && i+1 < length && text[i+1] == '%') {
+            ++i;
+        }
+        logger->formatBuffer[pos++] = text[i];
+    }
+    return pos;
+}
+
+//! @brief Formats and writes one record (runs on the logger thread)
+static void writeRecord(fmi4cLogger *logger, const logRecord_t *record)
+{
+    const char *message = record->text + record->messageOffset;
+    size_t pos = 0;
+    char prefix[64];
+    snprintf(prefix, sizeof(prefix), "[%s] ", statusString(record->status));
+    pos = appendFormatted(logger, pos, prefix, record, 0, NULL, 0);
+    if(record->text[record->instanceNameOffset] != '\0') {
+        pos = appendFormatted(logger, pos, record->text + record->instanceNameOffset, record, 0, NULL, 0);
+        pos = appendFormatted(logger, pos, " ", record, 0, NULL, 0);
+    }
+    pos = appendFormatted(logger, pos, record->text + record->categoryOffset, record, 0, NULL, 0);
+    pos = appendFormatted(logger, pos, ": ", record, 0, NULL, 0);
+
+    if(record->fmiVersion == 3) {
+        pos = appendFormatted(logger, pos, message, record, 0, NULL, 0);
+    }
+    else {
+        //Re-parse the format string and format one conversion at a time from the stored arguments
+        const char *fmt = message;
+        int argIndex = 0;
+        logConversion_t conv;
+        char spec[64];
+        while(nextConversion(fmt, &conv) && conv.conversion != '\0') {
+            pos = appendLiteral(logger, pos, fmt, (size_t)(conv.start - fmt));
+
+            int nArgs = 1 + (conv.widthFromArg ? 1 : 0) + (conv.precisionFromArg ? 1 : 0);
+            if(argIndex + nArgs > record->nArgs) {
+                fmt = conv.start;
+                break;
+            }
+
+            //Rebuild the specification with a length modifier matching the stored argument type
+            size_t specLength = 0;
+            for(const char *p = conv.start; p < conv.end-1 && specLength < sizeof(spec)-4; ++p) {
+                if(!strchr("hlLqjzt", *p)) {
+                    spec[specLength++] = *p;
+                }
+            }
+            unsigned char type = record->argTypes[argIndex+nArgs-1];
+            if(type == logArgInt || type == logArgUInt) {
+                spec[specLength++] = 'l';
+                spec[specLength++] = 'l';
+            }
+            spec[specLength++] = (conv.conversion == 'n') ? 'p' : conv.conversion;
+            spec[specLength] = '\0';
+            if(conv.conversion == 'n') {
+                argIndex += nArgs;      //Never write through %n
+            }
+            else {
+                pos = appendFormatted(logger, pos, spec, record, nArgs, &record->args[argIndex], type);
+                argIndex += nArgs;
+            }
+            fmt = conv.end;
+        }
+        pos = appendLiteral(logger, pos, fmt, strlen(fmt));
+    }
+    if(record->truncated) {
+        pos = appendFormatted(logger, pos, " [truncated]", record, 0, NULL, 0);
+    }
+    pos = appendFormatted(logger, pos, "\n", record, 0, NULL, 0);
+    fwrite(logger->formatBuffer, 1, pos, logger->output);
+}
+
+//! @brief Drains all ring buffers once
+//! @param rings First ring in list (rings are only ever prepended, so the rest of the list is stable)
+//! @returns True if any record was written
+static bool drainRings(fmi4cLogger *logger, logRing_t *rings)
+{
+    bool any = false;
+    for(logRing_t *ring = rings; ring != NULL; ring = ring->next) {
+        size_t tail = ring->tail;
+        size_t head = fmi4c_atomicLoadAcquire(&ring->head);
+        while(tail != head) {
+            writeRecord(logger, &ring->records[tail & ring->mask]);
+            ++tail;
+            fmi4c_atomicStoreRelease(&ring->tail, tail);
+            any = true;
+        }
+    }
+    if(any) {
+        fflush(logger->output);
+    }
+    return any;
+}
+
+static void loggerThread(void *arg)
+{
+    fmi4cLogger *logger = (fmi4cLogger*)arg;
+    fmi4c_mutexLock(&logger->mutex);
+    for(;;) {
+        size_t flushRequested = logger->flushRequested;
+        bool stop = logger->stopRequested;
+        fmi4c_mutexUnlock(&logger->mutex);
+
+        fmi4c_mutexLock(&logger->ringMutex);    //Protects the list head only, producers never take it on the hot path
+        logRing_t *rings = logger->rings;
+        fmi4c_mutexUnlock(&logger->ringMutex);
+        bool any = drainRings(logger, rings);
+
+        fmi4c_mutexLock(&logger->mutex);
+        if(logger->flushCompleted != flushRequested) {
+            logger->flushCompleted = flushRequested;
+            fmi4c_condBroadcast(&logger->cond);
+        }
+        if(stop) {
+            break;
+        }
+        if(!any && logger->flushRequested == logger->flushCompleted && !logger->stopRequested) {
+            fmi4c_condTimedWait(&logger->cond, &logger->mutex, 2000);
+        }
+    }
+    fmi4c_mutexUnlock(&logger->mutex);
+}
+
+//! @brief Creates an asynchronous logger
+//! @param output File to write messages to (e.g. stdout)
+//! @param level Maximum log level to accept
+//! @param recordsPerThread Ring buffer capacity per producing thread (rounded up to a power of two, 0 gives default)
+//! @returns Handle to logger, or NULL on failure
+fmi4cLogger *fmi4c_createLogger(FILE *output, fmi4cLogLevel level, size_t recordsPerThread)
+{
+    fmi4cLogger *logger = calloc(1, sizeof(fmi4cLogger));
+    if(logger == NULL) {
+        return NULL;
+    }
+    if(recordsPerThread == 0) {
+        recordsPerThread = LOG_DEFAULT_RECORDS_PER_THREAD;
+    }
+    size_t capacity = 1;
+    while(capacity < recordsPerThread) {
+        capacity *= 2;
+    }
+    logger->output = output ? output : stdout;
+    logger->level = (size_t)level;
+    logger->recordsPerThread = capacity;
+    logger->id = fmi4c_atomicFetchAdd(&nextLoggerId, 1);
+    logger->formatBufferSize = 2*LOG_TEXT_SIZE;
+    logger->formatBuffer = malloc(logger->formatBufferSize);
+    fmi4c_mutexInit(&logger->ringMutex);
+    fmi4c_mutexInit(&logger->mutex);
+    fmi4c_condInit(&logger->cond);
+    if(logger->formatBuffer == NULL || !fmi4c_threadCreate(&logger->thread, loggerThread, logger)) {
+        fmi4c_printMessage("Failed to start logger thread.");
+        fmi4c_condDestroy(&logger->cond);
+        fmi4c_mutexDestroy(&logger->mutex);
+        fmi4c_mutexDestroy(&logger->ringMutex);
+        free(logger->formatBuffer);
+        free(logger);
+        return NULL;
+    }
+    return logger;
+}
+
+//! @brief Writes all pending messages and stops the logger thread
+//! Must not be called while FMUs may still log to this logger.
+//! @param logger Logger handle
+void fmi4c_freeLogger(fmi4cLogger *logger)
+{
+    if(logger == NULL) {
+        return;
+    }
+    if(activeLogger == logger) {
+        activeLogger = NULL;
+    }
+    fmi4c_mutexLock(&logger->mutex);
+    logger->stopRequested = true;
+    fmi4c_condBroadcast(&logger->cond);
+    fmi4c_mutexUnlock(&logger->mutex);
+    fmi4c_threadJoin(logger->thread);
+
+    logRing_t *ring = logger->rings;
+    while(ring != NULL) {
+        logRing_t *next = ring->next;
+        free(ring->records);
+        free(ring);
+        ring = next;
+    }
+    for(size_t i=0; i<logger->numberOfDisabledCategories; ++i) {
+        freeCategory(logger->disabledCategories[i]);
+    }
+    while(logger->retiredCategories != NULL) {
+        logCategory_t *next = logger->retiredCategories->next;
+        freeCategory(logger->retiredCategories);
+        logger->retiredCategories = next;
+    }
+    fmi4c_condDestroy(&logger->cond);
+    fmi4c_mutexDestroy(&logger->mutex);
+    fmi4c_mutexDestroy(&logger->ringMutex);
+    free(logger->formatBuffer);
+    free(logger);
+}
+
+//! @brief Blocks until all messages logged before the call have been written
+//! @param logger Logger handle
+void fmi4c_flushLogger(fmi4cLogger *logger)
+{
+    fmi4c_mutexLock(&logger->mutex);
+    size_t ticket = ++logger->flushRequested;
+    fmi4c_condBroadcast(&logger->cond);
+    while(logger->flushCompleted < ticket && !logger->stopRequested) {
+        fmi4c_condWait(&logger->cond, &logger->mutex);
+    }
+    fmi4c_mutexUnlock(&logger->mutex);
+}
+
+void fmi4c_setLoggerLevel(fmi4cLogger *logger, fmi4cLogLevel level)
+{
+    fmi4c_atomicStoreRelease(&logger->level, (size_t)level);
+}
+
+//! @brief Enables or disables messages of a log category (all categories are enabled by default)
+//! Can be called while FMUs are logging, the number of disabled categories is limited.
+//! @param logger Logger handle
+//! @param category Category name
+//! @param enabled True to enable, false to disable
+void fmi4c_setLoggerCategoryEnabled(fmi4cLogger *logger, const char *category, bool enabled)
+{
+    fmi4c_mutexLock(&logger->ringMutex);
+    size_t n = logger->numberOfDisabledCategories;
+    size_t hash = hashString(category);
+    size_t i = 0;
+    while(i < n && !categoryMatches(logger->disabledCategories[i], hash, category)) {
+        ++i;
+    }
+    if(!enabled && i == n) {
+        logCategory_t *disabled = NULL;
+        if(n == LOG_MAX_DISABLED_CATEGORIES) {
+            fmi4c_printMessage("Too many disabled log categories.");
+        }
+        else if((disabled = takeRetiredCategory(logger, hash, category)) == NULL &&
+                (disabled = newCategory(hash, category)) == NULL) {
+            fmi4c_printMessage("Failed to disable log category.");
+        }
+        if(disabled != NULL) {
+            //The entry is complete before it is published, and its slot is set before the count is increased
+            fmi4c_atomicStorePointerRelease(&logger->disabledCategories[n], disabled);
+            fmi4c_atomicStoreRelease(&logger->numberOfDisabledCategories, n+1);
+        }
+    }
+    else if(enabled && i < n) {
+        //The last entry replaces the removed one with a single pointer store, so producers never see a partial entry.
+        //Producers may still read the removed entry, so it is retired instead of freed.
+        logCategory_t *removed = logger->disabledCategories[i];
+        fmi4c_atomicStorePointerRelease(&logger->disabledCategories[i], logger->disabledCategories[n-1]);
+        fmi4c_atomicStoreRelease(&logger->numberOfDisabledCategories, n-1);
+        removed->next = logger->retiredCategories;
+        logger->retiredCategories = removed;
+    }
+    fmi4c_mutexUnlock(&logger->ringMutex);
+}
+
+//! @brief Returns the number of messages dropped because a ring buffer was full
+size_t fmi4c_getLoggerNumberOfDroppedMessages(fmi4cLogger *logger)
+{
+    size_t dropped = 0;
+    fmi4c_mutexLock(&logger->ringMutex);
+    for(logRing_t *ring = logger->rings; ring != NULL; ring = ring->next) {
+        dropped += fmi4c_atomicLoadAcquire(&ring->dropped);
+    }
+    fmi4c_mutexUnlock(&logger->ringMutex);
+    return dropped;
+}
+
+//! @brief Returns the number of messages that did not fit in a log record and were truncated
+size_t fmi4c_getLoggerNumberOfTruncatedMessages(fmi4cLogger *logger)
+{
+    size_t truncated = 0;
+    fmi4c_mutexLock(&logger->ringMutex);
+    for(logRing_t *ring = logger->rings; ring != NULL; ring = ring->next) {
+        truncated += fmi4c_atomicLoadAcquire(&ring->truncated);
+    }
+    fmi4c_mutexUnlock(&logger->ringMutex);
+    return truncated;
+}
+
+//! @brief Selects the logger used by the fmi4c_loggerFmiX() callbacks
+//! @param logger Logger handle (NULL disables logging)
+void fmi4c_setActiveLogger(fmi4cLogger *logger)
+{
+    activeLogger = logger;
+}
+
+fmi4cLogger *fmi4c_getActiveLogger(void)
+{
+    return activeLogger;
+}
+
+void fmi4c_loggerFmi1(fmi1Component *component, fmi1String instanceName, fmi1Status status, fmi1String category, fmi1String message, ...)
+{
+    UNUSED(component)
+    fmi4cLogger *logger = activeLogger;
+    if(logger == NULL) {
+        return;
+    }
+    va_list args;
+    va_start(args, message);
+    logMessage(logger, 1, instanceName, (int)status, category, message, &args);
+    va_end(args);
+}
+
+void fmi4c_loggerFmi2(fmi2ComponentEnvironment componentEnvironment, fmi2String instanceName, fmi2Status status, fmi2String category, fmi2String message, ...)
+{
+    UNUSED(componentEnvironment)
+    fmi4cLogger *logger = activeLogger;
+    if(logger == NULL) {
+        return;
+    }
+    va_list args;
+    va_start(args, message);
+    logMessage(logger, 2, instanceName, (int)status, category, message, &args);
+    va_end(args);
+}
+
+void fmi4c_loggerFmi3(fmi3InstanceEnvironment instanceEnvironment, fmi3Status status, fmi3String category, fmi3String message)
+{
+    UNUSED(instanceEnvironment)
+    fmi4cLogger *logger = activeLogger;
+    if(logger == NULL) {
+        return;
+    }
+    logMessage(logger, 3, NULL, (int)status, category, message, NULL);
+}
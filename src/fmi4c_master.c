@@ -0,0 +1,1199 @@
+#include "fmi4c_private.h"
+#define FMI4C_H_INTERNAL_INCLUDE
+#include "fmi4c.h"
+#include "fmi4c_master.h"
+#include "fmi4c_common.h"
+#include "fmi4c_deque.h"
+#include "fmi4c_pool.h"
+#include "fmi4c_schedule.h"
+#include "fmi4c_threads.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define STEP_TIME_SMOOTHING 0.25        // Weight of the latest measurement in the average step time
+#define REBALANCE_TOLERANCE 1.1         // Re-place components when the predicted level time exceeds the lower bound by this factor
+#define STEP_SAFETY_FACTOR 0.9          // Adaptive stepping: margin to the step size predicted from the error estimate
+#define STEP_MAX_GROWTH 2.0
+#define STEP_MIN_SHRINK 0.2
+
+//! @brief Connection from a real output of one subsystem to a real input of another
+typedef struct {
+    int fromSubsystem;
+    unsigned int outputValueReference;
+    int toSubsystem;
+    unsigned int inputValueReference;
+} connection_t;
+
+//! @brief Subsystem with its I/O plan
+typedef struct {
+    fmiVersion_t fmiVersion;
+    fmi2InstanceHandle *fmi2Instance;
+    fmi3InstanceHandle *fmi3Instance;
+
+    size_t nInputs;
+    fmi2ValueReference *fmi2InputRefs;
+    fmi3ValueReference *fmi3InputRefs;
+    size_t *inputSources;       // Index of the connected output in the master output buffers
+    double *inputValues;
+
+    size_t nOutputs;
+    fmi2ValueReference *fmi2OutputRefs;
+    fmi3ValueReference *fmi3OutputRefs;
+    size_t outputOffset;        // Index of the first output in the master output buffers
+
+    fmi4cMasterStatus status;
+    int worker;                 // Worker the subsystem is bound to, or -1
+    double stepTime;            // Wall time of the last step, including I/O
+    double averageStepTime;
+    void *state;                // Saved FMU state for rollback (adaptive stepping only)
+} subsystem_t;
+
+//! @brief Component with its estimated cost, for placement
+typedef struct {
+    double cost;
+    int component;
+} rankedComponent_t;
+
+struct fmi4cMaster {
+    subsystem_t *subsystems;
+    int nSubsystems;
+    int subsystemCapacity;
+    connection_t *connections;
+    size_t nConnections;
+    size_t connectionCapacity;
+
+    fmi4cMasterMethod method;
+    int requestedThreads;
+    bool pinThreads;
+    fmi4cPool *pool;
+    fmi4cSchedule *schedule;
+
+    bool initialized;
+    size_t nOutputs;
+    double *outputBuffers[2];
+    int readBuffer;             // Buffer holding the outputs from the previous step (Jacobi only)
+
+    double currentTime;
+    double stepSize;
+    int currentLevel;           // Schedule level being stepped by the pool
+
+    bool workStealing;
+    int maxWidth;               // Components in the widest level
+    fmi4cDeque **deques;        // One per worker
+    int *componentWorker;       // Home worker of each schedule component, -1 before the first placement
+    int *componentBinding;      // Worker each component is bound to, or -1 if it may move between workers
+    int *nLevelBoundComponents; // Number of bound components in each level
+    rankedComponent_t *rankedComponents;
+    int *boundComponents;       // Bound components of the current level, maxWidth per worker
+    int *nBoundComponents;
+    double *workerLoads;
+    volatile size_t nSteals;
+
+    double busyTime;            // Sum of all subsystem step times
+    double wallTime;            // Sum of all master step times
+
+    bool adaptive;
+    double relativeTolerance;
+    double absoluteTolerance;
+    double adaptiveStepSize;    // Step size of the next adaptive step attempt
+    double minStepSize;
+    double maxStepSize;
+    double *savedOutputs;       // Outputs at the start of an adaptive step, restored on rollback
+    size_t nAcceptedSteps;
+    size_t nRejectedSteps;
+};
+
+//! @brief Creates an empty co-simulation master
+//! @returns Master handle, or NULL on failure
+fmi4cMaster *fmi4c_createMaster(void)
+{
+    fmi4cMaster *master = calloc(1, sizeof(fmi4cMaster));
+    if(master == NULL) {
+        return NULL;
+    }
+    master->relativeTolerance = 1e-4;
+    master->absoluteTolerance = 1e-6;
+    master->adaptiveStepSize = 1e-3;
+    master->minStepSize = 1e-8;
+    master->maxStepSize = 1;
+    return master;
+}
+
+void fmi4c_freeMaster(fmi4cMaster *master)
+{
+    if(master == NULL) {
+        return;
+    }
+    if(master->deques != NULL) {
+        for(int i=0; i<fmi4c_getMasterNumberOfThreads(master); ++i) {
+            fmi4c_freeDeque(master->deques[i]);
+        }
+    }
+    fmi4c_freePool(master->pool);
+    free(master->deques);
+    free(master->componentWorker);
+    free(master->componentBinding);
+    free(master->nLevelBoundComponents);
+    free(master->rankedComponents);
+    free(master->boundComponents);
+    free(master->nBoundComponents);
+    free(master->workerLoads);
+    for(int i=0; i<master->nSubsystems; ++i) {
+        subsystem_t *sub = &master->subsystems[i];
+        if(sub->state != NULL && sub->fmiVersion == fmiVersion2) {
+            fmi2_freeFMUstate(sub->fmi2Instance, &sub->state);
+        }
+        else if(sub->state != NULL) {
+            fmi3_freeFMUState(sub->fmi3Instance, &sub->state);
+        }
+        free(sub->fmi2InputRefs);
+        free(sub->fmi3InputRefs);
+        free(sub->inputSources);
+        free(sub->inputValues);
+        free(sub->fmi2OutputRefs);
+        free(sub->fmi3OutputRefs);
+    }
+    free(master->subsystems);
+    free(master->connections);
+    fmi4c_freeSchedule(master->schedule);
+    free(master->outputBuffers[0]);
+    free(master->outputBuffers[1]);
+    free(master->savedOutputs);
+    free(master);
+}
+
+static int addSubsystem(fmi4cMaster *master, fmiVersion_t fmiVersion, fmi2InstanceHandle *fmi2Instance, fmi3InstanceHandle *fmi3Instance)
+{
+    if(master->initialized) {
+        fmi4c_printMessage("Subsystems cannot be added after the master is initialized");
+        return -1;
+    }
+    if(master->nSubsystems == master->subsystemCapacity) {
+        int capacity = master->subsystemCapacity > 0 ? 2*master->subsystemCapacity : 16;
+        subsystem_t *subsystems = realloc(master->subsystems, (size_t)capacity*sizeof(subsystem_t));
+        if(subsystems == NULL) {
+            return -1;
+        }
+        master->subsystems = subsystems;
+        master->subsystemCapacity = capacity;
+    }
+    subsystem_t *sub = &master->subsystems[master->nSubsystems];
+    memset(sub, 0, sizeof(subsystem_t));
+    sub->fmiVersion = fmiVersion;
+    sub->fmi2Instance = fmi2Instance;
+    sub->fmi3Instance = fmi3Instance;
+    sub->worker = -1;
+    return master->nSubsystems++;
+}
+
+//! @brief Adds an FMI 2 co-simulation instance to the master
+//! @returns Subsystem index, or -1 on failure
+int fmi4c_addMasterSubsystemFmi2(fmi4cMaster *master, fmi2InstanceHandle *instance)
+{
+    return addSubsystem(master, fmiVersion2, instance, NULL);
+}
+
+//! @brief Adds an FMI 3 co-simulation instance to the master
+//! @returns Subsystem index, or -1 on failure
+int fmi4c_addMasterSubsystemFmi3(fmi4cMaster *master, fmi3InstanceHandle *instance)
+{
+    return addSubsystem(master, fmiVersion3, NULL, instance);
+}
+
+//! @brief Checks that a value reference refers to a real (Float64) variable of a subsystem
+static bool isRealVariable(subsystem_t *sub, unsigned int valueReference)
+{
+    if(sub->fmiVersion == fmiVersion2) {
+        fmi2VariableHandle *var = fmi2_getVariableByValueReference(sub->fmi2Instance->fmu, valueReference);
+        return var != NULL && fmi2_getVariableDataType(var) == fmi2DataTypeReal;
+    }
+    fmi3VariableHandle *var = fmi3_getVariableByValueReference(sub->fmi3Instance->fmu, valueReference);
+    return var != NULL && fmi3_getVariableDataType(var) == fmi3DataTypeFloat64;
+}
+
+//! @brief Connects a real output of one subsystem to a real input of another
+//! Each input can only be connected to one output.
+//! @returns True if the connection was added
+bool fmi4c_addMasterConnection(fmi4cMaster *master, int fromSubsystem, unsigned int outputValueReference, int toSubsystem, unsigned int inputValueReference)
+{
+    if(master->initialized) {
+        fmi4c_printMessage("Connections cannot be added after the master is initialized");
+        return false;
+    }
+    if(fromSubsystem < 0 || fromSubsystem >= master->nSubsystems ||
+       toSubsystem < 0 || toSubsystem >= master->nSubsystems) {
+        fmi4c_printMessage("Invalid subsystem index in connection");
+        return false;
+    }
+    if(!isRealVariable(&master->subsystems[fromSubsystem], outputValueReference) ||
+       !isRealVariable(&master->subsystems[toSubsystem], inputValueReference)) {
+        fmi4c_printMessage("Only real variables can be connected");
+        return false;
+    }
+    for(size_t i=0; i<master->nConnections; ++i) {
+        if(master->connections[i].toSubsystem == toSubsystem &&
+           master->connections[i].inputValueReference == inputValueReference) {
+            fmi4c_printMessage("Input is already connected");
+            return false;
+        }
+    }
+    if(master->nConnections == master->connectionCapacity) {
+        size_t capacity = master->connectionCapacity > 0 ? 2*master->connectionCapacity : 64;
+        connection_t *connections = realloc(master->connections, capacity*sizeof(connection_t));
+        if(connections == NULL) {
+            return false;
+        }
+        master->connections = connections;
+        master->connectionCapacity = capacity;
+    }
+    connection_t *connection = &master->connections[master->nConnections++];
+    connection->fromSubsystem = fromSubsystem;
+    connection->outputValueReference = outputValueReference;
+    connection->toSubsystem = toSubsystem;
+    connection->inputValueReference = inputValueReference;
+    return true;
+}
+
+//! @brief Selects Jacobi (default) or Gauss-Seidel stepping
+void fmi4c_setMasterMethod(fmi4cMaster *master, fmi4cMasterMethod method)
+{
+    if(master->initialized) {
+        fmi4c_printMessage("Master method cannot be changed after the master is initialized");
+        return;
+    }
+    master->method = method;
+}
+
+//! @brief Sets the number of worker threads used for stepping
+//! @param nThreads Number of threads including the calling thread (0 = number of processors)
+//! @param pinThreads Pin each worker thread to its own processor
+void fmi4c_setMasterThreads(fmi4cMaster *master, int nThreads, bool pinThreads)
+{
+    master->requestedThreads = nThreads;
+    master->pinThreads = pinThreads;
+}
+
+//! @brief Enables adaptive communication step sizes, see fmi4c_doMasterAdaptiveStep()
+//! All subsystems must be able to get and set their FMU state.
+void fmi4c_setMasterAdaptiveStep(fmi4cMaster *master, bool adaptive)
+{
+    if(master->initialized) {
+        fmi4c_printMessage("Adaptive stepping cannot be changed after the master is initialized");
+        return;
+    }
+    master->adaptive = adaptive;
+}
+
+//! @brief Sets the tolerances of the coupling error estimate (adaptive stepping only)
+void fmi4c_setMasterTolerance(fmi4cMaster *master, double relativeTolerance, double absoluteTolerance)
+{
+    master->relativeTolerance = relativeTolerance;
+    master->absoluteTolerance = absoluteTolerance;
+}
+
+//! @brief Sets the initial step size and the step size limits (adaptive stepping only)
+void fmi4c_setMasterStepSize(fmi4cMaster *master, double stepSize, double minStepSize, double maxStepSize)
+{
+    master->adaptiveStepSize = stepSize;
+    master->minStepSize = minStepSize;
+    master->maxStepSize = maxStepSize;
+}
+
+//! @brief Enables work-stealing placement of subsystems on the worker threads
+//! Components of each level are placed on workers by their measured step times (longest first, on the
+//! least loaded worker), and idle workers steal queued components from the others.
+void fmi4c_setMasterWorkStealing(fmi4cMaster *master, bool enabled)
+{
+    if(master->initialized) {
+        fmi4c_printMessage("Work stealing cannot be changed after the master is initialized");
+        return;
+    }
+    master->workStealing = enabled;
+}
+
+//! @brief Binds a subsystem to one worker thread
+//! A bound subsystem is always stepped by the same worker and is never stolen. Subsystems whose FMU
+//! can only be instantiated once per process are bound automatically. Worker 0 is the calling thread.
+//! @returns False if the subsystem index is invalid
+bool fmi4c_setMasterSubsystemWorker(fmi4cMaster *master, int subsystem, int worker)
+{
+    if(master->initialized) {
+        fmi4c_printMessage("Subsystem workers cannot be changed after the master is initialized");
+        return false;
+    }
+    if(subsystem < 0 || subsystem >= master->nSubsystems) {
+        fmi4c_printMessage("Invalid subsystem index");
+        return false;
+    }
+    master->subsystems[subsystem].worker = worker >= 0 ? worker : -1;
+    return true;
+}
+
+//! @brief Sorts connections by target subsystem, then by source subsystem and output
+static int compareConnections(const void *a, const void *b)
+{
+    const connection_t *ca = (const connection_t*)a;
+    const connection_t *cb = (const connection_t*)b;
+    if(ca->toSubsystem != cb->toSubsystem) {
+        return ca->toSubsystem < cb->toSubsystem ? -1 : 1;
+    }
+    if(ca->fromSubsystem != cb->fromSubsystem) {
+        return ca->fromSubsystem < cb->fromSubsystem ? -1 : 1;
+    }
+    if(ca->outputValueReference != cb->outputValueReference) {
+        return ca->outputValueReference < cb->outputValueReference ? -1 : 1;
+    }
+    return 0;
+}
+
+static int compareValueReferences(const void *a, const void *b)
+{
+    unsigned int va = *(const unsigned int*)a;
+    unsigned int vb = *(const unsigned int*)b;
+    return va < vb ? -1 : (va > vb ? 1 : 0);
+}
+
+//! @brief Allocates a value reference array of the subsystem's FMI version and fills it
+static bool setValueReferences(subsystem_t *sub, const unsigned int *refs, size_t n, fmi2ValueReference **fmi2Refs, fmi3ValueReference **fmi3Refs)
+{
+    size_t count = n > 0 ? n : 1;
+    if(sub->fmiVersion == fmiVersion2) {
+        *fmi2Refs = calloc(count, sizeof(fmi2ValueReference));
+        if(*fmi2Refs == NULL) {
+            return false;
+        }
+        for(size_t i=0; i<n; ++i) {
+            (*fmi2Refs)[i] = (fmi2ValueReference)refs[i];
+        }
+    }
+    else {
+        *fmi3Refs = calloc(count, sizeof(fmi3ValueReference));
+        if(*fmi3Refs == NULL) {
+            return false;
+        }
+        for(size_t i=0; i<n; ++i) {
+            (*fmi3Refs)[i] = (fmi3ValueReference)refs[i];
+        }
+    }
+    return true;
+}
+
+//! @brief Builds the output part of the I/O plans
+//! Each subsystem gets a sorted, unique list of its connected outputs, stored contiguously in the
+//! master output buffers.
+static bool buildOutputPlans(fmi4cMaster *master, unsigned int *refs)
+{
+    master->nOutputs = 0;
+    for(int s=0; s<master->nSubsystems; ++s) {
+        subsystem_t *sub = &master->subsystems[s];
+        size_t n = 0;
+        for(size_t i=0; i<master->nConnections; ++i) {
+            if(master->connections[i].fromSubsystem == s) {
+                refs[n++] = master->connections[i].outputValueReference;
+            }
+        }
+        qsort(refs, n, sizeof(unsigned int), compareValueReferences);
+        size_t nUnique = 0;
+        for(size_t i=0; i<n; ++i) {
+            if(nUnique == 0 || refs[nUnique-1] != refs[i]) {
+                refs[nUnique++] = refs[i];
+            }
+        }
+        sub->nOutputs = nUnique;
+        sub->outputOffset = master->nOutputs;
+        master->nOutputs += nUnique;
+        if(!setValueReferences(sub, refs, nUnique, &sub->fmi2OutputRefs, &sub->fmi3OutputRefs)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//! @brief Returns the position of an output in the master output buffers
+static size_t findOutput(fmi4cMaster *master, int subsystem, unsigned int valueReference)
+{
+    subsystem_t *sub = &master->subsystems[subsystem];
+    size_t lo = 0;
+    size_t hi = sub->nOutputs;
+    while(lo < hi) {
+        size_t mid = (lo+hi)/2;
+        unsigned int ref = sub->fmiVersion == fmiVersion2 ? sub->fmi2OutputRefs[mid] : sub->fmi3OutputRefs[mid];
+        if(ref < valueReference) {
+            lo = mid+1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return sub->outputOffset+lo;
+}
+
+//! @brief Builds the input part of the I/O plans (connections must be sorted by target subsystem)
+static bool buildInputPlans(fmi4cMaster *master, unsigned int *refs)
+{
+    size_t c = 0;
+    for(int s=0; s<master->nSubsystems; ++s) {
+        subsystem_t *sub = &master->subsystems[s];
+        size_t first = c;
+        while(c < master->nConnections && master->connections[c].toSubsystem == s) {
+            refs[c-first] = master->connections[c].inputValueReference;
+            ++c;
+        }
+        sub->nInputs = c-first;
+        size_t count = sub->nInputs > 0 ? sub->nInputs : 1;
+        sub->inputSources = calloc(count, sizeof(size_t));
+        sub->inputValues = calloc(count, sizeof(double));
+        if(sub->inputSources == NULL || sub->inputValues == NULL ||
+           !setValueReferences(sub, refs, sub->nInputs, &sub->fmi2InputRefs, &sub->fmi3InputRefs)) {
+            return false;
+        }
+        for(size_t i=0; i<sub->nInputs; ++i) {
+            connection_t *connection = &master->connections[first+i];
+            sub->inputSources[i] = findOutput(master, connection->fromSubsystem, connection->outputValueReference);
+        }
+    }
+    return true;
+}
+
+//! @brief Returns the index of a value reference in a sorted reference array, or -1
+static int findValueReference(subsystem_t *sub, const fmi2ValueReference *fmi2Refs, const fmi3ValueReference *fmi3Refs, size_t n, unsigned int valueReference)
+{
+    size_t lo = 0;
+    size_t hi = n;
+    while(lo < hi) {
+        size_t mid = (lo+hi)/2;
+        unsigned int ref = sub->fmiVersion == fmiVersion2 ? fmi2Refs[mid] : fmi3Refs[mid];
+        if(ref == valueReference) {
+            return (int)mid;
+        }
+        if(ref < valueReference) {
+            lo = mid+1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return -1;
+}
+
+//! @brief Marks the connected inputs of a subsystem that have direct feedthrough to a connected output
+//! Outputs without declared dependencies are assumed to depend on all inputs.
+//! @param first Index of the first connection to the subsystem (connections are sorted by target)
+static void findFeedthrough(fmi4cMaster *master, int s, size_t first, bool *feedthrough)
+{
+    subsystem_t *sub = &master->subsystems[s];
+    for(size_t i=0; i<sub->nInputs; ++i) {
+        feedthrough[first+i] = false;
+    }
+    if(sub->nInputs == 0 || sub->nOutputs == 0) {
+        return;
+    }
+    fmuHandle *fmu = sub->fmiVersion == fmiVersion2 ? sub->fmi2Instance->fmu : sub->fmi3Instance->fmu;
+    int nRows = sub->fmiVersion == fmiVersion2 ? fmi2_getNumberOfModelStructureOutputs(fmu) : fmi3_getNumberOfModelStructureOutputs(fmu);
+    for(int r=0; r<nRows; ++r) {
+        int nDependencies;
+        bool defined;
+        unsigned int outputRef;
+        fmi2ModelStructureHandle *row2 = NULL;
+        fmi3ModelStructureHandle *row3 = NULL;
+        if(sub->fmiVersion == fmiVersion2) {
+            row2 = fmi2_getModelStructureOutput(fmu, (size_t)r);
+            fmi2VariableHandle *var = fmi2_getVariableByIndex(fmu, fmi2_getModelStructureIndex(row2));
+            if(var == NULL) {
+                continue;
+            }
+            outputRef = fmi2_getVariableValueReference(var);
+            nDependencies = fmi2_getModelStructureNumberOfDependencies(row2);
+            defined = fmi2_getModelStructureDependenciesDefined(row2);
+        }
+        else {
+            row3 = fmi3_getModelStructureOutput(fmu, (size_t)r);
+            outputRef = fmi3_getModelStructureValueReference(row3);
+            nDependencies = fmi3_getModelStructureNumberOfDependencies(row3);
+            defined = fmi3_getModelStructureDependenciesDefined(row3);
+        }
+        if(findValueReference(sub, sub->fmi2OutputRefs, sub->fmi3OutputRefs, sub->nOutputs, outputRef) < 0) {
+            continue;   // Output is not connected
+        }
+        if(!defined) {
+            for(size_t i=0; i<sub->nInputs; ++i) {
+                feedthrough[first+i] = true;
+            }
+            return;
+        }
+        if(nDependencies <= 0) {
+            continue;
+        }
+        int *dependencies = malloc((size_t)nDependencies*sizeof(int));
+        if(dependencies == NULL) {
+            for(size_t i=0; i<sub->nInputs; ++i) {
+                feedthrough[first+i] = true;
+            }
+            return;
+        }
+        if(sub->fmiVersion == fmiVersion2) {
+            fmi2_getModelStructureDependencies(row2, dependencies, (size_t)nDependencies);
+        }
+        else {
+            fmi3_getModelStructureDependencies(row3, dependencies, (size_t)nDependencies);
+        }
+        for(int k=0; k<nDependencies; ++k) {
+            unsigned int inputRef = (unsigned int)dependencies[k];     // FMI 3 dependencies are value references
+            if(sub->fmiVersion == fmiVersion2) {
+                fmi2VariableHandle *var = fmi2_getVariableByIndex(fmu, dependencies[k]);
+                if(var == NULL) {
+                    continue;
+                }
+                inputRef = fmi2_getVariableValueReference(var);
+            }
+            for(size_t i=0; i<sub->nInputs; ++i) {
+                unsigned int ref = sub->fmiVersion == fmiVersion2 ? sub->fmi2InputRefs[i] : sub->fmi3InputRefs[i];
+                if(ref == inputRef) {
+                    feedthrough[first+i] = true;
+                }
+            }
+        }
+        free(dependencies);
+    }
+}
+
+//! @brief Builds the execution schedule, one level for Jacobi or the connection graph levels for Gauss-Seidel
+static bool buildSchedule(fmi4cMaster *master)
+{
+    if(master->method == fmi4cMasterJacobi) {
+        master->schedule = fmi4c_createParallelSchedule(master->nSubsystems);
+        return master->schedule != NULL;
+    }
+
+    size_t nEdges = master->nConnections;
+    int *edgeFrom = malloc((nEdges > 0 ? nEdges : 1)*sizeof(int));
+    int *edgeTo = malloc((nEdges > 0 ? nEdges : 1)*sizeof(int));
+    bool *edgeFeedthrough = malloc((nEdges > 0 ? nEdges : 1)*sizeof(bool));
+    if(edgeFrom == NULL || edgeTo == NULL || edgeFeedthrough == NULL) {
+        free(edgeFrom);
+        free(edgeTo);
+        free(edgeFeedthrough);
+        return false;
+    }
+    size_t first = 0;
+    for(int s=0; s<master->nSubsystems; ++s) {
+        findFeedthrough(master, s, first, edgeFeedthrough);
+        first += master->subsystems[s].nInputs;
+    }
+    for(size_t i=0; i<nEdges; ++i) {
+        edgeFrom[i] = master->connections[i].fromSubsystem;
+        edgeTo[i] = master->connections[i].toSubsystem;
+    }
+    master->schedule = fmi4c_createSchedule(master->nSubsystems, nEdges, edgeFrom, edgeTo, edgeFeedthrough);
+    free(edgeFrom);
+    free(edgeTo);
+    free(edgeFeedthrough);
+    if(master->schedule == NULL) {
+        return false;
+    }
+    if(master->schedule->nAlgebraicLoops > 0) {
+        char msg[128];
+        snprintf(msg, sizeof(msg), "Connection graph contains %i algebraic loop(s), they are broken with a one step delay", master->schedule->nAlgebraicLoops);
+        fmi4c_printMessage(msg);
+    }
+    return true;
+}
+
+static bool getOutputs(subsystem_t *sub, double *buffer)
+{
+    if(sub->nOutputs == 0) {
+        return true;
+    }
+    double *values = buffer+sub->outputOffset;
+    if(sub->fmiVersion == fmiVersion2) {
+        return fmi2_getReal(sub->fmi2Instance, sub->fmi2OutputRefs, sub->nOutputs, values) <= fmi2Warning;
+    }
+    return fmi3_getFloat64(sub->fmi3Instance, sub->fmi3OutputRefs, sub->nOutputs, values, sub->nOutputs) <= fmi3Warning;
+}
+
+static bool setInputs(subsystem_t *sub, const double *buffer)
+{
+    if(sub->nInputs == 0) {
+        return true;
+    }
+    for(size_t i=0; i<sub->nInputs; ++i) {
+        sub->inputValues[i] = buffer[sub->inputSources[i]];
+    }
+    if(sub->fmiVersion == fmiVersion2) {
+        return fmi2_setReal(sub->fmi2Instance, sub->fmi2InputRefs, sub->nInputs, sub->inputValues) <= fmi2Warning;
+    }
+    return fmi3_setFloat64(sub->fmi3Instance, sub->fmi3InputRefs, sub->nInputs, sub->inputValues, sub->nInputs) <= fmi3Warning;
+}
+
+static fmi4cMasterStatus doStep(subsystem_t *sub, double currentTime, double stepSize, bool noSetFMUStatePriorToCurrentPoint)
+{
+    if(sub->fmiVersion == fmiVersion2) {
+        fmi2Status status = fmi2_doStep(sub->fmi2Instance, currentTime, stepSize, noSetFMUStatePriorToCurrentPoint);
+        if(status == fmi2Discard) {
+            fmi2Boolean terminated = fmi2False;
+            if(fmi2_getBooleanStatus(sub->fmi2Instance, fmi2Terminated, &terminated) <= fmi2Warning && terminated) {
+                return fmi4cMasterTerminate;
+            }
+        }
+        return status <= fmi2Warning ? fmi4cMasterOK : fmi4cMasterError;
+    }
+    fmi3Boolean eventEncountered = fmi3False;
+    fmi3Boolean terminateSimulation = fmi3False;
+    fmi3Boolean earlyReturn = fmi3False;
+    fmi3Float64 lastSuccessfulTime = currentTime;
+    fmi3Status status = fmi3_doStep(sub->fmi3Instance, currentTime, stepSize, noSetFMUStatePriorToCurrentPoint,
+                                    &eventEncountered, &terminateSimulation, &earlyReturn, &lastSuccessfulTime);
+    if(status > fmi3Warning) {
+        return fmi4cMasterError;
+    }
+    return terminateSimulation ? fmi4cMasterTerminate : fmi4cMasterOK;
+}
+
+static void stepSubsystem(fmi4cMaster *master, subsystem_t *sub, const double *readBuffer, double *writeBuffer)
+{
+    double startTime = fmi4c_getWallTime();
+    if(!setInputs(sub, readBuffer)) {
+        sub->status = fmi4cMasterError;
+    }
+    else {
+        sub->status = doStep(sub, master->currentTime, master->stepSize, !master->adaptive);
+        if(sub->status != fmi4cMasterError && !getOutputs(sub, writeBuffer)) {
+            sub->status = fmi4cMasterError;
+        }
+    }
+    sub->stepTime = fmi4c_getWallTime()-startTime;
+}
+
+//! @brief Steps the members of a schedule component serially
+static void stepComponent(fmi4cMaster *master, int component)
+{
+    fmi4cSchedule *schedule = master->schedule;
+    const double *readBuffer = master->outputBuffers[master->readBuffer];
+    double *writeBuffer = master->outputBuffers[master->method == fmi4cMasterJacobi ? 1-master->readBuffer : master->readBuffer];
+    for(int i=schedule->componentStart[component]; i<schedule->componentStart[component+1]; ++i) {
+        stepSubsystem(master, &master->subsystems[schedule->order[i]], readBuffer, writeBuffer);
+    }
+}
+
+//! @brief Pool task: steps the bound components and one worker's contiguous share of the other components in the current level
+//! Members of a component are stepped serially. With Gauss-Seidel, inputs are read from the same
+//! buffer that outputs are written to, so they see the new outputs of all earlier levels.
+static void stepLevel(void *context, int worker)
+{
+    fmi4cMaster *master = (fmi4cMaster*)context;
+    fmi4cSchedule *schedule = master->schedule;
+    int nWorkers = fmi4c_getPoolNumberOfWorkers(master->pool);
+    int levelBegin = schedule->levelStart[master->currentLevel];
+    int levelEnd = schedule->levelStart[master->currentLevel+1];
+    int nUnbound = levelEnd-levelBegin-master->nLevelBoundComponents[master->currentLevel];
+    int begin = (int)((long long)worker*nUnbound/nWorkers);
+    int end = (int)((long long)(worker+1)*nUnbound/nWorkers);
+    int unbound = 0;
+    for(int k=levelBegin; k<levelEnd; ++k) {
+        int binding = master->componentBinding[k];
+        if(binding >= 0 ? binding == worker : (unbound >= begin && unbound < end)) {
+            stepComponent(master, k);
+        }
+        if(binding < 0) {
+            ++unbound;
+        }
+    }
+}
+
+//! @brief Pool task: steps the bound components and the own queue of one worker, then steals from the others
+//! A worker returns when a full sweep over the other queues finds them all empty. No tasks are added
+//! while a level is stepped, so no work can appear after that.
+static void stealLevel(void *context, int worker)
+{
+    fmi4cMaster *master = (fmi4cMaster*)context;
+    int nWorkers = fmi4c_getPoolNumberOfWorkers(master->pool);
+    int *bound = master->boundComponents+(size_t)worker*(size_t)master->maxWidth;
+    for(int i=0; i<master->nBoundComponents[worker]; ++i) {
+        stepComponent(master, bound[i]);
+    }
+
+    int component;
+    while(fmi4c_popDeque(master->deques[worker], &component)) {
+        stepComponent(master, component);
+    }
+
+    bool retry = true;
+    while(retry) {
+        retry = false;
+        for(int i=1; i<nWorkers; ++i) {
+            fmi4cDequeResult result = fmi4c_stealDeque(master->deques[(worker+i) % nWorkers], &component);
+            if(result == fmi4cDequeSuccess) {
+                fmi4c_atomicFetchAdd(&master->nSteals, 1);
+                stepComponent(master, component);
+                retry = true;
+                break;
+            }
+            if(result == fmi4cDequeAbort) {
+                retry = true;
+            }
+        }
+    }
+}
+
+static int compareRankedComponents(const void *a, const void *b)
+{
+    const rankedComponent_t *ra = (const rankedComponent_t*)a;
+    const rankedComponent_t *rb = (const rankedComponent_t*)b;
+    if(ra->cost != rb->cost) {
+        return ra->cost > rb->cost ? -1 : 1;
+    }
+    return ra->component < rb->component ? -1 : (ra->component > rb->component ? 1 : 0);
+}
+
+//! @brief Fills the worker queues for a level, re-placing the components if the workers are unbalanced
+//! Component costs are the smoothed step times of their members. Components keep their home worker
+//! as long as the predicted level time is within the tolerance of the lower bound (the largest of the
+//! average load and the most expensive component), otherwise they are placed longest first on the
+//! least loaded worker. Stealing only evens out the remaining imbalance within a step. After a
+//! placement each queue is filled cheapest first, so owners pop their most expensive components first
+//! and thieves take the cheap ones.
+static void prepareLevel(fmi4cMaster *master, int level)
+{
+    fmi4cSchedule *schedule = master->schedule;
+    int nWorkers = fmi4c_getPoolNumberOfWorkers(master->pool);
+    int begin = schedule->levelStart[level];
+    int n = schedule->levelStart[level+1]-begin;
+
+    for(int w=0; w<nWorkers; ++w) {
+        master->workerLoads[w] = 0;
+        master->nBoundComponents[w] = 0;
+        fmi4c_clearDeque(master->deques[w]);
+    }
+    bool place = false;
+    double totalCost = 0;
+    double maxCost = 0;
+    for(int i=0; i<n; ++i) {
+        int k = begin+i;
+        double cost = 1e-9;     // Spreads components evenly before any step times are known
+        for(int j=schedule->componentStart[k]; j<schedule->componentStart[k+1]; ++j) {
+            cost += master->subsystems[schedule->order[j]].averageStepTime;
+        }
+        master->rankedComponents[i].cost = cost;
+        master->rankedComponents[i].component = k;
+        totalCost += cost;
+        maxCost = cost > maxCost ? cost : maxCost;
+        int w = master->componentBinding[k] >= 0 ? master->componentBinding[k] : master->componentWorker[k];
+        if(w < 0) {
+            place = true;
+        }
+        else {
+            master->workerLoads[w] += cost;
+        }
+    }
+    double lowerBound = totalCost/nWorkers > maxCost ? totalCost/nWorkers : maxCost;
+    for(int w=0; w<nWorkers && !place; ++w) {
+        place = master->workerLoads[w] > REBALANCE_TOLERANCE*lowerBound;
+    }
+    if(place) {
+        qsort(master->rankedComponents, (size_t)n, sizeof(rankedComponent_t), compareRankedComponents);
+        for(int w=0; w<nWorkers; ++w) {
+            master->workerLoads[w] = 0;
+        }
+        for(int i=0; i<n; ++i) {
+            int k = master->rankedComponents[i].component;
+            if(master->componentBinding[k] >= 0) {
+                master->workerLoads[master->componentBinding[k]] += master->rankedComponents[i].cost;
+            }
+        }
+        for(int i=0; i<n; ++i) {
+            int k = master->rankedComponents[i].component;
+            if(master->componentBinding[k] >= 0) {
+                continue;
+            }
+            int best = 0;
+            for(int w=1; w<nWorkers; ++w) {
+                if(master->workerLoads[w] < master->workerLoads[best]) {
+                    best = w;
+                }
+            }
+            master->componentWorker[k] = best;
+            master->workerLoads[best] += master->rankedComponents[i].cost;
+        }
+    }
+
+    for(int i=n-1; i>=0; --i) {
+        int k = master->rankedComponents[i].component;
+        if(master->componentBinding[k] >= 0) {
+            int w = master->componentBinding[k];
+            master->boundComponents[(size_t)w*(size_t)master->maxWidth+(size_t)master->nBoundComponents[w]++] = k;
+        }
+        else {
+            fmi4c_pushDeque(master->deques[master->componentWorker[k]], k);
+        }
+    }
+}
+
+//! @brief Returns true if the FMU of a subsystem can only be instantiated once per process
+static bool isOncePerProcess(subsystem_t *sub)
+{
+    if(sub->fmiVersion == fmiVersion2) {
+        return fmi2cs_getCanBeInstantiatedOnlyOncePerProcess(sub->fmi2Instance->fmu);
+    }
+    return fmi3cs_getCanBeInstantiatedOnlyOncePerProcess(sub->fmi3Instance->fmu);
+}
+
+//! @brief Allocates the work stealing state
+static bool initializeWorkStealing(fmi4cMaster *master, int nWorkers)
+{
+    size_t nComponents = (size_t)master->schedule->nComponents;
+    master->deques = calloc((size_t)nWorkers, sizeof(fmi4cDeque*));
+    master->componentWorker = malloc(nComponents*sizeof(int));
+    master->rankedComponents = calloc((size_t)master->maxWidth, sizeof(rankedComponent_t));
+    master->boundComponents = calloc((size_t)nWorkers*(size_t)master->maxWidth, sizeof(int));
+    master->nBoundComponents = calloc((size_t)nWorkers, sizeof(int));
+    master->workerLoads = calloc((size_t)nWorkers, sizeof(double));
+    if(master->deques == NULL || master->componentWorker == NULL || master->rankedComponents == NULL ||
+       master->boundComponents == NULL || master->nBoundComponents == NULL || master->workerLoads == NULL) {
+        return false;
+    }
+    for(int w=0; w<nWorkers; ++w) {
+        master->deques[w] = fmi4c_createDeque((size_t)master->maxWidth);
+        if(master->deques[w] == NULL) {
+            return false;
+        }
+    }
+    for(size_t k=0; k<nComponents; ++k) {
+        master->componentWorker[k] = -1;
+    }
+    return true;
+}
+
+//! @brief Binds the components to workers
+//! Subsystems of FMUs that can only be instantiated once per process may rely on global state, so
+//! they are kept on one worker. Unless bound explicitly, they are spread over the workers round-robin.
+static bool bindComponents(fmi4cMaster *master, int nWorkers)
+{
+    fmi4cSchedule *schedule = master->schedule;
+    master->componentBinding = malloc((size_t)schedule->nComponents*sizeof(int));
+    master->nLevelBoundComponents = calloc((size_t)schedule->nLevels, sizeof(int));
+    if(master->componentBinding == NULL || master->nLevelBoundComponents == NULL) {
+        return false;
+    }
+
+    int nextWorker = 0;
+    for(int s=0; s<master->nSubsystems; ++s) {
+        subsystem_t *sub = &master->subsystems[s];
+        if(sub->worker >= nWorkers) {
+            fmi4c_printMessage("Subsystem is bound to a non-existing worker, using the worker with the same index modulo the number of workers");
+            sub->worker %= nWorkers;
+        }
+        else if(sub->worker < 0 && isOncePerProcess(sub)) {
+            sub->worker = nextWorker;
+            nextWorker = (nextWorker+1) % nWorkers;
+        }
+    }
+    for(int k=0; k<schedule->nComponents; ++k) {
+        master->componentBinding[k] = -1;
+        for(int i=schedule->componentStart[k]; i<schedule->componentStart[k+1]; ++i) {
+            int worker = master->subsystems[schedule->order[i]].worker;
+            if(worker < 0) {
+                continue;
+            }
+            if(master->componentBinding[k] < 0) {
+                master->componentBinding[k] = worker;
+            }
+            else if(master->componentBinding[k] != worker) {
+                fmi4c_printMessage("Subsystems in a coupling loop are bound to different workers, the loop is stepped by the first one");
+            }
+        }
+    }
+    for(int l=0; l<schedule->nLevels; ++l) {
+        for(int k=schedule->levelStart[l]; k<schedule->levelStart[l+1]; ++k) {
+            master->nLevelBoundComponents[l] += (master->componentBinding[k] >= 0);
+        }
+    }
+    return true;
+}
+
+//! @brief Builds the I/O plans, starts the worker threads and reads the initial outputs
+//! All instances must have exited initialization mode.
+//! @returns True on success
+bool fmi4c_initializeMaster(fmi4cMaster *master)
+{
+    if(master->initialized) {
+        return true;
+    }
+    if(master->nSubsystems == 0) {
+        fmi4c_printMessage("Master has no subsystems");
+        return false;
+    }
+
+    qsort(master->connections, master->nConnections, sizeof(connection_t), compareConnections);
+    unsigned int *refs = malloc((master->nConnections > 0 ? master->nConnections : 1)*sizeof(unsigned int));
+    if(refs == NULL) {
+        return false;
+    }
+    bool ok = buildOutputPlans(master, refs) && buildInputPlans(master, refs);
+    free(refs);
+    if(!ok || !buildSchedule(master)) {
+        return false;
+    }
+
+    size_t nValues = master->nOutputs > 0 ? master->nOutputs : 1;
+    master->outputBuffers[0] = calloc(nValues, sizeof(double));
+    master->outputBuffers[1] = calloc(nValues, sizeof(double));
+    if(master->outputBuffers[0] == NULL || master->outputBuffers[1] == NULL) {
+        return false;
+    }
+    for(int s=0; s<master->nSubsystems; ++s) {
+        if(!getOutputs(&master->subsystems[s], master->outputBuffers[0])) {
+            fmi4c_printMessage("Failed to read initial outputs");
+            return false;
+        }
+    }
+    master->readBuffer = 0;
+
+    // No more workers than components in the widest level
+    master->maxWidth = 1;
+    for(int l=0; l<master->schedule->nLevels; ++l) {
+        int width = master->schedule->levelStart[l+1]-master->schedule->levelStart[l];
+        if(width > master->maxWidth) {
+            master->maxWidth = width;
+        }
+    }
+    int nThreads = master->requestedThreads > 0 ? master->requestedThreads : fmi4c_getNumberOfProcessors();
+    if(nThreads > master->maxWidth) {
+        nThreads = master->maxWidth;
+    }
+    master->pool = fmi4c_createPool(nThreads, master->pinThreads);
+    if(master->pool == NULL) {
+        fmi4c_printMessage("Failed to start worker threads");
+        return false;
+    }
+    if(!bindComponents(master, nThreads)) {
+        return false;
+    }
+    if(master->workStealing && !initializeWorkStealing(master, nThreads)) {
+        fmi4c_printMessage("Failed to allocate work stealing queues");
+        return false;
+    }
+    if(master->adaptive) {
+        for(int s=0; s<master->nSubsystems; ++s) {
+            subsystem_t *sub = &master->subsystems[s];
+            if((sub->fmiVersion == fmiVersion2 && !fmi2cs_getCanGetAndSetFMUState(sub->fmi2Instance->fmu)) ||
+               (sub->fmiVersion == fmiVersion3 && !fmi3cs_getCanGetAndSetFMUState(sub->fmi3Instance->fmu))) {
+                fmi4c_printMessage("Adaptive stepping requires that all subsystems can get and set their FMU state");
+                return false;
+            }
+        }
+        master->savedOutputs = calloc(nValues, sizeof(double));
+        if(master->savedOutputs == NULL) {
+            return false;
+        }
+    }
+
+    master->initialized = true;
+    return true;
+}
+
+//! @brief Steps all levels, collects the step statistics and returns the combined status of the subsystems
+static fmi4cMasterStatus stepLevels(fmi4cMaster *master, double currentTime, double stepSize)
+{
+    double startTime = fmi4c_getWallTime();
+    master->currentTime = currentTime;
+    master->stepSize = stepSize;
+    for(int l=0; l<master->schedule->nLevels; ++l) {
+        master->currentLevel = l;
+        int first = master->schedule->levelStart[l];
+        if(master->schedule->levelStart[l+1]-first == 1 && master->componentBinding[first] <= 0) {
+            stepComponent(master, first);  // Stepped by the calling thread (worker 0) without waking the pool
+        }
+        else if(master->workStealing) {
+            prepareLevel(master, l);
+            fmi4c_runPool(master->pool, stealLevel, master);
+        }
+        else {
+            fmi4c_runPool(master->pool, stepLevel, master);
+        }
+    }
+    master->wallTime += fmi4c_getWallTime()-startTime;
+
+    fmi4cMasterStatus status = fmi4cMasterOK;
+    for(int s=0; s<master->nSubsystems; ++s) {
+        subsystem_t *sub = &master->subsystems[s];
+        if(sub->status > status) {
+            status = sub->status;
+        }
+        master->busyTime += sub->stepTime;
+        if(sub->averageStepTime == 0) {
+            sub->averageStepTime = sub->stepTime;
+        }
+        else {
+            sub->averageStepTime += STEP_TIME_SMOOTHING*(sub->stepTime-sub->averageStepTime);
+        }
+    }
+    return status;
+}
+
+//! @brief Steps all subsystems from currentTime to currentTime+stepSize
+//! With Jacobi stepping all subsystems step concurrently with inputs from the outputs at currentTime.
+//! With Gauss-Seidel stepping the levels are stepped in order, and the subsystems within each level
+//! concurrently, so inputs receive the outputs at currentTime+stepSize from earlier levels.
+//! @returns fmi4cMasterError if any subsystem failed, fmi4cMasterTerminate if any requested termination
+fmi4cMasterStatus fmi4c_doMasterStep(fmi4cMaster *master, double currentTime, double stepSize)
+{
+    if(!master->initialized) {
+        fmi4c_printMessage("Master must be initialized before stepping");
+        return fmi4cMasterError;
+    }
+    fmi4cMasterStatus status = stepLevels(master, currentTime, stepSize);
+    if(master->method == fmi4cMasterJacobi) {
+        master->readBuffer = 1-master->readBuffer;
+    }
+    return status;
+}
+
+//! @brief Saves (save = true) or restores the FMU states of all subsystems
+static bool saveOrRestoreStates(fmi4cMaster *master, bool save)
+{
+    for(int s=0; s<master->nSubsystems; ++s) {
+        subsystem_t *sub = &master->subsystems[s];
+        bool ok;
+        if(sub->fmiVersion == fmiVersion2) {
+            ok = (save ? fmi2_getFMUstate(sub->fmi2Instance, &sub->state) : fmi2_setFMUstate(sub->fmi2Instance, sub->state)) <= fmi2Warning;
+        }
+        else {
+            ok = (save ? fmi3_getFMUState(sub->fmi3Instance, &sub->state) : fmi3_setFMUState(sub->fmi3Instance, sub->state)) <= fmi3Warning;
+        }
+        if(!ok) {
+            fmi4c_printMessage(save ? "Failed to get FMU state" : "Failed to set FMU state");
+            return false;
+        }
+    }
+    return true;
+}
+
+//! @brief Returns the coupling error of the last step relative to the tolerances (1 = at the tolerance)
+//! Inputs are held constant over a step, so the error of an input is the difference between the value
+//! it was held at and the value of its source output at the end of the step. With Gauss-Seidel this is
+//! zero for inputs from earlier levels, only the delayed connections contribute.
+static double estimateCouplingError(fmi4cMaster *master)
+{
+    const double *outputs = master->outputBuffers[master->method == fmi4cMasterJacobi ? 1-master->readBuffer : master->readBuffer];
+    double error = 0;
+    for(int s=0; s<master->nSubsystems; ++s) {
+        subsystem_t *sub = &master->subsystems[s];
+        for(size_t i=0; i<sub->nInputs; ++i) {
+            double held = sub->inputValues[i];
+            double actual = outputs[sub->inputSources[i]];
+            double scale = master->absoluteTolerance+master->relativeTolerance*fmax(fabs(held), fabs(actual));
+            error = fmax(error, fabs(actual-held)/scale);
+        }
+    }
+    return error;
+}
+
+//! @brief Takes one adaptive step from currentTime, with a step size chosen from the coupling error
+//! The FMU states are saved before the step. If the estimated coupling error exceeds the tolerance,
+//! all subsystems are rolled back and the step is retried with a smaller step size, otherwise the step
+//! is accepted and the next step size is increased or decreased. The error is proportional to the step
+//! size, since inputs are held constant over each step.
+//! @param stopTime The step never goes beyond this time
+//! @param nextTime Returns the end time of the accepted step
+//! @returns fmi4cMasterError if any subsystem failed, fmi4cMasterTerminate if any requested termination
+fmi4cMasterStatus fmi4c_doMasterAdaptiveStep(fmi4cMaster *master, double currentTime, double stopTime, double *nextTime)
+{
+    *nextTime = currentTime;
+    if(!master->initialized || !master->adaptive) {
+        fmi4c_printMessage("Master must be initialized with adaptive stepping enabled");
+        return fmi4cMasterError;
+    }
+    if(stopTime <= currentTime) {
+        return fmi4cMasterOK;
+    }
+    if(!saveOrRestoreStates(master, true)) {
+        return fmi4cMasterError;
+    }
+    double *outputs = master->outputBuffers[master->readBuffer];
+    memcpy(master->savedOutputs, outputs, master->nOutputs*sizeof(double));
+
+    double stepSize = fmin(master->adaptiveStepSize, stopTime-currentTime);
+    while(true) {
+        fmi4cMasterStatus status = stepLevels(master, currentTime, stepSize);
+        if(status == fmi4cMasterError) {
+            return status;
+        }
+        double error = estimateCouplingError(master);
+        double factor = error > 0 ? STEP_SAFETY_FACTOR/error : STEP_MAX_GROWTH;
+        factor = fmin(STEP_MAX_GROWTH, fmax(STEP_MIN_SHRINK, factor));
+        if(error <= 1 || stepSize <= master->minStepSize) {
+            ++master->nAcceptedSteps;
+            master->adaptiveStepSize = fmin(master->maxStepSize, fmax(master->minStepSize, stepSize*factor));
+            if(master->method == fmi4cMasterJacobi) {
+                master->readBuffer = 1-master->readBuffer;
+            }
+            *nextTime = currentTime+stepSize;
+            return status;
+        }
+
+        ++master->nRejectedSteps;
+        if(!saveOrRestoreStates(master, false)) {
+            return fmi4cMasterError;
+        }
+        memcpy(outputs, master->savedOutputs, master->nOutputs*sizeof(double));
+        stepSize = fmax(master->minStepSize, stepSize*factor);
+    }
+}
+
+//! @brief Returns the number of accepted adaptive steps
+size_t fmi4c_getMasterNumberOfAcceptedSteps(fmi4cMaster *master)
+{
+    return master->nAcceptedSteps;
+}
+
+//! @brief Returns the number of rejected (rolled back) adaptive steps
+size_t fmi4c_getMasterNumberOfRejectedSteps(fmi4cMaster *master)
+{
+    return master->nRejectedSteps;
+}
+
+int fmi4c_getMasterNumberOfSubsystems(fmi4cMaster *master)
+{
+    return master->nSubsystems;
+}
+
+//! @brief Returns the number of worker threads (including the calling thread), 0 before initialization
+int fmi4c_getMasterNumberOfThreads(fmi4cMaster *master)
+{
+    if(master->pool == NULL) {
+        return 0;
+    }
+    return fmi4c_getPoolNumberOfWorkers(master->pool);
+}
+
+//! @brief Returns the number of schedule levels, i.e. pool runs per step (0 before initialization)
+int fmi4c_getMasterNumberOfLevels(fmi4cMaster *master)
+{
+    return master->schedule != NULL ? master->schedule->nLevels : 0;
+}
+
+//! @brief Returns the number of algebraic loops found in the connection graph (Gauss-Seidel only)
+int fmi4c_getMasterNumberOfAlgebraicLoops(fmi4cMaster *master)
+{
+    return master->schedule != NULL ? master->schedule->nAlgebraicLoops : 0;
+}
+
+//! @brief Returns the parallel efficiency of all steps so far
+//! The efficiency is the total time spent in subsystem steps divided by the master step time times the
+//! number of workers, 1 means that no worker was ever idle.
+double fmi4c_getMasterParallelEfficiency(fmi4cMaster *master)
+{
+    int nThreads = fmi4c_getMasterNumberOfThreads(master);
+    if(master->wallTime <= 0 || nThreads == 0) {
+        return 0;
+    }
+    return master->busyTime/(master->wallTime*nThreads);
+}
+
+//! @brief Returns the number of components stolen by idle workers so far (work stealing only)
+size_t fmi4c_getMasterNumberOfSteals(fmi4cMaster *master)
+{
+    return fmi4c_atomicLoadAcquire(&master->nSteals);
+}
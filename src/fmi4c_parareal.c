@@ -0,0 +1,507 @@
+#include "fmi4c_private.h"
+#define FMI4C_H_INTERNAL_INCLUDE
+#include "fmi4c.h"
+#include "fmi4c_parareal.h"
+#include "fmi4c_common.h"
+#include "fmi4c_pool.h"
+
+#include <math.h>
+#include <string.h>
+
+#define STEP_EPSILON 1e-9       // Relative tolerance when dividing a slice into communication steps
+
+//! @brief Propagator instance
+typedef struct {
+    fmiVersion_t fmiVersion;
+    fmi2InstanceHandle *fmi2Instance;
+    fmi3InstanceHandle *fmi3Instance;
+    bool ok;                    // False if a propagation on this instance failed
+} propagator_t;
+
+//! @brief Serialized FMU state
+typedef struct {
+    unsigned char *data;
+    size_t size;
+    size_t capacity;
+} serializedState_t;
+
+struct fmi4cParareal {
+    propagator_t *propagators;  // Coarse propagator first, then the fine propagators
+    int nPropagators;
+    int propagatorCapacity;
+
+    unsigned int *stateRefs;
+    size_t nStates;
+    fmi4cPararealInputCallback inputCallback;
+    void *inputUserData;
+
+    int nSlices;
+    double coarseStepSize;      // 0 = one coarse step per slice
+    double fineStepSize;
+    double relativeTolerance;
+    double absoluteTolerance;
+    int maxIterations;          // 0 = one per slice
+    bool pinThreads;
+    fmi4cPool *pool;
+
+    // Run data, indexed by slice boundary (nSlices+1 entries)
+    double *times;
+    double *values;             // Current state estimates U[n]
+    double *coarseValues;       // Coarse predictions G(U[n-1]) from the latest correction
+    double *fineValues;         // Fine results F(U[n-1]) from the latest fine propagation
+    double *newValues;
+    serializedState_t *startStates;  // FMU state at the start of each slice
+    serializedState_t *fineStates;   // FMU state at the end of each fine propagation
+    int firstSlice;             // First slice with a changed start state
+    int nIterations;
+    size_t nFinePropagations;
+    bool converged;
+};
+
+//! @brief Creates an empty Parareal driver
+//! @returns Driver handle, or NULL on failure
+fmi4cParareal *fmi4c_createParareal(void)
+{
+    fmi4cParareal *parareal = calloc(1, sizeof(fmi4cParareal));
+    if(parareal == NULL) {
+        return NULL;
+    }
+    parareal->nSlices = 16;
+    parareal->fineStepSize = 1e-3;
+    parareal->relativeTolerance = 1e-6;
+    parareal->absoluteTolerance = 1e-9;
+    return parareal;
+}
+
+static void freeRunData(fmi4cParareal *parareal)
+{
+    for(int n=0; parareal->startStates != NULL && n<=parareal->nSlices; ++n) {
+        free(parareal->startStates[n].data);
+        free(parareal->fineStates[n].data);
+    }
+    free(parareal->startStates);
+    free(parareal->fineStates);
+    free(parareal->times);
+    free(parareal->values);
+    free(parareal->coarseValues);
+    free(parareal->fineValues);
+    free(parareal->newValues);
+    parareal->startStates = NULL;
+    parareal->fineStates = NULL;
+    parareal->times = NULL;
+    parareal->values = NULL;
+    parareal->coarseValues = NULL;
+    parareal->fineValues = NULL;
+    parareal->newValues = NULL;
+}
+
+void fmi4c_freeParareal(fmi4cParareal *parareal)
+{
+    if(parareal == NULL) {
+        return;
+    }
+    freeRunData(parareal);
+    fmi4c_freePool(parareal->pool);
+    free(parareal->propagators);
+    free(parareal->stateRefs);
+    free(parareal);
+}
+
+static bool addPropagator(fmi4cParareal *parareal, fmiVersion_t version, fmi2InstanceHandle *fmi2Instance, fmi3InstanceHandle *fmi3Instance)
+{
+    if(parareal->nPropagators > 0 && parareal->propagators[0].fmiVersion != version) {
+        fmi4c_printMessage("All Parareal instances must have the same FMI version");
+        return false;
+    }
+    if(parareal->nPropagators == parareal->propagatorCapacity) {
+        int capacity = parareal->propagatorCapacity > 0 ? 2*parareal->propagatorCapacity : 8;
+        propagator_t *propagators = realloc(parareal->propagators, (size_t)capacity*sizeof(propagator_t));
+        if(propagators == NULL) {
+            return false;
+        }
+        parareal->propagators = propagators;
+        parareal->propagatorCapacity = capacity;
+    }
+    propagator_t *propagator = &parareal->propagators[parareal->nPropagators++];
+    propagator->fmiVersion = version;
+    propagator->fmi2Instance = fmi2Instance;
+    propagator->fmi3Instance = fmi3Instance;
+    propagator->ok = true;
+    return true;
+}
+
+//! @brief Adds an initialized FMI 2 co-simulation instance, the first one added is the coarse propagator
+//! @returns False if the FMU cannot get, set and serialize its state
+bool fmi4c_addPararealInstanceFmi2(fmi4cParareal *parareal, fmi2InstanceHandle *instance)
+{
+    if(!fmi2cs_getCanGetAndSetFMUState(instance->fmu) || !fmi2cs_getCanSerializeFMUState(instance->fmu)) {
+        fmi4c_printMessage("Parareal requires FMUs that can get, set and serialize their state");
+        return false;
+    }
+    return addPropagator(parareal, fmiVersion2, instance, NULL);
+}
+
+//! @brief Adds an initialized FMI 3 co-simulation instance, the first one added is the coarse propagator
+//! @returns False if the FMU cannot get, set and serialize its state
+bool fmi4c_addPararealInstanceFmi3(fmi4cParareal *parareal, fmi3InstanceHandle *instance)
+{
+    if(!fmi3cs_getCanGetAndSetFMUState(instance->fmu) || !fmi3cs_getCanSerializeFMUState(instance->fmu)) {
+        fmi4c_printMessage("Parareal requires FMUs that can get, set and serialize their state");
+        return false;
+    }
+    return addPropagator(parareal, fmiVersion3, NULL, instance);
+}
+
+//! @brief Sets the real-valued variables that are corrected and checked for convergence
+bool fmi4c_setPararealStateVariables(fmi4cParareal *parareal, const unsigned int *valueReferences, size_t nValueReferences)
+{
+    unsigned int *stateRefs = malloc((nValueReferences > 0 ? nValueReferences : 1)*sizeof(unsigned int));
+    if(stateRefs == NULL) {
+        return false;
+    }
+    if(nValueReferences > 0) {
+        memcpy(stateRefs, valueReferences, nValueReferences*sizeof(unsigned int));
+    }
+    free(parareal->stateRefs);
+    parareal->stateRefs = stateRefs;
+    parareal->nStates = nValueReferences;
+    return true;
+}
+
+//! @brief Sets a callback for setting inputs before each communication step
+void fmi4c_setPararealInputCallback(fmi4cParareal *parareal, fmi4cPararealInputCallback callback, void *userData)
+{
+    parareal->inputCallback = callback;
+    parareal->inputUserData = userData;
+}
+
+void fmi4c_setPararealTimeSlices(fmi4cParareal *parareal, int nSlices)
+{
+    parareal->nSlices = nSlices > 0 ? nSlices : 1;
+}
+
+//! @brief Sets the communication step sizes of the propagators
+//! @param coarseStepSize Coarse step size, 0 for one coarse step per slice
+//! @param fineStepSize Fine step size, the step size of the solution
+void fmi4c_setPararealStepSizes(fmi4cParareal *parareal, double coarseStepSize, double fineStepSize)
+{
+    parareal->coarseStepSize = coarseStepSize;
+    parareal->fineStepSize = fineStepSize;
+}
+
+void fmi4c_setPararealTolerance(fmi4cParareal *parareal, double relativeTolerance, double absoluteTolerance)
+{
+    parareal->relativeTolerance = relativeTolerance;
+    parareal->absoluteTolerance = absoluteTolerance;
+}
+
+//! @brief Limits the number of correction iterations, 0 (default) for one per slice
+void fmi4c_setPararealMaxIterations(fmi4cParareal *parareal, int maxIterations)
+{
+    parareal->maxIterations = maxIterations;
+}
+
+void fmi4c_setPararealThreads(fmi4cParareal *parareal, bool pinThreads)
+{
+    parareal->pinThreads = pinThreads;
+}
+
+static bool getStateValues(fmi4cParareal *parareal, propagator_t *propagator, double *values)
+{
+    if(parareal->nStates == 0) {
+        return true;
+    }
+    if(propagator->fmiVersion == fmiVersion2) {
+        return fmi2_getReal(propagator->fmi2Instance, parareal->stateRefs, parareal->nStates, values) <= fmi2Warning;
+    }
+    return fmi3_getFloat64(propagator->fmi3Instance, parareal->stateRefs, parareal->nStates, values, parareal->nStates) <= fmi3Warning;
+}
+
+static bool setStateValues(fmi4cParareal *parareal, propagator_t *propagator, const double *values)
+{
+    if(parareal->nStates == 0) {
+        return true;
+    }
+    if(propagator->fmiVersion == fmiVersion2) {
+        return fmi2_setReal(propagator->fmi2Instance, parareal->stateRefs, parareal->nStates, values) <= fmi2Warning;
+    }
+    return fmi3_setFloat64(propagator->fmi3Instance, parareal->stateRefs, parareal->nStates, values, parareal->nStates) <= fmi3Warning;
+}
+
+//! @brief Serializes the current FMU state of an instance, reusing the buffer of the state
+static bool saveState(propagator_t *propagator, serializedState_t *state)
+{
+    bool ok;
+    size_t size = 0;
+    if(propagator->fmiVersion == fmiVersion2) {
+        fmi2FMUstate fmuState = NULL;
+        ok = fmi2_getFMUstate(propagator->fmi2Instance, &fmuState) <= fmi2Warning &&
+             fmi2_serializedFMUstateSize(propagator->fmi2Instance, fmuState, &size) <= fmi2Warning;
+        if(ok && size > state->capacity) {
+            free(state->data);
+            state->data = malloc(size);
+            state->capacity = state->data != NULL ? size : 0;
+            ok = state->data != NULL;
+        }
+        ok = ok && fmi2_serializeFMUstate(propagator->fmi2Instance, fmuState, (fmi2Byte*)state->data, size) <= fmi2Warning;
+        fmi2_freeFMUstate(propagator->fmi2Instance, &fmuState);
+    }
+    else {
+        fmi3FMUState fmuState = NULL;
+        ok = fmi3_getFMUState(propagator->fmi3Instance, &fmuState) <= fmi3Warning &&
+             fmi3_serializedFMUStateSize(propagator->fmi3Instance, fmuState, &size) <= fmi3Warning;
+        if(ok && size > state->capacity) {
+            free(state->data);
+            state->data = malloc(size);
+            state->capacity = state->data != NULL ? size : 0;
+            ok = state->data != NULL;
+        }
+        ok = ok && fmi3_serializeFMUState(propagator->fmi3Instance, fmuState, (fmi3Byte*)state->data, size) <= fmi3Warning;
+        fmi3_freeFMUState(propagator->fmi3Instance, &fmuState);
+    }
+    state->size = ok ? size : 0;
+    return ok;
+}
+
+//! @brief Restores a serialized FMU state into an instance
+static bool loadState(propagator_t *propagator, const serializedState_t *state)
+{
+    bool ok;
+    if(propagator->fmiVersion == fmiVersion2) {
+        fmi2FMUstate fmuState = NULL;
+        ok = fmi2_deSerializeFMUstate(propagator->fmi2Instance, (const fmi2Byte*)state->data, state->size, &fmuState) <= fmi2Warning &&
+             fmi2_setFMUstate(propagator->fmi2Instance, fmuState) <= fmi2Warning;
+        if(fmuState != NULL) {
+            fmi2_freeFMUstate(propagator->fmi2Instance, &fmuState);
+        }
+    }
+    else {
+        fmi3FMUState fmuState = NULL;
+        ok = fmi3_deserializeFMUState(propagator->fmi3Instance, (const fmi3Byte*)state->data, state->size, &fmuState) <= fmi3Warning &&
+             fmi3_setFMUState(propagator->fmi3Instance, fmuState) <= fmi3Warning;
+        if(fmuState != NULL) {
+            fmi3_freeFMUState(propagator->fmi3Instance, &fmuState);
+        }
+    }
+    return ok;
+}
+
+//! @brief Steps an instance from startTime to stopTime with equal steps not larger than the step size
+static bool propagate(fmi4cParareal *parareal, propagator_t *propagator, double startTime, double stopTime, double stepSize)
+{
+    double length = stopTime-startTime;
+    if(stepSize <= 0 || stepSize > length) {
+        stepSize = length;
+    }
+    double steps = ceil(length/stepSize-STEP_EPSILON);
+    int nSteps = steps > 1 ? (int)steps : 1;
+    double h = length/nSteps;
+    for(int i=0; i<nSteps; ++i) {
+        double time = startTime+i*h;
+        if(parareal->inputCallback != NULL) {
+            parareal->inputCallback(propagator->fmiVersion == fmiVersion2 ? (void*)propagator->fmi2Instance : (void*)propagator->fmi3Instance,
+                                    time, parareal->inputUserData);
+        }
+        if(propagator->fmiVersion == fmiVersion2) {
+            if(fmi2_doStep(propagator->fmi2Instance, time, h, fmi2False) > fmi2Warning) {
+                return false;
+            }
+        }
+        else {
+            fmi3Boolean eventEncountered = fmi3False;
+            fmi3Boolean terminateSimulation = fmi3False;
+            fmi3Boolean earlyReturn = fmi3False;
+            fmi3Float64 lastSuccessfulTime = time;
+            if(fmi3_doStep(propagator->fmi3Instance, time, h, fmi3False,
+                           &eventEncountered, &terminateSimulation, &earlyReturn, &lastSuccessfulTime) > fmi3Warning) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+//! @brief Runs the fine propagations of the changed slices, slices are dealt round-robin to the workers
+static void fineTask(void *context, int worker)
+{
+    fmi4cParareal *parareal = context;
+    propagator_t *propagator = &parareal->propagators[1+worker];
+    int nWorkers = parareal->nPropagators-1;
+    for(int n=parareal->firstSlice+worker; n<parareal->nSlices && propagator->ok; n+=nWorkers) {
+        propagator->ok = loadState(propagator, &parareal->startStates[n]) &&
+                         propagate(parareal, propagator, parareal->times[n], parareal->times[n+1], parareal->fineStepSize) &&
+                         getStateValues(parareal, propagator, &parareal->fineValues[(size_t)(n+1)*parareal->nStates]) &&
+                         saveState(propagator, &parareal->fineStates[n+1]);
+    }
+}
+
+static bool allocateRunData(fmi4cParareal *parareal)
+{
+    size_t nBoundaries = (size_t)parareal->nSlices+1;
+    size_t nValues = nBoundaries*(parareal->nStates > 0 ? parareal->nStates : 1);
+    parareal->times = calloc(nBoundaries, sizeof(double));
+    parareal->values = calloc(nValues, sizeof(double));
+    parareal->coarseValues = calloc(nValues, sizeof(double));
+    parareal->fineValues = calloc(nValues, sizeof(double));
+    parareal->newValues = calloc(nValues, sizeof(double));
+    parareal->startStates = calloc(nBoundaries, sizeof(serializedState_t));
+    parareal->fineStates = calloc(nBoundaries, sizeof(serializedState_t));
+    return parareal->times != NULL && parareal->values != NULL && parareal->coarseValues != NULL && parareal->fineValues != NULL &&
+           parareal->newValues != NULL && parareal->startStates != NULL && parareal->fineStates != NULL;
+}
+
+//! @brief Simulates from startTime to stopTime, starting from the current state of the first instance
+//! On success the first instance is left in the final state at stopTime.
+//! @returns False if a propagation failed; not reaching the tolerance within the maximum number of iterations is not a failure
+bool fmi4c_runParareal(fmi4cParareal *parareal, double startTime, double stopTime)
+{
+    if(parareal->nPropagators < 2) {
+        fmi4c_printMessage("Parareal requires a coarse and at least one fine instance");
+        return false;
+    }
+    if(stopTime <= startTime) {
+        fmi4c_printMessage("Parareal stop time must be after the start time");
+        return false;
+    }
+    int nWorkers = parareal->nPropagators-1;
+    if(parareal->pool == NULL || fmi4c_getPoolNumberOfWorkers(parareal->pool) != nWorkers) {
+        fmi4c_freePool(parareal->pool);
+        parareal->pool = fmi4c_createPool(nWorkers, parareal->pinThreads);
+        if(parareal->pool == NULL) {
+            return false;
+        }
+    }
+    freeRunData(parareal);
+    if(!allocateRunData(parareal)) {
+        fmi4c_printMessage("Failed to allocate memory for Parareal");
+        freeRunData(parareal);
+        return false;
+    }
+
+    int nSlices = parareal->nSlices;
+    size_t nStates = parareal->nStates;
+    propagator_t *coarse = &parareal->propagators[0];
+    for(int n=0; n<=nSlices; ++n) {
+        parareal->times[n] = startTime+(stopTime-startTime)*n/nSlices;
+    }
+    for(int i=0; i<parareal->nPropagators; ++i) {
+        parareal->propagators[i].ok = true;
+    }
+    parareal->nIterations = 0;
+    parareal->nFinePropagations = 0;
+    parareal->converged = false;
+
+    // Initial coarse prediction
+    bool ok = getStateValues(parareal, coarse, parareal->values) && saveState(coarse, &parareal->startStates[0]);
+    for(int n=0; ok && n<nSlices; ++n) {
+        ok = propagate(parareal, coarse, parareal->times[n], parareal->times[n+1], parareal->coarseStepSize) &&
+             getStateValues(parareal, coarse, &parareal->coarseValues[(size_t)(n+1)*nStates]) &&
+             saveState(coarse, &parareal->startStates[n+1]);
+    }
+    if(!ok) {
+        fmi4c_printMessage("Parareal coarse propagation failed");
+        return false;
+    }
+    memcpy(parareal->values+nStates, parareal->coarseValues+nStates, (size_t)nSlices*nStates*sizeof(double));
+
+    int maxIterations = parareal->maxIterations > 0 ? parareal->maxIterations : nSlices;
+    parareal->firstSlice = 0;
+    while(parareal->nIterations < maxIterations) {
+        // Fine propagation of all slices whose start state changed
+        fmi4c_runPool(parareal->pool, fineTask, parareal);
+        for(int i=1; i<parareal->nPropagators; ++i) {
+            ok = ok && parareal->propagators[i].ok;
+        }
+        if(!ok) {
+            fmi4c_printMessage("Parareal fine propagation failed");
+            return false;
+        }
+        parareal->nFinePropagations += (size_t)(nSlices-parareal->firstSlice);
+        ++parareal->nIterations;
+
+        // Serial correction, starting with the first changed slice (its start state is exact)
+        int firstChanged = nSlices+1;
+        ok = loadState(coarse, &parareal->startStates[parareal->firstSlice]);
+        for(int n=parareal->firstSlice; ok && n<nSlices; ++n) {
+            double *coarseValues = &parareal->coarseValues[(size_t)(n+1)*nStates];
+            double *fineValues = &parareal->fineValues[(size_t)(n+1)*nStates];
+            double *oldValues = &parareal->values[(size_t)(n+1)*nStates];
+            double *newValues = &parareal->newValues[(size_t)(n+1)*nStates];
+            ok = propagate(parareal, coarse, parareal->times[n], parareal->times[n+1], parareal->coarseStepSize) &&
+                 getStateValues(parareal, coarse, newValues);
+            if(!ok) {
+                break;
+            }
+            bool changed = false;
+            for(size_t i=0; i<nStates; ++i) {
+                double predicted = newValues[i];
+                newValues[i] = predicted+fineValues[i]-coarseValues[i];
+                coarseValues[i] = predicted;
+                if(fabs(newValues[i]-oldValues[i]) > parareal->absoluteTolerance+parareal->relativeTolerance*fabs(newValues[i])) {
+                    changed = true;
+                }
+            }
+            if(changed && firstChanged > nSlices) {
+                firstChanged = n+1;
+            }
+            memcpy(oldValues, newValues, nStates*sizeof(double));
+
+            // The corrected state continues from the fine end state, with the corrected state variables
+            ok = loadState(coarse, &parareal->fineStates[n+1]) &&
+                 setStateValues(parareal, coarse, newValues) &&
+                 saveState(coarse, &parareal->startStates[n+1]);
+        }
+        if(!ok) {
+            fmi4c_printMessage("Parareal correction failed");
+            return false;
+        }
+        if(firstChanged >= nSlices) {
+            // The last boundary has no slice after it, a change there needs no further iteration
+            parareal->converged = true;
+            break;
+        }
+        parareal->firstSlice = firstChanged;
+    }
+
+    // Leave the coarse instance in the final state
+    if(!loadState(coarse, &parareal->startStates[nSlices])) {
+        fmi4c_printMessage("Failed to restore the final Parareal state");
+        return false;
+    }
+    return true;
+}
+
+int fmi4c_getPararealNumberOfIterations(fmi4cParareal *parareal)
+{
+    return parareal->nIterations;
+}
+
+//! @brief Returns the total number of fine slice propagations in the last run, nSlices for serial execution
+size_t fmi4c_getPararealNumberOfFinePropagations(fmi4cParareal *parareal)
+{
+    return parareal->nFinePropagations;
+}
+
+bool fmi4c_getPararealConverged(fmi4cParareal *parareal)
+{
+    return parareal->converged;
+}
+
+//! @brief Returns the time of a slice boundary (0 to number of slices) in the last run
+double fmi4c_getPararealSliceTime(fmi4cParareal *parareal, int boundary)
+{
+    if(parareal->times == NULL || boundary < 0 || boundary > parareal->nSlices) {
+        return 0;
+    }
+    return parareal->times[boundary];
+}
+
+//! @brief Copies the state variable values at a slice boundary (0 to number of slices) in the last run
+bool fmi4c_getPararealStateValues(fmi4cParareal *parareal, int boundary, double *values)
+{
+    if(parareal->values == NULL || boundary < 0 || boundary > parareal->nSlices) {
+        return false;
+    }
+    memcpy(values, &parareal->values[(size_t)boundary*parareal->nStates], parareal->nStates*sizeof(double));
+    return true;
+}
@@ -876,14 +876,14 @@ fmi3Component *STDCALL placeholder_fmi3InstantiateModelExchange(fmi3String insta
     return NULL;
 }
 
-fmi3InstanceHandle *STDCALL placeholder_fmi3InstantiateScheduledExecution(fmi3String instanceName,
+fmi3Component *STDCALL placeholder_fmi3InstantiateScheduledExecution(fmi3String instanceName,
                                                              fmi3String instantiationToken,
                                                              fmi3String resourcePath,
                                                              fmi3Boolean visible,
                                                              fmi3Boolean loggingOn,
                                                              fmi3InstanceEnvironment instanceEnvironment,
                                                              fmi3LogMessageCallback logMessage,
-                                                             fmi3IntermediateUpdateCallback intermediateUpdate,
+                                                             fmi3ClockUpdateCallback clockUpdate,
                                                              fmi3CallbackLockPreemption lockPreemption,
                                                              fmi3CallbackUnlockPreemption unlockPreemption) {
     UNUSED(instanceName);
@@ -893,7 +893,7 @@ fmi3InstanceHandle *STDCALL placeholder_fmi3InstantiateScheduledExecution(fmi3St
     UNUSED(loggingOn);
     UNUSED(instanceEnvironment);
     UNUSED(logMessage);
-    UNUSED(intermediateUpdate);
+    UNUSED(clockUpdate);
     UNUSED(lockPreemption);
     UNUSED(unlockPreemption);
     NOT_IMPLEMENTED(fmi3InstantiateScheduledExecution);
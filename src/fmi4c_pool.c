@@ -0,0 +1,168 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE     // For CPU affinity on Linux
+#endif
+
+#include "fmi4c_pool.h"
+#include "fmi4c_threads.h"
+
+#define POOL_SPIN_ITERATIONS 4000
+
+typedef struct {
+    fmi4cPool *pool;
+    int index;
+} poolWorker_t;
+
+struct fmi4cPool {
+    int nWorkers;
+    bool pinThreads;
+    int spinIterations;             // Spinning only pays off when every worker has its own processor
+    fmi4cThread_t *threads;
+    poolWorker_t *workers;
+    int nStarted;
+
+    fmi4cMutex_t mutex;
+    fmi4cCond_t startCondition;
+    fmi4cCond_t doneCondition;
+    volatile size_t generation;     // Incremented for each run
+    volatile size_t remaining;      // Workers (except the caller) that have not finished the current run
+    volatile size_t stop;
+
+    fmi4cPoolTask_t task;
+    void *context;
+};
+
+//! @brief Waits until the generation counter differs from the last seen value
+static size_t waitForGeneration(fmi4cPool *pool, size_t seen)
+{
+    for(int i=0; i<pool->spinIterations; ++i) {
+        size_t generation = fmi4c_atomicLoadAcquire(&pool->generation);
+        if(generation != seen) {
+            return generation;
+        }
+        fmi4c_cpuRelax();
+    }
+    fmi4c_mutexLock(&pool->mutex);
+    while(fmi4c_atomicLoadAcquire(&pool->generation) == seen) {
+        fmi4c_condWait(&pool->startCondition, &pool->mutex);
+    }
+    fmi4c_mutexUnlock(&pool->mutex);
+    return fmi4c_atomicLoadAcquire(&pool->generation);
+}
+
+static void workerMain(void *arg)
+{
+    poolWorker_t *worker = (poolWorker_t*)arg;
+    fmi4cPool *pool = worker->pool;
+    if(pool->pinThreads) {
+        fmi4c_threadPinToProcessor(worker->index % fmi4c_getNumberOfProcessors());
+    }
+
+    size_t seen = 0;
+    while(true) {
+        seen = waitForGeneration(pool, seen);
+        if(fmi4c_atomicLoadAcquire(&pool->stop)) {
+            break;
+        }
+        pool->task(pool->context, worker->index);
+        if(fmi4c_atomicFetchAdd(&pool->remaining, (size_t)-1) == 1) {
+            fmi4c_mutexLock(&pool->mutex);
+            fmi4c_condBroadcast(&pool->doneCondition);
+            fmi4c_mutexUnlock(&pool->mutex);
+        }
+    }
+}
+
+//! @brief Creates a pool and starts its worker threads
+//! @param nWorkers Number of workers including the calling thread (0 = number of processors)
+//! @param pinThreads Pin worker i to processor i (the calling thread is not pinned)
+//! @returns Pool handle, or NULL on failure
+fmi4cPool *fmi4c_createPool(int nWorkers, bool pinThreads)
+{
+    if(nWorkers <= 0) {
+        nWorkers = fmi4c_getNumberOfProcessors();
+    }
+    fmi4cPool *pool = calloc(1, sizeof(fmi4cPool));
+    if(pool == NULL) {
+        return NULL;
+    }
+    pool->nWorkers = nWorkers;
+    pool->pinThreads = pinThreads;
+    pool->spinIterations = nWorkers <= fmi4c_getNumberOfProcessors() ? POOL_SPIN_ITERATIONS : 0;
+    pool->threads = calloc((size_t)nWorkers, sizeof(fmi4cThread_t));
+    pool->workers = calloc((size_t)nWorkers, sizeof(poolWorker_t));
+    if(pool->threads == NULL || pool->workers == NULL) {
+        free(pool->threads);
+        free(pool->workers);
+        free(pool);
+        return NULL;
+    }
+    fmi4c_mutexInit(&pool->mutex);
+    fmi4c_condInit(&pool->startCondition);
+    fmi4c_condInit(&pool->doneCondition);
+
+    for(int i=1; i<nWorkers; ++i) {
+        pool->workers[i].pool = pool;
+        pool->workers[i].index = i;
+        if(!fmi4c_threadCreate(&pool->threads[i], workerMain, &pool->workers[i])) {
+            fmi4c_freePool(pool);
+            return NULL;
+        }
+        ++pool->nStarted;
+    }
+    return pool;
+}
+
+//! @brief Stops all worker threads and frees the pool
+void fmi4c_freePool(fmi4cPool *pool)
+{
+    if(pool == NULL) {
+        return;
+    }
+    fmi4c_mutexLock(&pool->mutex);
+    fmi4c_atomicStoreRelease(&pool->stop, 1);
+    fmi4c_atomicFetchAdd(&pool->generation, 1);
+    fmi4c_condBroadcast(&pool->startCondition);
+    fmi4c_mutexUnlock(&pool->mutex);
+    for(int i=1; i<=pool->nStarted; ++i) {
+        fmi4c_threadJoin(pool->threads[i]);
+    }
+    fmi4c_condDestroy(&pool->startCondition);
+    fmi4c_condDestroy(&pool->doneCondition);
+    fmi4c_mutexDestroy(&pool->mutex);
+    free(pool->threads);
+    free(pool->workers);
+    free(pool);
+}
+
+int fmi4c_getPoolNumberOfWorkers(fmi4cPool *pool)
+{
+    return pool->nWorkers;
+}
+
+//! @brief Runs task(context, worker) once on every worker and waits until all have finished
+//! The calling thread runs worker 0. Must not be called concurrently from several threads.
+void fmi4c_runPool(fmi4cPool *pool, fmi4cPoolTask_t task, void *context)
+{
+    if(pool->nWorkers > 1) {
+        pool->task = task;
+        pool->context = context;
+        fmi4c_atomicStoreRelease(&pool->remaining, (size_t)(pool->nWorkers-1));
+        fmi4c_mutexLock(&pool->mutex);
+        fmi4c_atomicFetchAdd(&pool->generation, 1);
+        fmi4c_condBroadcast(&pool->startCondition);
+        fmi4c_mutexUnlock(&pool->mutex);
+    }
+
+    task(context, 0);
+
+    if(pool->nWorkers > 1) {
+        for(int i=0; i<pool->spinIterations && fmi4c_atomicLoadAcquire(&pool->remaining) != 0; ++i) {
+            fmi4c_cpuRelax();
+        }
+        fmi4c_mutexLock(&pool->mutex);
+        while(fmi4c_atomicLoadAcquire(&pool->remaining) != 0) {
+            fmi4c_condWait(&pool->doneCondition, &pool->mutex);
+        }
+        fmi4c_mutexUnlock(&pool->mutex);
+    }
+}
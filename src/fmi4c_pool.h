@@ -0,0 +1,22 @@
+#ifndef FMIC_POOL_H
+#define FMIC_POOL_H
+
+#include <stdbool.h>
+
+// Persistent worker pool
+//
+// Workers are started once and reused for every run. The calling thread acts as worker 0, so a pool
+// with n workers starts n-1 threads. Work is handed off by bumping a generation counter: workers spin
+// briefly on the counter before blocking on a condition variable, so short back-to-back runs (one per
+// communication step) are not delayed by the kernel scheduler.
+
+typedef struct fmi4cPool fmi4cPool;
+
+typedef void (*fmi4cPoolTask_t)(void *context, int worker);
+
+fmi4cPool *fmi4c_createPool(int nWorkers, bool pinThreads);
+void fmi4c_freePool(fmi4cPool *pool);
+int fmi4c_getPoolNumberOfWorkers(fmi4cPool *pool);
+void fmi4c_runPool(fmi4cPool *pool, fmi4cPoolTask_t task, void *context);
+
+#endif // FMIC_POOL_H
@@ -311,6 +311,7 @@ typedef struct {
 typedef struct {
     int index;
     int numberOfDependencies;
+    bool dependenciesDefined;
     bool dependencyKindsDefined;
     int *dependencies;
     fmi2DependencyKind *dependencyKinds;
@@ -565,6 +566,7 @@ typedef struct {
 typedef struct {
     fmi3ValueReference valueReference;
     int numberOfDependencies;
+    bool dependenciesDefined;
     bool dependencyKindsDefined;
     fmi3ValueReference *dependencies;
     fmi3DependencyKind *dependencyKinds;
@@ -807,6 +809,9 @@ struct fmuHandle {
 #else
     void* dll;
 #endif
+    const char* hostExecutable;     // Run instances in separate host processes, if not NULL
+    fmi4cBinaryIsolation isolation;
+    struct fmuHandle *parent;       // FMU handle this is a per-instance copy of, NULL for loaded FMUs
 
     fmi1_data_t fmi1;
     fmi2Data_t fmi2;
@@ -825,4 +830,9 @@ bool loadFunctionsFmi1(fmuHandle *contents);
 bool loadFunctionsFmi2(fmuHandle *contents, fmi2Type fmuType);
 bool loadFunctionsFmi3(fmuHandle *contents, fmi3Type fmuType);
 
+void fmi4c_setPlaceholdersFmi2(fmuHandle *fmu);
+void fmi4c_setPlaceholdersFmi3(fmuHandle *fmu);
+fmi2Component *fmi4c_instantiateRemoteFmi2(fmuHandle *fmu, fmi2Type type, fmi2Boolean visible, fmi2Boolean loggingOn);
+fmi3Component *fmi4c_instantiateRemoteFmi3(fmuHandle *fmu, fmi3Boolean visible, fmi3Boolean loggingOn, fmi3Boolean eventModeUsed, fmi3Boolean earlyReturnAllowed);
+
 #endif // FMIC_PRIVATE_H
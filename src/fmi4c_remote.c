@@ -0,0 +1,899 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE     // For memfd_create
+#endif
+#include "fmi4c_private.h"
+#define FMI4C_H_INTERNAL_INCLUDE
+#include "fmi4c.h"
+#include "fmi4c_common.h"
+#include "fmi4c_remote.h"
+#include "fmi4c_utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "fmi4c_threads.h"
+
+#define REMOTE_DATA_SIZE (1 << 20)              // Bytes available for value references and values in one call
+#define REMOTE_SPIN_ITERATIONS 20000           // Only used with more than one processor, the other side can not run otherwise
+#define REMOTE_LIVENESS_INTERVAL 100000000L     // Nanoseconds between checks that the host is still running
+
+// Status codes are shared between FMI 2 and FMI 3 (OK, Warning, Discard, Error, Fatal)
+#define REMOTE_ERROR 3
+#define REMOTE_FATAL 4
+
+typedef enum {
+    remoteInstantiate,
+    remoteFreeInstance,
+    remoteSetupExperiment,
+    remoteEnterInitializationMode,
+    remoteExitInitializationMode,
+    remoteTerminate,
+    remoteReset,
+    remoteGetReal,
+    remoteSetReal,
+    remoteGetInteger,
+    remoteSetInteger,
+    remoteGetBoolean,
+    remoteSetBoolean,
+    remoteDoStep,
+    remoteGetRealStatus,
+    remoteGetBooleanStatus,
+    remoteGetFMUState,
+    remoteSetFMUState,
+    remoteFreeFMUState
+} remoteFunction_t;
+
+//! @brief Shared memory channel between one remote instance and its host process
+//! Works as a single slot mailbox: the client writes the arguments and increments request, the host
+//! executes the call, writes the results and sets response to the request number.
+typedef struct {
+    volatile uint32_t request;          // Futex word, incremented by the client for each call
+    volatile uint32_t response;         // Futex word, set to the request number when the call is done
+    volatile uint32_t hostWaiting;
+    volatile uint32_t clientWaiting;
+    int32_t function;
+    int32_t status;
+    int32_t intArgs[4];
+    double realArgs[4];
+    uint64_t count;                     // Number of value references in the data area
+    uint64_t state;                     // Host side FMU state identifier, zero for none
+    char text[2*FILENAME_MAX];          // Instance name and unzipped location, for instantiation
+    double data[REMOTE_DATA_SIZE/sizeof(double)];   // Value references followed by values
+} remoteChannel_t;
+
+typedef struct {
+    remoteChannel_t *channel;
+    pid_t pid;
+    bool dead;
+} remoteInstance_t;
+
+static void futexWait(volatile uint32_t *word, uint32_t value, long timeout)
+{
+    struct timespec ts = { timeout/1000000000L, timeout%1000000000L };
+    syscall(SYS_futex, word, FUTEX_WAIT, value, timeout > 0 ? &ts : NULL, NULL, 0);
+}
+
+static void futexWake(volatile uint32_t *word)
+{
+    syscall(SYS_futex, word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+//! @brief Publishes a new value of a futex word and wakes the other side if it is blocked on it
+static void signalWord(volatile uint32_t *word, uint32_t value, volatile uint32_t *waiting)
+{
+    __atomic_store_n(word, value, __ATOMIC_SEQ_CST);
+    if(__atomic_load_n(waiting, __ATOMIC_SEQ_CST)) {
+        futexWake(word);
+    }
+}
+
+//! @brief Waits until a futex word differs from a value, spinning briefly before blocking
+//! @param pid Process to check for liveness while blocked, or zero to wait indefinitely
+//! @returns The new value, or the old value if the process has exited
+static uint32_t waitForChange(volatile uint32_t *word, uint32_t value, volatile uint32_t *waiting, pid_t pid)
+{
+    static int spinIterations = -1;
+    if(spinIterations < 0) {
+        spinIterations = (fmi4c_getNumberOfProcessors() > 1) ? REMOTE_SPIN_ITERATIONS : 0;
+    }
+    for(int i=0; i<spinIterations; ++i) {
+        uint32_t current = __atomic_load_n(word, __ATOMIC_ACQUIRE);
+        if(current != value) {
+            return current;
+        }
+        fmi4c_cpuRelax();
+    }
+    while(true) {
+        __atomic_store_n(waiting, 1, __ATOMIC_SEQ_CST);
+        uint32_t current = __atomic_load_n(word, __ATOMIC_SEQ_CST);
+        if(current == value) {
+            futexWait(word, value, pid > 0 ? REMOTE_LIVENESS_INTERVAL : 0);
+            current = __atomic_load_n(word, __ATOMIC_ACQUIRE);
+        }
+        __atomic_store_n(waiting, 0, __ATOMIC_RELAXED);
+        if(current != value) {
+            return current;
+        }
+        if(pid > 0 && waitpid(pid, NULL, WNOHANG) != 0) {
+            return value;
+        }
+    }
+}
+
+//! @brief Offset (in bytes) of the values in the data area, after n value references
+static size_t valuesOffset(size_t n)
+{
+    return (n*sizeof(uint32_t)+7) & ~(size_t)7;
+}
+
+static void *valuesPointer(remoteChannel_t *channel)
+{
+    return (char*)channel->data + valuesOffset((size_t)channel->count);
+}
+
+
+// Client side
+
+//! @brief Executes the call prepared in the channel in the host process
+//! @returns Status of the call, fatal if the host process is no longer running
+static int callHost(void *component, remoteFunction_t function)
+{
+    remoteInstance_t *remote = component;
+    remoteChannel_t *channel = remote->channel;
+    if(remote->dead) {
+        return REMOTE_FATAL;
+    }
+    channel->function = function;
+    uint32_t request = channel->request+1;
+    signalWord(&channel->request, request, &channel->hostWaiting);
+    if(waitForChange(&channel->response, request-1, &channel->clientWaiting, remote->pid) != request) {
+        fmi4c_printMessage("FMU host process terminated unexpectedly");
+        remote->dead = true;
+        return REMOTE_FATAL;
+    }
+    return channel->status;
+}
+
+//! @brief Copies value references (and values, if not NULL) to the data area
+static bool putValues(remoteChannel_t *channel, const uint32_t *valueReferences, size_t n, const void *values, size_t valueSize)
+{
+    if(valuesOffset(n)+n*valueSize > REMOTE_DATA_SIZE) {
+        fmi4c_printMessage("Too many values in one call to an out-of-process instance");
+        return false;
+    }
+    channel->count = n;
+    memcpy(channel->data, valueReferences, n*sizeof(uint32_t));
+    if(values != NULL) {
+        memcpy(valuesPointer(channel), values, n*valueSize);
+    }
+    return true;
+}
+
+static int getValues(void *component, remoteFunction_t function, const uint32_t *valueReferences, size_t n, void *values, size_t valueSize)
+{
+    remoteInstance_t *remote = component;
+    if(!putValues(remote->channel, valueReferences, n, NULL, valueSize)) {
+        return REMOTE_ERROR;
+    }
+    int status = callHost(remote, function);
+    if(status != REMOTE_FATAL) {
+        memcpy(values, valuesPointer(remote->channel), n*valueSize);
+    }
+    return status;
+}
+
+static int setValues(void *component, remoteFunction_t function, const uint32_t *valueReferences, size_t n, const void *values, size_t valueSize)
+{
+    remoteInstance_t *remote = component;
+    if(!putValues(remote->channel, valueReferences, n, values, valueSize)) {
+        return REMOTE_ERROR;
+    }
+    return callHost(remote, function);
+}
+
+static int callWithState(void *component, remoteFunction_t function, void **state)
+{
+    remoteInstance_t *remote = component;
+    remote->channel->state = (uint64_t)(uintptr_t)*state;
+    int status = callHost(remote, function);
+    *state = (void*)(uintptr_t)remote->channel->state;
+    return status;
+}
+
+//! @brief Starts a host process connected to a new shared memory channel and instantiates the FMU in it
+static remoteInstance_t *startHost(fmuHandle *fmu, int32_t intArgs[4])
+{
+    remoteInstance_t *remote = calloc(1, sizeof(remoteInstance_t));
+    if(remote == NULL) {
+        return NULL;
+    }
+    int fd = memfd_create("fmi4c", MFD_CLOEXEC);
+    if(fd < 0 || ftruncate(fd, sizeof(remoteChannel_t)) != 0) {
+        fmi4c_printMessage("Failed to create shared memory for out-of-process instance");
+        if(fd >= 0) {
+            close(fd);
+        }
+        free(remote);
+        return NULL;
+    }
+    remote->channel = mmap(NULL, sizeof(remoteChannel_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(remote->channel == MAP_FAILED) {
+        fmi4c_printMessage("Failed to map shared memory for out-of-process instance");
+        close(fd);
+        free(remote);
+        return NULL;
+    }
+
+    // Everything the child needs is prepared before forking, since only async-signal-safe functions may be called there
+    char fdArgument[32];
+    snprintf(fdArgument, sizeof(fdArgument), "%d", fd);
+    remote->pid = fork();
+    if(remote->pid == 0) {
+        prctl(PR_SET_PDEATHSIG, SIGKILL);
+        fcntl(fd, F_SETFD, 0);      // Keep the shared memory open in the host
+        execl(fmu->hostExecutable, fmu->hostExecutable, "--fd", fdArgument, (char*)NULL);
+        _exit(127);
+    }
+    close(fd);
+    if(remote->pid < 0) {
+        fmi4c_printMessage("Failed to start FMU host process");
+        munmap(remote->channel, sizeof(remoteChannel_t));
+        free(remote);
+        return NULL;
+    }
+
+    remoteChannel_t *channel = remote->channel;
+    size_t nameLength = strlen(fmu->instanceName)+1;
+    size_t locationLength = strlen(fmu->unzippedLocation)+1;
+    if(nameLength+locationLength > sizeof(channel->text)) {
+        fmi4c_printMessage("Instance name or unzipped location too long for out-of-process instance");
+        kill(remote->pid, SIGKILL);
+        remote->dead = true;
+    }
+    else {
+        memcpy(channel->text, fmu->instanceName, nameLength);
+        memcpy(channel->text+nameLength, fmu->unzippedLocation, locationLength);
+        memcpy(channel->intArgs, intArgs, sizeof(channel->intArgs));
+    }
+    if(callHost(remote, remoteInstantiate) != 0) {
+        fmi4c_printMessage("Failed to instantiate FMU in host process");
+        kill(remote->pid, SIGKILL);
+        waitpid(remote->pid, NULL, 0);
+        munmap(remote->channel, sizeof(remoteChannel_t));
+        free(remote);
+        return NULL;
+    }
+    return remote;
+}
+
+static void freeRemoteInstance(void *component)
+{
+    remoteInstance_t *remote = component;
+    callHost(remote, remoteFreeInstance);
+    waitpid(remote->pid, NULL, 0);
+    munmap(remote->channel, sizeof(remoteChannel_t));
+    free(remote);
+}
+
+static fmi2Status fmi2RemoteSetupExperiment(fmi2Component *c, fmi2Boolean toleranceDefined, fmi2Real tolerance, fmi2Real startTime, fmi2Boolean stopTimeDefined, fmi2Real stopTime)
+{
+    remoteChannel_t *channel = ((remoteInstance_t*)c)->channel;
+    channel->intArgs[0] = toleranceDefined;
+    channel->intArgs[1] = stopTimeDefined;
+    channel->realArgs[0] = tolerance;
+    channel->realArgs[1] = startTime;
+    channel->realArgs[2] = stopTime;
+    return (fmi2Status)callHost(c, remoteSetupExperiment);
+}
+
+static fmi2Status fmi2RemoteEnterInitializationMode(fmi2Component *c)
+{
+    return (fmi2Status)callHost(c, remoteEnterInitializationMode);
+}
+
+static fmi2Status fmi2RemoteExitInitializationMode(fmi2Component *c)
+{
+    return (fmi2Status)callHost(c, remoteExitInitializationMode);
+}
+
+static fmi2Status fmi2RemoteTerminate(fmi2Component *c)
+{
+    return (fmi2Status)callHost(c, remoteTerminate);
+}
+
+static fmi2Status fmi2RemoteReset(fmi2Component *c)
+{
+    return (fmi2Status)callHost(c, remoteReset);
+}
+
+static fmi2Status fmi2RemoteGetReal(fmi2Component *c, const fmi2ValueReference vr[], size_t nvr, fmi2Real value[])
+{
+    return (fmi2Status)getValues(c, remoteGetReal, vr, nvr, value, sizeof(fmi2Real));
+}
+
+static fmi2Status fmi2RemoteSetReal(fmi2Component *c, const fmi2ValueReference vr[], size_t nvr, const fmi2Real value[])
+{
+    return (fmi2Status)setValues(c, remoteSetReal, vr, nvr, value, sizeof(fmi2Real));
+}
+
+static fmi2Status fmi2RemoteGetInteger(fmi2Component *c, const fmi2ValueReference vr[], size_t nvr, fmi2Integer value[])
+{
+    return (fmi2Status)getValues(c, remoteGetInteger, vr, nvr, value, sizeof(fmi2Integer));
+}
+
+static fmi2Status fmi2RemoteSetInteger(fmi2Component *c, const fmi2ValueReference vr[], size_t nvr, const fmi2Integer value[])
+{
+    return (fmi2Status)setValues(c, remoteSetInteger, vr, nvr, value, sizeof(fmi2Integer));
+}
+
+static fmi2Status fmi2RemoteGetBoolean(fmi2Component *c, const fmi2ValueReference vr[], size_t nvr, fmi2Boolean value[])
+{
+    return (fmi2Status)getValues(c, remoteGetBoolean, vr, nvr, value, sizeof(fmi2Boolean));
+}
+
+static fmi2Status fmi2RemoteSetBoolean(fmi2Component *c, const fmi2ValueReference vr[], size_t nvr, const fmi2Boolean value[])
+{
+    return (fmi2Status)setValues(c, remoteSetBoolean, vr, nvr, value, sizeof(fmi2Boolean));
+}
+
+static fmi2Status fmi2RemoteDoStep(fmi2Component *c, fmi2Real currentCommunicationPoint, fmi2Real communicationStepSize, fmi2Boolean noSetFMUStatePriorToCurrentPoint)
+{
+    remoteChannel_t *channel = ((remoteInstance_t*)c)->channel;
+    channel->realArgs[0] = currentCommunicationPoint;
+    channel->realArgs[1] = communicationStepSize;
+    channel->intArgs[0] = noSetFMUStatePriorToCurrentPoint;
+    return (fmi2Status)callHost(c, remoteDoStep);
+}
+
+static fmi2Status fmi2RemoteGetRealStatus(fmi2Component *c, const fmi2StatusKind s, fmi2Real *value)
+{
+    remoteChannel_t *channel = ((remoteInstance_t*)c)->channel;
+    channel->intArgs[0] = s;
+    fmi2Status status = (fmi2Status)callHost(c, remoteGetRealStatus);
+    *value = channel->realArgs[0];
+    return status;
+}
+
+static fmi2Status fmi2RemoteGetBooleanStatus(fmi2Component *c, const fmi2StatusKind s, fmi2Boolean *value)
+{
+    remoteChannel_t *channel = ((remoteInstance_t*)c)->channel;
+    channel->intArgs[0] = s;
+    fmi2Status status = (fmi2Status)callHost(c, remoteGetBooleanStatus);
+    *value = channel->intArgs[0];
+    return status;
+}
+
+static fmi2Status fmi2RemoteGetFMUstate(fmi2Component *c, fmi2FMUstate *state)
+{
+    return (fmi2Status)callWithState(c, remoteGetFMUState, state);
+}
+
+static fmi2Status fmi2RemoteSetFMUstate(fmi2Component *c, fmi2FMUstate state)
+{
+    return (fmi2Status)callWithState(c, remoteSetFMUState, &state);
+}
+
+static fmi2Status fmi2RemoteFreeFMUstate(fmi2Component *c, fmi2FMUstate *state)
+{
+    return (fmi2Status)callWithState(c, remoteFreeFMUState, state);
+}
+
+static void fmi2RemoteFreeInstance(fmi2Component *c)
+{
+    freeRemoteInstance(c);
+}
+
+static fmi3Status fmi3RemoteEnterInitializationMode(fmi3Component *instance, fmi3Boolean toleranceDefined, fmi3Float64 tolerance, fmi3Float64 startTime, fmi3Boolean stopTimeDefined, fmi3Float64 stopTime)
+{
+    remoteChannel_t *channel = ((remoteInstance_t*)instance)->channel;
+    channel->intArgs[0] = toleranceDefined;
+    channel->intArgs[1] = stopTimeDefined;
+    channel->realArgs[0] = tolerance;
+    channel->realArgs[1] = startTime;
+    channel->realArgs[2] = stopTime;
+    return (fmi3Status)callHost(instance, remoteEnterInitializationMode);
+}
+
+static fmi3Status fmi3RemoteExitInitializationMode(fmi3Component *instance)
+{
+    return (fmi3Status)callHost(instance, remoteExitInitializationMode);
+}
+
+static fmi3Status fmi3RemoteTerminate(fmi3Component *instance)
+{
+    return (fmi3Status)callHost(instance, remoteTerminate);
+}
+
+static fmi3Status fmi3RemoteReset(fmi3Component *instance)
+{
+    return (fmi3Status)callHost(instance, remoteReset);
+}
+
+static fmi3Status fmi3RemoteGetFloat64(fmi3Component *instance, const fmi3ValueReference vr[], size_t nvr, fmi3Float64 values[], size_t nValues)
+{
+    if(nValues != nvr) {
+        fmi4c_printMessage("Array variables are not supported by out-of-process instances");
+        return fmi3Error;
+    }
+    return (fmi3Status)getValues(instance, remoteGetReal, vr, nvr, values, sizeof(fmi3Float64));
+}
+
+static fmi3Status fmi3RemoteSetFloat64(fmi3Component *instance, const fmi3ValueReference vr[], size_t nvr, const fmi3Float64 values[], size_t nValues)
+{
+    if(nValues != nvr) {
+        fmi4c_printMessage("Array variables are not supported by out-of-process instances");
+        return fmi3Error;
+    }
+    return (fmi3Status)setValues(instance, remoteSetReal, vr, nvr, values, sizeof(fmi3Float64));
+}
+
+static fmi3Status fmi3RemoteGetInt32(fmi3Component *instance, const fmi3ValueReference vr[], size_t nvr, fmi3Int32 values[], size_t nValues)
+{
+    if(nValues != nvr) {
+        fmi4c_printMessage("Array variables are not supported by out-of-process instances");
+        return fmi3Error;
+    }
+    return (fmi3Status)getValues(instance, remoteGetInteger, vr, nvr, values, sizeof(fmi3Int32));
+}
+
+static fmi3Status fmi3RemoteSetInt32(fmi3Component *instance, const fmi3ValueReference vr[], size_t nvr, const fmi3Int32 values[], size_t nValues)
+{
+    if(nValues != nvr) {
+        fmi4c_printMessage("Array variables are not supported by out-of-process instances");
+        return fmi3Error;
+    }
+    return (fmi3Status)setValues(instance, remoteSetInteger, vr, nvr, values, sizeof(fmi3Int32));
+}
+
+static fmi3Status fmi3RemoteGetBoolean(fmi3Component *instance, const fmi3ValueReference vr[], size_t nvr, fmi3Boolean values[], size_t nValues)
+{
+    if(nValues != nvr) {
+        fmi4c_printMessage("Array variables are not supported by out-of-process instances");
+        return fmi3Error;
+    }
+    return (fmi3Status)getValues(instance, remoteGetBoolean, vr, nvr, values, sizeof(fmi3Boolean));
+}
+
+static fmi3Status fmi3RemoteSetBoolean(fmi3Component *instance, const fmi3ValueReference vr[], size_t nvr, const fmi3Boolean values[], size_t nValues)
+{
+    if(nValues != nvr) {
+        fmi4c_printMessage("Array variables are not supported by out-of-process instances");
+        return fmi3Error;
+    }
+    return (fmi3Status)setValues(instance, remoteSetBoolean, vr, nvr, values, sizeof(fmi3Boolean));
+}
+
+static fmi3Status fmi3RemoteDoStep(fmi3Component *instance,
+                                   fmi3Float64 currentCommunicationPoint,
+                                   fmi3Float64 communicationStepSize,
+                                   fmi3Boolean noSetFMUStatePriorToCurrentPoint,
+                                   fmi3Boolean *eventHandlingNeeded,
+                                   fmi3Boolean *terminateSimulation,
+                                   fmi3Boolean *earlyReturn,
+                                   fmi3Float64 *lastSuccessfulTime)
+{
+    remoteChannel_t *channel = ((remoteInstance_t*)instance)->channel;
+    channel->realArgs[0] = currentCommunicationPoint;
+    channel->realArgs[1] = communicationStepSize;
+    channel->intArgs[0] = noSetFMUStatePriorToCurrentPoint;
+    fmi3Status status = (fmi3Status)callHost(instance, remoteDoStep);
+    *eventHandlingNeeded = channel->intArgs[1];
+    *terminateSimulation = channel->intArgs[2] || status == fmi3Fatal;
+    *earlyReturn = channel->intArgs[3];
+    *lastSuccessfulTime = channel->realArgs[2];
+    return status;
+}
+
+static fmi3Status fmi3RemoteGetFMUState(fmi3Component *instance, fmi3FMUState *state)
+{
+    return (fmi3Status)callWithState(instance, remoteGetFMUState, state);
+}
+
+static fmi3Status fmi3RemoteSetFMUState(fmi3Component *instance, fmi3FMUState state)
+{
+    return (fmi3Status)callWithState(instance, remoteSetFMUState, &state);
+}
+
+static fmi3Status fmi3RemoteFreeFMUState(fmi3Component *instance, fmi3FMUState *state)
+{
+    return (fmi3Status)callWithState(instance, remoteFreeFMUState, state);
+}
+
+static void fmi3RemoteFreeInstance(fmi3Component *instance)
+{
+    freeRemoteInstance(instance);
+}
+
+//! @brief Installs the forwarding functions and starts a host process for a new FMI 2 instance
+//! @param fmu Per-instance copy of the FMU handle, functions that are not forwarded report errors
+fmi2Component *fmi4c_instantiateRemoteFmi2(fmuHandle *fmu, fmi2Type type, fmi2Boolean visible, fmi2Boolean loggingOn)
+{
+    if(type != fmi2CoSimulation) {
+        fmi4c_printMessage("Only co-simulation is supported for out-of-process instances");
+        return NULL;
+    }
+    fmi4c_setPlaceholdersFmi2(fmu);
+    fmu->fmi2.freeInstance = fmi2RemoteFreeInstance;
+    fmu->fmi2.setupExperiment = fmi2RemoteSetupExperiment;
+    fmu->fmi2.enterInitializationMode = fmi2RemoteEnterInitializationMode;
+    fmu->fmi2.exitInitializationMode = fmi2RemoteExitInitializationMode;
+    fmu->fmi2.terminate = fmi2RemoteTerminate;
+    fmu->fmi2.reset = fmi2RemoteReset;
+    fmu->fmi2.getReal = fmi2RemoteGetReal;
+    fmu->fmi2.setReal = fmi2RemoteSetReal;
+    fmu->fmi2.getInteger = fmi2RemoteGetInteger;
+    fmu->fmi2.setInteger = fmi2RemoteSetInteger;
+    fmu->fmi2.getBoolean = fmi2RemoteGetBoolean;
+    fmu->fmi2.setBoolean = fmi2RemoteSetBoolean;
+    fmu->fmi2.doStep = fmi2RemoteDoStep;
+    fmu->fmi2.getRealStatus = fmi2RemoteGetRealStatus;
+    fmu->fmi2.getBooleanStatus = fmi2RemoteGetBooleanStatus;
+    fmu->fmi2.getFMUstate = fmi2RemoteGetFMUstate;
+    fmu->fmi2.setFMUstate = fmi2RemoteSetFMUstate;
+    fmu->fmi2.freeFMUstate = fmi2RemoteFreeFMUstate;
+
+    int32_t intArgs[4] = { 2, visible, loggingOn, 0 };
+    return (fmi2Component*)startHost(fmu, intArgs);
+}
+
+//! @brief Installs the forwarding functions and starts a host process for a new FMI 3 co-simulation instance
+//! @param fmu Per-instance copy of the FMU handle, functions that are not forwarded report errors
+fmi3Component *fmi4c_instantiateRemoteFmi3(fmuHandle *fmu, fmi3Boolean visible, fmi3Boolean loggingOn, fmi3Boolean eventModeUsed, fmi3Boolean earlyReturnAllowed)
+{
+    fmi4c_setPlaceholdersFmi3(fmu);
+    fmu->fmi3.freeInstance = fmi3RemoteFreeInstance;
+    fmu->fmi3.enterInitializationMode = fmi3RemoteEnterInitializationMode;
+    fmu->fmi3.exitInitializationMode = fmi3RemoteExitInitializationMode;
+    fmu->fmi3.terminate = fmi3RemoteTerminate;
+    fmu->fmi3.reset = fmi3RemoteReset;
+    fmu->fmi3.getFloat64 = fmi3RemoteGetFloat64;
+    fmu->fmi3.setFloat64 = fmi3RemoteSetFloat64;
+    fmu->fmi3.getInt32 = fmi3RemoteGetInt32;
+    fmu->fmi3.setInt32 = fmi3RemoteSetInt32;
+    fmu->fmi3.getBoolean = fmi3RemoteGetBoolean;
+    fmu->fmi3.setBoolean = fmi3RemoteSetBoolean;
+    fmu->fmi3.doStep = fmi3RemoteDoStep;
+    fmu->fmi3.getFMUState = fmi3RemoteGetFMUState;
+    fmu->fmi3.setFMUState = fmi3RemoteSetFMUState;
+    fmu->fmi3.freeFMUState = fmi3RemoteFreeFMUState;
+
+    int32_t intArgs[4] = { 3, visible, loggingOn, (eventModeUsed ? 1 : 0) | (earlyReturnAllowed ? 2 : 0) };
+    return (fmi3Component*)startHost(fmu, intArgs);
+}
+
+
+// Host side
+
+typedef struct {
+    remoteChannel_t *channel;
+    fmuHandle *fmu;
+    fmi2InstanceHandle *fmi2Instance;
+    fmi3InstanceHandle *fmi3Instance;
+    void **states;                      // FMU states, identified by index+1 on the client side
+    size_t nStates;
+} hostData_t;
+
+static void hostLoggerFmi2(fmi2ComponentEnvironment componentEnvironment, fmi2String instanceName, fmi2Status status, fmi2String category, fmi2String message, ...)
+{
+    UNUSED(componentEnvironment)
+    UNUSED(status)
+    va_list args;
+    va_start(args, message);
+    fprintf(stderr, "%s (%s): ", instanceName, category);
+    vfprintf(stderr, message, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+}
+
+static void hostLoggerFmi3(fmi3InstanceEnvironment instanceEnvironment, fmi3Status status, fmi3String category, fmi3String message)
+{
+    UNUSED(instanceEnvironment)
+    UNUSED(status)
+    fprintf(stderr, "%s: %s\n", category, message);
+}
+
+static int hostInstantiate(hostData_t *host)
+{
+    remoteChannel_t *channel = host->channel;
+    const char *instanceName = channel->text;
+    const char *unzippedLocation = channel->text+strlen(instanceName)+1;
+    host->fmu = fmi4c_loadUnzippedFmu(instanceName, unzippedLocation);
+    if(host->fmu == NULL || (int)fmi4c_getFmiVersion(host->fmu) != channel->intArgs[0]) {
+        return REMOTE_ERROR;
+    }
+    if(channel->intArgs[0] == 2) {
+        host->fmi2Instance = fmi2_instantiate(host->fmu, fmi2CoSimulation, hostLoggerFmi2, calloc, free, NULL, NULL,
+                                              channel->intArgs[1], channel->intArgs[2]);
+        return (host->fmi2Instance != NULL && host->fmi2Instance->component != NULL) ? 0 : REMOTE_ERROR;
+    }
+    host->fmi3Instance = fmi3_instantiateCoSimulation(host->fmu, channel->intArgs[1], channel->intArgs[2],
+                                                      channel->intArgs[3] & 1, channel->intArgs[3] & 2,
+                                                      NULL, 0, NULL, hostLoggerFmi3, NULL);
+    return (host->fmi3Instance != NULL && host->fmi3Instance->component != NULL) ? 0 : REMOTE_ERROR;
+}
+
+//! @brief Stores a new FMU state and returns its identifier
+static uint64_t addState(hostData_t *host, void *state)
+{
+    for(size_t i=0; i<host->nStates; ++i) {
+        if(host->states[i] == NULL) {
+            host->states[i] = state;
+            return i+1;
+        }
+    }
+    void **states = realloc(host->states, (host->nStates+1)*sizeof(void*));
+    if(states == NULL) {
+        return 0;
+    }
+    host->states = states;
+    host->states[host->nStates++] = state;
+    return host->nStates;
+}
+
+static void *lookupState(hostData_t *host, uint64_t id)
+{
+    return (id > 0 && id <= host->nStates) ? host->states[id-1] : NULL;
+}
+
+//! @brief Stores the state from a get call under the identifier in the channel, or under a new one if there is none
+//! The FMU may return a different pointer when it updates an existing state, so it is always written back.
+static bool storeState(hostData_t *host, void *state)
+{
+    uint64_t id = host->channel->state;
+    if(id > 0 && id <= host->nStates) {
+        host->states[id-1] = state;
+        return true;
+    }
+    host->channel->state = addState(host, state);
+    return host->channel->state != 0;
+}
+
+static int serveFmi2(hostData_t *host, remoteFunction_t function)
+{
+    remoteChannel_t *channel = host->channel;
+    fmi2InstanceHandle *instance = host->fmi2Instance;
+    const fmi2ValueReference *vrs = (const fmi2ValueReference*)channel->data;
+    size_t n = (size_t)channel->count;
+    void *values = valuesPointer(channel);
+    fmi2Status status;
+    fmi2FMUstate state;
+
+    switch(function) {
+    case remoteFreeInstance:
+        fmi2_freeInstance(instance);
+        host->fmi2Instance = NULL;
+        return fmi2OK;
+    case remoteSetupExperiment:
+        return fmi2_setupExperiment(instance, channel->intArgs[0], channel->realArgs[0], channel->realArgs[1], channel->intArgs[1], channel->realArgs[2]);
+    case remoteEnterInitializationMode:
+        return fmi2_enterInitializationMode(instance);
+    case remoteExitInitializationMode:
+        return fmi2_exitInitializationMode(instance);
+    case remoteTerminate:
+        return fmi2_terminate(instance);
+    case remoteReset:
+        return fmi2_reset(instance);
+    case remoteGetReal:
+        return fmi2_getReal(instance, vrs, n, values);
+    case remoteSetReal:
+        return fmi2_setReal(instance, vrs, n, values);
+    case remoteGetInteger:
+        return fmi2_getInteger(instance, vrs, n, values);
+    case remoteSetInteger:
+        return fmi2_setInteger(instance, vrs, n, values);
+    case remoteGetBoolean:
+        return fmi2_getBoolean(instance, vrs, n, values);
+    case remoteSetBoolean:
+        return fmi2_setBoolean(instance, vrs, n, values);
+    case remoteDoStep:
+        return fmi2_doStep(instance, channel->realArgs[0], channel->realArgs[1], channel->intArgs[0]);
+    case remoteGetRealStatus:
+        return fmi2_getRealStatus(instance, (fmi2StatusKind)channel->intArgs[0], &channel->realArgs[0]);
+    case remoteGetBooleanStatus: {
+        fmi2Boolean value = fmi2False;
+        status = fmi2_getBooleanStatus(instance, (fmi2StatusKind)channel->intArgs[0], &value);
+        channel->intArgs[0] = value;
+        return status;
+    }
+    case remoteGetFMUState:
+        state = lookupState(host, channel->state);
+        status = fmi2_getFMUstate(instance, &state);
+        if(status <= fmi2Warning && !storeState(host, state)) {
+            fmi2_freeFMUstate(instance, &state);
+            status = fmi2Error;
+        }
+        return status;
+    case remoteSetFMUState:
+        return fmi2_setFMUstate(instance, lookupState(host, channel->state));
+    case remoteFreeFMUState:
+        state = lookupState(host, channel->state);
+        status = fmi2_freeFMUstate(instance, &state);
+        if(channel->state > 0 && channel->state <= host->nStates) {
+            host->states[channel->state-1] = NULL;
+        }
+        channel->state = 0;
+        return status;
+    default:
+        return fmi2Error;
+    }
+}
+
+static int serveFmi3(hostData_t *host, remoteFunction_t function)
+{
+    remoteChannel_t *channel = host->channel;
+    fmi3InstanceHandle *instance = host->fmi3Instance;
+    const fmi3ValueReference *vrs = (const fmi3ValueReference*)channel->data;
+    size_t n = (size_t)channel->count;
+    void *values = valuesPointer(channel);
+    fmi3Status status;
+    fmi3FMUState state;
+
+    switch(function) {
+    case remoteFreeInstance:
+        fmi3_freeInstance(instance);
+        host->fmi3Instance = NULL;
+        return fmi3OK;
+    case remoteEnterInitializationMode:
+        return fmi3_enterInitializationMode(instance, channel->intArgs[0], channel->realArgs[0], channel->realArgs[1], channel->intArgs[1], channel->realArgs[2]);
+    case remoteExitInitializationMode:
+        return fmi3_exitInitializationMode(instance);
+    case remoteTerminate:
+        return fmi3_terminate(instance);
+    case remoteReset:
+        return fmi3_reset(instance);
+    case remoteGetReal:
+        return fmi3_getFloat64(instance, vrs, n, values, n);
+    case remoteSetReal:
+        return fmi3_setFloat64(instance, vrs, n, values, n);
+    case remoteGetInteger:
+        return fmi3_getInt32(instance, vrs, n, values, n);
+    case remoteSetInteger:
+        return fmi3_setInt32(instance, vrs, n, values, n);
+    case remoteGetBoolean:
+        return fmi3_getBoolean(instance, vrs, n, values, n);
+    case remoteSetBoolean:
+        return fmi3_setBoolean(instance, vrs, n, values, n);
+    case remoteDoStep: {
+        fmi3Boolean eventHandlingNeeded = fmi3False;
+        fmi3Boolean terminateSimulation = fmi3False;
+        fmi3Boolean earlyReturn = fmi3False;
+        status = fmi3_doStep(instance, channel->realArgs[0], channel->realArgs[1], channel->intArgs[0],
+                             &eventHandlingNeeded, &terminateSimulation, &earlyReturn, &channel->realArgs[2]);
+        channel->intArgs[1] = eventHandlingNeeded;
+        channel->intArgs[2] = terminateSimulation;
+        channel->intArgs[3] = earlyReturn;
+        return status;
+    }
+    case remoteGetFMUState:
+        state = lookupState(host, channel->state);
+        status = fmi3_getFMUState(instance, &state);
+        if(status <= fmi3Warning && !storeState(host, state)) {
+            fmi3_freeFMUState(instance, &state);
+            status = fmi3Error;
+        }
+        return status;
+    case remoteSetFMUState:
+        return fmi3_setFMUState(instance, lookupState(host, channel->state));
+    case remoteFreeFMUState:
+        state = lookupState(host, channel->state);
+        status = fmi3_freeFMUState(instance, &state);
+        if(channel->state > 0 && channel->state <= host->nStates) {
+            host->states[channel->state-1] = NULL;
+        }
+        channel->state = 0;
+        return status;
+    default:
+        return fmi3Error;
+    }
+}
+
+//! @brief Serves calls from a remote instance until it is freed
+//! Called by the host executable with the shared memory file descriptor it was started with.
+//! @returns Zero if the instance was freed normally, non-zero otherwise
+int fmi4c_serveRemoteInstance(int fd)
+{
+    hostData_t host;
+    memset(&host, 0, sizeof(host));
+    host.channel = mmap(NULL, sizeof(remoteChannel_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(host.channel == MAP_FAILED) {
+        fmi4c_printMessage("Failed to map shared memory for FMU host");
+        return 1;
+    }
+    remoteChannel_t *channel = host.channel;
+
+    uint32_t request = 0;
+    bool running = true;
+    while(running) {
+        request = waitForChange(&channel->request, request, &channel->hostWaiting, 0);
+        remoteFunction_t function = (remoteFunction_t)channel->function;
+        int status;
+        if(function == remoteInstantiate) {
+            status = hostInstantiate(&host);
+        }
+        else if(host.fmi2Instance != NULL) {
+            status = serveFmi2(&host, function);
+        }
+        else if(host.fmi3Instance != NULL) {
+            status = serveFmi3(&host, function);
+        }
+        else {
+            status = REMOTE_ERROR;
+        }
+        running = (function != remoteFreeInstance) && !(function == remoteInstantiate && status != 0);
+        channel->status = status;
+        signalWord(&channel->response, request, &channel->clientWaiting);
+    }
+
+    if(host.fmu != NULL) {
+        fmi4c_freeFmu(host.fmu);
+    }
+    free(host.states);
+    munmap(channel, sizeof(remoteChannel_t));
+    return 0;
+}
+
+#else
+
+fmi2Component *fmi4c_instantiateRemoteFmi2(fmuHandle *fmu, fmi2Type type, fmi2Boolean visible, fmi2Boolean loggingOn)
+{
+    UNUSED(fmu)
+    UNUSED(type)
+    UNUSED(visible)
+    UNUSED(loggingOn)
+    fmi4c_printMessage("Out-of-process instances are only supported on Linux");
+    return NULL;
+}
+
+fmi3Component *fmi4c_instantiateRemoteFmi3(fmuHandle *fmu, fmi3Boolean visible, fmi3Boolean loggingOn, fmi3Boolean eventModeUsed, fmi3Boolean earlyReturnAllowed)
+{
+    UNUSED(fmu)
+    UNUSED(visible)
+    UNUSED(loggingOn)
+    UNUSED(eventModeUsed)
+    UNUSED(earlyReturnAllowed)
+    fmi4c_printMessage("Out-of-process instances are only supported on Linux");
+    return NULL;
+}
+
+int fmi4c_serveRemoteInstance(int fd)
+{
+    UNUSED(fd)
+    fmi4c_printMessage("Out-of-process instances are only supported on Linux");
+    return 1;
+}
+
+#endif
+
+//! @brief Runs all co-simulation instances of an FMU in separate host processes
+//! Must be called before instantiating. Pass NULL to load the FMU into the calling process again.
+//! @param hostExecutable Path to the host executable (fmi4chost)
+//! @returns False if out-of-process instances are not supported on this platform
+bool fmi4c_setFmuHostExecutable(fmuHandle *fmu, const char *hostExecutable)
+{
+#if defined(__linux__)
+    fmu->hostExecutable = (hostExecutable != NULL) ? duplicateAndRememberString(fmu, hostExecutable) : NULL;
+    return true;
+#else
+    UNUSED(fmu)
+    UNUSED(hostExecutable)
+    fmi4c_printMessage("Out-of-process instances are only supported on Linux");
+    return false;
+#endif
+}
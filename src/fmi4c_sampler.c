@@ -0,0 +1,373 @@
+#include "fmi4c_private.h"
+#define FMI4C_H_INTERNAL_INCLUDE
+#include "fmi4c.h"
+#include "fmi4c_common.h"
+#include "fmi4c_sampler.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SAMPLER_GRID_TOLERANCE 1e-6     // Fraction of the interval by which a sample may precede a grid point (accumulated step times)
+
+struct fmi4cResultSampler {
+    size_t nChannels;
+    char **names;
+    double interval;
+    double *deadbands;                  // Per channel, NAN if changes are not recorded
+    size_t *deadbandChannels;           // Channels with a deadband
+    size_t nDeadbandChannels;
+    bool *aggregated;                   // Per channel
+    size_t *aggregatedChannels;         // Channels with aggregation, in column order
+    size_t nAggregatedChannels;
+    const char **columnNames;           // Channels followed by aggregates, for creating the writer
+    char **aggregateNames;
+    fmi4cResultWriter *writer;
+    double *row;                        // Channels followed by aggregates, for the writer
+
+    bool hasPrevious;
+    bool previousRecorded;
+    bool recordNext;                    // The previous sample was the last before an event
+    double previousTime;
+    double *previous;                   // Last sample, written when flushing if it was not recorded
+    double *recorded;                   // Values of the last recorded row, for deadbands
+    double nextGridTime;
+
+    // Aggregates since the last recorded row, per aggregated channel
+    double windowStart;
+    double *minimum;
+    double *maximum;
+    double *integral;
+
+    fmi4cResultSamplerStatistics statistics;
+};
+
+static void freeColumnNames(fmi4cResultSampler *sampler)
+{
+    if(sampler->aggregateNames != NULL) {
+        for(size_t i=0; i<3*sampler->nAggregatedChannels; ++i) {
+            free(sampler->aggregateNames[i]);
+        }
+    }
+    free(sampler->aggregateNames);
+    free((void*)sampler->columnNames);
+    sampler->aggregateNames = NULL;
+    sampler->columnNames = NULL;
+}
+
+//! @brief Frees the sampler, without flushing it
+void fmi4c_freeResultSampler(fmi4cResultSampler *sampler)
+{
+    if(sampler == NULL) {
+        return;
+    }
+    freeColumnNames(sampler);
+    if(sampler->names != NULL) {
+        for(size_t i=0; i<sampler->nChannels; ++i) {
+            free(sampler->names[i]);
+        }
+    }
+    free(sampler->names);
+    free(sampler->deadbands);
+    free(sampler->deadbandChannels);
+    free(sampler->aggregated);
+    free(sampler->aggregatedChannels);
+    free(sampler->row);
+    free(sampler->previous);
+    free(sampler->recorded);
+    free(sampler->minimum);
+    free(sampler->maximum);
+    free(sampler->integral);
+    free(sampler);
+}
+
+//! @brief Creates a sampler that records every sample, until an interval, deadbands or aggregation are set
+//! @param nChannels Number of channels (variables), excluding time
+//! @param names Names of the channels, excluding time
+//! @returns Sampler, or NULL if out of memory
+fmi4cResultSampler *fmi4c_createResultSampler(size_t nChannels, const char **names)
+{
+    fmi4cResultSampler *sampler = calloc(1, sizeof(fmi4cResultSampler));
+    if(sampler == NULL) {
+        return NULL;
+    }
+    sampler->nChannels = nChannels;
+    sampler->names = calloc(nChannels+1, sizeof(char*));
+    sampler->deadbands = malloc((nChannels+1)*sizeof(double));
+    sampler->deadbandChannels = malloc((nChannels+1)*sizeof(size_t));
+    sampler->aggregated = calloc(nChannels+1, sizeof(bool));
+    sampler->aggregatedChannels = malloc((nChannels+1)*sizeof(size_t));
+    sampler->previous = malloc((nChannels+1)*sizeof(double));
+    sampler->recorded = malloc((nChannels+1)*sizeof(double));
+    if(sampler->names == NULL || sampler->deadbands == NULL || sampler->deadbandChannels == NULL || sampler->aggregated == NULL ||
+       sampler->aggregatedChannels == NULL || sampler->previous == NULL || sampler->recorded == NULL) {
+        fmi4c_freeResultSampler(sampler);
+        return NULL;
+    }
+    for(size_t i=0; i<nChannels; ++i) {
+        sampler->names[i] = _strdup(names[i]);
+        if(sampler->names[i] == NULL) {
+            fmi4c_freeResultSampler(sampler);
+            return NULL;
+        }
+        sampler->deadbands[i] = NAN;
+    }
+    return sampler;
+}
+
+//! @brief Sets the interval of the output grid, whose points are the multiples of the interval
+//! @param interval Time between grid points (0 = record every sample, INFINITY = no grid)
+void fmi4c_setResultSamplingInterval(fmi4cResultSampler *sampler, double interval)
+{
+    sampler->interval = interval > 0 ? interval : 0;
+}
+
+//! @brief Records a row whenever the channel has changed by more than the deadband since the last row
+//! @param deadband Largest change that is not recorded (0 = record every change, NAN = do not record changes)
+//! @returns False if there is no such channel
+bool fmi4c_setResultChannelDeadband(fmi4cResultSampler *sampler, size_t channel, double deadband)
+{
+    if(channel >= sampler->nChannels) {
+        fmi4c_printMessage("Result sampler channel out of range");
+        return false;
+    }
+    // The values of rows recorded so far were not kept, so measure changes from the last sample instead
+    if(sampler->nDeadbandChannels == 0 && sampler->hasPrevious) {
+        memcpy(sampler->recorded, sampler->previous, sampler->nChannels*sizeof(double));
+    }
+    sampler->deadbands[channel] = deadband;
+    sampler->nDeadbandChannels = 0;
+    for(size_t i=0; i<sampler->nChannels; ++i) {
+        if(!isnan(sampler->deadbands[i])) {
+            sampler->deadbandChannels[sampler->nDeadbandChannels++] = i;
+        }
+    }
+    return true;
+}
+
+//! @brief Adds minimum, maximum and mean columns for the channel, must be called before the writer is set
+//! @returns False if there is no such channel or the writer is set already
+bool fmi4c_setResultChannelAggregation(fmi4cResultSampler *sampler, size_t channel, bool aggregate)
+{
+    if(channel >= sampler->nChannels || sampler->writer != NULL) {
+        fmi4c_printMessage("Cannot change aggregation of result sampler channel");
+        return false;
+    }
+    freeColumnNames(sampler);
+    sampler->aggregated[channel] = aggregate;
+    sampler->nAggregatedChannels = 0;
+    for(size_t i=0; i<sampler->nChannels; ++i) {
+        if(sampler->aggregated[i]) {
+            sampler->aggregatedChannels[sampler->nAggregatedChannels++] = i;
+        }
+    }
+    return true;
+}
+
+//! @brief Returns the number of columns of recorded rows (channels and aggregates), excluding time
+size_t fmi4c_getResultSamplerNumberOfColumns(fmi4cResultSampler *sampler)
+{
+    return sampler->nChannels+3*sampler->nAggregatedChannels;
+}
+
+//! @brief Returns the names of the columns of recorded rows, for fmi4c_createResultWriter
+//! The names are valid until the aggregation is changed or the sampler is freed.
+//! @returns Array of fmi4c_getResultSamplerNumberOfColumns() names, or NULL if out of memory
+const char **fmi4c_getResultSamplerColumnNames(fmi4cResultSampler *sampler)
+{
+    if(sampler->columnNames != NULL) {
+        return sampler->columnNames;
+    }
+    static const char *prefixes[3] = { "min", "max", "mean" };
+    size_t nAggregates = 3*sampler->nAggregatedChannels;
+    sampler->columnNames = malloc((sampler->nChannels+nAggregates+1)*sizeof(const char*));
+    sampler->aggregateNames = calloc(nAggregates+1, sizeof(char*));
+    if(sampler->columnNames == NULL || sampler->aggregateNames == NULL) {
+        freeColumnNames(sampler);
+        return NULL;
+    }
+    for(size_t i=0; i<sampler->nChannels; ++i) {
+        sampler->columnNames[i] = sampler->names[i];
+    }
+    for(size_t i=0; i<nAggregates; ++i) {
+        const char *name = sampler->names[sampler->aggregatedChannels[i/3]];
+        size_t size = strlen(name)+8;
+        sampler->aggregateNames[i] = malloc(size);
+        if(sampler->aggregateNames[i] == NULL) {
+            freeColumnNames(sampler);
+            return NULL;
+        }
+        snprintf(sampler->aggregateNames[i], size, "%s(%s)", prefixes[i%3], name);
+        sampler->columnNames[sampler->nChannels+i] = sampler->aggregateNames[i];
+    }
+    return sampler->columnNames;
+}
+
+//! @brief Sets the writer of recorded rows, which must have fmi4c_getResultSamplerNumberOfColumns() variables
+//! The writer is not owned by the sampler. Flush the sampler before closing the writer.
+//! @returns False if out of memory
+bool fmi4c_setResultSamplerWriter(fmi4cResultSampler *sampler, fmi4cResultWriter *writer)
+{
+    size_t n = sampler->nAggregatedChannels;
+    if(n > 0 && sampler->row == NULL) {
+        sampler->row = malloc(fmi4c_getResultSamplerNumberOfColumns(sampler)*sizeof(double));
+        sampler->minimum = malloc(n*sizeof(double));
+        sampler->maximum = malloc(n*sizeof(double));
+        sampler->integral = malloc(n*sizeof(double));
+        if(sampler->row == NULL || sampler->minimum == NULL || sampler->maximum == NULL || sampler->integral == NULL) {
+            fmi4c_printMessage("Failed to allocate result sampler buffers");
+            free(sampler->row);
+            free(sampler->minimum);
+            free(sampler->maximum);
+            free(sampler->integral);
+            sampler->row = NULL;
+            sampler->minimum = NULL;
+            sampler->maximum = NULL;
+            sampler->integral = NULL;
+            return false;
+        }
+    }
+    sampler->writer = writer;
+    return true;
+}
+
+//! @brief Starts a new aggregation window at the sample
+static void resetAggregates(fmi4cResultSampler *sampler, double time, const double *values)
+{
+    sampler->windowStart = time;
+    for(size_t k=0; k<sampler->nAggregatedChannels; ++k) {
+        double value = values[sampler->aggregatedChannels[k]];
+        sampler->minimum[k] = value;
+        sampler->maximum[k] = value;
+        sampler->integral[k] = 0;
+    }
+}
+
+//! @brief Adds the interval from the previous sample to the aggregates
+static void updateAggregates(fmi4cResultSampler *sampler, double time, const double *values)
+{
+    double halfStep = 0.5*(time-sampler->previousTime);
+    const double *previous = sampler->previous;
+    for(size_t k=0; k<sampler->nAggregatedChannels; ++k) {
+        size_t i = sampler->aggregatedChannels[k];
+        double value = values[i];
+        sampler->minimum[k] = value < sampler->minimum[k] ? value : sampler->minimum[k];
+        sampler->maximum[k] = value > sampler->maximum[k] ? value : sampler->maximum[k];
+        sampler->integral[k] += halfStep*(previous[i]+value);
+    }
+}
+
+//! @brief Writes the sample with the aggregates of the current window, and starts the next window
+static bool recordRow(fmi4cResultSampler *sampler, double time, const double *values)
+{
+    bool ok;
+    size_t n = sampler->nAggregatedChannels;
+    if(n == 0) {
+        ok = fmi4c_writeResult(sampler->writer, time, values);
+    }
+    else {
+        double *aggregates = sampler->row+sampler->nChannels;
+        double duration = time-sampler->windowStart;
+        memcpy(sampler->row, values, sampler->nChannels*sizeof(double));
+        for(size_t k=0; k<n; ++k) {
+            aggregates[3*k] = sampler->minimum[k];
+            aggregates[3*k+1] = sampler->maximum[k];
+            aggregates[3*k+2] = duration > 0 ? sampler->integral[k]/duration : values[sampler->aggregatedChannels[k]];
+        }
+        ok = fmi4c_writeResult(sampler->writer, time, sampler->row);
+        resetAggregates(sampler, time, values);
+    }
+    if(sampler->nDeadbandChannels > 0) {
+        memcpy(sampler->recorded, values, sampler->nChannels*sizeof(double));
+    }
+    if(sampler->interval > 0 && !isinf(sampler->interval)) {
+        sampler->nextGridTime = (floor(time/sampler->interval+SAMPLER_GRID_TOLERANCE)+1)*sampler->interval;
+    }
+    ++sampler->statistics.numberOfRows;
+    return ok;
+}
+
+//! @brief Returns true if the time has reached the next point of the output grid
+static bool reachesGrid(fmi4cResultSampler *sampler, double time)
+{
+    if(sampler->interval == 0) {
+        return true;
+    }
+    return !isinf(sampler->interval) && time >= sampler->nextGridTime-SAMPLER_GRID_TOLERANCE*sampler->interval;
+}
+
+//! @brief Returns true if a channel has changed by more than its deadband since the last recorded row
+static bool exceedsDeadband(fmi4cResultSampler *sampler, const double *values)
+{
+    for(size_t k=0; k<sampler->nDeadbandChannels; ++k) {
+        size_t i = sampler->deadbandChannels[k];
+        if(fabs(values[i]-sampler->recorded[i]) > sampler->deadbands[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+//! @brief Passes a sample to the sampler, which records it if it is selected
+//! @param time Time of the sample, not earlier than the previous sample
+//! @param values One value per channel
+//! @param event True if an event follows this sample, so that it and the next sample are recorded
+//! @returns False if writing failed
+bool fmi4c_sampleResult(fmi4cResultSampler *sampler, double time, const double *values, bool event)
+{
+    if(sampler->writer == NULL) {
+        fmi4c_printMessage("Result sampler has no writer");
+        return false;
+    }
+    ++sampler->statistics.numberOfSamples;
+    bool record;
+    if(!sampler->hasPrevious) {
+        sampler->hasPrevious = true;
+        if(sampler->nAggregatedChannels > 0) {
+            resetAggregates(sampler, time, values);
+        }
+        record = true;
+    }
+    else {
+        updateAggregates(sampler, time, values);
+        if(event || sampler->recordNext) {
+            ++sampler->statistics.numberOfEventRows;
+            record = true;
+        }
+        else if(reachesGrid(sampler, time)) {
+            ++sampler->statistics.numberOfGridRows;
+            record = true;
+        }
+        else if(exceedsDeadband(sampler, values)) {
+            ++sampler->statistics.numberOfChangeRows;
+            record = true;
+        }
+        else {
+            record = false;
+        }
+    }
+
+    bool ok = !record || recordRow(sampler, time, values);
+    sampler->recordNext = event;
+    sampler->previousRecorded = record;
+    sampler->previousTime = time;
+    memcpy(sampler->previous, values, sampler->nChannels*sizeof(double));
+    return ok;
+}
+
+//! @brief Records the last sample if it was not recorded, so that the rows extend to the end of the simulation
+//! @returns False if writing failed
+bool fmi4c_flushResultSampler(fmi4cResultSampler *sampler)
+{
+    if(!sampler->hasPrevious || sampler->previousRecorded || sampler->writer == NULL) {
+        return true;
+    }
+    sampler->previousRecorded = true;
+    return recordRow(sampler, sampler->previousTime, sampler->previous);
+}
+
+//! @brief Returns statistics about samples and recorded rows
+void fmi4c_getResultSamplerStatistics(fmi4cResultSampler *sampler, fmi4cResultSamplerStatistics *statistics)
+{
+    *statistics = sampler->statistics;
+}
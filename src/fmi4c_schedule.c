@@ -0,0 +1,365 @@
+#include "fmi4c_schedule.h"
+
+#include <stdlib.h>
+
+//! @brief Directed graph in compressed sparse row form
+typedef struct {
+    int nNodes;
+    int *edgeStart;         // Outgoing edges of node i are edgeStart[i] to edgeStart[i+1]-1
+    int *edgeTarget;
+    bool *edgeFeedthrough;
+} graph_t;
+
+static void freeGraph(graph_t *graph)
+{
+    free(graph->edgeStart);
+    free(graph->edgeTarget);
+    free(graph->edgeFeedthrough);
+}
+
+//! @brief Builds the graph from an edge list, self edges are skipped
+static bool buildGraph(graph_t *graph, int nNodes, size_t nEdges, const int *edgeFrom, const int *edgeTo, const bool *edgeFeedthrough)
+{
+    graph->nNodes = nNodes;
+    graph->edgeStart = calloc((size_t)nNodes+1, sizeof(int));
+    graph->edgeTarget = malloc((nEdges > 0 ? nEdges : 1)*sizeof(int));
+    graph->edgeFeedthrough = malloc((nEdges > 0 ? nEdges : 1)*sizeof(bool));
+    if(graph->edgeStart == NULL || graph->edgeTarget == NULL || graph->edgeFeedthrough == NULL) {
+        freeGraph(graph);
+        return false;
+    }
+    for(size_t e=0; e<nEdges; ++e) {
+        if(edgeFrom[e] != edgeTo[e]) {
+            ++graph->edgeStart[edgeFrom[e]+1];
+        }
+    }
+    for(int i=0; i<nNodes; ++i) {
+        graph->edgeStart[i+1] += graph->edgeStart[i];
+    }
+    int *next = malloc((size_t)(nNodes > 0 ? nNodes : 1)*sizeof(int));
+    if(next == NULL) {
+        freeGraph(graph);
+        return false;
+    }
+    for(int i=0; i<nNodes; ++i) {
+        next[i] = graph->edgeStart[i];
+    }
+    for(size_t e=0; e<nEdges; ++e) {
+        if(edgeFrom[e] != edgeTo[e]) {
+            int k = next[edgeFrom[e]]++;
+            graph->edgeTarget[k] = edgeTo[e];
+            graph->edgeFeedthrough[k] = edgeFeedthrough[e];
+        }
+    }
+    free(next);
+    return true;
+}
+
+//! @brief Finds strongly connected components with Tarjan's algorithm (iterative)
+//! Components are numbered in reverse topological order, i.e. a component only has edges to
+//! components with lower numbers.
+//! @returns Number of components, or -1 on allocation failure
+static int findComponents(const graph_t *graph, int *component)
+{
+    int n = graph->nNodes;
+    size_t size = (size_t)(n > 0 ? n : 1)*sizeof(int);
+    int *index = malloc(size);
+    int *lowLink = malloc(size);
+    int *stack = malloc(size);
+    int *callStack = malloc(size);
+    int *nextEdge = malloc(size);
+    if(index == NULL || lowLink == NULL || stack == NULL || callStack == NULL || nextEdge == NULL) {
+        free(index);
+        free(lowLink);
+        free(stack);
+        free(callStack);
+        free(nextEdge);
+        return -1;
+    }
+    for(int i=0; i<n; ++i) {
+        index[i] = -1;
+        component[i] = -1;
+    }
+
+    int nextIndex = 0;
+    int nComponents = 0;
+    int stackSize = 0;
+    for(int root=0; root<n; ++root) {
+        if(index[root] >= 0) {
+            continue;
+        }
+        int callDepth = 0;
+        index[root] = lowLink[root] = nextIndex++;
+        nextEdge[root] = graph->edgeStart[root];
+        stack[stackSize++] = root;
+        callStack[callDepth++] = root;
+        while(callDepth > 0) {
+            int v = callStack[callDepth-1];
+            if(nextEdge[v] < graph->edgeStart[v+1]) {
+                int w = graph->edgeTarget[nextEdge[v]++];
+                if(index[w] < 0) {
+                    index[w] = lowLink[w] = nextIndex++;
+                    nextEdge[w] = graph->edgeStart[w];
+                    stack[stackSize++] = w;
+                    callStack[callDepth++] = w;
+                }
+                else if(component[w] < 0 && index[w] < lowLink[v]) {
+                    lowLink[v] = index[w];    // w is still on the stack
+                }
+                continue;
+            }
+            --callDepth;
+            if(callDepth > 0) {
+                int u = callStack[callDepth-1];
+                if(lowLink[v] < lowLink[u]) {
+                    lowLink[u] = lowLink[v];
+                }
+            }
+            if(lowLink[v] == index[v]) {
+                int w;
+                do {
+                    w = stack[--stackSize];
+                    component[w] = nComponents;
+                } while(w != v);
+                ++nComponents;
+            }
+        }
+    }
+
+    free(index);
+    free(lowLink);
+    free(stack);
+    free(callStack);
+    free(nextEdge);
+    return nComponents;
+}
+
+//! @brief Orders the members of one component along their feedthrough edges (Kahn's algorithm)
+//! Edges that end up pointing backwards are executed with the values from the previous step.
+//! @returns False if the feedthrough edges form a cycle (algebraic loop)
+static bool orderComponent(const graph_t *graph, const int *component, int *members, int nMembers, int *inDegree, int *queue)
+{
+    if(nMembers == 1) {
+        return true;
+    }
+    int c = component[members[0]];
+    for(int i=0; i<nMembers; ++i) {
+        inDegree[members[i]] = 0;
+    }
+    for(int i=0; i<nMembers; ++i) {
+        int v = members[i];
+        for(int e=graph->edgeStart[v]; e<graph->edgeStart[v+1]; ++e) {
+            if(graph->edgeFeedthrough[e] && component[graph->edgeTarget[e]] == c) {
+                ++inDegree[graph->edgeTarget[e]];
+            }
+        }
+    }
+    int head = 0;
+    int tail = 0;
+    for(int i=0; i<nMembers; ++i) {
+        if(inDegree[members[i]] == 0) {
+            queue[tail++] = members[i];
+        }
+    }
+    while(head < tail) {
+        int v = queue[head++];
+        for(int e=graph->edgeStart[v]; e<graph->edgeStart[v+1]; ++e) {
+            int w = graph->edgeTarget[e];
+            if(graph->edgeFeedthrough[e] && component[w] == c && --inDegree[w] == 0) {
+                queue[tail++] = w;
+            }
+        }
+    }
+    bool acyclic = (tail == nMembers);
+
+    // Members on a feedthrough cycle are appended in their original order
+    for(int i=0; i<nMembers; ++i) {
+        if(inDegree[members[i]] > 0) {
+            queue[tail++] = members[i];
+        }
+    }
+    for(int i=0; i<nMembers; ++i) {
+        members[i] = queue[i];
+    }
+    return acyclic;
+}
+
+static fmi4cSchedule *allocateSchedule(int nNodes, int nComponents, int nLevels)
+{
+    fmi4cSchedule *schedule = calloc(1, sizeof(fmi4cSchedule));
+    if(schedule == NULL) {
+        return NULL;
+    }
+    schedule->nNodes = nNodes;
+    schedule->nComponents = nComponents;
+    schedule->nLevels = nLevels;
+    schedule->order = malloc((size_t)(nNodes > 0 ? nNodes : 1)*sizeof(int));
+    schedule->componentStart = malloc((size_t)(nComponents+1)*sizeof(int));
+    schedule->levelStart = malloc((size_t)(nLevels+1)*sizeof(int));
+    if(schedule->order == NULL || schedule->componentStart == NULL || schedule->levelStart == NULL) {
+        fmi4c_freeSchedule(schedule);
+        return NULL;
+    }
+    return schedule;
+}
+
+//! @brief Creates a Gauss-Seidel schedule for a directed graph
+//! @param nNodes Number of nodes (subsystems)
+//! @param nEdges Number of edges (connections), duplicates are allowed
+//! @param edgeFrom Source node of each edge
+//! @param edgeTo Target node of each edge
+//! @param edgeFeedthrough True if the target input of the edge has direct feedthrough to a connected output
+//! @returns Schedule, or NULL on allocation failure
+fmi4cSchedule *fmi4c_createSchedule(int nNodes, size_t nEdges, const int *edgeFrom, const int *edgeTo, const bool *edgeFeedthrough)
+{
+    graph_t graph;
+    if(!buildGraph(&graph, nNodes, nEdges, edgeFrom, edgeTo, edgeFeedthrough)) {
+        return NULL;
+    }
+
+    // All work arrays share one allocation (there are never more components than nodes)
+    size_t n = (size_t)nNodes;
+    int *work = malloc((9*n+2)*sizeof(int));
+    if(work == NULL) {
+        freeGraph(&graph);
+        return NULL;
+    }
+    int *component = work;
+    int *componentLevel = component+n;
+    int *componentSize = componentLevel+n;
+    int *componentFirst = componentSize+n;      // First position of each component in nodesByComponent
+    int *nodesByComponent = componentFirst+n;   // Nodes grouped by component, in topological order
+    int *componentOrder = nodesByComponent+n;   // Components sorted by level
+    int *levelCount = componentOrder+n;         // n+2 elements
+    int *inDegree = levelCount+n+2;
+    int *queue = inDegree+n;
+
+    int nComponents = findComponents(&graph, component);
+    if(nComponents < 0) {
+        free(work);
+        freeGraph(&graph);
+        return NULL;
+    }
+
+    for(int c=0; c<nComponents; ++c) {
+        componentSize[c] = 0;
+        componentLevel[c] = 0;
+    }
+    for(int v=0; v<nNodes; ++v) {
+        ++componentSize[component[v]];
+    }
+    int position = 0;
+    for(int c=nComponents-1; c>=0; --c) {
+        componentFirst[c] = position;
+        position += componentSize[c];
+    }
+    for(int v=0; v<nNodes; ++v) {
+        nodesByComponent[componentFirst[component[v]]++] = v;
+    }
+    for(int c=0; c<nComponents; ++c) {
+        componentFirst[c] -= componentSize[c];
+    }
+
+    // Levels by longest path; components are visited in topological order, so the level of a
+    // component is final before its outgoing edges are processed
+    int nLevels = nComponents > 0 ? 1 : 0;
+    for(int i=0; i<nNodes; ++i) {
+        int v = nodesByComponent[i];
+        int c = component[v];
+        for(int e=graph.edgeStart[v]; e<graph.edgeStart[v+1]; ++e) {
+            int d = component[graph.edgeTarget[e]];
+            if(d != c && componentLevel[d] < componentLevel[c]+1) {
+                componentLevel[d] = componentLevel[c]+1;
+                if(componentLevel[d]+1 > nLevels) {
+                    nLevels = componentLevel[d]+1;
+                }
+            }
+        }
+    }
+
+    fmi4cSchedule *schedule = allocateSchedule(nNodes, nComponents, nLevels);
+    if(schedule == NULL) {
+        free(work);
+        freeGraph(&graph);
+        return NULL;
+    }
+
+    // Sort components by level (counting sort), and by lowest member within each level
+    for(int l=0; l<=nLevels; ++l) {
+        levelCount[l] = 0;
+    }
+    for(int c=0; c<nComponents; ++c) {
+        ++levelCount[componentLevel[c]+1];
+    }
+    for(int l=0; l<nLevels; ++l) {
+        levelCount[l+1] += levelCount[l];
+    }
+    for(int l=0; l<=nLevels; ++l) {
+        schedule->levelStart[l] = levelCount[l];
+    }
+    int *placed = inDegree;
+    for(int c=0; c<nComponents; ++c) {
+        placed[c] = 0;
+    }
+    for(int v=0; v<nNodes; ++v) {
+        int c = component[v];
+        if(!placed[c]) {
+            placed[c] = 1;
+            componentOrder[levelCount[componentLevel[c]]++] = c;
+        }
+    }
+
+    position = 0;
+    for(int k=0; k<nComponents; ++k) {
+        int c = componentOrder[k];
+        int *members = schedule->order+position;
+        schedule->componentStart[k] = position;
+        for(int i=0; i<componentSize[c]; ++i) {
+            members[i] = nodesByComponent[componentFirst[c]+i];
+        }
+        if(!orderComponent(&graph, component, members, componentSize[c], inDegree, queue)) {
+            ++schedule->nAlgebraicLoops;
+        }
+        position += componentSize[c];
+    }
+    schedule->componentStart[nComponents] = position;
+
+    // A feedthrough connection from a subsystem to itself is an algebraic loop on its own
+    for(size_t e=0; e<nEdges; ++e) {
+        if(edgeFrom[e] == edgeTo[e] && edgeFeedthrough[e]) {
+            ++schedule->nAlgebraicLoops;
+        }
+    }
+
+    free(work);
+    freeGraph(&graph);
+    return schedule;
+}
+
+//! @brief Creates a schedule where all nodes are independent and run in one level (Jacobi)
+fmi4cSchedule *fmi4c_createParallelSchedule(int nNodes)
+{
+    fmi4cSchedule *schedule = allocateSchedule(nNodes, nNodes, 1);
+    if(schedule == NULL) {
+        return NULL;
+    }
+    for(int i=0; i<nNodes; ++i) {
+        schedule->order[i] = i;
+        schedule->componentStart[i] = i;
+    }
+    schedule->componentStart[nNodes] = nNodes;
+    schedule->levelStart[0] = 0;
+    schedule->levelStart[1] = nNodes;
+    return schedule;
+}
+
+void fmi4c_freeSchedule(fmi4cSchedule *schedule)
+{
+    if(schedule == NULL) {
+        return;
+    }
+    free(schedule->order);
+    free(schedule->componentStart);
+    free(schedule->levelStart);
+    free(schedule);
+}
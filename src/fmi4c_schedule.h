@@ -0,0 +1,29 @@
+#ifndef FMIC_SCHEDULE_H
+#define FMIC_SCHEDULE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Execution schedule for a directed graph of subsystems
+//
+// Strongly connected components (coupling loops) are found with Tarjan's algorithm. The condensed
+// graph is acyclic and is split into levels, where all components in one level only depend on
+// components in earlier levels and can be executed concurrently. Members of a component are executed
+// serially, ordered along their feedthrough edges. If the feedthrough edges within a component form a
+// cycle, the component contains an algebraic loop.
+
+typedef struct {
+    int nNodes;
+    int *order;             // Nodes in execution order
+    int nComponents;
+    int *componentStart;    // Component i consists of order[componentStart[i]] to order[componentStart[i+1]-1]
+    int nLevels;
+    int *levelStart;        // Level i consists of components levelStart[i] to levelStart[i+1]-1
+    int nAlgebraicLoops;
+} fmi4cSchedule;
+
+fmi4cSchedule *fmi4c_createSchedule(int nNodes, size_t nEdges, const int *edgeFrom, const int *edgeTo, const bool *edgeFeedthrough);
+fmi4cSchedule *fmi4c_createParallelSchedule(int nNodes);
+void fmi4c_freeSchedule(fmi4cSchedule *schedule);
+
+#endif // FMIC_SCHEDULE_H
@@ -0,0 +1,593 @@
+#include "fmi4c_private.h"
+#define FMI4C_H_INTERNAL_INCLUDE
+#include "fmi4c.h"
+#include "fmi4c_scheduler.h"
+#include "fmi4c_threads.h"
+
+#include <math.h>
+#include <string.h>
+
+#define TIME_EPSILON 1e-9                   // Relative tolerance for activations at the same time instant
+#define MAX_REAL_TIME_PRIORITY 80           // SCHED_FIFO priority of the highest clock priority
+#define QUEUE_CAPACITY 64                   // Initial number of queued activations per priority level
+
+typedef enum {
+    clockPeriodic,
+    clockCountdown,
+    clockTriggered
+} clockKind_t;
+
+typedef struct {
+    fmi3ValueReference valueReference;
+    clockKind_t kind;
+    int level;                              // Index of the priority level
+    double interval;                        // Period of periodic clocks
+    double shift;
+    size_t tick;                            // Number of periodic activations released
+    double nextActivation;                  // Simulation time of the next activation, INFINITY if none
+
+    size_t pending;                         // Activations queued or running
+    size_t activations;
+    size_t deadlineMisses;
+    double maxResponseTime;
+} scheduledClock_t;
+
+typedef struct {
+    int clock;
+    double activationTime;
+    double releaseTime;                     // Wall time when the activation was released
+} activation_t;
+
+typedef struct {
+    struct fmi4cScheduler *scheduler;
+    int priority;                           // FMU priority of the clocks on this level
+    fmi4cThread_t thread;
+    fmi4cCond_t condition;
+    activation_t *queue;                    // Ring buffer of released activations
+    size_t capacity;
+    size_t head;
+    size_t count;
+    size_t running;
+} priorityLevel_t;
+
+struct fmi4cScheduler {
+    fmi3InstanceHandle *instance;
+    fmi3InstanceEnvironment instanceEnvironment;
+    fmi3LogMessageCallback logMessage;
+    bool realTime;
+
+    scheduledClock_t *clocks;
+    int numberOfClocks;
+    priorityLevel_t *levels;
+    int numberOfLevels;
+
+    fmi4cMutex_t mutex;
+    fmi4cCond_t dispatcherCondition;        // Signalled when activations finish or clocks change
+    bool running;
+    bool quit;
+    bool failed;
+    volatile size_t stopRequested;
+    size_t numberOfPending;
+    bool started;
+    double originTime;                      // Start time of the first run, periodic clocks are aligned to it
+    double startTime;
+    double startWallTime;
+    double currentTime;
+};
+
+// Preemption lock shared by all scheduled execution instances, since the callbacks have no arguments
+static fmi4cMutex_t preemptionMutex;
+static volatile size_t preemptionMutexState = 0;  // 0 = uninitialized, 1 = initializing, 2 = ready
+
+// Activation time of the partition running on the current thread, used for countdown clocks
+static FMI4C_THREAD_LOCAL double currentActivationTime = 0;
+
+static void initPreemptionMutex(void)
+{
+    if(fmi4c_atomicCompareExchange(&preemptionMutexState, 0, 1)) {
+        fmi4c_mutexInit(&preemptionMutex);
+        fmi4c_atomicStoreRelease(&preemptionMutexState, 2);
+    }
+    while(fmi4c_atomicLoadAcquire(&preemptionMutexState) != 2) {
+        fmi4c_cpuRelax();
+    }
+}
+
+static void lockPreemption(void)
+{
+    fmi4c_mutexLock(&preemptionMutex);
+}
+
+static void unlockPreemption(void)
+{
+    fmi4c_mutexUnlock(&preemptionMutex);
+}
+
+static void forwardLogMessage(fmi3InstanceEnvironment instanceEnvironment, fmi3Status status, fmi3String category, fmi3String message)
+{
+    fmi4cScheduler *scheduler = instanceEnvironment;
+    if(scheduler->logMessage != NULL) {
+        scheduler->logMessage(scheduler->instanceEnvironment, status, category, message);
+    }
+}
+
+static scheduledClock_t *findClock(fmi4cScheduler *scheduler, fmi3ValueReference clockReference)
+{
+    for(int i=0; i<scheduler->numberOfClocks; ++i) {
+        if(scheduler->clocks[i].valueReference == clockReference) {
+            return &scheduler->clocks[i];
+        }
+    }
+    return NULL;
+}
+
+//! @brief Called by the FMU when countdown or changing clocks have new intervals
+//! Runs on the thread of the calling partition. The new activation is relative to its activation time.
+static void clockUpdate(fmi3InstanceEnvironment instanceEnvironment)
+{
+    fmi4cScheduler *scheduler = instanceEnvironment;
+    for(int i=0; i<scheduler->numberOfClocks; ++i) {
+        scheduledClock_t *clock = &scheduler->clocks[i];
+        if(clock->kind != clockCountdown) {
+            continue;
+        }
+        fmi3Float64 interval = 0;
+        fmi3IntervalQualifier qualifier = fmi3IntervalNotYetKnown;
+        fmi3Status status = fmi3_getIntervalDecimal(scheduler->instance, &clock->valueReference, 1, &interval, &qualifier);
+        if(status <= fmi3Warning && qualifier == fmi3IntervalChanged) {
+            fmi4c_mutexLock(&scheduler->mutex);
+            clock->nextActivation = currentActivationTime+interval;
+            fmi4c_condSignal(&scheduler->dispatcherCondition);
+            fmi4c_mutexUnlock(&scheduler->mutex);
+        }
+    }
+}
+
+//! @brief Queues one activation on the worker for its priority, must be called with the mutex locked
+//! Periodic activations are skipped and counted as deadline misses if the previous one has not finished.
+static bool releaseActivation(fmi4cScheduler *scheduler, scheduledClock_t *clock, double activationTime)
+{
+    if(clock->kind == clockPeriodic && clock->pending > 0) {
+        ++clock->deadlineMisses;
+        return true;
+    }
+    priorityLevel_t *level = &scheduler->levels[clock->level];
+    if(level->count == level->capacity) {
+        activation_t *queue = malloc(2*level->capacity*sizeof(activation_t));
+        if(queue == NULL) {
+            return false;
+        }
+        for(size_t i=0; i<level->count; ++i) {
+            queue[i] = level->queue[(level->head+i) % level->capacity];
+        }
+        free(level->queue);
+        level->queue = queue;
+        level->head = 0;
+        level->capacity *= 2;
+    }
+    activation_t *activation = &level->queue[(level->head+level->count) % level->capacity];
+    activation->clock = (int)(clock-scheduler->clocks);
+    activation->activationTime = activationTime;
+    activation->releaseTime = fmi4c_getWallTime();
+    ++level->count;
+    ++clock->pending;
+    ++scheduler->numberOfPending;
+    fmi4c_condSignal(&level->condition);
+    return true;
+}
+
+static void workerThread(void *arg)
+{
+    priorityLevel_t *level = arg;
+    fmi4cScheduler *scheduler = level->scheduler;
+
+    if(scheduler->realTime) {
+        int rank = (int)(level-scheduler->levels);
+        if(!fmi4c_threadSetRealTimePriority(MAX_REAL_TIME_PRIORITY-rank) && rank == 0) {
+            fmi4c_printMessage("Failed to set real-time thread priorities, running with normal priorities");
+        }
+    }
+
+    fmi4c_mutexLock(&scheduler->mutex);
+    while(true) {
+        while(level->count == 0 && !scheduler->quit) {
+            fmi4c_condWait(&level->condition, &scheduler->mutex);
+        }
+        if(level->count == 0) {
+            break;
+        }
+        activation_t activation = level->queue[level->head];
+        level->head = (level->head+1) % level->capacity;
+        --level->count;
+        ++level->running;
+        fmi4c_mutexUnlock(&scheduler->mutex);
+
+        scheduledClock_t *clock = &scheduler->clocks[activation.clock];
+        currentActivationTime = activation.activationTime;
+        fmi3Status status = fmi3_activateModelPartition(scheduler->instance, clock->valueReference, activation.activationTime);
+        double responseTime = fmi4c_getWallTime()-activation.releaseTime;
+
+        fmi4c_mutexLock(&scheduler->mutex);
+        --level->running;
+        --clock->pending;
+        ++clock->activations;
+        if(responseTime > clock->maxResponseTime) {
+            clock->maxResponseTime = responseTime;
+        }
+        if(scheduler->realTime && clock->kind == clockPeriodic && responseTime > clock->interval) {
+            ++clock->deadlineMisses;
+        }
+        if(status > fmi3Warning) {
+            scheduler->failed = true;
+            fmi4c_atomicStoreRelease(&scheduler->stopRequested, 1);
+        }
+        --scheduler->numberOfPending;
+        fmi4c_condSignal(&scheduler->dispatcherCondition);
+    }
+    fmi4c_mutexUnlock(&scheduler->mutex);
+}
+
+//! @brief Returns the earliest pending clock activation time, INFINITY if there is none
+static double nextActivationTime(fmi4cScheduler *scheduler)
+{
+    double time = INFINITY;
+    for(int i=0; i<scheduler->numberOfClocks; ++i) {
+        if(scheduler->clocks[i].nextActivation < time) {
+            time = scheduler->clocks[i].nextActivation;
+        }
+    }
+    return time;
+}
+
+static bool isSameInstant(double t1, double t2)
+{
+    return fabs(t1-t2) <= TIME_EPSILON*fmax(1.0, fabs(t1));
+}
+
+//! @brief Waits until all released activations have finished, must be called with the mutex locked
+static void waitForActivations(fmi4cScheduler *scheduler)
+{
+    while(scheduler->numberOfPending > 0) {
+        fmi4c_condWait(&scheduler->dispatcherCondition, &scheduler->mutex);
+    }
+}
+
+//! @brief Releases all activations at the specified time, must be called with the mutex locked
+static bool releaseActivations(fmi4cScheduler *scheduler, double time)
+{
+    scheduler->currentTime = time;
+    for(int l=0; l<scheduler->numberOfLevels; ++l) {
+        for(int i=0; i<scheduler->numberOfClocks; ++i) {
+            scheduledClock_t *clock = &scheduler->clocks[i];
+            if(clock->level != l || !isSameInstant(clock->nextActivation, time)) {
+                continue;
+            }
+            if(clock->kind == clockPeriodic) {
+                ++clock->tick;
+                clock->nextActivation = scheduler->originTime+clock->shift+(double)clock->tick*clock->interval;
+            }
+            else {
+                clock->nextActivation = INFINITY;
+            }
+            if(!releaseActivation(scheduler, clock, time)) {
+                return false;
+            }
+        }
+        // Emulate preemption deterministically: higher priorities finish before lower ones start
+        if(!scheduler->realTime) {
+            waitForActivations(scheduler);
+        }
+    }
+    return true;
+}
+
+static bool isPeriodic(fmi3IntervalVariability intervalVariability)
+{
+    return intervalVariability == fmi3IntervalVariabilityConstant ||
+           intervalVariability == fmi3IntervalVariabilityFixed ||
+           intervalVariability == fmi3IntervalVariabilityCalculated ||
+           intervalVariability == fmi3IntervalVariabilityTunable;
+}
+
+static int compareInt(const void *a, const void *b)
+{
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+//! @brief Builds the clock and priority level tables from the input clocks in the model description
+static bool buildClockTables(fmi4cScheduler *scheduler, fmuHandle *fmu)
+{
+    int numberOfVariables = fmi3_getNumberOfVariables(fmu);
+    scheduler->clocks = calloc((size_t)numberOfVariables+1, sizeof(scheduledClock_t));
+    int *priorities = calloc((size_t)numberOfVariables+1, sizeof(int));
+    if(scheduler->clocks == NULL || priorities == NULL) {
+        free(priorities);
+        return false;
+    }
+
+    for(int i=0; i<numberOfVariables; ++i) {
+        fmi3VariableHandle *var = fmi3_getVariableByIndex(fmu, i+1);
+        if(fmi3_getVariableDataType(var) != fmi3DataTypeClock || fmi3_getVariableCausality(var) != fmi3CausalityInput) {
+            continue;
+        }
+        scheduledClock_t *clock = &scheduler->clocks[scheduler->numberOfClocks];
+        clock->valueReference = fmi3_getVariableValueReference(var);
+        fmi3IntervalVariability intervalVariability = fmi3_getVariableIntervalVariability(var);
+        if(isPeriodic(intervalVariability)) {
+            clock->kind = clockPeriodic;
+        }
+        else if(intervalVariability == fmi3IntervalVariabilityCountdown || intervalVariability == fmi3IntervalVariabilityChanging) {
+            clock->kind = clockCountdown;
+        }
+        else {
+            clock->kind = clockTriggered;
+        }
+        clock->interval = fmi3_getVariableIntervalDecimal(var);
+        clock->shift = fmi3_getVariableShiftDecimal(var);
+        clock->level = fmi3_getVariablePriority(var);   // Replaced by the level index below
+        priorities[scheduler->numberOfClocks] = clock->level;
+        ++scheduler->numberOfClocks;
+    }
+    if(scheduler->numberOfClocks == 0) {
+        fmi4c_printMessage("FMU has no input clocks to schedule");
+        free(priorities);
+        return false;
+    }
+
+    // One priority level per distinct priority, highest priority (lowest value) first
+    qsort(priorities, (size_t)scheduler->numberOfClocks, sizeof(int), compareInt);
+    scheduler->levels = calloc((size_t)scheduler->numberOfClocks, sizeof(priorityLevel_t));
+    if(scheduler->levels == NULL) {
+        free(priorities);
+        return false;
+    }
+    for(int i=0; i<scheduler->numberOfClocks; ++i) {
+        if(i == 0 || priorities[i] != priorities[i-1]) {
+            scheduler->levels[scheduler->numberOfLevels++].priority = priorities[i];
+        }
+    }
+    free(priorities);
+    for(int i=0; i<scheduler->numberOfClocks; ++i) {
+        scheduledClock_t *clock = &scheduler->clocks[i];
+        int l = 0;
+        while(scheduler->levels[l].priority != clock->level) {
+            ++l;
+        }
+        clock->level = l;
+    }
+    return true;
+}
+
+//! @brief Instantiates an FMU for scheduled execution and starts one worker thread per clock priority
+//! @param realTime Release activations at wall-clock times with real-time thread priorities
+//! @returns Scheduler handle, or NULL on failure
+fmi4cScheduler *fmi4c_createScheduler(fmuHandle *fmu,
+                                      fmi3Boolean visible,
+                                      fmi3Boolean loggingOn,
+                                      fmi3InstanceEnvironment instanceEnvironment,
+                                      fmi3LogMessageCallback logMessage,
+                                      bool realTime)
+{
+    if(fmi4c_getFmiVersion(fmu) != fmiVersion3 || !fmi3_supportsScheduledExecution(fmu)) {
+        fmi4c_printMessage("FMU does not support scheduled execution");
+        return NULL;
+    }
+    fmi4cScheduler *scheduler = calloc(1, sizeof(fmi4cScheduler));
+    if(scheduler == NULL) {
+        return NULL;
+    }
+    scheduler->instanceEnvironment = instanceEnvironment;
+    scheduler->logMessage = logMessage;
+    scheduler->realTime = realTime;
+    if(!buildClockTables(scheduler, fmu)) {
+        free(scheduler->clocks);
+        free(scheduler->levels);
+        free(scheduler);
+        return NULL;
+    }
+
+    initPreemptionMutex();
+    scheduler->instance = fmi3_instantiateScheduledExecution(fmu, visible, loggingOn, scheduler, forwardLogMessage,
+                                                             clockUpdate, lockPreemption, unlockPreemption);
+    if(scheduler->instance == NULL) {
+        fmi4c_printMessage("Failed to instantiate FMU for scheduled execution");
+        free(scheduler->clocks);
+        free(scheduler->levels);
+        free(scheduler);
+        return NULL;
+    }
+
+    fmi4c_mutexInit(&scheduler->mutex);
+    fmi4c_condInit(&scheduler->dispatcherCondition);
+    for(int l=0; l<scheduler->numberOfLevels; ++l) {
+        priorityLevel_t *level = &scheduler->levels[l];
+        level->scheduler = scheduler;
+        level->capacity = QUEUE_CAPACITY;
+        level->queue = malloc(level->capacity*sizeof(activation_t));
+        fmi4c_condInit(&level->condition);
+        if(level->queue == NULL || !fmi4c_threadCreate(&level->thread, workerThread, level)) {
+            fmi4c_printMessage("Failed to start scheduler worker thread");
+            free(level->queue);
+            level->queue = NULL;
+            fmi4c_condDestroy(&level->condition);
+            scheduler->numberOfLevels = l;
+            fmi4c_freeScheduler(scheduler);
+            return NULL;
+        }
+    }
+    return scheduler;
+}
+
+//! @brief Stops the worker threads and frees the scheduler and its FMU instance
+//! Must not be called while fmi4c_runScheduler is running.
+void fmi4c_freeScheduler(fmi4cScheduler *scheduler)
+{
+    if(scheduler == NULL) {
+        return;
+    }
+    fmi4c_mutexLock(&scheduler->mutex);
+    scheduler->quit = true;
+    for(int l=0; l<scheduler->numberOfLevels; ++l) {
+        fmi4c_condSignal(&scheduler->levels[l].condition);
+    }
+    fmi4c_mutexUnlock(&scheduler->mutex);
+    for(int l=0; l<scheduler->numberOfLevels; ++l) {
+        fmi4c_threadJoin(scheduler->levels[l].thread);
+        fmi4c_condDestroy(&scheduler->levels[l].condition);
+        free(scheduler->levels[l].queue);
+    }
+    fmi3_freeInstance(scheduler->instance);
+    fmi4c_condDestroy(&scheduler->dispatcherCondition);
+    fmi4c_mutexDestroy(&scheduler->mutex);
+    free(scheduler->levels);
+    free(scheduler->clocks);
+    free(scheduler);
+}
+
+//! @brief Returns the FMU instance, e.g. for initialization and for getting and setting variables
+//! Variables shared with running partitions should only be accessed while no activations are running.
+fmi3InstanceHandle *fmi4c_getSchedulerInstance(fmi4cScheduler *scheduler)
+{
+    return scheduler->instance;
+}
+
+//! @brief Activates the model partitions due from startTime up to, but not including, stopTime
+//! Blocks until done. The instance must have been initialized before the first call. Consecutive
+//! calls continue the clock schedule, so inputs can be set between them.
+//! @returns False if a partition failed or the scheduler could not release activations
+bool fmi4c_runScheduler(fmi4cScheduler *scheduler, double startTime, double stopTime)
+{
+    if(!scheduler->started) {
+        scheduler->started = true;
+        scheduler->originTime = startTime;
+        for(int i=0; i<scheduler->numberOfClocks; ++i) {
+            scheduler->clocks[i].nextActivation = INFINITY;
+        }
+    }
+
+    // Intervals of fixed and calculated clocks are known to the FMU after initialization
+    for(int i=0; i<scheduler->numberOfClocks; ++i) {
+        scheduledClock_t *clock = &scheduler->clocks[i];
+        if(clock->kind != clockPeriodic) {
+            continue;
+        }
+        fmi3Float64 interval = 0;
+        fmi3IntervalQualifier qualifier = fmi3IntervalNotYetKnown;
+        fmi3Status status = fmi3_getIntervalDecimal(scheduler->instance, &clock->valueReference, 1, &interval, &qualifier);
+        if(status <= fmi3Warning && qualifier != fmi3IntervalNotYetKnown && interval > 0) {
+            clock->interval = interval;
+        }
+        if(clock->interval > 0) {
+            double ticks = ceil((startTime-scheduler->originTime-clock->shift)/clock->interval-TIME_EPSILON);
+            clock->tick = ticks > 0 ? (size_t)ticks : 0;
+            clock->nextActivation = scheduler->originTime+clock->shift+(double)clock->tick*clock->interval;
+        }
+        else {
+            clock->nextActivation = INFINITY;
+            fmi4c_printMessage("Periodic clock without a known interval is not scheduled");
+        }
+    }
+
+    fmi4c_mutexLock(&scheduler->mutex);
+    scheduler->running = true;
+    scheduler->failed = false;
+    fmi4c_atomicStoreRelease(&scheduler->stopRequested, 0);
+    scheduler->startTime = startTime;
+    scheduler->currentTime = startTime;
+    scheduler->startWallTime = fmi4c_getWallTime();
+
+    bool ok = true;
+    while(ok && !fmi4c_atomicLoadAcquire(&scheduler->stopRequested)) {
+        double time = nextActivationTime(scheduler);
+        if(scheduler->realTime) {
+            // Sleep until the next activation is due, waking up for clock updates and stop requests
+            double wakeTime = scheduler->startWallTime+(fmin(time, stopTime)-startTime);
+            double now = fmi4c_getWallTime();
+            if(now < wakeTime) {
+                fmi4c_condTimedWait(&scheduler->dispatcherCondition, &scheduler->mutex, (long)ceil((wakeTime-now)*1e6));
+                continue;
+            }
+        }
+        else {
+            // Released activations may reschedule countdown clocks, so wait for them before advancing time
+            waitForActivations(scheduler);
+            if(nextActivationTime(scheduler) != time) {
+                continue;
+            }
+        }
+        if(time > stopTime || isSameInstant(time, stopTime)) {
+            break;
+        }
+        ok = releaseActivations(scheduler, time);
+    }
+    waitForActivations(scheduler);
+    scheduler->currentTime = stopTime;
+    scheduler->running = false;
+    ok = ok && !scheduler->failed;
+    fmi4c_mutexUnlock(&scheduler->mutex);
+    return ok;
+}
+
+//! @brief Makes fmi4c_runScheduler return after the running activations have finished
+//! Can be called from any thread, including from within callbacks.
+void fmi4c_stopScheduler(fmi4cScheduler *scheduler)
+{
+    fmi4c_atomicStoreRelease(&scheduler->stopRequested, 1);
+    fmi4c_mutexLock(&scheduler->mutex);
+    fmi4c_condSignal(&scheduler->dispatcherCondition);
+    fmi4c_mutexUnlock(&scheduler->mutex);
+}
+
+//! @brief Activates the model partition of a clock at the current time, e.g. on an external event
+//! Can be called from any thread while fmi4c_runScheduler is running.
+//! @returns False if the scheduler is not running or the clock is unknown
+bool fmi4c_triggerSchedulerClock(fmi4cScheduler *scheduler, fmi3ValueReference clockReference)
+{
+    scheduledClock_t *clock = findClock(scheduler, clockReference);
+    if(clock == NULL) {
+        fmi4c_printMessage("Unknown clock value reference");
+        return false;
+    }
+    fmi4c_mutexLock(&scheduler->mutex);
+    bool ok = scheduler->running;
+    if(ok) {
+        double time = scheduler->currentTime;
+        if(scheduler->realTime) {
+            time = scheduler->startTime+(fmi4c_getWallTime()-scheduler->startWallTime);
+        }
+        ok = releaseActivation(scheduler, clock, time);
+    }
+    fmi4c_mutexUnlock(&scheduler->mutex);
+    return ok;
+}
+
+int fmi4c_getSchedulerNumberOfClocks(fmi4cScheduler *scheduler)
+{
+    return scheduler->numberOfClocks;
+}
+
+fmi3ValueReference fmi4c_getSchedulerClockValueReference(fmi4cScheduler *scheduler, int i)
+{
+    return scheduler->clocks[i].valueReference;
+}
+
+size_t fmi4c_getSchedulerNumberOfActivations(fmi4cScheduler *scheduler, fmi3ValueReference clockReference)
+{
+    scheduledClock_t *clock = findClock(scheduler, clockReference);
+    return clock != NULL ? clock->activations : 0;
+}
+
+size_t fmi4c_getSchedulerNumberOfDeadlineMisses(fmi4cScheduler *scheduler, fmi3ValueReference clockReference)
+{
+    scheduledClock_t *clock = findClock(scheduler, clockReference);
+    return clock != NULL ? clock->deadlineMisses : 0;
+}
+
+//! @brief Returns the longest time from release to completion of an activation of a clock, in seconds
+double fmi4c_getSchedulerMaxResponseTime(fmi4cScheduler *scheduler, fmi3ValueReference clockReference)
+{
+    scheduledClock_t *clock = findClock(scheduler, clockReference);
+    return clock != NULL ? clock->maxResponseTime : 0;
+}
@@ -0,0 +1,344 @@
+#include "fmi4c_private.h"
+#define FMI4C_H_INTERNAL_INCLUDE
+#include "fmi4c.h"
+#include "fmi4c_simulation.h"
+#include "fmi4c_common.h"
+
+#include <math.h>
+#include <string.h>
+
+//! @brief State of one simulation run
+typedef struct {
+    fmiVersion_t fmiVersion;
+    fmi2InstanceHandle *fmi2Instance;
+    fmi3InstanceHandle *fmi3Instance;
+
+    const unsigned int *inputRefs;
+    size_t nInputs;
+    const double *inputTimes;
+    const double *inputValues;
+    size_t nInputTimes;
+    size_t inputRow;            // Last row at or before the current time (0 before the first row)
+    double *values;             // Interpolated input values
+    bool setDerivatives;        // Set the slopes of the input table on the FMU (FMI 2 co-simulation)
+    double *derivatives;        // Slopes of the input table, NULL if not set on the FMU
+    fmi2Integer *orders;
+
+    const unsigned int *outputRefs;
+    size_t nOutputs;
+    double *results;
+    size_t nTimes;
+} simulation_t;
+
+static bool isIncreasing(const double *times, size_t nTimes, bool strictly)
+{
+    for(size_t i=1; i<nTimes; ++i) {
+        if(!(times[i] > times[i-1]) && !(!strictly && times[i] == times[i-1])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//! @brief Interpolates the input table at a time and sets the values on the FMU
+//! Times must not decrease between calls, the row cursor only moves forward.
+static bool setInputs(simulation_t *simulation, double time)
+{
+    if(simulation->nInputs == 0) {
+        return true;
+    }
+    const double *times = simulation->inputTimes;
+    size_t n = simulation->nInputTimes;
+    size_t row = simulation->inputRow;
+    while(row+1 < n && times[row+1] <= time) {
+        ++row;
+    }
+    simulation->inputRow = row;
+
+    const double *values = simulation->inputValues+row*simulation->nInputs;
+    if(time < times[0] || row+1 == n) {
+        memcpy(simulation->values, values, simulation->nInputs*sizeof(double));
+        if(simulation->derivatives != NULL) {
+            memset(simulation->derivatives, 0, simulation->nInputs*sizeof(double));
+        }
+    }
+    else {
+        const double *nextValues = values+simulation->nInputs;
+        double interval = times[row+1]-times[row];
+        double fraction = (time-times[row])/interval;
+        for(size_t i=0; i<simulation->nInputs; ++i) {
+            simulation->values[i] = values[i]+fraction*(nextValues[i]-values[i]);
+        }
+        if(simulation->derivatives != NULL) {
+            for(size_t i=0; i<simulation->nInputs; ++i) {
+                simulation->derivatives[i] = (nextValues[i]-values[i])/interval;
+            }
+        }
+    }
+
+    if(simulation->fmiVersion == fmiVersion2) {
+        if(fmi2_setReal(simulation->fmi2Instance, simulation->inputRefs, simulation->nInputs, simulation->values) > fmi2Warning) {
+            return false;
+        }
+        return simulation->derivatives == NULL ||
+               fmi2_setRealInputDerivatives(simulation->fmi2Instance, simulation->inputRefs, simulation->nInputs,
+                                            simulation->orders, simulation->derivatives) <= fmi2Warning;
+    }
+    return fmi3_setFloat64(simulation->fmi3Instance, simulation->inputRefs, simulation->nInputs,
+                           simulation->values, simulation->nInputs) <= fmi3Warning;
+}
+
+//! @brief Reads the outputs into one row of the results
+static bool getOutputs(simulation_t *simulation, size_t row)
+{
+    if(simulation->nOutputs == 0) {
+        return true;
+    }
+    double *values = simulation->results+row*simulation->nOutputs;
+    if(simulation->fmiVersion == fmiVersion2) {
+        return fmi2_getReal(simulation->fmi2Instance, simulation->outputRefs, simulation->nOutputs, values) <= fmi2Warning;
+    }
+    return fmi3_getFloat64(simulation->fmi3Instance, simulation->outputRefs, simulation->nOutputs, values, simulation->nOutputs) <= fmi3Warning;
+}
+
+//! @brief Marks the rows from the first one that was not reached as missing
+static void fillMissingRows(simulation_t *simulation, size_t firstRow)
+{
+    for(size_t i=firstRow*simulation->nOutputs; i<simulation->nTimes*simulation->nOutputs; ++i) {
+        simulation->results[i] = NAN;
+    }
+}
+
+//! @brief Takes one communication step per grid interval
+static bool simulateCoSimulation(simulation_t *simulation, const double *times)
+{
+    if(!setInputs(simulation, times[0]) || !getOutputs(simulation, 0)) {
+        fmi4c_printMessage("Failed to set inputs or get outputs");
+        return false;
+    }
+    for(size_t k=1; k<simulation->nTimes; ++k) {
+        if(!setInputs(simulation, times[k-1])) {
+            fmi4c_printMessage("Failed to set inputs");
+            return false;
+        }
+        bool terminateSimulation = false;
+        if(simulation->fmiVersion == fmiVersion2) {
+            fmi2Status status = fmi2_doStep(simulation->fmi2Instance, times[k-1], times[k]-times[k-1], fmi2True);
+            if(status == fmi2Discard) {
+                // The FMU could not complete the step, and can not continue
+                fillMissingRows(simulation, k);
+                return true;
+            }
+            if(status > fmi2Warning) {
+                fmi4c_printMessage("Co-simulation step failed");
+                return false;
+            }
+        }
+        else {
+            fmi3Boolean eventEncountered, terminate = fmi3False, earlyReturn;
+            fmi3Float64 lastSuccessfulTime;
+            fmi3Status status = fmi3_doStep(simulation->fmi3Instance, times[k-1], times[k]-times[k-1], fmi3True,
+                                            &eventEncountered, &terminate, &earlyReturn, &lastSuccessfulTime);
+            if(status == fmi3Discard) {
+                // The FMU only completed the step up to lastSuccessfulTime, and can not continue
+                fillMissingRows(simulation, k);
+                return true;
+            }
+            if(status > fmi3Warning) {
+                fmi4c_printMessage("Co-simulation step failed");
+                return false;
+            }
+            terminateSimulation = terminate;
+        }
+        if(!getOutputs(simulation, k)) {
+            fmi4c_printMessage("Failed to get outputs");
+            return false;
+        }
+        if(terminateSimulation) {
+            fillMissingRows(simulation, k+1);
+            return true;
+        }
+    }
+    return true;
+}
+
+//! @brief Integrates with the built-in solver, stopping at every grid time and event
+static bool simulateModelExchange(simulation_t *simulation, const double *times, fmi4cSolverMethod solverMethod)
+{
+    fmuHandle *fmu;
+    size_t nStates = 0;
+    size_t nEventIndicators = 0;
+    fmi4cSolver *solver;
+    if(simulation->fmiVersion == fmiVersion2) {
+        fmu = simulation->fmi2Instance->fmu;
+        nStates = (size_t)fmi2_getNumberOfContinuousStates(fmu);
+        nEventIndicators = (size_t)fmi2_getNumberOfEventIndicators(fmu);
+        solver = fmi4c_createSolverFmi2(simulation->fmi2Instance, nStates, solverMethod);
+    }
+    else {
+        fmu = simulation->fmi3Instance->fmu;
+        if(fmi3_getNumberOfContinuousStates(simulation->fmi3Instance, &nStates) > fmi3Warning ||
+           fmi3_getNumberOfEventIndicators(simulation->fmi3Instance, &nEventIndicators) > fmi3Warning) {
+            fmi4c_printMessage("Failed to get number of continuous states and event indicators");
+            return false;
+        }
+        solver = fmi4c_createSolverFmi3(simulation->fmi3Instance, nStates, solverMethod);
+    }
+    if(solver == NULL || !fmi4c_setSolverNumberOfEventIndicators(solver, nEventIndicators)) {
+        fmi4c_freeSolver(solver);
+        return false;
+    }
+
+    // Fixed step methods step directly to the grid times, inputs are only updated between solver calls
+    fmi4c_setSolverStepSize(solver, 0, 0, 0);
+    if(simulation->fmiVersion == fmiVersion2 && fmi2_defaultToleranceDefined(fmu)) {
+        fmi4c_setSolverTolerance(solver, fmi2_getDefaultTolerance(fmu), fmi2_getDefaultTolerance(fmu));
+    }
+    else if(simulation->fmiVersion == fmiVersion3 && fmi3_defaultToleranceDefined(fmu)) {
+        fmi4c_setSolverTolerance(solver, fmi3_getDefaultTolerance(fmu), fmi3_getDefaultTolerance(fmu));
+    }
+    fmi4c_setSolverStopTime(solver, times[simulation->nTimes-1]);
+    fmi4c_setSolverDenseOutput(solver, simulation->nInputs == 0);
+
+    // Initial event iteration, which also initializes the solver
+    bool ok = setInputs(simulation, times[0]);
+    fmi4cSolverStatus status = ok ? fmi4c_handleSolverEvent(solver, times[0]) : fmi4cSolverError;
+    ok = ok && status != fmi4cSolverError && getOutputs(simulation, 0);
+    bool terminateSimulation = (status == fmi4cSolverTerminate);
+    bool eventPending = false;
+    double time = times[0];
+    size_t k = 1;
+    for(; ok && !terminateSimulation && k<simulation->nTimes; ++k) {
+        while(ok && !terminateSimulation && time < times[k]) {
+            ok = setInputs(simulation, time);
+            if(ok && eventPending) {
+                status = fmi4c_handleSolverEvent(solver, time);
+                eventPending = false;
+            }
+            else if(ok) {
+                status = fmi4c_integrateSolver(solver, times[k]);
+                eventPending = (status == fmi4cSolverEnterEventMode);
+                time = fmi4c_getSolverTime(solver);
+            }
+            ok = ok && status != fmi4cSolverError;
+            terminateSimulation = (status == fmi4cSolverTerminate);
+        }
+        if(ok && time >= times[k]) {
+            ok = getOutputs(simulation, k);
+        }
+        else {
+            break;
+        }
+    }
+    fmi4c_freeSolver(solver);
+    if(!ok) {
+        fmi4c_printMessage("Model exchange simulation failed");
+        return false;
+    }
+    fillMissingRows(simulation, k);
+    return true;
+}
+
+static bool simulate(simulation_t *simulation, bool coSimulation, fmi4cSolverMethod solverMethod, const double *times)
+{
+    if(simulation->nTimes == 0 || !isIncreasing(times, simulation->nTimes, true)) {
+        fmi4c_printMessage("Simulation time grid must be non-empty and strictly increasing");
+        return false;
+    }
+    if(simulation->nInputs > 0 && (simulation->nInputTimes == 0 || !isIncreasing(simulation->inputTimes, simulation->nInputTimes, false))) {
+        fmi4c_printMessage("Input table must have at least one row and non-decreasing times");
+        return false;
+    }
+
+    bool ok = true;
+    simulation->values = malloc(simulation->nInputs*sizeof(double)+1);
+    if(simulation->setDerivatives) {
+        simulation->derivatives = malloc(simulation->nInputs*sizeof(double)+1);
+        simulation->orders = malloc(simulation->nInputs*sizeof(fmi2Integer)+1);
+        for(size_t i=0; simulation->orders != NULL && i<simulation->nInputs; ++i) {
+            simulation->orders[i] = 1;
+        }
+        ok = (simulation->derivatives != NULL && simulation->orders != NULL);
+    }
+    ok = ok && simulation->values != NULL;
+    if(!ok) {
+        fmi4c_printMessage("Failed to allocate memory for inputs");
+    }
+    else if(coSimulation) {
+        ok = simulateCoSimulation(simulation, times);
+    }
+    else {
+        ok = simulateModelExchange(simulation, times, solverMethod);
+    }
+    free(simulation->values);
+    free(simulation->derivatives);
+    free(simulation->orders);
+    return ok;
+}
+
+//! @brief Simulates an initialized FMI 2 instance over a time grid in one call
+//! @param type Type the instance was instantiated as
+//! @param solverMethod Solver for model exchange, ignored for co-simulation
+//! @param times Grid of nTimes strictly increasing times, starting at the current time of the instance
+//! @param inputTimes Times of the nInputTimes rows of the input table (non-decreasing)
+//! @param inputValues Input table, nInputTimes rows of nInputs values
+//! @param results Output values, nTimes rows of nOutputs values
+//! @returns False on errors, true if the simulation completed or the FMU terminated it
+bool fmi4c_simulateFmi2(fmi2InstanceHandle *instance, fmi2Type type, fmi4cSolverMethod solverMethod,
+                        const double *times, size_t nTimes,
+                        const fmi2ValueReference *inputRefs, size_t nInputs,
+                        const double *inputTimes, const double *inputValues, size_t nInputTimes,
+                        const fmi2ValueReference *outputRefs, size_t nOutputs, double *results)
+{
+    simulation_t simulation;
+    memset(&simulation, 0, sizeof(simulation));
+    simulation.fmiVersion = fmiVersion2;
+    simulation.fmi2Instance = instance;
+    simulation.inputRefs = inputRefs;
+    simulation.nInputs = nInputs;
+    simulation.inputTimes = inputTimes;
+    simulation.inputValues = inputValues;
+    simulation.nInputTimes = nInputTimes;
+    simulation.outputRefs = outputRefs;
+    simulation.nOutputs = nOutputs;
+    simulation.results = results;
+    simulation.nTimes = nTimes;
+
+    simulation.setDerivatives = (type == fmi2CoSimulation && nInputs > 0 && fmi2cs_getCanInterpolateInputs(instance->fmu));
+    return simulate(&simulation, type == fmi2CoSimulation, solverMethod, times);
+}
+
+//! @brief Simulates an initialized FMI 3 instance over a time grid in one call
+//! Co-simulation instances must be instantiated without event mode and early return.
+//! @param type Type the instance was instantiated as (model exchange or co-simulation)
+//! @param solverMethod Solver for model exchange, ignored for co-simulation
+//! @param times Grid of nTimes strictly increasing times, starting at the current time of the instance
+//! @param inputTimes Times of the nInputTimes rows of the input table (non-decreasing)
+//! @param inputValues Input table, nInputTimes rows of nInputs values
+//! @param results Output values, nTimes rows of nOutputs values
+//! @returns False on errors, true if the simulation completed or the FMU terminated it
+bool fmi4c_simulateFmi3(fmi3InstanceHandle *instance, fmi3Type type, fmi4cSolverMethod solverMethod,
+                        const double *times, size_t nTimes,
+                        const fmi3ValueReference *inputRefs, size_t nInputs,
+                        const double *inputTimes, const double *inputValues, size_t nInputTimes,
+                        const fmi3ValueReference *outputRefs, size_t nOutputs, double *results)
+{
+    if(type == fmi3ScheduledExecution) {
+        fmi4c_printMessage("Scheduled execution instances can not be simulated over a time grid");
+        return false;
+    }
+    simulation_t simulation;
+    memset(&simulation, 0, sizeof(simulation));
+    simulation.fmiVersion = fmiVersion3;
+    simulation.fmi3Instance = instance;
+    simulation.inputRefs = inputRefs;
+    simulation.nInputs = nInputs;
+    simulation.inputTimes = inputTimes;
+    simulation.inputValues = inputValues;
+    simulation.nInputTimes = nInputTimes;
+    simulation.outputRefs = outputRefs;
+    simulation.nOutputs = nOutputs;
+    simulation.results = results;
+    simulation.nTimes = nTimes;
+    return simulate(&simulation, type == fmi3CoSimulation, solverMethod, times);
+}
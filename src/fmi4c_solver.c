@@ -0,0 +1,1270 @@
+#include "fmi4c_private.h"
+#define FMI4C_H_INTERNAL_INCLUDE
+#include "fmi4c.h"
+#include "fmi4c_solver.h"
+#include "fmi4c_common.h"
+#include "fmi4c_jacobian.h"
+
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#ifdef FMI4C_WITH_CVODE
+#include "cvode/cvode.h"
+#include "cvode/cvode_dense.h"
+#include "nvector/nvector_serial.h"
+#include "sundials/sundials_direct.h"
+#endif
+
+#define SOLVER_MAX_STAGES 7
+#define SOLVER_SAFETY_FACTOR 0.9
+#define SOLVER_MIN_FACTOR 0.2
+#define SOLVER_MAX_FACTOR 5.0
+#define SOLVER_MAX_EVENT_ITERATIONS 100
+
+//! @brief Butcher tableau of an explicit Runge-Kutta method
+typedef struct {
+    int nStages;
+    int errorOrder;     // Order of the embedded error estimate plus one, 0 for fixed step methods
+    bool fsal;          // Last stage is evaluated at the new solution (first same as last)
+    double c[SOLVER_MAX_STAGES];
+    double a[SOLVER_MAX_STAGES][SOLVER_MAX_STAGES];
+    double b[SOLVER_MAX_STAGES];
+    double e[SOLVER_MAX_STAGES];    // Difference between the two embedded solutions
+} rkTableau_t;
+
+static const rkTableau_t eulerTableau = {
+    1, 0, false,
+    { 0 },
+    { { 0 } },
+    { 1 },
+    { 0 }
+};
+
+static const rkTableau_t rungeKutta4Tableau = {
+    4, 0, false,
+    { 0, 0.5, 0.5, 1 },
+    { { 0 },
+      { 0.5 },
+      { 0, 0.5 },
+      { 0, 0, 1 } },
+    { 1.0/6.0, 1.0/3.0, 1.0/3.0, 1.0/6.0 },
+    { 0 }
+};
+
+static const rkTableau_t dormandPrinceTableau = {
+    7, 5, true,
+    { 0, 1.0/5.0, 3.0/10.0, 4.0/5.0, 8.0/9.0, 1, 1 },
+    { { 0 },
+      { 1.0/5.0 },
+      { 3.0/40.0, 9.0/40.0 },
+      { 44.0/45.0, -56.0/15.0, 32.0/9.0 },
+      { 19372.0/6561.0, -25360.0/2187.0, 64448.0/6561.0, -212.0/729.0 },
+      { 9017.0/3168.0, -355.0/33.0, 46732.0/5247.0, 49.0/176.0, -5103.0/18656.0 },
+      { 35.0/384.0, 0, 500.0/1113.0, 125.0/192.0, -2187.0/6784.0, 11.0/84.0 } },
+    { 35.0/384.0, 0, 500.0/1113.0, 125.0/192.0, -2187.0/6784.0, 11.0/84.0, 0 },
+    { 71.0/57600.0, 0, -71.0/16695.0, 71.0/1920.0, -17253.0/339200.0, 22.0/525.0, -1.0/40.0 }
+};
+
+//! @brief Coefficients for the continuous extension of Dormand-Prince (Hairer & Wanner)
+static const double dormandPrinceDense[SOLVER_MAX_STAGES] = {
+    -12715105075.0/11282082432.0, 0, 87487479700.0/32700410799.0, -10690763975.0/1880347072.0,
+    701980252875.0/199316789632.0, -1453857185.0/822651844.0, 69997945.0/29380423.0
+};
+
+static const rkTableau_t cashKarpTableau = {
+    6, 5, false,
+    { 0, 1.0/5.0, 3.0/10.0, 3.0/5.0, 1, 7.0/8.0 },
+    { { 0 },
+      { 1.0/5.0 },
+      { 3.0/40.0, 9.0/40.0 },
+      { 3.0/10.0, -9.0/10.0, 6.0/5.0 },
+      { -11.0/54.0, 5.0/2.0, -70.0/27.0, 35.0/27.0 },
+      { 1631.0/55296.0, 175.0/512.0, 575.0/13824.0, 44275.0/110592.0, 253.0/4096.0 } },
+    { 37.0/378.0, 0, 250.0/621.0, 125.0/594.0, 0, 512.0/1771.0 },
+    { 37.0/378.0 - 2825.0/27648.0, 0, 250.0/621.0 - 18575.0/48384.0, 125.0/594.0 - 13525.0/55296.0,
+      -277.0/14336.0, 512.0/1771.0 - 0.25 }
+};
+
+struct fmi4cSolver {
+    fmiVersion_t fmiVersion;
+    fmi2InstanceHandle *fmi2Instance;
+    fmi3InstanceHandle *fmi3Instance;
+    fmi4cSolverMethod method;
+    const rkTableau_t *tableau;
+    size_t n;
+
+    double relativeTolerance;
+    double absoluteTolerance;
+    double stepSize;        // Fixed step, or initial step for adaptive methods (0 = automatic)
+    double minStepSize;
+    double maxStepSize;
+    bool stopTimeDefined;
+    double stopTime;
+    bool denseOutput;
+
+    bool initialized;
+    bool derivativesValid;  // k[0] contains the derivatives at (time, states)
+    bool pendingEvent;      // An event was found beyond the last output time, at eventTime
+    double eventTime;
+    bool nextEventTimeDefined;
+    double nextEventTime;   // Next time event, as reported by the last event iteration
+    double time;            // Time of the last accepted internal step
+    double outputTime;      // Time the FMU was last left at
+    double previousTime;    // Start time of the last accepted internal step
+    double lastStepSize;
+    double nextStepSize;    // Step size proposed by the error controller
+
+    double *states;
+    double *newStates;
+    double *tempStates;
+    double *previousStates;
+    double *previousDerivatives;
+    double *nominals;
+    double *denseTerm;
+    double *k[SOLVER_MAX_STAGES];
+    double *workspace;
+
+    size_t nEventIndicators;
+    double *eventIndicators;            // At the end of the last accepted step
+    double *previousEventIndicators;    // At the start of the last accepted step
+    double *leftEventIndicators;        // Work vectors for event location
+    double *rightEventIndicators;
+    double *trialEventIndicators;
+    double *eventWorkspace;
+
+    fmi4cJacobian *jacobian;
+#ifdef FMI4C_WITH_CVODE
+    void *cvodeMemory;
+    bool cvodeInitialized;
+    FMIC_N_Vector cvodeStates;              // Wraps states
+    FMIC_N_Vector cvodeAbsoluteTolerances;  // Wraps nominals, scaled in place
+    FMIC_N_Vector cvodeDense;               // Wraps denseTerm
+#endif
+
+    fmi4cSolverStatistics statistics;
+};
+
+static bool setTime(fmi4cSolver *solver, double time)
+{
+    if(solver->fmiVersion == fmiVersion2) {
+        return fmi2_setTime(solver->fmi2Instance, time) <= fmi2Warning;
+    }
+    return fmi3_setTime(solver->fmi3Instance, time) <= fmi3Warning;
+}
+
+static bool setStates(fmi4cSolver *solver, const double *states)
+{
+    if(solver->fmiVersion == fmiVersion2) {
+        return fmi2_setContinuousStates(solver->fmi2Instance, states, solver->n) <= fmi2Warning;
+    }
+    return fmi3_setContinuousStates(solver->fmi3Instance, states, solver->n) <= fmi3Warning;
+}
+
+static bool getDerivatives(fmi4cSolver *solver, double *derivatives)
+{
+    if(solver->fmiVersion == fmiVersion2) {
+        return fmi2_getDerivatives(solver->fmi2Instance, derivatives, solver->n) <= fmi2Warning;
+    }
+    return fmi3_getContinuousStateDerivatives(solver->fmi3Instance, derivatives, solver->n) <= fmi3Warning;
+}
+
+static bool completedIntegratorStep(fmi4cSolver *solver, bool *enterEventMode, bool *terminateSimulation)
+{
+    if(solver->fmiVersion == fmiVersion2) {
+        fmi2Boolean enter = fmi2False;
+        fmi2Boolean terminate = fmi2False;
+        bool ok = fmi2_completedIntegratorStep(solver->fmi2Instance, fmi2True, &enter, &terminate) <= fmi2Warning;
+        *enterEventMode = enter;
+        *terminateSimulation = terminate;
+        return ok;
+    }
+    fmi3Boolean enter = fmi3False;
+    fmi3Boolean terminate = fmi3False;
+    bool ok = fmi3_completedIntegratorStep(solver->fmi3Instance, fmi3True, &enter, &terminate) <= fmi3Warning;
+    *enterEventMode = enter;
+    *terminateSimulation = terminate;
+    return ok;
+}
+
+//! @brief Moves the FMU to the specified time and states
+static bool setTimeAndStates(fmi4cSolver *solver, double time, const double *states)
+{
+    if(!setTime(solver, time) || !setStates(solver, states)) {
+        fmi4c_printMessage("Solver failed to set time and continuous states");
+        return false;
+    }
+    return true;
+}
+
+//! @brief Evaluates the state derivatives at the specified time and states
+static bool evaluate(fmi4cSolver *solver, double time, const double *states, double *derivatives)
+{
+    ++solver->statistics.nDerivativeEvaluations;
+    if(!setTimeAndStates(solver, time, states)) {
+        return false;
+    }
+    if(!getDerivatives(solver, derivatives)) {
+        fmi4c_printMessage("Solver failed to get state derivatives");
+        return false;
+    }
+    return true;
+}
+
+//! @brief Weighted root-mean-square norm, weights are based on tolerances and state nominals
+static double weightedNorm(fmi4cSolver *solver, const double *v, const double *y1, const double *y2)
+{
+    double sum = 0;
+    for(size_t i=0; i<solver->n; ++i) {
+        double magnitude = fabs(y1[i]);
+        if(y2 != NULL && fabs(y2[i]) > magnitude) {
+            magnitude = fabs(y2[i]);
+        }
+        double scale = solver->absoluteTolerance*solver->nominals[i] + solver->relativeTolerance*magnitude;
+        double r = v[i]/scale;
+        sum += r*r;
+    }
+    return solver->n > 0 ? sqrt(sum/(double)solver->n) : 0;
+}
+
+//! @brief Estimates an initial step size for adaptive methods (Hairer, Norsett & Wanner)
+//! Requires valid derivatives at the current point and uses one additional derivative evaluation.
+static bool initialStepSize(fmi4cSolver *solver, double *h)
+{
+    double d0 = weightedNorm(solver, solver->states, solver->states, NULL);
+    double d1 = weightedNorm(solver, solver->k[0], solver->states, NULL);
+    double h0 = (d0 < 1e-5 || d1 < 1e-5) ? 1e-6 : 0.01*d0/d1;
+    if(solver->maxStepSize > 0 && h0 > solver->maxStepSize) {
+        h0 = solver->maxStepSize;
+    }
+
+    for(size_t i=0; i<solver->n; ++i) {
+        solver->tempStates[i] = solver->states[i] + h0*solver->k[0][i];
+    }
+    if(!evaluate(solver, solver->time+h0, solver->tempStates, solver->k[1])) {
+        return false;
+    }
+    for(size_t i=0; i<solver->n; ++i) {
+        solver->k[1][i] -= solver->k[0][i];
+    }
+    double d2 = weightedNorm(solver, solver->k[1], solver->states, NULL)/h0;
+
+    double dmax = d1 > d2 ? d1 : d2;
+    double h1;
+    if(dmax <= 1e-15) {
+        h1 = h0*1e-3 > 1e-6 ? h0*1e-3 : 1e-6;
+    }
+    else {
+        h1 = pow(0.01/dmax, 1.0/solver->tableau->errorOrder);
+    }
+    *h = 100*h0 < h1 ? 100*h0 : h1;
+    if(solver->maxStepSize > 0 && *h > solver->maxStepSize) {
+        *h = solver->maxStepSize;
+    }
+    return true;
+}
+
+//! @brief Takes one Runge-Kutta step of size h from the current point into newStates
+//! @param error Weighted norm of the local error estimate (only for adaptive methods)
+static bool takeStep(fmi4cSolver *solver, double h, double *error)
+{
+    const rkTableau_t *tab = solver->tableau;
+    size_t n = solver->n;
+
+    for(int s=1; s<tab->nStages; ++s) {
+        double *target = (tab->fsal && s == tab->nStages-1) ? solver->newStates : solver->tempStates;
+        for(size_t i=0; i<n; ++i) {
+            double sum = 0;
+            for(int j=0; j<s; ++j) {
+                sum += tab->a[s][j]*solver->k[j][i];
+            }
+            target[i] = solver->states[i] + h*sum;
+        }
+        if(!evaluate(solver, solver->time+tab->c[s]*h, target, solver->k[s])) {
+            return false;
+        }
+    }
+
+    if(!tab->fsal) {
+        for(size_t i=0; i<n; ++i) {
+            double sum = 0;
+            for(int j=0; j<tab->nStages; ++j) {
+                sum += tab->b[j]*solver->k[j][i];
+            }
+            solver->newStates[i] = solver->states[i] + h*sum;
+        }
+    }
+
+    *error = 0;
+    if(tab->errorOrder > 0) {
+        for(size_t i=0; i<n; ++i) {
+            double sum = 0;
+            for(int j=0; j<tab->nStages; ++j) {
+                sum += tab->e[j]*solver->k[j][i];
+            }
+            solver->tempStates[i] = h*sum;
+        }
+        *error = weightedNorm(solver, solver->tempStates, solver->states, solver->newStates);
+    }
+    return true;
+}
+
+//! @brief Accepts the step in newStates and leaves the FMU at the new point
+//! @param evaluateDerivatives Derivatives at the new point are needed before the next call returns
+static bool acceptStep(fmi4cSolver *solver, double h, double newTime, bool evaluateDerivatives)
+{
+    const rkTableau_t *tab = solver->tableau;
+    size_t n = solver->n;
+
+    if(solver->method == fmi4cSolverDormandPrince) {
+        for(size_t i=0; i<n; ++i) {
+            double sum = 0;
+            for(int j=0; j<tab->nStages; ++j) {
+                sum += dormandPrinceDense[j]*solver->k[j][i];
+            }
+            solver->denseTerm[i] = h*sum;
+        }
+    }
+
+    double *swap = solver->previousStates;
+    solver->previousStates = solver->states;
+    solver->states = solver->newStates;
+    solver->newStates = swap;
+
+    swap = solver->previousDerivatives;
+    solver->previousDerivatives = solver->k[0];
+    if(tab->fsal) {
+        solver->k[0] = solver->k[tab->nStages-1];
+        solver->k[tab->nStages-1] = swap;
+    }
+    else {
+        solver->k[0] = swap;
+    }
+
+    solver->previousTime = solver->time;
+    solver->lastStepSize = h;
+    solver->time = newTime;
+    ++solver->statistics.nSteps;
+
+    if(tab->fsal) {
+        // The FMU was left at the new point by the last stage evaluation
+        solver->derivativesValid = true;
+        return true;
+    }
+    if(evaluateDerivatives) {
+        solver->derivativesValid = evaluate(solver, solver->time, solver->states, solver->k[0]);
+        return solver->derivativesValid;
+    }
+    solver->derivativesValid = false;
+    return setTimeAndStates(solver, solver->time, solver->states);
+}
+
+//! @brief Interpolates the states within the last accepted step
+static bool interpolate(fmi4cSolver *solver, double time, double *states)
+{
+    size_t n = solver->n;
+    if(solver->lastStepSize <= 0 || time >= solver->time) {
+        memcpy(states, solver->states, n*sizeof(double));
+        return true;
+    }
+
+#ifdef FMI4C_WITH_CVODE
+    if(solver->method == fmi4cSolverCVode) {
+        if(CVodeGetDky(solver->cvodeMemory, time, 0, solver->cvodeDense) != CV_SUCCESS) {
+            return false;
+        }
+        memcpy(states, solver->denseTerm, n*sizeof(double));
+        return true;
+    }
+#endif
+
+    double h = solver->lastStepSize;
+    double theta = (time-solver->previousTime)/h;
+    const double *y0 = solver->previousStates;
+    const double *y1 = solver->states;
+
+    if(solver->method == fmi4cSolverEuler) {
+        for(size_t i=0; i<n; ++i) {
+            states[i] = y0[i] + theta*(y1[i]-y0[i]);
+        }
+        return true;
+    }
+
+    // Remaining methods need the derivatives at the end of the step
+    if(!solver->derivativesValid) {
+        if(!evaluate(solver, solver->time, solver->states, solver->k[0])) {
+            return false;
+        }
+        solver->derivativesValid = true;
+    }
+    const double *f0 = solver->previousDerivatives;
+    const double *f1 = solver->k[0];
+
+    if(solver->method == fmi4cSolverDormandPrince) {
+        double theta1 = 1-theta;
+        for(size_t i=0; i<n; ++i) {
+            double ydiff = y1[i]-y0[i];
+            double bspl = h*f0[i]-ydiff;
+            states[i] = y0[i] + theta*(ydiff + theta1*(bspl + theta*(ydiff-h*f1[i]-bspl + theta1*solver->denseTerm[i])));
+        }
+    }
+    else {
+        // Cubic Hermite interpolation
+        for(size_t i=0; i<n; ++i) {
+            double ydiff = y1[i]-y0[i];
+            states[i] = y0[i] + theta*ydiff + theta*(theta-1)*((1-2*theta)*ydiff + (theta-1)*h*f0[i] + theta*h*f1[i]);
+        }
+    }
+    return true;
+}
+
+static bool getEventIndicators(fmi4cSolver *solver, double *indicators)
+{
+    bool ok;
+    if(solver->fmiVersion == fmiVersion2) {
+        ok = fmi2_getEventIndicators(solver->fmi2Instance, indicators, solver->nEventIndicators) <= fmi2Warning;
+    }
+    else {
+        ok = fmi3_getEventIndicators(solver->fmi3Instance, indicators, solver->nEventIndicators) <= fmi3Warning;
+    }
+    if(!ok) {
+        fmi4c_printMessage("Solver failed to get event indicators");
+    }
+    return ok;
+}
+
+//! @brief Checks if any event indicator changed sign
+static bool eventIndicatorsCrossed(fmi4cSolver *solver, const double *before, const double *after)
+{
+    for(size_t i=0; i<solver->nEventIndicators; ++i) {
+        if((after[i] > 0) != (before[i] > 0)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+//! @brief Moves the FMU to a time within the last accepted step and evaluates the event indicators
+static bool evaluateEventIndicators(fmi4cSolver *solver, double time, double *indicators)
+{
+    return interpolate(solver, time, solver->tempStates) &&
+           setTimeAndStates(solver, time, solver->tempStates) &&
+           getEventIndicators(solver, indicators);
+}
+
+//! @brief Checks the event indicators at the end of the last accepted step and locates the first zero crossing
+//! The crossing is bracketed with the Illinois method, using the dense output of the step, and eventTime
+//! is set to the right end of the final bracket. On return the FMU is left at the end of the step, or at
+//! eventTime if an event was found.
+//! @param eventFound Set to true if any event indicator changed sign within the step
+static bool detectStateEvent(fmi4cSolver *solver, bool *eventFound)
+{
+    *eventFound = false;
+    if(solver->nEventIndicators == 0) {
+        return true;
+    }
+
+    double *swap = solver->previousEventIndicators;
+    solver->previousEventIndicators = solver->eventIndicators;
+    solver->eventIndicators = swap;
+    if(!getEventIndicators(solver, solver->eventIndicators)) {
+        return false;
+    }
+    if(!eventIndicatorsCrossed(solver, solver->previousEventIndicators, solver->eventIndicators)) {
+        return true;
+    }
+
+    size_t m = solver->nEventIndicators;
+    double *gl = solver->leftEventIndicators;
+    double *gr = solver->rightEventIndicators;
+    double *gt = solver->trialEventIndicators;
+    memcpy(gl, solver->previousEventIndicators, m*sizeof(double));
+    memcpy(gr, solver->eventIndicators, m*sizeof(double));
+    double tl = solver->previousTime;
+    double tr = solver->time;
+    double tolerance = 100*DBL_EPSILON*(fabs(tr)+fabs(tr-tl));
+    double alpha = 1;
+    int lastSide = 0;
+
+    for(int iter=0; iter<SOLVER_MAX_EVENT_ITERATIONS && tr-tl > tolerance; ++iter) {
+        // Secant step on the indicator with the earliest estimated crossing
+        size_t imax = 0;
+        double maxFraction = -1;
+        for(size_t i=0; i<m; ++i) {
+            if((gr[i] > 0) != (gl[i] > 0)) {
+                double fraction = fabs(gr[i])/fabs(gr[i]-gl[i]);
+                if(fraction > maxFraction) {
+                    maxFraction = fraction;
+                    imax = i;
+                }
+            }
+        }
+        double denominator = gr[imax]-alpha*gl[imax];
+        double t = tr - gr[imax]*(tr-tl)/denominator;
+        if(!(t > tl && t < tr)) {
+            t = 0.5*(tl+tr);
+        }
+        // Keep the trial point strictly inside the bracket
+        if(t-tl < 0.5*tolerance) {
+            t = tl+0.5*tolerance;
+        }
+        if(tr-t < 0.5*tolerance) {
+            t = tr-0.5*tolerance;
+        }
+
+        if(!evaluateEventIndicators(solver, t, gt)) {
+            return false;
+        }
+        // Illinois modification: scale the retained end point when the same side is kept twice
+        if(eventIndicatorsCrossed(solver, gl, gt)) {
+            tr = t;
+            memcpy(gr, gt, m*sizeof(double));
+            alpha = (lastSide == 1) ? 0.5*alpha : 1;
+            lastSide = 1;
+        }
+        else {
+            tl = t;
+            memcpy(gl, gt, m*sizeof(double));
+            alpha = (lastSide == 2) ? 2*alpha : 1;
+            lastSide = 2;
+        }
+    }
+
+    ++solver->statistics.nStateEvents;
+    solver->eventTime = tr;
+    *eventFound = true;
+    return interpolate(solver, tr, solver->tempStates) && setTimeAndStates(solver, tr, solver->tempStates);
+}
+
+//! @brief Handles events and termination requests at the end of an accepted step
+//! @returns fmi4cSolverOK to continue integrating, otherwise the status to return
+static fmi4cSolverStatus completeStep(fmi4cSolver *solver, double nextTime)
+{
+    bool stateEvent = false;
+    if(!detectStateEvent(solver, &stateEvent)) {
+        return fmi4cSolverError;
+    }
+
+    bool enterEventMode = false;
+    bool terminateSimulation = false;
+    if(!completedIntegratorStep(solver, &enterEventMode, &terminateSimulation)) {
+        fmi4c_printMessage("Solver failed to complete integrator step");
+        return fmi4cSolverError;
+    }
+    double eventTime = stateEvent ? solver->eventTime : solver->time;
+    if(terminateSimulation) {
+        solver->outputTime = eventTime;
+        return fmi4cSolverTerminate;
+    }
+    if(stateEvent || enterEventMode) {
+        if(eventTime <= nextTime) {
+            solver->outputTime = eventTime;
+            return fmi4cSolverEnterEventMode;
+        }
+        // Report the event when the caller reaches its time
+        solver->eventTime = eventTime;
+        solver->pendingEvent = true;
+    }
+    return fmi4cSolverOK;
+}
+
+#ifdef FMI4C_WITH_CVODE
+static int cvodeRhs(realtype t, FMIC_N_Vector y, FMIC_N_Vector ydot, void *userData)
+{
+    fmi4cSolver *solver = (fmi4cSolver*)userData;
+    return evaluate(solver, t, NV_DATA_S(y), NV_DATA_S(ydot)) ? 0 : -1;
+}
+
+static int cvodeJacobian(long int N, realtype t, FMIC_N_Vector y, FMIC_N_Vector fy, DlsMat J, void *userData,
+                         FMIC_N_Vector tmp1, FMIC_N_Vector tmp2, FMIC_N_Vector tmp3)
+{
+    UNUSED(N)
+    UNUSED(tmp1)
+    UNUSED(tmp2)
+    UNUSED(tmp3)
+    fmi4cSolver *solver = (fmi4cSolver*)userData;
+    ++solver->statistics.nJacobianEvaluations;
+    if(!setTimeAndStates(solver, t, NV_DATA_S(y)) ||
+       !fmi4c_evaluateJacobian(solver->jacobian, NV_DATA_S(y), NV_DATA_S(fy), solver->nominals)) {
+        return -1;
+    }
+
+    const size_t *rowPointers = fmi4c_getJacobianRowPointers(solver->jacobian);
+    const size_t *columnIndices = fmi4c_getJacobianColumnIndices(solver->jacobian);
+    const double *values = fmi4c_getJacobianValues(solver->jacobian);
+    SetToZero(J);
+    for(size_t i=0; i<solver->n; ++i) {
+        for(size_t k=rowPointers[i]; k<rowPointers[i+1]; ++k) {
+            DENSE_ELEM(J, (long int)i, (long int)columnIndices[k]) = values[k];
+        }
+    }
+    return 0;
+}
+
+static void cvodeErrorHandler(int errorCode, const char *module, const char *function, char *msg, void *userData)
+{
+    UNUSED(errorCode)
+    UNUSED(module)
+    UNUSED(userData)
+    char message[1024];
+    snprintf(message, sizeof(message), "CVODE (%s): %s", function, msg);
+    fmi4c_printMessage(message);
+}
+
+static bool createCVode(fmi4cSolver *solver)
+{
+    long int n = (long int)solver->n;
+    solver->cvodeStates = FMIC_N_VMake_Serial(n, solver->states);
+    solver->cvodeAbsoluteTolerances = FMIC_N_VMake_Serial(n, solver->nominals);
+    solver->cvodeDense = FMIC_N_VMake_Serial(n, solver->denseTerm);
+    solver->cvodeMemory = CVodeCreate(CV_BDF, CV_NEWTON);
+    if(solver->cvodeStates == NULL || solver->cvodeAbsoluteTolerances == NULL ||
+       solver->cvodeDense == NULL || solver->cvodeMemory == NULL) {
+        return false;
+    }
+    CVodeSetErrHandlerFn(solver->cvodeMemory, cvodeErrorHandler, solver);
+    CVodeSetUserData(solver->cvodeMemory, solver);
+
+    // Sparse Jacobian from ModelStructure, falls back on the CVODE internal approximation if not available
+    if(solver->fmiVersion == fmiVersion2) {
+        solver->jacobian = fmi4c_createStateJacobianFmi2(solver->fmi2Instance, solver->n);
+    }
+    else {
+        solver->jacobian = fmi4c_createStateJacobianFmi3(solver->fmi3Instance, solver->n);
+    }
+    return true;
+}
+
+static void freeCVode(fmi4cSolver *solver)
+{
+    if(solver->cvodeMemory != NULL) {
+        CVodeFree(&solver->cvodeMemory);
+    }
+    if(solver->cvodeStates != NULL) {
+        FMIC_N_VDestroy_Serial(solver->cvodeStates);
+    }
+    if(solver->cvodeAbsoluteTolerances != NULL) {
+        FMIC_N_VDestroy_Serial(solver->cvodeAbsoluteTolerances);
+    }
+    if(solver->cvodeDense != NULL) {
+        FMIC_N_VDestroy_Serial(solver->cvodeDense);
+    }
+    fmi4c_freeJacobian(solver->jacobian);
+}
+
+//! @brief (Re)initializes CVODE from the current states, and updates tolerances and step size limits
+static bool initializeCVode(fmi4cSolver *solver, double time)
+{
+    void *mem = solver->cvodeMemory;
+    int flag;
+    if(!solver->cvodeInitialized) {
+        flag = CVodeInit(mem, cvodeRhs, time, solver->cvodeStates);
+        if(flag == CV_SUCCESS) {
+            flag = CVDense(mem, (long int)solver->n);
+        }
+        if(flag == CV_SUCCESS && solver->jacobian != NULL) {
+            flag = CVDlsSetDenseJacFn(mem, cvodeJacobian);
+        }
+        solver->cvodeInitialized = (flag == CV_SUCCESS);
+    }
+    else {
+        flag = CVodeReInit(mem, time, solver->cvodeStates);
+    }
+    if(flag != CV_SUCCESS) {
+        return false;
+    }
+
+    // Absolute tolerances are scaled with the nominal values (CVODE keeps a copy)
+    for(size_t i=0; i<solver->n; ++i) {
+        solver->tempStates[i] = solver->nominals[i];
+        solver->nominals[i] *= solver->absoluteTolerance;
+    }
+    flag = CVodeSVtolerances(mem, solver->relativeTolerance, solver->cvodeAbsoluteTolerances);
+    memcpy(solver->nominals, solver->tempStates, solver->n*sizeof(double));
+    if(flag != CV_SUCCESS) {
+        return false;
+    }
+
+    CVodeSetMaxNumSteps(mem, 100000);
+    CVodeSetMinStep(mem, solver->minStepSize);
+    CVodeSetMaxStep(mem, solver->maxStepSize);
+    CVodeSetInitStep(mem, solver->stepSize);
+    return true;
+}
+
+//! @brief Takes internal CVODE steps until nextTime is reached or passed, or an event occurs
+static fmi4cSolverStatus integrateCVode(fmi4cSolver *solver, double nextTime, double endTime)
+{
+    void *mem = solver->cvodeMemory;
+
+    // Never pass the end time (the stop time is cleared by CVODE when reached)
+    if(endTime < DBL_MAX) {
+        CVodeSetStopTime(mem, endTime);
+    }
+
+    while(solver->time < nextTime) {
+        realtype time;
+        int flag = CVode(mem, nextTime, solver->cvodeStates, &time, CV_ONE_STEP);
+        if(flag < 0) {
+            return fmi4cSolverError;
+        }
+        realtype lastStepSize = 0;
+        CVodeGetLastStep(mem, &lastStepSize);
+        solver->previousTime = time-lastStepSize;
+        solver->lastStepSize = lastStepSize;
+        solver->time = time;
+        ++solver->statistics.nSteps;
+
+        if(!setTimeAndStates(solver, solver->time, solver->states)) {
+            return fmi4cSolverError;
+        }
+        fmi4cSolverStatus status = completeStep(solver, nextTime);
+        if(status != fmi4cSolverOK) {
+            return status;
+        }
+    }
+    return fmi4cSolverOK;
+}
+#endif
+
+static fmi4cSolver *createSolver(fmiVersion_t fmiVersion, fmi2InstanceHandle *fmi2Instance, fmi3InstanceHandle *fmi3Instance,
+                                 size_t nStates, fmi4cSolverMethod method)
+{
+    const rkTableau_t *tableau = NULL;
+    switch(method) {
+    case fmi4cSolverEuler:
+        tableau = &eulerTableau;
+        break;
+    case fmi4cSolverRungeKutta4:
+        tableau = &rungeKutta4Tableau;
+        break;
+    case fmi4cSolverDormandPrince:
+        tableau = &dormandPrinceTableau;
+        break;
+    case fmi4cSolverCashKarp:
+        tableau = &cashKarpTableau;
+        break;
+    case fmi4cSolverCVode:
+#ifndef FMI4C_WITH_CVODE
+        fmi4c_printMessage("CVODE solver is not available (fmi4c was built without FMI4C_WITH_CVODE)");
+        return NULL;
+#endif
+        break;
+    default:
+        fmi4c_printMessage("Unknown solver method");
+        return NULL;
+    }
+
+    fmi4cSolver *solver = calloc(1, sizeof(fmi4cSolver));
+    if(solver == NULL) {
+        return NULL;
+    }
+
+    // All work vectors share one allocation
+    size_t nVectors = 7+SOLVER_MAX_STAGES;
+    size_t n = nStates > 0 ? nStates : 1;
+    solver->workspace = calloc(nVectors*n, sizeof(double));
+    if(solver->workspace == NULL) {
+        free(solver);
+        return NULL;
+    }
+    double *ptr = solver->workspace;
+    solver->states = ptr; ptr += n;
+    solver->newStates = ptr; ptr += n;
+    solver->tempStates = ptr; ptr += n;
+    solver->previousStates = ptr; ptr += n;
+    solver->previousDerivatives = ptr; ptr += n;
+    solver->nominals = ptr; ptr += n;
+    solver->denseTerm = ptr; ptr += n;
+    for(int i=0; i<SOLVER_MAX_STAGES; ++i) {
+        solver->k[i] = ptr; ptr += n;
+    }
+
+    solver->fmiVersion = fmiVersion;
+    solver->fmi2Instance = fmi2Instance;
+    solver->fmi3Instance = fmi3Instance;
+    solver->method = method;
+    solver->tableau = tableau;
+    solver->n = nStates;
+    solver->relativeTolerance = 1e-4;
+    solver->absoluteTolerance = 1e-6;
+
+#ifdef FMI4C_WITH_CVODE
+    if(method == fmi4cSolverCVode && !createCVode(solver)) {
+        fmi4c_printMessage("Failed to create CVODE solver");
+        fmi4c_freeSolver(solver);
+        return NULL;
+    }
+#endif
+    return solver;
+}
+
+//! @brief Creates a solver for an FMI 2 model exchange instance
+//! @param instance Instance to integrate
+//! @param nStates Number of continuous states
+//! @param method Integration method
+//! @returns Solver handle, or NULL on failure
+fmi4cSolver *fmi4c_createSolverFmi2(fmi2InstanceHandle *instance, size_t nStates, fmi4cSolverMethod method)
+{
+    return createSolver(fmiVersion2, instance, NULL, nStates, method);
+}
+
+//! @brief Creates a solver for an FMI 3 model exchange instance
+//! @param instance Instance to integrate
+//! @param nStates Number of continuous states
+//! @param method Integration method
+//! @returns Solver handle, or NULL on failure
+fmi4cSolver *fmi4c_createSolverFmi3(fmi3InstanceHandle *instance, size_t nStates, fmi4cSolverMethod method)
+{
+    return createSolver(fmiVersion3, NULL, instance, nStates, method);
+}
+
+void fmi4c_freeSolver(fmi4cSolver *solver)
+{
+    if(solver == NULL) {
+        return;
+    }
+#ifdef FMI4C_WITH_CVODE
+    freeCVode(solver);
+#endif
+    free(solver->eventWorkspace);
+    free(solver->workspace);
+    free(solver);
+}
+
+//! @brief Looks up a solver method from its short name ("euler", "rk4", "dopri5", "cashkarp" or "cvode")
+bool fmi4c_getSolverMethodByName(const char *name, fmi4cSolverMethod *method)
+{
+    for(int i=fmi4cSolverEuler; i<=fmi4cSolverCVode; ++i) {
+        if(!strcmp(name, fmi4c_getSolverMethodName((fmi4cSolverMethod)i))) {
+            *method = (fmi4cSolverMethod)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *fmi4c_getSolverMethodName(fmi4cSolverMethod method)
+{
+    switch(method) {
+    case fmi4cSolverEuler:
+        return "euler";
+    case fmi4cSolverRungeKutta4:
+        return "rk4";
+    case fmi4cSolverDormandPrince:
+        return "dopri5";
+    case fmi4cSolverCashKarp:
+        return "cashkarp";
+    case fmi4cSolverCVode:
+        return "cvode";
+    }
+    return "unknown";
+}
+
+//! @brief Sets error tolerances for adaptive methods
+//! The absolute tolerance is scaled with the nominal value of each state.
+void fmi4c_setSolverTolerance(fmi4cSolver *solver, double relativeTolerance, double absoluteTolerance)
+{
+    solver->relativeTolerance = relativeTolerance;
+    solver->absoluteTolerance = absoluteTolerance;
+}
+
+//! @brief Sets step size limits
+//! @param stepSize Step size for fixed step methods (0 = step directly to the requested time), initial step size for adaptive methods (0 = automatic)
+//! @param minStepSize Smallest allowed step size for adaptive methods (0 = no limit)
+//! @param maxStepSize Largest allowed step size for adaptive methods (0 = no limit)
+void fmi4c_setSolverStepSize(fmi4cSolver *solver, double stepSize, double minStepSize, double maxStepSize)
+{
+    solver->stepSize = stepSize;
+    solver->minStepSize = minStepSize;
+    solver->maxStepSize = maxStepSize;
+}
+
+//! @brief Sets a time the solver will never integrate beyond, not even in dense output mode
+void fmi4c_setSolverStopTime(fmi4cSolver *solver, double stopTime)
+{
+    solver->stopTimeDefined = true;
+    solver->stopTime = stopTime;
+}
+
+//! @brief Enables or disables dense output mode for adaptive methods
+//! In dense output mode, internal steps may pass the requested time and the states at the requested
+//! time are interpolated. This is much cheaper when output is requested often, but inputs changed
+//! between calls to fmi4c_integrateSolver() only take effect at the next internal step.
+void fmi4c_setSolverDenseOutput(fmi4cSolver *solver, bool denseOutput)
+{
+    solver->denseOutput = denseOutput;
+}
+
+//! @brief Enables state event detection
+//! After each accepted step the event indicators are compared with those at the start of the step. If
+//! any indicator changed sign, the first crossing is located and fmi4c_integrateSolver() stops there.
+//! @param nEventIndicators Number of event indicators of the FMU
+//! @returns True on success
+bool fmi4c_setSolverNumberOfEventIndicators(fmi4cSolver *solver, size_t nEventIndicators)
+{
+    double *eventWorkspace = NULL;
+    if(nEventIndicators > 0) {
+        eventWorkspace = calloc(5*nEventIndicators, sizeof(double));
+        if(eventWorkspace == NULL) {
+            fmi4c_printMessage("Failed to allocate memory for event indicators");
+            return false;
+        }
+    }
+    free(solver->eventWorkspace);
+    solver->eventWorkspace = eventWorkspace;
+    solver->nEventIndicators = nEventIndicators;
+    solver->eventIndicators = eventWorkspace;
+    solver->previousEventIndicators = eventWorkspace+nEventIndicators;
+    solver->leftEventIndicators = eventWorkspace+2*nEventIndicators;
+    solver->rightEventIndicators = eventWorkspace+3*nEventIndicators;
+    solver->trialEventIndicators = eventWorkspace+4*nEventIndicators;
+    return true;
+}
+
+//! @brief Handles an event at the specified time and re-initializes the solver
+//! Enters event mode, iterates the discrete states until they are converged and returns to
+//! continuous-time mode. Before the solver has been initialized the instance is assumed to be in
+//! event mode already, as it is directly after initialization mode, so this function can also be used
+//! for the initial event iteration. The next time event reported by the FMU is remembered, and
+//! fmi4c_integrateSolver() stops there.
+//! @param time Current time of the FMU, normally fmi4c_getSolverTime()
+//! @returns fmi4cSolverOK, fmi4cSolverTerminate or fmi4cSolverError
+fmi4cSolverStatus fmi4c_handleSolverEvent(fmi4cSolver *solver, double time)
+{
+    bool terminateSimulation = false;
+    bool converged = false;
+    if(solver->fmiVersion == fmiVersion2) {
+        fmi2InstanceHandle *instance = solver->fmi2Instance;
+        if(solver->initialized && fmi2_enterEventMode(instance) > fmi2Warning) {
+            fmi4c_printMessage("Solver failed to enter event mode");
+            return fmi4cSolverError;
+        }
+        fmi2EventInfo eventInfo;
+        memset(&eventInfo, 0, sizeof(eventInfo));
+        for(int i=0; i<SOLVER_MAX_EVENT_ITERATIONS && !converged; ++i) {
+            // Outputs are reset in case the FMU does not set them all
+            eventInfo.newDiscreteStatesNeeded = fmi2False;
+            eventInfo.terminateSimulation = fmi2False;
+            if(fmi2_newDiscreteStates(instance, &eventInfo) > fmi2Warning) {
+                fmi4c_printMessage("Solver failed to update discrete states");
+                return fmi4cSolverError;
+            }
+            terminateSimulation = eventInfo.terminateSimulation;
+            converged = !eventInfo.newDiscreteStatesNeeded || terminateSimulation;
+        }
+        solver->nextEventTimeDefined = eventInfo.nextEventTimeDefined;
+        solver->nextEventTime = eventInfo.nextEventTime;
+        if(converged && !terminateSimulation && fmi2_enterContinuousTimeMode(instance) > fmi2Warning) {
+            fmi4c_printMessage("Solver failed to enter continuous-time mode");
+            return fmi4cSolverError;
+        }
+    }
+    else {
+        fmi3InstanceHandle *instance = solver->fmi3Instance;
+        if(solver->initialized && fmi3_enterEventMode(instance) > fmi3Warning) {
+            fmi4c_printMessage("Solver failed to enter event mode");
+            return fmi4cSolverError;
+        }
+        fmi3Boolean discreteStatesNeedUpdate;
+        fmi3Boolean terminate;
+        fmi3Boolean nominalsChanged;
+        fmi3Boolean valuesChanged;
+        fmi3Boolean nextEventTimeDefined = fmi3False;
+        fmi3Float64 nextEventTime = 0;
+        for(int i=0; i<SOLVER_MAX_EVENT_ITERATIONS && !converged; ++i) {
+            // Outputs are reset in case the FMU does not set them all
+            discreteStatesNeedUpdate = fmi3False;
+            terminate = fmi3False;
+            nominalsChanged = fmi3False;
+            valuesChanged = fmi3False;
+            if(fmi3_updateDiscreteStates(instance, &discreteStatesNeedUpdate, &terminate, &nominalsChanged,
+                                         &valuesChanged, &nextEventTimeDefined, &nextEventTime) > fmi3Warning) {
+                fmi4c_printMessage("Solver failed to update discrete states");
+                return fmi4cSolverError;
+            }
+            terminateSimulation = terminate;
+            converged = !discreteStatesNeedUpdate || terminateSimulation;
+        }
+        solver->nextEventTimeDefined = nextEventTimeDefined;
+        solver->nextEventTime = nextEventTime;
+        if(converged && !terminateSimulation && fmi3_enterContinuousTimeMode(instance) > fmi3Warning) {
+            fmi4c_printMessage("Solver failed to enter continuous-time mode");
+            return fmi4cSolverError;
+        }
+    }
+
+    if(!converged) {
+        fmi4c_printMessage("Event iteration did not converge");
+        return fmi4cSolverError;
+    }
+    if(terminateSimulation) {
+        solver->outputTime = time;
+        return fmi4cSolverTerminate;
+    }
+    return fmi4c_initializeSolver(solver, time) ? fmi4cSolverOK : fmi4cSolverError;
+}
+
+//! @brief (Re)initializes the solver from the current continuous states of the FMU
+//! Must be called before the first call to fmi4c_integrateSolver() and after each event, unless
+//! events are handled with fmi4c_handleSolverEvent().
+//! @param time Current time of the FMU
+//! @returns True on success
+bool fmi4c_initializeSolver(fmi4cSolver *solver, double time)
+{
+    bool ok;
+    if(solver->fmiVersion == fmiVersion2) {
+        ok = fmi2_getContinuousStates(solver->fmi2Instance, solver->states, solver->n) <= fmi2Warning &&
+             fmi2_getNominalsOfContinuousStates(solver->fmi2Instance, solver->nominals, solver->n) <= fmi2Warning;
+    }
+    else {
+        ok = fmi3_getContinuousStates(solver->fmi3Instance, solver->states, solver->n) <= fmi3Warning &&
+             fmi3_getNominalsOfContinuousStates(solver->fmi3Instance, solver->nominals, solver->n) <= fmi3Warning;
+    }
+    if(!ok) {
+        fmi4c_printMessage("Solver failed to get continuous states");
+        return false;
+    }
+    for(size_t i=0; i<solver->n; ++i) {
+        if(!(solver->nominals[i] > 0)) {
+            solver->nominals[i] = 1;
+        }
+    }
+
+    solver->time = time;
+    solver->outputTime = time;
+    solver->previousTime = time;
+    solver->lastStepSize = 0;
+    solver->nextStepSize = solver->stepSize;
+    solver->derivativesValid = false;
+    solver->pendingEvent = false;
+    if(solver->nEventIndicators > 0) {
+        if(!getEventIndicators(solver, solver->eventIndicators)) {
+            return false;
+        }
+        memcpy(solver->previousEventIndicators, solver->eventIndicators, solver->nEventIndicators*sizeof(double));
+    }
+#ifdef FMI4C_WITH_CVODE
+    if(solver->method == fmi4cSolverCVode && !initializeCVode(solver, time)) {
+        fmi4c_printMessage("Failed to initialize CVODE solver");
+        return false;
+    }
+#endif
+    solver->initialized = true;
+    return true;
+}
+
+//! @brief Takes Runge-Kutta steps until nextTime is reached or passed, or an event occurs
+static fmi4cSolverStatus integrateRungeKutta(fmi4cSolver *solver, double nextTime, double endTime)
+{
+    bool adaptive = (solver->tableau->errorOrder > 0);
+    bool dense = (adaptive && solver->denseOutput);
+    if(!dense) {
+        // Internal steps end at nextTime
+        endTime = nextTime;
+    }
+
+    while(solver->time < nextTime) {
+        if(!solver->derivativesValid) {
+            if(!evaluate(solver, solver->time, solver->states, solver->k[0])) {
+                return fmi4cSolverError;
+            }
+            solver->derivativesValid = true;
+        }
+
+        double h = solver->nextStepSize;
+        if(!adaptive && h <= 0) {
+            h = nextTime-solver->time;
+        }
+        else if(adaptive && h <= 0) {
+            if(!initialStepSize(solver, &h)) {
+                return fmi4cSolverError;
+            }
+        }
+        if(adaptive && solver->maxStepSize > 0 && h > solver->maxStepSize) {
+            h = solver->maxStepSize;
+        }
+
+        // Land exactly on the end time rather than leaving a tiny remainder
+        bool lastStep = false;
+        if(solver->time + h*(1+1e-8) >= endTime) {
+            h = endTime-solver->time;
+            lastStep = true;
+        }
+
+        double error = 0;
+        if(!takeStep(solver, h, &error)) {
+            return fmi4cSolverError;
+        }
+        bool rejected = false;
+        while(adaptive && error > 1) {
+            ++solver->statistics.nRejectedSteps;
+            rejected = true;
+            double factor = SOLVER_SAFETY_FACTOR*pow(error, -1.0/solver->tableau->errorOrder);
+            h *= factor > SOLVER_MIN_FACTOR ? factor : SOLVER_MIN_FACTOR;
+            lastStep = false;
+            if(h < solver->minStepSize || solver->time + h == solver->time) {
+                fmi4c_printMessage("Solver step size became too small");
+                return fmi4cSolverError;
+            }
+            if(!takeStep(solver, h, &error)) {
+                return fmi4cSolverError;
+            }
+        }
+
+        if(adaptive) {
+            double factor = error > 0 ? SOLVER_SAFETY_FACTOR*pow(error, -1.0/solver->tableau->errorOrder) : SOLVER_MAX_FACTOR;
+            double maxFactor = rejected ? 1.0 : SOLVER_MAX_FACTOR;
+            factor = factor < SOLVER_MIN_FACTOR ? SOLVER_MIN_FACTOR : factor;
+            factor = factor > maxFactor ? maxFactor : factor;
+            solver->nextStepSize = h*factor;
+        }
+
+        double newTime = lastStep ? endTime : solver->time+h;
+        bool moreSteps = (newTime < nextTime);
+        if(!acceptStep(solver, h, newTime, dense || moreSteps)) {
+            return fmi4cSolverError;
+        }
+
+        fmi4cSolverStatus status = completeStep(solver, nextTime);
+        if(status != fmi4cSolverOK) {
+            return status;
+        }
+    }
+    return fmi4cSolverOK;
+}
+
+//! @brief Integrates the FMU to the specified time
+//! On return the FMU is left at fmi4c_getSolverTime(), with continuous states set accordingly.
+//! This is normally nextTime, but can be earlier if an event indicator crossed zero, a time event
+//! was reached or the FMU requested event mode or termination. Events are located to within a
+//! small multiple of the machine precision, see fmi4c_handleSolverEvent().
+//! @param nextTime Time to integrate to
+//! @returns Solver status
+fmi4cSolverStatus fmi4c_integrateSolver(fmi4cSolver *solver, double nextTime)
+{
+    if(!solver->initialized) {
+        fmi4c_printMessage("Solver must be initialized before integrating");
+        return fmi4cSolverError;
+    }
+    if(nextTime < solver->outputTime) {
+        fmi4c_printMessage("Solver cannot integrate backwards in time");
+        return fmi4cSolverError;
+    }
+
+    // Stop at the next time event
+    bool timeEvent = false;
+    if(solver->nextEventTimeDefined && solver->nextEventTime > solver->outputTime && solver->nextEventTime <= nextTime) {
+        nextTime = solver->nextEventTime;
+        timeEvent = true;
+    }
+    fmi4cSolverStatus reachedStatus = timeEvent ? fmi4cSolverEnterEventMode : fmi4cSolverOK;
+
+    double eventTime = solver->pendingEvent ? solver->eventTime : solver->time;
+    if(nextTime < eventTime || (nextTime == eventTime && !solver->pendingEvent)) {
+        // Requested time is already covered by the last internal step
+        if(!interpolate(solver, nextTime, solver->tempStates) ||
+           !setTimeAndStates(solver, nextTime, solver->tempStates)) {
+            return fmi4cSolverError;
+        }
+        solver->outputTime = nextTime;
+        return reachedStatus;
+    }
+    if(solver->pendingEvent) {
+        solver->pendingEvent = false;
+        if(!interpolate(solver, eventTime, solver->tempStates) ||
+           !setTimeAndStates(solver, eventTime, solver->tempStates)) {
+            return fmi4cSolverError;
+        }
+        solver->outputTime = eventTime;
+        return fmi4cSolverEnterEventMode;
+    }
+
+    if(!solver->denseOutput) {
+        // Inputs may have been changed by the caller since the last call
+        solver->derivativesValid = false;
+        if(solver->nEventIndicators > 0 && solver->outputTime == solver->time) {
+            if(!getEventIndicators(solver, solver->trialEventIndicators)) {
+                return fmi4cSolverError;
+            }
+            bool crossed = eventIndicatorsCrossed(solver, solver->eventIndicators, solver->trialEventIndicators);
+            memcpy(solver->eventIndicators, solver->trialEventIndicators, solver->nEventIndicators*sizeof(double));
+            if(crossed) {
+                ++solver->statistics.nStateEvents;
+                return fmi4cSolverEnterEventMode;
+            }
+        }
+    }
+
+    // In dense output mode internal steps may pass nextTime, but never the stop time or the next time event
+    double endTime = nextTime;
+    if(solver->denseOutput) {
+        endTime = DBL_MAX;
+        if(solver->stopTimeDefined && solver->stopTime > nextTime) {
+            endTime = solver->stopTime;
+        }
+        if(solver->nextEventTimeDefined && solver->nextEventTime > nextTime && solver->nextEventTime < endTime) {
+            endTime = solver->nextEventTime;
+        }
+    }
+
+    fmi4cSolverStatus status;
+#ifdef FMI4C_WITH_CVODE
+    if(solver->method == fmi4cSolverCVode) {
+        status = integrateCVode(solver, nextTime, endTime);
+    }
+    else
+#endif
+    {
+        status = integrateRungeKutta(solver, nextTime, endTime);
+    }
+    if(status != fmi4cSolverOK) {
+        return status;
+    }
+
+    if(solver->time > nextTime) {
+        if(!interpolate(solver, nextTime, solver->tempStates) ||
+           !setTimeAndStates(solver, nextTime, solver->tempStates)) {
+            return fmi4cSolverError;
+        }
+    }
+    solver->outputTime = nextTime;
+    return reachedStatus;
+}
+
+//! @brief Interpolates the continuous states at a time within the last accepted step
+//! @returns False if the time is outside the last step
+bool fmi4c_getSolverDenseOutput(fmi4cSolver *solver, double time, double states[])
+{
+    if(time > solver->time || time < solver->previousTime) {
+        fmi4c_printMessage("Dense output requested outside last solver step");
+        return false;
+    }
+    return interpolate(solver, time, states);
+}
+
+//! @brief Returns the time the FMU was left at by the last call to fmi4c_integrateSolver()
+double fmi4c_getSolverTime(fmi4cSolver *solver)
+{
+    return solver->outputTime;
+}
+
+//! @brief Returns the continuous states at the end of the last accepted internal step
+const double *fmi4c_getSolverStates(fmi4cSolver *solver)
+{
+    return solver->states;
+}
+
+void fmi4c_getSolverStatistics(fmi4cSolver *solver, fmi4cSolverStatistics *statistics)
+{
+    *statistics = solver->statistics;
+#ifdef FMI4C_WITH_CVODE
+    if(solver->method == fmi4cSolverCVode && solver->cvodeInitialized) {
+        long int errorTestFails = 0;
+        long int convergenceFails = 0;
+        CVodeGetNumErrTestFails(solver->cvodeMemory, &errorTestFails);
+        CVodeGetNumNonlinSolvConvFails(solver->cvodeMemory, &convergenceFails);
+        statistics->nRejectedSteps = (size_t)(errorTestFails+convergenceFails);
+    }
+#endif
+}
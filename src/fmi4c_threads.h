@@ -0,0 +1,298 @@
+#ifndef FMIC_THREADS_H
+#define FMIC_THREADS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <process.h>
+#else
+    #include <pthread.h>
+    #include <sched.h>
+    #include <time.h>
+    #include <errno.h>
+    #include <unistd.h>
+#endif
+
+// Thread-local storage
+
+#if defined(_MSC_VER)
+#define FMI4C_THREAD_LOCAL __declspec(thread)
+#else
+#define FMI4C_THREAD_LOCAL __thread
+#endif
+
+// Atomic operations (sequentially consistent unless stated otherwise)
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+static __inline size_t fmi4c_atomicLoadAcquire(volatile size_t *ptr) { size_t v = *ptr; _ReadWriteBarrier(); return v; }
+static __inline void fmi4c_atomicStoreRelease(volatile size_t *ptr, size_t value) { _ReadWriteBarrier(); *ptr = value; }
+static __inline void *fmi4c_atomicLoadPointerAcquire(void *volatile *ptr) { void *v = *ptr; _ReadWriteBarrier(); return v; }
+static __inline void fmi4c_atomicStorePointerRelease(void *volatile *ptr, void *value) { _ReadWriteBarrier(); *ptr = value; }
+static __inline size_t fmi4c_atomicFetchAdd(volatile size_t *ptr, size_t value) { return (size_t)InterlockedExchangeAdd64((volatile LONG64*)ptr, (LONG64)value); }
+static __inline bool fmi4c_atomicCompareExchange(volatile size_t *ptr, size_t expected, size_t desired) { return (size_t)InterlockedCompareExchange64((volatile LONG64*)ptr, (LONG64)desired, (LONG64)expected) == expected; }
+static __inline void fmi4c_atomicFence(void) { MemoryBarrier(); }
+static __inline void fmi4c_cpuRelax(void) { YieldProcessor(); }
+#else
+static inline size_t fmi4c_atomicLoadAcquire(volatile size_t *ptr) { return __atomic_load_n(ptr, __ATOMIC_ACQUIRE); }
+static inline void fmi4c_atomicStoreRelease(volatile size_t *ptr, size_t value) { __atomic_store_n(ptr, value, __ATOMIC_RELEASE); }
+static inline void *fmi4c_atomicLoadPointerAcquire(void *volatile *ptr) { return __atomic_load_n(ptr, __ATOMIC_ACQUIRE); }
+static inline void fmi4c_atomicStorePointerRelease(void *volatile *ptr, void *value) { __atomic_store_n(ptr, value, __ATOMIC_RELEASE); }
+static inline size_t fmi4c_atomicFetchAdd(volatile size_t *ptr, size_t value) { return __atomic_fetch_add(ptr, value, __ATOMIC_SEQ_CST); }
+static inline bool fmi4c_atomicCompareExchange(volatile size_t *ptr, size_t expected, size_t desired) { return __atomic_compare_exchange_n(ptr, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); }
+static inline void fmi4c_atomicFence(void) { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+#if defined(__x86_64__) || defined(__i386__)
+static inline void fmi4c_cpuRelax(void) { __builtin_ia32_pause(); }
+#else
+static inline void fmi4c_cpuRelax(void) { }
+#endif
+#endif
+
+// Threads, mutexes and condition variables
+
+typedef void (*fmi4cThreadFunction_t)(void *arg);
+
+#ifdef _WIN32
+typedef HANDLE fmi4cThread_t;
+typedef CRITICAL_SECTION fmi4cMutex_t;
+typedef CONDITION_VARIABLE fmi4cCond_t;
+#else
+typedef pthread_t fmi4cThread_t;
+typedef pthread_mutex_t fmi4cMutex_t;
+typedef pthread_cond_t fmi4cCond_t;
+#endif
+
+typedef struct {
+    fmi4cThreadFunction_t function;
+    void *arg;
+} fmi4cThreadStart_t;
+
+#ifdef _WIN32
+static inline unsigned __stdcall fmi4c_threadTrampoline(void *ptr)
+{
+    fmi4cThreadStart_t start = *(fmi4cThreadStart_t*)ptr;
+    free(ptr);
+    start.function(start.arg);
+    return 0;
+}
+#else
+static inline void *fmi4c_threadTrampoline(void *ptr)
+{
+    fmi4cThreadStart_t start = *(fmi4cThreadStart_t*)ptr;
+    free(ptr);
+    start.function(start.arg);
+    return NULL;
+}
+#endif
+
+//! @brief Starts a new thread executing function(arg)
+//! @returns True if the thread was started
+static inline bool fmi4c_threadCreate(fmi4cThread_t *thread, fmi4cThreadFunction_t function, void *arg)
+{
+    fmi4cThreadStart_t *start = malloc(sizeof(fmi4cThreadStart_t));
+    if(start == NULL) {
+        return false;
+    }
+    start->function = function;
+    start->arg = arg;
+#ifdef _WIN32
+    *thread = (HANDLE)_beginthreadex(NULL, 0, fmi4c_threadTrampoline, start, 0, NULL);
+    if(*thread == 0) {
+        free(start);
+        return false;
+    }
+#else
+    if(pthread_create(thread, NULL, fmi4c_threadTrampoline, start) != 0) {
+        free(start);
+        return false;
+    }
+#endif
+    return true;
+}
+
+static inline void fmi4c_threadJoin(fmi4cThread_t thread)
+{
+#ifdef _WIN32
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+}
+
+static inline void fmi4c_threadYield(void)
+{
+#ifdef _WIN32
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+static inline int fmi4c_getNumberOfProcessors(void)
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+//! @brief Pins the calling thread to one processor
+//! On Linux this requires _GNU_SOURCE to be defined before any system header is included.
+//! @returns True if the affinity was set
+static inline bool fmi4c_threadPinToProcessor(int processor)
+{
+#if defined(_WIN32)
+    return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << (processor % (8*sizeof(DWORD_PTR)))) != 0;
+#elif defined(__linux__) && defined(CPU_SET)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(processor, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)processor;
+    return false;
+#endif
+}
+
+//! @brief Gives the calling thread a fixed real-time priority (SCHED_FIFO), higher values preempt lower
+//! Usually requires elevated privileges (CAP_SYS_NICE or an rtprio limit) on Linux.
+//! @param priority Priority from 1 to 98, clamped to the range supported by the system
+//! @returns True if the priority was set
+static inline bool fmi4c_threadSetRealTimePriority(int priority)
+{
+#if defined(_WIN32)
+    int level = priority >= 50 ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_HIGHEST;
+    return SetThreadPriority(GetCurrentThread(), level) != 0;
+#else
+    int minimum = sched_get_priority_min(SCHED_FIFO);
+    int maximum = sched_get_priority_max(SCHED_FIFO);
+    struct sched_param parameters;
+    parameters.sched_priority = priority < minimum ? minimum : (priority > maximum ? maximum : priority);
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters) == 0;
+#endif
+}
+
+static inline void fmi4c_mutexInit(fmi4cMutex_t *mutex)
+{
+#ifdef _WIN32
+    InitializeCriticalSection(mutex);
+#else
+    pthread_mutex_init(mutex, NULL);
+#endif
+}
+
+static inline void fmi4c_mutexDestroy(fmi4cMutex_t *mutex)
+{
+#ifdef _WIN32
+    DeleteCriticalSection(mutex);
+#else
+    pthread_mutex_destroy(mutex);
+#endif
+}
+
+static inline void fmi4c_mutexLock(fmi4cMutex_t *mutex)
+{
+#ifdef _WIN32
+    EnterCriticalSection(mutex);
+#else
+    pthread_mutex_lock(mutex);
+#endif
+}
+
+static inline void fmi4c_mutexUnlock(fmi4cMutex_t *mutex)
+{
+#ifdef _WIN32
+    LeaveCriticalSection(mutex);
+#else
+    pthread_mutex_unlock(mutex);
+#endif
+}
+
+static inline void fmi4c_condInit(fmi4cCond_t *cond)
+{
+#ifdef _WIN32
+    InitializeConditionVariable(cond);
+#else
+    pthread_cond_init(cond, NULL);
+#endif
+}
+
+static inline void fmi4c_condDestroy(fmi4cCond_t *cond)
+{
+#ifdef _WIN32
+    (void)cond;
+#else
+    pthread_cond_destroy(cond);
+#endif
+}
+
+static inline void fmi4c_condWait(fmi4cCond_t *cond, fmi4cMutex_t *mutex)
+{
+#ifdef _WIN32
+    SleepConditionVariableCS(cond, mutex, INFINITE);
+#else
+    pthread_cond_wait(cond, mutex);
+#endif
+}
+
+//! @brief Waits on a condition variable for at most the specified number of microseconds
+static inline void fmi4c_condTimedWait(fmi4cCond_t *cond, fmi4cMutex_t *mutex, long microseconds)
+{
+#ifdef _WIN32
+    DWORD ms = (DWORD)(microseconds/1000);
+    SleepConditionVariableCS(cond, mutex, ms > 0 ? ms : 1);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += microseconds/1000000;
+    ts.tv_nsec += (microseconds%1000000)*1000;
+    if(ts.tv_nsec >= 1000000000) {
+        ts.tv_sec += 1;
+        ts.tv_nsec -= 1000000000;
+    }
+    pthread_cond_timedwait(cond, mutex, &ts);
+#endif
+}
+
+static inline void fmi4c_condSignal(fmi4cCond_t *cond)
+{
+#ifdef _WIN32
+    WakeConditionVariable(cond);
+#else
+    pthread_cond_signal(cond);
+#endif
+}
+
+static inline void fmi4c_condBroadcast(fmi4cCond_t *cond)
+{
+#ifdef _WIN32
+    WakeAllConditionVariable(cond);
+#else
+    pthread_cond_broadcast(cond);
+#endif
+}
+
+//! @brief Returns a monotonic time stamp in seconds
+static inline double fmi4c_getWallTime(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart/(double)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1e-9*(double)ts.tv_nsec;
+#endif
+}
+
+#endif // FMIC_THREADS_H
@@ -0,0 +1,265 @@
+#include "fmi4c_private.h"
+#define FMI4C_H_INTERNAL_INCLUDE
+#include "fmi4c.h"
+#include "fmi4c_tlm.h"
+#include "fmi4c_threads.h"
+
+#define TLM_SPIN_ITERATIONS 4000
+
+//! @brief Single producer, single consumer ring of (time, wave) samples for one direction
+//! The producer owns head and lastTime, the consumer owns tail and cursor. Samples are published by
+//! writing them before storing head with release semantics, and released by storing tail.
+typedef struct {
+    size_t capacity;                // Power of two
+    size_t mask;
+    size_t history;                 // Samples kept behind the cursor for lookups at earlier times
+    double *times;
+    double *waves;
+
+    volatile size_t head;           // Number of published samples
+    volatile size_t tail;           // Oldest sample still needed by the consumer
+    size_t cursor;                  // Consumer: last sample at or before the previous lookup time
+    double lastTime;                // Producer: time of the last published sample
+
+    volatile size_t consumerWaiting;
+    volatile size_t producerWaiting;
+    volatile size_t closed;
+    fmi4cMutex_t mutex;
+    fmi4cCond_t condition;
+} delayLine_t;
+
+struct fmi4cTlmConnection {
+    double characteristicImpedance;
+    double timeDelay;
+    delayLine_t lines[2];           // lines[i] carries waves produced by side i
+};
+
+static bool initDelayLine(delayLine_t *line, size_t bufferSize, double startTime)
+{
+    size_t capacity = 16;
+    while(capacity < bufferSize) {
+        capacity *= 2;
+    }
+    line->capacity = capacity;
+    line->mask = capacity-1;
+    line->history = capacity/4;
+    line->times = calloc(capacity, sizeof(double));
+    line->waves = calloc(capacity, sizeof(double));
+    if(line->times == NULL || line->waves == NULL) {
+        free(line->times);
+        free(line->waves);
+        return false;
+    }
+    fmi4c_mutexInit(&line->mutex);
+    fmi4c_condInit(&line->condition);
+
+    // Waves are zero until the first sample after the start time is published
+    line->times[0] = startTime;
+    line->waves[0] = 0;
+    line->head = 1;
+    line->lastTime = startTime;
+    return true;
+}
+
+static void freeDelayLine(delayLine_t *line)
+{
+    fmi4c_condDestroy(&line->condition);
+    fmi4c_mutexDestroy(&line->mutex);
+    free(line->times);
+    free(line->waves);
+}
+
+//! @brief Wakes the other side if it is blocked on the line
+static void wakeDelayLine(delayLine_t *line, volatile size_t *waiting)
+{
+    fmi4c_atomicFence();
+    if(fmi4c_atomicLoadAcquire(waiting)) {
+        fmi4c_mutexLock(&line->mutex);
+        fmi4c_condBroadcast(&line->condition);
+        fmi4c_mutexUnlock(&line->mutex);
+    }
+}
+
+//! @brief Consumer: waits until more than count samples are published, or the line is closed
+static void waitForSamples(delayLine_t *line, size_t count)
+{
+    for(int i=0; i<TLM_SPIN_ITERATIONS; ++i) {
+        if(fmi4c_atomicLoadAcquire(&line->head) > count || fmi4c_atomicLoadAcquire(&line->closed)) {
+            return;
+        }
+        fmi4c_cpuRelax();
+    }
+    fmi4c_mutexLock(&line->mutex);
+    fmi4c_atomicStoreRelease(&line->consumerWaiting, 1);
+    fmi4c_atomicFence();
+    while(fmi4c_atomicLoadAcquire(&line->head) <= count && !fmi4c_atomicLoadAcquire(&line->closed)) {
+        fmi4c_condWait(&line->condition, &line->mutex);
+    }
+    fmi4c_atomicStoreRelease(&line->consumerWaiting, 0);
+    fmi4c_mutexUnlock(&line->mutex);
+}
+
+//! @brief Producer: waits until there is room for one more sample, or the line is closed
+static void waitForSpace(delayLine_t *line, size_t head)
+{
+    for(int i=0; i<TLM_SPIN_ITERATIONS; ++i) {
+        if(head-fmi4c_atomicLoadAcquire(&line->tail) < line->capacity || fmi4c_atomicLoadAcquire(&line->closed)) {
+            return;
+        }
+        fmi4c_cpuRelax();
+    }
+    fmi4c_mutexLock(&line->mutex);
+    fmi4c_atomicStoreRelease(&line->producerWaiting, 1);
+    fmi4c_atomicFence();
+    while(head-fmi4c_atomicLoadAcquire(&line->tail) >= line->capacity && !fmi4c_atomicLoadAcquire(&line->closed)) {
+        fmi4c_condWait(&line->condition, &line->mutex);
+    }
+    fmi4c_atomicStoreRelease(&line->producerWaiting, 0);
+    fmi4c_mutexUnlock(&line->mutex);
+}
+
+//! @brief Consumer: returns the wave at the specified time, interpolated linearly between samples
+//! Blocks until the producer has published a sample at or after the time.
+static double readDelayLine(delayLine_t *line, double time)
+{
+    size_t tail = line->tail;
+    size_t cursor = line->cursor;
+
+    // Step back if the time is earlier than the previous lookup (e.g. after a rejected step)
+    while(cursor > tail && line->times[cursor & line->mask] > time) {
+        --cursor;
+    }
+
+    // Step forward until the next sample is after the time, waiting for the producer when needed
+    while(true) {
+        size_t head = fmi4c_atomicLoadAcquire(&line->head);
+        while(cursor+1 < head && line->times[(cursor+1) & line->mask] <= time) {
+            ++cursor;
+        }
+        if(cursor+1 < head || line->times[cursor & line->mask] >= time || fmi4c_atomicLoadAcquire(&line->closed)) {
+            break;
+        }
+        waitForSamples(line, cursor+1);
+    }
+    line->cursor = cursor;
+
+    // Release samples that are too old to be needed again
+    if(cursor > tail+line->history) {
+        fmi4c_atomicStoreRelease(&line->tail, cursor-line->history);
+        wakeDelayLine(line, &line->producerWaiting);
+    }
+
+    size_t i = cursor & line->mask;
+    double t1 = line->times[i];
+    if(time <= t1 || cursor+1 >= fmi4c_atomicLoadAcquire(&line->head)) {
+        return line->waves[i];
+    }
+    size_t j = (cursor+1) & line->mask;
+    double t2 = line->times[j];
+    return line->waves[i] + (line->waves[j]-line->waves[i])*(time-t1)/(t2-t1);
+}
+
+//! @brief Producer: publishes one sample, blocking while the ring is full
+static bool writeDelayLine(delayLine_t *line, double time, double wave)
+{
+    if(time <= line->lastTime) {
+        return false;
+    }
+    size_t head = line->head;
+    waitForSpace(line, head);
+    if(fmi4c_atomicLoadAcquire(&line->closed)) {
+        return false;
+    }
+    line->times[head & line->mask] = time;
+    line->waves[head & line->mask] = wave;
+    line->lastTime = time;
+    fmi4c_atomicStoreRelease(&line->head, head+1);
+    wakeDelayLine(line, &line->consumerWaiting);
+    return true;
+}
+
+//! @brief Creates a TLM connection
+//! @param characteristicImpedance Characteristic impedance Zc of the line
+//! @param timeDelay Wave propagation time T, must be larger than the internal steps of both sides
+//! @param startTime Simulation start time, waves are zero before the first published sample
+//! @param bufferSize Minimum number of samples per direction (rounded up to a power of two)
+//! @returns Connection handle, or NULL on failure
+fmi4cTlmConnection *fmi4c_createTlmConnection(double characteristicImpedance, double timeDelay, double startTime, size_t bufferSize)
+{
+    if(timeDelay <= 0) {
+        fmi4c_printMessage("TLM time delay must be positive");
+        return NULL;
+    }
+    fmi4cTlmConnection *connection = calloc(1, sizeof(fmi4cTlmConnection));
+    if(connection == NULL) {
+        return NULL;
+    }
+    connection->characteristicImpedance = characteristicImpedance;
+    connection->timeDelay = timeDelay;
+    if(!initDelayLine(&connection->lines[0], bufferSize, startTime)) {
+        free(connection);
+        return NULL;
+    }
+    if(!initDelayLine(&connection->lines[1], bufferSize, startTime)) {
+        freeDelayLine(&connection->lines[0]);
+        free(connection);
+        return NULL;
+    }
+    return connection;
+}
+
+void fmi4c_freeTlmConnection(fmi4cTlmConnection *connection)
+{
+    if(connection == NULL) {
+        return;
+    }
+    freeDelayLine(&connection->lines[0]);
+    freeDelayLine(&connection->lines[1]);
+    free(connection);
+}
+
+//! @brief Releases both sides from any blocking wait, e.g. when one side fails or terminates
+//! After closing, lookups return the latest available wave and nothing more is published.
+void fmi4c_closeTlmConnection(fmi4cTlmConnection *connection)
+{
+    for(int i=0; i<2; ++i) {
+        delayLine_t *line = &connection->lines[i];
+        fmi4c_mutexLock(&line->mutex);
+        fmi4c_atomicStoreRelease(&line->closed, 1);
+        fmi4c_condBroadcast(&line->condition);
+        fmi4c_mutexUnlock(&line->mutex);
+    }
+}
+
+//! @brief Returns the wave arriving at one side, c_i(t) = w_j(t-T)
+//! Must only be called from the thread stepping that side.
+double fmi4c_getTlmWave(fmi4cTlmConnection *connection, int side, double time)
+{
+    return readDelayLine(&connection->lines[1-side], time-connection->timeDelay);
+}
+
+//! @brief Returns the force acting on one side, F_i = Zc*v_i + c_i(t)
+//! Must only be called from the thread stepping that side.
+double fmi4c_getTlmForce(fmi4cTlmConnection *connection, int side, double time, double velocity)
+{
+    return connection->characteristicImpedance*velocity + fmi4c_getTlmWave(connection, side, time);
+}
+
+//! @brief Publishes the velocity of one side, producing the wave w_i = 2*Zc*v_i + c_i(t) to the other side
+//! Must only be called from the thread stepping that side, with strictly increasing times.
+//! @returns False if the sample was ignored (time not increasing, or connection closed)
+bool fmi4c_publishTlmVelocity(fmi4cTlmConnection *connection, int side, double time, double velocity)
+{
+    double wave = 2*connection->characteristicImpedance*velocity + fmi4c_getTlmWave(connection, side, time);
+    return writeDelayLine(&connection->lines[side], time, wave);
+}
+
+double fmi4c_getTlmCharacteristicImpedance(fmi4cTlmConnection *connection)
+{
+    return connection->characteristicImpedance;
+}
+
+double fmi4c_getTlmTimeDelay(fmi4cTlmConnection *connection)
+{
+    return connection->timeDelay;
+}
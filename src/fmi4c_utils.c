@@ -254,6 +254,7 @@ bool parseModelStructureElementFmi2(fmuHandle *fmu, fmi2ModelStructureHandle *ou
     parseInt32AttributeEzXml(*element, "index", &output->index);
 
     //Default values
+    output->dependenciesDefined = false;
     output->dependencyKindsDefined = false;
     output->dependencies = NULL;
     output->dependencyKinds = NULL;
@@ -262,6 +263,7 @@ bool parseModelStructureElementFmi2(fmuHandle *fmu, fmi2ModelStructureHandle *ou
     output->numberOfDependencies = 0;
     const char* dependencies = NULL;
     if(parseStringAttributeEzXml(*element, "dependencies", &dependencies)) {
+        output->dependenciesDefined = true;
 
         if(dependencies != NULL && dependencies[0] != '\0') {
 
@@ -354,12 +356,14 @@ bool parseModelStructureElementFmi3(fmuHandle *fmu, fmi3ModelStructureHandle *ou
 {
     parseUInt32AttributeEzXml(*element, "valueReference", &output->valueReference);
 
+    output->dependenciesDefined = false; //Default value
     output->dependencyKindsDefined = false; //Default value
 
     //Count number of dependencies
     output->numberOfDependencies = 0;
     const char* dependencies = NULL;
     if(parseStringAttributeEzXmlAndRememberPointer(*element, "dependencies", &dependencies, fmu)) {
+        output->dependenciesDefined = true;
 
         if(dependencies != NULL && dependencies[0] != '\0') {
 
@@ -0,0 +1,558 @@
+#include "fmi4c_private.h"
+#define FMI4C_H_INTERNAL_INCLUDE
+#include "fmi4c.h"
+#include "fmi4c_common.h"
+#include "fmi4c_writer.h"
+#include "fmi4c_threads.h"
+#include "fmi4c_dtoa.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef FMI4C_WITH_ZLIB
+#include <zlib.h>
+#endif
+
+#define WRITER_BLOCK_SIZE (1 << 20)     // Bytes of values per block
+#define WRITER_DEFAULT_MEMORY_BUDGET (16 << 20)
+#define WRITER_CSV_VALUE_SIZE (FMI4C_DTOA_BUFFER_SIZE+1)     // Characters reserved per CSV value, including separator
+#define MAT4_HEADER_SIZE 20             // Five 32-bit integers: type, rows, columns, imaginary flag, name length
+#define MAT4_TEXT_TYPE 51               // Text stored as bytes
+#define GZIP_HEADER_SIZE 10
+
+static const char *dataMatrixName = "data";
+static const char *namesMatrixName = "names";
+
+struct fmi4cResultWriter {
+    fmi4cResultFormat format;
+    FILE *file;
+    volatile size_t failed;             // Set by the writing thread, checked by the simulation thread
+    size_t nColumns;                    // Time and variables
+    size_t nRows;                       // Rows written or buffered
+    double *blocks;                     // Ring of blocks of buffered rows, one after another (one block if synchronous)
+    size_t *blockRows;                  // Number of rows in each full block
+    size_t nBlocks;
+    size_t blockCapacity;               // Maximum number of rows in a block
+    double *block;                      // Block currently filled
+    size_t nBlockRows;                  // Rows in the current block
+    char *text;                         // Formatted block, for CSV
+    long dataHeaderOffset;              // Position of the data matrix header, for writing the number of rows
+    fmi4cResultWriterStatistics statistics;
+
+    // Asynchronous writing: the simulation thread fills blocks and publishes them by incrementing
+    // head, the writing thread writes them and increments tail. The mutex is only taken when one
+    // side has to wait for the other.
+    bool async;
+    fmi4cThread_t thread;
+    fmi4cMutex_t mutex;
+    fmi4cCond_t blockReady;
+    fmi4cCond_t blockFree;
+    volatile size_t head;               // Number of published blocks
+    volatile size_t tail;               // Number of written blocks
+    volatile size_t writerWaiting;
+    size_t producerWaiting;
+    volatile size_t stopping;
+#ifdef FMI4C_WITH_ZLIB
+    z_stream deflater;
+    bool deflating;
+    unsigned char *compressed;          // Output buffer of the deflater
+#endif
+};
+
+//! @brief Selects the result format from the file name extension: .mat (MAT-file), .mat.gz (compressed MAT-file) or anything else (CSV)
+fmi4cResultFormat fmi4c_getResultFormatFromFileName(const char *path)
+{
+    size_t length = strlen(path);
+    if(length >= 7 && !strcmp(path+length-7, ".mat.gz")) {
+        return fmi4cResultMat4Compressed;
+    }
+    if(length >= 4 && !strcmp(path+length-4, ".mat")) {
+        return fmi4cResultMat4;
+    }
+    return fmi4cResultCsv;
+}
+
+static bool isBigEndian(void)
+{
+    const uint16_t word = 1;
+    return *(const unsigned char*)&word == 0;
+}
+
+//! @brief Creates a MAT-file matrix header followed by the matrix name
+//! @returns Number of bytes in header
+static size_t createMatrixHeader(unsigned char *header, int32_t type, size_t nRows, size_t nColumns, const char *name)
+{
+    int32_t fields[5];
+    fields[0] = (isBigEndian() ? 1000 : 0) + type;
+    fields[1] = (int32_t)nRows;
+    fields[2] = (int32_t)nColumns;
+    fields[3] = 0;
+    fields[4] = (int32_t)strlen(name)+1;
+    memcpy(header, fields, MAT4_HEADER_SIZE);
+    memcpy(header+MAT4_HEADER_SIZE, name, (size_t)fields[4]);
+    return MAT4_HEADER_SIZE+(size_t)fields[4];
+}
+
+//! @brief Creates the names matrix of a MAT-file, with one space padded name per column
+static unsigned char *createNamesMatrix(size_t nNames, const char **names, size_t *size)
+{
+    size_t nameLength = 1;
+    for(size_t i=0; i<nNames; ++i) {
+        size_t length = strlen(names[i]);
+        nameLength = length > nameLength ? length : nameLength;
+    }
+    size_t headerSize = MAT4_HEADER_SIZE+strlen(namesMatrixName)+1;
+    unsigned char *matrix = malloc(headerSize+nNames*nameLength);
+    if(matrix == NULL) {
+        return NULL;
+    }
+    createMatrixHeader(matrix, MAT4_TEXT_TYPE, nameLength, nNames, namesMatrixName);
+    memset(matrix+headerSize, ' ', nNames*nameLength);
+    for(size_t i=0; i<nNames; ++i) {
+        memcpy(matrix+headerSize+i*nameLength, names[i], strlen(names[i]));
+    }
+    *size = headerSize+nNames*nameLength;
+    return matrix;
+}
+
+static void setFailed(fmi4cResultWriter *writer)
+{
+    fmi4c_atomicStoreRelease(&writer->failed, 1);
+}
+
+static bool hasFailed(fmi4cResultWriter *writer)
+{
+    return fmi4c_atomicLoadAcquire(&writer->failed) != 0;
+}
+
+static bool writeBytes(fmi4cResultWriter *writer, const void *data, size_t size)
+{
+    if(!hasFailed(writer) && fwrite(data, 1, size, writer->file) != size) {
+        fmi4c_printMessage("Failed to write result file");
+        setFailed(writer);
+    }
+    return !hasFailed(writer);
+}
+
+#ifdef FMI4C_WITH_ZLIB
+//! @brief Compresses data into the current gzip member, finishing the member if requested
+static bool deflateBytes(fmi4cResultWriter *writer, const void *data, size_t size, bool finish)
+{
+    z_stream *deflater = &writer->deflater;
+    deflater->next_in = (Bytef*)data;
+    deflater->avail_in = (uInt)size;
+    int result;
+    do {
+        deflater->next_out = writer->compressed;
+        deflater->avail_out = WRITER_BLOCK_SIZE;
+        result = deflate(deflater, finish ? Z_FINISH : Z_NO_FLUSH);
+        if(result == Z_STREAM_ERROR) {
+            setFailed(writer);
+            return false;
+        }
+        if(!writeBytes(writer, writer->compressed, WRITER_BLOCK_SIZE-deflater->avail_out)) {
+            return false;
+        }
+    } while(deflater->avail_out == 0 || (finish && result != Z_STREAM_END));
+    return true;
+}
+
+//! @brief Writes data as a gzip member with one uncompressed (stored) deflate block, which can be modified afterwards
+static bool writeStoredMember(fmi4cResultWriter *writer, const unsigned char *data, uint16_t size)
+{
+    unsigned char header[GZIP_HEADER_SIZE+5] = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff,
+                                                 1, (unsigned char)(size & 0xff), (unsigned char)(size >> 8),
+                                                 (unsigned char)(~size & 0xff), (unsigned char)((~size >> 8) & 0xff) };
+    uint32_t crc = (uint32_t)crc32(0, data, size);
+    unsigned char trailer[8] = { (unsigned char)crc, (unsigned char)(crc >> 8), (unsigned char)(crc >> 16), (unsigned char)(crc >> 24),
+                                 (unsigned char)size, (unsigned char)(size >> 8), 0, 0 };
+    return writeBytes(writer, header, sizeof(header)) && writeBytes(writer, data, size) && writeBytes(writer, trailer, sizeof(trailer));
+}
+#endif
+
+//! @brief Writes the names matrix and the data matrix header, with zero time points
+static bool writeMatHeader(fmi4cResultWriter *writer, size_t nNames, const char **names)
+{
+    size_t namesSize = 0;
+    unsigned char *namesMatrix = createNamesMatrix(nNames, names, &namesSize);
+    if(namesMatrix == NULL) {
+        return false;
+    }
+    unsigned char dataHeader[MAT4_HEADER_SIZE+8];
+    size_t dataHeaderSize = createMatrixHeader(dataHeader, 0, writer->nColumns, 0, dataMatrixName);
+    bool ok;
+    if(writer->format == fmi4cResultMat4) {
+        ok = writeBytes(writer, namesMatrix, namesSize);
+        writer->dataHeaderOffset = ftell(writer->file);
+        ok = ok && writeBytes(writer, dataHeader, dataHeaderSize);
+    }
+    else {
+#ifdef FMI4C_WITH_ZLIB
+        // The names and the values are separate compressed gzip members, with the data matrix header in a stored member in between
+        ok = deflateBytes(writer, namesMatrix, namesSize, true) && deflateReset(&writer->deflater) == Z_OK;
+        writer->dataHeaderOffset = ftell(writer->file);
+        ok = ok && writeStoredMember(writer, dataHeader, (uint16_t)dataHeaderSize);
+#else
+        ok = false;
+#endif
+    }
+    free(namesMatrix);
+    return ok;
+}
+
+//! @brief Writes the final number of time points into the data matrix header
+static bool updateMatHeader(fmi4cResultWriter *writer)
+{
+    unsigned char dataHeader[MAT4_HEADER_SIZE+8];
+    size_t dataHeaderSize = createMatrixHeader(dataHeader, 0, writer->nColumns, writer->nRows, dataMatrixName);
+    long offset = writer->dataHeaderOffset;
+    if(writer->format == fmi4cResultMat4Compressed) {
+        offset += GZIP_HEADER_SIZE+5;
+    }
+    if(fseek(writer->file, offset, SEEK_SET) != 0 || !writeBytes(writer, dataHeader, dataHeaderSize)) {
+        setFailed(writer);
+        return false;
+    }
+#ifdef FMI4C_WITH_ZLIB
+    if(writer->format == fmi4cResultMat4Compressed) {
+        uint32_t crc = (uint32_t)crc32(0, dataHeader, (uInt)dataHeaderSize);
+        unsigned char crcBytes[4] = { (unsigned char)crc, (unsigned char)(crc >> 8), (unsigned char)(crc >> 16), (unsigned char)(crc >> 24) };
+        return writeBytes(writer, crcBytes, sizeof(crcBytes));
+    }
+#endif
+    return true;
+}
+
+//! @brief Formats rows as CSV text
+//! @returns Number of characters
+static size_t formatCsv(fmi4cResultWriter *writer, const double *block, size_t nRows)
+{
+    char *text = writer->text;
+    for(size_t i=0; i<nRows; ++i) {
+        const double *row = block+i*writer->nColumns;
+        for(size_t j=0; j<writer->nColumns; ++j) {
+            if(j > 0) {
+                *(text++) = ',';
+            }
+            text += fmi4c_formatDouble(row[j], text);
+        }
+        *(text++) = '\n';
+    }
+    return (size_t)(text-writer->text);
+}
+
+//! @brief Formats, compresses and writes a block of rows, and returns the time it took in writeTime
+static bool writeBlock(fmi4cResultWriter *writer, const double *block, size_t nRows, double *writeTime)
+{
+    double startTime = fmi4c_getWallTime();
+    size_t size = nRows*writer->nColumns*sizeof(double);
+    bool ok;
+    if(writer->format == fmi4cResultCsv) {
+        ok = writeBytes(writer, writer->text, formatCsv(writer, block, nRows));
+    }
+#ifdef FMI4C_WITH_ZLIB
+    else if(writer->format == fmi4cResultMat4Compressed) {
+        ok = deflateBytes(writer, block, size, false);
+    }
+#endif
+    else {
+        ok = writeBytes(writer, block, size);
+    }
+    *writeTime = fmi4c_getWallTime()-startTime;
+    return ok;
+}
+
+//! @brief Writes published blocks until the writer is closed
+static void writerThread(void *arg)
+{
+    fmi4cResultWriter *writer = arg;
+    size_t stride = writer->blockCapacity*writer->nColumns;
+    while(true) {
+        size_t tail = writer->tail;
+        if(fmi4c_atomicLoadAcquire(&writer->head) == tail) {
+            fmi4c_mutexLock(&writer->mutex);
+            fmi4c_atomicStoreRelease(&writer->writerWaiting, 1);
+            fmi4c_atomicFence();
+            while(fmi4c_atomicLoadAcquire(&writer->head) == tail && !fmi4c_atomicLoadAcquire(&writer->stopping)) {
+                fmi4c_condWait(&writer->blockReady, &writer->mutex);
+            }
+            fmi4c_atomicStoreRelease(&writer->writerWaiting, 0);
+            fmi4c_mutexUnlock(&writer->mutex);
+            if(fmi4c_atomicLoadAcquire(&writer->head) == tail) {
+                return;     // Stopping, and all blocks have been written
+            }
+        }
+        size_t index = tail % writer->nBlocks;
+        double writeTime;
+        writeBlock(writer, writer->blocks+index*stride, writer->blockRows[index], &writeTime);
+
+        fmi4c_mutexLock(&writer->mutex);
+        writer->statistics.writeTime += writeTime;
+        ++writer->statistics.numberOfBlocks;
+        fmi4c_atomicStoreRelease(&writer->tail, tail+1);
+        if(writer->producerWaiting) {
+            fmi4c_condSignal(&writer->blockFree);
+        }
+        fmi4c_mutexUnlock(&writer->mutex);
+    }
+}
+
+//! @brief Hands the current block over to the writing thread and waits for a free block if all are in use
+static bool publishBlock(fmi4cResultWriter *writer)
+{
+    writer->blockRows[writer->head % writer->nBlocks] = writer->nBlockRows;
+    writer->nBlockRows = 0;
+    size_t head = fmi4c_atomicFetchAdd(&writer->head, 1)+1;
+    if(fmi4c_atomicLoadAcquire(&writer->writerWaiting)) {
+        fmi4c_mutexLock(&writer->mutex);
+        fmi4c_condSignal(&writer->blockReady);
+        fmi4c_mutexUnlock(&writer->mutex);
+    }
+
+    size_t nQueued = head-fmi4c_atomicLoadAcquire(&writer->tail);
+    if(nQueued == writer->nBlocks) {
+        // Backpressure: the file can not be written as fast as results are produced
+        double startTime = fmi4c_getWallTime();
+        fmi4c_mutexLock(&writer->mutex);
+        writer->producerWaiting = 1;
+        while(head-fmi4c_atomicLoadAcquire(&writer->tail) == writer->nBlocks) {
+            fmi4c_condWait(&writer->blockFree, &writer->mutex);
+        }
+        writer->producerWaiting = 0;
+        ++writer->statistics.numberOfStalls;
+        writer->statistics.stallTime += fmi4c_getWallTime()-startTime;
+        fmi4c_mutexUnlock(&writer->mutex);
+    }
+    if(nQueued > writer->statistics.maxQueuedBlocks) {
+        writer->statistics.maxQueuedBlocks = nQueued;
+    }
+    writer->block = writer->blocks+(head % writer->nBlocks)*writer->blockCapacity*writer->nColumns;
+    return !hasFailed(writer);
+}
+
+//! @brief Writes the rows in the current block, or hands them over to the writing thread
+static bool flushBlock(fmi4cResultWriter *writer)
+{
+    if(writer->nBlockRows == 0) {
+        return !hasFailed(writer);
+    }
+    if(writer->async) {
+        return publishBlock(writer);
+    }
+    double writeTime;
+    bool ok = writeBlock(writer, writer->block, writer->nBlockRows, &writeTime);
+    writer->statistics.writeTime += writeTime;
+    ++writer->statistics.numberOfBlocks;
+    writer->nBlockRows = 0;
+    return ok;
+}
+
+//! @brief Allocates the blocks, and the text buffer for CSV
+static bool allocateBlocks(fmi4cResultWriter *writer, size_t blockSize, size_t nBlocks)
+{
+    free(writer->blocks);
+    free(writer->blockRows);
+    free(writer->text);
+    writer->blockCapacity = blockSize/(writer->nColumns*sizeof(double));
+    if(writer->blockCapacity == 0) {
+        writer->blockCapacity = 1;
+    }
+    writer->nBlocks = nBlocks;
+    writer->blocks = malloc(nBlocks*writer->blockCapacity*writer->nColumns*sizeof(double));
+    writer->blockRows = calloc(nBlocks, sizeof(size_t));
+    writer->text = NULL;
+    if(writer->format == fmi4cResultCsv) {
+        writer->text = malloc(writer->blockCapacity*writer->nColumns*WRITER_CSV_VALUE_SIZE);
+    }
+    writer->block = writer->blocks;
+    writer->statistics.bufferBytes = nBlocks*writer->blockCapacity*writer->nColumns*sizeof(double);
+    return writer->blocks != NULL && writer->blockRows != NULL && (writer->format != fmi4cResultCsv || writer->text != NULL);
+}
+
+static void freeResultWriter(fmi4cResultWriter *writer)
+{
+    if(writer->file != NULL) {
+        fclose(writer->file);
+    }
+#ifdef FMI4C_WITH_ZLIB
+    if(writer->deflating) {
+        deflateEnd(&writer->deflater);
+    }
+    free(writer->compressed);
+#endif
+    free(writer->blocks);
+    free(writer->blockRows);
+    free(writer->text);
+    free(writer);
+}
+
+//! @brief Creates a result file
+//! @param path Path to the result file, which is replaced if it exists
+//! @param format Result file format
+//! @param nVariables Number of variables, excluding time
+//! @param names Names of the variables, excluding time
+//! @returns Result writer, or NULL if the file could not be created
+fmi4cResultWriter *fmi4c_createResultWriter(const char *path, fmi4cResultFormat format, size_t nVariables, const char **names)
+{
+#ifndef FMI4C_WITH_ZLIB
+    if(format == fmi4cResultMat4Compressed) {
+        fmi4c_printMessage("Compressed result files require fmi4c built with zlib");
+        return NULL;
+    }
+#endif
+    fmi4cResultWriter *writer = calloc(1, sizeof(fmi4cResultWriter));
+    if(writer == NULL) {
+        return NULL;
+    }
+    writer->format = format;
+    writer->nColumns = nVariables+1;
+    bool allocated = allocateBlocks(writer, WRITER_BLOCK_SIZE, 1);
+    writer->file = fopen(path, "wb");
+    if(!allocated || writer->file == NULL) {
+        fmi4c_printMessage("Failed to create result file");
+        freeResultWriter(writer);
+        return NULL;
+    }
+#ifdef FMI4C_WITH_ZLIB
+    if(format == fmi4cResultMat4Compressed) {
+        writer->compressed = malloc(WRITER_BLOCK_SIZE);
+        writer->deflating = (deflateInit2(&writer->deflater, Z_BEST_SPEED, Z_DEFLATED, 16+MAX_WBITS, 8, Z_DEFAULT_STRATEGY) == Z_OK);
+        if(writer->compressed == NULL || !writer->deflating) {
+            freeResultWriter(writer);
+            return NULL;
+        }
+    }
+#endif
+
+    const char **allNames = malloc(writer->nColumns*sizeof(const char*));
+    if(allNames == NULL) {
+        freeResultWriter(writer);
+        return NULL;
+    }
+    allNames[0] = "time";
+    for(size_t i=0; i<nVariables; ++i) {
+        allNames[i+1] = names[i];
+    }
+    bool ok;
+    if(format == fmi4cResultCsv) {
+        ok = true;
+        for(size_t i=0; i<writer->nColumns && ok; ++i) {
+            ok = (i == 0 || writeBytes(writer, ",", 1)) && writeBytes(writer, allNames[i], strlen(allNames[i]));
+        }
+        ok = ok && writeBytes(writer, "\n", 1);
+    }
+    else {
+        ok = writeMatHeader(writer, writer->nColumns, allNames);
+    }
+    free((void*)allNames);
+    if(!ok) {
+        freeResultWriter(writer);
+        return NULL;
+    }
+    return writer;
+}
+
+//! @brief Moves writing (including formatting and compression) to a background thread
+//! Rows are collected in a ring of blocks within the memory budget (at least two blocks). The
+//! simulation thread only waits when all blocks are full. Must be called before the first row.
+//! @param memoryBudget Maximum memory for buffered rows in bytes (0 = default of 16 MB)
+//! @returns False if rows have been written already or the thread could not be started
+bool fmi4c_setResultWriterAsynchronous(fmi4cResultWriter *writer, size_t memoryBudget)
+{
+    if(writer->async || writer->nRows > 0) {
+        return false;
+    }
+    if(memoryBudget == 0) {
+        memoryBudget = WRITER_DEFAULT_MEMORY_BUDGET;
+    }
+    size_t blockSize = memoryBudget/2 < WRITER_BLOCK_SIZE ? memoryBudget/2 : WRITER_BLOCK_SIZE;
+    size_t rowSize = writer->nColumns*sizeof(double);
+    size_t blockRows = blockSize/rowSize > 0 ? blockSize/rowSize : 1;
+    size_t nBlocks = memoryBudget/(blockRows*rowSize);
+    if(!allocateBlocks(writer, blockSize, nBlocks < 2 ? 2 : nBlocks)) {
+        fmi4c_printMessage("Failed to allocate result buffers");
+        setFailed(writer);
+        return false;
+    }
+    fmi4c_mutexInit(&writer->mutex);
+    fmi4c_condInit(&writer->blockReady);
+    fmi4c_condInit(&writer->blockFree);
+    writer->async = fmi4c_threadCreate(&writer->thread, writerThread, writer);
+    if(!writer->async) {
+        fmi4c_condDestroy(&writer->blockReady);
+        fmi4c_condDestroy(&writer->blockFree);
+        fmi4c_mutexDestroy(&writer->mutex);
+    }
+    return writer->async;
+}
+
+//! @brief Appends one row of results
+//! @param time Time of the row
+//! @param values One value per variable
+//! @returns False if writing failed (at this or an earlier row)
+bool fmi4c_writeResult(fmi4cResultWriter *writer, double time, const double *values)
+{
+    double *row = writer->block+writer->nBlockRows*writer->nColumns;
+    row[0] = time;
+    memcpy(row+1, values, (writer->nColumns-1)*sizeof(double));
+    ++writer->nRows;
+    if(++writer->nBlockRows == writer->blockCapacity) {
+        return flushBlock(writer);
+    }
+    return !hasFailed(writer);
+}
+
+//! @brief Returns the number of rows written so far
+size_t fmi4c_getResultNumberOfRows(fmi4cResultWriter *writer)
+{
+    return writer->nRows;
+}
+
+//! @brief Returns statistics about buffering and writing, must be called from the thread writing rows
+void fmi4c_getResultWriterStatistics(fmi4cResultWriter *writer, fmi4cResultWriterStatistics *statistics)
+{
+    if(writer->async) {
+        fmi4c_mutexLock(&writer->mutex);
+    }
+    *statistics = writer->statistics;
+    if(writer->async) {
+        fmi4c_mutexUnlock(&writer->mutex);
+    }
+}
+
+//! @brief Writes buffered rows, completes the file and frees the writer
+//! In asynchronous mode, this waits until the writing thread has written all blocks.
+//! @returns False if any part of the results could not be written
+bool fmi4c_closeResultWriter(fmi4cResultWriter *writer)
+{
+    if(writer == NULL) {
+        return false;
+    }
+    bool ok = flushBlock(writer);
+    if(writer->async) {
+        // All published blocks are written before the thread exits
+        fmi4c_mutexLock(&writer->mutex);
+        fmi4c_atomicStoreRelease(&writer->stopping, 1);
+        fmi4c_condSignal(&writer->blockReady);
+        fmi4c_mutexUnlock(&writer->mutex);
+        fmi4c_threadJoin(writer->thread);
+        fmi4c_condDestroy(&writer->blockReady);
+        fmi4c_condDestroy(&writer->blockFree);
+        fmi4c_mutexDestroy(&writer->mutex);
+        writer->async = false;
+        ok = ok && !hasFailed(writer);
+    }
+#ifdef FMI4C_WITH_ZLIB
+    if(writer->format == fmi4cResultMat4Compressed) {
+        ok = ok && deflateBytes(writer, NULL, 0, true);
+    }
+#endif
+    if(writer->format != fmi4cResultCsv) {
+        ok = ok && updateMatHeader(writer);
+    }
+    ok = (fclose(writer->file) == 0) && ok;
+    writer->file = NULL;
+    freeResultWriter(writer);
+    return ok;
+}
@@ -128,6 +128,7 @@ fmi2Status fmi2SetReal(fmi2Component c, const fmi2ValueReference vr[], size_t nv
         switch(vr[i]) {
         case VR_X:
             fmu->x = value[i];
+            fmu->xold = value[i];   //Restart integration from the new value
             break;
         case VR_DX:
             fmu->dx = value[i];
@@ -316,23 +317,32 @@ fmi2Status fmi2DoStep(fmi2Component c, fmi2Real currentCommunicationPoint, fmi2R
 
 fmi2Status fmi2GetFMUstate(fmi2Component c,
                            fmi2FMUstate* FMUstate) {
-    UNUSED(c);
-    UNUSED(FMUstate);
-    return fmi2Warning;
+    fmuContext *fmu = (fmuContext *)c;
+
+    //Allocate a new state, or overwrite the existing one
+    if(*FMUstate == NULL) {
+        *FMUstate = malloc(sizeof(fmuContext));
+        if(*FMUstate == NULL) {
+            return fmi2Error;
+        }
+    }
+    memcpy(*FMUstate, fmu, sizeof(fmuContext));
+    return fmi2OK;
 }
 
 fmi2Status fmi2SetFMUstate(fmi2Component c,
                            fmi2FMUstate FMUstate) {
-    UNUSED(c);
-    UNUSED(FMUstate);
-    return fmi2Warning;
+    fmuContext *fmu = (fmuContext *)c;
+    memcpy(fmu, FMUstate, sizeof(fmuContext));
+    return fmi2OK;
 }
 
 fmi2Status fmi2FreeFMUstate(fmi2Component c,
                             fmi2FMUstate* FMUstate) {
     UNUSED(c);
-    UNUSED(FMUstate);
-    return fmi2Warning;
+    free(*FMUstate);
+    *FMUstate = NULL;
+    return fmi2OK;
 }
 
 fmi2Status fmi2SerializedFMUstateSize(fmi2Component c,
@@ -340,8 +350,8 @@ fmi2Status fmi2SerializedFMUstateSize(fmi2Component c,
                                       size_t* size) {
     UNUSED(c);
     UNUSED(FMUstate);
-    UNUSED(size);
-    return fmi2Warning;
+    *size = 4*sizeof(fmi2Real);
+    return fmi2OK;
 }
 
 fmi2Status fmi2SerializeFMUstate(fmi2Component c,
@@ -349,21 +359,36 @@ fmi2Status fmi2SerializeFMUstate(fmi2Component c,
                                  fmi2Byte serializedState[],
                                  size_t size) {
     UNUSED(c);
-    UNUSED(FMUstate);
-    UNUSED(serializedState);
-    UNUSED(size);
-    return fmi2Warning;
+    fmuContext *state = (fmuContext *)FMUstate;
+    fmi2Real values[4] = { state->dx, state->dxold, state->x, state->xold };
+    if(size < sizeof(values)) {
+        return fmi2Error;
+    }
+    memcpy(serializedState, values, sizeof(values));
+    return fmi2OK;
 }
 
 fmi2Status fmi2DeSerializeFMUstate(fmi2Component c,
                                    const fmi2Byte serializedState[],
                                    size_t size,
                                    fmi2FMUstate* FMUstate) {
-    UNUSED(c);
-    UNUSED(serializedState);
-    UNUSED(size);
-    UNUSED(FMUstate);
-    return fmi2Warning;
+    fmi2Real values[4];
+    if(size < sizeof(values)) {
+        return fmi2Error;
+    }
+    memcpy(values, serializedState, sizeof(values));
+
+    //Only the variables are serialized, the rest is taken from the instance
+    fmi2Status status = fmi2GetFMUstate(c, FMUstate);
+    if(status != fmi2OK) {
+        return status;
+    }
+    fmuContext *state = (fmuContext *)*FMUstate;
+    state->dx = values[0];
+    state->dxold = values[1];
+    state->x = values[2];
+    state->xold = values[3];
+    return fmi2OK;
 }
 
 fmi2Status fmi2GetDirectionalDerivative(fmi2Component c,
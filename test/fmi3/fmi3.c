@@ -8,6 +8,9 @@
 
 #define VR_DX 1
 #define VR_X 2
+#define VR_X_SAMPLED 3
+#define VR_FAST_CLOCK 10
+#define VR_SLOW_CLOCK 11
 
 typedef struct {
     fmi3String instanceName;
@@ -16,11 +19,15 @@ typedef struct {
     fmi3InstanceEnvironment fmi3InstanceEnvironment;
     fmi3LogMessageCallback logger;
     fmi3IntermediateUpdateCallback intermediateUpdate;
+    fmi3LockPreemptionCallback lockPreemption;
+    fmi3UnlockPreemptionCallback unlockPreemption;
     bool loggingOn;
     fmi3Float64 dx; //Input
     fmi3Float64 dxold; //Delayed variable(internal)
     fmi3Float64 x; //Output(integrated value)
     fmi3Float64 xold; //Delayed variable(internal)
+    fmi3Float64 xSampled; //Local variable(sampled by slow clock)
+    fmi3Float64 lastFastTime; //Last activation of fast clock(internal)
 } fmuContext;
 
 
@@ -106,20 +113,24 @@ fmi3Instance fmi3InstantiateScheduledExecution(fmi3String instanceName,
                                                fmi3Boolean loggingOn,
                                                fmi3InstanceEnvironment instanceEnvironment,
                                                fmi3LogMessageCallback logMessage,
-                                               fmi3ClockUpdateCallback intermediateUpdate,
+                                               fmi3ClockUpdateCallback clockUpdate,
                                                fmi3LockPreemptionCallback lockPreemption,
                                                fmi3UnlockPreemptionCallback unlockPreemption) {
-    UNUSED(instanceName);
-    UNUSED(instantiationToken);
-    UNUSED(resourcePath);
     UNUSED(visible);
-    UNUSED(loggingOn);
-    UNUSED(instanceEnvironment);
-    UNUSED(logMessage);
-    UNUSED(intermediateUpdate);
-    UNUSED(lockPreemption);
-    UNUSED(unlockPreemption);
-    return NULL;
+    UNUSED(clockUpdate);    //Only constant clocks, no clock updates
+
+    fmuContext *fmu = calloc(1, sizeof(fmuContext));
+
+    fmu->instanceName = _strdup(instanceName);
+    fmu->instantiationToken = _strdup(instantiationToken);
+    fmu->resourcePath = resourcePath;
+    fmu->fmi3InstanceEnvironment = instanceEnvironment;
+    fmu->logger = logMessage;
+    fmu->lockPreemption = lockPreemption;
+    fmu->unlockPreemption = unlockPreemption;
+    fmu->loggingOn = loggingOn;
+
+    return fmu;
 }
 
 void fmi3FreeInstance(fmi3Instance instance)
@@ -139,13 +150,14 @@ fmi3Status fmi3EnterInitializationMode(fmi3Instance instance,
 {
     UNUSED(toleranceDefined);
     UNUSED(tolerance);
-    UNUSED(startTime);
     UNUSED(stopTimeDefined);
     UNUSED(stopTime);
     fmuContext *fmu = (fmuContext*)instance;
     fmu->x = 0;
     fmu->xold = 0;
     fmu->dxold = 0;
+    fmu->xSampled = 0;
+    fmu->lastFastTime = startTime;
     return fmi3OK;
 }
 
@@ -189,6 +201,9 @@ fmi3Status fmi3GetFloat64(fmi3Instance instance,
         case VR_DX:
             values[i] = fmu->dx;
             break;
+        case VR_X_SAMPLED:
+            values[i] = fmu->xSampled;
+            break;
         default:
             status = fmi3Warning;  // Non-existing value reference;
         }
@@ -210,6 +225,7 @@ fmi3Status fmi3SetFloat64(fmi3Instance instance,
         switch(valueReferences[i]) {
         case VR_X:
             fmu->x = values[i];
+            fmu->xold = values[i];  //Restart integration from the new value
             break;
         case VR_DX:
             fmu->dx = values[i];
@@ -696,6 +712,35 @@ fmi3Status fmi3DoStep(fmi3Instance instance,
     return fmi3OK;
 }
 
+fmi3Status fmi3ActivateModelPartition(fmi3Instance instance,
+                                      fmi3ValueReference clockReference,
+                                      fmi3Float64 activationTime)
+{
+    fmuContext *fmu =(fmuContext *)instance;
+    fmi3Status status = fmi3OK;
+
+    if(fmu->lockPreemption != NULL) {
+        fmu->lockPreemption();
+    }
+    switch(clockReference) {
+    case VR_FAST_CLOCK:
+        //Integrate(forward Euler) since last activation
+        fmu->x += (activationTime-fmu->lastFastTime)*fmu->dx;
+        fmu->lastFastTime = activationTime;
+        break;
+    case VR_SLOW_CLOCK:
+        fmu->xSampled = fmu->x;
+        break;
+    default:
+        status = fmi3Error;  // Non-existing clock
+    }
+    if(fmu->unlockPreemption != NULL) {
+        fmu->unlockPreemption();
+    }
+
+    return status;
+}
+
 fmi3Status fmi3UpdateDiscreteStates(fmi3Instance instance,
                                     fmi3Boolean* needsDiscreteStatesUpdate,
                                     fmi3Boolean* terminateSimulation,
@@ -742,23 +787,32 @@ fmi3Status fmi3GetVariableDependencies(fmi3Instance instance,
 
 fmi3Status fmi3GetFMUState(fmi3Instance instance,
                            fmi3FMUState* FMUState) {
-    UNUSED(instance);
-    UNUSED(FMUState);
-    return fmi3Warning;
+    fmuContext *fmu = (fmuContext *)instance;
+
+    //Allocate a new state, or overwrite the existing one
+    if(*FMUState == NULL) {
+        *FMUState = malloc(sizeof(fmuContext));
+        if(*FMUState == NULL) {
+            return fmi3Error;
+        }
+    }
+    memcpy(*FMUState, fmu, sizeof(fmuContext));
+    return fmi3OK;
 }
 
 fmi3Status fmi3SetFMUState(fmi3Instance instance,
                            fmi3FMUState FMUState) {
-    UNUSED(instance);
-    UNUSED(FMUState);
-    return fmi3Warning;
+    fmuContext *fmu = (fmuContext *)instance;
+    memcpy(fmu, FMUState, sizeof(fmuContext));
+    return fmi3OK;
 }
 
 fmi3Status fmi3FreeFMUState(fmi3Instance instance,
                             fmi3FMUState* FMUState) {
     UNUSED(instance);
-    UNUSED(FMUState);
-    return fmi3Warning;
+    free(*FMUState);
+    *FMUState = NULL;
+    return fmi3OK;
 }
 
 fmi3Status fmi3SerializedFMUStateSize(fmi3Instance instance,
@@ -766,8 +820,8 @@ fmi3Status fmi3SerializedFMUStateSize(fmi3Instance instance,
                                       size_t* size) {
     UNUSED(instance);
     UNUSED(FMUState);
-    UNUSED(size);
-    return fmi3Warning;
+    *size = 6*sizeof(fmi3Float64);
+    return fmi3OK;
 }
 
 fmi3Status fmi3SerializeFMUState(fmi3Instance instance,
@@ -775,21 +829,38 @@ fmi3Status fmi3SerializeFMUState(fmi3Instance instance,
                                  fmi3Byte serializedState[],
                                  size_t size) {
     UNUSED(instance);
-    UNUSED(FMUState);
-    UNUSED(serializedState);
-    UNUSED(size);
-    return fmi3Warning;
+    fmuContext *state = (fmuContext *)FMUState;
+    fmi3Float64 values[6] = { state->dx, state->dxold, state->x, state->xold, state->xSampled, state->lastFastTime };
+    if(size < sizeof(values)) {
+        return fmi3Error;
+    }
+    memcpy(serializedState, values, sizeof(values));
+    return fmi3OK;
 }
 
 fmi3Status fmi3DeserializeFMUState(fmi3Instance instance,
                                    const fmi3Byte serializedState[],
                                    size_t size,
                                    fmi3FMUState* FMUState) {
-    UNUSED(instance);
-    UNUSED(serializedState);
-    UNUSED(size);
-    UNUSED(FMUState);
-    return fmi3Warning;
+    fmi3Float64 values[6];
+    if(size < sizeof(values)) {
+        return fmi3Error;
+    }
+    memcpy(values, serializedState, sizeof(values));
+
+    //Only the variables are serialized, the rest is taken from the instance
+    fmi3Status status = fmi3GetFMUState(instance, FMUState);
+    if(status != fmi3OK) {
+        return status;
+    }
+    fmuContext *state = (fmuContext *)*FMUState;
+    state->dx = values[0];
+    state->dxold = values[1];
+    state->x = values[2];
+    state->xold = values[3];
+    state->xSampled = values[4];
+    state->lastFastTime = values[5];
+    return fmi3OK;
 }
 
 fmi3Status fmi3GetDirectionalDerivative(fmi3Instance instance,
@@ -850,11 +921,22 @@ fmi3Status fmi3GetIntervalDecimal(fmi3Instance instance,
                                   fmi3Float64 intervals[],
                                   fmi3IntervalQualifier qualifiers[]) {
     UNUSED(instance);
-    UNUSED(valueReferences);
-    UNUSED(nValueReferences);
-    UNUSED(intervals);
-    UNUSED(qualifiers);
-    return fmi3Warning;
+    fmi3Status status = fmi3OK;
+    for(size_t i=0; i<nValueReferences; ++i) {
+        qualifiers[i] = fmi3IntervalUnchanged;
+        switch(valueReferences[i]) {
+        case VR_FAST_CLOCK:
+            intervals[i] = 0.01;
+            break;
+        case VR_SLOW_CLOCK:
+            intervals[i] = 0.1;
+            break;
+        default:
+            qualifiers[i] = fmi3IntervalNotYetKnown;
+            status = fmi3Warning;  // Non-existing value reference;
+        }
+    }
+    return status;
 }
 
 fmi3Status fmi3GetIntervalFraction(fmi3Instance instance,
@@ -8,17 +8,30 @@
 #endif
 
 #include "fmi4c.h"
+#include "fmi4c_logger.h"
+#include "fmi4c_remote.h"
 #include "fmi4c_common.h"
 #include "fmi4c_test.h"
 #include "fmi4c_test_fmi1.h"
 #include "fmi4c_test_fmi2.h"
 #include "fmi4c_test_fmi3.h"
 #include "fmi4c_test_tlm.h"
+#include "fmi4c_test_master.h"
+#include "fmi4c_test_parareal.h"
+#include "fmi4c_test_checkpoint.h"
+#include "fmi4c_test_ensemble.h"
+#include "fmi4c_test_simulation.h"
+#include "fmi4c_test_sampler.h"
+#include "fmi4c_test_events.h"
+#include "fmi4c_test_jacobian.h"
+#include "fmi4c_test_solver.h"
+#include "fmi4c_test_logger.h"
 
 int numOutputs = 0;
-FILE* outputFile = NULL;
+fmi4cResultWriter *resultWriter = NULL;
 unsigned int outputRefs[VAR_MAX];
 int logLevel = 0;
+fmi4cSolverMethod solverMethod = fmi4cSolverEuler;
 
 //Default experiment settings (may be overwritten by default experiment in FMU)
 static double startTime = 0;
@@ -27,36 +40,215 @@ static double stopTime = 1;
 static double tolerance = 0;
 
 const char* outputCsvPath = NULL;
-size_t nInterpolators = 0;
-namedData interpolationData[20];
-size_t dataSize = 0;
+static bool asyncOutput = false;
+static size_t outputMemoryBudget = 0;
+static fmi4cResultSampler *resultSampler = NULL;
+static double sampleInterval = 0;
+static double deadband = NAN;
+static bool aggregateOutputs = false;
+fmi4cInputSignals *inputSignals = NULL;
+size_t numInputs = 0;
+double *inputValues = NULL;
+double *inputDerivatives = NULL;
+unsigned int *inputRefs = NULL;
+int *inputOrders = NULL;
+static fmi4cInterpolationMethod interpolationMethod = fmi4cInterpolationLinear;
 
-double interpolate(namedData *timeData, namedData *data, double time, size_t nData) {
-    size_t i1 = 0;
-    size_t i2 = 1;
-    while(i1 < nData && !(timeData->data[i1] <= time && timeData->data[i2] > time)) {
-        ++i1;
-        ++i2;
+//Creates the result writer for the output file, in the format given by its file name extension
+//(and the sampler in front of it, if the output is decimated, recorded on changes or aggregated)
+void openResultFile(int nVariables, const char **names)
+{
+    resultWriter = NULL;
+    if(outputCsvPath == NULL || strcmp(outputCsvPath, "") == 0) {
+        return;
+    }
+    size_t nColumns = (size_t)nVariables;
+    if(sampleInterval > 0 || !isnan(deadband) || aggregateOutputs) {
+        resultSampler = fmi4c_createResultSampler(nColumns, names);
+        if(resultSampler == NULL) {
+            printf("Failed to create result sampler\n");
+            return;
+        }
+        fmi4c_setResultSamplingInterval(resultSampler, (sampleInterval > 0 || isnan(deadband)) ? sampleInterval : INFINITY);
+        for(size_t i=0; i<nColumns; ++i) {
+            fmi4c_setResultChannelDeadband(resultSampler, i, deadband);
+            fmi4c_setResultChannelAggregation(resultSampler, i, aggregateOutputs);
+        }
+        nColumns = fmi4c_getResultSamplerNumberOfColumns(resultSampler);
+        names = fmi4c_getResultSamplerColumnNames(resultSampler);
+    }
+    if(names != NULL) {
+        resultWriter = fmi4c_createResultWriter(outputCsvPath, fmi4c_getResultFormatFromFileName(outputCsvPath), nColumns, names);
+    }
+    if(resultWriter != NULL && asyncOutput && !fmi4c_setResultWriterAsynchronous(resultWriter, outputMemoryBudget)) {
+        printf("Failed to enable asynchronous result writing\n");
+    }
+    if(resultSampler != NULL && (resultWriter == NULL || !fmi4c_setResultSamplerWriter(resultSampler, resultWriter))) {
+        fmi4c_closeResultWriter(resultWriter);
+        fmi4c_freeResultSampler(resultSampler);
+        resultWriter = NULL;
+        resultSampler = NULL;
+    }
+}
+
+//Passes one row of results to the sampler, or directly to the result writer
+//(event is true if an event follows, so that the rows before and after it are kept)
+void writeResult(double time, const double *values, bool event)
+{
+    if(resultSampler != NULL) {
+        fmi4c_sampleResult(resultSampler, time, values, event);
+    }
+    else {
+        fmi4c_writeResult(resultWriter, time, values);
+    }
+}
+
+//Writes all remaining results (also registered to run at exit, so that results are not lost on errors)
+void closeResultFile(void)
+{
+    if(resultWriter == NULL) {
+        return;
+    }
+    if(resultSampler != NULL) {
+        fmi4c_flushResultSampler(resultSampler);
+        fmi4cResultSamplerStatistics samplerStatistics;
+        fmi4c_getResultSamplerStatistics(resultSampler, &samplerStatistics);
+        printf("  Result sampler: %zu rows of %zu samples (%zu on the grid, %zu changes, %zu at events)\n",
+               samplerStatistics.numberOfRows, samplerStatistics.numberOfSamples, samplerStatistics.numberOfGridRows,
+               samplerStatistics.numberOfChangeRows, samplerStatistics.numberOfEventRows);
+        fmi4c_freeResultSampler(resultSampler);
+        resultSampler = NULL;
+    }
+    fmi4cResultWriterStatistics statistics;
+    fmi4c_getResultWriterStatistics(resultWriter, &statistics);
+    size_t nRows = fmi4c_getResultNumberOfRows(resultWriter);
+    if(!fmi4c_closeResultWriter(resultWriter)) {
+        printf("Failed to write result file: %s\n", outputCsvPath);
+    }
+    else if(asyncOutput) {
+        printf("  Result writer: %zu rows, %zu kB buffers, %zu blocks written before closing in %.3f ms, at most %zu queued, %zu stalls (%.3f ms)\n",
+               nRows, statistics.bufferBytes/1024, statistics.numberOfBlocks, 1e3*statistics.writeTime,
+               statistics.maxQueuedBlocks, statistics.numberOfStalls, 1e3*statistics.stallTime);
+    }
+    resultWriter = NULL;
+}
+
+//Interpolates all signals from the input file into inputValues (and their time derivatives into inputDerivatives)
+bool interpolateInputs(double time, bool derivatives)
+{
+    if(inputSignals == NULL) {
+        return false;
+    }
+    return fmi4c_getInputSignalValuesAndDerivatives(inputSignals, time, inputValues, derivatives ? inputDerivatives : NULL);
+}
+
+//Interpolates one signal from the input file, or returns the default value if there is no such signal
+double getInputValue(const char *name, double time, double defaultValue)
+{
+    int signal = (inputSignals != NULL) ? fmi4c_getInputSignalIndex(inputSignals, name) : -1;
+    if(signal < 0) {
+        return defaultValue;
+    }
+    return fmi4c_getInputSignalValue(inputSignals, (size_t)signal, time);
+}
+
+//Creates and initializes one instance of an FMI 2 or FMI 3 FMU
+void *createInstance(fmuHandle *fmu, bool modelExchange, double startTime, double stopTime)
+{
+    if(fmi4c_getFmiVersion(fmu) == fmiVersion2) {
+        fmi2InstanceHandle *instance = fmi2_instantiate(fmu, modelExchange ? fmi2ModelExchange : fmi2CoSimulation, fmi4c_loggerFmi2, calloc, free, NULL, NULL, fmi2False, fmi2True);
+        if(instance == NULL ||
+           fmi2_setupExperiment(instance, fmi2False, 0, startTime, fmi2True, stopTime) != fmi2OK ||
+           fmi2_enterInitializationMode(instance) != fmi2OK ||
+           fmi2_exitInitializationMode(instance) != fmi2OK) {
+            return NULL;
+        }
+        return instance;
+    }
+    fmi3InstanceHandle *instance;
+    if(modelExchange) {
+        instance = fmi3_instantiateModelExchange(fmu, fmi3False, fmi3True, fmu, fmi4c_loggerFmi3);
     }
+    else {
+        instance = fmi3_instantiateCoSimulation(fmu, fmi3False, fmi3True, fmi3False, fmi3False, NULL, 0, fmu, fmi4c_loggerFmi3, NULL);
+    }
+    if(instance == NULL ||
+       fmi3_enterInitializationMode(instance, fmi3False, 0, startTime, fmi3True, stopTime) != fmi3OK ||
+       fmi3_exitInitializationMode(instance) != fmi3OK) {
+        return NULL;
+    }
+    return instance;
+}
 
-    double x1 = data->data[i1];
-    double x2 = data->data[i2];
-    double t1 = timeData->data[i1];
-    double t2 = timeData->data[i2];
+void freeInstance(fmuHandle *fmu, void *instance)
+{
+    if(fmi4c_getFmiVersion(fmu) == fmiVersion2) {
+        fmi2_terminate((fmi2InstanceHandle*)instance);
+        fmi2_freeInstance((fmi2InstanceHandle*)instance);
+    }
+    else {
+        fmi3_terminate((fmi3InstanceHandle*)instance);
+        fmi3_freeInstance((fmi3InstanceHandle*)instance);
+    }
+}
+
+//Returns the output (integrated value) of an instance of the test FMUs
+double getOutput(fmuHandle *fmu, void *instance)
+{
+    double value = 0;
+    if(fmi4c_getFmiVersion(fmu) == fmiVersion2) {
+        fmi2ValueReference vr = VR_X;
+        fmi2_getReal((fmi2InstanceHandle*)instance, &vr, 1, &value);
+    }
+    else {
+        fmi3ValueReference vr = VR_X;
+        fmi3_getFloat64((fmi3InstanceHandle*)instance, &vr, 1, &value, 1);
+    }
+    return value;
+}
 
-    return x1 + (x2-x1)*(time-t1)/(t2-t1);
+//Sets the input (derivative) of an instance of the test FMUs
+void setInput(fmuHandle *fmu, void *instance, double value)
+{
+    if(fmi4c_getFmiVersion(fmu) == fmiVersion2) {
+        fmi2ValueReference vr = VR_DX;
+        fmi2_setReal((fmi2InstanceHandle*)instance, &vr, 1, &value);
+    }
+    else {
+        fmi3ValueReference vr = VR_DX;
+        fmi3_setFloat64((fmi3InstanceHandle*)instance, &vr, 1, &value, 1);
+    }
 }
 
+static void closeInputFile(void)
+{
+    fmi4c_closeInputSignals(inputSignals);
+    free(inputValues);
+    free(inputDerivatives);
+    free(inputRefs);
+    free(inputOrders);
+    inputSignals = NULL;
+    inputValues = NULL;
+    inputDerivatives = NULL;
+    inputRefs = NULL;
+    inputOrders = NULL;
+    numInputs = 0;
+}
 
 void printUsage() {
     printf("Usage: fmi4ctest <options> <fmu_file(s)>\n");
     printf("Options:                 Meaning:\n");
-    printf("-i, --input              Path to input CSV file\n");
-    printf("-o, --output             Path to output CSV file\n");
+    printf("-i, --input              Path to input file (CSV, or MAT-file with the .mat extension)\n");
+    printf("-o, --output             Path to output file (CSV, MAT-file with the .mat extension, or compressed MAT-file with .mat.gz)\n");
+    printf("-u, --interpolation=METHOD Interpolation of inputs: \n"
+           "                         linear: linear interpolation (default)\n"
+           "                         zoh: zero-order hold\n"
+           "                         hermite: cubic Hermite splines (smooth, also sets input derivatives when supported)\n");
     printf("-m, --mode               Simulation mode: \n"
            "                         auto: use co-simulation if possible, else model excghange (defualt)\n"
            "                         me: force model excghange mode\n"
-           "                         cs: force co-simulation mode\n");
+           "                         cs: force co-simulation mode\n"
+           "                         se: scheduled execution (FMI 3 only)\n");
     printf("-h, --stepsize=TIMESTEP  Specify communication step size\n");
     printf("-s, --stoptime=STOPTIME  Specify simulation stop time\n");
     printf("-l, --loglevel=LOGLEVEL  Specify log level: \n"
@@ -66,7 +258,39 @@ void printUsage() {
            "                         3: fatal, errors & warnings\n"
            "                         4: fatal, errors, warning & info\n"
            "                         5: fatal, errors, warnings, info & debug.\n");
+    printf("-x, --solver=SOLVER      Solver for model exchange: \n"
+           "                         euler: forward Euler, fixed step (default)\n"
+           "                         rk4: classic Runge-Kutta, fixed step\n"
+           "                         dopri5: Dormand-Prince 5(4), adaptive step\n"
+           "                         cashkarp: Cash-Karp 5(4), adaptive step\n"
+           "                         cvode: CVODE BDF, adaptive step for stiff models\n");
     printf("-t, --tlm                Run a TLM test (requires two FMUs)\n");
+    printf("-n, --instances=N        Simulate a chain of N co-simulation instances with the master\n");
+    printf("-j, --threads=N          Number of master threads (0 = number of processors, default)\n");
+    printf("-g, --gauss-seidel       Use Gauss-Seidel instead of Jacobi stepping in the master\n");
+    printf("-w, --work-stealing      Use work-stealing placement of instances in the master\n");
+    printf("-e, --tolerance=TOL      Use adaptive communication steps with rollback in the master, with this tolerance\n");
+    printf("-a, --async              Step the chain of instances with asynchronous steps instead of the master\n");
+    printf("-p, --host=EXECUTABLE    Run each instance of the chain in a separate host process (Linux only)\n");
+    printf("-b, --isolation=MODE     Load the FMU binary separately for each instance: \n"
+           "                         none: share the binary between instances (default)\n"
+           "                         namespace: load into a new link-map namespace\n"
+           "                         copy: load a temporary copy of the binary\n");
+    printf("-k, --parareal=SLICES    Benchmark Parareal with this number of time slices against serial stepping\n");
+    printf("-c, --checkpoints=BUDGET Checkpoint every step and verify rollbacks, with this memory budget in bytes (0 = unlimited)\n");
+    printf("-f, --ensemble=SAMPLES   Benchmark a fork-based ensemble with this number of samples (Linux only)\n");
+    printf("-d, --sample-interval=INTERVAL Only write outputs at this interval, and before and after events\n");
+    printf("-y, --deadband=DEADBAND  Also write outputs when a variable has changed by more than this since the last row\n");
+    printf("-z, --aggregate          Add min, max and mean columns over each output interval for all outputs\n");
+    printf("-q, --async-output=BUDGET Write the output file on a background thread, with this memory budget in bytes (0 = default)\n");
+    printf("-r, --realtime           Release clock activations in real time in scheduled execution mode\n");
+    printf("-v, --simulate           Simulate in one call with a built-in input table, and compare with step-by-step simulation\n");
+    printf("    --events             Simulate the bouncing ball test FMU and compare the located events with the analytic ones\n");
+    printf("    --jacobian           Evaluate the sparse Jacobians of the linear system test FMU and compare them with the known ones\n");
+    printf("    --evaluations        Compare the derivative evaluations of the solver with forward Euler at the same accuracy\n");
+    printf("    --test-sampler       Test the result sampler with known samples (no FMU required)\n");
+    printf("    --test-logger        Test the asynchronous logger with messages from several threads (no FMU required)\n");
+    printf("    --test-tlm           Test a TLM delay line with known waves (no FMU required)\n");
 }
 
 void messageCallback(const char* msg)
@@ -75,6 +299,11 @@ void messageCallback(const char* msg)
     printf("\n");
 }
 
+void freeLogger()
+{
+    fmi4c_freeLogger(fmi4c_getActiveLogger());
+}
+
 int main(int argc, char *argv[])
 {
     if(argc == 1) {
@@ -85,11 +314,31 @@ int main(int argc, char *argv[])
     //Parse flags
     bool forceModelExchange = false;
     bool forceCosimulation = false;
+    bool forceScheduledExecution = false;
+    bool realTime = false;
     bool testTLM = false;
     bool overrideStopTime = false;
     double stopTimeOverride=0;
     bool overrideTimeStep = false;
     double timeStepOverride=0;
+    int nInstances = 0;
+    int nThreads = 0;
+    int nSlices = 0;
+    int nSamples = 0;
+    bool testCheckpoint = false;
+    bool testOneCall = false;
+    bool testResultSampler = false;
+    bool testAsyncLogger = false;
+    bool testTLMLine = false;
+    bool testEventLocation = false;
+    bool testJacobians = false;
+    bool testEvaluations = false;
+    size_t checkpointBudget = 0;
+    bool gaussSeidel = false;
+    bool workStealing = false;
+    bool async = false;
+    const char* hostExecutable = NULL;
+    fmi4cBinaryIsolation isolation = fmi4cIsolationNone;
     int i=1;
     int nFlags = 0;
     const char* inputCsvPath = "";
@@ -109,6 +358,9 @@ int main(int argc, char *argv[])
             else if(!strcmp(argv[i+1], "cs")) {
                 forceCosimulation = true;
             }
+            else if(!strcmp(argv[i+1], "se")) {
+                forceScheduledExecution = true;
+            }
             else if(strcmp(argv[i+1], "auto")) {   
                 printf("Error: Unknown mode: %s\n",argv[i+1]);
                 printUsage();
@@ -164,8 +416,206 @@ int main(int argc, char *argv[])
             }
             nFlags+=2;
         }
+        else if(!strcmp(argv[i],"-x") || !strcmp(argv[i], "--solver")) {
+            ++i;
+            if(argc<=i || argv[i][0] == '-')   {
+                printf("Error: Solver flag requires a value.");
+                printUsage();
+                exit(1);
+            }
+            if(!fmi4c_getSolverMethodByName(argv[i], &solverMethod)) {
+                printf("Error: Unknown solver: %s\n", argv[i]);
+                printUsage();
+                exit(1);
+            }
+            nFlags+=2;
+        }
+        else if(!strcmp(argv[i],"-u") || !strcmp(argv[i], "--interpolation")) {
+            ++i;
+            if(argc<=i || argv[i][0] == '-')   {
+                printf("Error: Interpolation flag requires a value.");
+                printUsage();
+                exit(1);
+            }
+            if(!fmi4c_getInterpolationMethodByName(argv[i], &interpolationMethod)) {
+                printf("Error: Unknown interpolation method: %s\n", argv[i]);
+                printUsage();
+                exit(1);
+            }
+            nFlags+=2;
+        }
+        else if(!strcmp(argv[i],"-n") || !strcmp(argv[i], "--instances")) {
+            ++i;
+            if(argc<=i || (sscanf(argv[i], "%i", &nInstances) != 1) || (nInstances <= 0)) {
+                printf("Error: Number of instances must be a positive integer.");
+                printUsage();
+                exit(1);
+            }
+            nFlags+=2;
+        }
+        else if(!strcmp(argv[i],"-g") || !strcmp(argv[i],"--gauss-seidel")) {
+            gaussSeidel = true;
+            ++nFlags;
+        }
+        else if(!strcmp(argv[i],"-w") || !strcmp(argv[i],"--work-stealing")) {
+            workStealing = true;
+            ++nFlags;
+        }
+        else if(!strcmp(argv[i],"-e") || !strcmp(argv[i], "--tolerance")) {
+            ++i;
+            if(argc<=i || (sscanf(argv[i], "%lf", &tolerance) != 1) || (tolerance <= 0)) {
+                printf("Error: Tolerance must be a positive number.");
+                printUsage();
+                exit(1);
+            }
+            nFlags+=2;
+        }
+        else if(!strcmp(argv[i],"-p") || !strcmp(argv[i], "--host")) {
+            ++i;
+            if(argc<=i || argv[i][0] == '-') {
+                printf("Error: Host flag requires an executable.");
+                printUsage();
+                exit(1);
+            }
+            hostExecutable = argv[i];
+            nFlags+=2;
+        }
+        else if(!strcmp(argv[i],"-b") || !strcmp(argv[i], "--isolation")) {
+            ++i;
+            if(argc<=i) {
+                printf("Error: Isolation flag requires a value.");
+                printUsage();
+                exit(1);
+            }
+            if(!strcmp(argv[i], "namespace")) {
+                isolation = fmi4cIsolationNamespace;
+            }
+            else if(!strcmp(argv[i], "copy")) {
+                isolation = fmi4cIsolationCopy;
+            }
+            else if(strcmp(argv[i], "none")) {
+                printf("Error: Unknown isolation mode: %s\n", argv[i]);
+                printUsage();
+                exit(1);
+            }
+            nFlags+=2;
+        }
+        else if(!strcmp(argv[i],"-k") || !strcmp(argv[i], "--parareal")) {
+            ++i;
+            if(argc<=i || (sscanf(argv[i], "%i", &nSlices) != 1) || (nSlices < 1)) {
+                printf("Error: Number of time slices must be a positive integer.");
+                printUsage();
+                exit(1);
+            }
+            nFlags+=2;
+        }
+        else if(!strcmp(argv[i],"-c") || !strcmp(argv[i], "--checkpoints")) {
+            ++i;
+            if(argc<=i || (sscanf(argv[i], "%zu", &checkpointBudget) != 1)) {
+                printf("Error: Checkpoint memory budget must be a non-negative integer.");
+                printUsage();
+                exit(1);
+            }
+            testCheckpoint = true;
+            nFlags+=2;
+        }
+        else if(!strcmp(argv[i],"-f") || !strcmp(argv[i], "--ensemble")) {
+            ++i;
+            if(argc<=i || (sscanf(argv[i], "%i", &nSamples) != 1) || (nSamples < 1)) {
+                printf("Error: Number of samples must be a positive integer.");
+                printUsage();
+                exit(1);
+            }
+            nFlags+=2;
+        }
+        else if(!strcmp(argv[i],"-q") || !strcmp(argv[i], "--async-output")) {
+            ++i;
+            if(argc<=i || (sscanf(argv[i], "%zu", &outputMemoryBudget) != 1)) {
+                printf("Error: Output memory budget must be a non-negative integer.");
+                printUsage();
+                exit(1);
+            }
+            asyncOutput = true;
+            nFlags+=2;
+        }
+        else if(!strcmp(argv[i],"-d") || !strcmp(argv[i], "--sample-interval")) {
+            ++i;
+            if(argc<=i || (sscanf(argv[i], "%lf", &sampleInterval) != 1) || !(sampleInterval > 0)) {
+                printf("Error: Sample interval must be a positive number.");
+                printUsage();
+                exit(1);
+            }
+            nFlags+=2;
+        }
+        else if(!strcmp(argv[i],"-y") || !strcmp(argv[i], "--deadband")) {
+            ++i;
+            if(argc<=i || (sscanf(argv[i], "%lf", &deadband) != 1) || !(deadband >= 0)) {
+                printf("Error: Deadband must be a non-negative number.");
+                printUsage();
+                exit(1);
+            }
+            nFlags+=2;
+        }
+        else if(!strcmp(argv[i],"-z") || !strcmp(argv[i],"--aggregate")) {
+            aggregateOutputs = true;
+            ++nFlags;
+        }
+        else if(!strcmp(argv[i],"-v") || !strcmp(argv[i],"--simulate")) {
+            testOneCall = true;
+            ++nFlags;
+        }
+        else if(!strcmp(argv[i],"--events")) {
+            testEventLocation = true;
+            ++nFlags;
+        }
+        else if(!strcmp(argv[i],"--jacobian")) {
+            testJacobians = true;
+            ++nFlags;
+        }
+        else if(!strcmp(argv[i],"--evaluations")) {
+            testEvaluations = true;
+            ++nFlags;
+        }
+        else if(!strcmp(argv[i],"--test-sampler")) {
+            testResultSampler = true;
+            ++nFlags;
+        }
+        else if(!strcmp(argv[i],"--test-logger")) {
+            testAsyncLogger = true;
+            ++nFlags;
+        }
+        else if(!strcmp(argv[i],"--test-tlm")) {
+            testTLMLine = true;
+            ++nFlags;
+        }
+        else if(!strcmp(argv[i],"-r") || !strcmp(argv[i],"--realtime")) {
+            realTime = true;
+            ++nFlags;
+        }
+        else if(!strcmp(argv[i],"-a") || !strcmp(argv[i],"--async")) {
+            async = true;
+            ++nFlags;
+        }
+        else if(!strcmp(argv[i],"-j") || !strcmp(argv[i], "--threads")) {
+            ++i;
+            if(argc<=i || (sscanf(argv[i], "%i", &nThreads) != 1) || (nThreads < 0)) {
+                printf("Error: Number of threads must be a non-negative integer.");
+                printUsage();
+                exit(1);
+            }
+            nFlags+=2;
+        }
         ++i;
     }
+    if(testResultSampler) {
+        return testSampler();
+    }
+    if(testAsyncLogger) {
+        return testLogger();
+    }
+    if(testTLMLine) {
+        return testTLMDelayLine();
+    }
     if(argc < 2+nFlags) {
         printUsage();
         exit(1);
@@ -195,10 +645,16 @@ int main(int argc, char *argv[])
         printf("  FMU to test: %s\n", fmuPath);
     }
     if(inputCsvPath != NULL && strcmp(inputCsvPath, "") != 0) {
-        printf("  Will read from input file: %s\n", inputCsvPath);
+        printf("  Will read from input file: %s (%s interpolation)\n", inputCsvPath, fmi4c_getInterpolationMethodName(interpolationMethod));
     }
     if(outputCsvPath != NULL && strcmp(outputCsvPath, "") != 0) {
-        printf("  Will write to output file: %s\n", outputCsvPath);
+        printf("  Will write to output file: %s%s\n", outputCsvPath, asyncOutput ? " (asynchronously)" : "");
+        if(sampleInterval > 0) {
+            printf("  Will write outputs every %g s%s\n", sampleInterval, aggregateOutputs ? " with min, max and mean" : "");
+        }
+        if(!isnan(deadband)) {
+            printf("  Will write outputs that change by more than %g\n", deadband);
+        }
     }
     if(forceModelExchange) {
         printf("  Will use model exchange mode\n");
@@ -206,15 +662,33 @@ int main(int argc, char *argv[])
     if(forceCosimulation) {
         printf("  Will use co-simulation mode\n");
     }
+    if(forceScheduledExecution) {
+        printf("  Will use scheduled execution mode%s\n", realTime ? " in real time" : "");
+    }
     if(testTLM) {
         printf("  Will run a TLM test with intermediate update\n");
     }
+    if(nInstances > 0) {
+        printf("  Will simulate %i instances with %s\n", nInstances, async ? "asynchronous steps" : "the co-simulation master");
+    }
+    if(hostExecutable != NULL) {
+        printf("  Will run instances in host processes: %s\n", hostExecutable);
+    }
+    if(isolation == fmi4cIsolationNamespace) {
+        printf("  Will load the FMU binary into a new namespace for each instance\n");
+    }
+    else if(isolation == fmi4cIsolationCopy) {
+        printf("  Will load a copy of the FMU binary for each instance\n");
+    }
     if(overrideStopTime) {
         printf("  Will use stop time: %f\n", stopTimeOverride);
     }
     if(overrideTimeStep) {
         printf("  Will use time step: %f\n", timeStepOverride);
     }
+    if(solverMethod != fmi4cSolverEuler) {
+        printf("  Will use solver: %s\n", fmi4c_getSolverMethodName(solverMethod));
+    }
     if(logLevel == 0) {
         printf("  Using log level 0 (no logging)\n");
     }
@@ -235,6 +709,15 @@ int main(int argc, char *argv[])
     }
 
     fmi4c_setMessageFunction(&messageCallback);
+
+    //Log messages from FMUs are formatted and printed asynchronously, and flushed on exit
+    fmi4cLogger *logger = fmi4c_createLogger(stdout, (fmi4cLogLevel)logLevel, 0);
+    if(logger != NULL) {
+        fmi4c_setActiveLogger(logger);
+        atexit(freeLogger);
+    }
+    atexit(closeResultFile);
+
     fmuHandle *fmu = fmi4c_loadFmu(fmuPath, "testfmu");
 
     if(fmu == NULL) {
@@ -242,6 +725,12 @@ int main(int argc, char *argv[])
         exit(1);
     }
 
+    if(isolation != fmi4cIsolationNone && !fmi4c_setFmuBinaryIsolation(fmu, isolation)) {
+        printf("Error: Binary isolation mode is not supported on this platform.\n");
+        fmi4c_freeFmu(fmu);
+        exit(1);
+    }
+
     fmiVersion_t version = fmi4c_getFmiVersion(fmu);
     printf("--- FMU data ---\n  FMI Version:        ");
     if(version == fmiVersion1) {
@@ -260,31 +749,21 @@ int main(int argc, char *argv[])
     }
 
     if(inputCsvPath != NULL && strcmp(inputCsvPath, "") != 0) {
-        FILE *inputFile = fopen(inputCsvPath, "r");
-        char lineStr[1024];
-        size_t lineNumber = 0;
-        while(fgets(lineStr , sizeof(lineStr) , inputFile) != NULL) {
-            lineStr[strcspn(lineStr, "\r\n")] = 0;
-            char* word = strtok(lineStr, ",");
-            int j=0;
-            while(word != NULL && strcmp(word, "")) {
-                if(lineNumber == 0) {
-                    namedData data;
-                    data.name = _strdup(word);
-                    interpolationData[nInterpolators] = data;
-                    ++nInterpolators;
-                }
-                else {
-                    interpolationData[j].data[lineNumber-1] = atof(word);
-                }
-                word = strtok(NULL, ",");
-
-                ++j;
-            }
-            lineNumber++;
+        inputSignals = fmi4c_openInputSignals(inputCsvPath);
+        if(inputSignals == NULL) {
+            printf("Failed to read input file: %s\n", inputCsvPath);
+            exit(1);
+        }
+        fmi4c_setInputSignalInterpolation(inputSignals, interpolationMethod);
+        numInputs = fmi4c_getNumberOfInputSignals(inputSignals);
+        inputValues = calloc(numInputs+1, sizeof(double));
+        inputDerivatives = calloc(numInputs+1, sizeof(double));
+        inputRefs = calloc(numInputs+1, sizeof(unsigned int));
+        inputOrders = calloc(numInputs+1, sizeof(int));
+        for(size_t i=0; i<numInputs; ++i) {
+            inputOrders[i] = 1;
         }
-        fclose(inputFile);
-        dataSize = lineNumber-1;
+        atexit(closeInputFile);
     }
 
     if(testTLM) {
@@ -307,15 +786,74 @@ int main(int argc, char *argv[])
             return 1;
         }
 
-#ifdef FMI4CTEST_NO_TLM
-        printf("FMI TLM support not available\n");
-        return 1;
-#else
         int retval = testFMI3TLM(fmu, fmu2, overrideStopTime, stopTimeOverride, overrideTimeStep, timeStepOverride);
         fmi4c_freeFmu(fmu);
         fmi4c_freeFmu(fmu2);
         return retval;
-#endif
+    }
+
+    if(forceScheduledExecution) {
+        if(version != fmiVersion3) {
+            printf("Can only test scheduled execution with FMI 3.\n");
+            fmi4c_freeFmu(fmu);
+            return 1;
+        }
+        int retval = testFMI3SE(fmu, realTime, overrideStopTime, stopTimeOverride, overrideTimeStep, timeStepOverride);
+        fmi4c_freeFmu(fmu);
+        return retval;
+    }
+
+    if(nSlices > 0) {
+        int retval = testParareal(fmu, nSlices, nThreads, overrideStopTime, stopTimeOverride, overrideTimeStep, timeStepOverride);
+        fmi4c_freeFmu(fmu);
+        return retval;
+    }
+
+    if(nSamples > 0) {
+        int retval = testEnsemble(fmuPath, fmu, nSamples, nThreads, overrideStopTime, stopTimeOverride, overrideTimeStep, timeStepOverride);
+        fmi4c_freeFmu(fmu);
+        return retval;
+    }
+
+    if(testOneCall) {
+        int retval = testSimulation(fmu, forceModelExchange, overrideStopTime, stopTimeOverride, overrideTimeStep, timeStepOverride);
+        fmi4c_freeFmu(fmu);
+        return retval;
+    }
+
+    if(testEventLocation) {
+        int retval = testEvents(fmu, overrideStopTime, stopTimeOverride, overrideTimeStep, timeStepOverride);
+        fmi4c_freeFmu(fmu);
+        return retval;
+    }
+
+    if(testJacobians) {
+        int retval = testJacobian(fmu);
+        fmi4c_freeFmu(fmu);
+        return retval;
+    }
+
+    if(testEvaluations) {
+        int retval = testSolverEvaluations(fmu);
+        fmi4c_freeFmu(fmu);
+        return retval;
+    }
+
+    if(testCheckpoint) {
+        int retval = testCheckpoints(fmu, checkpointBudget, overrideStopTime, stopTimeOverride, overrideTimeStep, timeStepOverride);
+        fmi4c_freeFmu(fmu);
+        return retval;
+    }
+
+    if(nInstances > 0) {
+        if(hostExecutable != NULL && !fmi4c_setFmuHostExecutable(fmu, hostExecutable)) {
+            printf("Error: Out-of-process instances are not supported on this platform.\n");
+            fmi4c_freeFmu(fmu);
+            return 1;
+        }
+        int retval = testMaster(fmu, nInstances, nThreads, gaussSeidel, workStealing, async, tolerance, overrideStopTime, stopTimeOverride, overrideTimeStep, timeStepOverride);
+        fmi4c_freeFmu(fmu);
+        return retval;
     }
 
     int retval;
@@ -2,25 +2,41 @@
 #define FMIC_TEST_H
 
 #include <stdio.h>
+#include "fmi4c_solver.h"
+#include "fmi4c_jacobian.h"
+#include "fmi4c_writer.h"
+#include "fmi4c_sampler.h"
+#include "fmi4c_input.h"
 
 #define VAR_MAX 1024
 
-typedef struct {
-    const char *name;
-    double data[1024];
-} namedData;
+#define VR_DX 1     //Input (derivative) of the test FMUs
+#define VR_X 2      //Output (integrated value) of the test FMUs
 
 extern int logLevel;
+extern fmi4cSolverMethod solverMethod;
 
-extern FILE *outputFile;
+extern fmi4cResultWriter *resultWriter;
 extern int numOutputs;
 extern unsigned int outputRefs[VAR_MAX];
 extern const char* outputCsvPath;
 
-extern size_t nInterpolators;
-extern namedData interpolationData[20];
-extern size_t dataSize;
-
-double interpolate(namedData *timeData, namedData *data, double time, size_t nData);
+extern fmi4cInputSignals *inputSignals;
+extern size_t numInputs;
+extern double *inputValues;
+extern double *inputDerivatives;
+extern unsigned int *inputRefs;
+extern int *inputOrders;
+
+void openResultFile(int nVariables, const char **names);
+void writeResult(double time, const double *values, bool event);
+void closeResultFile(void);
+bool interpolateInputs(double time, bool derivatives);
+double getInputValue(const char *name, double time, double defaultValue);
+
+void *createInstance(fmuHandle *fmu, bool modelExchange, double startTime, double stopTime);
+void freeInstance(fmuHandle *fmu, void *instance);
+double getOutput(fmuHandle *fmu, void *instance);
+void setInput(fmuHandle *fmu, void *instance, double value);
 
 #endif //FMIC_TEST.H
@@ -0,0 +1,226 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fmi4c.h"
+#include "fmi4c_checkpoint.h"
+#include "fmi4c_threads.h"
+#include "fmi4c_test.h"
+#include "fmi4c_test_checkpoint.h"
+
+//Sets the derivative input from the input file, or a unit derivative, and takes one step
+static bool doStep(fmuHandle *fmu, void *instance, double time, double stepSize)
+{
+    setInput(fmu, instance, getInputValue("dx", time, 1));
+    if(fmi4c_getFmiVersion(fmu) == fmiVersion2) {
+        return fmi2_doStep((fmi2InstanceHandle*)instance, time, stepSize, fmi2True) == fmi2OK;
+    }
+    bool eventEncountered, terminateSimulation, earlyReturn;
+    double lastT;
+    return fmi3_doStep((fmi3InstanceHandle*)instance, time, stepSize, fmi3True, &eventEncountered, &terminateSimulation, &earlyReturn, &lastT) == fmi3OK;
+}
+
+static bool saveCheckpoint(fmuHandle *fmu, fmi4cCheckpointStore *store, void *instance, double time)
+{
+    if(fmi4c_getFmiVersion(fmu) == fmiVersion2) {
+        return fmi4c_saveCheckpointFmi2(store, (fmi2InstanceHandle*)instance, time);
+    }
+    return fmi4c_saveCheckpointFmi3(store, (fmi3InstanceHandle*)instance, time);
+}
+
+static bool restoreCheckpoint(fmuHandle *fmu, fmi4cCheckpointStore *store, void *instance, double time)
+{
+    if(fmi4c_getFmiVersion(fmu) == fmiVersion2) {
+        return fmi4c_restoreCheckpointFmi2(store, (fmi2InstanceHandle*)instance, time);
+    }
+    return fmi4c_restoreCheckpointFmi3(store, (fmi3InstanceHandle*)instance, time);
+}
+
+//Checkpoints every step of the test FMU, rolls back to several earlier steps and verifies that re-stepping reproduces the results bit by bit
+int testCheckpoints(fmuHandle *fmu, size_t memoryBudget, bool overrideStopTime, double stopTimeOverride, bool overrideTimeStep, double timeStepOverride)
+{
+    fmiVersion_t version = fmi4c_getFmiVersion(fmu);
+    if((version == fmiVersion2 && (!fmi2_getSupportsCoSimulation(fmu) || !fmi2cs_getCanSerializeFMUState(fmu))) ||
+       (version == fmiVersion3 && (!fmi3_supportsCoSimulation(fmu) || !fmi3cs_getCanSerializeFMUState(fmu))) ||
+       version == fmiVersion1) {
+        printf("Checkpoint test requires an FMI 2 or FMI 3 FMU for co-simulation that can serialize its state\n");
+        return 1;
+    }
+
+    double startTime = 0;
+    double stepSize = 0.001;
+    double stopTime = 1;
+    if(overrideTimeStep) {
+        stepSize = timeStepOverride;
+    }
+    if(overrideStopTime) {
+        stopTime = stopTimeOverride;
+    }
+    int nSteps = (int)ceil((stopTime-startTime)/stepSize-1e-9);
+
+    printf("--- Test checkpoints ---\n");
+    void *instance = createInstance(fmu, false, startTime, stopTime);
+    if(instance == NULL) {
+        printf("  Failed to instantiate FMU\n");
+        return 1;
+    }
+
+    fmi4cCheckpointStore *store = fmi4c_createCheckpointStore(memoryBudget, NULL);
+    double *values = calloc((size_t)nSteps+1, sizeof(double));
+    if(store == NULL || values == NULL) {
+        printf("  Failed to create checkpoint store\n");
+        return 1;
+    }
+
+    //Simulate, with a checkpoint before every step
+    printf("  Simulating %i steps from %f to %f with a checkpoint per step and a memory budget of %zu bytes...\n",
+           nSteps, startTime, stopTime, memoryBudget);
+    double saveTime = 0;
+    for(int i=0; i<nSteps; ++i) {
+        double time = startTime+i*stepSize;
+        values[i] = getOutput(fmu, instance);
+        double t0 = fmi4c_getWallTime();
+        if(!saveCheckpoint(fmu, store, instance, time)) {
+            printf("  Failed to save checkpoint at %f\n", time);
+            return 1;
+        }
+        saveTime += fmi4c_getWallTime()-t0;
+        if(!doStep(fmu, instance, time, stepSize)) {
+            printf("  Step failed at %f\n", time);
+            return 1;
+        }
+    }
+    values[nSteps] = getOutput(fmu, instance);
+
+    fmi4cCheckpointStatistics statistics;
+    fmi4c_getCheckpointStatistics(store, &statistics);
+    printf("  %zu checkpoints of %zu bytes in %zu unique chunks of %zu bytes, stored as %zu bytes in memory and %zu bytes spilled\n",
+           statistics.numberOfCheckpoints, statistics.checkpointBytes, statistics.numberOfChunks, statistics.chunkBytes,
+           statistics.memoryBytes, statistics.spilledBytes);
+    printf("  Deduplication ratio %.2f, compression ratio %.2f\n",
+           (double)statistics.checkpointBytes/(double)fmax(1, statistics.chunkBytes),
+           (double)statistics.chunkBytes/(double)fmax(1, statistics.memoryBytes+statistics.spilledBytes));
+
+    //Roll back to a number of earlier steps (latest first) and compare re-stepped results with the original ones
+    int nMismatches = 0;
+    int nRollbacks = 0;
+    double restoreTime = 0;
+    for(int first=nSteps-1; first>=0; first-=(nSteps+7)/8) {
+        double t0 = fmi4c_getWallTime();
+        if(!restoreCheckpoint(fmu, store, instance, startTime+first*stepSize)) {
+            printf("  Failed to restore checkpoint at %f\n", startTime+first*stepSize);
+            return 1;
+        }
+        restoreTime += fmi4c_getWallTime()-t0;
+        ++nRollbacks;
+        if(getOutput(fmu, instance) != values[first]) {
+            ++nMismatches;
+        }
+        for(int i=first; i<nSteps; ++i) {
+            if(!doStep(fmu, instance, startTime+i*stepSize, stepSize)) {
+                printf("  Step failed at %f\n", startTime+i*stepSize);
+                return 1;
+            }
+            if(getOutput(fmu, instance) != values[i+1]) {
+                ++nMismatches;
+            }
+        }
+    }
+
+    //Discard the second half, as after a rollback to the middle
+    size_t nRemoved = fmi4c_removeCheckpoints(store, instance, startTime+(nSteps/2)*stepSize, stopTime);
+    fmi4c_getCheckpointStatistics(store, &statistics);
+    printf("  Removed %zu checkpoints, %zu remaining in %zu chunks\n", nRemoved, statistics.numberOfCheckpoints, statistics.numberOfChunks);
+    if(statistics.numberOfCheckpoints != (size_t)nSteps-nRemoved || (nSteps > 1 && nRemoved == 0)) {
+        ++nMismatches;
+    }
+
+    //Cycle incompressible blobs through a store where everything is spilled, keeping the two latest ones,
+    //and check that the spill file stops growing once freed space is reused
+    fmi4cCheckpointStore *spillStore = fmi4c_createCheckpointStore(1, NULL);
+    size_t blobSize = 3*4096+100;
+    unsigned char *blob = malloc(blobSize);
+    unsigned char *restored = malloc(blobSize);
+    if(spillStore == NULL || blob == NULL || restored == NULL) {
+        printf("  Failed to create spill store\n");
+        return 1;
+    }
+    size_t spillSize = 0;
+    for(int round=0; round<16; ++round) {
+        uint64_t seed = 0x9e3779b97f4a7c15ULL*(uint64_t)(round+1);
+        for(size_t i=0; i<blobSize; ++i) {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            blob[i] = (unsigned char)seed;
+        }
+        if(!fmi4c_putCheckpoint(spillStore, spillStore, round, blob, blobSize) ||
+           !fmi4c_getCheckpoint(spillStore, spillStore, round, restored, blobSize) ||
+           memcmp(blob, restored, blobSize) != 0) {
+            ++nMismatches;
+        }
+        fmi4c_removeCheckpoint(spillStore, spillStore, round-2);
+        fmi4c_getCheckpointStatistics(spillStore, &statistics);
+        if(round == 3) {
+            spillSize = statistics.spillFileBytes;
+        }
+        else if(round > 3 && statistics.spillFileBytes > spillSize) {
+            ++nMismatches;
+        }
+    }
+    fmi4c_removeCheckpoints(spillStore, NULL, 0, 16);
+    fmi4c_getCheckpointStatistics(spillStore, &statistics);
+    printf("  Spill file: %zu bytes used with two live checkpoints, %zu bytes when empty\n", spillSize, statistics.spillFileBytes);
+    if(spillSize == 0 || statistics.spillFileBytes != 0 || statistics.spilledBytes != 0) {
+        ++nMismatches;
+    }
+    fmi4c_freeCheckpointStore(spillStore);
+    free(blob);
+    free(restored);
+
+    //Put and remove small checkpoints many times, keeping one live, and check that the hash indices stop growing
+    fmi4cCheckpointStore *churnStore = fmi4c_createCheckpointStore(0, NULL);
+    if(churnStore == NULL) {
+        printf("  Failed to create churn store\n");
+        return 1;
+    }
+    size_t indexSlots = 0;
+    for(int round=0; round<100000; ++round) {
+        double value = round;
+        if(!fmi4c_putCheckpoint(churnStore, churnStore, round, &value, sizeof(value))) {
+            ++nMismatches;
+        }
+        fmi4c_removeCheckpoint(churnStore, churnStore, round-1);
+        fmi4c_getCheckpointStatistics(churnStore, &statistics);
+        if(round == 1000) {
+            indexSlots = statistics.indexSlots;
+        }
+        else if(round > 1000 && statistics.indexSlots > indexSlots) {
+            ++nMismatches;
+        }
+    }
+    fmi4c_getCheckpointStatistics(churnStore, &statistics);
+    printf("  Index: %zu slots after 100000 puts and removals\n", statistics.indexSlots);
+    if(statistics.numberOfCheckpoints != 1 || statistics.numberOfChunks != 1) {
+        ++nMismatches;
+    }
+    fmi4c_freeCheckpointStore(churnStore);
+
+    const char *names[] = { "x" };
+    openResultFile(1, names);
+    for(int i=0; resultWriter != NULL && i<=nSteps; ++i) {
+        writeResult(startTime+i*stepSize, &values[i], false);
+    }
+    closeResultFile();
+
+    printf("  %i rollback(s), %i mismatching value(s)\n", nRollbacks, nMismatches);
+    printf("  Save: %.2f us per checkpoint, restore: %.2f us per checkpoint\n",
+           1e6*saveTime/nSteps, 1e6*restoreTime/nRollbacks);
+
+    fmi4c_freeCheckpointStore(store);
+    freeInstance(fmu, instance);
+    free(values);
+    return nMismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,9 @@
+#ifndef FMIC_TEST_CHECKPOINT_H
+#define FMIC_TEST_CHECKPOINT_H
+
+#include "fmi4c.h"
+#include <stdbool.h>
+
+int testCheckpoints(fmuHandle *fmu, size_t memoryBudget, bool overrideStopTime, double stopTimeOverride, bool overrideTimeStep, double timeStepOverride);
+
+#endif //FMIC_TEST_CHECKPOINT_H
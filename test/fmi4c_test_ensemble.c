@@ -0,0 +1,187 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fmi4c.h"
+#include "fmi4c_ensemble.h"
+#include "fmi4c_threads.h"
+#include "fmi4c_test.h"
+#include "fmi4c_test_ensemble.h"
+
+#define COLD_START_SAMPLES 4    //Number of samples used to measure loading, instantiation and initialization
+
+typedef struct {
+    fmuHandle *fmu;
+    int nSamples;
+    double startTime;
+    double stopTime;
+    double stepSize;
+} sampleData;
+
+//Resets and initializes an instance again, for reusing it from an instance pool
+static bool resetInstance(fmuHandle *fmu, void *instance, double startTime, double stopTime)
+{
+    if(fmi4c_getFmiVersion(fmu) == fmiVersion2) {
+        return fmi2_reset((fmi2InstanceHandle*)instance) == fmi2OK &&
+               fmi2_setupExperiment((fmi2InstanceHandle*)instance, fmi2False, 0, startTime, fmi2True, stopTime) == fmi2OK &&
+               fmi2_enterInitializationMode((fmi2InstanceHandle*)instance) == fmi2OK &&
+               fmi2_exitInitializationMode((fmi2InstanceHandle*)instance) == fmi2OK;
+    }
+    return fmi3_reset((fmi3InstanceHandle*)instance) == fmi3OK &&
+           fmi3_enterInitializationMode((fmi3InstanceHandle*)instance, fmi3False, 0, startTime, fmi3True, stopTime) == fmi3OK &&
+           fmi3_exitInitializationMode((fmi3InstanceHandle*)instance) == fmi3OK;
+}
+
+//Simulates one sample with its own (constant) derivative and returns the final output
+static bool simulateSample(void *instance, int sample, double *results, void *userData)
+{
+    sampleData *data = (sampleData*)userData;
+    double dx = 1.0+(double)sample/data->nSamples;
+    int nSteps = (int)ceil((data->stopTime-data->startTime)/data->stepSize-1e-9);
+    bool ok = true;
+    if(fmi4c_getFmiVersion(data->fmu) == fmiVersion2) {
+        fmi2ValueReference vr = VR_DX;
+        ok = fmi2_setReal((fmi2InstanceHandle*)instance, &vr, 1, &dx) == fmi2OK;
+        for(int i=0; ok && i<nSteps; ++i) {
+            ok = fmi2_doStep((fmi2InstanceHandle*)instance, data->startTime+i*data->stepSize, data->stepSize, fmi2True) == fmi2OK;
+        }
+        vr = VR_X;
+        ok = ok && fmi2_getReal((fmi2InstanceHandle*)instance, &vr, 1, results) == fmi2OK;
+    }
+    else {
+        fmi3ValueReference vr = VR_DX;
+        ok = fmi3_setFloat64((fmi3InstanceHandle*)instance, &vr, 1, &dx, 1) == fmi3OK;
+        for(int i=0; ok && i<nSteps; ++i) {
+            bool eventEncountered, terminateSimulation, earlyReturn;
+            double lastT;
+            ok = fmi3_doStep((fmi3InstanceHandle*)instance, data->startTime+i*data->stepSize, data->stepSize, fmi3True, &eventEncountered, &terminateSimulation, &earlyReturn, &lastT) == fmi3OK;
+        }
+        vr = VR_X;
+        ok = ok && fmi3_getFloat64((fmi3InstanceHandle*)instance, &vr, 1, results, 1) == fmi3OK;
+    }
+    return ok;
+}
+
+//Benchmarks a fork-based ensemble against reusing a pooled instance and against loading the FMU for every sample
+int testEnsemble(const char *fmuPath, fmuHandle *fmu, int nSamples, int nWorkers, bool overrideStopTime, double stopTimeOverride, bool overrideTimeStep, double timeStepOverride)
+{
+    fmiVersion_t version = fmi4c_getFmiVersion(fmu);
+    if((version == fmiVersion2 && !fmi2_getSupportsCoSimulation(fmu)) ||
+       (version == fmiVersion3 && !fmi3_supportsCoSimulation(fmu)) ||
+       version == fmiVersion1) {
+        printf("Ensemble test requires an FMI 2 or FMI 3 FMU for co-simulation\n");
+        return 1;
+    }
+
+    sampleData data;
+    data.fmu = fmu;
+    data.nSamples = nSamples;
+    data.startTime = 0;
+    data.stopTime = 0.1;
+    data.stepSize = 0.001;
+    if(overrideTimeStep) {
+        data.stepSize = timeStepOverride;
+    }
+    if(overrideStopTime) {
+        data.stopTime = stopTimeOverride;
+    }
+
+    printf("--- Test ensemble ---\n");
+    double *forkResults = calloc((size_t)nSamples, sizeof(double));
+    double *poolResults = calloc((size_t)nSamples, sizeof(double));
+    bool *succeeded = calloc((size_t)nSamples, sizeof(bool));
+    void *templateInstance = createInstance(fmu, false, data.startTime, data.stopTime);
+    if(forkResults == NULL || poolResults == NULL || succeeded == NULL || templateInstance == NULL) {
+        printf("  Failed to create template instance\n");
+        return 1;
+    }
+    fmi4cEnsemble *ensemble = (version == fmiVersion2) ? fmi4c_createEnsembleFmi2((fmi2InstanceHandle*)templateInstance)
+                                                       : fmi4c_createEnsembleFmi3((fmi3InstanceHandle*)templateInstance);
+    if(ensemble == NULL) {
+        printf("  Failed to create ensemble\n");
+        return 1;
+    }
+    fmi4c_setEnsembleWorkers(ensemble, nWorkers);
+    fmi4c_setEnsembleResultSize(ensemble, 1);
+    printf("  Simulating %i samples from %f to %f with step size %f...\n", nSamples, data.startTime, data.stopTime, data.stepSize);
+
+    //Cold start: unzip, load, instantiate and initialize for each sample (only measured for a few samples)
+    int nColdSamples = nSamples < COLD_START_SAMPLES ? nSamples : COLD_START_SAMPLES;
+    double coldStart = fmi4c_getWallTime();
+    for(int i=0; i<nColdSamples; ++i) {
+        fmuHandle *coldFmu = fmi4c_loadFmu(fmuPath, "ensemblefmu");
+        void *instance = (coldFmu != NULL) ? createInstance(coldFmu, false, data.startTime, data.stopTime) : NULL;
+        if(instance == NULL) {
+            printf("  Failed to load FMU\n");
+            return 1;
+        }
+        freeInstance(coldFmu, instance);
+        fmi4c_freeFmu(coldFmu);
+    }
+    double coldStartupTime = (fmi4c_getWallTime()-coldStart)/nColdSamples;
+
+    //Instance pool: reuse one instance for all samples, resetting and initializing it again in between
+    void *pooledInstance = createInstance(fmu, false, data.startTime, data.stopTime);
+    double poolStartupTime = 0;
+    double poolStart = fmi4c_getWallTime();
+    for(int i=0; i<nSamples; ++i) {
+        double resetStart = fmi4c_getWallTime();
+        if(pooledInstance == NULL || !resetInstance(fmu, pooledInstance, data.startTime, data.stopTime)) {
+            printf("  Failed to reset pooled instance\n");
+            return 1;
+        }
+        poolStartupTime += fmi4c_getWallTime()-resetStart;
+        if(!simulateSample(pooledInstance, i, &poolResults[i], &data)) {
+            printf("  Sample %i failed with pooled instance\n", i);
+            return 1;
+        }
+    }
+    double poolTime = fmi4c_getWallTime()-poolStart;
+    poolStartupTime /= nSamples;
+    freeInstance(fmu, pooledInstance);
+
+    //Fork-based ensemble from the initialized template instance
+    double templateValue = getOutput(fmu, templateInstance);
+    double forkStart = fmi4c_getWallTime();
+    if(!fmi4c_runEnsemble(ensemble, nSamples, simulateSample, &data, forkResults, succeeded)) {
+        printf("  Ensemble failed\n");
+        return 1;
+    }
+    double forkTime = fmi4c_getWallTime()-forkStart;
+
+    int nMismatches = 0;
+    for(int i=0; i<nSamples; ++i) {
+        if(!succeeded[i] || forkResults[i] != poolResults[i]) {
+            ++nMismatches;
+        }
+    }
+
+    //One row per sample, with the sample number in the time column
+    const char *names[] = { "x_pool", "x_fork" };
+    openResultFile(2, names);
+    for(int i=0; resultWriter != NULL && i<nSamples; ++i) {
+        double values[2] = { poolResults[i], forkResults[i] };
+        writeResult(i, values, false);
+    }
+    closeResultFile();
+
+    printf("  %i failed sample(s), %i mismatching result(s)\n", fmi4c_getEnsembleNumberOfFailedSamples(ensemble), nMismatches);
+    printf("  Startup per sample: load %.1f us, pooled reset %.1f us, fork %.1f us\n",
+           1e6*coldStartupTime, 1e6*poolStartupTime, 1e6*fmi4c_getEnsembleMeanStartupTime(ensemble));
+    printf("  Total: pooled instance %.3f ms, fork ensemble %.3f ms, loading every sample (estimated) %.3f ms\n",
+           1e3*poolTime, 1e3*forkTime, 1e3*(poolTime+nSamples*(coldStartupTime-poolStartupTime)));
+
+    //The template instance must be unaffected by the samples
+    if(getOutput(fmu, templateInstance) != templateValue) {
+        printf("  Template instance was modified\n");
+        ++nMismatches;
+    }
+
+    fmi4c_freeEnsemble(ensemble);
+    freeInstance(fmu, templateInstance);
+    free(forkResults);
+    free(poolResults);
+    free(succeeded);
+    return nMismatches == 0 ? 0 : 1;
+}
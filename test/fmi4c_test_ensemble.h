@@ -0,0 +1,9 @@
+#ifndef FMIC_TEST_ENSEMBLE_H
+#define FMIC_TEST_ENSEMBLE_H
+
+#include "fmi4c.h"
+#include <stdbool.h>
+
+int testEnsemble(const char *fmuPath, fmuHandle *fmu, int nSamples, int nWorkers, bool overrideStopTime, double stopTimeOverride, bool overrideTimeStep, double timeStepOverride);
+
+#endif //FMIC_TEST_ENSEMBLE_H
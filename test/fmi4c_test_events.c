@@ -0,0 +1,125 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "fmi4c.h"
+#include "fmi4c_logger.h"
+#include "fmi4c_test.h"
+#include "fmi4c_test_events.h"
+
+#define GRAVITY 9.81        //Same constants as the bouncing ball test FMU
+#define RESTITUTION 0.7
+#define RELEASE_TIME 0.25
+#define START_HEIGHT 1.0
+#define MAX_EVENTS 64
+
+//Computes the event times of the bouncing ball test FMU: the release from rest (time event) and the bounces (state events)
+static int getAnalyticEventTimes(double stopTime, double *times)
+{
+    int nEvents = 0;
+    if(RELEASE_TIME <= stopTime) {
+        times[nEvents++] = RELEASE_TIME;
+    }
+    double height = START_HEIGHT-0.5*GRAVITY*RELEASE_TIME*RELEASE_TIME;
+    double fallTime = sqrt(2*height/GRAVITY);
+    double time = RELEASE_TIME+fallTime;
+    double flightTime = 2*RESTITUTION*fallTime;     //Rises with e times the impact speed and falls back
+    while(time <= stopTime && nEvents < MAX_EVENTS) {
+        times[nEvents++] = time;
+        time += flightTime;
+        flightTime *= RESTITUTION;
+    }
+    return nEvents;
+}
+
+//Simulates the bouncing ball test FMU with large steps and compares the located events with the analytic event times
+int testEvents(fmuHandle *fmu, bool overrideStopTime, double stopTimeOverride, bool overrideTimeStep, double timeStepOverride)
+{
+    if(fmi4c_getFmiVersion(fmu) != fmiVersion2 || !fmi2_getSupportsModelExchange(fmu) || fmi2_getNumberOfEventIndicators(fmu) != 1) {
+        printf("Event test requires the FMI 2 bouncing ball test FMU\n");
+        return 1;
+    }
+    double startTime = 0;
+    double stepSize = overrideTimeStep ? timeStepOverride : 0.1;
+    double stopTime = overrideStopTime ? stopTimeOverride : 1.5;
+
+    //The states are quadratic in time between events, so Runge-Kutta methods and their interpolants are exact
+    //and only the root finding limits the accuracy. CVODE is limited by its tolerance. Forward Euler errors
+    //grow by a fraction of a step per bounce, so only the number of events and their rough location is checked.
+    double tolerance = 1e-9;
+    if(solverMethod == fmi4cSolverCVode) {
+        tolerance = 1e-6;
+    }
+    else if(solverMethod == fmi4cSolverEuler) {
+        tolerance = 5*stepSize;
+    }
+
+    printf("--- Test event location ---\n");
+    fmi2InstanceHandle *instance = fmi2_instantiate(fmu, fmi2ModelExchange, fmi4c_loggerFmi2, calloc, free, NULL, NULL, fmi2False, fmi2True);
+    if(instance == NULL ||
+       fmi2_setupExperiment(instance, fmi2False, 0, startTime, fmi2True, stopTime) != fmi2OK ||
+       fmi2_enterInitializationMode(instance) != fmi2OK ||
+       fmi2_exitInitializationMode(instance) != fmi2OK) {
+        printf("  Failed to instantiate FMU\n");
+        return 1;
+    }
+    fmi4cSolver *solver = fmi4c_createSolverFmi2(instance, (size_t)fmi2_getNumberOfContinuousStates(fmu), solverMethod);
+    if(solver == NULL || !fmi4c_setSolverNumberOfEventIndicators(solver, 1)) {
+        printf("  Failed to create solver\n");
+        return 1;
+    }
+    fmi4c_setSolverStepSize(solver, (solverMethod == fmi4cSolverEuler || solverMethod == fmi4cSolverRungeKutta4) ? stepSize : 0, 0, 0);
+    fmi4c_setSolverTolerance(solver, 1e-8, 1e-8);
+    fmi4c_setSolverStopTime(solver, stopTime);
+
+    const char *names[] = { "h", "v" };
+    fmi2ValueReference refs[] = { 1, 2 };
+    openResultFile(2, names);
+
+    printf("  Simulating from %f to %f with %s and communication steps of %g...\n", startTime, stopTime,
+           fmi4c_getSolverMethodName(solverMethod), stepSize);
+    double eventTimes[MAX_EVENTS];
+    int nEvents = 0;
+    fmi4cSolverStatus status = fmi4c_handleSolverEvent(solver, startTime);
+    double time = startTime;
+    while(status != fmi4cSolverError && status != fmi4cSolverTerminate && time < stopTime) {
+        status = fmi4c_integrateSolver(solver, fmin(time+stepSize, stopTime));
+        time = fmi4c_getSolverTime(solver);
+        double values[2];
+        if(resultWriter != NULL) {
+            fmi2_getReal(instance, refs, 2, values);
+            writeResult(time, values, status == fmi4cSolverEnterEventMode);
+        }
+        if(status == fmi4cSolverEnterEventMode) {
+            if(nEvents < MAX_EVENTS) {
+                eventTimes[nEvents++] = time;
+            }
+            status = fmi4c_handleSolverEvent(solver, time);
+            if(resultWriter != NULL) {
+                fmi2_getReal(instance, refs, 2, values);
+                writeResult(time, values, false);
+            }
+        }
+    }
+    closeResultFile();
+    fmi4cSolverStatistics statistics;
+    fmi4c_getSolverStatistics(solver, &statistics);
+    fmi4c_freeSolver(solver);
+    fmi2_terminate(instance);
+    fmi2_freeInstance(instance);
+    if(status == fmi4cSolverError) {
+        printf("  Simulation failed at %f\n", time);
+        return 1;
+    }
+
+    double expected[MAX_EVENTS];
+    int nExpected = getAnalyticEventTimes(stopTime, expected);
+    double maxDeviation = 0;
+    for(int i=0; i<nEvents && i<nExpected; ++i) {
+        printf("  Event at %.12f, expected %.12f\n", eventTimes[i], expected[i]);
+        maxDeviation = fmax(maxDeviation, fabs(eventTimes[i]-expected[i]));
+    }
+    printf("  %d events (%d expected, %zu state events), %zu steps, max deviation %g (tolerance %g)\n",
+           nEvents, nExpected, statistics.nStateEvents, statistics.nSteps, maxDeviation, tolerance);
+    return (nEvents == nExpected && maxDeviation <= tolerance) ? 0 : 1;
+}
@@ -0,0 +1,9 @@
+#ifndef FMIC_TEST_EVENTS_H
+#define FMIC_TEST_EVENTS_H
+
+#include "fmi4c.h"
+#include <stdbool.h>
+
+int testEvents(fmuHandle *fmu, bool overrideStopTime, double stopTimeOverride, bool overrideTimeStep, double timeStepOverride);
+
+#endif //FMIC_TEST_EVENTS_H
@@ -1,42 +1,26 @@
-#include <stdarg.h>
-
 #include "fmi4c.h"
+#include "fmi4c_logger.h"
 #include "fmi4c_common.h"
 #include "fmi4c_test.h"
 #include "fmi4c_test_fmi1.h"
 
-void loggerFmi1(fmi1Component *component,
-                fmi1String instanceName,
-                fmi1Status status,
-                fmi1String category,
-                fmi1String message,
-                ...)
+//Resolves the value references of the variables in the input file
+static bool resolveInputsFMI1(fmuHandle *fmu)
 {
-    UNUSED(component)
-    UNUSED(instanceName)
-    UNUSED(status)
-    UNUSED(category)
-
-    if(status == fmi1OK && logLevel < 4 ||
-        status == fmi1Pending && logLevel < 4 ||
-        status == fmi1Warning && logLevel < 3 ||
-        status == fmi1Discard && logLevel < 3 ||
-        status == fmi1Error && logLevel < 2 ||
-        status == fmi1Fatal && logLevel < 1) {
-        return;
+    for(size_t i=0; i<numInputs; ++i) {
+        fmi1VariableHandle *var = fmi1_getVariableByName(fmu, fmi4c_getInputSignalName(inputSignals, i));
+        if(var == NULL) {
+            printf("Variable in input file does not exist in FMU: %s\n", fmi4c_getInputSignalName(inputSignals, i));
+            return false;
+        }
+        inputRefs[i] = fmi1_getVariableValueReference(var);
     }
-
-    va_list args;
-    va_start(args, message);
-    char msgstr[1024];
-    sprintf(msgstr, "%s: %s\n", category, message);
-    printf(msgstr, args);
-    va_end(args);
+    return true;
 }
 
 int testFMI1ME(fmuHandle *fmu, bool overrideStopTime, double stopTimeOverride, bool overrideTimeStep, double timeStepOverride) {
     //Instantiate FMU
-    fmi1InstanceHandle *instance = fmi1_instantiateModel(fmu, loggerFmi1, calloc, free, fmi1True);
+    fmi1InstanceHandle *instance = fmi1_instantiateModel(fmu, fmi4c_loggerFmi1, calloc, free, fmi1True);
     if(instance == NULL) {
         printf("  fmi2Instantiate() failed\n");
         exit(1);
@@ -102,31 +86,24 @@ int testFMI1ME(fmuHandle *fmu, bool overrideStopTime, double stopTimeOverride, b
         exit(1);
     }
 
-    outputFile = fopen(outputCsvPath, "w");
-    if(outputFile != NULL) {
-        fprintf(outputFile,"time");
-        for(int i=0; i<numOutputs; ++i) {
-            fprintf(outputFile,",%s",fmi1_getVariableName(fmi1_getVariableByValueReference(fmu, outputRefs[i])));
-        }
-        fprintf(outputFile,"\n");
+    const char *outputNames[VAR_MAX];
+    for(int i=0; i<numOutputs; ++i) {
+        outputNames[i] = fmi1_getVariableName(fmi1_getVariableByValueReference(fmu, outputRefs[i]));
     }
+    if(!resolveInputsFMI1(fmu)) {
+        free(derivatives);
+        free(eventIndicatorsPrev);
+        return 1;
+    }
+    openResultFile(numOutputs, outputNames);
 
     printf("  Simulating from %f to %f...\n",startTime, stopTime);
 
     double time = startTime;
     for(; time < stopTime; ) {
-        //Interpolate inputs from CSV file
-        for(int i=1; i<nInterpolators; ++i) {
-            fmi1VariableHandle *var = fmi1_getVariableByName(fmu, interpolationData[i].name);
-            if(var == NULL) {
-                printf("Variable in input file does not exist in FMU: %s\n", interpolationData[i].name);
-                free(derivatives);
-                free(eventIndicatorsPrev);
-                return 1;
-            }
-            fmi1Real value = interpolate(&interpolationData[0], &interpolationData[i], time, dataSize);
-            fmi1ValueReference vr = fmi1_getVariableValueReference(var);
-            fmi1_setReal(instance, &vr, 1, &value);
+        //Interpolate inputs from input file
+        if(interpolateInputs(time, false)) {
+            fmi1_setReal(instance, inputRefs, numInputs, inputValues);
         }
 
         size_t k;
@@ -173,6 +150,15 @@ int testFMI1ME(fmuHandle *fmu, bool overrideStopTime, double stopTimeOverride, b
                 printf("fmi1_getEventIndicators() failed\n");
                 exit(1);
             }
+
+            //Write the outputs after the event, at the same time as the ones before it
+            if(resultWriter != NULL) {
+                double values[VAR_MAX];
+                for(int i=0; i<numOutputs; ++i) {
+                    fmi1_getReal(instance, &outputRefs[i], 1, &values[i]);
+                }
+                writeResult(time, values, false);
+            }
         }
 
         //Update actual time stpe
@@ -215,20 +201,16 @@ int testFMI1ME(fmuHandle *fmu, bool overrideStopTime, double stopTimeOverride, b
             exit(1);
         }
 
-        //Print all output variables to CSV file
-        double value;
-        if(outputFile != NULL) {
-            fprintf(outputFile,"%f",time);
+        //Write all output variables to result file
+        if(resultWriter != NULL) {
+            double values[VAR_MAX];
             for(int i=0; i<numOutputs; ++i) {
-                fmi1_getReal(instance, &outputRefs[i], 1, &value);
-                fprintf(outputFile,",%f",value);
+                fmi1_getReal(instance, &outputRefs[i], 1, &values[i]);
             }
-            fprintf(outputFile,"\n");
+            writeResult(time, values, callEventUpdate || (eventInfo.upcomingTimeEvent && time == eventInfo.nextEventTime));
         }
     }
-    if(outputFile != NULL) {
-        fclose(outputFile);
-    }
+    closeResultFile();
     free(derivatives);
     free(eventIndicatorsPrev);
     free(states);
@@ -249,7 +231,7 @@ int testFMI1ME(fmuHandle *fmu, bool overrideStopTime, double stopTimeOverride, b
 int testfmi1_cs(fmuHandle *fmu, bool overrideStopTime, double stopTimeOverride, bool overrideTimeStep, double timeStepOverride)
 {
     //Instantiate FMU
-    fmi1InstanceHandle *instance = fmi1_instantiateSlave(fmu, "application/x-fmu-sharedlibrary", 1000, fmi1False, fmi1False, loggerFmi1, calloc, free, NULL, fmi1True);
+    fmi1InstanceHandle *instance = fmi1_instantiateSlave(fmu, "application/x-fmu-sharedlibrary", 1000, fmi1False, fmi1False, fmi4c_loggerFmi1, calloc, free, NULL, fmi1True);
     if(instance == NULL) {
         printf("fmi1_instantiateSlave() failed\n");
         exit(1);
@@ -282,28 +264,21 @@ int testfmi1_cs(fmuHandle *fmu, bool overrideStopTime, double stopTimeOverride,
     printf("  FMU successfully initialized.\n");
 
     printf("  Simulating from %f to %f...\n",startTime, stopTime);
-    outputFile = fopen(outputCsvPath, "w");
-    if(outputFile != NULL) {
-        fprintf(outputFile,"time");
-        for(int i=0; i<numOutputs; ++i) {
-            fprintf(outputFile,",%s",fmi1_getVariableName(fmi1_getVariableByValueReference(fmu, outputRefs[i])));
-        }
-        fprintf(outputFile,"\n");
+    const char *outputNames[VAR_MAX];
+    for(int i=0; i<numOutputs; ++i) {
+        outputNames[i] = fmi1_getVariableName(fmi1_getVariableByValueReference(fmu, outputRefs[i]));
     }
+    if(!resolveInputsFMI1(fmu)) {
+        return 1;
+    }
+    openResultFile(numOutputs, outputNames);
 
     double time = startTime;
     while(time <= stopTime) {
 
-        //Interpolate inputs from CSV file
-        for(int i=1; i<nInterpolators; ++i) {
-            fmi1VariableHandle *var = fmi1_getVariableByName(fmu, interpolationData[i].name);
-            if(var == NULL) {
-                printf("Variable in input file does not exist in FMU: %s\n", interpolationData[i].name);
-                return 1;
-            }
-            fmi1Real value = interpolate(&interpolationData[0], &interpolationData[i], time, dataSize);
-            fmi1ValueReference vr = fmi1_getVariableValueReference(var);
-            fmi1_setReal(instance, &vr, 1, &value);
+        //Interpolate inputs from input file
+        if(interpolateInputs(time, false)) {
+            fmi1_setReal(instance, inputRefs, numInputs, inputValues);
         }
 
         //Take a step
@@ -313,22 +288,18 @@ int testfmi1_cs(fmuHandle *fmu, bool overrideStopTime, double stopTimeOverride,
             exit(1);
         }
 
-        //Print all output variables to CSV file
-        double value;
-        if(outputFile != NULL) {
-            fprintf(outputFile,"%f",time);
+        //Write all output variables to result file
+        if(resultWriter != NULL) {
+            double values[VAR_MAX];
             for(int i=0; i<numOutputs; ++i) {
-                fmi1_getReal(instance, &outputRefs[i], 1, &value);
-                fprintf(outputFile,",%f",value);
+                fmi1_getReal(instance, &outputRefs[i], 1, &values[i]);
             }
-            fprintf(outputFile,"\n");
+            writeResult(time, values, false);
         }
 
         time+=stepSize;
     }
-    if(outputFile != NULL) {
-        fclose(outputFile);
-    }
+    closeResultFile();
 
     printf("  Simulation finished.\n");
 
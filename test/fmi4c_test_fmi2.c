@@ -1,45 +1,29 @@
-#include <stdarg.h>
 #include <string.h>
 
 #include "fmi4c.h"
+#include "fmi4c_logger.h"
 #include "fmi4c_common.h"
 #include "fmi4c_test.h"
 #include "fmi4c_test_fmi2.h"
 
-void loggerFmi2(fmi2ComponentEnvironment componentEnvironment,
-                fmi2String instanceName,
-                fmi2Status status,
-                fmi2String category,
-                fmi2String message,
-                ...)
+//Resolves the value references of the variables in the input file
+static bool resolveInputsFMI2(fmuHandle *fmu)
 {
-    UNUSED(componentEnvironment)
-    UNUSED(instanceName)
-    UNUSED(category)
-
-
-    if(status == fmi2OK && logLevel < 4 ||
-        status == fmi2Pending && logLevel < 4 ||
-        status == fmi2Warning && logLevel < 3 ||
-        status == fmi2Discard && logLevel < 3 ||
-        status == fmi2Error && logLevel < 2 ||
-        status == fmi2Fatal && logLevel < 1) {
-        return;
-    }
-
-    va_list args;
-    va_start(args, message);
-    char msgstr[1024];
-    sprintf(msgstr, "%s: %s\n", category, message);
-    printf(msgstr, args);
-    va_end(args);
+    for(size_t i=0; i<numInputs; ++i) {
+        fmi2VariableHandle *var = fmi2_getVariableByName(fmu, fmi4c_getInputSignalName(inputSignals, i));
+        if(var == NULL) {
+            printf("Variable in input file does not exist in FMU: %s\n", fmi4c_getInputSignalName(inputSignals, i));
+            return false;
+        }
+        inputRefs[i] = fmi2_getVariableValueReference(var);
+    }
+    return true;
 }
 
-
 int testFMI2ME(fmuHandle *fmu, bool overrideStopTime, double stopTimeOverride, bool overrideTimeStep, double timeStepOverride)
 {
     //Instantiate FMU
-    fmi2InstanceHandle *instance = fmi2_instantiate(fmu, fmi2ModelExchange, loggerFmi2, calloc, free, NULL, NULL, fmi2False, fmi2True);
+    fmi2InstanceHandle *instance = fmi2_instantiate(fmu, fmi2ModelExchange, fmi4c_loggerFmi2, calloc, free, NULL, NULL, fmi2False, fmi2True);
 
     if(instance == NULL)
     {
@@ -95,198 +79,117 @@ int testFMI2ME(fmuHandle *fmu, bool overrideStopTime, double stopTimeOverride, b
     }
     printf("  FMU successfully initialized.\n");
 
-    double actualStepSize;
     fmi2Boolean terminateSimulation = fmi2False;
     fmi2Boolean callEventUpdate = fmi2False;
-    fmi2EventInfo eventInfo;
     size_t nStates;
-    fmi2Real* states;
-    fmi2Real* derivatives;
     size_t nEventIndicators;
-    fmi2Real* eventIndicators;
-    fmi2Real *eventIndicatorsPrev;
-    eventInfo.newDiscreteStatesNeeded = fmi2False;
-    eventInfo.terminateSimulation = fmi2False;
-    eventInfo.nominalsOfContinuousStatesChanged = fmi2False;
-    eventInfo.valuesOfContinuousStatesChanged = fmi2True;
-    eventInfo.nextEventTimeDefined = fmi2False;
-    eventInfo.nextEventTime = 0.0;
 
     nStates = fmi2_getNumberOfContinuousStates(fmu);
     nEventIndicators = fmi2_getNumberOfEventIndicators(fmu);
 
-    states = malloc(nStates*sizeof(double));
-    derivatives = malloc(nStates*sizeof(double));
-    eventIndicators = malloc(nEventIndicators*sizeof(double));
-    eventIndicatorsPrev = malloc(nEventIndicators*sizeof(double));
-
-    //Perform event iteration
-    eventInfo.newDiscreteStatesNeeded = fmi2True;
-    eventInfo.terminateSimulation     = fmi2False;
-    while (eventInfo.newDiscreteStatesNeeded && !eventInfo.terminateSimulation) {
-        fmi2_newDiscreteStates(instance,  &eventInfo);
+    //Create solver, fixed step methods use the communication step size
+    fmi4cSolver *solver = fmi4c_createSolverFmi2(instance, nStates, solverMethod);
+    if(solver == NULL) {
+        printf("fmi4c_createSolverFmi2() failed\n");
+        exit(1);
     }
-    fmi2_enterContinuousTimeMode(instance);
-
-    status = fmi2_getContinuousStates(instance,  states, nStates);
-    if(status != fmi2OK) {
-        printf("fmi2_getContinuousStates() failed\n");
+    fmi4c_setSolverStepSize(solver, (solverMethod == fmi4cSolverEuler || solverMethod == fmi4cSolverRungeKutta4) ? stepSize : 0, 0, 0);
+    if(fmi2_defaultToleranceDefined(fmu)) {
+        fmi4c_setSolverTolerance(solver, fmi2_getDefaultTolerance(fmu), fmi2_getDefaultTolerance(fmu));
+    }
+    fmi4c_setSolverStopTime(solver, stopTime);
+    fmi4c_setSolverDenseOutput(solver, numInputs == 0);
+    if(!fmi4c_setSolverNumberOfEventIndicators(solver, nEventIndicators)) {
+        printf("fmi4c_setSolverNumberOfEventIndicators() failed\n");
         exit(1);
     }
 
-    if(nEventIndicators > 0) {
-        status = fmi2_getEventIndicators(instance,  eventIndicators, nEventIndicators);
-        if(status != fmi2OK) {
-            printf("fmi2_getEventIndicators() failed\n");
-            exit(1);
-        }
+    //Perform event iteration and initialize solver
+    fmi4cSolverStatus solverStatus = fmi4c_handleSolverEvent(solver, startTime);
+    if(solverStatus == fmi4cSolverError) {
+        printf("fmi4c_handleSolverEvent() failed\n");
+        exit(1);
     }
+    terminateSimulation = (solverStatus == fmi4cSolverTerminate);
 
-    outputFile = fopen(outputCsvPath, "w");
-    if(outputFile != NULL) {
-        fprintf(outputFile,"time");
-        for(int i=0; i<numOutputs; ++i) {
-            fprintf(outputFile,",%s",fmi2_getVariableName(fmi2_getVariableByValueReference(fmu, outputRefs[i])));
-        }
-        fprintf(outputFile,"\n");
+    const char *outputNames[VAR_MAX];
+    for(int i=0; i<numOutputs; ++i) {
+        outputNames[i] = fmi2_getVariableName(fmi2_getVariableByValueReference(fmu, outputRefs[i]));
     }
+    if(!resolveInputsFMI2(fmu)) {
+        fmi4c_freeSolver(solver);
+        return 1;
+    }
+    openResultFile(numOutputs, outputNames);
 
     printf("  Simulating from %f to %f...\n",startTime, stopTime);
     for(double time=startTime; time < stopTime;) {
-        if(eventInfo.terminateSimulation || terminateSimulation) {
+        if(terminateSimulation) {
             printf("Terminating simulation at time = %f\n", time);
             break;
         }
 
-        //Interpolate inputs from CSV file
-        for(int i=1; i<nInterpolators; ++i) {
-            fmi2VariableHandle *var = fmi2_getVariableByName(fmu, interpolationData[i].name);
-            if(var == NULL) {
-                printf("Variable in input file does not exist in FMU: %s\n", interpolationData[i].name);
-                free(derivatives);
-                free(eventIndicatorsPrev);
-                free(states);
-                free(eventIndicators);
-                return 1;
-            }
-            fmi2Real value = interpolate(&interpolationData[0], &interpolationData[i], time, dataSize);
-            fmi2ValueReference vr = fmi2_getVariableValueReference(var);
-            fmi2_setReal(instance, &vr, 1, &value);
-        }
-
-        size_t k;
-        fmi2Real lastTime;
-        int zeroCrossingEvent = 0;
-
-        status = fmi2_setTime(instance,  time);
-        if(status != fmi2OK) {
-            printf("fmi2_setTime() failed\n");
-            exit(1);
+        //Interpolate inputs from input file
+        if(interpolateInputs(time, false)) {
+            fmi2_setReal(instance, inputRefs, numInputs, inputValues);
         }
 
-        if(nEventIndicators > 0) {
-            memcpy(eventIndicatorsPrev, eventIndicators, nEventIndicators*sizeof(double));
-            status = fmi2_getEventIndicators(instance,  eventIndicators, nEventIndicators);
-            if(status != fmi2OK) {
-                printf("fmi2_getEventIndicators() failed\n");
+        //Handle events (state events, time events and step events are located by the solver)
+        if (callEventUpdate) {
+            solverStatus = fmi4c_handleSolverEvent(solver, time);
+            if(solverStatus == fmi4cSolverError) {
+                printf("fmi4c_handleSolverEvent() failed\n");
                 exit(1);
             }
-
-            /* Check if an event indicator has triggered */
-            for (k = 0; k < nEventIndicators; k++) {
-                if ((eventIndicators[k] > 0) != (eventIndicatorsPrev[k] > 0)) {
-                    zeroCrossingEvent = 1;
-                    break;
-                }
-            }
-
-        }
-
-        //Handle events
-        if (callEventUpdate || zeroCrossingEvent ||
-                (eventInfo.nextEventTimeDefined && time == eventInfo.nextEventTime)) {
-            status = fmi2_enterEventMode(instance);
-            if(status != fmi2OK) {
-                printf("fmi2EnterEventMode() failed\n");
-                exit(1);
+            terminateSimulation = (solverStatus == fmi4cSolverTerminate);
+            callEventUpdate = fmi2False;
+            if(terminateSimulation) {
+                continue;
             }
 
-            //Perform event iteration
-            eventInfo.newDiscreteStatesNeeded = fmi2True;
-            eventInfo.terminateSimulation     = fmi2False;
-            while (eventInfo.newDiscreteStatesNeeded && !eventInfo.terminateSimulation) {
-                fmi2_newDiscreteStates(instance,  &eventInfo);
-            }
-            status = fmi2_enterContinuousTimeMode(instance);
-            if(status != fmi2OK) {
-                printf("fmi2EnterContinuousTimeMode() failed\n");
-                exit(1);
-            }
-            status = fmi2_getContinuousStates(instance, states, nStates);
-            if(status != fmi2OK) {
-                printf("fmi2_getContinuousStates() failed\n");
-                exit(1);
-            }
-            if(nEventIndicators > 0) {
-                status = fmi2_getEventIndicators(instance, eventIndicators, nEventIndicators);
-                if(status != fmi2OK) {
-                    printf("fmi2_getEventIndicators() failed\n");
-                    exit(1);
+            //Write the outputs after the event, at the same time as the ones before it
+            if(resultWriter != NULL) {
+                double values[VAR_MAX];
+                for(int i=0; i<numOutputs; ++i) {
+                    fmi2_getReal(instance, &outputRefs[i], 1, &values[i]);
                 }
+                writeResult(time, values, false);
             }
         }
 
-        //Update actual time stpe
-        lastTime = time;
-        time += stepSize;
-        if (eventInfo.nextEventTimeDefined && (time >= eventInfo.nextEventTime)) {
-            time = eventInfo.nextEventTime;
-        }
-        actualStepSize = time - lastTime;
-        if(time > stopTime) {
-            time = stopTime;
-            actualStepSize = time - lastTime;
+        //Update next communication time
+        double nextTime = time + stepSize;
+        if(nextTime > stopTime) {
+            nextTime = stopTime;
         }
 
         //Perform integration
-        status = fmi2_getDerivatives(instance, derivatives, nStates);
-        if(status != fmi2OK) {
-            printf("fmi2_getDerivatives() failed\n");
+        solverStatus = fmi4c_integrateSolver(solver, nextTime);
+        if(solverStatus == fmi4cSolverError) {
+            printf("fmi4c_integrateSolver() failed\n");
             exit(1);
         }
-        for (k = 0; k < nStates; k++) {
-            states[k] = states[k] + actualStepSize*derivatives[k];
-        }
+        callEventUpdate = (solverStatus == fmi4cSolverEnterEventMode);
+        terminateSimulation = (solverStatus == fmi4cSolverTerminate);
+        time = fmi4c_getSolverTime(solver);
 
-        status = fmi2_setContinuousStates(instance, states, nStates);
-        if(status != fmi2OK) {
-            printf("fmi2_setContinuousStates() failed\n");
-            exit(1);
-        }
-        status = fmi2_completedIntegratorStep(instance, fmi2True, &callEventUpdate, &terminateSimulation);
-        if(status != fmi2OK) {
-            printf("fmi2CompletedIntegratorStep() failed\n");
-            exit(1);
-        }
-
-        //Print all output variables to CSV file
-        double value;
-        if(outputFile != NULL) {
-            fprintf(outputFile,"%f",time);
+        //Write all output variables to result file
+        if(resultWriter != NULL) {
+            double values[VAR_MAX];
             for(int i=0; i<numOutputs; ++i) {
-                fmi2_getReal(instance, &outputRefs[i], 1, &value);
-                fprintf(outputFile,",%f",value);
+                fmi2_getReal(instance, &outputRefs[i], 1, &values[i]);
             }
-            fprintf(outputFile,"\n");
+            writeResult(time, values, callEventUpdate);
         }
     }
-    free(derivatives);
-    free(eventIndicatorsPrev);
-    free(states);
-    free(eventIndicators);
-    if(outputFile != NULL) {
-        fclose(outputFile);
-    }
+
+    fmi4cSolverStatistics statistics;
+    fmi4c_getSolverStatistics(solver, &statistics);
+    printf("  Solver statistics: %zu steps, %zu rejected steps, %zu derivative evaluations, %zu Jacobian evaluations, %zu state events\n",
+           statistics.nSteps, statistics.nRejectedSteps, statistics.nDerivativeEvaluations, statistics.nJacobianEvaluations, statistics.nStateEvents);
+
+    fmi4c_freeSolver(solver);
+    closeResultFile();
 
     printf("  Simulation finished.\n");
 
@@ -302,7 +205,7 @@ int testFMI2ME(fmuHandle *fmu, bool overrideStopTime, double stopTimeOverride, b
 int testFMI2CS(fmuHandle *fmu, bool overrideStopTime, double stopTimeOverride, bool overrideTimeStep, double timeStepOverride)
 {
     //Instantiate FMU
-    fmi2InstanceHandle *instance = fmi2_instantiate(fmu, fmi2CoSimulation, loggerFmi2, calloc, free, NULL, NULL, fmi2False, fmi2True);
+    fmi2InstanceHandle *instance = fmi2_instantiate(fmu, fmi2CoSimulation, fmi4c_loggerFmi2, calloc, free, NULL, NULL, fmi2False, fmi2True);
 
     if(instance == NULL)    {
         printf("fmi2Instantiate() failed\n");
@@ -356,28 +259,25 @@ int testFMI2CS(fmuHandle *fmu, bool overrideStopTime, double stopTimeOverride, b
     printf("  FMU successfully initialized.\n");
 
     printf("  Simulating from %f to %f...\n",startTime, stopTime);
-    if(outputFile != NULL) {
-        outputFile = fopen(outputCsvPath, "w");
-        fprintf(outputFile,"time");
-        for(int i=0; i<numOutputs; ++i) {
-            fprintf(outputFile,",%s",fmi2_getVariableName(fmi2_getVariableByValueReference(fmu, outputRefs[i])));
-        }
-        fprintf(outputFile,"\n");
+    const char *outputNames[VAR_MAX];
+    for(int i=0; i<numOutputs; ++i) {
+        outputNames[i] = fmi2_getVariableName(fmi2_getVariableByValueReference(fmu, outputRefs[i]));
     }
+    if(!resolveInputsFMI2(fmu)) {
+        return 1;
+    }
+    bool setInputDerivatives = fmi2cs_getCanInterpolateInputs(fmu);
+    openResultFile(numOutputs, outputNames);
 
     double time=startTime;
     while(time <= stopTime) {
 
-        //Interpolate inputs from CSV file
-        for(int i=1; i<nInterpolators; ++i) {
-            fmi2VariableHandle *var = fmi2_getVariableByName(fmu, interpolationData[i].name);
-            if(var == NULL) {
-                printf("Variable in input file does not exist in FMU: %s\n", interpolationData[i].name);
-                return 1;
+        //Interpolate inputs from input file (and let the FMU extrapolate them over the step, if it can)
+        if(interpolateInputs(time, setInputDerivatives)) {
+            fmi2_setReal(instance, inputRefs, numInputs, inputValues);
+            if(setInputDerivatives) {
+                fmi2_setRealInputDerivatives(instance, inputRefs, numInputs, inputOrders, inputDerivatives);
             }
-            fmi2Real value = interpolate(&interpolationData[0], &interpolationData[i], time, dataSize);
-            fmi2ValueReference vr = fmi2_getVariableValueReference(var);
-            fmi2_setReal(instance, &vr, 1, &value);
         }
 
         //Take a step
@@ -387,22 +287,18 @@ int testFMI2CS(fmuHandle *fmu, bool overrideStopTime, double stopTimeOverride, b
             exit(1);
         }
 
-        //Print all output variables to CSV file
-        double value;
-        if(outputFile != NULL) {
-            fprintf(outputFile,"%f",time);
+        //Write all output variables to result file
+        if(resultWriter != NULL) {
+            double values[VAR_MAX];
             for(int i=0; i<numOutputs; ++i) {
-                fmi2_getReal(instance, &outputRefs[i], 1, &value);
-                fprintf(outputFile,",%f",value);
+                fmi2_getReal(instance, &outputRefs[i], 1, &values[i]);
             }
-            fprintf(outputFile,"\n");
+            writeResult(time, values, false);
         }
 
         time+=stepSize;
     }
-    if(outputFile != NULL) {
-        fclose(outputFile);
-    }
+    closeResultFile();
     printf("  Simulation finished.\n");
 
     fmi2_terminate(instance);
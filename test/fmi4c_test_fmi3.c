@@ -1,28 +1,10 @@
 #include "fmi4c.h"
+#include "fmi4c_logger.h"
+#include "fmi4c_scheduler.h"
 #include "fmi4c_common.h"
 #include "fmi4c_test.h"
 #include "fmi4c_test_fmi3.h"
 
-void loggerFmi3(fmi3InstanceEnvironment instanceEnvironment,
-                 fmi3Status status,
-                 fmi3String category,
-                 fmi3String message)
-{
-    UNUSED(instanceEnvironment)
-    UNUSED(category)
-
-    if(status == fmi3OK && logLevel < 4 ||
-        status == fmi3Warning && logLevel < 3 ||
-        status == fmi3Discard && logLevel < 3 ||
-        status == fmi3Error && logLevel < 2 ||
-        status == fmi3Fatal && logLevel < 1) {
-        return;
-    }
-
-    printf("%s: %s\n",category, message);
-}
-
-
 void intermediateUpdate(
         fmi3InstanceEnvironment instanceEnvironment,
         fmi3Float64  intermediateUpdateTime,
@@ -40,25 +22,37 @@ void intermediateUpdate(
 
     printf("Intermediate update at %f\n", intermediateUpdateTime);
 
-    if(intermediateVariableGetAllowed && intermediateStepFinished) {
-        //Print all output variables to CSV file
-        double value;
-        fprintf(outputFile,"%f",intermediateUpdateTime);
+    if(intermediateVariableGetAllowed && intermediateStepFinished && resultWriter != NULL) {
+        //Write all output variables to result file
+        double values[VAR_MAX];
         for(int i=0; i<numOutputs; ++i) {
-            fmi3_getFloat64((fmi3InstanceHandle *)instanceEnvironment, &outputRefs[i], 1, &value, 1);
-            fprintf(outputFile,",%f",value);
+            fmi3_getFloat64((fmi3InstanceHandle *)instanceEnvironment, &outputRefs[i], 1, &values[i], 1);
         }
-        fprintf(outputFile,"\n");
+        writeResult(intermediateUpdateTime, values, false);
     }
 }
 
 
+//Resolves the value references of the variables in the input file
+static bool resolveInputsFMI3(fmuHandle *fmu)
+{
+    for(size_t i=0; i<numInputs; ++i) {
+        fmi3VariableHandle *var = fmi3_getVariableByName(fmu, fmi4c_getInputSignalName(inputSignals, i));
+        if(var == NULL) {
+            printf("Variable in input file does not exist in FMU: %s\n", fmi4c_getInputSignalName(inputSignals, i));
+            return false;
+        }
+        inputRefs[i] = fmi3_getVariableValueReference(var);
+    }
+    return true;
+}
+
 int testFMI3CS(fmuHandle *fmu, bool overrideStopTime, double stopTimeOverride, bool overrideTimeStep, double timeStepOverride)
 {
     fmi3Status status;
 
     int nRequiredIntermediateVariables = 0;
-    fmi3InstanceHandle *instance = fmi3_instantiateCoSimulation(fmu, fmi3False, fmi3True, fmi3False, fmi3False, NULL, nRequiredIntermediateVariables, fmu, loggerFmi3, intermediateUpdate);
+    fmi3InstanceHandle *instance = fmi3_instantiateCoSimulation(fmu, fmi3False, fmi3True, fmi3False, fmi3False, NULL, nRequiredIntermediateVariables, fmu, fmi4c_loggerFmi3, intermediateUpdate);
 
     if(instance == NULL) {
         printf("fmi3InstantiateCoSimulation() failed\n");
@@ -104,23 +98,20 @@ int testFMI3CS(fmuHandle *fmu, bool overrideStopTime, double stopTimeOverride, b
     printf("  FMU successfully initialized!\n");
 
     printf("  Simulating from %f to %f with a step size of %f...\n",startTime, stopTime, stepSize);
-    outputFile = fopen(outputCsvPath, "w");
-    if(outputFile != NULL) {
-        fprintf(outputFile,"time");
-        for(int i=0; i<numOutputs; ++i) {
-            fprintf(outputFile,",%s",fmi3_getVariableName(fmi3_getVariableByValueReference(fmu, outputRefs[i])));
-        }
-        fprintf(outputFile,"\n");
+    const char *outputNames[VAR_MAX];
+    for(int i=0; i<numOutputs; ++i) {
+        outputNames[i] = fmi3_getVariableName(fmi3_getVariableByValueReference(fmu, outputRefs[i]));
     }
+    if(!resolveInputsFMI3(fmu)) {
+        return 1;
+    }
+    openResultFile(numOutputs, outputNames);
     double time=startTime;
     while(time <= stopTime) {
 
-        //Interpolate inputs from CSV file
-        for(int i=1; i<nInterpolators; ++i) {
-            fmi3VariableHandle *var = fmi3_getVariableByName(fmu, interpolationData[i].name);
-            fmi3Float64 value = interpolate(&interpolationData[0], &interpolationData[i], time, dataSize);
-            fmi3ValueReference vr = fmi3_getVariableValueReference(var);
-            fmi3_setFloat64(instance, &vr, 1, &value, 1);
+        //Interpolate inputs from input file
+        if(interpolateInputs(time, false)) {
+            fmi3_setFloat64(instance, inputRefs, numInputs, inputValues, numInputs);
         }
 
         //Take a step
@@ -132,21 +123,17 @@ int testFMI3CS(fmuHandle *fmu, bool overrideStopTime, double stopTimeOverride, b
             exit(1);
         }
 
-        //Print all output variables to CSV file
-        double value;
-        if(outputFile != NULL) {
-            fprintf(outputFile,"%f",time);
+        //Write all output variables to result file
+        if(resultWriter != NULL) {
+            double values[VAR_MAX];
             for(int i=0; i<numOutputs; ++i) {
-                fmi3_getFloat64(instance, &outputRefs[i], 1, &value, 1);
-                fprintf(outputFile,",%f",value);
+                fmi3_getFloat64(instance, &outputRefs[i], 1, &values[i], 1);
             }
-            fprintf(outputFile,"\n");
+            writeResult(time, values, eventEncountered);
         }
         time+=stepSize;
     }
-    if(outputFile != NULL) {
-        fclose(outputFile);
-    }
+    closeResultFile();
 
     printf("  Simulation finished.\n");
 
@@ -162,7 +149,7 @@ int testFMI3CS(fmuHandle *fmu, bool overrideStopTime, double stopTimeOverride, b
 
 int testFMI3ME(fmuHandle *fmu, bool overrideStopTime, double stopTimeOverride, bool overrideTimeStep, double timeStepOverride) {
     //Instantiate FMU
-    fmi3InstanceHandle *instance = fmi3_instantiateModelExchange(fmu, fmi2False, fmi2True, NULL, loggerFmi3);
+    fmi3InstanceHandle *instance = fmi3_instantiateModelExchange(fmu, fmi2False, fmi2True, NULL, fmi4c_loggerFmi3);
     if(instance == NULL) {
         printf("  fmi2Instantiate() failed\n");
         exit(1);
@@ -214,22 +201,9 @@ int testFMI3ME(fmuHandle *fmu, bool overrideStopTime, double stopTimeOverride, b
     printf("  FMU successfully initialized.\n");
 
     fmi3Boolean terminateSimulation = fmi3False;
+    fmi3Boolean callEventUpdate = fmi3False;
     size_t nStates;
-    fmi3Float64* states;
-    fmi3Float64* nominalStates = NULL;
-    fmi3Float64* derivatives;
     size_t nEventIndicators;
-    fmi3Float64* eventIndicators;
-    fmi3Float64* eventIndicatorsPrev;
-    fmi3Boolean discreteStatesNeedUpdate = fmi3False;
-    fmi3Boolean nominalsOfContinuousStatesChanged;
-    fmi3Boolean valuesOfContinuousStatesChanged;
-    fmi3Boolean nextEventTimeDefined = fmi3False;
-    fmi3Float64 nextEventTime;
-    fmi3Boolean timeEvent;
-    fmi3Boolean stateEvent = fmi3False;
-    fmi3Boolean stepEvent = fmi3False;
-    fmi3Int32* rootsFound;
 
     status = fmi3_getNumberOfContinuousStates(instance, &nStates);
     if(status != fmi3OK) {
@@ -242,154 +216,230 @@ int testFMI3ME(fmuHandle *fmu, bool overrideStopTime, double stopTimeOverride, b
         exit(1);
     }
 
-    states = malloc(nStates*sizeof(fmi3Float64));
-    nominalStates = malloc(nStates*sizeof(fmi3Float64));
-    derivatives = malloc(nStates*sizeof(fmi3Float64));
-    eventIndicators = malloc(nEventIndicators*sizeof(fmi3Float64));
-    eventIndicatorsPrev = malloc(nEventIndicators*sizeof(fmi3Float64));
-    rootsFound = malloc(nEventIndicators*sizeof(fmi3Int32));
-
-    for(int i=0; i<nEventIndicators; ++i) {
-        eventIndicatorsPrev[i] = 0;
-        rootsFound[i] = 0;
-    }
-
-    while (discreteStatesNeedUpdate) {
-        fmi3_updateDiscreteStates(instance,
-                                 &discreteStatesNeedUpdate,
-                                 &terminateSimulation,
-                                 &nominalsOfContinuousStatesChanged,
-                                 &valuesOfContinuousStatesChanged,
-                                 &nextEventTimeDefined,
-                                 &nextEventTime);
-
-        if (terminateSimulation) {
-            return 1;
-        }
-    }
-
-    fmi3_enterContinuousTimeMode(instance);
-
-    status = fmi3_getContinuousStates(instance, states, nStates);
-    if(status != fmi3OK) {
-        printf("  fmi3GetContinuousStates() failed\n");
+    //Create solver, fixed step methods use the communication step size
+    fmi4cSolver *solver = fmi4c_createSolverFmi3(instance, nStates, solverMethod);
+    if(solver == NULL) {
+        printf("  fmi4c_createSolverFmi3() failed\n");
         exit(1);
     }
-    status = fmi3_getNominalsOfContinuousStates(instance, nominalStates, nStates);
-    if(status != fmi3OK) {
-        printf("  fmi3GetNominalsOfContinuousStates() failed\n");
+    fmi4c_setSolverStepSize(solver, (solverMethod == fmi4cSolverEuler || solverMethod == fmi4cSolverRungeKutta4) ? stepSize : 0, 0, 0);
+    fmi4c_setSolverTolerance(solver, tolerance, tolerance);
+    fmi4c_setSolverStopTime(solver, stopTime);
+    fmi4c_setSolverDenseOutput(solver, numInputs == 0);
+    if(!fmi4c_setSolverNumberOfEventIndicators(solver, nEventIndicators)) {
+        printf("  fmi4c_setSolverNumberOfEventIndicators() failed\n");
         exit(1);
     }
-    status = fmi3_getEventIndicators(instance, eventIndicators, nEventIndicators);
-    if(status != fmi3OK) {
-        printf("  fmi3GetEventIndicators() failed\n");
+
+    //Perform event iteration and initialize solver
+    fmi4cSolverStatus solverStatus = fmi4c_handleSolverEvent(solver, startTime);
+    if(solverStatus == fmi4cSolverError) {
+        printf("  fmi4c_handleSolverEvent() failed\n");
         exit(1);
     }
+    if(solverStatus == fmi4cSolverTerminate) {
+        fmi4c_freeSolver(solver);
+        return 1;
+    }
 
-    if(outputCsvPath != NULL) {
-        outputFile = fopen(outputCsvPath, "w");
-        if(outputFile != NULL) {
-            fprintf(outputFile,"time");
-            for(int i=0; i<numOutputs; ++i) {
-                fprintf(outputFile,",%s",fmi3_getVariableName(fmi3_getVariableByValueReference(fmu, outputRefs[i])));
-            }
-            fprintf(outputFile,"\n");
-        }
+    const char *outputNames[VAR_MAX];
+    for(int i=0; i<numOutputs; ++i) {
+        outputNames[i] = fmi3_getVariableName(fmi3_getVariableByValueReference(fmu, outputRefs[i]));
+    }
+    if(!resolveInputsFMI3(fmu)) {
+        fmi4c_freeSolver(solver);
+        return 1;
     }
+    openResultFile(numOutputs, outputNames);
 
     printf("  Simulating from %f to %f with a step size of %f...\n",startTime, stopTime, stepSize);
 
     double time=startTime;
-    while(time <= stopTime) {
-        if(terminateSimulation || terminateSimulation) {
+    while(time < stopTime) {
+        if(terminateSimulation) {
             printf("Terminating simulation at time = %f\n", time);
             break;
         }
 
-        fmi3_getContinuousStateDerivatives(instance, derivatives, nStates);
-
-        fmi3_setTime(instance, time);
-
-        //Interpolate inputs from CSV file
-        for(int i=1; i<nInterpolators; ++i) {
-            fmi3VariableHandle *var = fmi3_getVariableByName(fmu, interpolationData[i].name);
-            if(var == NULL) {
-                printf("Variable in input file does not exist in FMU: %s\n", interpolationData[i].name);
-                free(derivatives);
-                free(eventIndicatorsPrev);
-                free(rootsFound);
-                free(states);
-                free(nominalStates);
-                free(eventIndicators);
-                return 1;
+        //Interpolate inputs from input file
+        if(interpolateInputs(time, false)) {
+            fmi3_setFloat64(instance, inputRefs, numInputs, inputValues, numInputs);
+        }
+
+        //Handle events (state events, time events and step events are located by the solver)
+        if(callEventUpdate) {
+            solverStatus = fmi4c_handleSolverEvent(solver, time);
+            if(solverStatus == fmi4cSolverError) {
+                printf("  fmi4c_handleSolverEvent() failed\n");
+                exit(1);
+            }
+            terminateSimulation = (solverStatus == fmi4cSolverTerminate);
+            callEventUpdate = fmi3False;
+            if(terminateSimulation) {
+                continue;
+            }
+
+            //Write the outputs after the event, at the same time as the ones before it
+            if(resultWriter != NULL) {
+                double values[VAR_MAX];
+                for(int i=0; i<numOutputs; ++i) {
+                    fmi3_getFloat64(instance, &outputRefs[i], 1, &values[i], 1);
+                }
+                writeResult(time, values, false);
             }
-            fmi3Float64 value = interpolate(&interpolationData[0], &interpolationData[i], time, dataSize);
-            fmi3ValueReference vr = fmi3_getVariableValueReference(var);
-            fmi3_setFloat64(instance, &vr, 1, &value, 1);
         }
 
-        //Integrate one step
-        for(size_t i=0; i<nStates; ++i) {
-            states[i] += stepSize*derivatives[i]; // forward Euler method
+        //Integrate one communication step
+        double nextTime = time+stepSize;
+        if(nextTime > stopTime) {
+            nextTime = stopTime;
+        }
+        solverStatus = fmi4c_integrateSolver(solver, nextTime);
+        if(solverStatus == fmi4cSolverError) {
+            printf("  fmi4c_integrateSolver() failed\n");
+            exit(1);
         }
+        callEventUpdate = (solverStatus == fmi4cSolverEnterEventMode);
+        terminateSimulation = (solverStatus == fmi4cSolverTerminate);
+        time = fmi4c_getSolverTime(solver);
 
-        fmi3_setContinuousStates(instance, states, nStates);
+        //Write all output variables to result file
+        if(resultWriter != NULL) {
+            double values[VAR_MAX];
+            for(int i=0; i<numOutputs; ++i) {
+                fmi3_getFloat64(instance, &outputRefs[i], 1, &values[i], 1);
+            }
+            writeResult(time, values, callEventUpdate);
+        }
+    }
 
-        // get event indicators at t = time
-        fmi3_getEventIndicators(instance, eventIndicators, nEventIndicators);
+    fmi4cSolverStatistics statistics;
+    fmi4c_getSolverStatistics(solver, &statistics);
+    printf("  Solver statistics: %zu steps, %zu rejected steps, %zu derivative evaluations, %zu Jacobian evaluations, %zu state events\n",
+           statistics.nSteps, statistics.nRejectedSteps, statistics.nDerivativeEvaluations, statistics.nJacobianEvaluations, statistics.nStateEvents);
 
-        stateEvent = fmi3False;
+    fmi4c_freeSolver(solver);
+    closeResultFile();
+    printf("  Simulation finished.\n");
 
-        for (size_t i = 0; i < nEventIndicators; ++i) {
+    fmi3_terminate(instance);
 
-            // check for zero crossings
-            if(eventIndicatorsPrev[i] < 0 && eventIndicators[i] >= 0) {
-                rootsFound[i] = 1;
-            }
-            else if (eventIndicatorsPrev[i] > 0 && eventIndicators[i] <= 0) {
-                rootsFound[i] = -1;
-            } else {
-                rootsFound[i] = 0;
-            }
+    printf("  FMU successfully terminated.\n");
+
+    fmi3_freeInstance(instance);
+
+    return 0;
+}
 
-            stateEvent |= rootsFound[i];
 
-            eventIndicatorsPrev[i] = eventIndicators[i];
+int testFMI3SE(fmuHandle *fmu, bool realTime, bool overrideStopTime, double stopTimeOverride, bool overrideTimeStep, double timeStepOverride)
+{
+    fmi3Status status;
+
+    fmi4cScheduler *scheduler = fmi4c_createScheduler(fmu, fmi3False, fmi3True, fmu, fmi4c_loggerFmi3, realTime);
+    if(scheduler == NULL) {
+        printf("fmi4c_createScheduler() failed\n");
+        exit(1);
+    }
+    fmi3InstanceHandle *instance = fmi4c_getSchedulerInstance(scheduler);
+    printf("  FMU successfully instantiated!\n");
+
+    double startTime = 0;
+    double stepSize = 0.001;
+    double stopTime = 1;
+
+    if(fmi3_defaultStartTimeDefined(fmu)) {
+        startTime = fmi3_getDefaultStartTime(fmu);
+    }
+    if(overrideTimeStep) {
+        stepSize = timeStepOverride;
+    }
+    else if(fmi3_defaultStepSizeDefined(fmu)) {
+        stepSize = fmi3_getDefaultStepSize(fmu);
+    }
+    if(overrideStopTime) {
+        stopTime = stopTimeOverride;
+    }
+    else if(fmi3_defaultStopTimeDefined(fmu)) {
+        stopTime = fmi3_getDefaultStopTime(fmu);
+    }
+
+    status = fmi3_enterInitializationMode(instance, fmi3False, 0, startTime, fmi3True, stopTime);
+    if(status != fmi3OK) {
+        printf("  fmi3EnterInitializationMode() failed\n");
+        exit(1);
+    }
+    status = fmi3_exitInitializationMode(instance);
+    if(status != fmi3OK) {
+        printf("  fmi3ExitInitializationMode() failed\n");
+        exit(1);
+    }
+    printf("  FMU successfully initialized!\n");
+
+    //Print all Float64 variables that are not inputs
+    fmi3ValueReference printRefs[VAR_MAX];
+    int numPrintRefs = 0;
+    size_t nVariables = (size_t)fmi3_getNumberOfVariables(fmu);
+    for(size_t i=0; i<nVariables && numPrintRefs < VAR_MAX; ++i) {
+        fmi3VariableHandle *var = fmi3_getVariableByIndex(fmu, i+1);
+        if(fmi3_getVariableDataType(var) == fmi3DataTypeFloat64 && fmi3_getVariableCausality(var) != fmi3CausalityInput) {
+            printRefs[numPrintRefs++] = fmi3_getVariableValueReference(var);
         }
+    }
 
-        //Print all output variables to CSV file
-        double value;
-        if(outputFile != NULL) {
-            fprintf(outputFile,"%f",time);
-            for(int i=0; i<numOutputs; ++i) {
-                fmi3_getFloat64(instance, &outputRefs[i], 1, &value, 1 );
-                fprintf(outputFile,",%f",value);
-            }
-            fprintf(outputFile,"\n");
+    printf("  Running scheduled execution from %f to %f with a step size of %f...\n", startTime, stopTime, stepSize);
+    const char *outputNames[VAR_MAX];
+    for(int i=0; i<numPrintRefs; ++i) {
+        outputNames[i] = fmi3_getVariableName(fmi3_getVariableByValueReference(fmu, printRefs[i]));
+    }
+    if(!resolveInputsFMI3(fmu)) {
+        return 1;
+    }
+    openResultFile(numPrintRefs, outputNames);
+    double time=startTime;
+    while(time <= stopTime) {
+
+        //Interpolate inputs from input file
+        if(interpolateInputs(time, false)) {
+            fmi3_setFloat64(instance, inputRefs, numInputs, inputValues, numInputs);
         }
 
-        fmi3_completedIntegratorStep(instance, fmi3True, &stepEvent, &terminateSimulation);
+        //Activate all partitions due in this step
+        if(!fmi4c_runScheduler(scheduler, time, time+stepSize)) {
+            printf("  fmi4c_runScheduler() failed\n");
+            exit(1);
+        }
 
+        //Write variables to result file
+        if(resultWriter != NULL) {
+            double values[VAR_MAX];
+            for(int i=0; i<numPrintRefs; ++i) {
+                fmi3_getFloat64(instance, &printRefs[i], 1, &values[i], 1);
+            }
+            writeResult(time, values, false);
+        }
         time+=stepSize;
     }
-    free(derivatives);
-    free(eventIndicatorsPrev);
-    free(rootsFound);
-    free(states);
-    free(nominalStates);
-    free(eventIndicators);
-    printf("  Simulation finished.\n");
+    closeResultFile();
+    printf("  Scheduled execution finished.\n");
 
-    fmi3_terminate(instance);
+    for(int i=0; i<fmi4c_getSchedulerNumberOfClocks(scheduler); ++i) {
+        fmi3ValueReference vr = fmi4c_getSchedulerClockValueReference(scheduler, i);
+        printf("  Clock %s: %zu activations, %zu deadline misses, max response time %g s\n",
+               fmi3_getVariableName(fmi3_getVariableByValueReference(fmu, vr)),
+               fmi4c_getSchedulerNumberOfActivations(scheduler, vr),
+               fmi4c_getSchedulerNumberOfDeadlineMisses(scheduler, vr),
+               fmi4c_getSchedulerMaxResponseTime(scheduler, vr));
+    }
 
+    fmi3_terminate(instance);
     printf("  FMU successfully terminated.\n");
 
-    fmi3_freeInstance(instance);
+    fmi4c_freeScheduler(scheduler);
 
     return 0;
 }
 
-
 int testFMI3(fmuHandle *fmu, bool forceModelExchange, bool forceCosimulation, bool overrideStopTime, double stopTimeOverride, bool overrideTimeStep, double timeStepOverride)
 {
     //Loop through variables in FMU
@@ -3,11 +3,7 @@
 
 #include "fmi4c_types_fmi3.h"
 
-void loggerFmi3(fmi3InstanceEnvironment instanceEnvironment,
-                fmi3Status status,
-                fmi3String category,
-                fmi3String message);
-
 int testFMI3(fmuHandle *fmu, bool forceModelExchange, bool forceCosimulation, bool overrideStopTime, double stopTimeOverride, bool overrideTimeStep, double timeStepOverride);
+int testFMI3SE(fmuHandle *fmu, bool realTime, bool overrideStopTime, double stopTimeOverride, bool overrideTimeStep, double timeStepOverride);
 
 #endif //FMIC_TEST_FMI3_H
@@ -0,0 +1,177 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "fmi4c.h"
+#include "fmi4c_jacobian.h"
+#include "fmi4c_logger.h"
+#include "fmi4c_test.h"
+#include "fmi4c_test_jacobian.h"
+
+#define N_STATES 8      //Same dimensions as the linear system test FMU
+#define N_OUTPUTS 2
+
+//Known dense state Jacobian of the linear system test FMU: tridiagonal, with -(i+1) on the diagonal,
+//1 above it and 0.5 below it
+static double getExpectedStateElement(int row, int column)
+{
+    if(column == row) {
+        return -(row+1);
+    }
+    if(column == row+1) {
+        return 1;
+    }
+    if(column == row-1) {
+        return 0.5;
+    }
+    return 0;
+}
+
+//Known dense output Jacobian of the linear system test FMU: y1 = x1 + 2*x8, y2 = 3*x4
+static double getExpectedOutputElement(int row, int column)
+{
+    static const double expected[N_OUTPUTS][N_STATES] = {
+        { 1, 0, 0, 0, 0, 0, 0, 2 },
+        { 0, 0, 0, 3, 0, 0, 0, 0 }
+    };
+    return expected[row][column];
+}
+
+//Checks the CSR structure and values of an evaluated Jacobian against the non-zeros of the expected dense
+//Jacobian, that no two columns of the same color share a row, and that the number of colors is within the bound
+static int checkJacobian(fmi4cJacobian *jacobian, const char *name, int nRows, double (*getExpected)(int, int), int maxColors,
+                         bool directional, double tolerance)
+{
+    int nErrors = 0;
+    const size_t *rowPointers = fmi4c_getJacobianRowPointers(jacobian);
+    const size_t *columnIndices = fmi4c_getJacobianColumnIndices(jacobian);
+    const double *values = fmi4c_getJacobianValues(jacobian);
+    const int *colors = fmi4c_getJacobianColumnColors(jacobian);
+    int nColors = fmi4c_getJacobianNumberOfColors(jacobian);
+    printf("  %s Jacobian (%s): %zux%zu, %zu non-zeros, %d colors (at most %d expected)\n", name,
+           directional ? "directional derivatives" : "finite differences",
+           fmi4c_getJacobianNumberOfRows(jacobian), fmi4c_getJacobianNumberOfColumns(jacobian),
+           fmi4c_getJacobianNumberOfNonZeros(jacobian), nColors, maxColors);
+    if(fmi4c_getJacobianNumberOfRows(jacobian) != (size_t)nRows || fmi4c_getJacobianNumberOfColumns(jacobian) != N_STATES) {
+        printf("  Expected %dx%d\n", nRows, N_STATES);
+        return 1;
+    }
+    if(fmi4c_getJacobianUsesDirectionalDerivatives(jacobian) != directional) {
+        printf("  Wrong evaluation method\n");
+        ++nErrors;
+    }
+    if(nColors > maxColors) {
+        ++nErrors;
+    }
+
+    size_t k = 0;
+    if(rowPointers[0] != 0) {
+        printf("  First row pointer is %zu\n", rowPointers[0]);
+        ++nErrors;
+    }
+    for(int i=0; i<nRows; ++i) {
+        for(int j=0; j<N_STATES; ++j) {
+            double expected = getExpected(i, j);
+            if(expected == 0) {
+                continue;
+            }
+            if(k >= rowPointers[i+1] || columnIndices[k] != (size_t)j) {
+                printf("  Row %d: element in column %d is missing from the sparsity pattern\n", i, j);
+                ++nErrors;
+                continue;
+            }
+            if(fabs(values[k]-expected) > tolerance) {
+                printf("  Row %d, column %d: %g, expected %g\n", i, j, values[k], expected);
+                ++nErrors;
+            }
+            for(size_t l=rowPointers[i]; l<k; ++l) {
+                if(colors[columnIndices[l]] == colors[j]) {
+                    printf("  Row %d: columns %zu and %d have the same color\n", i, columnIndices[l], j);
+                    ++nErrors;
+                }
+            }
+            ++k;
+        }
+        if(k != rowPointers[i+1]) {
+            printf("  Row %d: %zu non-zeros, expected %zu\n", i, rowPointers[i+1]-rowPointers[i], k-rowPointers[i]);
+            ++nErrors;
+            k = rowPointers[i+1];
+        }
+    }
+
+    double dense[N_OUTPUTS > N_STATES ? N_OUTPUTS*N_STATES : N_STATES*N_STATES];
+    fmi4c_getJacobianDense(jacobian, dense);
+    for(int i=0; i<nRows; ++i) {
+        for(int j=0; j<N_STATES; ++j) {
+            if(fabs(dense[i*N_STATES+j]-getExpected(i, j)) > tolerance) {
+                printf("  Dense row %d, column %d: %g, expected %g\n", i, j, dense[i*N_STATES+j], getExpected(i, j));
+                ++nErrors;
+            }
+        }
+    }
+    return nErrors;
+}
+
+//Evaluates the state and output Jacobians of the linear system test FMU from colored directional derivatives
+//and from forced colored finite differences, and compares them with the known dense Jacobians
+int testJacobian(fmuHandle *fmu)
+{
+    if(fmi4c_getFmiVersion(fmu) != fmiVersion2 || !fmi2_getSupportsModelExchange(fmu) || fmi2_getNumberOfContinuousStates(fmu) != N_STATES) {
+        printf("Jacobian test requires the FMI 2 linear system test FMU\n");
+        return 1;
+    }
+
+    printf("--- Test sparse Jacobians ---\n");
+    fmi2InstanceHandle *instance = fmi2_instantiate(fmu, fmi2ModelExchange, fmi4c_loggerFmi2, calloc, free, NULL, NULL, fmi2False, fmi2True);
+    if(instance == NULL ||
+       fmi2_setupExperiment(instance, fmi2False, 0, 0, fmi2False, 0) != fmi2OK ||
+       fmi2_enterInitializationMode(instance) != fmi2OK ||
+       fmi2_exitInitializationMode(instance) != fmi2OK) {
+        printf("  Failed to instantiate FMU\n");
+        return 1;
+    }
+    double states[N_STATES];
+    for(int i=0; i<N_STATES; ++i) {
+        states[i] = i-2.5;
+    }
+    fmi2_enterContinuousTimeMode(instance);
+    fmi2_setContinuousStates(instance, states, N_STATES);
+
+    //Tridiagonal columns need three colors, and the output rows share at most two columns. Finite differences
+    //of a linear model only carry the rounding error of increments of sqrt(DBL_EPSILON) relative to the states.
+    int nErrors = 0;
+    for(int method=0; method<2; ++method) {
+        bool directional = (method == 0);
+        double tolerance = directional ? 1e-12 : 1e-6;
+        fmi4cJacobian *jacobians[2] = { fmi4c_createStateJacobianFmi2(instance, N_STATES), fmi4c_createOutputJacobianFmi2(instance, N_STATES) };
+        for(int i=0; i<2; ++i) {
+            if(jacobians[i] == NULL || !fmi4c_setJacobianUsesDirectionalDerivatives(jacobians[i], directional) ||
+               !fmi4c_evaluateJacobian(jacobians[i], states, NULL, NULL)) {
+                printf("  Jacobian evaluation failed\n");
+                ++nErrors;
+            }
+            else if(i == 0) {
+                nErrors += checkJacobian(jacobians[i], "State", N_STATES, getExpectedStateElement, 3, directional, tolerance);
+            }
+            else {
+                nErrors += checkJacobian(jacobians[i], "Output", N_OUTPUTS, getExpectedOutputElement, 2, directional, tolerance);
+            }
+            if(jacobians[i] != NULL) {
+                fmi4c_freeJacobian(jacobians[i]);
+            }
+        }
+
+        //Finite differences must leave the FMU at the unperturbed states
+        double restored[N_STATES];
+        fmi2_getContinuousStates(instance, restored, N_STATES);
+        for(int i=0; i<N_STATES; ++i) {
+            if(restored[i] != states[i]) {
+                printf("  State %d is %g after evaluation, expected %g\n", i, restored[i], states[i]);
+                ++nErrors;
+            }
+        }
+    }
+    fmi2_terminate(instance);
+    fmi2_freeInstance(instance);
+    return nErrors == 0 ? 0 : 1;
+}
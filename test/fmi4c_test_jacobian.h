@@ -0,0 +1,8 @@
+#ifndef FMIC_TEST_JACOBIAN_H
+#define FMIC_TEST_JACOBIAN_H
+
+#include "fmi4c.h"
+
+int testJacobian(fmuHandle *fmu);
+
+#endif //FMIC_TEST_JACOBIAN_H
@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fmi4c.h"
+#include "fmi4c_logger.h"
+#include "fmi4c_threads.h"
+#include "fmi4c_test.h"
+#include "fmi4c_test_logger.h"
+
+#define N_LOGGING_THREADS 4
+#define RING_SIZE 64
+
+typedef struct {
+    int thread;
+    int nMessages;
+} loggingThread_t;
+
+//Logs numbered messages with raw arguments, plus messages that must be filtered out
+static void logMessages(void *arg)
+{
+    loggingThread_t *context = (loggingThread_t*)arg;
+    for(int i=0; i<context->nMessages; ++i) {
+        fmi4c_loggerFmi2(NULL, "instance", fmi2OK, "logAll", "thread %d message %d value %g", context->thread, i, 0.5*i);
+        fmi4c_loggerFmi2(NULL, "instance", fmi2OK, "logDisabled", "disabled category %d", i);
+    }
+}
+
+//Logs from several threads, flushes, and checks that every written message appears once and in order per thread,
+//that written and dropped messages add up to the logged ones, and that no message of a disabled category is written
+static int testLoggerThreads(int nMessages, bool expectComplete)
+{
+    FILE *output = tmpfile();
+    fmi4cLogger *logger = fmi4c_createLogger(output, fmi4cLogLevelDebug, RING_SIZE);
+    if(output == NULL || logger == NULL) {
+        printf("  Failed to create logger\n");
+        return 1;
+    }
+    fmi4c_setLoggerCategoryEnabled(logger, "logToggled", false);
+    fmi4c_setLoggerCategoryEnabled(logger, "logDisabled", false);
+    fmi4c_setActiveLogger(logger);
+
+    fmi4cThread_t threads[N_LOGGING_THREADS];
+    loggingThread_t contexts[N_LOGGING_THREADS];
+    for(int t=0; t<N_LOGGING_THREADS; ++t) {
+        contexts[t].thread = t;
+        contexts[t].nMessages = nMessages;
+        if(!fmi4c_threadCreate(&threads[t], logMessages, &contexts[t])) {
+            printf("  Failed to start logging thread\n");
+            return 1;
+        }
+    }
+    //Toggle a category while the threads log, the first time moves the entry of "logDisabled", then its entry is retired and reused
+    for(int i=0; i<1000; ++i) {
+        fmi4c_setLoggerCategoryEnabled(logger, "logToggled", true);
+        fmi4c_setLoggerCategoryEnabled(logger, "logToggled", false);
+    }
+    for(int t=0; t<N_LOGGING_THREADS; ++t) {
+        fmi4c_threadJoin(threads[t]);
+    }
+    fmi4c_flushLogger(logger);
+    size_t nDropped = fmi4c_getLoggerNumberOfDroppedMessages(logger);
+    size_t nTruncated = fmi4c_getLoggerNumberOfTruncatedMessages(logger);
+    fmi4c_freeLogger(logger);
+
+    int nErrors = 0;
+    int last[N_LOGGING_THREADS];
+    size_t nWritten = 0;
+    for(int t=0; t<N_LOGGING_THREADS; ++t) {
+        last[t] = -1;
+    }
+    rewind(output);
+    char line[512];
+    while(fgets(line, sizeof(line), output) != NULL) {
+        int thread, message;
+        double value;
+        const char *text = strstr(line, "logAll: ");
+        if(strncmp(line, "[OK] instance ", 14) != 0 || text == NULL ||
+           sscanf(text, "logAll: thread %d message %d value %lf", &thread, &message, &value) != 3 ||
+           thread < 0 || thread >= N_LOGGING_THREADS || value != 0.5*message) {
+            printf("  Unexpected line: %s", line);
+            ++nErrors;
+            continue;
+        }
+        if(message <= last[thread] || message >= nMessages) {
+            printf("  Message %d from thread %d after message %d\n", message, thread, last[thread]);
+            ++nErrors;
+        }
+        last[thread] = message;
+        ++nWritten;
+    }
+    fclose(output);
+
+    size_t nLogged = (size_t)N_LOGGING_THREADS*(size_t)nMessages;
+    printf("  %zu messages logged from %d threads: %zu written, %zu dropped, %zu truncated\n",
+           nLogged, N_LOGGING_THREADS, nWritten, nDropped, nTruncated);
+    if(nWritten+nDropped != nLogged || nTruncated != 0 || (expectComplete && nDropped != 0)) {
+        ++nErrors;
+    }
+    return nErrors;
+}
+
+//Tests the asynchronous logger, first with fewer messages per thread than the ring size so that nothing may be
+//lost, and then with enough messages to overflow the rings
+int testLogger(void)
+{
+    printf("--- Test asynchronous logger ---\n");
+    int nErrors = testLoggerThreads(RING_SIZE-1, true);
+    nErrors += testLoggerThreads(100*RING_SIZE, false);
+    return nErrors == 0 ? 0 : 1;
+}
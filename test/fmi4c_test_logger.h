@@ -0,0 +1,6 @@
+#ifndef FMIC_TEST_LOGGER_H
+#define FMIC_TEST_LOGGER_H
+
+int testLogger(void);
+
+#endif //FMIC_TEST_LOGGER_H
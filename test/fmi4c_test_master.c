@@ -0,0 +1,336 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fmi4c.h"
+#include "fmi4c_async.h"
+#include "fmi4c_master.h"
+#include "fmi4c_test.h"
+#include "fmi4c_test_master.h"
+
+//Creates and initializes one co-simulation instance, and adds it to the master
+static bool addInstance(fmuHandle *fmu, fmi4cMaster *master, double startTime, double stopTime, void **instance)
+{
+    *instance = createInstance(fmu, false, startTime, stopTime);
+    if(*instance == NULL) {
+        return false;
+    }
+    if(fmi4c_getFmiVersion(fmu) == fmiVersion2) {
+        return fmi4c_addMasterSubsystemFmi2(master, (fmi2InstanceHandle*)*instance) >= 0;
+    }
+    return fmi4c_addMasterSubsystemFmi3(master, (fmi3InstanceHandle*)*instance) >= 0;
+}
+
+typedef struct {
+    fmiVersion_t version;
+    volatile int failed;
+    volatile int terminated;
+} asyncContext_t;
+
+//Completion callback for asynchronous steps, records failures and termination requests
+static void stepFinished(fmi4cStepFuture *future, void *userData)
+{
+    asyncContext_t *context = (asyncContext_t*)userData;
+    if(context->version == fmiVersion2) {
+        if(fmi2_getStepStatus(future) > fmi2Warning) {
+            context->failed = 1;
+        }
+    }
+    else {
+        fmi3Boolean terminateSimulation = fmi3False;
+        if(fmi3_getStepStatus(future, NULL, &terminateSimulation, NULL, NULL) > fmi3Warning) {
+            context->failed = 1;
+        }
+        if(terminateSimulation) {
+            context->terminated = 1;
+        }
+    }
+}
+
+//Steps all instances concurrently with asynchronous steps, with the same (Jacobi) coupling as the master
+static bool doAsyncStep(fmuHandle *fmu, void **instances, fmi4cStepFuture **futures, int nInstances, asyncContext_t *context, double time, double stepSize)
+{
+    for(int i=nInstances-1; i>0; --i) {
+        setInput(fmu, instances[i], getOutput(fmu, instances[i-1]));
+    }
+    for(int i=0; i<nInstances; ++i) {
+        if(context->version == fmiVersion2) {
+            futures[i] = fmi2_doStepAsync((fmi2InstanceHandle*)instances[i], time, stepSize, fmi2True);
+        }
+        else {
+            futures[i] = fmi3_doStepAsync((fmi3InstanceHandle*)instances[i], time, stepSize, fmi3True);
+        }
+        if(futures[i] == NULL) {
+            context->failed = 1;
+        }
+        else {
+            fmi4c_setStepCallback(futures[i], stepFinished, context);
+        }
+    }
+    fmi4c_waitAllSteps(futures, (size_t)nInstances);
+    for(int i=0; i<nInstances; ++i) {
+        fmi4c_freeStep(futures[i]);
+    }
+    return !context->failed;
+}
+
+//Frees the instances of a chain
+static void freeInstances(fmuHandle *fmu, void **instances, int nInstances)
+{
+    for(int i=0; i<nInstances; ++i) {
+        if(instances[i] != NULL) {
+            freeInstance(fmu, instances[i]);
+        }
+    }
+    free(instances);
+}
+
+//Simulates a chain of instances of the test FMU, where the output of each instance drives the input of the next.
+//The final outputs of all instances are returned in outputs, and the number of communication steps in nSteps.
+//With adaptive steps, the largest coupling error of an accepted step relative to the tolerance is returned in
+//maxCouplingError. Settings and statistics are only printed, and results only written, if verbose is set.
+static bool simulateChain(fmuHandle *fmu, int nInstances, int nThreads, bool gaussSeidel, bool workStealing, bool async, double tolerance,
+                          double startTime, double stopTime, double stepSize, bool verbose, double *outputs, size_t *nSteps, double *maxCouplingError)
+{
+    fmiVersion_t version = fmi4c_getFmiVersion(fmu);
+    fmi4cMaster *master = fmi4c_createMaster();
+    void **instances = calloc((size_t)nInstances, sizeof(void*));
+    if(master == NULL || instances == NULL) {
+        printf("  Failed to create master\n");
+        return false;
+    }
+    bool ok = true;
+    for(int i=0; ok && i<nInstances; ++i) {
+        if(!addInstance(fmu, master, startTime, stopTime, &instances[i])) {
+            printf("  Failed to instantiate and initialize instance %i\n", i);
+            ok = false;
+        }
+        else if(i > 0 && !fmi4c_addMasterConnection(master, i-1, VR_X, i, VR_DX)) {
+            printf("  Failed to connect instance %i to instance %i\n", i-1, i);
+            ok = false;
+        }
+    }
+    fmi4cStepFuture **futures = NULL;
+    asyncContext_t context = { version, 0, 0 };
+    if(async) {
+        futures = calloc((size_t)nInstances, sizeof(fmi4cStepFuture*));
+        fmi4c_setStepExecutorThreads(nThreads);
+    }
+    fmi4c_setMasterMethod(master, gaussSeidel ? fmi4cMasterGaussSeidel : fmi4cMasterJacobi);
+    fmi4c_setMasterThreads(master, nThreads, true);
+    fmi4c_setMasterWorkStealing(master, workStealing);
+    if(tolerance > 0) {
+        fmi4c_setMasterAdaptiveStep(master, true);
+        fmi4c_setMasterTolerance(master, tolerance, tolerance);
+        fmi4c_setMasterStepSize(master, stepSize, 1e-3*stepSize, stopTime-startTime);
+    }
+    if(ok && async) {
+        if(verbose) {
+            printf("  %i instances stepped asynchronously\n", nInstances);
+        }
+    }
+    else if(ok && !fmi4c_initializeMaster(master)) {
+        printf("  Failed to initialize master\n");
+        ok = false;
+    }
+    else if(ok && verbose) {
+        printf("  %i instances on %i threads, %s stepping%s in %i level(s), %i algebraic loop(s)\n",
+               fmi4c_getMasterNumberOfSubsystems(master), fmi4c_getMasterNumberOfThreads(master), gaussSeidel ? "Gauss-Seidel" : "Jacobi",
+               workStealing ? " with work stealing" : "",
+               fmi4c_getMasterNumberOfLevels(master), fmi4c_getMasterNumberOfAlgebraicLoops(master));
+    }
+
+    if(ok && verbose) {
+        const char *names[] = { "x_first", "x_last" };
+        openResultFile(2, names);
+        printf("  Simulating from %f to %f with a step size of %f...\n", startTime, stopTime, stepSize);
+    }
+    for(int i=0; ok && i<nInstances; ++i) {
+        outputs[i] = getOutput(fmu, instances[i]);
+    }
+    double time = startTime;
+    *nSteps = 0;
+    *maxCouplingError = 0;
+    while(ok && time < stopTime) {
+        //First instance is driven by the input file, or by a unit derivative
+        double dx = getInputValue("dx", time, 1);
+        setInput(fmu, instances[0], dx);
+
+        fmi4cMasterStatus status;
+        if(async) {
+            status = doAsyncStep(fmu, instances, futures, nInstances, &context, time, stepSize) ? fmi4cMasterOK : fmi4cMasterError;
+            if(status == fmi4cMasterOK && context.terminated) {
+                status = fmi4cMasterTerminate;
+            }
+        }
+        else if(tolerance > 0) {
+            status = fmi4c_doMasterAdaptiveStep(master, time, stopTime, &time);
+        }
+        else {
+            status = fmi4c_doMasterStep(master, time, stepSize);
+        }
+        if(status == fmi4cMasterError) {
+            printf("  Master step failed at time %f\n", time);
+            ok = false;
+            break;
+        }
+        if(tolerance <= 0) {
+            time += stepSize;
+        }
+        ++(*nSteps);
+        if(tolerance > 0 && !gaussSeidel) {
+            //Jacobi holds each input at the output of the previous instance from the start of the step
+            for(int i=0; i<nInstances-1; ++i) {
+                double held = outputs[i];
+                outputs[i] = getOutput(fmu, instances[i]);
+                double error = fabs(outputs[i]-held)/(tolerance+tolerance*fmax(fabs(held), fabs(outputs[i])));
+                *maxCouplingError = fmax(*maxCouplingError, error);
+            }
+        }
+        if(verbose && resultWriter != NULL) {
+            double values[2] = { getOutput(fmu, instances[0]), getOutput(fmu, instances[nInstances-1]) };
+            writeResult(time, values, false);
+        }
+        if(status == fmi4cMasterTerminate) {
+            break;
+        }
+    }
+    if(verbose) {
+        closeResultFile();
+    }
+    if(ok) {
+        for(int i=0; i<nInstances; ++i) {
+            outputs[i] = getOutput(fmu, instances[i]);
+        }
+    }
+    if(ok && verbose) {
+        printf("  Simulation finished after %zu steps, x = %g in last instance\n", *nSteps, outputs[nInstances-1]);
+        if(tolerance > 0) {
+            printf("  Adaptive steps: %zu accepted, %zu rejected, %zu doStep calls\n", fmi4c_getMasterNumberOfAcceptedSteps(master), fmi4c_getMasterNumberOfRejectedSteps(master),
+                   (fmi4c_getMasterNumberOfAcceptedSteps(master)+fmi4c_getMasterNumberOfRejectedSteps(master))*(size_t)nInstances);
+        }
+        if(!async) {
+            printf("  Parallel efficiency: %.1f %%, %zu steal(s)\n", 100*fmi4c_getMasterParallelEfficiency(master), fmi4c_getMasterNumberOfSteals(master));
+        }
+    }
+    if(tolerance > 0) {
+        //Rejected steps are rolled back, but their doStep calls count as work
+        *nSteps = fmi4c_getMasterNumberOfAcceptedSteps(master)+fmi4c_getMasterNumberOfRejectedSteps(master);
+    }
+
+    fmi4c_freeMaster(master);
+    if(async) {
+        fmi4c_freeStepExecutor();
+    }
+    free(futures);
+    freeInstances(fmu, instances, nInstances);
+    return ok;
+}
+
+//Returns the largest deviation of the chain outputs from the analytic solution for a unit derivative into the first
+//instance, x_k(t) = (t-d_k)^k/k!, relative to the magnitude of each output. The delay d_k is half a step in the
+//first instance, where the trapezoid rule sees a zero derivative before the first step, plus one step per
+//connection when the outputs are exchanged at the start of the step (Jacobi and asynchronous stepping).
+static double getAnalyticDeviation(const double *outputs, int nInstances, double time, double stepSize, bool delayed)
+{
+    double maxDeviation = 0;
+    for(int k=1; k<=nInstances; ++k) {
+        double delay = 0.5*stepSize + (delayed ? (k-1)*stepSize : 0);
+        double expected = 1;
+        for(int j=1; j<=k; ++j) {
+            expected *= fmax(time-delay, 0)/j;
+        }
+        maxDeviation = fmax(maxDeviation, fabs(outputs[k-1]-expected)/fmax(fabs(expected), 1e-300));
+    }
+    return maxDeviation;
+}
+
+//Simulates a chain of instances of the test FMU, and checks the results against the analytic solution when the
+//chain is driven by a unit derivative. Gauss-Seidel results are compared with a single threaded simulation, and
+//adaptive steps with fixed steps.
+int testMaster(fmuHandle *fmu, int nInstances, int nThreads, bool gaussSeidel, bool workStealing, bool async, double tolerance, bool overrideStopTime, double stopTimeOverride, bool overrideTimeStep, double timeStepOverride)
+{
+    fmiVersion_t version = fmi4c_getFmiVersion(fmu);
+    if((version == fmiVersion2 && !fmi2_getSupportsCoSimulation(fmu)) ||
+       (version == fmiVersion3 && !fmi3_supportsCoSimulation(fmu)) ||
+       version == fmiVersion1) {
+        printf("Master test requires an FMI 2 or FMI 3 FMU for co-simulation\n");
+        return 1;
+    }
+
+    double startTime = 0;
+    double stepSize = 0.001;
+    double stopTime = 1;
+    if(overrideTimeStep) {
+        stepSize = timeStepOverride;
+    }
+    if(overrideStopTime) {
+        stopTime = stopTimeOverride;
+    }
+
+    printf("--- Test co-simulation master ---\n");
+    double *outputs = calloc((size_t)nInstances, sizeof(double));
+    double *reference = calloc((size_t)nInstances, sizeof(double));
+    size_t nSteps = 0;
+    double maxCouplingError = 0;
+    if(outputs == NULL || reference == NULL ||
+       !simulateChain(fmu, nInstances, nThreads, gaussSeidel, workStealing, async, tolerance, startTime, stopTime, stepSize, true, outputs, &nSteps, &maxCouplingError)) {
+        free(outputs);
+        free(reference);
+        return 1;
+    }
+
+    int nErrors = 0;
+    bool unitInput = (inputSignals == NULL || fmi4c_getInputSignalIndex(inputSignals, "dx") < 0);
+    if(!unitInput) {
+        printf("  Chain is driven by the input file, analytic solution not checked\n");
+    }
+    else if(tolerance <= 0) {
+        //The trapezoid rule integrates the polynomial of degree k-1 into instance k with a relative error of order
+        //(k*h/t)^2, which accumulates to order k^3*(h/t)^2 at the end of the chain, where t is the time after the delay
+        double deviation = getAnalyticDeviation(outputs, nInstances, stopTime, stepSize, !gaussSeidel || async);
+        double delayedTime = stopTime-(gaussSeidel && !async ? 0.5 : nInstances-0.5)*stepSize;
+        double maxDeviation = 0.25*pow(nInstances, 3)*pow(stepSize/delayedTime, 2);
+        printf("  Max relative deviation from analytic solution: %g (tolerance %g)\n", deviation, maxDeviation);
+        if(deviation > maxDeviation) {
+            ++nErrors;
+        }
+    }
+
+    if(gaussSeidel && !async) {
+        //Gauss-Seidel steps the instances in a fixed order, so the results must not depend on the number of threads
+        size_t nReferenceSteps;
+        double couplingError;
+        if(!simulateChain(fmu, nInstances, 1, true, false, false, tolerance, startTime, stopTime, stepSize, false, reference, &nReferenceSteps, &couplingError)) {
+            ++nErrors;
+        }
+        else if(nReferenceSteps != nSteps || memcmp(outputs, reference, (size_t)nInstances*sizeof(double)) != 0) {
+            printf("  Gauss-Seidel results differ between %i thread(s) and a single thread\n", nThreads);
+            ++nErrors;
+        }
+        else {
+            printf("  Gauss-Seidel results are identical on a single thread\n");
+        }
+    }
+
+    if(tolerance > 0) {
+        //Every accepted adaptive step must meet the tolerance, with fewer steps than the fixed initial step size
+        size_t nFixedSteps;
+        double couplingError;
+        if(!simulateChain(fmu, nInstances, nThreads, gaussSeidel, workStealing, false, 0, startTime, stopTime, stepSize, false, reference, &nFixedSteps, &couplingError)) {
+            ++nErrors;
+        }
+        else {
+            printf("  %zu adaptive steps (including rejected), %zu fixed steps, max coupling error %g of the tolerance\n",
+                   nSteps, nFixedSteps, maxCouplingError);
+            if(nSteps >= nFixedSteps || maxCouplingError > 1) {
+                ++nErrors;
+            }
+        }
+    }
+
+    free(outputs);
+    free(reference);
+    return nErrors == 0 ? 0 : 1;
+}
@@ -0,0 +1,9 @@
+#ifndef FMIC_TEST_MASTER_H
+#define FMIC_TEST_MASTER_H
+
+#include "fmi4c.h"
+#include <stdbool.h>
+
+int testMaster(fmuHandle *fmu, int nInstances, int nThreads, bool gaussSeidel, bool workStealing, bool async, double tolerance, bool overrideStopTime, double stopTimeOverride, bool overrideTimeStep, double timeStepOverride);
+
+#endif //FMIC_TEST_MASTER_H
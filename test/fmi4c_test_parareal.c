@@ -0,0 +1,148 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fmi4c.h"
+#include "fmi4c_parareal.h"
+#include "fmi4c_threads.h"
+#include "fmi4c_test.h"
+#include "fmi4c_test_parareal.h"
+
+#define COARSE_STEP_FACTOR 100  //Coarse step size relative to the fine step size
+
+//Sets the derivative input from the input file, or a unit derivative (called concurrently by the fine propagators)
+static void setInputs(void *instance, double time, void *userData)
+{
+    setInput((fmuHandle*)userData, instance, getInputValue("dx", time, 1));
+}
+
+//Steps one instance serially with the fine step size, recording the output at the slice boundaries
+static bool simulateSerial(fmuHandle *fmu, void *instance, double startTime, double stopTime, double stepSize, int nSlices, double *values)
+{
+    values[0] = getOutput(fmu, instance);
+    for(int n=0; n<nSlices; ++n) {
+        double sliceStart = startTime+(stopTime-startTime)*n/nSlices;
+        double sliceStop = startTime+(stopTime-startTime)*(n+1)/nSlices;
+        int nSteps = (int)ceil((sliceStop-sliceStart)/stepSize-1e-9);
+        double h = (sliceStop-sliceStart)/nSteps;
+        for(int i=0; i<nSteps; ++i) {
+            double time = sliceStart+i*h;
+            setInputs(instance, time, fmu);
+            bool ok;
+            if(fmi4c_getFmiVersion(fmu) == fmiVersion2) {
+                ok = fmi2_doStep((fmi2InstanceHandle*)instance, time, h, fmi2True) == fmi2OK;
+            }
+            else {
+                bool eventEncountered, terminateSimulation, earlyReturn;
+                double lastT;
+                ok = fmi3_doStep((fmi3InstanceHandle*)instance, time, h, fmi3True, &eventEncountered, &terminateSimulation, &earlyReturn, &lastT) == fmi3OK;
+            }
+            if(!ok) {
+                return false;
+            }
+        }
+        values[n+1] = getOutput(fmu, instance);
+    }
+    return true;
+}
+
+//Benchmarks Parareal against serial stepping of the test FMU, with one fine propagator per thread
+int testParareal(fmuHandle *fmu, int nSlices, int nThreads, bool overrideStopTime, double stopTimeOverride, bool overrideTimeStep, double timeStepOverride)
+{
+    fmiVersion_t version = fmi4c_getFmiVersion(fmu);
+    if((version == fmiVersion2 && !fmi2_getSupportsCoSimulation(fmu)) ||
+       (version == fmiVersion3 && !fmi3_supportsCoSimulation(fmu)) ||
+       version == fmiVersion1) {
+        printf("Parareal test requires an FMI 2 or FMI 3 FMU for co-simulation\n");
+        return 1;
+    }
+
+    double startTime = 0;
+    double stepSize = 0.001;
+    double stopTime = 1;
+    if(overrideTimeStep) {
+        stepSize = timeStepOverride;
+    }
+    if(overrideStopTime) {
+        stopTime = stopTimeOverride;
+    }
+    if(nThreads <= 0) {
+        nThreads = 4;
+    }
+
+    printf("--- Test Parareal ---\n");
+    void *serialInstance = createInstance(fmu, false, startTime, stopTime);
+    void **instances = calloc((size_t)nThreads+1, sizeof(void*));
+    double *serialValues = calloc((size_t)nSlices+1, sizeof(double));
+    fmi4cParareal *parareal = fmi4c_createParareal();
+    if(serialInstance == NULL || instances == NULL || serialValues == NULL || parareal == NULL) {
+        printf("  Failed to create instances\n");
+        return 1;
+    }
+    for(int i=0; i<=nThreads; ++i) {
+        instances[i] = createInstance(fmu, false, startTime, stopTime);
+        bool added = false;
+        if(instances[i] != NULL) {
+            added = (version == fmiVersion2) ? fmi4c_addPararealInstanceFmi2(parareal, (fmi2InstanceHandle*)instances[i])
+                                             : fmi4c_addPararealInstanceFmi3(parareal, (fmi3InstanceHandle*)instances[i]);
+        }
+        if(!added) {
+            printf("  Failed to add instance %i\n", i);
+            return 1;
+        }
+    }
+    unsigned int stateRef = VR_X;
+    fmi4c_setPararealStateVariables(parareal, &stateRef, 1);
+    fmi4c_setPararealInputCallback(parareal, setInputs, fmu);
+    fmi4c_setPararealTimeSlices(parareal, nSlices);
+    fmi4c_setPararealStepSizes(parareal, COARSE_STEP_FACTOR*stepSize, stepSize);
+
+    printf("  Simulating from %f to %f with a fine step size of %f and a coarse step size of %f...\n",
+           startTime, stopTime, stepSize, COARSE_STEP_FACTOR*stepSize);
+    double serialStart = fmi4c_getWallTime();
+    if(!simulateSerial(fmu, serialInstance, startTime, stopTime, stepSize, nSlices, serialValues)) {
+        printf("  Serial simulation failed\n");
+        return 1;
+    }
+    double serialTime = fmi4c_getWallTime()-serialStart;
+
+    double pararealStart = fmi4c_getWallTime();
+    if(!fmi4c_runParareal(parareal, startTime, stopTime)) {
+        printf("  Parareal simulation failed\n");
+        return 1;
+    }
+    double pararealTime = fmi4c_getWallTime()-pararealStart;
+
+    const char *names[] = { "x_serial", "x_parareal" };
+    openResultFile(2, names);
+    double maxDeviation = 0;
+    for(int n=0; n<=nSlices; ++n) {
+        double value = 0;
+        fmi4c_getPararealStateValues(parareal, n, &value);
+        maxDeviation = fmax(maxDeviation, fabs(value-serialValues[n]));
+        if(resultWriter != NULL) {
+            double values[2] = { serialValues[n], value };
+            writeResult(fmi4c_getPararealSliceTime(parareal, n), values, false);
+        }
+    }
+    closeResultFile();
+
+    int nIterations = fmi4c_getPararealNumberOfIterations(parareal);
+    printf("  %i slices on %i fine propagator(s): %i iteration(s), %s, %zu fine slice propagations\n",
+           nSlices, nThreads, nIterations, fmi4c_getPararealConverged(parareal) ? "converged" : "not converged",
+           fmi4c_getPararealNumberOfFinePropagations(parareal));
+    printf("  x = %f (serial %f), max deviation at slice boundaries %g\n", getOutput(fmu, instances[0]), serialValues[nSlices], maxDeviation);
+    printf("  Serial: %.3f ms, Parareal: %.3f ms, speedup %.2f (ideal for %i iteration(s) on %i processor(s): %.2f)\n",
+           1e3*serialTime, 1e3*pararealTime, serialTime/pararealTime, nIterations, nThreads,
+           1.0/((double)nIterations/fmin(nThreads, nSlices)+(double)(nIterations+1)/COARSE_STEP_FACTOR));
+
+    fmi4c_freeParareal(parareal);
+    for(int i=0; i<=nThreads; ++i) {
+        freeInstance(fmu, instances[i]);
+    }
+    freeInstance(fmu, serialInstance);
+    free(instances);
+    free(serialValues);
+    return maxDeviation < 1e-6 ? 0 : 1;
+}
@@ -0,0 +1,9 @@
+#ifndef FMIC_TEST_PARAREAL_H
+#define FMIC_TEST_PARAREAL_H
+
+#include "fmi4c.h"
+#include <stdbool.h>
+
+int testParareal(fmuHandle *fmu, int nSlices, int nThreads, bool overrideStopTime, double stopTimeOverride, bool overrideTimeStep, double timeStepOverride);
+
+#endif //FMIC_TEST_PARAREAL_H
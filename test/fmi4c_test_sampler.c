@@ -0,0 +1,158 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fmi4c.h"
+#include "fmi4c_test.h"
+#include "fmi4c_test_sampler.h"
+
+#define SAMPLER_TEST_FILE "fmi4c_sampler_test.csv"
+#define N_SAMPLES 12
+#define N_ROWS 7
+#define N_COLUMNS 6     //time, x, y, min(x), max(x), mean(x)
+
+//Reads the rows of a CSV result file, skipping the header
+static int readRows(const char *path, double rows[][N_COLUMNS], int maxRows)
+{
+    FILE *file = fopen(path, "r");
+    if(file == NULL) {
+        return -1;
+    }
+    char line[1024];
+    int nRows = 0;
+    bool header = true;
+    while(fgets(line, sizeof(line), file) != NULL) {
+        if(header) {
+            header = false;
+            continue;
+        }
+        if(nRows == maxRows) {
+            ++nRows;
+            break;
+        }
+        char *p = line;
+        for(int i=0; i<N_COLUMNS; ++i) {
+            rows[nRows][i] = strtod(p, &p);
+            if(*p == ',') {
+                ++p;
+            }
+        }
+        ++nRows;
+    }
+    fclose(file);
+    return nRows;
+}
+
+//Sets a deadband after the first rows are recorded, and checks that changes are measured from the last sample
+static int testLateDeadband(void)
+{
+    const char *names[] = { "x" };
+    fmi4cResultSampler *sampler = fmi4c_createResultSampler(1, names);
+    if(sampler == NULL) {
+        printf("  Failed to create result sampler\n");
+        return 1;
+    }
+    fmi4c_setResultSamplingInterval(sampler, INFINITY);
+    fmi4cResultWriter *writer = fmi4c_createResultWriter(SAMPLER_TEST_FILE, fmi4cResultCsv, 1, names);
+    if(writer == NULL || !fmi4c_setResultSamplerWriter(sampler, writer)) {
+        printf("  Failed to create result writer\n");
+        return 1;
+    }
+
+    //Only the first sample and the change by more than 0.5 since 100.2 are recorded
+    double x = 100;
+    fmi4c_sampleResult(sampler, 0, &x, false);
+    x = 100.2;
+    fmi4c_sampleResult(sampler, 1, &x, false);
+    fmi4c_setResultChannelDeadband(sampler, 0, 0.5);
+    x = 100.6;
+    fmi4c_sampleResult(sampler, 2, &x, false);
+    x = 100.8;
+    fmi4c_sampleResult(sampler, 3, &x, false);
+    fmi4cResultSamplerStatistics statistics;
+    fmi4c_getResultSamplerStatistics(sampler, &statistics);
+    fmi4c_freeResultSampler(sampler);
+    fmi4c_closeResultWriter(writer);
+    double rows[3][N_COLUMNS];
+    int nRows = readRows(SAMPLER_TEST_FILE, rows, 3);
+    remove(SAMPLER_TEST_FILE);
+
+    printf("  Deadband set after sampling: %d rows (%zu changes)\n", nRows, statistics.numberOfChangeRows);
+    if(nRows != 2 || statistics.numberOfChangeRows != 1 || rows[0][0] != 0 || rows[1][0] != 3 || rows[1][1] != 100.8) {
+        printf("  Expected rows at 0 and 3 (1 change)\n");
+        return 1;
+    }
+    return 0;
+}
+
+//Passes known samples to a sampler with an output interval, a deadband and aggregation on x, and an
+//event, and checks which rows are recorded and their aggregates, then tests a deadband set while sampling
+int testSampler(void)
+{
+    printf("--- Test result sampler ---\n");
+
+    //Samples every 0.25 s: x jumps at 0.75 (deadband), events at 1.25 (x jumps from 1 to 3), y = 2t
+    static const double times[N_SAMPLES] = { 0, 0.25, 0.5, 0.75, 1, 1.25, 1.25, 1.5, 1.75, 2, 2.25, 2.5 };
+    static const double xs[N_SAMPLES] =    { 0, 0,    0,   1,    1, 1,    3,    3,   3.2,  3.2, 3.2, 3.2 };
+    static const bool events[N_SAMPLES] =  { false, false, false, false, false, true, false, false, false, false, false, false };
+
+    //Expected rows: first sample, change at 0.75, grid at 1, before and after the event, grid at 2, flush at 2.5
+    static const double expected[N_ROWS][N_COLUMNS] = {
+        { 0,    0,   0,   0, 0,   0 },
+        { 0.75, 1,   1.5, 0, 1,   0.125/0.75 },
+        { 1,    1,   2,   1, 1,   1 },
+        { 1.25, 1,   2.5, 1, 1,   1 },
+        { 1.25, 3,   2.5, 1, 3,   3 },
+        { 2,    3.2, 4,   3, 3.2, (0.25*3+0.25*3.1+0.25*3.2)/0.75 },
+        { 2.5,  3.2, 5,   3.2, 3.2, 3.2 }
+    };
+
+    const char *names[] = { "x", "y" };
+    fmi4cResultSampler *sampler = fmi4c_createResultSampler(2, names);
+    if(sampler == NULL) {
+        printf("  Failed to create result sampler\n");
+        return 1;
+    }
+    fmi4c_setResultSamplingInterval(sampler, 1);
+    fmi4c_setResultChannelDeadband(sampler, 0, 0.5);
+    fmi4c_setResultChannelAggregation(sampler, 0, true);
+    fmi4cResultWriter *writer = fmi4c_createResultWriter(SAMPLER_TEST_FILE, fmi4cResultCsv,
+                                                         fmi4c_getResultSamplerNumberOfColumns(sampler),
+                                                         fmi4c_getResultSamplerColumnNames(sampler));
+    if(writer == NULL || !fmi4c_setResultSamplerWriter(sampler, writer)) {
+        printf("  Failed to create result writer\n");
+        return 1;
+    }
+    for(int k=0; k<N_SAMPLES; ++k) {
+        double values[2] = { xs[k], 2*times[k] };
+        fmi4c_sampleResult(sampler, times[k], values, events[k]);
+    }
+    fmi4c_flushResultSampler(sampler);
+    fmi4cResultSamplerStatistics statistics;
+    fmi4c_getResultSamplerStatistics(sampler, &statistics);
+    fmi4c_freeResultSampler(sampler);
+    fmi4c_closeResultWriter(writer);
+
+    int nErrors = 0;
+    double rows[N_ROWS][N_COLUMNS];
+    int nRows = readRows(SAMPLER_TEST_FILE, rows, N_ROWS);
+    remove(SAMPLER_TEST_FILE);
+    printf("  %zu samples, %d rows (%zu on the grid, %zu changes, %zu at events)\n", statistics.numberOfSamples,
+           nRows, statistics.numberOfGridRows, statistics.numberOfChangeRows, statistics.numberOfEventRows);
+    if(nRows != N_ROWS || statistics.numberOfSamples != N_SAMPLES || statistics.numberOfRows != N_ROWS ||
+       statistics.numberOfGridRows != 2 || statistics.numberOfChangeRows != 1 || statistics.numberOfEventRows != 2) {
+        printf("  Expected %d rows (2 on the grid, 1 change, 2 at events)\n", N_ROWS);
+        ++nErrors;
+    }
+    for(int r=0; r<nRows && r<N_ROWS; ++r) {
+        for(int i=0; i<N_COLUMNS; ++i) {
+            if(fabs(rows[r][i]-expected[r][i]) > 1e-12) {
+                printf("  Row %d, column %d: %g, expected %g\n", r, i, rows[r][i], expected[r][i]);
+                ++nErrors;
+            }
+        }
+    }
+    nErrors += testLateDeadband();
+    return nErrors == 0 ? 0 : 1;
+}
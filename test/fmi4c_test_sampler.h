@@ -0,0 +1,6 @@
+#ifndef FMIC_TEST_SAMPLER_H
+#define FMIC_TEST_SAMPLER_H
+
+int testSampler(void);
+
+#endif //FMIC_TEST_SAMPLER_H
@@ -0,0 +1,161 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "fmi4c.h"
+#include "fmi4c_simulation.h"
+#include "fmi4c_threads.h"
+#include "fmi4c_test.h"
+#include "fmi4c_test_simulation.h"
+
+#define INPUT_ROWS 4
+
+//Derivative input table: a ramp up to the middle of the simulation, a jump, and a ramp down
+static void createInputTable(double startTime, double stopTime, double *times, double *values)
+{
+    double middle = 0.5*(startTime+stopTime);
+    times[0] = startTime;   values[0] = 0;
+    times[1] = middle;      values[1] = 2;
+    times[2] = middle;      values[2] = -1;
+    times[3] = stopTime;    values[3] = 0;
+}
+
+//Interpolates the input table the same way as fmi4c_simulateFmi2() and fmi4c_simulateFmi3()
+static double interpolateTable(const double *times, const double *values, double time)
+{
+    int row = 0;
+    while(row+1 < INPUT_ROWS && times[row+1] <= time) {
+        ++row;
+    }
+    if(time < times[0] || row+1 == INPUT_ROWS) {
+        return values[row];
+    }
+    return values[row]+(time-times[row])/(times[row+1]-times[row])*(values[row+1]-values[row]);
+}
+
+//Computes the reference result step by step: co-simulation steps through the API, or the exact
+//integral for model exchange, where the derivative input is constant over every grid interval
+static bool simulateReference(fmuHandle *fmu, bool modelExchange, const double *times, size_t nTimes,
+                              const double *inputTimes, const double *inputValues, double *results)
+{
+    void *instance = createInstance(fmu, false, times[0], times[nTimes-1]);
+    if(instance == NULL) {
+        return false;
+    }
+    bool ok = true;
+    fmi2ValueReference vrs[2] = { VR_DX, VR_X };
+    for(size_t k=0; ok && k<nTimes; ++k) {
+        if(k == 0 || !modelExchange) {
+            double dx = interpolateTable(inputTimes, inputValues, times[k == 0 ? 0 : k-1]);
+            if(fmi4c_getFmiVersion(fmu) == fmiVersion2) {
+                fmi2_setReal((fmi2InstanceHandle*)instance, &vrs[0], 1, &dx);
+                ok = (k == 0 || fmi2_doStep((fmi2InstanceHandle*)instance, times[k-1], times[k]-times[k-1], fmi2True) == fmi2OK);
+                fmi2_getReal((fmi2InstanceHandle*)instance, &vrs[1], 1, &results[k]);
+            }
+            else {
+                fmi3_setFloat64((fmi3InstanceHandle*)instance, &vrs[0], 1, &dx, 1);
+                bool eventEncountered, terminateSimulation, earlyReturn;
+                double lastT;
+                ok = (k == 0 || fmi3_doStep((fmi3InstanceHandle*)instance, times[k-1], times[k]-times[k-1], fmi3True,
+                                            &eventEncountered, &terminateSimulation, &earlyReturn, &lastT) == fmi3OK);
+                fmi3_getFloat64((fmi3InstanceHandle*)instance, &vrs[1], 1, &results[k], 1);
+            }
+        }
+        else {
+            results[k] = results[k-1]+(times[k]-times[k-1])*interpolateTable(inputTimes, inputValues, times[k-1]);
+        }
+    }
+    freeInstance(fmu, instance);
+    return ok;
+}
+
+//Simulates the test FMU with fmi4c_simulateFmi2() or fmi4c_simulateFmi3() and compares with step-by-step simulation
+int testSimulation(fmuHandle *fmu, bool forceModelExchange, bool overrideStopTime, double stopTimeOverride, bool overrideTimeStep, double timeStepOverride)
+{
+    fmiVersion_t version = fmi4c_getFmiVersion(fmu);
+    if(version == fmiVersion1) {
+        printf("Simulation test requires an FMI 2 or FMI 3 FMU\n");
+        return 1;
+    }
+    bool modelExchange = forceModelExchange ||
+                         (version == fmiVersion2 && !fmi2_getSupportsCoSimulation(fmu)) ||
+                         (version == fmiVersion3 && !fmi3_supportsCoSimulation(fmu));
+
+    double startTime = 0;
+    double stepSize = 0.001;
+    double stopTime = 1;
+    if(overrideTimeStep) {
+        stepSize = timeStepOverride;
+    }
+    if(overrideStopTime) {
+        stopTime = stopTimeOverride;
+    }
+
+    printf("--- Test simulation in one call ---\n");
+    size_t nTimes = (size_t)ceil((stopTime-startTime)/stepSize-1e-9)+1;
+    double *times = malloc(nTimes*sizeof(double));
+    double *results = malloc(2*nTimes*sizeof(double));
+    double *referenceResults = malloc(nTimes*sizeof(double));
+    if(times == NULL || results == NULL || referenceResults == NULL) {
+        printf("  Failed to allocate memory\n");
+        return 1;
+    }
+    for(size_t k=0; k<nTimes; ++k) {
+        times[k] = fmin(startTime+(double)k*stepSize, stopTime);
+    }
+    double inputTimes[INPUT_ROWS];
+    double inputValues[INPUT_ROWS];
+    createInputTable(startTime, stopTime, inputTimes, inputValues);
+
+    void *instance = createInstance(fmu, modelExchange, startTime, stopTime);
+    if(instance == NULL) {
+        printf("  Failed to create instance\n");
+        return 1;
+    }
+
+    printf("  Simulating from %f to %f in %s mode with %zu time points...\n", startTime, stopTime,
+           modelExchange ? "model exchange" : "co-simulation", nTimes);
+    unsigned int inputRef = VR_DX;
+    unsigned int outputRefs[2] = { VR_X, VR_DX };
+    double start = fmi4c_getWallTime();
+    bool ok;
+    if(version == fmiVersion2) {
+        ok = fmi4c_simulateFmi2((fmi2InstanceHandle*)instance, modelExchange ? fmi2ModelExchange : fmi2CoSimulation, solverMethod,
+                                times, nTimes, &inputRef, 1, inputTimes, inputValues, INPUT_ROWS, outputRefs, 2, results);
+    }
+    else {
+        ok = fmi4c_simulateFmi3((fmi3InstanceHandle*)instance, modelExchange ? fmi3ModelExchange : fmi3CoSimulation, solverMethod,
+                                times, nTimes, &inputRef, 1, inputTimes, inputValues, INPUT_ROWS, outputRefs, 2, results);
+    }
+    double elapsed = fmi4c_getWallTime()-start;
+    freeInstance(fmu, instance);
+    if(!ok) {
+        printf("  Simulation failed\n");
+        return 1;
+    }
+    if(!simulateReference(fmu, modelExchange, times, nTimes, inputTimes, inputValues, referenceResults)) {
+        printf("  Reference simulation failed\n");
+        return 1;
+    }
+
+    const char *names[] = { "x", "dx", "x_reference" };
+    openResultFile(3, names);
+    double maxDeviation = 0;
+    for(size_t k=0; k<nTimes; ++k) {
+        maxDeviation = fmax(maxDeviation, fabs(results[2*k]-referenceResults[k]));
+        if(resultWriter != NULL) {
+            double values[3] = { results[2*k], results[2*k+1], referenceResults[k] };
+            writeResult(times[k], values, false);
+        }
+    }
+    closeResultFile();
+
+    printf("  x = %f (reference %f), max deviation %g\n", results[2*(nTimes-1)], referenceResults[nTimes-1], maxDeviation);
+    printf("  %.3f ms, %.3f us per time point\n", 1e3*elapsed, 1e6*elapsed/(double)nTimes);
+
+    free(times);
+    free(results);
+    free(referenceResults);
+    return (maxDeviation < 1e-9) ? 0 : 1;
+}
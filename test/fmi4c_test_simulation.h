@@ -0,0 +1,9 @@
+#ifndef FMIC_TEST_SIMULATION_H
+#define FMIC_TEST_SIMULATION_H
+
+#include "fmi4c.h"
+#include <stdbool.h>
+
+int testSimulation(fmuHandle *fmu, bool forceModelExchange, bool overrideStopTime, double stopTimeOverride, bool overrideTimeStep, double timeStepOverride);
+
+#endif //FMIC_TEST_SIMULATION_H
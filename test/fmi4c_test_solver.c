@@ -0,0 +1,122 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "fmi4c.h"
+#include "fmi4c_logger.h"
+#include "fmi4c_solver.h"
+#include "fmi4c_test.h"
+#include "fmi4c_test_solver.h"
+
+#define STOP_TIME 1.0
+#define TARGET_ERROR 1e-4       //Required accuracy of the final states
+#define MIN_SPEEDUP 10          //Required reduction in derivative evaluations compared to forward Euler
+#define MIN_EULER_STEP 1e-7
+
+//Simulates the FMU from its start values to STOP_TIME, and returns the final states and the number of derivative evaluations.
+//Fixed step methods use stepSize, adaptive methods the tolerance.
+static bool simulate(fmuHandle *fmu, size_t nStates, fmi4cSolverMethod method, double stepSize, double tolerance, double *states, size_t *nEvaluations)
+{
+    fmi2InstanceHandle *instance = fmi2_instantiate(fmu, fmi2ModelExchange, fmi4c_loggerFmi2, calloc, free, NULL, NULL, fmi2False, fmi2True);
+    if(instance == NULL ||
+       fmi2_setupExperiment(instance, fmi2False, 0, 0, fmi2True, STOP_TIME) != fmi2OK ||
+       fmi2_enterInitializationMode(instance) != fmi2OK ||
+       fmi2_exitInitializationMode(instance) != fmi2OK) {
+        printf("  Failed to instantiate FMU\n");
+        return false;
+    }
+    fmi4cSolver *solver = fmi4c_createSolverFmi2(instance, nStates, method);
+    if(solver == NULL) {
+        printf("  Failed to create solver\n");
+        fmi2_freeInstance(instance);
+        return false;
+    }
+    bool fixedStep = (method == fmi4cSolverEuler || method == fmi4cSolverRungeKutta4);
+    fmi4c_setSolverStepSize(solver, fixedStep ? stepSize : 0, 0, 0);
+    fmi4c_setSolverTolerance(solver, tolerance, tolerance);
+    fmi4c_setSolverStopTime(solver, STOP_TIME);
+    fmi4cSolverStatus status = fmi4c_handleSolverEvent(solver, 0);
+    while(status != fmi4cSolverError && status != fmi4cSolverTerminate && fmi4c_getSolverTime(solver) < STOP_TIME) {
+        status = fmi4c_integrateSolver(solver, STOP_TIME);
+        if(status == fmi4cSolverEnterEventMode) {
+            status = fmi4c_handleSolverEvent(solver, fmi4c_getSolverTime(solver));
+        }
+    }
+    bool ok = (status != fmi4cSolverError);
+    if(ok) {
+        const double *solverStates = fmi4c_getSolverStates(solver);
+        for(size_t i=0; i<nStates; ++i) {
+            states[i] = solverStates[i];
+        }
+    }
+    fmi4cSolverStatistics statistics;
+    fmi4c_getSolverStatistics(solver, &statistics);
+    *nEvaluations = statistics.nDerivativeEvaluations;
+    fmi4c_freeSolver(solver);
+    fmi2_terminate(instance);
+    fmi2_freeInstance(instance);
+    return ok;
+}
+
+static double getMaxError(const double *states, const double *reference, size_t nStates)
+{
+    double error = 0;
+    for(size_t i=0; i<nStates; ++i) {
+        error = fmax(error, fabs(states[i]-reference[i]));
+    }
+    return error;
+}
+
+//Compares the derivative evaluations of the selected solver with forward Euler, at the same accuracy of the final
+//states. The reference solution is computed with RK4 and tiny steps.
+int testSolverEvaluations(fmuHandle *fmu)
+{
+    if(fmi4c_getFmiVersion(fmu) != fmiVersion2 || !fmi2_getSupportsModelExchange(fmu) || fmi2_getNumberOfContinuousStates(fmu) <= 0) {
+        printf("Solver evaluation test requires an FMI 2 FMU for model exchange with continuous states\n");
+        return 1;
+    }
+    size_t nStates = (size_t)fmi2_getNumberOfContinuousStates(fmu);
+    printf("--- Test solver derivative evaluations ---\n");
+    double *reference = calloc(nStates, sizeof(double));
+    double *states = calloc(nStates, sizeof(double));
+    size_t nEvaluations;
+    if(reference == NULL || states == NULL ||
+       !simulate(fmu, nStates, fmi4cSolverRungeKutta4, 1e-4, 0, reference, &nEvaluations)) {
+        free(reference);
+        free(states);
+        return 1;
+    }
+
+    //The tolerance controls the local error, so aim a decade below the required global error
+    size_t nSolverEvaluations = 0;
+    double solverError = INFINITY;
+    if(simulate(fmu, nStates, solverMethod, 0.01, 0.1*TARGET_ERROR, states, &nSolverEvaluations)) {
+        solverError = getMaxError(states, reference, nStates);
+    }
+    printf("  %s: error %g with %zu derivative evaluations\n", fmi4c_getSolverMethodName(solverMethod), solverError, nSolverEvaluations);
+
+    //Halve the Euler step until it is as accurate as the solver
+    size_t nEulerEvaluations = 0;
+    double eulerError = INFINITY;
+    double eulerStep = 0.01;
+    while(eulerError > fmax(solverError, TARGET_ERROR/1000) && eulerStep >= MIN_EULER_STEP &&
+          simulate(fmu, nStates, fmi4cSolverEuler, eulerStep, 0, states, &nEulerEvaluations)) {
+        eulerError = getMaxError(states, reference, nStates);
+        eulerStep /= 2;
+    }
+    printf("  Forward Euler: error %g with %zu derivative evaluations (step %g)\n", eulerError, nEulerEvaluations, 2*eulerStep);
+    free(reference);
+    free(states);
+
+    int nErrors = 0;
+    if(solverError > TARGET_ERROR) {
+        printf("  Error exceeds %g\n", TARGET_ERROR);
+        ++nErrors;
+    }
+    if(eulerError <= fmax(solverError, TARGET_ERROR/1000) && nEulerEvaluations < MIN_SPEEDUP*nSolverEvaluations) {
+        printf("  Less than %dx fewer derivative evaluations than forward Euler\n", MIN_SPEEDUP);
+        ++nErrors;
+    }
+    printf("  %.1fx fewer derivative evaluations than forward Euler\n", (double)nEulerEvaluations/(double)nSolverEvaluations);
+    return nErrors == 0 ? 0 : 1;
+}
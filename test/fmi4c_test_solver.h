@@ -0,0 +1,8 @@
+#ifndef FMIC_TEST_SOLVER_H
+#define FMIC_TEST_SOLVER_H
+
+#include "fmi4c.h"
+
+int testSolverEvaluations(fmuHandle *fmu);
+
+#endif //FMIC_TEST_SOLVER_H
@@ -2,7 +2,6 @@
 #include <stdlib.h>
 #include <stdarg.h>
 #include <string.h>
-#include <pthread.h>
 #include <math.h>
 
 #ifndef _WIN32
@@ -10,102 +9,25 @@
 #endif
 
 #include "fmi4c.h"
+#include "fmi4c_logger.h"
+#include "fmi4c_master.h"
+#include "fmi4c_tlm.h"
+#include "fmi4c_threads.h"
 #include "fmi4c_common.h"
 #include "fmi4c_test.h"
 #include "fmi4c_test_fmi3.h"
 #include "fmi4c_test_tlm.h"
 
-#define TABLE_SIZE 1500
-
-pthread_mutex_t mutex1 = PTHREAD_MUTEX_INITIALIZER;
-pthread_mutex_t mutex2 = PTHREAD_MUTEX_INITIALIZER;
-
 typedef struct {
     fmuHandle *fmu1;
-    fmi3InstanceHandle *instance1;
-    double table1[2][TABLE_SIZE];
-    size_t table1start;
-    size_t table1end;
-
     fmuHandle *fmu2;
+    fmi3InstanceHandle *instance1;
     fmi3InstanceHandle *instance2;
-    double table2[2][TABLE_SIZE];
-    size_t table2start;
-    size_t table2end;
-
-    double Zc;
-    double dt;
+    fmi4cTlmConnection *connection;
 } tlmContext;
 
 static tlmContext tlm;
 
-double getInterpolatedForce1(double time)
-{
-    while(tlm.table1[0][tlm.table1end] < time) {
-#ifdef _WIN32
-        Sleep(1);
-#else
-        usleep(1000);
-#endif
-    }
-
-    pthread_mutex_lock(&mutex1);
-
-    int i = tlm.table1end;
-
-    //find first element where time is not too small
-    while(tlm.table1[0][i] > time) {
-        --i;
-        if(i < 0) {
-            i = TABLE_SIZE-2;
-        }
-    }
-    int j = i+1;
-
-    double t1 = tlm.table1[0][j];
-    double t2 = tlm.table1[0][i];
-    double x1 = tlm.table1[1][j];
-    double x2 = tlm.table1[1][i];
-
-    double force = x1 + ((x2-x1)/(t2-t1)) * (time - t1);
-    pthread_mutex_unlock(&mutex1);
-    return force;
-}
-
-
-double getInterpolatedForce2(double time)
-{
-    while(tlm.table2[0][tlm.table2end] < time) {
-#ifdef _WIN32
-        Sleep(1);
-#else
-        usleep(1000);
-#endif
-    }
-
-    pthread_mutex_lock(&mutex2);
-
-    int i = tlm.table2end;
-
-    //find first element where time is not too small
-    while(tlm.table2[0][i] > time) {
-        --i;
-        if(i < 0) {
-            i = TABLE_SIZE-2;
-        }
-    }
-    int j = i+1;
-
-    double t1 = tlm.table2[0][j];
-    double t2 = tlm.table2[0][i];
-    double x1 = tlm.table2[1][j];
-    double x2 = tlm.table2[1][i];
-
-    double force = x1 + ((x2-x1)/(t2-t1)) * (time - t1);
-    pthread_mutex_unlock(&mutex2);
-    return force;
-}
-
 void intermediateUpdateTLM(
         fmi3InstanceEnvironment instanceEnvironment,
         fmi3Float64  intermediateUpdateTime,
@@ -123,78 +45,22 @@ void intermediateUpdateTLM(
     fmi3ValueReference vr_v = 0;    //Connection velocity (output)
     fmi3ValueReference vr_f = 1;    //Connection force (input)
 
-    fmi3InstanceHandle *instance = (fmi3InstanceHandle*)instanceEnvironment;
+    //Instance environment is the FMU handle, since the instance does not exist when it is passed
+    int side = (instanceEnvironment == tlm.fmu1) ? 0 : 1;
+    fmi3InstanceHandle *instance = (side == 0) ? tlm.instance1 : tlm.instance2;
     if(intermediateVariableGetAllowed) {
         double v;
         fmi3_getFloat64(instance, &vr_v, 1, &v, 1);
         if(intermediateStepFinished) {
-            if(instance == tlm.instance1) {
-                ++tlm.table2end;
-                while(tlm.table2[0][tlm.table2start] < intermediateUpdateTime - 2*tlm.dt) {
-                    ++tlm.table2start;
-                }
-                if(tlm.table2end > TABLE_SIZE-1) {    //Prevent overflow (circular buffer)
-                    tlm.table2end = 0;
-                }
-                if(tlm.table2start > TABLE_SIZE-1) {
-                    tlm.table2start = 0;
-                }
-                tlm.table2[0][tlm.table2end] = intermediateUpdateTime;
-                double c = getInterpolatedForce1(intermediateUpdateTime - tlm.dt);
-                tlm.table2[1][tlm.table2end] = 2*tlm.Zc*v + c;
-            }
-            if(instance == tlm.instance2) { //!@todo Costly to compare strings
-                ++tlm.table1end;
-                while(tlm.table1[0][tlm.table1start] < intermediateUpdateTime - 2*tlm.dt) {
-                    ++tlm.table1start;
-                }
-                if(tlm.table1end > TABLE_SIZE-1) {    //Prevent overflow (circular buffer)
-                    tlm.table1end = 0;
-                }
-                if(tlm.table1start > TABLE_SIZE-1) {
-                    tlm.table1start = 0;
-                }
-                tlm.table1[0][tlm.table1end] = intermediateUpdateTime;
-                double c = getInterpolatedForce2(intermediateUpdateTime - tlm.dt);
-                tlm.table1[1][tlm.table1end] = 2*tlm.Zc*v + c;
-            }
-        }
-    }
-    if(intermediateVariableGetAllowed && intermediateVariableSetRequested) {
-        double c;
-        if(instance == tlm.instance1) {
-            c = getInterpolatedForce1(intermediateUpdateTime-tlm.dt);
+            fmi4c_publishTlmVelocity(tlm.connection, side, intermediateUpdateTime, v);
         }
-        else {
-            c = getInterpolatedForce2(intermediateUpdateTime-tlm.dt);
+        if(intermediateVariableSetRequested) {
+            double F = fmi4c_getTlmForce(tlm.connection, side, intermediateUpdateTime, v);
+            fmi3_setFloat64(instance, &vr_f, 1, &F, 1);
         }
-        double v;
-        fmi3_getFloat64(instance, &vr_v, 1, &v, 1);
-
-        double F = v*tlm.Zc + c;
-        fmi3_setFloat64(instance, &vr_f, 1, &F, 1);
     }
 }
 
-//Argument struct for doStep thread
-struct doStepArgs {
-    fmi3InstanceHandle *instance;
-    fmi3Float64 tcur;
-    fmi3Float64 tstep;
-};
-
-
-//doStep thread
-void* doStepInThread(void* argsptr)
-{
-    struct doStepArgs *args = (struct doStepArgs*)argsptr;
-    bool eventEncountered, terminateSimulation, earlyReturn;
-    double lastT;
-    fmi3_doStep(args->instance, args->tcur, args->tstep, fmi3True, &eventEncountered, &terminateSimulation, &earlyReturn, &lastT);
-    return NULL;
-}
-
-
 int testFMI3TLM(fmuHandle *fmua, fmuHandle *fmub, bool overrideStopTime, double stopTimeOverride, bool overrideTimeStep, double timeStepOverride)
 {
     //TLM coupling parameters
@@ -205,7 +71,7 @@ int testFMI3TLM(fmuHandle *fmua, fmuHandle *fmub, bool overrideStopTime, double
     fmi3Float64 tcur = 0;       //Current simulation time
     fmi3Float64 tstop = 2;      //Simulation stop time
     if(overrideStopTime) {
-        tstop = overrideStopTime;
+        tstop = stopTimeOverride;
     }
     fmi3Float64 tstep = 0.001;  //Simulation time step
     if(overrideTimeStep) {
@@ -216,37 +82,29 @@ int testFMI3TLM(fmuHandle *fmua, fmuHandle *fmub, bool overrideStopTime, double
     fmi3Float64 fd = 100;       //Disturbance force
 
     //Compute TLM parameters
-    tlm.Zc = sqrt(mtlm*ktlm);       //Resulting characteristic impedance (global variable)
-    tlm.dt = sqrt(mtlm/ktlm);       //Resulting time delay (global variable)
-    printf("dt = %f\n",tlm.dt);
+    fmi3Float64 Zc = sqrt(mtlm*ktlm);   //Resulting characteristic impedance
+    fmi3Float64 dt = sqrt(mtlm/ktlm);   //Resulting time delay
+    printf("dt = %f\n",dt);
 
     //Value references
     fmi3ValueReference vr_v = 0;    //Connection velocity (output)
     fmi3ValueReference vr_f = 1;    //Connection force (input)
     fmi3ValueReference vr_fd = 5;   //Disturbance force (input to one of the FMUs)
 
-    //Initialize interpolation tables (zero force)
-    tlm.fmu1 = fmua;
-    tlm.table1start = 0;
-    tlm.table1end = 1;
-    tlm.table1[0][tlm.table1start] = -10000;
-    tlm.table1[1][tlm.table1start] = 0;
-    tlm.table1[0][tlm.table1end] = 0;
-    tlm.table1[1][tlm.table1end] = 0;
-
-    tlm.fmu2 = fmub;
-    tlm.table2start = 0;
-    tlm.table2end = 1;
-    tlm.table2[0][tlm.table2start] = -10000;
-    tlm.table2[1][tlm.table2start] = 0;
-    tlm.table2[0][tlm.table2end] = 0;
-    tlm.table2[1][tlm.table2end] = 0;
+    //Create TLM connection (zero waves initially), with room for a few delays worth of intermediate steps
+    tlm.connection = fmi4c_createTlmConnection(Zc, dt, tcur, 1024);
+    if(tlm.connection == NULL) {
+        printf("Failed to create TLM connection\n");
+        return 1;
+    }
 
     //Instantiate
+    tlm.fmu1 = fmua;
+    tlm.fmu2 = fmub;
     fmi3ValueReference requiredIntermediateVariables[2] = {0, 1};
     fmi3ValueReference nRequiredIntermediateVaraibles = 2;
-    fmi3InstanceHandle *instancea = fmi3_instantiateCoSimulation(fmua, fmi3False, fmi3True, fmi3False, fmi3False, requiredIntermediateVariables, nRequiredIntermediateVaraibles, fmua, loggerFmi3, intermediateUpdateTLM);
-    fmi3InstanceHandle *instanceb = fmi3_instantiateCoSimulation(fmub, fmi3False, fmi3True, fmi3False, fmi3False, requiredIntermediateVariables, nRequiredIntermediateVaraibles, fmub, loggerFmi3, intermediateUpdateTLM);
+    fmi3InstanceHandle *instancea = fmi3_instantiateCoSimulation(fmua, fmi3False, fmi3True, fmi3False, fmi3False, requiredIntermediateVariables, nRequiredIntermediateVaraibles, fmua, fmi4c_loggerFmi3, intermediateUpdateTLM);
+    fmi3InstanceHandle *instanceb = fmi3_instantiateCoSimulation(fmub, fmi3False, fmi3True, fmi3False, fmi3False, requiredIntermediateVariables, nRequiredIntermediateVaraibles, fmub, fmi4c_loggerFmi3, intermediateUpdateTLM);
 
     tlm.instance1 = instancea;
     tlm.instance2 = instanceb;
@@ -282,23 +140,26 @@ int testFMI3TLM(fmuHandle *fmua, fmuHandle *fmub, bool overrideStopTime, double
     fmi3_setFloat64(instanceb, &vr_c, 1, &c2, 1);
     fmi3_setFloat64(instanceb, &vr_k, 1, &k2, 1);
 
-    FILE *pResultFile;
-    fclose(fopen(outputCsvPath, "w"));          //Clear old results in file
-    pResultFile = fopen(outputCsvPath, "a");    //Open result file for appending
-    if(pResultFile != NULL) {
-        fprintf(pResultFile, "t,v1,v2,f1,f2\n");          //Print header row
+    const char *resultNames[4] = { "v1", "v2", "f1", "f2" };
+    openResultFile(4, resultNames);
+
+    //Both FMUs wait for each other's delayed waves, so they must step concurrently on separate threads
+    fmi4cMaster *master = fmi4c_createMaster();
+    fmi4c_addMasterSubsystemFmi3(master, instancea);
+    fmi4c_addMasterSubsystemFmi3(master, instanceb);
+    fmi4c_setMasterThreads(master, 2, false);
+    if(!fmi4c_initializeMaster(master)) {
+        printf("Failed to initialize co-simulation master\n");
+        closeResultFile();
+        fmi4c_freeMaster(master);
+        fmi4c_freeTlmConnection(tlm.connection);
+        fmi3_terminate(instancea);
+        fmi3_terminate(instanceb);
+        fmi3_freeInstance(instancea);
+        fmi3_freeInstance(instanceb);
+        return 1;
     }
 
-    struct doStepArgs stepArgs1;
-    stepArgs1.tstep = tstep;
-    stepArgs1.instance = instancea;
-
-    struct doStepArgs stepArgs2;
-    stepArgs2.tstep = tstep;
-    stepArgs2.instance = instanceb;
-
-    pthread_t thread1, thread2;
-
     printf("Starting simulation...\n");
 
     while(tcur < tstop) {
@@ -306,24 +167,19 @@ int testFMI3TLM(fmuHandle *fmua, fmuHandle *fmub, bool overrideStopTime, double
             fmi3_setFloat64(instanceb, &vr_fd, 1, &fd, 1); //Apply disturbance force
         }
 
-        //Create threads
-        stepArgs1.tcur = tcur;
-        pthread_create(&thread1, NULL, doStepInThread, &stepArgs1);
-
-        stepArgs2.tcur = tcur;
-        pthread_create(&thread2, NULL, doStepInThread, &stepArgs2);
-
-        // wait for them to finish
-        pthread_join(thread1, NULL);
-        pthread_join(thread2, NULL);
+        if(fmi4c_doMasterStep(master, tcur, tstep) == fmi4cMasterError) {
+            printf("\nStep failed at time %f\n", tcur);
+            fmi4c_closeTlmConnection(tlm.connection);
+            break;
+        }
 
-        double v1, v2, f1, f2;
-        fmi3_getFloat64(instancea, &vr_v, 1, &v1, 1);
-        fmi3_getFloat64(instanceb, &vr_v, 1, &v2, 1);
-        fmi3_getFloat64(instancea, &vr_f, 1, &f1, 1);
-        fmi3_getFloat64(instanceb, &vr_f, 1, &f2, 1);
-        if(pResultFile != NULL) {
-            fprintf(pResultFile, "%f,%f,%f,%f,%f\n",tcur,v1,v2,f1,f2);
+        double values[4];   //v1, v2, f1, f2
+        fmi3_getFloat64(instancea, &vr_v, 1, &values[0], 1);
+        fmi3_getFloat64(instanceb, &vr_v, 1, &values[1], 1);
+        fmi3_getFloat64(instancea, &vr_f, 1, &values[2], 1);
+        fmi3_getFloat64(instanceb, &vr_f, 1, &values[3], 1);
+        if(resultWriter != NULL) {
+            writeResult(tcur, values, false);
         }
         tcur += tstep;
 
@@ -331,10 +187,10 @@ int testFMI3TLM(fmuHandle *fmua, fmuHandle *fmub, bool overrideStopTime, double
         fflush(stdout);
     }
 
-    if(pResultFile != NULL) {
-        fclose(pResultFile);
-    }
+    closeResultFile();
 
+    fmi4c_freeMaster(master);
+    fmi4c_freeTlmConnection(tlm.connection);
     fmi3_terminate(instancea);
     fmi3_terminate(instanceb);
     fmi3_freeInstance(instancea);
@@ -344,3 +200,122 @@ int testFMI3TLM(fmuHandle *fmua, fmuHandle *fmub, bool overrideStopTime, double
 
     return 0;
 }
+
+#define DELAY_LINE_SIZE 16          //Smallest ring, history of 4 samples
+#define DELAY_LINE_SAMPLES 200      //Wraps around the ring many times
+#define DELAY_LINE_STEP 0.125       //Exactly representable sample interval
+#define DELAY_LINE_DELAY 1000       //Longer than the test, so side 0 never waits for waves from side 1
+#define DELAY_LINE_IMPEDANCE 2
+
+//Known velocity of side 0 at sample k, sample 0 is the zero wave at the start time
+static double getKnownVelocity(int k)
+{
+    return k == 0 ? 0 : sin(0.3*k) + 0.01*k*k;
+}
+
+//Expected wave arriving at side 1 at delay + (k+fraction)*step, interpolated linearly between the waves
+//w_0 = 2*Zc*v_0 of sample k and k+1 (the wave arriving at side 0 is still zero)
+static double getExpectedWave(int k, double fraction)
+{
+    double w1 = 2*DELAY_LINE_IMPEDANCE*getKnownVelocity(k);
+    double w2 = 2*DELAY_LINE_IMPEDANCE*getKnownVelocity(k+1);
+    return w1 + (w2-w1)*fraction;
+}
+
+static int checkWave(fmi4cTlmConnection *connection, int k, double fraction)
+{
+    double wave = fmi4c_getTlmWave(connection, 1, DELAY_LINE_DELAY + (k+fraction)*DELAY_LINE_STEP);
+    if(fabs(wave-getExpectedWave(k, fraction)) > 1e-12) {
+        printf("  Wave at sample %g: %g, expected %g\n", k+fraction, wave, getExpectedWave(k, fraction));
+        return 1;
+    }
+    return 0;
+}
+
+typedef struct {
+    fmi4cTlmConnection *connection;
+    double time;
+    double wave;
+    volatile size_t started;
+    volatile size_t finished;
+} blockedReader_t;
+
+//Looks up a wave that is never published, and blocks until the connection is closed
+static void readBlocked(void *arg)
+{
+    blockedReader_t *reader = (blockedReader_t*)arg;
+    fmi4c_atomicStoreRelease(&reader->started, 1);
+    reader->wave = fmi4c_getTlmWave(reader->connection, 1, reader->time);
+    fmi4c_atomicStoreRelease(&reader->finished, 1);
+}
+
+//Tests one direction of a TLM connection with known waves: linear interpolation between samples, stepping
+//the read cursor back after lookups at later times, wraparound of the ring, and closing the connection while
+//the reader is blocked waiting for a sample
+int testTLMDelayLine(void)
+{
+    printf("--- Test TLM delay line ---\n");
+    fmi4cTlmConnection *connection = fmi4c_createTlmConnection(DELAY_LINE_IMPEDANCE, DELAY_LINE_DELAY, 0, DELAY_LINE_SIZE);
+    if(connection == NULL) {
+        printf("  Failed to create TLM connection\n");
+        return 1;
+    }
+
+    //Publish one sample at a time and read behind it, so that the reader releases old samples and the ring wraps.
+    //Every few samples, step back to earlier lookup times that are still within the history.
+    int nErrors = 0;
+    for(int k=1; k<=DELAY_LINE_SAMPLES; ++k) {
+        if(!fmi4c_publishTlmVelocity(connection, 0, k*DELAY_LINE_STEP, getKnownVelocity(k))) {
+            printf("  Failed to publish sample %d\n", k);
+            ++nErrors;
+            break;
+        }
+        nErrors += checkWave(connection, k-1, 0.25);
+        nErrors += checkWave(connection, k-1, 0.75);
+        nErrors += checkWave(connection, k, 0);
+        if(k%5 == 0 && k > 3) {
+            nErrors += checkWave(connection, k-3, 0.5);
+            nErrors += checkWave(connection, k-2, 0);
+            nErrors += checkWave(connection, k-1, 0.5);
+        }
+    }
+    if(fmi4c_publishTlmVelocity(connection, 0, DELAY_LINE_SAMPLES*DELAY_LINE_STEP, 0)) {
+        printf("  Sample at the time of the previous sample was not ignored\n");
+        ++nErrors;
+    }
+
+    //The wave after the last sample is not published yet, so the reader blocks until the connection is closed, and
+    //then gets the last published wave. Give it time to stop spinning and wait on the condition variable.
+    blockedReader_t reader = { connection, DELAY_LINE_DELAY + (DELAY_LINE_SAMPLES+0.5)*DELAY_LINE_STEP, 0, 0, 0 };
+    fmi4cThread_t thread;
+    if(!fmi4c_threadCreate(&thread, readBlocked, &reader)) {
+        printf("  Failed to start reader thread\n");
+        fmi4c_freeTlmConnection(connection);
+        return 1;
+    }
+    while(!fmi4c_atomicLoadAcquire(&reader.started)) {
+        fmi4c_threadYield();
+    }
+    double startTime = fmi4c_getWallTime();
+    while(fmi4c_getWallTime() < startTime+0.1) {
+        fmi4c_threadYield();
+    }
+    if(fmi4c_atomicLoadAcquire(&reader.finished)) {
+        printf("  Reader did not wait for the sample\n");
+        ++nErrors;
+    }
+    fmi4c_closeTlmConnection(connection);
+    fmi4c_threadJoin(thread);
+    if(reader.wave != getExpectedWave(DELAY_LINE_SAMPLES, 0)) {
+        printf("  Wave after closing: %g, expected %g\n", reader.wave, getExpectedWave(DELAY_LINE_SAMPLES, 0));
+        ++nErrors;
+    }
+    if(fmi4c_publishTlmVelocity(connection, 0, (DELAY_LINE_SAMPLES+1)*DELAY_LINE_STEP, 0)) {
+        printf("  Sample published after closing\n");
+        ++nErrors;
+    }
+    fmi4c_freeTlmConnection(connection);
+
+    printf("  %d samples through a ring of %d: %d errors\n", DELAY_LINE_SAMPLES, DELAY_LINE_SIZE, nErrors);
+    return nErrors == 0 ? 0 : 1;
+}
@@ -4,5 +4,6 @@
 #include "fmi4c.h"
 
 int testFMI3TLM(fmuHandle *fmua, fmuHandle *fmub, bool overrideStopTime, double stopTimeOverride, bool overrideTimeStep, double timeStepOverride);
+int testTLMDelayLine(void);
 
 #endif //FMIC_TEST_TLM_H
@@ -0,0 +1,457 @@
+#define MODEL_IDENTIFIER linearsystem
+
+#include "fmi2Functions.h"
+#include "fmi4c_common.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#define N_STATES 8
+#define VR_X 1          //States x1..x8 have value references 1..8
+#define VR_DER_X 11     //Derivatives der(x1)..der(x8) have value references 11..18
+#define VR_Y1 21        //y1 = x1 + 2*x8
+#define VR_Y2 22        //y2 = 3*x4
+
+typedef struct {
+    fmi2String instanceName;
+    fmi2String guid;
+    const fmi2CallbackFunctions *callbacks;
+    bool loggingOn;
+    fmi2Real time;
+    fmi2Real x[N_STATES];
+} fmuContext;
+
+//Element of the tridiagonal system matrix, der(x) = A*x
+static double getSystemMatrix(int row, int column)
+{
+    if(column == row) {
+        return -(row+1);
+    }
+    if(column == row+1) {
+        return 1;
+    }
+    if(column == row-1) {
+        return 0.5;
+    }
+    return 0;
+}
+
+//Element of the output matrix, y = C*x
+static double getOutputMatrix(int row, int column)
+{
+    if(row == 0) {
+        return column == 0 ? 1 : (column == N_STATES-1 ? 2 : 0);
+    }
+    return column == 3 ? 3 : 0;
+}
+
+//Returns the derivative of the variable with value reference vr with respect to state column, or false for other variables
+static bool getMatrixElement(fmi2ValueReference vr, int column, double *value)
+{
+    if(vr >= VR_DER_X && vr < VR_DER_X+N_STATES) {
+        *value = getSystemMatrix((int)(vr-VR_DER_X), column);
+        return true;
+    }
+    if(vr == VR_Y1 || vr == VR_Y2) {
+        *value = getOutputMatrix((int)(vr-VR_Y1), column);
+        return true;
+    }
+    return false;
+}
+
+static void reset(fmuContext *fmu)
+{
+    fmu->time = 0;
+    for(int i=0; i<N_STATES; ++i) {
+        fmu->x[i] = 1;
+    }
+}
+
+//Value of any real variable, the states, the derivatives or the outputs
+static bool getValue(fmuContext *fmu, fmi2ValueReference vr, double *value)
+{
+    if(vr >= VR_X && vr < VR_X+N_STATES) {
+        *value = fmu->x[vr-VR_X];
+        return true;
+    }
+    double element;
+    if(!getMatrixElement(vr, 0, &element)) {
+        return false;
+    }
+    *value = 0;
+    for(int j=0; j<N_STATES; ++j) {
+        getMatrixElement(vr, j, &element);
+        *value += element*fmu->x[j];
+    }
+    return true;
+}
+
+const char* fmi2GetTypesPlatform(void) {
+    return fmi2TypesPlatform;
+}
+
+const char* fmi2GetVersion(void) {
+    return fmi2Version;
+}
+
+fmi2Status  fmi2SetDebugLogging(fmi2Component c, fmi2Boolean loggingOn, size_t nCategories, const fmi2String categories[]) {
+    UNUSED(nCategories);
+    UNUSED(categories);
+    fmuContext *fmu = (fmuContext*)c;
+    fmu->loggingOn = loggingOn;
+    return fmi2OK;
+}
+
+/* Creation and destruction of FMU instances and setting debug status */
+fmi2Component fmi2Instantiate(fmi2String instanceName, fmi2Type fmuType, fmi2String fmuGUID, fmi2String fmuResourceLocation, const fmi2CallbackFunctions* functions, fmi2Boolean visible, fmi2Boolean loggingOn)
+{
+    UNUSED(fmuResourceLocation);
+    UNUSED(visible);
+    if(fmuType != fmi2ModelExchange) {
+        return NULL;
+    }
+
+    fmuContext *fmu = calloc(1, sizeof(fmuContext));
+    fmu->instanceName = _strdup(instanceName);
+    fmu->guid = _strdup(fmuGUID);
+    fmu->callbacks = functions;
+    fmu->loggingOn = loggingOn;
+    reset(fmu);
+    return fmu;
+}
+
+void fmi2FreeInstance(fmi2Component c) {
+    fmuContext *fmu = (fmuContext*)c;
+    free((char*)fmu->instanceName);
+    free((char*)fmu->guid);
+    free(fmu);
+}
+
+/* Enter and exit initialization mode, terminate and reset */
+fmi2Status fmi2SetupExperiment(fmi2Component c, fmi2Boolean toleranceDefined, fmi2Real tolerance, fmi2Real startTime, fmi2Boolean stopTimeDefined, fmi2Real stopTime) {
+    UNUSED(toleranceDefined);
+    UNUSED(tolerance);
+    UNUSED(stopTimeDefined);
+    UNUSED(stopTime);
+    fmuContext *fmu = (fmuContext*)c;
+    reset(fmu);
+    fmu->time = startTime;
+    return fmi2OK;
+}
+
+fmi2Status fmi2EnterInitializationMode(fmi2Component c) {
+    UNUSED(c);
+    return fmi2OK; //Nothing to do
+}
+
+fmi2Status fmi2ExitInitializationMode(fmi2Component c) {
+    UNUSED(c);
+    return fmi2OK; //Nothing to do
+}
+
+fmi2Status fmi2Terminate(fmi2Component c) {
+    UNUSED(c);
+    return fmi2OK; //Nothing to do
+}
+
+fmi2Status fmi2Reset(fmi2Component c) {
+    reset((fmuContext*)c);
+    return fmi2OK;
+}
+
+fmi2Status fmi2GetReal(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, fmi2Real value[]) {
+    fmuContext *fmu =(fmuContext*)c;
+    fmi2Status status = fmi2OK;
+    for(size_t i=0; i<nvr; ++i) {
+        if(!getValue(fmu, vr[i], &value[i])) {
+            status = fmi2Warning;  // Non-existing value reference;
+        }
+    }
+    return status;
+}
+
+fmi2Status fmi2SetReal(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, const fmi2Real value[]) {
+    fmuContext *fmu =(fmuContext*)c;
+    fmi2Status status = fmi2OK;
+    for(size_t i=0; i<nvr; ++i) {
+        if(vr[i] >= VR_X && vr[i] < VR_X+N_STATES) {
+            fmu->x[vr[i]-VR_X] = value[i];
+        }
+        else {
+            status = fmi2Warning;  // Non-existing or calculated value reference;
+        }
+    }
+    return status;
+}
+
+fmi2Status fmi2GetInteger(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, fmi2Integer value[]) {
+    UNUSED(c);
+    UNUSED(vr);
+    UNUSED(nvr);
+    UNUSED(value);
+    return fmi2Warning;
+}
+
+fmi2Status fmi2GetBoolean(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, fmi2Boolean value[]) {
+    UNUSED(c);
+    UNUSED(vr);
+    UNUSED(nvr);
+    UNUSED(value);
+    return fmi2Warning;
+}
+
+fmi2Status fmi2GetString(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, fmi2String value[]) {
+    UNUSED(c);
+    UNUSED(vr);
+    UNUSED(nvr);
+    UNUSED(value);
+    return fmi2Warning;
+}
+
+fmi2Status fmi2SetInteger(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, const fmi2Integer value[]) {
+    UNUSED(c);
+    UNUSED(vr);
+    UNUSED(nvr);
+    UNUSED(value);
+    return fmi2Warning;
+}
+
+fmi2Status fmi2SetBoolean(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, const fmi2Boolean value[]) {
+    UNUSED(c);
+    UNUSED(vr);
+    UNUSED(nvr);
+    UNUSED(value);
+    return fmi2Warning;
+}
+
+fmi2Status fmi2SetString(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, const fmi2String value[]) {
+    UNUSED(c);
+    UNUSED(vr);
+    UNUSED(nvr);
+    UNUSED(value);
+    return fmi2Warning;
+}
+
+//Model exchange
+fmi2Status fmi2EnterEventMode(fmi2Component c)
+{
+    UNUSED(c);
+    return fmi2OK;  //Nothing to do
+}
+
+fmi2Status fmi2NewDiscreteStates(fmi2Component c, fmi2EventInfo* eventInfo)
+{
+    UNUSED(c);
+    eventInfo->newDiscreteStatesNeeded = fmi2False;
+    eventInfo->nominalsOfContinuousStatesChanged = fmi2False;
+    eventInfo->terminateSimulation = fmi2False;
+    eventInfo->valuesOfContinuousStatesChanged = fmi2False;
+    eventInfo->nextEventTimeDefined = fmi2False;
+    eventInfo->nextEventTime = 0;
+    return fmi2OK;
+}
+
+fmi2Status fmi2EnterContinuousTimeMode(fmi2Component c)
+{
+    UNUSED(c);
+    return fmi2OK;  //Nothing to do
+}
+
+fmi2Status fmi2CompletedIntegratorStep(fmi2Component c,
+                                       fmi2Boolean noSetFMUStatePriorToCurrentPoint,
+                                       fmi2Boolean* enterEventMode,
+                                       fmi2Boolean* terminateSimulation)
+{
+    UNUSED(c);
+    UNUSED(noSetFMUStatePriorToCurrentPoint);
+    *enterEventMode = fmi2False;
+    *terminateSimulation = fmi2False;
+    return fmi2OK;
+}
+
+fmi2Status fmi2SetTime(fmi2Component c, fmi2Real time)
+{
+    fmuContext *fmu = (fmuContext *)c;
+    fmu->time = time;
+    return fmi2OK;
+}
+
+fmi2Status fmi2SetContinuousStates(fmi2Component c, const fmi2Real states[], size_t nStates)
+{
+    fmuContext *fmu = (fmuContext *)c;
+    if(nStates >= N_STATES) {
+        memcpy(fmu->x, states, N_STATES*sizeof(fmi2Real));
+        return fmi2OK;
+    }
+    return fmi2Warning; //Too few states were given
+}
+
+fmi2Status fmi2GetDerivatives(fmi2Component c, fmi2Real derivatives[], size_t nx)
+{
+    fmuContext *fmu = (fmuContext *)c;
+    if(nx >= N_STATES) {
+        for(int i=0; i<N_STATES; ++i) {
+            getValue(fmu, VR_DER_X+(fmi2ValueReference)i, &derivatives[i]);
+        }
+        return fmi2OK;
+    }
+    return fmi2Warning; //Asked for derivatives with too short array
+}
+
+fmi2Status fmi2GetEventIndicators(fmi2Component c, fmi2Real eventIndicators[], size_t ni)
+{
+    UNUSED(c);
+    UNUSED(eventIndicators);
+    UNUSED(ni);
+    return fmi2OK;  //No event indicators
+}
+
+fmi2Status fmi2GetContinuousStates(fmi2Component c, fmi2Real states[], size_t nStates)
+{
+    fmuContext *fmu = (fmuContext *)c;
+    if(nStates >= N_STATES) {
+        memcpy(states, fmu->x, N_STATES*sizeof(fmi2Real));
+        return fmi2OK;
+    }
+    return fmi2Warning; //Asked for states with too short array
+}
+
+fmi2Status fmi2GetNominalsOfContinuousStates(fmi2Component c, fmi2Real x_nominal[], size_t nx)
+{
+    UNUSED(c);
+    for(size_t i=0; i<nx; ++i) {
+        x_nominal[i] = 1.0;
+    }
+    return fmi2OK;
+}
+
+//Co-simulation and FMU states are not supported
+fmi2Status fmi2DoStep(fmi2Component c, fmi2Real currentCommunicationPoint, fmi2Real communicationStepSize, fmi2Boolean noSetFMUStatePriorToCurrentPoint) {
+    UNUSED(c);
+    UNUSED(currentCommunicationPoint);
+    UNUSED(communicationStepSize);
+    UNUSED(noSetFMUStatePriorToCurrentPoint);
+    return fmi2Error;
+}
+
+fmi2Status fmi2GetFMUstate(fmi2Component c, fmi2FMUstate* FMUstate) {
+    UNUSED(c);
+    UNUSED(FMUstate);
+    return fmi2Error;
+}
+
+fmi2Status fmi2SetFMUstate(fmi2Component c, fmi2FMUstate FMUstate) {
+    UNUSED(c);
+    UNUSED(FMUstate);
+    return fmi2Error;
+}
+
+fmi2Status fmi2FreeFMUstate(fmi2Component c, fmi2FMUstate* FMUstate) {
+    UNUSED(c);
+    UNUSED(FMUstate);
+    return fmi2Error;
+}
+
+fmi2Status fmi2SerializedFMUstateSize(fmi2Component c, fmi2FMUstate FMUstate, size_t* size) {
+    UNUSED(c);
+    UNUSED(FMUstate);
+    UNUSED(size);
+    return fmi2Error;
+}
+
+fmi2Status fmi2SerializeFMUstate(fmi2Component c, fmi2FMUstate FMUstate, fmi2Byte serializedState[], size_t size) {
+    UNUSED(c);
+    UNUSED(FMUstate);
+    UNUSED(serializedState);
+    UNUSED(size);
+    return fmi2Error;
+}
+
+fmi2Status fmi2DeSerializeFMUstate(fmi2Component c, const fmi2Byte serializedState[], size_t size, fmi2FMUstate* FMUstate) {
+    UNUSED(c);
+    UNUSED(serializedState);
+    UNUSED(size);
+    UNUSED(FMUstate);
+    return fmi2Error;
+}
+
+fmi2Status fmi2GetDirectionalDerivative(fmi2Component c,
+                                        const fmi2ValueReference vUnknownRef[],
+                                        size_t nUnknown,
+                                        const fmi2ValueReference vKnownRef[],
+                                        size_t nKnown,
+                                        const fmi2Real dvKnown[],
+                                        fmi2Real dvUnknown[]) {
+    UNUSED(c);
+    //The model is linear, so the directional derivative is the matrix times the seed
+    for(size_t i=0; i<nUnknown; ++i) {
+        dvUnknown[i] = 0;
+        for(size_t j=0; j<nKnown; ++j) {
+            double element;
+            if(vKnownRef[j] < VR_X || vKnownRef[j] >= VR_X+N_STATES ||
+               !getMatrixElement(vUnknownRef[i], (int)(vKnownRef[j]-VR_X), &element)) {
+                return fmi2Error;   //Only derivatives of derivatives and outputs with respect to states are supported
+            }
+            dvUnknown[i] += element*dvKnown[j];
+        }
+    }
+    return fmi2OK;
+}
+
+fmi2Status fmi2SetRealInputDerivatives(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, const fmi2Integer order[], const fmi2Real value[]) {
+    UNUSED(c);
+    UNUSED(vr);
+    UNUSED(nvr);
+    UNUSED(order);
+    UNUSED(value);
+    return fmi2Error;
+}
+
+fmi2Status fmi2GetRealOutputDerivatives(fmi2Component c, const fmi2ValueReference vr[], size_t nvr, const fmi2Integer order[], fmi2Real value[]) {
+    UNUSED(c);
+    UNUSED(vr);
+    UNUSED(nvr);
+    UNUSED(order);
+    UNUSED(value);
+    return fmi2Error;
+}
+
+fmi2Status fmi2CancelStep(fmi2Component c) {
+    UNUSED(c);
+    return fmi2Error;
+}
+
+fmi2Status fmi2GetStatus(fmi2Component c, const fmi2StatusKind s, fmi2Status* value) {
+    UNUSED(c);
+    UNUSED(s);
+    UNUSED(value);
+    return fmi2Error;
+}
+
+fmi2Status fmi2GetRealStatus(fmi2Component c, const fmi2StatusKind s, fmi2Real* value) {
+    UNUSED(c);
+    UNUSED(s);
+    UNUSED(value);
+    return fmi2Error;
+}
+
+fmi2Status fmi2GetIntegerStatus(fmi2Component c, const fmi2StatusKind s, fmi2Integer* value) {
+    UNUSED(c);
+    UNUSED(s);
+    UNUSED(value);
+    return fmi2Error;
+}
+
+fmi2Status fmi2GetBooleanStatus(fmi2Component c, const fmi2StatusKind s, fmi2Boolean* value) {
+    UNUSED(c);
+    UNUSED(s);
+    UNUSED(value);
+    return fmi2Error;
+}
+
+fmi2Status fmi2GetStringStatus(fmi2Component c, const fmi2StatusKind s, fmi2String* value) {
+    UNUSED(c);
+    UNUSED(s);
+    UNUSED(value);
+    return fmi2Error;
+}
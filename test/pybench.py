@@ -0,0 +1,117 @@
+import os
+import time
+import numpy as np
+import fmi4c
+
+#Compares the time per step of setting inputs and getting outputs of a co-simulation FMU from Python with list
+#and NumPy array functions, for different numbers of variables
+
+nSteps = 20000
+stepSize = 1e-4
+
+f = fmi4c.fmi4c()
+if not f.fmi4c_loadFmu(os.path.dirname(os.path.abspath(__file__))+"/fmi2.fmu", "testfmu"):
+    print("Failed to load fmi2.fmu")
+    exit(1)
+
+def simulate(step):
+    comp = f.fmi2_instantiate(1, False, False)    # 1 = co-simulation
+    f.fmi2_setupExperiment(comp, False, 0, 0, False, 0)
+    f.fmi2_enterInitializationMode(comp)
+    f.fmi2_exitInitializationMode(comp)
+    start = time.perf_counter()
+    for i in range(nSteps):
+        step(comp, i*stepSize)
+    elapsed = time.perf_counter()-start
+    f.fmi2_terminate(comp)
+    f.fmi2_freeInstance(comp)
+    return 1e6*elapsed/nSteps
+
+def stepOnly(comp, t):
+    f.fmi2_doStep(comp, t, stepSize, True)
+
+stepTime = simulate(stepOnly)
+print("Time per step: %.2f us for doStep only" % stepTime)
+print("Overhead of setReal and getReal per step:")
+for nVariables in [1, 10, 100]:
+    inputRefs = [1]*nVariables     # Value references can be repeated, the test FMU only has one input and one output
+    outputRefs = [2]*nVariables
+    inputs = [1.0]*nVariables
+    def stepLists(comp, t):
+        f.fmi2_setReal(comp, inputRefs, nVariables, inputs)
+        f.fmi2_doStep(comp, t, stepSize, True)
+        return f.fmi2_getReal(comp, outputRefs, nVariables)
+
+    inputRefArray = np.array(inputRefs, dtype=np.uint32)
+    outputRefArray = np.array(outputRefs, dtype=np.uint32)
+    inputArray = np.ones(nVariables)
+    outputArray = np.empty(nVariables)
+    def stepArrays(comp, t):
+        f.fmi2_setRealArray(comp, inputRefArray, inputArray)
+        f.fmi2_doStep(comp, t, stepSize, True)
+        return f.fmi2_getRealArray(comp, outputRefArray, outputArray)
+
+    listTime = simulate(stepLists)
+    arrayTime = simulate(stepArrays)
+    print("  %3d variables: %6.2f us with lists, %6.2f us with arrays" % (nVariables, listTime-stepTime, arrayTime-stepTime))
+
+#Whole simulation in one call, with the GIL released, against stepping from Python
+def createInstance():
+    comp = f.fmi2_instantiate(1, False, False)
+    f.fmi2_setupExperiment(comp, False, 0, 0, False, 0)
+    f.fmi2_enterInitializationMode(comp)
+    f.fmi2_exitInitializationMode(comp)
+    return comp
+
+nLongSteps = 1000000     # Long enough for the thread start to be negligible
+times = np.arange(nLongSteps+1)*stepSize
+inputTimes = [0, times[-1]]
+inputValues = [[0.0], [1.0]]
+def simulateInOneCall():
+    comp = createInstance()
+    success, results = f.fmi2_simulate(comp, 1, times, [2], [1], inputTimes, inputValues)
+    f.fmi2_terminate(comp)
+    f.fmi2_freeInstance(comp)
+    return success, results
+
+start = time.perf_counter()
+success, results = simulateInOneCall()
+oneCallTime = 1e6*(time.perf_counter()-start)/nLongSteps
+inputArray = np.empty(1)
+outputArray = np.empty(1)
+def stepWithInputs(comp, t):
+    inputArray[0] = t/(nSteps*stepSize)
+    f.fmi2_setRealArray(comp, inputRefArray[:1], inputArray)
+    f.fmi2_doStep(comp, t, stepSize, True)
+    f.fmi2_getRealArray(comp, outputRefArray[:1], outputArray)
+loopTime = simulate(stepWithInputs)
+print("Time per step: %.2f us stepping from Python with arrays, %.3f us with fmi2_simulate" % (loopTime, oneCallTime))
+if not success or abs(results[-1, 0]-0.5*times[-1]) > 1e-3:
+    print("fmi2_simulate failed: "+str(results[-1]))
+    exit(1)
+
+import threading
+nThreads = 4
+start = time.perf_counter()
+threads = [threading.Thread(target=simulateInOneCall) for i in range(nThreads)]
+for thread in threads:
+    thread.start()
+for thread in threads:
+    thread.join()
+threadTime = 1e6*(time.perf_counter()-start)/nLongSteps
+print("%d simulations in %d Python threads take %.2f times as long as one simulation (ideal on %d processor(s): %.2f)" %
+      (nThreads, nThreads, threadTime/oneCallTime, os.cpu_count(), nThreads/min(nThreads, os.cpu_count())))
+
+#Array functions must give the same results as list functions
+comp = f.fmi2_instantiate(1, False, False)
+f.fmi2_setupExperiment(comp, False, 0, 0, False, 0)
+f.fmi2_enterInitializationMode(comp)
+f.fmi2_exitInitializationMode(comp)
+f.fmi2_setRealArray(comp, [1, 2], np.array([2.5, 3.0]))
+status, values = f.fmi2_getReal(comp, [1, 2], 2)
+status2, values2 = f.fmi2_getRealArray(comp, [1, 2])
+if status != 0 or status2 != 0 or values != [2.5, 3.0] or list(values2) != values:
+    print("Array functions failed: "+str(values)+" "+str(values2))
+    exit(1)
+f.fmi2_freeInstance(comp)
+f.fmi4c_freeFmu()
@@ -1,4 +1,5 @@
 import ctypes as ct
+import weakref
 
 print("")     
 print("###################################")
@@ -569,6 +570,9 @@ verificationDict =	{
     "setRealSuccess": 0,
     "doStepSuccess": 0,
     "getRealResults": [0, [5.0, 0.25]],
+    "getRealArrayNotCached": True,
+    "getRealArrayCached": True,
+    "getRealArrayReleased": True,
     "getDerivativesSuccess": [0, [0.0]],
     "getStateValueReferencesSuccess": [0, [2]],
     "getNominalsOfContinuousStatesSuccess": [0, [1.0]],
@@ -587,6 +591,8 @@ verificationDict =	{
     "canNotUseMemoryManagementFunctions": False,
     "canGetAndSetFMUState": False,
     "canSerializeFMUState": False,
+    "canGetAndSetFMUStateCs": True,
+    "canSerializeFMUStateCs": True,
     "providesDirectionalDerivative": False,
     "completedIntegratorStepNotNeeded": False,
     "supportsCoSimulation": True,
@@ -771,8 +777,8 @@ verify("canRunAsynchronously", f.fmi2cs_getCanRunAsynchronuously())
 verify("needsExecutionTool", f.fmi2cs_getNeedsExecutionTool())
 verify("canBeInstantiatedOnlyOncePerProcess", f.fmi2cs_getCanBeInstantiatedOnlyOncePerProcess())
 verify("canNotUseMemoryManagementFunctions", f.fmi2cs_getCanNotUseMemoryManagementFunctions())
-verify("canGetAndSetFMUState", f.fmi2cs_getCanGetAndSetFMUState())
-verify("canSerializeFMUState", f.fmi2cs_getCanSerializeFMUState())
+verify("canGetAndSetFMUStateCs", f.fmi2cs_getCanGetAndSetFMUState())
+verify("canSerializeFMUStateCs", f.fmi2cs_getCanSerializeFMUState())
 verify("providesDirectionalDerivative", f.fmi2cs_getProvidesDirectionalDerivative())
 
 
@@ -873,6 +879,16 @@ verify("setRealSuccess", f.fmi2_setReal(comp, [1], 1, [5]))
 verify("doStepSuccess", f.fmi2_doStep(comp, 0,0.1,True))
 
 verify("getRealResults", f.fmi2_getReal(comp, [1, 2],2))
+if fmi4c.np is not None:
+    status, values = f.fmi2_getRealArray(comp, [1, 2])
+    verify("getRealResults", [status, values.tolist()])
+    verify("getRealArrayNotCached", all(entry[0]() is not values for entry in f.arrayAddresses.values()))
+    values = fmi4c.np.zeros(2)
+    f.fmi2_getRealArray(comp, [1, 2], values)
+    verify("getRealArrayCached", any(entry[0]() is values for entry in f.arrayAddresses.values()))
+    cached = weakref.ref(values)
+    del values
+    verify("getRealArrayReleased", cached() is None)
 
 verify("resetSuccess", f.fmi2_reset(comp))
 
@@ -977,8 +993,8 @@ verificationDict =	{
     "version": "0.1",
     "supportsCoSimulation": True,
     "supportsModelExchange": True,
-    "supportsScheduledExecution": False,
-    "numberOfVariables": 2,
+    "supportsScheduledExecution": True,
+    "numberOfVariables": 5,
     "variableNames": ['dx', 'x'],
     "variableValueReferences": [1, 2],
     "variableDescriptions": ['Derivative of x', 'x'],
@@ -1016,6 +1032,8 @@ verificationDict =	{
     "canBeInstantiatedOnlyOncePerProcess": False,
     "canGetAndSetFMUState": False,
     "canSerializeFMUState": False,
+    "canGetAndSetFMUStateCs": True,
+    "canSerializeFMUStateCs": True,
     "providesDirectionalDerivative": False,
     "providesAdjointDerivatives": False,
     "providesPerElementDependencies": False,
@@ -1028,7 +1046,7 @@ verificationDict =	{
     "canReturnEarlyAfterIntermediateUpdate": False,
     "fixedInternalStepSize": 0,
     "needsCompletedIntegratorStep": False,
-    "modelIdentifierSE": "",
+    "modelIdentifierSE": "fmi3",
     "instantiateSuccess": True,
     "setDebugLoggingSuccess": 0,
     "enterInitializationModeSuccess": 0,
@@ -1036,6 +1054,7 @@ verificationDict =	{
     "setFloat64Success": 0,
     "doStepSuccess": 0,
     "getFloat64Results": [0, [5.0, 0.0025]],
+    "simulateResults": [True, [0.0, 0.25, 0.75]],
     "terminateSuccess": 0,
     "doStepResults": (0, False, False, False, 0.001),
     "resetSuccess": 0,
@@ -1274,8 +1293,8 @@ verify("logCategories", logCategories);
 verify("modelIdentifier", f.fmi3cs_getModelIdentifier())
 verify("needsExecutionTool", f.fmi3cs_getNeedsExecutionTool())
 verify("canBeInstantiatedOnlyOncePerProcess", f.fmi3cs_getCanBeInstantiatedOnlyOncePerProcess())
-verify("canGetAndSetFMUState", f.fmi3cs_getCanGetAndSetFMUState())
-verify("canSerializeFMUState", f.fmi3cs_getCanSerializeFMUState())
+verify("canGetAndSetFMUStateCs", f.fmi3cs_getCanGetAndSetFMUState())
+verify("canSerializeFMUStateCs", f.fmi3cs_getCanSerializeFMUState())
 verify("providesDirectionalDerivative", f.fmi3cs_getProvidesDirectionalDerivative())
 verify("providesAdjointDerivatives", f.fmi3cs_getProvidesAdjointDerivatives())
 verify("providesPerElementDependencies", f.fmi3cs_getProvidesPerElementDependencies())
@@ -1326,7 +1345,15 @@ verify("exitInitializationModeSuccess", f.fmi3_exitInitializationMode(instance))
 verify("setFloat64Success", f.fmi3_setFloat64(instance, [1], 1, [5], 1))
 verify("doStepResults", f.fmi3_doStep(instance, 0, 0.001, True))
 verify("getFloat64Results", f.fmi3_getFloat64(instance, [1, 2],2,2))
+if fmi4c.np is not None:
+    status, values = f.fmi3_getFloat64Array(instance, [1, 2])
+    verify("getFloat64Results", [status, values.tolist()])
 verify("resetSuccess", f.fmi3_reset(instance))
+if fmi4c.np is not None:
+    f.fmi3_enterInitializationMode(instance2, False, 0, 0, False, 0)
+    f.fmi3_exitInitializationMode(instance2)
+    success, results = f.fmi3_simulate(instance2, 1, [0, 0.5, 1], [2], [1], [0], [1.0])
+    verify("simulateResults", [success, results.ravel().tolist()])
 f.fmi3_freeInstance(instance2)
 
 #Test model exchange